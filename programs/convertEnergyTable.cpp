@@ -0,0 +1,113 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+#include "MslTools.h"
+#include "OptionParser.h"
+#include "release.h"
+
+#include "EnergyTable.h"
+
+using namespace std;
+using namespace MSL;
+
+#include "convertEnergyTable.h"
+
+/*
+  Converts an energy table between the text format of the energyTable
+  program and the binary format that can be memory mapped by optimizeMC
+  (the format of the input is detected).
+*/
+int main(int argc, char *argv[]) {
+
+	Options opt = setupOptions(argc, argv);
+
+	EnergyTable table;
+	if (EnergyTable::isBinaryFile(opt.input)) {
+		if (!table.readBinaryFile(opt.input, false)) {
+			exit(1112);
+		}
+	} else {
+		if (!table.readTextFile(opt.input, opt.useFloat)) {
+			exit(1112);
+		}
+	}
+	fprintf(stdout, "Read %u positions, %u interacting pairs from %s\n", table.getNumberOfPositions(), table.getNumberOfStoredPairs(), opt.input.c_str());
+
+	bool written = false;
+	if (opt.binary) {
+		written = table.writeBinaryFile(opt.output);
+	} else {
+		written = table.writeTextFile(opt.output);
+	}
+	if (!written) {
+		exit(1113);
+	}
+	fprintf(stdout, "Written %s table %s\n", opt.binary ? "binary" : "text", opt.output.c_str());
+
+}
+
+
+Options setupOptions(int theArgc, char * theArgv[]){
+	// Create the options
+	Options opt;
+
+	// Parse the options
+	OptionParser OP;
+	OP.readArgv(theArgc, theArgv);
+	OP.setRequired(opt.required);	
+	OP.setAllowed(opt.optional);	
+	OP.setDefaultArguments(opt.defaultArgs); // the default argument is the --configfile option
+
+
+	if (OP.countOptions() == 0){
+		cout << "Usage: convertEnergyTable " << endl;
+		cout << endl;
+		cout << "\n";
+		cout << "input ENERGY_TABLE (text or binary)\n";
+		cout << "output ENERGY_TABLE\n";
+		cout << "#binary (write the binary format, otherwise text)\n";
+		cout << "#float (single precision pair energies when a text table is converted)\n";
+		cout << endl;
+		exit(0);
+	}
+
+	opt.input = OP.getString("input");
+	if (OP.fail()){
+		cerr << "ERROR 1111 no input specified."<<endl;
+		exit(1111);
+	}
+	opt.output = OP.getString("output");
+	if (OP.fail()){
+		cerr << "ERROR 1111 no output specified."<<endl;
+		exit(1111);
+	}
+	opt.binary = OP.getBool("binary");
+	opt.useFloat = OP.getBool("float");
+
+	return opt;
+}
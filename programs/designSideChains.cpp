@@ -61,6 +61,7 @@ int main(int argc, char *argv[]){
 	SelfPairManager scom;
 	scom.setSystem(&sys);
 	scom.seed(opt.randomSeed);
+	scom.setNumberOfThreads(opt.numberOfThreads);
 	EnergySet *e = sys.getEnergySet();
 	cout << "SIZEOF: "<<sizeof(*e)<<endl;
 
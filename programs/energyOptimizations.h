@@ -119,6 +119,7 @@ struct EnergyTableOptions {
 		     Optionals
 		*************************/
 		optional.push_back("energyTableName");
+		optional.push_back("binaryEnergyTableName");
 		optional.push_back("partialEnergyTable");
 		optional.push_back("dielectric");
 		optional.push_back("distanceDielectric");
@@ -139,6 +140,7 @@ struct EnergyTableOptions {
 	std::string structureConfig;
 	std::string configFile;
 	std::string energyTableName;
+	std::string binaryEnergyTableName;
 	std::string partialEnergyTable;
 	double dielectric;
 	bool distanceDependentElectrostatics;
@@ -185,6 +187,9 @@ struct MonteCarloOptions {
 		// Dead-End Elimination
 		optional.push_back("DEE");
 
+		// Threads used to build the self and pair energy tables
+		optional.push_back("numberOfThreads");
+
 		// Configuration files
 		optional.push_back("energyConfig");
 		optional.push_back("maxRejections");
@@ -230,6 +235,7 @@ struct MonteCarloOptions {
 	int    numStoredConfigurations;
 	int    randomSeed;
 	bool   DEE;
+	int    numberOfThreads;
 
         MonteCarloManager::ANNEALTYPES annealShape;
         map<string,MonteCarloManager::ANNEALTYPES> annealShapeMap;
@@ -589,6 +595,7 @@ EnergyTableOptions setupEnergyTableOptions(int theArgc, char * theArgv[]){
 		std::cout << "\n";
 		std::cout << "structureConfig STRUCTURE_CONF_FILE\n";
 		std::cout << "#energyTableName FILE\n";
+		std::cout << "#binaryEnergyTableName FILE\n";
 		std::cout << "#dielectric 80\n";
 		std::cout << "#distanceDielectric\n";
 		std::cout << "#vdwScale 1.0\n";
@@ -618,6 +625,10 @@ EnergyTableOptions setupEnergyTableOptions(int theArgc, char * theArgv[]){
 	if (OP.fail()){
 		opt.energyTableName = "energyTable.txt";
 	}
+	opt.binaryEnergyTableName = OP.getString("binaryEnergyTableName");
+	if (OP.fail()){
+		opt.binaryEnergyTableName = "";
+	}
 
 
 	opt.dielectric = OP.getDouble("dielectric");
@@ -670,6 +681,10 @@ EnergyTableOptions setupEnergyTableOptions(std::string _confFile){
 	if (OP.fail()){
 		opt.energyTableName = "energyTable.txt";
 	}
+	opt.binaryEnergyTableName = OP.getString("binaryEnergyTableName");
+	if (OP.fail()){
+		opt.binaryEnergyTableName = "";
+	}
 
 
 	opt.dielectric = OP.getDouble("dielectric");
@@ -748,6 +763,8 @@ MonteCarloOptions setupMonteCarloOptions(int theArgc, char * theArgv[]){
 		std::cout << "numberOfStoredConfigurations 100\n\n";
 		std::cout << "# Random Seed to use, -1 means create a time-based seed\n";
 		std::cout << "randomSeed 838201\n\n";
+		std::cout << "# Number of threads used to build the energy tables\n";
+		std::cout << "numberOfThreads 1\n\n";
 		std::cout << "# energyTable configuration file\n";
 		std::cout << "energyConfig FILENAME\n";
 		std::cout << "# Max number of rejections per cycle\n";
@@ -856,6 +873,11 @@ MonteCarloOptions setupMonteCarloOptions(int theArgc, char * theArgv[]){
 		opt.DEE = false;
 	}
 
+	opt.numberOfThreads = OP.getInt("numberOfThreads");
+	if (OP.fail() || opt.numberOfThreads < 1){
+		opt.numberOfThreads = 1;
+	}
+
 
 	cout << OP<<std::endl;
 	return opt;
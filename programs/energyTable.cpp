@@ -30,6 +30,7 @@ You should have received a copy of the GNU Lesser General Public
 #include <map>
 #include <fstream>
 #include "OptionParser.h"
+#include "EnergyTable.h"
 #include "energyOptimizations.h"
 
 
@@ -128,6 +129,37 @@ int main(int argc, char *argv[]){
 	eout << t;
 	eout.close();
 
+	// binary copy of the same table (variable positions only), it can be memory mapped by optimizeMC
+	if (opt.binaryEnergyTableName != ""){
+		vector<vector<double> > variableSelf;
+		vector<vector<vector<vector<double> > > > variablePair;
+		vector<vector<string> > labels;
+		vector<uint> variablePositions;
+		for (uint i = 0; i < selfEnergy.size();i++){
+			if (selfEnergy[i].size() <= 1) continue;
+			uint vi = variablePositions.size();
+			variablePositions.push_back(i);
+			variableSelf.push_back(vector<double>());
+			variablePair.push_back(vector<vector<vector<double> > >(selfEnergy[i].size()));
+			labels.push_back(vector<string>());
+			for (uint j = 0; j < selfEnergy[i].size();j++){
+				variableSelf[vi].push_back(selfEnergy[i][j]+templateEnergy[i][j]);
+				labels[vi].push_back(sys.getPosition(i).getPositionId() + ":" + MslTools::intToString(j));
+				for (uint vii = 0; vii < vi;vii++){
+					variablePair[vi][j].push_back(pairEnergy[i][j][variablePositions[vii]]);
+				}
+			}
+		}
+		EnergyTable table;
+		table.setTables(variableSelf, variablePair, false, true);
+		table.setFixedEnergy(fixedE);
+		table.setRotamerLabels(labels);
+		if (!table.writeBinaryFile(opt.binaryEnergyTableName)){
+			cerr << "ERROR 1112 cannot write the binary energy table " << opt.binaryEnergyTableName << endl;
+			exit(1112);
+		}
+	}
+
 
 	
 	cout << "Done."<<endl;
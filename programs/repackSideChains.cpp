@@ -103,24 +103,24 @@ void rotlibRepack (System& _sys, Options& _opt) {
 		scom.seed(_opt.seed);
 	}
 	scom.setOnTheFly(_opt.onTheFly);
+	scom.setNumberOfThreads(_opt.threads);
 
 	scom.calculateEnergies();
 	/*
 	cout << "FixedE " << scom.getFixedEnergy() << endl;
-		vector<vector<double> > & se = scom.getSelfEnergy();
+		EnergyTable & table = scom.getEnergyTable();
 		cout << "SelfE " << endl;
-		for(int i = 0; i < se.size(); i++) {
-			for(int j = 0; j < se[i].size(); j++) {
-				cout << se[i][j] << endl;
+		for(int i = 0; i < table.getNumberOfPositions(); i++) {
+			for(int j = 0; j < table.getNumberOfRotamers(i); j++) {
+				cout << table.getSelfEnergy(i, j) << endl;
 			}
 		}
-		vector<vector<vector<vector<double> > > > & pe = scom.getPairEnergy();
 		cout << "PairE " << endl;
-		for(int i = 0; i < pe.size(); i++) {
-			for(int j = 0; j < pe[i].size(); j++) {
-				for(int k = 0; k < pe[i][j].size(); k++) {
-					for(int l = 0; l < pe[i][j][k].size(); l++) {
-						cout << pe[i][j][k][l] << endl;
+		for(int i = 0; i < table.getNumberOfPositions(); i++) {
+			for(int j = 0; j < table.getNumberOfRotamers(i); j++) {
+				for(int k = 0; k < i; k++) {
+					for(int l = 0; l < table.getNumberOfRotamers(k); l++) {
+						cout << table.getPairEnergy(i, j, k, l) << endl;
 					}
 				}
 			}
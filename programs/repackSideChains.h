@@ -95,6 +95,7 @@ struct Options {
 	int greedyCycles;
 
 	bool onTheFly;
+	int threads; // threads used to build the energy tables
 
 	unsigned int seed;
 	bool useTimeToSeed; // true if no seed is specified
@@ -155,7 +156,7 @@ void help() {
 	cout << " % repackSideChains \n --pdbfile <pdbfile> " << endl;
 	cout << endl;
 	cout << "Optional Parameters " << endl;
-	cout << " --rotlibfile <rotlibfile> \n --beblfile <filename> \n --charmmtopfile <charmmTopFile> \n --charmmparfile <charmmParFile> \n --hbondparfile <hbondParFile> \n --solvfile <solvationFile> --solvent <string> \n --outputpdbfile <outputpdbfile> \n --logfile <logfile> \n --verbose <true/false> \n --cuton <nbcuton> \n --cutoff <nbcutoff> \n --cutnb <nbcutnb> \n --includecrystalrotamer <true/false> (include crystal rotamer)" << endl;
+	cout << " --rotlibfile <rotlibfile> \n --beblfile <filename> \n --charmmtopfile <charmmTopFile> \n --charmmparfile <charmmParFile> \n --hbondparfile <hbondParFile> \n --solvfile <solvationFile> --solvent <string> \n --outputpdbfile <outputpdbfile> \n --logfile <logfile> \n --verbose <true/false> \n --threads <number of threads for the energy tables> \n --cuton <nbcuton> \n --cutoff <nbcutoff> \n --cutnb <nbcutnb> \n --includecrystalrotamer <true/false> (include crystal rotamer)" << endl;
 	cout << " --configfile <configfile> \n --rungoldsteinsingles <true/false> \n --rungoldsteinpairs <true/false> \n --runscmf <true/false> \n --runscmfbiasedmc <true/false> \n --rununbiasedmc <true/false> --rungreedy <true/false> --greedyCycles <int>" << endl;
 	cout << "--excludeenergyterm <term1> --excludeenergyterm <term2> \n   [Terms can be CHARMM_ANGL,CHARMM_BOND,CHARMM_DIHE,CHARMM_ELEC,CHARMM_IMPR,CHARMM_U-BR,CHARMM_VDW,SCWRL4_HBOND] All terms are implemented by default " << endl;
 	cout << endl;
@@ -204,6 +205,7 @@ Options parseOptions(int _argc, char * _argv[]) {
 	opt.allowed.push_back("excludeenergyterm");
 	opt.allowed.push_back("verbose");
 	opt.allowed.push_back("onthefly"); // 
+	opt.allowed.push_back("threads"); // 
 	opt.allowed.push_back("seed"); // 
 	opt.allowed.push_back("cuton");
 	opt.allowed.push_back("cutoff");
@@ -350,6 +352,11 @@ Options parseOptions(int _argc, char * _argv[]) {
 		opt.warningFlag = true;
 	}
 
+	opt.threads = OP.getInt("threads");
+	if(OP.fail() || opt.threads < 1) {
+		opt.threads = 1;
+	}
+
 	opt.seed = OP.getBool("seed");
 	if(OP.fail()) {
 		opt.useTimeToSeed = true;
@@ -155,6 +155,7 @@ void Atom::reset() {
 	charge = 0.0;
 	radius = -1.0;
 	type = "";
+	typeId = noTypeId;
 	tempFactor = 0.0;
 	sasa = 0.0;
 	segId = "";
@@ -173,7 +174,9 @@ void Atom::setup(CartesianPoint _point, string _atomId, string _element) {
 	string icode = "";
 	string identity = "";
 	string atomname = "";
-	if (MslTools::parseAtomId(_atomId, chain, resnum, icode, atomname, 2)) {
+	if (_atomId == "") {
+		// nothing to parse (i.e. the default constructor)
+	} else if (MslTools::parseAtomId(_atomId, chain, resnum, icode, atomname, 2)) {
 		chainId = chain;
 		residueNumber = resnum;
 		residueIcode = icode;
@@ -195,7 +198,8 @@ void Atom::setup(CartesianPoint _point, string _atomId, string _element) {
 	addSelectableFunctions();
 
 	// Every atom should be marked as "all"
-	setSelectionFlag("all",true);
+	static unsigned int allSelectionId = registerSelectionId("all");
+	setSelectionFlag(allSelectionId,true);
 
 	minIndex = -1;
 	toStringFormat = 0;
@@ -222,6 +226,7 @@ void Atom::copy(const Atom & _atom) {
 	charge = _atom.charge;
 	radius = _atom.radius;
 	type = _atom.type;
+	typeId = _atom.typeId;
 	segId = _atom.segId;
 	tempFactor = _atom.tempFactor;
 	sasa = _atom.sasa;
@@ -236,7 +241,8 @@ void Atom::copy(const Atom & _atom) {
 	hasCoordinates = _atom.hasCoordinates;
 
 	// Every atom should be marked as "all"
-	setSelectionFlag("all",true);
+	static unsigned int allSelectionId = registerSelectionId("all");
+	setSelectionFlag(allSelectionId,true);
 
 	minIndex = _atom.minIndex;
 	toStringFormat = _atom.toStringFormat;
@@ -347,6 +353,13 @@ string Atom::getNameSpace() const {
 /*********************************************************/
 
 void Atom::addSelectableFunctions(){
+	// the function tables are shared by all atoms, fill them once
+	static bool added = false;
+	if (added) {
+		return;
+	}
+	added = true;
+
 	addStringFunction("NAME", &Atom::getName);
 	addStringFunction("RESN", &Atom::getResidueName);
 	addIntFunction("RESI", &Atom::getResidueNumber);
@@ -548,96 +561,144 @@ unsigned int Atom::getGroupNumber() const {
 	}
 }
 
+/*********************************************************
+ *  Insert/remove a value in a sorted vector (the bond lists
+ *  of the atom)
+ *********************************************************/
+template <class T> static void insertSorted(vector<T> & _list, const T & _value) {
+	typename vector<T>::iterator found = lower_bound(_list.begin(), _list.end(), _value);
+	if (found == _list.end() || !(*found == _value)) {
+		_list.insert(found, _value);
+	}
+}
+
+template <class T> static void eraseSorted(vector<T> & _list, const T & _value) {
+	typename vector<T>::iterator found = lower_bound(_list.begin(), _list.end(), _value);
+	if (found != _list.end() && *found == _value) {
+		_list.erase(found);
+	}
+}
+
+typedef pair<Atom*, Atom*> OneThreeEntry;
+typedef pair<Atom*, pair<Atom*, Atom*> > OneFourEntry;
+
+unsigned int Atom::bondRevision = 0;
+
+void Atom::getOneThreeAtomsThrough(Atom * _pAtom2, vector<Atom*> & _oneThree) const {
+	_oneThree.clear();
+	for (vector<OneThreeEntry>::const_iterator k=oneThreeAtoms.begin(); k!=oneThreeAtoms.end(); k++) {
+		if (k->second == _pAtom2) {
+			_oneThree.push_back(k->first);
+		}
+	}
+}
+
+vector<Atom*> Atom::getOneThreeAtoms() const {
+	vector<Atom*> out;
+	for (vector<OneThreeEntry>::const_iterator k=oneThreeAtoms.begin(); k!=oneThreeAtoms.end(); k++) {
+		if (out.size() == 0 || out.back() != k->first) {
+			out.push_back(k->first);
+		}
+	}
+	return out;
+}
+
+vector<Atom*> Atom::getOneFourAtoms() const {
+	vector<Atom*> out;
+	for (vector<OneFourEntry>::const_iterator k=oneFourAtoms.begin(); k!=oneFourAtoms.end(); k++) {
+		if (out.size() == 0 || out.back() != k->first) {
+			out.push_back(k->first);
+		}
+	}
+	return out;
+}
+
 void Atom::setBoundTo(Atom * _pAtom) {
-	boundAtoms[_pAtom]; // create 1-2
-	_pAtom->boundAtoms[this]; // create reciprocal 1-2
+	bondRevision++;
+	insertSorted(boundAtoms, _pAtom); // create 1-2
+	insertSorted(_pAtom->boundAtoms, this); // create reciprocal 1-2
 
+	vector<Atom*> oneThree;
 	// to all 1-2 atoms of this atom, add a 1-3 through _pAtom
-	for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k=_pAtom->boundAtoms.begin(); k!=_pAtom->boundAtoms.end(); k++) {
-		if (k->first == this) {
+	for (unsigned int k=0; k<_pAtom->boundAtoms.size(); k++) {
+		Atom * pK = _pAtom->boundAtoms[k];
+		if (pK == this) {
 			continue;
 		}
-		if (this->getParentPosition() == k->first->getParentPosition() && this->getParentResidue() != k->first->getParentResidue()) {
+		if (isInAlternativeIdentity(pK)) {
 			// exclude if the atoms that are on different identities of the same position
 			continue;
 		}
-		boundAtoms[_pAtom][k->first]; // create 1-3
-		k->first->boundAtoms[_pAtom][this]; // create reciprocal 1-3
-		oneThreeAtoms[k->first][_pAtom] = true;
-		k->first->oneThreeAtoms[this][_pAtom] = true;
-
+		insertSorted(oneThreeAtoms, OneThreeEntry(pK, _pAtom)); // create 1-3
+		insertSorted(pK->oneThreeAtoms, OneThreeEntry(this, _pAtom)); // create reciprocal 1-3
 
 		// to all 1-2 atoms of the 1-2 atom, add a 1-4 through _pAtom and its 1-2 atom
-		for (map<Atom*, map<Atom*, bool> >::iterator l=k->second.begin(); l!=k->second.end(); l++) {
-			if (l->first == this || l->first == _pAtom) {
+		_pAtom->getOneThreeAtomsThrough(pK, oneThree);
+		for (vector<Atom*>::iterator l=oneThree.begin(); l!=oneThree.end(); l++) {
+			if (*l == this || *l == _pAtom) {
 				continue;
 			}
-			if (this->getParentPosition() == l->first->getParentPosition() && this->getParentResidue() != l->first->getParentResidue()) {
+			if (isInAlternativeIdentity(*l)) {
 				// exclude if the atoms that are on different identities of the same position
 				continue;
 			}
-			boundAtoms[_pAtom][k->first][l->first] = true; // create 1-4
-			l->first->boundAtoms[k->first][_pAtom][this] = true; // create reciprocal 1-4
-			oneFourAtoms[l->first][_pAtom][k->first] = true;
-			l->first->oneFourAtoms[this][k->first][_pAtom] = true;
+			insertSorted(oneFourAtoms, OneFourEntry(*l, OneThreeEntry(_pAtom, pK))); // create 1-4
+			insertSorted((*l)->oneFourAtoms, OneFourEntry(this, OneThreeEntry(pK, _pAtom))); // create reciprocal 1-4
 		}
 	}
 	// to all 1-2 atoms of _pAtom, add a 1-3 through this atom
-	for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		if (k->first == _pAtom) {
+	for (unsigned int k=0; k<boundAtoms.size(); k++) {
+		Atom * pK = boundAtoms[k];
+		if (pK == _pAtom) {
 			continue;
 		}
-		if (_pAtom->getParentPosition() == k->first->getParentPosition() && _pAtom->getParentResidue() != k->first->getParentResidue()) {
+		if (_pAtom->isInAlternativeIdentity(pK)) {
 			// exclude if the atoms that are on different identities of the same position
 			continue;
 		}
-		_pAtom->boundAtoms[this][k->first]; // create 1-3
-		k->first->boundAtoms[this][_pAtom]; // create reciprocal 1-3
-		_pAtom->oneThreeAtoms[k->first][this] = true;
-		k->first->oneThreeAtoms[_pAtom][this] = true;
-
+		insertSorted(_pAtom->oneThreeAtoms, OneThreeEntry(pK, this)); // create 1-3
+		insertSorted(pK->oneThreeAtoms, OneThreeEntry(_pAtom, this)); // create reciprocal 1-3
 
 		// to all 1-2 atoms of the 1-2 atom, add a 1-4 through _pAtom and its 1-2 atom
-		for (map<Atom*, map<Atom*, bool> >::iterator l=k->second.begin(); l!=k->second.end(); l++) {
-			if (l->first == this || l->first == _pAtom) {
+		getOneThreeAtomsThrough(pK, oneThree);
+		for (vector<Atom*>::iterator l=oneThree.begin(); l!=oneThree.end(); l++) {
+			if (*l == this || *l == _pAtom) {
 				continue;
 			}
-			if (_pAtom->getParentPosition() == l->first->getParentPosition() && _pAtom->getParentResidue() != l->first->getParentResidue()) {
+			if (_pAtom->isInAlternativeIdentity(*l)) {
 				// exclude if the atoms that are on different identities of the same position
 				continue;
 			}
-			_pAtom->boundAtoms[this][k->first][l->first] = true; // create 1-4
-			l->first->boundAtoms[k->first][this][_pAtom] = true; // create reciprocal 1-4
-			_pAtom->oneFourAtoms[l->first][this][k->first] = true;
-			l->first->oneFourAtoms[_pAtom][k->first][this] = true;
+			insertSorted(_pAtom->oneFourAtoms, OneFourEntry(*l, OneThreeEntry(this, pK))); // create 1-4
+			insertSorted((*l)->oneFourAtoms, OneFourEntry(_pAtom, OneThreeEntry(pK, this))); // create reciprocal 1-4
 		}
 	}
 	
 	// finally, combinatorially add 1-4 relationships between all 1-2 atoms of this atom and _pAtom
-	for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		if (k->first == _pAtom) {
+	for (unsigned int k=0; k<boundAtoms.size(); k++) {
+		Atom * pK = boundAtoms[k];
+		if (pK == _pAtom) {
 			continue;
 		}
-		if (_pAtom->getParentPosition() == k->first->getParentPosition() && _pAtom->getParentResidue() != k->first->getParentResidue()) {
+		if (_pAtom->isInAlternativeIdentity(pK)) {
 			// exclude if the atoms that are on different identities of the same position
 			continue;
 		}
-		for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator l=_pAtom->boundAtoms.begin(); l!=_pAtom->boundAtoms.end(); l++) {
-			if (l->first == this || l->first == k->first) {
+		for (unsigned int l=0; l<_pAtom->boundAtoms.size(); l++) {
+			Atom * pL = _pAtom->boundAtoms[l];
+			if (pL == this || pL == pK) {
 				continue;
 			}
-			if (this->getParentPosition() == l->first->getParentPosition() && this->getParentResidue() != l->first->getParentResidue()) {
+			if (isInAlternativeIdentity(pL)) {
 				// exclude if the atoms that are on different identities of the same position
 				continue;
 			}
-			if (k->first->getParentPosition() == l->first->getParentPosition() && k->first->getParentResidue() != l->first->getParentResidue()) {
+			if (pK->isInAlternativeIdentity(pL)) {
 				// exclude if the atoms that are on different identities of the same position
 				continue;
 			}
-			k->first->boundAtoms[this][_pAtom][l->first] = true; // create 1-4 beetween the 1-2 or this and the 1-2 of _pAtom
-			l->first->boundAtoms[_pAtom][this][k->first] = true; // create reciprocal 1-4
-			k->first->oneFourAtoms[l->first][this][_pAtom] = true;
-			l->first->oneFourAtoms[k->first][_pAtom][this] = true;
+			insertSorted(pK->oneFourAtoms, OneFourEntry(pL, OneThreeEntry(this, _pAtom))); // create 1-4 beetween the 1-2 or this and the 1-2 of _pAtom
+			insertSorted(pL->oneFourAtoms, OneFourEntry(pK, OneThreeEntry(_pAtom, this))); // create reciprocal 1-4
 		}
 	}
 }
@@ -647,10 +708,12 @@ void Atom::setUnboundFromAll(bool _propagate) {
 	if (boundAtoms.size() == 0) {
 		return;
 	}
+	bondRevision++;
 	if (_propagate) {
 		// remove the bond to this atoms from all bound atoms
-		for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k = boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-			k->first->setUnboundFrom(this, false);
+		vector<Atom*> bound = boundAtoms;
+		for (vector<Atom*>::iterator k = bound.begin(); k!=bound.end(); k++) {
+			(*k)->setUnboundFrom(this, false);
 		}
 	}
 	boundAtoms.clear();
@@ -661,16 +724,13 @@ void Atom::setUnboundFromAll(bool _propagate) {
 
 void Atom::setUnboundFrom(Atom * _pAtom, bool _propagate) {
 
-	map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator found = boundAtoms.find(_pAtom);
-	if (found != boundAtoms.end()) {
+	if (isBoundTo(_pAtom)) {
 		// atom is bound: erase it
+		bondRevision++;
 
 		// find all atoms that are connected through _pAtom
 		vector<Atom *> thirdAtoms;
-		for (map<Atom*, map<Atom*, bool> >::iterator k = found->second.begin(); k!=found->second.end(); k++) {
-			thirdAtoms.push_back(k->first);
-		}
-
+		getOneThreeAtomsThrough(_pAtom, thirdAtoms);
 
 		// remove all the 1-3 and 1-4 references through _pAtom
 		for (vector<Atom*>::iterator third=thirdAtoms.begin(); third!=thirdAtoms.end(); third++) {
@@ -678,18 +738,17 @@ void Atom::setUnboundFrom(Atom * _pAtom, bool _propagate) {
 			purge13(_pAtom, *third);
 		}
 
-		// erase the bond (it was most likely erased by the purge functions but just in case)
-		boundAtoms.erase(found);
-
+		// erase the bond
+		eraseSorted(boundAtoms, _pAtom);
 
 		// remove all the 1-3 and 1-4 through _pAtom from the atoms bound to this
-		for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k = boundAtoms.begin(); k!=boundAtoms.end(); k++) {
+		for (vector<Atom*>::iterator k = boundAtoms.begin(); k!=boundAtoms.end(); k++) {
 
-			k->first->purge14mid(this, _pAtom);
-			k->first->purge13(this, _pAtom);
+			(*k)->purge14mid(this, _pAtom);
+			(*k)->purge13(this, _pAtom);
 			// and remove all the 1-4 through this and _pAtom from the atoms bound to those atoms
-			for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator kk = k->first->boundAtoms.begin(); kk!=k->first->boundAtoms.end(); kk++) {
-				kk->first->purge14end(this, _pAtom);
+			for (vector<Atom*>::iterator kk = (*k)->boundAtoms.begin(); kk!=(*k)->boundAtoms.end(); kk++) {
+				(*kk)->purge14end(this, _pAtom);
 			}
 		}
 		// call the same function on the other atoms (the _propagate=false means to call this back)
@@ -707,27 +766,9 @@ void Atom::purge13(Atom * _pAtom2, Atom * _pAtom3) {
 	 *
 	 *    this -- _pAtom2 -- _pAtom3
 	 *
-	 *  corresponding to
-	 *    boundAtoms[_pAtom2][_pAtom3]
-	 *    oneThreeAtoms[_pAtom3][_pAtom2]
+	 *  corresponding to oneThreeAtoms (_pAtom3, _pAtom2)
 	 *********************************************************/
-	map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator found1=boundAtoms.find(_pAtom2);
-	if (found1 != boundAtoms.end()) {
-		map<Atom*, map<Atom*, bool> >::iterator found2 = found1->second.find(_pAtom3);
-		if (found2 != found1->second.end()) {
-			found1->second.erase(found2);
-		}
-	}
-	map<Atom*, map<Atom*, bool> >::iterator found3 = oneThreeAtoms.find(_pAtom3);
-	if (found3 != oneThreeAtoms.end()) {
-		map<Atom*, bool>::iterator found4 = found3->second.find(_pAtom2);
-		if (found4 != found3->second.end()) {
-			found3->second.erase(found4);
-		}
-		if (found3->second.size() == 0) {
-			oneThreeAtoms.erase(found3);
-		}
-	}
+	eraseSorted(oneThreeAtoms, OneThreeEntry(_pAtom3, _pAtom2));
 }
 
 void Atom::purge14mid(Atom * _pAtom2, Atom * _pAtom3) {
@@ -736,40 +777,16 @@ void Atom::purge14mid(Atom * _pAtom2, Atom * _pAtom3) {
 	 *
 	 *    this -- _pAtom2 -- _pAtom3 -- any atom
 	 *
-	 *  corresponding to
-	 *    boundAtoms[_pAtom2][_pAtom3][any]
-	 *    oneFourAtoms[any][_pAtom2][_pAtom3]
+	 *  corresponding to oneFourAtoms (any, (_pAtom2, _pAtom3))
 	 *********************************************************/
-	vector<Atom*> fourthAtoms;
-	map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator found1=boundAtoms.find(_pAtom2);
-	if (found1 != boundAtoms.end()) {
-		map<Atom*, map<Atom*, bool> >::iterator found2 = found1->second.find(_pAtom3);
-		if (found2 != found1->second.end()) {
-			for (map<Atom*, bool>::iterator k=found2->second.begin(); k!=found2->second.end(); k++) {
-				fourthAtoms.push_back(k->first);
-			}
-			found1->second.erase(found2);
-		}
-	}
-
-	for (vector<Atom*>::iterator k=fourthAtoms.begin(); k!=fourthAtoms.end(); k++) {
-		map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator found3 = oneFourAtoms.find(*k);
-		if (found3 != oneFourAtoms.end()) {
-			map<Atom*, map<Atom*, bool> >::iterator found4 = found3->second.find(_pAtom2);
-			if (found4 != found3->second.end()) {
-				map<Atom*, bool>::iterator found5 = found4->second.find(_pAtom3);
-				if (found5 != found4->second.end()) {
-					found4->second.erase(found5);
-				}
-				if (found4->second.size() == 0) {
-					found3->second.erase(found4);
-				}
-			}
-			if (found3->second.size() == 0) {
-				oneFourAtoms.erase(found3);
-			}
+	vector<OneFourEntry>::iterator kept = oneFourAtoms.begin();
+	for (vector<OneFourEntry>::iterator k=oneFourAtoms.begin(); k!=oneFourAtoms.end(); k++) {
+		if (k->second.first != _pAtom2 || k->second.second != _pAtom3) {
+			*kept = *k;
+			kept++;
 		}
 	}
+	oneFourAtoms.erase(kept, oneFourAtoms.end());
 }
 
 void Atom::purge14end(Atom * _pAtom3, Atom * _pAtom4) {
@@ -778,36 +795,18 @@ void Atom::purge14end(Atom * _pAtom3, Atom * _pAtom4) {
 	 *
 	 *    this -- any atom -- _pAtom3 -- _pAtom4
 	 *
-	 *  corresponding to
-	 *    boundAtoms[any][_pAtom3][_pAtom4]
-	 *    oneFourAtoms[_pAtom4][any][_pAtom3]
+	 *  corresponding to oneFourAtoms (_pAtom4, (any, _pAtom3))
 	 *********************************************************/
-	for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		map<Atom*, map<Atom*, bool> >::iterator found1 = k->second.find(_pAtom3);
-		if (found1 != k->second.end()) {
-			map<Atom*, bool>::iterator found2 = found1->second.find(_pAtom4);
-			if (found2 != found1->second.end()) {
-				found1->second.erase(found2);
-			}
-		}
-	}
-	map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator found3 = oneFourAtoms.find(_pAtom4);
-	if (found3 != oneFourAtoms.end()) {
-		for (map<Atom*, map<Atom*, bool> >::iterator k=found3->second.begin(); k!=found3->second.end();) {
-			map<Atom*, bool>::iterator found4 = k->second.find(_pAtom3);
-			if (found4 != k->second.end()) {
-				k->second.erase(found4);
-			}
-			map<Atom*, map<Atom*, bool> >::iterator tmp = k;
-			k++;
-			if (tmp->second.size() == 0) {
-				found3->second.erase(tmp);
-			}
-		}
-		if (found3->second.size() == 0) {
-			oneFourAtoms.erase(found3);
+	vector<OneFourEntry>::iterator begin = lower_bound(oneFourAtoms.begin(), oneFourAtoms.end(), OneFourEntry(_pAtom4, OneThreeEntry((Atom*)NULL, (Atom*)NULL)));
+	vector<OneFourEntry>::iterator kept = begin;
+	vector<OneFourEntry>::iterator k = begin;
+	for (; k!=oneFourAtoms.end() && k->first == _pAtom4; k++) {
+		if (k->second.second != _pAtom3) {
+			*kept = *k;
+			kept++;
 		}
 	}
+	oneFourAtoms.erase(kept, k);
 }
 
 
@@ -857,6 +856,13 @@ CartesianPoint& Atom::getGroupGeometricCenter(unsigned int _stamp) {
 		return *(*currentCoorIterator);
 	}
 }
+CartesianPoint Atom::calcGroupGeometricCenter() const {
+	if (pParentGroup != NULL) {
+		return pParentGroup->calcGeometricCenter();
+	} else {
+		return *(*currentCoorIterator);
+	}
+}
 
 set<Atom*> Atom::findLinkedAtoms(const set<Atom*> & _excluded) {
 	// Find all atoms that are connected to this atom, except those going through the exclusion list.
@@ -866,14 +872,14 @@ set<Atom*> Atom::findLinkedAtoms(const set<Atom*> & _excluded) {
 //	map<Atom*, bool> bonded = _pAtom->getBonds();
 
 	set<Atom*> linked;
-	for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		if (_excluded.find(k->first) != _excluded.end()) {
+	for (vector<Atom*>::iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
+		if (_excluded.find(*k) != _excluded.end()) {
 			continue;
 		}
-		linked.insert(k->first);
+		linked.insert(*k);
 		set<Atom*> localExcluded = _excluded;
 		localExcluded.insert(this);
-		set<Atom*> linkedToBonded = k->first->findLinkedAtoms(localExcluded);
+		set<Atom*> linkedToBonded = (*k)->findLinkedAtoms(localExcluded);
 		linked.insert(linkedToBonded.begin(), linkedToBonded.end());
 	}
 	return linked;
@@ -1116,6 +1122,43 @@ bool Atom::hideAltCoors(unsigned int _absoluteIndex, unsigned int _relativeIndex
 
 }
 
+void Atom::getConformationState(vector<CartesianPoint> & _coor, vector<CartesianPoint> & _hiddenCoor, vector<unsigned int> & _hiddenIndices, unsigned int & _active) const {
+	_coor.clear();
+	for (vector<CartesianPoint*>::const_iterator k=pCoorVec.begin(); k!=pCoorVec.end(); k++) {
+		_coor.push_back(**k);
+	}
+	_hiddenCoor.clear();
+	for (vector<CartesianPoint*>::const_iterator k=pHiddenCoorVec.begin(); k!=pHiddenCoorVec.end(); k++) {
+		_hiddenCoor.push_back(**k);
+	}
+	_hiddenIndices = hiddenCoorIndeces;
+	_active = getActiveConformation();
+}
+
+void Atom::setConformationState(const vector<CartesianPoint> & _coor, const vector<CartesianPoint> & _hiddenCoor, const vector<unsigned int> & _hiddenIndices, unsigned int _active) {
+	if (_coor.size() == 0 || _active >= _coor.size() || _hiddenCoor.size() != _hiddenIndices.size()) {
+		cerr << "ERROR 22318: invalid conformations in void Atom::setConformationState(const vector<CartesianPoint> & _coor, const vector<CartesianPoint> & _hiddenCoor, const vector<unsigned int> & _hiddenIndices, unsigned int _active)" << endl;
+		exit(22318);
+	}
+	for (vector<CartesianPoint*>::iterator k=pCoorVec.begin(); k!=pCoorVec.end(); k++) {
+		delete *k;
+	}
+	pCoorVec.clear();
+	for (vector<CartesianPoint*>::iterator k=pHiddenCoorVec.begin(); k!=pHiddenCoorVec.end(); k++) {
+		delete *k;
+	}
+	pHiddenCoorVec.clear();
+
+	for (vector<CartesianPoint>::const_iterator k=_coor.begin(); k!=_coor.end(); k++) {
+		pCoorVec.push_back(new CartesianPoint(*k));
+	}
+	for (vector<CartesianPoint>::const_iterator k=_hiddenCoor.begin(); k!=_hiddenCoor.end(); k++) {
+		pHiddenCoorVec.push_back(new CartesianPoint(*k));
+	}
+	hiddenCoorIndeces = _hiddenIndices;
+	currentCoorIterator = pCoorVec.begin() + _active;
+}
+
 bool Atom::unhideAltCoorAbsIndex(unsigned int _absoluteIndex) {
 	if (_absoluteIndex >= pCoorVec.size() + pHiddenCoorVec.size()) {
 		return false;
@@ -1354,3 +1397,43 @@ bool Atom::isPositionCterminal() const {
 	return false;
 }
 
+
+// the registry of the atom types (function statics, so that it is initialized before use)
+static map<string, unsigned int> & typeIdTable() {
+	static map<string, unsigned int> table;
+	return table;
+}
+static vector<string> & typeIdNames() {
+	static vector<string> names;
+	return names;
+}
+
+unsigned int Atom::registerTypeId(string _type) {
+	map<string, unsigned int>::iterator found = typeIdTable().find(_type);
+	if (found != typeIdTable().end()) {
+		return found->second;
+	}
+	unsigned int id = typeIdNames().size();
+	typeIdTable()[_type] = id;
+	typeIdNames().push_back(_type);
+	return id;
+}
+
+unsigned int Atom::findTypeId(string _type) {
+	map<string, unsigned int>::iterator found = typeIdTable().find(_type);
+	if (found != typeIdTable().end()) {
+		return found->second;
+	}
+	return noTypeId;
+}
+
+string Atom::getTypeName(unsigned int _typeId) {
+	if (_typeId < typeIdNames().size()) {
+		return typeIdNames()[_typeId];
+	}
+	return "";
+}
+
+unsigned int Atom::getNumberOfTypeIds() {
+	return typeIdNames().size();
+}
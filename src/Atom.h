@@ -38,6 +38,7 @@ You should have received a copy of the GNU Lesser General Public
 #include <string>
 #include <map>
 #include <set>
+#include <algorithm>
 
 
 // MSL Includes
@@ -104,6 +105,7 @@ class Atom : public Selectable<Atom> {
 		std::string getElement() const;
 		void setType(std::string _type);
 		std::string & getType();
+		unsigned int getTypeId() const; // the integer id of the type (see registerTypeId)
 		void setRadius(double _radius);
 		double getRadius() const;
 		void setCharge(double _charge);
@@ -111,6 +113,7 @@ class Atom : public Selectable<Atom> {
 		void setGroupNumber(unsigned int _groupNumber);
 		unsigned int getGroupNumber() const;
 		CartesianPoint& getGroupGeometricCenter(unsigned int _stamp=0);
+		CartesianPoint calcGroupGeometricCenter() const; // not cached, safe to call from concurrent threads
 		unsigned int getIdentityIndex(); // return the index of its parent identity in the position
 		bool isInAlternativeIdentity(Atom * _pAtom) const; // checks if the two atoms happen to be in the same position but different residue types (cannot coexist)
 
@@ -320,6 +323,15 @@ class Atom : public Selectable<Atom> {
 		bool hideAllAltCoorsButFirstN(unsigned int _numberToKeepAbsIndex); // turns all alt coor off except the first N, expressed as absolute index
 		bool unhideAltCoorAbsIndex(unsigned int _absoluteIndex); // unhide a specific coor based on absolute index
 		bool unhideAllAltCoors();
+
+		/*************************************************************
+		 *  The whole conformation storage at once (used by the
+		 *  SystemSnapshotReader/Writer): the visible coordinates,
+		 *  the hidden ones with their absolute indices and the
+		 *  active (relative) conformation
+		 *************************************************************/
+		void getConformationState(std::vector<CartesianPoint> & _coor, std::vector<CartesianPoint> & _hiddenCoor, std::vector<unsigned int> & _hiddenIndices, unsigned int & _active) const;
+		void setConformationState(const std::vector<CartesianPoint> & _coor, const std::vector<CartesianPoint> & _hiddenCoor, const std::vector<unsigned int> & _hiddenIndices, unsigned int _active);
 	
 		/***************************************************
 		 * As atoms have alternate conformations, residues can
@@ -443,6 +455,9 @@ class Atom : public Selectable<Atom> {
 		bool isOneFour(Atom * _pAtom) const;
 		std::vector<Atom*> getOneThreeMiddleAtoms(Atom * _pAtom) const; // returns a std::vector with the middle atoms for all 1-3 relationships with a given atom _pAtom (generally there is just one unless it is a 4 members ring)
 		std::vector<std::vector<Atom*> > getOneFourMiddleAtoms(Atom * _pAtom) const; // returns a std::vector with the second and third atoms for all 1-4 relationships with a given atom _pAtom (can be multiple in 6 member rings)
+		std::vector<Atom*> getOneThreeAtoms() const; // all atoms that are 1-3 to this atom (each once)
+		std::vector<Atom*> getOneFourAtoms() const; // all atoms that are 1-4 to this atom (each once)
+		static unsigned int getBondRevision(); // incremented every time a bond is created or removed in any atom (see BondGraph)
 		std::set<Atom*> findLinkedAtoms(const std::set<Atom*> & _excluded);
 
 		/***************************************************
@@ -451,6 +466,21 @@ class Atom : public Selectable<Atom> {
 		bool isPositionNterminal() const;
 		bool isPositionCterminal() const;
 
+		/***************************************************
+		 *  Atom types are interned: each type name is
+		 *  registered once in a table shared by all atoms
+		 *  and receives a compact integer id, so that the
+		 *  parameter tables (i.e. CharmmParameterReader)
+		 *  can be indexed by type without string lookups.
+		 *  The id is assigned by setType.  An atom without
+		 *  type has the id noTypeId
+		 ***************************************************/
+		static const unsigned int noTypeId = (unsigned int)-1;
+		static unsigned int registerTypeId(std::string _type); // returns the id, registering the type if new
+		static unsigned int findTypeId(std::string _type); // noTypeId if the type was never registered
+		static std::string getTypeName(unsigned int _typeId);
+		static unsigned int getNumberOfTypeIds();
+
 	private:
 		void setup(CartesianPoint _point, std::string _name, std::string _element);
 		void copy(const Atom & _atom);
@@ -461,6 +491,7 @@ class Atom : public Selectable<Atom> {
 		void purge13(Atom * _pAtom2, Atom * _pAtom3);
 		void purge14mid(Atom * _pAtom2, Atom * _pAtom3);
 		void purge14end(Atom * _pAtom3, Atom * _pAtom4);
+		void getOneThreeAtomsThrough(Atom * _pAtom2, std::vector<Atom*> & _oneThree) const; // the 1-3 atoms this -- _pAtom2 -- X
 		void removeFromIc();
 		//void removeBonds();
 
@@ -476,6 +507,7 @@ class Atom : public Selectable<Atom> {
 		std::string element;
 		double charge;
 		std::string type;
+		unsigned int typeId;
 		double radius;
 		unsigned int groupNumber;
 		double tempFactor;
@@ -509,27 +541,26 @@ class Atom : public Selectable<Atom> {
 
 		/*********************************************************
 		 *  Structure that record what other atoms are bound (directly
-		 *  or indirectly up to 1-4) to this atom
-		 *
-		 *      E   F          bound atoms of A (this)
-		 *       \ /             boundAtoms[B]            A-B 1-2
-		 *        B                boundAtoms[B][E]       A-B-E: 1-3
-		 *        |                boundAtoms[B][F]
-		 *       *A      K       boundAtoms[D]            A-D: 1-2
-		 *       / \    /          boundAtoms[D][I]       A-D-I: 1-3
-		 *   G--C   D--I             boundAtoms[D][I][K]  A-D-I-K: 1-4
-		 *      |   |   \
-		 *      H   J    L     1-3 atoms of A
-		 *         /             oneThreeAtoms[E][B]      E is 1-3 through B
-		 *        M              oneThreeAtoms[I][D]      D is 1-3 through D
-		 *                         
-		 *                     1-4 atoms of A (note the unexpected order 4->2->3)
-		 *                       oneFourAtoms[K][D][I]    K is 1-4 through D-I
-		 *                       oneFourAtoms[M][D][J]    M is 1-4 through D-J
+		 *  or indirectly up to 1-4) to this atom.  Each list is a
+		 *  vector sorted by pointer, so that the lookups are binary
+		 *  searches on a few contiguous entries
+		 *
+		 *      E   F          1-2 atoms of A (this)
+		 *       \ /             boundAtoms:    B C D
+		 *        B                          
+		 *        |            1-3 atoms of A (end atom, middle atom)
+		 *       *A      K       oneThreeAtoms: (E,B) (F,B) (G,C) (H,C) (I,D) (J,D)
+		 *       / \    /       
+		 *   G--C   D--I       1-4 atoms of A (end atom, (second atom, third atom))
+		 *      |   |   \        oneFourAtoms:  (K,(D,I)) (L,(D,I)) (M,(D,J))
+		 *      H   J    L  
+		 *         /          
+		 *        M           
 		 *********************************************************/
-		std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > > boundAtoms;
-		std::map<Atom*, std::map<Atom*, bool> > oneThreeAtoms; // oneThreeAtoms[X][Y] corresponds to this-Y-X
-		std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > > oneFourAtoms; // oneFourAtoms[X][Y][Z] corresponds to this-Y-Z-X
+		std::vector<Atom*> boundAtoms;
+		std::vector<std::pair<Atom*, Atom*> > oneThreeAtoms; // (X, Y) corresponds to this-Y-X
+		std::vector<std::pair<Atom*, std::pair<Atom*, Atom*> > > oneFourAtoms; // (X, (Y, Z)) corresponds to this-Y-Z-X
+		static unsigned int bondRevision;
 
 		// BOOST-RELATED FUNCTIONS , keep them away from main class def.
 #ifdef __BOOST__
@@ -601,8 +632,9 @@ inline void Atom::setName(std::string _name) {name = _name; updateResidueMap();
 inline std::string Atom::getName() const {return name;};
 inline void Atom::setElement(std::string _element) {element = _element;};
 inline std::string Atom::getElement() const {return element;};
-inline void Atom::setType(std::string _type) {type = _type;};
+inline void Atom::setType(std::string _type) {type = _type; typeId = (type == "" ? noTypeId : registerTypeId(type));};
 inline std::string & Atom::getType() {return type;};
+inline unsigned int Atom::getTypeId() const {return typeId;};
 inline void Atom::setRadius(double _radius) {radius = _radius;};
 inline double Atom::getRadius() const {return radius;};
 inline void Atom::setCharge(double _charge) {charge = _charge;};
@@ -781,21 +813,22 @@ inline bool Atom::applySavedCoor(std::string _coordName) {
 //inline std::vector<Atom*> Atom::getBoundAtoms() const {std::vector<Atom*> bonded; for (std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > >::const_iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {bonded.push_back(k->first);} return bonded;}
 //inline std::map<Atom*, bool> & Atom::getBonds() {return bonds;}
 inline std::vector<Atom*> Atom::getBonds() {
-	std::vector<Atom*> bonded;
-	for (std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > >::const_iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		bonded.push_back(k->first);
-	}
-	return bonded;
+	return boundAtoms;
 }
 
 inline std::vector<std::vector<Atom*> > Atom::getBoundAtoms() const {
+	// each 1-2 atom, followed by its 1-3 atoms, each followed by its 1-4 atoms
 	std::vector<std::vector<Atom*> > bonded;
-	for (std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > >::const_iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		bonded.push_back(std::vector<Atom*>(1, k->first));
-		for (std::map<Atom*, std::map<Atom*, bool> >::const_iterator l=k->second.begin(); l!=k->second.end(); l++) {
-			bonded.back().push_back(l->first);
-			for (std::map<Atom*, bool>::const_iterator m=l->second.begin(); m!=l->second.end(); m++) {
-				bonded.back().push_back(m->first);
+	for (std::vector<Atom*>::const_iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
+		bonded.push_back(std::vector<Atom*>(1, *k));
+		std::vector<Atom*> oneThree;
+		getOneThreeAtomsThrough(*k, oneThree);
+		for (std::vector<Atom*>::const_iterator l=oneThree.begin(); l!=oneThree.end(); l++) {
+			bonded.back().push_back(*l);
+			for (std::vector<std::pair<Atom*, std::pair<Atom*, Atom*> > >::const_iterator m=oneFourAtoms.begin(); m!=oneFourAtoms.end(); m++) {
+				if (m->second.first == *k && m->second.second == *l) {
+					bonded.back().push_back(m->first);
+				}
 			}
 		}
 	}
@@ -803,25 +836,21 @@ inline std::vector<std::vector<Atom*> > Atom::getBoundAtoms() const {
 }
 inline std::vector<Atom*> Atom::getOneThreeMiddleAtoms(Atom *_pAtom) const {
 	std::vector<Atom*> middle;
-	std::map<Atom*, std::map<Atom*, bool> >::const_iterator found=oneThreeAtoms.find(_pAtom);
-	if (found != oneThreeAtoms.end()) {
-		for (std::map<Atom*, bool>::const_iterator k=found->second.begin(); k!=found->second.end(); k++) {
-			middle.push_back(k->first);
-		}
+	std::vector<std::pair<Atom*, Atom*> >::const_iterator k = std::lower_bound(oneThreeAtoms.begin(), oneThreeAtoms.end(), std::pair<Atom*, Atom*>(_pAtom, (Atom*)NULL));
+	for (; k!=oneThreeAtoms.end() && k->first == _pAtom; k++) {
+		middle.push_back(k->second);
 	}
 	return middle;
 }
 inline std::vector<std::vector<Atom*> > Atom::getOneFourMiddleAtoms(Atom *_pAtom) const {
 	std::vector<std::vector<Atom*> > middle;
-	std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > >::const_iterator found=oneFourAtoms.find(_pAtom);
-	if (found != oneFourAtoms.end()) {
-		for (std::map<Atom*, std::map<Atom*, bool> >::const_iterator k=found->second.begin(); k!=found->second.end(); k++) {
+	std::vector<std::pair<Atom*, std::pair<Atom*, Atom*> > >::const_iterator k = std::lower_bound(oneFourAtoms.begin(), oneFourAtoms.end(), std::pair<Atom*, std::pair<Atom*, Atom*> >(_pAtom, std::pair<Atom*, Atom*>((Atom*)NULL, (Atom*)NULL)));
+	for (; k!=oneFourAtoms.end() && k->first == _pAtom; k++) {
+		if (middle.size() == 0 || middle.back()[0] != k->second.first) {
 			middle.push_back(std::vector<Atom*>());
-			middle.back().push_back(k->first); // second atom of the 1-4 relationship
-			for (std::map<Atom*, bool>::const_iterator l=k->second.begin(); l!=k->second.end(); l++) {
-				middle.back().push_back(l->first); // 3rd atom
-			}
+			middle.back().push_back(k->second.first); // second atom of the 1-4 relationship
 		}
+		middle.back().push_back(k->second.second); // 3rd atom
 	}
 	return middle;
 }
@@ -830,11 +859,23 @@ inline std::vector<std::vector<Atom*> > Atom::getOneFourMiddleAtoms(Atom *_pAtom
 //inline bool Atom::isOneThree(Atom * _pAtom, const Atom * _14caller) const {if (_pAtom == this) {return false;} for (std::map<Atom*, bool>::const_iterator k=bonds.begin(); k!=bonds.end(); k++) {if (k->first == _pAtom) {return false;} else if (k->first->isBoundTo(_pAtom) && k->first != _14caller) {return true;}} return false;}
 //inline bool Atom::isOneFour(Atom * _pAtom) const {if (_pAtom == this) {return false;} for (std::map<Atom*, bool>::const_iterator k=bonds.begin(); k!=bonds.end(); k++) {if (k->first == _pAtom) {return false;} else if (k->first->isOneThree(_pAtom, this)) {return true;}} return false;}
 
-inline bool Atom::isBoundTo(Atom * _pAtom) const { return boundAtoms.find(_pAtom) != boundAtoms.end(); }
-inline bool Atom::isOneThree(Atom * _pAtom) const { return oneThreeAtoms.find(_pAtom) != oneThreeAtoms.end(); }
-inline bool Atom::isOneFour(Atom * _pAtom) const { return oneFourAtoms.find(_pAtom) != oneFourAtoms.end(); }
+inline bool Atom::isBoundTo(Atom * _pAtom) const { return std::binary_search(boundAtoms.begin(), boundAtoms.end(), _pAtom); }
+inline bool Atom::isOneThree(Atom * _pAtom) const {
+	std::vector<std::pair<Atom*, Atom*> >::const_iterator k = std::lower_bound(oneThreeAtoms.begin(), oneThreeAtoms.end(), std::pair<Atom*, Atom*>(_pAtom, (Atom*)NULL));
+	return k != oneThreeAtoms.end() && k->first == _pAtom;
+}
+inline bool Atom::isOneFour(Atom * _pAtom) const {
+	std::vector<std::pair<Atom*, std::pair<Atom*, Atom*> > >::const_iterator k = std::lower_bound(oneFourAtoms.begin(), oneFourAtoms.end(), std::pair<Atom*, std::pair<Atom*, Atom*> >(_pAtom, std::pair<Atom*, Atom*>((Atom*)NULL, (Atom*)NULL)));
+	return k != oneFourAtoms.end() && k->first == _pAtom;
+}
+inline unsigned int Atom::getBondRevision() { return bondRevision; }
 inline bool Atom::isInAlternativeIdentity(Atom * _pAtom) const {return getParentPosition() == _pAtom->getParentPosition() && getParentResidue() != _pAtom->getParentResidue();}
 inline double Atom::groupDistance(Atom & _atom, unsigned int _stamp) {
+	if (_stamp == 0) {
+		// no stamp, the center would be recalculated anyway: do not write the
+		// cache of the group, so that the energies can be computed in parallel
+		return MSL::CartesianGeometry::distance(calcGroupGeometricCenter(), _atom.calcGroupGeometricCenter());
+	}
 	return MSL::CartesianGeometry::distance(getGroupGeometricCenter(_stamp), _atom.getGroupGeometricCenter(_stamp));
 }
 
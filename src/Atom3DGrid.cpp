@@ -1,4 +1,5 @@
 #include "Atom3DGrid.h"
+#include <algorithm>
 
 using namespace MSL;
 using namespace std;
@@ -14,6 +15,25 @@ Atom3DGrid::Atom3DGrid(AtomPointerVector & _atoms, double _gridSize) {
 	buildGrid();
 }
 
+Atom3DGrid::Atom3DGrid(AtomPointerVector & _atoms, const vector<double> & _xMin, const vector<double> & _xMax, const vector<double> & _yMin, const vector<double> & _yMax, const vector<double> & _zMin, const vector<double> & _zMax, double _gridSize) {
+	setup(_atoms, _gridSize);
+	if (_xMin.size() != _atoms.size() || _xMax.size() != _atoms.size() || _yMin.size() != _atoms.size() || _yMax.size() != _atoms.size() || _zMin.size() != _atoms.size() || _zMax.size() != _atoms.size()) {
+		cerr << "ERROR 51603: the number of boxes does not match the number of atoms in Atom3DGrid::Atom3DGrid(AtomPointerVector & _atoms, const vector<double> & _xMin, ..., double _gridSize)" << endl;
+		exit(51603);
+	}
+	if (_gridSize <= 0.0) {
+		cerr << "ERROR 51608: invalid grid size " << _gridSize << " in Atom3DGrid::Atom3DGrid(AtomPointerVector & _atoms, const vector<double> & _xMin, ..., double _gridSize)" << endl;
+		exit(51608);
+	}
+	boxXMin = _xMin;
+	boxXMax = _xMax;
+	boxYMin = _yMin;
+	boxYMax = _yMax;
+	boxZMin = _zMin;
+	boxZMax = _zMax;
+	buildBoxGrid();
+}
+
 Atom3DGrid::~Atom3DGrid() {
 }
 
@@ -148,3 +168,127 @@ AtomPointerVector Atom3DGrid::getNeighbors(unsigned int _atomIndex) {
 	return out;
 }
 
+unsigned int Atom3DGrid::getBoxBin(double _value, double _start, unsigned int _size) const {
+	// the binning is monotonic, so two overlapping boxes always share at least one cell
+	double bin = (_value - _start)/gridSize;
+	if (bin < 0.0) {
+		return 0;
+	}
+	if (bin >= (double)(_size - 1)) {
+		return _size - 1;
+	}
+	return (unsigned int)bin;
+}
+
+void Atom3DGrid::buildBoxGrid() {
+
+	boxCells.clear();
+	boxBins = vector<vector<unsigned int> >(atoms.size(), vector<unsigned int>(6, 0));
+
+	// calculate the max dimensions of the non-empty boxes
+	bool found = false;
+	unsigned int nonEmpty = 0;
+	for (unsigned int i=0; i<boxXMin.size(); i++) {
+		if (boxXMin[i] > boxXMax[i] || boxYMin[i] > boxYMax[i] || boxZMin[i] > boxZMax[i]) {
+			continue;
+		}
+		if (!found) {
+			xMin = boxXMin[i];
+			xMax = boxXMax[i];
+			yMin = boxYMin[i];
+			yMax = boxYMax[i];
+			zMin = boxZMin[i];
+			zMax = boxZMax[i];
+			found = true;
+		}
+		if (boxXMin[i] < xMin) {
+			xMin = boxXMin[i];
+		}
+		if (boxXMax[i] > xMax) {
+			xMax = boxXMax[i];
+		}
+		if (boxYMin[i] < yMin) {
+			yMin = boxYMin[i];
+		}
+		if (boxYMax[i] > yMax) {
+			yMax = boxYMax[i];
+		}
+		if (boxZMin[i] < zMin) {
+			zMin = boxZMin[i];
+		}
+		if (boxZMax[i] > zMax) {
+			zMax = boxZMax[i];
+		}
+		nonEmpty++;
+	}
+	if (!found) {
+		xSize = ySize = zSize = 0;
+		for (unsigned int i=0; i<boxBins.size(); i++) {
+			boxBins[i][0] = 1;
+		}
+		return;
+	}
+
+	// coarsen the grid if a few distant boxes would make it too large for the number of boxes
+	while (true) {
+		xSize = (unsigned int)((xMax - xMin)/gridSize) + 1;
+		ySize = (unsigned int)((yMax - yMin)/gridSize) + 1;
+		zSize = (unsigned int)((zMax - zMin)/gridSize) + 1;
+		if ((double)xSize * (double)ySize * (double)zSize <= 8.0 * (double)nonEmpty + 1000.0) {
+			break;
+		}
+		gridSize *= 2.0;
+	}
+
+	boxCells = vector<vector<unsigned int> >(xSize * ySize * zSize);
+	for (unsigned int i=0; i<boxXMin.size(); i++) {
+		if (boxXMin[i] > boxXMax[i] || boxYMin[i] > boxYMax[i] || boxZMin[i] > boxZMax[i]) {
+			// empty box, give it an empty range of cells
+			boxBins[i][0] = 1;
+			continue;
+		}
+		boxBins[i][0] = getBoxBin(boxXMin[i], xMin, xSize);
+		boxBins[i][1] = getBoxBin(boxXMax[i], xMin, xSize);
+		boxBins[i][2] = getBoxBin(boxYMin[i], yMin, ySize);
+		boxBins[i][3] = getBoxBin(boxYMax[i], yMin, ySize);
+		boxBins[i][4] = getBoxBin(boxZMin[i], zMin, zSize);
+		boxBins[i][5] = getBoxBin(boxZMax[i], zMin, zSize);
+		for (unsigned int x=boxBins[i][0]; x<=boxBins[i][1]; x++) {
+			for (unsigned int y=boxBins[i][2]; y<=boxBins[i][3]; y++) {
+				for (unsigned int z=boxBins[i][4]; z<=boxBins[i][5]; z++) {
+					boxCells[(x * ySize + y) * zSize + z].push_back(i);
+				}
+			}
+		}
+	}
+}
+
+vector<unsigned int> Atom3DGrid::getOverlappingBoxes(unsigned int _atomIndex, bool _higherIndecesOnly) const {
+	vector<unsigned int> out;
+	if (_atomIndex >= boxBins.size()) {
+		return out;
+	}
+	const vector<unsigned int> & bins = boxBins[_atomIndex];
+	for (unsigned int x=bins[0]; x<=bins[1]; x++) {
+		for (unsigned int y=bins[2]; y<=bins[3]; y++) {
+			for (unsigned int z=bins[4]; z<=bins[5]; z++) {
+				const vector<unsigned int> & cell = boxCells[(x * ySize + y) * zSize + z];
+				for (vector<unsigned int>::const_iterator k=cell.begin(); k!=cell.end(); k++) {
+					if (*k == _atomIndex || (_higherIndecesOnly && *k < _atomIndex)) {
+						continue;
+					}
+					if (boxXMax[_atomIndex] < boxXMin[*k] || boxXMax[*k] < boxXMin[_atomIndex] || boxYMax[_atomIndex] < boxYMin[*k] || boxYMax[*k] < boxYMin[_atomIndex] || boxZMax[_atomIndex] < boxZMin[*k] || boxZMax[*k] < boxZMin[_atomIndex]) {
+						// the boxes share a cell but do not overlap
+						continue;
+					}
+					out.push_back(*k);
+				}
+			}
+		}
+	}
+	// a pair of boxes can share more than one cell
+	sort(out.begin(), out.end());
+	out.erase(unique(out.begin(), out.end()), out.end());
+	return out;
+}
+
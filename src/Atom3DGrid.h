@@ -19,6 +19,15 @@ class Atom3DGrid {
 	public:
 		Atom3DGrid();
 		Atom3DGrid(AtomPointerVector & _atoms, double _gridSize=1.0);
+		/*******************************************************************
+		   Grid of boxes: each atom is represented by an axis-aligned box
+		   (for example the box that contains all the alternative conformations
+		   of the atom) and it is placed in every cell that the box overlaps.
+		   Boxes with a minimum larger than the maximum are empty and are not
+		   placed in the grid.  getOverlappingBoxes returns the indeces
+		   of the atoms whose boxes overlap the box of an atom
+		 *******************************************************************/
+		Atom3DGrid(AtomPointerVector & _atoms, const std::vector<double> & _xMin, const std::vector<double> & _xMax, const std::vector<double> & _yMin, const std::vector<double> & _yMax, const std::vector<double> & _zMin, const std::vector<double> & _zMax, double _gridSize);
 		~Atom3DGrid();
 
 		unsigned int getXSize() const;
@@ -29,10 +38,14 @@ class Atom3DGrid {
 
 		AtomPointerVector getCell(unsigned int _i, unsigned int _j, unsigned int _k);
 		AtomPointerVector getNeighbors(unsigned int _atomIndex);
+		// sorted indeces of the overlapping boxes (only those of atoms after _atomIndex if _higherIndecesOnly is true)
+		std::vector<unsigned int> getOverlappingBoxes(unsigned int _atomIndex, bool _higherIndecesOnly=false) const;
 		
 	private:
 		void setup(AtomPointerVector & _atoms, double _gridSize);
 		void buildGrid();
+		void buildBoxGrid();
+		unsigned int getBoxBin(double _value, double _start, unsigned int _size) const;
 		double gridSize;
 		AtomPointerVector atoms;
 		std::vector<std::vector<unsigned int> > atomIndeces;
@@ -47,6 +60,15 @@ class Atom3DGrid {
 		unsigned int ySize;
 		unsigned int zSize;
 		
+		// for the grid of boxes
+		std::vector<double> boxXMin;
+		std::vector<double> boxXMax;
+		std::vector<double> boxYMin;
+		std::vector<double> boxYMax;
+		std::vector<double> boxZMin;
+		std::vector<double> boxZMax;
+		std::vector<std::vector<unsigned int> > boxCells; // flat x,y,z cell index, atom indeces
+		std::vector<std::vector<unsigned int> > boxBins; // first and last x,y,z cells of each box
 };
 
 inline AtomPointerVector Atom3DGrid::getCell(unsigned int _i, unsigned int _j, unsigned int _k) { return grid[_i][_j][_k]; }
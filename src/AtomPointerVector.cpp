@@ -153,16 +153,20 @@ CartesianPoint& AtomPointerVector::getGeometricCenter(unsigned int _stamp) {
 	 ************************************************************/
 	if (_stamp == 0 || updateStamp != _stamp) {
 		updateStamp = _stamp;
-		CartesianPoint tmp(0.0, 0.0, 0.0);
-
-		for (unsigned int i=0; i<size(); i++) {
-			tmp += (*this)[i]->getCoor();
-		}
-		geometricCenter = tmp/(double)size();
+		geometricCenter = calcGeometricCenter();
 	}
 	return geometricCenter;
 }
 
+CartesianPoint AtomPointerVector::calcGeometricCenter() const {
+	CartesianPoint tmp(0.0, 0.0, 0.0);
+
+	for (unsigned int i=0; i<size(); i++) {
+		tmp += (*this)[i]->getCoor();
+	}
+	return tmp/(double)size();
+}
+
 
 
 double AtomPointerVector::rmsd(const AtomPointerVector &_av) const {
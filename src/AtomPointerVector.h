@@ -81,6 +81,7 @@ class AtomPointerVector : public std::vector<Atom *> {
 		std::string getName() const;
 	//	CartesianPoint getGeometricCenter() const;
 		CartesianPoint& getGeometricCenter(unsigned int _stamp=0);
+		CartesianPoint calcGeometricCenter() const; // not cached, safe to call from concurrent threads
 
 		// Geometric Center
 	 //       void updateGeometricCenter(unsigned int _updateStamp=0);
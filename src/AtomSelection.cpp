@@ -29,6 +29,8 @@ You should have received a copy of the GNU Lesser General Public
 
 
 #include "AtomSelection.h"
+#include <climits>
+#include <cstdio>
 
 using namespace MSL;
 using namespace std;
@@ -154,28 +156,7 @@ AtomPointerVector& AtomSelection::select(string _selectString, bool _selectAllAt
 
 		// find any atom that is within the range of selection 2
 		AtomPointerVector aroundSele2;
-		for (AtomPointerVector::iterator avIt = data->begin();avIt != data->end();avIt++){
-			if (!(*avIt)->hasCoor()) {
-				// skip atoms that do not have coordinates
-				continue;
-			}
-			if((*avIt)->getSelectionFlag("_TMP1_")) {
-				// it is part of the sele1, it goes in
-				aroundSele2.push_back(*avIt);
-				continue;
-			}
-			for (AtomPointerVector::iterator avJt = sele2atoms.begin();avJt != sele2atoms.end();avJt++){
-				if (!(*avJt)->hasCoor()) { 
-					// skip atoms that do not have coordinates
-					continue;
-				}
-				if ((*avIt)->distance(**avJt) < radius) {
-					// atom within the radius of sele 2
-					aroundSele2.push_back(*avIt);
-					break;
-				}
-			}
-		}
+		withinSelect(sele2atoms, radius, aroundSele2);
 
 		// delete the temporary selection and return
 		clearStoredSelection("_TMP1_");
@@ -187,154 +168,138 @@ AtomPointerVector& AtomSelection::select(string _selectString, bool _selectAllAt
 	}
 }
 
+void AtomSelection::withinSelect(AtomPointerVector & _sele2atoms, double _radius, AtomPointerVector & _out) {
+	/*********************************************************
+	 *  The atoms of selection 2 are placed in a grid as boxes
+	 *  that extend by the radius around them, the other atoms
+	 *  as points: only the boxes that contain an atom need
+	 *  to be checked for the distance
+	 *********************************************************/
+	unsigned int tmpId = Atom::findSelectionId("_TMP1_");
+
+	// selection 2 is a subset of the data in the same order
+	vector<bool> inSele2(data->size(), false);
+	unsigned int j = 0;
+	for (unsigned int i=0; i<data->size() && j<_sele2atoms.size(); i++) {
+		if ((*data)[i] == _sele2atoms[j]) {
+			inSele2[i] = true;
+			j++;
+		}
+	}
+
+	// the boxes are padded so that rounding cannot exclude an atom that passes the distance test
+	double pad = _radius * (1.0 + 1.0e-9) + 1.0e-9;
+	vector<double> xMin(data->size(), 1.0);
+	vector<double> xMax(data->size(), 0.0);
+	vector<double> yMin(data->size(), 1.0);
+	vector<double> yMax(data->size(), 0.0);
+	vector<double> zMin(data->size(), 1.0);
+	vector<double> zMax(data->size(), 0.0);
+	bool useGrid = _radius > 0.0;
+	for (unsigned int i=0; i<data->size() && useGrid; i++) {
+		if (!(*data)[i]->hasCoor()) {
+			// empty box
+			continue;
+		}
+		CartesianPoint & coor = (*data)[i]->getCoor();
+		double r = inSele2[i] ? pad : 0.0;
+		xMin[i] = coor.getX() - r;
+		xMax[i] = coor.getX() + r;
+		yMin[i] = coor.getY() - r;
+		yMax[i] = coor.getY() + r;
+		zMin[i] = coor.getZ() - r;
+		zMax[i] = coor.getZ() + r;
+	}
+	Atom3DGrid grid;
+	if (useGrid) {
+		grid = Atom3DGrid(*data, xMin, xMax, yMin, yMax, zMin, zMax, _radius);
+	}
+
+	for (unsigned int i=0; i<data->size(); i++) {
+		Atom * pAtom = (*data)[i];
+		if (!pAtom->hasCoor()) {
+			// skip atoms that do not have coordinates
+			continue;
+		}
+		if (pAtom->getSelectionFlag(tmpId)) {
+			// it is part of the sele2, it goes in
+			_out.push_back(pAtom);
+			continue;
+		}
+		if (!useGrid) {
+			// no atom can be closer than a non positive radius
+			continue;
+		}
+		vector<unsigned int> overlapping = grid.getOverlappingBoxes(i);
+		for (vector<unsigned int>::iterator k=overlapping.begin(); k!=overlapping.end(); k++) {
+			if (inSele2[*k] && pAtom->distance(*(*data)[*k]) < _radius) {
+				// atom within the radius of sele 2
+				_out.push_back(pAtom);
+				break;
+			}
+		}
+	}
+}
+
 AtomPointerVector& AtomSelection::logicalSelect(string _selectString, string _name, AtomPointerVector & _atoms, bool _selectAllAtoms){
 
-	if (!cond.setLogic(_selectString)) {
+	CompiledLogic * pCompiled = compileLogic(_selectString);
+	if (pCompiled == NULL) {
 		cerr << "WARNING 32773: selection statement " << _selectString << " not valid in AtomPointerVector& AtomSelection::logicalSelect(string _selectString, string _name, AtomPointerVector & _atoms, bool _selectAllAtoms)" << endl;
 		return storedSelections[_name];
 	}
 	if (debug){
-		cout << "Reconstructed selection logic: " << cond.printLogicalConditions() << endl;
+		cout << "Reconstructed selection logic: " << pCompiled->logic.printLogicalConditions() << endl;
 	}
 
+	// register the selection name once, the flags are then set by integer id
+	unsigned int nameId = Atom::registerSelectionId(_name);
+
+	// the stored selections used by the logic are resolved once
+	vector<CompiledCondition> & conditions = pCompiled->conditions;
+	bool success = true;
+	for (unsigned int c=0; c<conditions.size(); c++) {
+		if (conditions[c].type == SELECTION_CONDITION) {
+			if (storedSelections.find(conditions[c].values[0]) != storedSelections.end()) {
+				conditions[c].selectionId = Atom::findSelectionId(conditions[c].values[0]);
+			} else {
+				success = false;
+			}
+		} else if (conditions[c].type == INVALID_CONDITION) {
+			success = false;
+		} else if (conditions[c].type == BLANK_CONDITION) {
+			// invalid condition
+			cerr << "WARNING 32778: blank condition (ignored) in selection statement " << _selectString << " in AtomPointerVector& AtomSelection::logicalSelect(string _selectString, string _name, AtomPointerVector & _atoms, bool _selectAllAtoms)" << endl;
+		}
+	}
+
+	vector<bool> values(conditions.size(), false);
 	for (AtomPointerVector::iterator avIt = _atoms.begin();avIt != _atoms.end();avIt++){
-		//  let's reset the query status of the condition
-		cond.restartQuery();
 
 		// first check if the atoms should be discarded because inactive
 		if (_selectAllAtoms || (*avIt)->getActive()) {
 
-			bool success = true;
-			// answer all the question asked by the LogicalCondition
-			while (!cond.logicComplete()) {
-				vector<string> tokens = cond.getLogicalCondition();
-				if (tokens.size() < 1) {
-					// invalid condition
-					cerr << "WARNING 32778: blank condition (ignored) in selection statement " << _selectString << " in AtomPointerVector& AtomSelection::logicalSelect(string _selectString, string _name, AtomPointerVector & _atoms, bool _selectAllAtoms)" << endl;
-					continue;
-				}
-
-				// check if the atom satisfies the condition
-				bool condition = false;
-				if (tokens[0] == "ALL" && tokens.size() == 1) {
-					// all atoms
-					condition = true;
-				} else if (tokens[0] == "NAME" && tokens.size() == 2) {
-					vector<string> vals=MslTools::tokenize(tokens[1], "+"); // split if it is multi CA+CB+CG
-					for (unsigned int i=0; i<vals.size(); i++) {
-						if (vals[i] == (*avIt)->getName()) {
-							condition = true;
-							break;
-						} 
-					}
-				} else if (tokens[0] == "RESI" && tokens.size() == 2) {
-					vector<string> vals=MslTools::tokenize(tokens[1], "+"); // split if it is multi 7+18+22
-					for (unsigned int i=0; i<vals.size(); i++) {
-						vector<string> range=MslTools::tokenize(vals[i], "-"); // split if it is ranges 
-						if (range.size() == 2) {
-							// range: resi 6-9
-							int start = MslTools::toInt(range[0]);
-							int end = MslTools::toInt(range[1]);
-							if (start <= (*avIt)->getResidueNumber() && end >= (*avIt)->getResidueNumber()) {
-								condition = true;
-								break;
-							} 
-						} else {
-							// note this support also a possible insertion code by using the positionId with
-							// a skip-level of 1 (skip chain), i.e. "37" or "37A" (the above range doesn't)
-							if (vals[i] == (*avIt)->getPositionId(1)) {
-								condition = true;
-								break;
-							} 
-						}
-//<<<<<<< .mine
-					}
-				} else if (tokens[0] == "RESN" && tokens.size() == 2) {
-					vector<string> vals=MslTools::tokenize(tokens[1], "+"); // split if it is multi ALA+LEU+VAL
-					for (unsigned int i=0; i<vals.size(); i++) {
-						if (vals[i] == (*avIt)->getResidueName()) {
-//=======
-//					} else if (tokens[0] == "CHAIN" && tokens.size() == 2) {
-//						vector<string> vals=MslTools::tokenize(tokens[1], "+"); // split if it is multi A+B+C
-//						for (unsigned int i=0; i<vals.size(); i++) {
-//							if (vals[i] == (*avIt)->getChainId()) {
-//								condition = true;
-//								break;
-//							} 
-//						}
-//					} else if (tokens[0] == "HASCRD" || tokens[0] == "HASCOOR") {
-//						bool cmp = true;
-//						if (tokens.size() == 2) {
-//							// HASCRD FALSE or HASCRD 0 or HASCRD TRUE or HASCRD 1
-//							cmp = MslTools::toBool(tokens[1]);
-//						}
-//						if ((*avIt)->hasCoor() == cmp) {
-//>>>>>>> .r450
-							condition = true;
-							break;
-						} 
-					}
-				} else if (tokens[0] == "CHAIN" && tokens.size() == 2) {
-					vector<string> vals=MslTools::tokenize(tokens[1], "+"); // split if it is multi A+B+C
-					for (unsigned int i=0; i<vals.size(); i++) {
-						if (vals[i] == (*avIt)->getChainId()) {
-							condition = true;
-							break;
-						} 
-					}
-				} else if (tokens[0] == "HASCRD" || tokens[0] == "HASCOOR") {
-					bool cmp = true;
-					if (tokens.size() == 2) {
-						// HASCRD FALSE or HASCRD 0 or HASCRD TRUE or HASCRD 1
-						cmp = MslTools::toBool(tokens[1]);
-					}
-					if ((*avIt)->hasCoor() == cmp) {
-						condition = true;
-					} 
-				} else if (tokens.size() == 1 && storedSelections.find(tokens[0]) != storedSelections.end()) {
-					// another selection
-					if ((*avIt)->getSelectionFlag(tokens[0])) {
-						condition = true;
-					}
-				} else {
-					cerr << "WARNING 32783: unrecognized condition (ignored) in selection statement " << _selectString << " in AtomPointerVector& AtomSelection::logicalSelect(string _selectString, string _name, AtomPointerVector & _atoms, bool _selectAllAtoms)" << endl;
-					success = false;
-					break;
-				}
-//<<<<<<< .mine
-				//if (debug) {
-				//	cout << "CONDITION: " << MslTools::joinLines(tokens) << " " << condition << endl;
-				//}
-				// pass the info to the LogicalCondition, the object keeps track of the logic
-				cond.setLogicalConditionValue(condition);
-//=======
-//				// time to decide if this atoms is selected or not
-//				bool selected = cond.getOverallBooleanState();
-//				if (debug) {
-//					cout << cond.printLogicalConditionsWithValues() << endl;
-//				}
-//				if (selected) {
-//					storedSelections[name].push_back(*avIt);
-//				}
-//				// turn the atom's selection flag on/off
-//				(*avIt)->setSelectionFlag(name, selected);
-//
-//>>>>>>> .r450
-			}
 			if (!success) {
 				// the atom selection syntax was problematic
+				cerr << "WARNING 32783: unrecognized condition (ignored) in selection statement " << _selectString << " in AtomPointerVector& AtomSelection::logicalSelect(string _selectString, string _name, AtomPointerVector & _atoms, bool _selectAllAtoms)" << endl;
 				break;
 			}
+
+			// check if the atom satisfies each condition
+			for (unsigned int c=0; c<conditions.size(); c++) {
+				values[c] = evaluateCondition(conditions[c], **avIt);
+			}
+
 			// time to decide if this atoms is selected or not
-			bool selected = cond.getOverallBooleanState();
+			bool selected = evaluateLogic(*pCompiled, values);
 			if (debug) {
-				cout << cond.printLogicalConditionsWithValues() << endl;
+				cout << pCompiled->logic.printLogicalConditionsWithValues() << endl;
 			}
 			if (selected) {
 				storedSelections[_name].push_back(*avIt);
 			}
 			// turn the atom's selection flag on/off
-			(*avIt)->setSelectionFlag(_name, selected);
+			(*avIt)->setSelectionFlag(nameId, selected);
 
 		}
 
@@ -344,6 +309,209 @@ AtomPointerVector& AtomSelection::logicalSelect(string _selectString, string _na
 	return storedSelections[_name];
 
 }
+
+AtomSelection::CompiledLogicCache AtomSelection::compiledLogic;
+
+void AtomSelection::CompiledLogicCache::clear() {
+	for (map<string, CompiledLogic*>::iterator k=logic.begin(); k!=logic.end(); k++) {
+		delete k->second;
+	}
+	logic.clear();
+}
+
+AtomSelection::CompiledLogicCache::~CompiledLogicCache() {
+	clear();
+}
+
+AtomSelection::CompiledLogic * AtomSelection::compileLogic(const string & _selectString) {
+	map<string, CompiledLogic*>::iterator found = compiledLogic.logic.find(_selectString);
+	if (found != compiledLogic.logic.end()) {
+		return found->second;
+	}
+
+	CompiledLogic * pCompiled = new CompiledLogic;
+	if (!pCompiled->logic.setLogic(_selectString)) {
+		delete pCompiled;
+		return NULL;
+	}
+
+	// record the sequence of conditions asked by the LogicalCondition
+	pCompiled->logic.restartQuery();
+	while (!pCompiled->logic.logicComplete()) {
+		vector<string> tokens = pCompiled->logic.getLogicalCondition();
+		pCompiled->conditions.push_back(compileCondition(tokens));
+		if (pCompiled->conditions.back().type != BLANK_CONDITION) {
+			pCompiled->logic.setLogicalConditionValue(false);
+		}
+	}
+	if (pCompiled->conditions.size() <= MAX_TRUTH_TABLE_CONDITIONS) {
+		pCompiled->truthTable = vector<signed char>(1 << pCompiled->conditions.size(), -1);
+	}
+
+	if (compiledLogic.logic.size() >= MAX_COMPILED_SELECTIONS) {
+		compiledLogic.clear();
+	}
+	compiledLogic.logic[_selectString] = pCompiled;
+	return pCompiled;
+}
+
+AtomSelection::CompiledCondition AtomSelection::compileCondition(const vector<string> & _tokens) const {
+	CompiledCondition out;
+	out.type = INVALID_CONDITION;
+	out.hasCoor = true;
+	out.selectionId = Atom::noSelectionId;
+	if (_tokens.size() < 1) {
+		out.type = BLANK_CONDITION;
+	} else if (_tokens[0] == "ALL" && _tokens.size() == 1) {
+		// all atoms
+		out.type = ALL_CONDITION;
+	} else if (_tokens[0] == "NAME" && _tokens.size() == 2) {
+		out.type = NAME_CONDITION;
+		out.values = MslTools::tokenize(_tokens[1], "+"); // split if it is multi CA+CB+CG
+	} else if (_tokens[0] == "RESI" && _tokens.size() == 2) {
+		out.type = RESI_CONDITION;
+		vector<string> vals=MslTools::tokenize(_tokens[1], "+"); // split if it is multi 7+18+22
+		for (unsigned int i=0; i<vals.size(); i++) {
+			vector<string> range=MslTools::tokenize(vals[i], "-"); // split if it is ranges 
+			if (range.size() == 2) {
+				// range: resi 6-9
+				out.rangeStart.push_back(MslTools::toInt(range[0]));
+				out.rangeEnd.push_back(MslTools::toInt(range[1]));
+			} else {
+				// note this support also a possible insertion code by using the positionId with
+				// a skip-level of 1 (skip chain), i.e. "37" or "37A" (the above range doesn't)
+				out.positionIds.push_back(vals[i]);
+				// the position id of an atom without insertion code is the residue number as %d
+				char * end;
+				long resnum = strtol(vals[i].c_str(), &end, 10);
+				if (*end == '\0' && resnum >= INT_MIN && resnum <= INT_MAX) {
+					char c[100];
+					sprintf(c, "%d", (int)resnum);
+					if (vals[i] == (string)c) {
+						out.resnums.push_back((int)resnum);
+					}
+				}
+			}
+		}
+	} else if (_tokens[0] == "RESN" && _tokens.size() == 2) {
+		out.type = RESN_CONDITION;
+		out.values = MslTools::tokenize(_tokens[1], "+"); // split if it is multi ALA+LEU+VAL
+	} else if (_tokens[0] == "CHAIN" && _tokens.size() == 2) {
+		out.type = CHAIN_CONDITION;
+		out.values = MslTools::tokenize(_tokens[1], "+"); // split if it is multi A+B+C
+	} else if (_tokens[0] == "HASCRD" || _tokens[0] == "HASCOOR") {
+		out.type = HASCRD_CONDITION;
+		if (_tokens.size() == 2) {
+			// HASCRD FALSE or HASCRD 0 or HASCRD TRUE or HASCRD 1
+			out.hasCoor = MslTools::toBool(_tokens[1]);
+		}
+	} else if (_tokens.size() == 1) {
+		// another selection (if it exists when the selection is made)
+		out.type = SELECTION_CONDITION;
+		out.values.push_back(_tokens[0]);
+	}
+	return out;
+}
+
+bool AtomSelection::evaluateCondition(const CompiledCondition & _condition, Atom & _atom) const {
+	switch (_condition.type) {
+		case ALL_CONDITION:
+			return true;
+		case NAME_CONDITION: {
+			string name = _atom.getName();
+			for (unsigned int i=0; i<_condition.values.size(); i++) {
+				if (_condition.values[i] == name) {
+					return true;
+				}
+			}
+			return false;
+		}
+		case RESI_CONDITION: {
+			int resnum = _atom.getResidueNumber();
+			for (unsigned int i=0; i<_condition.rangeStart.size(); i++) {
+				if (_condition.rangeStart[i] <= resnum && _condition.rangeEnd[i] >= resnum) {
+					return true;
+				}
+			}
+			if (_condition.positionIds.size() == 0) {
+				return false;
+			}
+			string icode = _atom.getResidueIcode();
+			if (icode == "" || MslTools::trim(icode) == "") {
+				for (unsigned int i=0; i<_condition.resnums.size(); i++) {
+					if (_condition.resnums[i] == resnum) {
+						return true;
+					}
+				}
+				return false;
+			}
+			string positionId = _atom.getPositionId(1);
+			for (unsigned int i=0; i<_condition.positionIds.size(); i++) {
+				if (_condition.positionIds[i] == positionId) {
+					return true;
+				}
+			}
+			return false;
+		}
+		case RESN_CONDITION: {
+			string resName = _atom.getResidueName();
+			for (unsigned int i=0; i<_condition.values.size(); i++) {
+				if (_condition.values[i] == resName) {
+					return true;
+				}
+			}
+			return false;
+		}
+		case CHAIN_CONDITION: {
+			string chainId = _atom.getChainId();
+			for (unsigned int i=0; i<_condition.values.size(); i++) {
+				if (_condition.values[i] == chainId) {
+					return true;
+				}
+			}
+			return false;
+		}
+		case HASCRD_CONDITION:
+			return _atom.hasCoor() == _condition.hasCoor;
+		case SELECTION_CONDITION:
+			return _atom.getSelectionFlag(_condition.selectionId);
+		default:
+			return false;
+	}
+}
+
+bool AtomSelection::evaluateLogic(CompiledLogic & _compiled, const vector<bool> & _values) {
+	// the truth table is not used in debug mode, so that the LogicalCondition can print the values
+	bool useTable = !debug && _compiled.truthTable.size() > 0;
+	unsigned int key = 0;
+	if (useTable) {
+		for (unsigned int c=0; c<_values.size(); c++) {
+			if (_values[c] && _compiled.conditions[c].type != BLANK_CONDITION) {
+				key |= (1 << c);
+			}
+		}
+		if (_compiled.truthTable[key] != -1) {
+			return _compiled.truthTable[key] == 1;
+		}
+	}
+
+	// answer all the question asked by the LogicalCondition
+	_compiled.logic.restartQuery();
+	unsigned int c = 0;
+	while (!_compiled.logic.logicComplete()) {
+		_compiled.logic.getLogicalCondition();
+		if (c < _values.size() && _compiled.conditions[c].type != BLANK_CONDITION) {
+			_compiled.logic.setLogicalConditionValue(_values[c]);
+		}
+		c++;
+	}
+	bool out = _compiled.logic.getOverallBooleanState();
+	if (useTable) {
+		_compiled.truthTable[key] = out ? 1 : 0;
+	}
+	return out;
+}
+
 // END OF ALESSANDRO'S CODE
 
 #else
@@ -44,6 +44,12 @@ You should have received a copy of the GNU Lesser General Public
 
 #include "Hash.h"
 #include "AtomPointerVector.h"
+#include "Atom3DGrid.h"
+
+// the number of compiled selection strings kept (the cache is emptied when it is exceeded)
+#define MAX_COMPILED_SELECTIONS 200
+// conditions above this number are not cached in a truth table
+#define MAX_TRUTH_TABLE_CONDITIONS 16
 
 namespace MSL { 
 class AtomSelection {
@@ -72,7 +78,50 @@ class AtomSelection {
 	private:
 #ifndef __TESTING__
 		AtomPointerVector& logicalSelect(std::string _selectString, std::string _name, AtomPointerVector & _atoms, bool _selectAllAtoms);
-		LogicalCondition cond;
+		void withinSelect(AtomPointerVector & _sele2atoms, double _radius, AtomPointerVector & _out);
+
+		/***************************************************************
+		 *  Compiled logic: the LogicalCondition asks the same sequence
+		 *  of conditions for every atom, whatever the answers.  A logic
+		 *  string is therefore parsed once into typed conditions (i.e.
+		 *  the list of names of NAME CA+CB) that are evaluated directly
+		 *  on the atom, and the LogicalCondition is consulted only the
+		 *  first time that a combination of answers is found (a truth
+		 *  table).  The compiled logic is kept by string in a cache
+		 *  shared by all the AtomSelection objects, so selecting again
+		 *  (i.e. on another model, with another AtomSelection) does not
+		 *  parse the string again.  The compiled logic does not depend
+		 *  on the atoms (the stored selections are resolved at every
+		 *  selection)
+		 ***************************************************************/
+		enum ConditionType {ALL_CONDITION, NAME_CONDITION, RESI_CONDITION, RESN_CONDITION, CHAIN_CONDITION, HASCRD_CONDITION, SELECTION_CONDITION, BLANK_CONDITION, INVALID_CONDITION};
+		struct CompiledCondition {
+			ConditionType type;
+			std::vector<std::string> values; // names, residue names, chains or the name of the stored selection
+			std::vector<int> rangeStart; // RESI 6-9
+			std::vector<int> rangeEnd;
+			std::vector<std::string> positionIds; // RESI 37 or 37A
+			std::vector<int> resnums; // the positionIds that are plain residue numbers (to match atoms without insertion code)
+			bool hasCoor;
+			unsigned int selectionId; // the stored selection, resolved at every selection
+		};
+		struct CompiledLogic {
+			LogicalCondition logic;
+			std::vector<CompiledCondition> conditions;
+			std::vector<signed char> truthTable; // overall value by the bits of the answers, -1 if not known yet
+		};
+		CompiledLogic * compileLogic(const std::string & _selectString);
+		CompiledCondition compileCondition(const std::vector<std::string> & _tokens) const;
+		bool evaluateCondition(const CompiledCondition & _condition, Atom & _atom) const;
+		bool evaluateLogic(CompiledLogic & _compiled, const std::vector<bool> & _values);
+
+		// owns the compiled logic (a LogicalCondition cannot be copied)
+		struct CompiledLogicCache {
+			std::map<std::string, CompiledLogic*> logic;
+			void clear();
+			~CompiledLogicCache();
+		};
+		static CompiledLogicCache compiledLogic;
 #else
 		LogicalParser lp;
 #endif
@@ -101,9 +150,10 @@ inline void AtomSelection::clearStoredSelection(std::string _name) {
 	if (it != storedSelections.end()){
 		storedSelections.erase(it);
 	}
+	unsigned int id = Atom::findSelectionId(_name);
 	AtomPointerVector::iterator avIt;
 	for (avIt = data->begin();avIt != data->end();avIt++){
-		(*avIt)->clearFlag(_name);
+		(*avIt)->clearFlag(id);
 	}
 }
 inline void AtomSelection::clearStoredSelections() { 
@@ -0,0 +1,136 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "BondGraph.h"
+
+using namespace MSL;
+using namespace std;
+
+BondGraph::BondGraph() {
+	setup();
+}
+
+BondGraph::BondGraph(const AtomPointerVector & _atoms) {
+	setup();
+	build(_atoms);
+}
+
+BondGraph::BondGraph(const BondGraph & _graph) {
+	setup();
+	copy(_graph);
+}
+
+BondGraph::~BondGraph() {
+}
+
+void BondGraph::operator=(const BondGraph & _graph) {
+	copy(_graph);
+}
+
+void BondGraph::setup() {
+	revision = 0;
+	bondStart = vector<unsigned int>(1, 0);
+	partnerStart = vector<unsigned int>(1, 0);
+}
+
+void BondGraph::copy(const BondGraph & _graph) {
+	atoms = _graph.atoms;
+	revision = _graph.revision;
+	bondStart = _graph.bondStart;
+	bondIndex = _graph.bondIndex;
+	partnerStart = _graph.partnerStart;
+	partnerIndex = _graph.partnerIndex;
+	partnerRelationship = _graph.partnerRelationship;
+}
+
+bool BondGraph::isCurrent(const AtomPointerVector & _atoms) const {
+	if (revision != Atom::getBondRevision() || atoms.size() != _atoms.size()) {
+		return false;
+	}
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		if (atoms[i] != _atoms[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void BondGraph::build(const AtomPointerVector & _atoms) {
+	atoms.assign(_atoms.begin(), _atoms.end());
+	revision = Atom::getBondRevision();
+
+	// the index of each atom, sorted by pointer for the lookup of the partners
+	vector<pair<Atom*, unsigned int> > lookup(atoms.size());
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		lookup[i] = pair<Atom*, unsigned int>(atoms[i], i);
+	}
+	sort(lookup.begin(), lookup.end());
+
+	bondStart.assign(1, 0);
+	bondIndex.clear();
+	partnerStart.assign(1, 0);
+	partnerIndex.clear();
+	partnerRelationship.clear();
+
+	vector<pair<unsigned int, unsigned char> > partners;
+	vector<Atom*> related[3];
+	unsigned char relationships[3] = {oneTwo, oneThree, oneFour};
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		related[0] = atoms[i]->getBonds();
+		related[1] = atoms[i]->getOneThreeAtoms();
+		related[2] = atoms[i]->getOneFourAtoms();
+		partners.clear();
+		for (unsigned int r=0; r<3; r++) {
+			for (vector<Atom*>::iterator k=related[r].begin(); k!=related[r].end(); k++) {
+				vector<pair<Atom*, unsigned int> >::iterator found = lower_bound(lookup.begin(), lookup.end(), pair<Atom*, unsigned int>(*k, 0));
+				if (found == lookup.end() || found->first != *k) {
+					// not in the list
+					continue;
+				}
+				partners.push_back(pair<unsigned int, unsigned char>(found->second, relationships[r]));
+			}
+		}
+		sort(partners.begin(), partners.end());
+		for (vector<pair<unsigned int, unsigned char> >::iterator k=partners.begin(); k!=partners.end(); k++) {
+			if (k->second == oneTwo) {
+				bondIndex.push_back(k->first);
+			}
+			if (partnerIndex.size() > partnerStart.back() && partnerIndex.back() == k->first) {
+				// the same partner with multiple relationships
+				partnerRelationship.back() |= k->second;
+			} else {
+				partnerIndex.push_back(k->first);
+				partnerRelationship.push_back(k->second);
+			}
+		}
+		bondStart.push_back(bondIndex.size());
+		partnerStart.push_back(partnerIndex.size());
+	}
+}
+
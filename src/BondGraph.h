@@ -0,0 +1,121 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef BONDGRAPH_H
+#define BONDGRAPH_H
+
+#include <vector>
+#include <algorithm>
+
+#include "AtomPointerVector.h"
+
+namespace MSL { 
+	/*******************************************************************
+	 *  Compact bonded topology of a list of atoms (i.e. all the atoms
+	 *  of a System), over the indeces of the atoms in the list:
+	 *   - the 1-2 partners of each atom in compressed sparse row form
+	 *     (bondStart[i] to bondStart[i+1] in bondIndex)
+	 *   - the 1-2, 1-3 and 1-4 partners of each atom, sorted by index,
+	 *     with a bitmask of the relationships (a pair can be both 1-3
+	 *     and 1-4 in a ring), used as exclusion list by the non-bonded
+	 *     builders
+	 *
+	 *  The graph is a snapshot of the bonds stored in the atoms
+	 *  (Atom::setBoundTo etc).  isCurrent() tells if the atom list is
+	 *  the same and no bond was changed since it was built
+	 *  (Atom::getBondRevision).  Partners that are not in the list
+	 *  are ignored
+	 *******************************************************************/
+	class BondGraph {
+		public:
+			BondGraph();
+			BondGraph(const AtomPointerVector & _atoms);
+			BondGraph(const BondGraph & _graph);
+			~BondGraph();
+
+			void operator=(const BondGraph & _graph);
+
+			enum Relationship { oneTwo = 1, oneThree = 2, oneFour = 4 };
+
+			void build(const AtomPointerVector & _atoms);
+			bool isCurrent(const AtomPointerVector & _atoms) const;
+
+			unsigned int size() const;
+
+			// the 1-2 partners of atom _i
+			unsigned int getNumberOfBonds(unsigned int _i) const;
+			unsigned int getBond(unsigned int _i, unsigned int _n) const;
+
+			// the bitmask of the relationships (oneTwo | oneThree | oneFour) between atoms _i and _j (0 if none)
+			unsigned char getRelationship(unsigned int _i, unsigned int _j) const;
+			bool isBound(unsigned int _i, unsigned int _j) const;
+			bool isOneThree(unsigned int _i, unsigned int _j) const;
+			bool isOneFour(unsigned int _i, unsigned int _j) const;
+
+			// the sorted partners of atom _i (1-2, 1-3 and 1-4) and their relationships
+			unsigned int getNumberOfPartners(unsigned int _i) const;
+			unsigned int getPartner(unsigned int _i, unsigned int _n) const;
+			unsigned char getPartnerRelationship(unsigned int _i, unsigned int _n) const;
+
+		private:
+			void setup();
+			void copy(const BondGraph & _graph);
+
+			std::vector<Atom*> atoms;
+			unsigned int revision;
+
+			std::vector<unsigned int> bondStart;
+			std::vector<unsigned int> bondIndex;
+
+			std::vector<unsigned int> partnerStart;
+			std::vector<unsigned int> partnerIndex;
+			std::vector<unsigned char> partnerRelationship;
+	};
+
+	inline unsigned int BondGraph::size() const { return atoms.size(); }
+	inline unsigned int BondGraph::getNumberOfBonds(unsigned int _i) const { return bondStart[_i+1] - bondStart[_i]; }
+	inline unsigned int BondGraph::getBond(unsigned int _i, unsigned int _n) const { return bondIndex[bondStart[_i] + _n]; }
+	inline unsigned int BondGraph::getNumberOfPartners(unsigned int _i) const { return partnerStart[_i+1] - partnerStart[_i]; }
+	inline unsigned int BondGraph::getPartner(unsigned int _i, unsigned int _n) const { return partnerIndex[partnerStart[_i] + _n]; }
+	inline unsigned char BondGraph::getPartnerRelationship(unsigned int _i, unsigned int _n) const { return partnerRelationship[partnerStart[_i] + _n]; }
+	inline unsigned char BondGraph::getRelationship(unsigned int _i, unsigned int _j) const {
+		std::vector<unsigned int>::const_iterator begin = partnerIndex.begin() + partnerStart[_i];
+		std::vector<unsigned int>::const_iterator end = partnerIndex.begin() + partnerStart[_i+1];
+		std::vector<unsigned int>::const_iterator found = std::lower_bound(begin, end, _j);
+		if (found != end && *found == _j) {
+			return partnerRelationship[found - partnerIndex.begin()];
+		}
+		return 0;
+	}
+	inline bool BondGraph::isBound(unsigned int _i, unsigned int _j) const { return (getRelationship(_i, _j) & oneTwo) != 0; }
+	inline bool BondGraph::isOneThree(unsigned int _i, unsigned int _j) const { return (getRelationship(_i, _j) & oneThree) != 0; }
+	inline bool BondGraph::isOneFour(unsigned int _i, unsigned int _j) const { return (getRelationship(_i, _j) & oneFour) != 0; }
+}
+
+#endif
@@ -92,8 +92,9 @@ void CCD::localSample(AtomPointerVector &_av,int numFragments, int maxDegree){
 			CartesianPoint axis = _av(i+1).getCoor();
 
 		        double angle = rng.getRandomInt(maxDegree);
+			Rotation3 rot = CartesianGeometry::getRotation(angle, axis - _av(i).getCoor());
 			for (uint j=i+2; j < _av.size();j++){
-				t.rotate(_av(j),angle, axis, _av(i).getCoor());
+				t.rotate(_av(j), rot, _av(i).getCoor());
 			}
 
 		
@@ -252,9 +253,11 @@ void CCD::rotateFragment(AtomPointerVector &_av, int _indexOfPivot, double _angl
 	CartesianPoint axisOfRotation = _av(_indexOfPivot+1).getCoor();
 
 	// Transform each atom downstream.
+	// the same rotation for every atom
 	Transforms t;
+	Rotation3 rot = CartesianGeometry::getRotation(_angleOfRotation, axisOfRotation - _av(_indexOfPivot).getCoor());
 	for (uint i = _indexOfPivot+2; i < _av.size();i++){
-		t.rotate(_av(i),_angleOfRotation, axisOfRotation,_av(_indexOfPivot).getCoor());
+		t.rotate(_av(i), rot, _av(_indexOfPivot).getCoor());
 	}
 	
 }
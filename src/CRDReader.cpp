@@ -60,11 +60,17 @@ bool CRDReader::read() {
 	}
 
 	try { 
+		if (!loadContent()) {
+			return false;
+		}
 		string currentResidue = "";
 
 		bool doneWithTitle = false;
-		while (!endOfFileTest()){
-			string line = Reader::getLine();
+		const char * pos = contentBegin;
+		const char * lineStart = NULL;
+		unsigned int length = 0;
+		while (nextLine(pos, lineStart, length)){
+			string line(lineStart, length);
 			if(!doneWithTitle) {
 				if(line.substr(0,1)=="*") {
 					// Skip comments
@@ -105,11 +111,13 @@ bool CRDReader::read() {
 			atoms.back()->setCharge(atom.D_CHARGE);
 		
 		}
+		releaseContent();
 		return true;
 		
 
 	} catch(...){
 		cerr << "ERROR 5623 in CRDReader::read()\n";
+		releaseContent();
 		return false;
 	}
 
@@ -871,7 +871,7 @@ void CartesianGeometry::seedRadians(CartesianPoint & _originCartesianPoint, Cart
 	_angleAtom.setCoor(rcos + _distAtom.getX(), rsin, 0.0);
 }
 
-Matrix CartesianGeometry::getRotationMatrix(double degrees, const CartesianPoint & _axis) {
+Rotation3 CartesianGeometry::getRotation(double degrees, const CartesianPoint & _axis) {
 	double radiants = degrees * M_PI / 180.0;
 	double cosRad = cos(radiants);
 	double sinRad = sin(radiants);
@@ -895,7 +895,7 @@ Matrix CartesianGeometry::getRotationMatrix(double degrees, const CartesianPoint
 	CartesianPoint n = _axis.getUnit();
 
 	// rotation matrix
-	Matrix m(3, 3, 0.0);
+	Rotation3 m;
 	m[0][0] = tRad * n[0] * n[0] + cosRad;
 	m[0][1] = tRad * n[0] * n[1] - sinRad * n[2];
 	m[0][2] = tRad * n[0] * n[2] + sinRad * n[1];
@@ -909,7 +909,7 @@ Matrix CartesianGeometry::getRotationMatrix(double degrees, const CartesianPoint
 	return m;
 }
 
-Matrix CartesianGeometry::getXRotationMatrix(double degrees) {
+Rotation3 CartesianGeometry::getXRotation(double degrees) {
 
 	double radiants = degrees * M_PI / 180;
 	double cosRad = cos(radiants);
@@ -931,8 +931,7 @@ Matrix CartesianGeometry::getXRotationMatrix(double degrees) {
 	}
 
 	// rotation matrix
-	Matrix m(3, 3, 0.0);
-	m[0][0] = 1;
+	Rotation3 m;
 	m[1][1] = cosRad;
 	m[2][2] = cosRad;
 	m[1][2] = -sinRad;
@@ -940,7 +939,7 @@ Matrix CartesianGeometry::getXRotationMatrix(double degrees) {
 	return m;
 
 }
-Matrix CartesianGeometry::getYRotationMatrix(double degrees) {
+Rotation3 CartesianGeometry::getYRotation(double degrees) {
 
 	double radiants = degrees * M_PI / 180;
 	double cosRad = cos(radiants);
@@ -962,16 +961,15 @@ Matrix CartesianGeometry::getYRotationMatrix(double degrees) {
 	}
 
 	// rotation matrix
-	Matrix m(3, 3, 0.0);
+	Rotation3 m;
 	m[0][0] = cosRad;
-	m[1][1] = 1;
 	m[2][2] = cosRad;
 	m[0][2] = sinRad;
 	m[2][0] = -sinRad;
 	return m;
 
 }
-Matrix CartesianGeometry::getZRotationMatrix(double degrees) {
+Rotation3 CartesianGeometry::getZRotation(double degrees) {
 
 	double radiants = degrees * M_PI / 180;
 	double cosRad = cos(radiants);
@@ -993,16 +991,31 @@ Matrix CartesianGeometry::getZRotationMatrix(double degrees) {
 	}
 
 	// rotation matrix
-	Matrix m(3, 3, 0.0);
+	Rotation3 m;
 	m[0][0] = cosRad;
 	m[0][1] = -sinRad;
 	m[1][0] = sinRad;
 	m[1][1] = cosRad;
-	m[2][2] = 1;
 	return m;
 
 }
 
+Matrix CartesianGeometry::getRotationMatrix(double degrees, const CartesianPoint & _axis) {
+	return getRotation(degrees, _axis).toMatrix();
+}
+
+Matrix CartesianGeometry::getXRotationMatrix(double degrees) {
+	return getXRotation(degrees).toMatrix();
+}
+
+Matrix CartesianGeometry::getYRotationMatrix(double degrees) {
+	return getYRotation(degrees).toMatrix();
+}
+
+Matrix CartesianGeometry::getZRotationMatrix(double degrees) {
+	return getZRotation(degrees).toMatrix();
+}
+
 CartesianPoint CartesianGeometry::projection(const CartesianPoint & _p, const CartesianPoint & _axis1, const CartesianPoint & _axis2) {
 	// projection of the point on a line
 	
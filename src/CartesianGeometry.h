@@ -37,6 +37,7 @@ You should have received a copy of the GNU Lesser General Public
 
 #include "CartesianPoint.h"
 #include "Matrix.h"
+#include "Rotation3.h"
 
 namespace MSL {
      namespace CartesianGeometry {
@@ -78,6 +79,11 @@ namespace MSL {
 		Matrix getXRotationMatrix(double degrees);
 		Matrix getYRotationMatrix(double degrees);
 		Matrix getZRotationMatrix(double degrees);
+		// the same rotations as a fixed-size Rotation3
+		Rotation3 getRotation(double degrees, const CartesianPoint & _axis);
+		Rotation3 getXRotation(double degrees);
+		Rotation3 getYRotation(double degrees);
+		Rotation3 getZRotation(double degrees);
 
 		CartesianPoint projection(const CartesianPoint & _p, const CartesianPoint & _axis1, const CartesianPoint & _axis2=CartesianPoint(0.0, 0.0, 0.0)); // projection of the point on a line
 		double distanceFromLine(const CartesianPoint & _p, const CartesianPoint & _axis1, const CartesianPoint & _axis2=CartesianPoint(0.0, 0.0, 0.0)); // projection of the point on a line
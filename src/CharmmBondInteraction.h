@@ -64,6 +64,7 @@ class CharmmBondInteraction: public TwoBodyInteraction {
 		double getEnergy();
 		double getEnergy(double _distance, std::vector<double> *_dd=NULL);
 		double getEnergy(std::vector<double> *_dd);
+		double getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace); // fused, no allocation
 
 		std::vector<double> getEnergyGrad();
 		std::vector<double> getEnergyGrad(Atom& a1, Atom& a2, double Kb, double b0);
@@ -100,6 +101,13 @@ inline double CharmmBondInteraction::getEnergy(std::vector<double> *_dd) {
 	} 
 	return getEnergy();
 }
+inline double CharmmBondInteraction::getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace) {
+	double dd[6];
+	double distance = distanceDerivative(dd);
+	double diff = distance - params[1];
+	addGradient(_gradients, dd, 2*params[0]*(diff));
+	return params[0] * (diff*diff);
+}
 inline std::string CharmmBondInteraction::toString() { 
 	char c [1000]; 
 	sprintf(c, "%s %s %s %9.4f %9.4f %9.4f %20.6f",typeName.c_str(), pAtoms[0]->toString().c_str(), pAtoms[1]->toString().c_str(), params[0], params[1], pAtoms[0]->distance(*pAtoms[1]), getEnergy()); 
@@ -76,7 +76,8 @@ class CharmmDihedralInteraction: public FourBodyInteraction {
 		//unsigned int getType() const;
 		std::string getName() const;
 
-		bool isSelected(std::string _selection1, std::string _selection2) const;
+		bool isSelected(unsigned int _selection1, unsigned int _selection2) const;
+		using Interaction::isSelected;
 		std::pair<double,std::vector<double> > partialDerivative();
 		
 	private:
@@ -148,7 +149,7 @@ inline std::string CharmmDihedralInteraction::toString() {
 }
 //inline unsigned int CharmmDihedralInteraction::getType() const {return type;}
 inline std::string CharmmDihedralInteraction::getName() const {return typeName;}
-inline bool CharmmDihedralInteraction::isSelected(std::string _selection1, std::string _selection2) const {
+inline bool CharmmDihedralInteraction::isSelected(unsigned int _selection1, unsigned int _selection2) const {
 	if ( (pAtoms[1]->getSelectionFlag(_selection1) && pAtoms[2]->getSelectionFlag(_selection2)) || (pAtoms[1]->getSelectionFlag(_selection2) && pAtoms[2]->getSelectionFlag(_selection1)) ) {
 		return true;
 	} else {
@@ -56,9 +56,9 @@ CharmmEEF1Interaction::~CharmmEEF1Interaction() {
 
 
 void CharmmEEF1Interaction::setup(Atom * _pA1, Atom * _pA2, double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j) {
-	pAtoms = vector<Atom*> (2, (Atom*)NULL);
+	pAtoms.assign(2, (Atom*)NULL);
 	setAtoms(*_pA1, *_pA2);	
-	params = vector<double>(8, 0.0);
+	params.assign(8, 0.0);
 	setParams(_V_i, _Gfree_i, _Sigw_i, _rmin_i, _V_j, _Gfree_j, _Sigw_j, _rmin_j);
 	useNonBondCutoffs = false;
 	nonBondCutoffOn = 997;
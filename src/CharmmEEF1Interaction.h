@@ -63,8 +63,9 @@ namespace MSL {
 			std::vector<double> getParams() const;
 			
 			double getEnergy();
-			double getEnergy(double _distance, std::vector<double> *_dd=NULL);// gradient not implemented for EEF1 yet
-			double getEnergy(std::vector<double> *_dd); // gradient not implemented for EEF1 yet - energy computed by this function doesnot apply the switching function even if cutoffs are in place
+			double getEnergy(double _distance, std::vector<double> *_dd=NULL); // used with no cutoffs
+			double getEnergy(std::vector<double> *_dd); // used by minimizer - energy computed by this function doesnot apply the switching function even if cutoffs are in place
+			double getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace); // fused, no allocation
 			std::vector<double> getEnergyGrad();
 			double getEnergy(double _distance, double _groupDistance);
 
@@ -110,18 +111,23 @@ namespace MSL {
 	}
 	inline double CharmmEEF1Interaction::getEnergy(std::vector<double> *_dd){
 		if(_dd != NULL) {
-			std::cerr << "WARNING 12234:  CharmmEEF1Interaction::getEnergy(double _distance, std::vector<double> *_dd) is not implemented to get the gradient" << std::endl;
-			_dd->resize(pAtoms.size() * 2,0.0);
+			// get the gradient
+			double distance = CartesianGeometry::distanceDerivative(pAtoms[0]->getCoor(),pAtoms[1]->getCoor(),_dd);
+			return getEnergy(distance,_dd);
 		}
 		return getEnergy(pAtoms[0]->distance(*pAtoms[1]));
 	}
+	inline double CharmmEEF1Interaction::getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace) {
+		double dd[6];
+		double distance = distanceDerivative(dd);
+		double dEdd = 0.0;
+		double energy = CharmmEnergy::instance()->EEF1EnerAndGrad(distance, params[0], params[1], params[2], params[3], params[4], params[5], params[6], params[7], dEdd);
+		addGradient(_gradients, dd, dEdd);
+		return energy;
+	}
 	inline double CharmmEEF1Interaction::getEnergy(double _distance, std::vector<double> *_dd){
-		if(_dd != NULL) {
-			std::cerr << "WARNING 12234:  CharmmEEF1Interaction::getEnergy(double _distance, std::vector<double> *_dd) is not implemented to get the gradient" << std::endl;
-			_dd->resize(pAtoms.size() * 2,0.0);
-		}
 		// if cutoffs are in force, this function is not the one to call - use CharmmEEF1Interaction::getEnergy(double _distance, double _groupDistance)
-		return CharmmEnergy::instance()->EEF1Ener(_distance, params[0], params[1], params[2], params[3], params[4], params[5], params[6], params[7]); 
+		return CharmmEnergy::instance()->EEF1Ener(_distance, params[0], params[1], params[2], params[3], params[4], params[5], params[6], params[7], _dd); 
 	}
 	inline double CharmmEEF1Interaction::getEnergy(double _distance, double _groupDistance) {
 		// called if there are cutoffs
@@ -137,9 +143,9 @@ namespace MSL {
 		return CharmmEnergy::instance()->EEF1Ener(_distance, params[0], params[1], params[2], params[3], params[4], params[5], params[6], params[7]) * factor;
 	}
 	inline std::vector<double> CharmmEEF1Interaction::getEnergyGrad(){
-		std::cerr << "WARNING 12234:  CharmmEEF1Interaction::getEnergyGrad() is not implemented to get the gradient" << std::endl;
-		std::vector<double> tmp(pAtoms.size() * 3,0.0); 
-		return tmp;
+		std::vector<double> dd;
+		getEnergy(&dd);
+		return dd;
 	}
 	inline std::string CharmmEEF1Interaction::toString() {
 		char c [1000]; 
@@ -58,9 +58,9 @@ CharmmElectrostaticInteraction::~CharmmElectrostaticInteraction() {
 
 void CharmmElectrostaticInteraction::setup(Atom * _pA1, Atom * _pA2, double _dielectricConstant, double _14rescaling, bool _useRdielectric) {
 	//is14 = _is14;
-	pAtoms = vector<Atom*>(2, (Atom*)NULL);
+	pAtoms.assign(2, (Atom*)NULL);
 	setAtoms(*_pA1, *_pA2);	
-	params = vector<double>(2, 1.0);
+	params.assign(2, 1.0);
 	params[0] = _dielectricConstant;
 	params[1] = _14rescaling;
 	useRiel = _useRdielectric;
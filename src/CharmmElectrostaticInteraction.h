@@ -59,9 +59,13 @@ class CharmmElectrostaticInteraction: public TwoBodyInteraction {
 		void setParams(std::vector<double> _params);
 		double getDielectricConstant() const;
 		double getElec14factor() const;
+		// the precomputed Kq * q1 * q2 * rescaling / dielectric
+		double getPrecomputedFactor() const;
+		bool getUseRdielectric() const;
 		
 		double getEnergy(); // wrapper function
 		double getEnergy(std::vector<double> *_dd); // used by minimizer - computes energy without the switching function even if cutoffs are in place
+		double getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace); // fused, no allocation
 		std::vector<double> getEnergyGrad();
 		std::vector<double> getEnergyGrad(Atom& _a1, Atom& _a2, bool _is14=false);
 
@@ -103,6 +107,8 @@ class CharmmElectrostaticInteraction: public TwoBodyInteraction {
 inline void CharmmElectrostaticInteraction::setParams(std::vector<double> _params) { if (_params.size() != 0) {std::cerr << "ERROR 41822: invalid number of parameters in inline void CharmmElectrostaticInteraction::setParams(std::vector<double> _params)" << std::endl; exit(41822);} params = _params;}
 inline double CharmmElectrostaticInteraction::getDielectricConstant() const {return params[0];};
 inline double CharmmElectrostaticInteraction::getElec14factor() const {return params[1];};
+inline double CharmmElectrostaticInteraction::getPrecomputedFactor() const {return Kq_q1_q1_rescal_over_diel;}
+inline bool CharmmElectrostaticInteraction::getUseRdielectric() const {return useRiel;}
 inline double CharmmElectrostaticInteraction::getEnergy() {
 	if (useNonBondCutoffs) {
 		// with cutoffs
@@ -130,6 +136,13 @@ inline double CharmmElectrostaticInteraction::getEnergy() {
 
 	return getEnergy(pAtoms[0]->distance(*pAtoms[1]));
  }
+ inline double CharmmElectrostaticInteraction::getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace) {
+	// without the switching function
+	double dd[6];
+	double distance = distanceDerivative(dd);
+	addGradient(_gradients, dd, CharmmEnergy::instance()->coulombEnerGrad(distance, Kq_q1_q1_rescal_over_diel, useRiel));
+	return getEnergy(distance);
+ }
  inline double CharmmElectrostaticInteraction::getEnergy(double _distance, std::vector<double> *_dd) {
 	double energy = 0.0;
 	if (useRiel) {
@@ -126,6 +126,15 @@ double CharmmEnergy::switchingFunction(double _d, double _rOn, double _rOff) con
 	}
 }
 
+double CharmmEnergy::switchingFunctionGrad(double _d, double _rOn, double _rOff) const {
+	// derivative of SW w.r.t Rij: (6 * (Rij - rOff) * (Rij - rOn)) / (rOff - rOn)^3 between rOn and rOff, zero outside
+	if (_d > _rOff || _d <= _rOn) {
+		return 0.0;
+	}
+	double t3 = (_rOff-_rOn) * (_rOff-_rOn) * (_rOff-_rOn);
+	return 6.0 * (_d - _rOff) * (_d - _rOn) / t3;
+}
+
 //double Energy::coulombEner(double d, double groupD, double q1, double q2, double diel, double cutOnDist, double cutOffDist, double e14fac, bool shift, bool useRdiel, double exponent) {
 // Apply the cutoff outside - calculate the energy alone here
 double CharmmEnergy::coulombEner(double _d, double _q1, double _q2, double _diel, double _rescalingFactor) const {
@@ -302,7 +311,7 @@ void CharmmEnergy::coulombEnerGrad(vector<double>& _dd, double _d, double K1_q1_
 }
 
 
-double CharmmEnergy::EEF1Ener(double _d, double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j) const {
+double CharmmEnergy::EEF1Ener(double _d, double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j, vector<double> *_grad) const {
 
 	/******************************************************
 	 *          2 * Gfree_i                   d - rmin_1
@@ -323,23 +332,14 @@ double CharmmEnergy::EEF1Ener(double _d, double _V_i, double _Gfree_i, double _S
 	 *  Note: Sigw in parameter file is lambda on the paper
 	 *  
 	 ******************************************************/
-	if (_d == 0) {
-		// overlapping atoms, zero energy
-		return 0.0;
-	}
-	double d2 = _d * _d;
-	double fV_i = 0.0;
-	double fV_j = 0.0;
-	
-	if (_Sigw_i != 0.0 && _Gfree_i != 0.0 && _V_j != 0.0) {
-		double x2_i = -pow((_d - _rmin_i) / _Sigw_i, 2.0);
-		fV_i = eef1_constant * _Gfree_i * exp(x2_i) * _V_j / (_Sigw_i * d2);
-	}
-	if (_Sigw_j != 0.0 && _Gfree_j != 0.0 && _V_i != 0.0) {
-		double x2_j = -pow((_d - _rmin_j) / _Sigw_j, 2.0);
-		fV_j = eef1_constant * _Gfree_j * exp(x2_j) * _V_i / (_Sigw_j * d2);
+	double p = 0.0;
+	double energy = EEF1EnerAndGrad(_d, _V_i, _Gfree_i, _Sigw_i, _rmin_i, _V_j, _Gfree_j, _Sigw_j, _rmin_j, p);
+	if (_grad != NULL) {
+		for (int i = 0; i < _grad->size(); i++) {
+			(*_grad)[i] *= p;
+		}
 	}
-	return -fV_i - fV_j;
+	return energy;
 	//cout << "UUU " << _d << ", " <<  _V_i << ", " <<  _Gfree_i << ", " <<  _Sigw_i << ", " <<  _rmin_i << ", " <<  _V_j << ", " <<  _Gfree_j << ", " <<  _Sigw_j << ", " <<  _rmin_j << endl;
 	//cout << "  UUU x2_i " << x2_i << endl;
 	//cout << "  UUU fV_i " << fV_i << endl;
@@ -360,6 +360,37 @@ double CharmmEnergy::EEF1Ener(double _d, double _V_i, double _Gfree_i, double _S
 */
 }
 
+double CharmmEnergy::EEF1EnerAndGrad(double _d, double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j, double & _dEdd) const {
+	if (_d == 0) {
+		// overlapping atoms, zero energy
+		_dEdd = 0.0;
+		return 0.0;
+	}
+	double d2 = _d * _d;
+	double fV_i = 0.0;
+	double fV_j = 0.0;
+
+	/******************************************************
+	 *  Gradient: the derivative of each term by d is
+	 *
+	 *          d fV_i           2 * (d - rmin_i)     2
+	 *          ------ = fV_i (- ---------------- - --- )
+	 *            dd                 Sigw_i^2        d
+	 ******************************************************/
+	_dEdd = 0.0;
+	if (_Sigw_i != 0.0 && _Gfree_i != 0.0 && _V_j != 0.0) {
+		double x2_i = -pow((_d - _rmin_i) / _Sigw_i, 2.0);
+		fV_i = eef1_constant * _Gfree_i * exp(x2_i) * _V_j / (_Sigw_i * d2);
+		_dEdd -= fV_i * (-2.0 * (_d - _rmin_i) / (_Sigw_i * _Sigw_i) - 2.0 / _d);
+	}
+	if (_Sigw_j != 0.0 && _Gfree_j != 0.0 && _V_i != 0.0) {
+		double x2_j = -pow((_d - _rmin_j) / _Sigw_j, 2.0);
+		fV_j = eef1_constant * _Gfree_j * exp(x2_j) * _V_i / (_Sigw_j * d2);
+		_dEdd -= fV_j * (-2.0 * (_d - _rmin_j) / (_Sigw_j * _Sigw_j) - 2.0 / _d);
+	}
+	return -fV_i - fV_j;
+}
+
 
 
 double CharmmEnergy::coulombEnerPrecomputedSwitched(double _d, double _q1_q2_kq_diel_rescal, double _groupDistance, double _nonBondCutoffOn, double _nonBondCutoffOff, bool _Rdep) const {
@@ -421,3 +452,24 @@ double CharmmEnergy::IMM1ZtransFunction(double _Z, double _halfThickness, double
 	double z_n = pow(zRel, _exponent);
 	return z_n / (1 + z_n);
 }
+
+double CharmmEnergy::IMM1ZtransFunctionGrad(double _Z, double _halfThickness, double _exponent) {
+	/*************************************
+	 *  df      n Zrel^(n-1)        dZrel
+	 *  --- = ---------------- * -------
+	 *  dZ    (1 + Zrel^n)^2       dZ
+	 *
+	 *  with dZrel/dZ = sign(Z) / halfThickness
+	 ************************************/
+	double zRel = _Z / _halfThickness;
+	double sign = 1.0;
+	if (zRel < 0.0) {
+		zRel *= -1;
+		sign = -1.0;
+	}
+	if (zRel == 0.0) {
+		return 0.0;
+	}
+	double z_n = pow(zRel, _exponent);
+	return sign * _exponent * z_n / zRel / ((1 + z_n) * (1 + z_n) * _halfThickness);
+}
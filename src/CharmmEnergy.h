@@ -50,6 +50,7 @@ class CharmmEnergy {
 
 		//double switchingFunction(double _d, double _rOn, double _rOff, double* grad = NULL) const;
 		double switchingFunction(double _d, double _rOn, double _rOff) const;
+		double switchingFunctionGrad(double _d, double _rOn, double _rOff) const; // dSW/dRij
 		double spring(double _d, double _Kd, double _d0,std::vector<double> *grad=NULL) ;
 		void springGrad(std::vector<double>& _dd, double _d, double _Kd, double _d0);
 		double coulombEner(double _d, double _q1, double _q2, double _diel, double _rescalingFactor) const; 
@@ -66,8 +67,11 @@ class CharmmEnergy {
 		double dihedralEner(double _chiRadians, double _Kchi, double _n, double _deltaRadians,std::vector<double> *_grad=NULL) const; 	
 		void dihedralEnerGrad(std::vector<double>& _dd, double _chiRadians, double _Kchi, double _n, double _deltaRadians);
 
-		double EEF1Ener(double _d, double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j) const;
+		double EEF1Ener(double _d, double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j, std::vector<double> *_grad=NULL) const;
+		// as EEF1Ener, also returns dE/dd in _dEdd
+		double EEF1EnerAndGrad(double _d, double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j, double & _dEdd) const;
 		double IMM1ZtransFunction(double _Z, double _halfThickness, double _exponent);
+		double IMM1ZtransFunctionGrad(double _Z, double _halfThickness, double _exponent); // df/dZ
 		// For ureyBradley and Angle -- Call spring with angle in Radians and appropriate prameters
 		
 		// parameter settings
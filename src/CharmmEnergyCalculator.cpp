@@ -37,6 +37,29 @@ using namespace std;
 #include "MslOut.h"
 static MslOut MSLOUT("CharmmEnergyCalculator");
 
+// the pair parameters from the dense matrix of the reader (zeros if the types do not have VDW parameters)
+static const double * vdwParamPairOf(const CharmmParameterReader * _parReader, Atom * _a, Atom * _b) {
+	static const double notFound[4] = {0.0, 0.0, 0.0, 0.0};
+	const double * out = _parReader->vdwParamPair(_a->getTypeId(), _b->getTypeId());
+	if (out == NULL) {
+		cerr << "vdwPairParams not found for types " << _a->getType() << " " << _b->getType() << endl;
+		return notFound;
+	}
+	return out;
+}
+
+// the center of the group of each atom, calculated once for the consecutive atoms of the same group
+static void fillGroupCenters(AtomPointerVector & _atoms, vector<CartesianPoint> & _centers) {
+	_centers.resize(_atoms.size());
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		if (i > 0 && _atoms[i]->getParentGroup() != NULL && _atoms[i]->getParentGroup() == _atoms[i-1]->getParentGroup()) {
+			_centers[i] = _centers[i-1];
+		} else {
+			_centers[i] = _atoms[i]->calcGroupGeometricCenter();
+		}
+	}
+}
+
 CharmmEnergyCalculator::CharmmEnergyCalculator(string _charmmParameterFile){
 	storeEneByType  = false;
 	storeEneByGroup = false;
@@ -45,7 +68,6 @@ CharmmEnergyCalculator::CharmmEnergyCalculator(string _charmmParameterFile){
 	parReader->open(_charmmParameterFile);
 	parReader->read();
 	parReader->close();
-	parReader->createVdwParamPairs();
 
 	vdwRescalingFactor = 1.0;
 		
@@ -421,22 +443,23 @@ map<string,double> CharmmEnergyCalculator::calculatePairwiseEnergy(AtomPointerVe
 			// Non-bonded calculations here..
 			pair<double,double> nonBondedE(0.0,0.0);
 			if (_a(i).isBoundTo(&_b(j)) || _a(i).isOneThree(&_b(j))) { continue; }
-			else if (_a(i).isOneFour(&_b(j))) {
+			double groupDistance = nonBondCutoffOn != 0.0 ? _a[i]->groupDistance(*_b[j],stamp) : 0.0;
+			if (_a(i).isOneFour(&_b(j))) {
 
 
 			  // Get pre-computed parameters for these types (better than getting vdwParam for each atom type and doing a sqrt right here)
-			  vector<double> vdwParam = parReader->vdwParamPair(_a[i]->getType(),_b[j]->getType());
+			  const double * vdwParam = vdwParamPairOf(parReader, _a[i], _b[j]);
 			  double Kq_q1_q2_rescal = CharmmEnergy::Kq * _a[i]->getCharge() * _b[j]->getCharge() * elec14factor;
 
-			  nonBondedE = computeVdwElec(_a[i],_b[j],vdwParam[3],vdwParam[2],Kq_q1_q2_rescal,stamp);
+			  nonBondedE = computeVdwElec(_a[i],_b[j],vdwParam[3],vdwParam[2],Kq_q1_q2_rescal,groupDistance);
 			  
 			} else {
 
 			  // Get pre-computed parameters for these types (better than getting vdwParam for each atom type and doing a sqrt right here)
-			  vector<double> vdwParam = parReader->vdwParamPair(_a[i]->getType(),_b[j]->getType());
+			  const double * vdwParam = vdwParamPairOf(parReader, _a[i], _b[j]);
 			  double Kq_q1_q2_rescal = (CharmmEnergy::Kq * _a[i]->getCharge() * _b[j]->getCharge());
 
-			  nonBondedE = computeVdwElec(_a[i],_b[j],vdwParam[1],vdwParam[0],Kq_q1_q2_rescal,stamp);
+			  nonBondedE = computeVdwElec(_a[i],_b[j],vdwParam[1],vdwParam[0],Kq_q1_q2_rescal,groupDistance);
 			}
 			
 			if (collectInteractionsFlag) numberOfInteractionsUsed["CHARMM_VDW"]++;
@@ -462,13 +485,17 @@ map<string,double> CharmmEnergyCalculator::calculatePairwiseNonBondedEnergy(Atom
 
 
 	/**********************************************************************
-	 * the stamp is a random number that is used to recall the center of each atom
-	 * group to avoid to calculate it multiple times (essentially the center is calculated
-	 * the first time a group distance is called and the value is cached and returned directly
-	 * if the groupDistance function is called on the same group with the same stamp
+	 * the centers of the atom groups are calculated once per call and kept
+	 * here instead of in the stamp cache of the AtomGroup, so that nothing
+	 * shared is written and the function can be called from concurrent
+	 * threads on sets that do not move (as the sweeps of the Quench do)
 	 **********************************************************************/
-	RandomNumberGenerator rng;
-	unsigned int stamp = rng.getRandomInt(1000000);
+	vector<CartesianPoint> centersA;
+	vector<CartesianPoint> centersB;
+	if (nonBondCutoffOn != 0.0) {
+		fillGroupCenters(_a, centersA);
+		fillGroupCenters(_b, centersB);
+	}
 
 	/********************************************************************************
 	 *  About the cutoffs:
@@ -516,22 +543,23 @@ map<string,double> CharmmEnergyCalculator::calculatePairwiseNonBondedEnergy(Atom
 			// Non-bonded calculations here..
 			pair<double,double> nonBondedE(0.0,0.0);
 			if (_a(i).isBoundTo(&_b(j)) || _a(i).isOneThree(&_b(j))) { continue; }
-			else if (_a(i).isOneFour(&_b(j))) {
+			double groupDistance = nonBondCutoffOn != 0.0 ? centersA[i].distance(centersB[j]) : 0.0;
+			if (_a(i).isOneFour(&_b(j))) {
 
 
 			  // Get pre-computed parameters for these types (better than getting vdwParam for each atom type and doing a sqrt right here)
-			  vector<double> vdwParam = parReader->vdwParamPair(_a[i]->getType(),_b[j]->getType());
+			  const double * vdwParam = vdwParamPairOf(parReader, _a[i], _b[j]);
 			  double Kq_q1_q2_rescal = CharmmEnergy::Kq * _a[i]->getCharge() * _b[j]->getCharge() * elec14factor;
 
-			  nonBondedE = computeVdwElec(_a[i],_b[j],vdwParam[3],vdwParam[2],Kq_q1_q2_rescal,stamp);
+			  nonBondedE = computeVdwElec(_a[i],_b[j],vdwParam[3],vdwParam[2],Kq_q1_q2_rescal,groupDistance);
 			  
 			} else {
 
 			  // Get pre-computed parameters for these types (better than getting vdwParam for each atom type and doing a sqrt right here)
-			  vector<double> vdwParam = parReader->vdwParamPair(_a[i]->getType(),_b[j]->getType());
+			  const double * vdwParam = vdwParamPairOf(parReader, _a[i], _b[j]);
 			  double Kq_q1_q2_rescal = (CharmmEnergy::Kq * _a[i]->getCharge() * _b[j]->getCharge());
 
-			  nonBondedE = computeVdwElec(_a[i],_b[j],vdwParam[1],vdwParam[0],Kq_q1_q2_rescal,stamp);
+			  nonBondedE = computeVdwElec(_a[i],_b[j],vdwParam[1],vdwParam[0],Kq_q1_q2_rescal,groupDistance);
 			}
 			energies["CHARMM_VDW"]  += nonBondedE.first;
 			energies["CHARMM_ELEC"] += nonBondedE.second;
@@ -719,10 +747,10 @@ void CharmmEnergyCalculator::dumpAtomMap(string _term){
 }
 
 
-pair<double,double> CharmmEnergyCalculator::computeVdwElec(Atom *_a, Atom *_b, double _rmin, double _emin, double _Kq_q1_q2_rescal, int _stamp){
+pair<double,double> CharmmEnergyCalculator::computeVdwElec(Atom *_a, Atom *_b, double _rmin, double _emin, double _Kq_q1_q2_rescal, double _groupDistance){
 
   // Atoms further away than cutoff
-  if (nonBondCutoffOn != 0.0 && _a->groupDistance(*_b,_stamp) > nonBondCutoffOff) {
+  if (nonBondCutoffOn != 0.0 && _groupDistance > nonBondCutoffOff) {
     return pair<double,double>(0.0,0.0);
   }
 
@@ -734,8 +762,8 @@ pair<double,double> CharmmEnergyCalculator::computeVdwElec(Atom *_a, Atom *_b, d
   }
 
   if (nonBondCutoffOn != 0.0){
-    result.first  = CharmmEnergy::instance()->LJSwitched(dist, vdwRescalingFactor*_rmin,_emin, _a->groupDistance(*_b,_stamp),nonBondCutoffOn,nonBondCutoffOff);
-    result.second = CharmmEnergy::instance()->coulombEnerPrecomputedSwitched(dist,Kq_q1_q2_rescal_over_diel, _a->groupDistance(*_b,_stamp),nonBondCutoffOn,nonBondCutoffOff);
+    result.first  = CharmmEnergy::instance()->LJSwitched(dist, vdwRescalingFactor*_rmin,_emin, _groupDistance,nonBondCutoffOn,nonBondCutoffOff);
+    result.second = CharmmEnergy::instance()->coulombEnerPrecomputedSwitched(dist,Kq_q1_q2_rescal_over_diel, _groupDistance,nonBondCutoffOn,nonBondCutoffOff);
   } else {
     result.first  = CharmmEnergy::instance()->LJ(dist, vdwRescalingFactor*_rmin,_emin);
     result.second = CharmmEnergy::instance()->coulombEnerPrecomputed(dist, Kq_q1_q2_rescal_over_diel);
@@ -153,7 +153,7 @@ class CharmmEnergyCalculator {
 		double nonBondCutoffOff;
 
 		bool extractInteractions(EnergySet &_es, string type);
-		pair<double,double> computeVdwElec(Atom *_a, Atom *_b, double _rmin, double _emin, double _Kq_q1_q2_rescal,int _stamp);
+		pair<double,double> computeVdwElec(Atom *_a, Atom *_b, double _rmin, double _emin, double _Kq_q1_q2_rescal, double _groupDistance);
 
 		std::vector<Interaction *> & getEnergyInteractions(Atom *a, Atom *b, std::string _termName);
 
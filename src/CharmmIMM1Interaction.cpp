@@ -86,3 +86,35 @@ void CharmmIMM1Interaction::copy(const CharmmIMM1Interaction & _interaction) {
 	pEEFC = new CharmmEEF1Interaction(*(_interaction.pEEFC));
 }
 
+double CharmmIMM1Interaction::getEnergyAndDerivatives(double * _dd) {
+	/*********************************************************
+	 *  E = f(z1) * Ew(d) + (1 - f(z1)) * Ec(d)
+	 *
+	 *  the derivatives by the coordinates of the two atoms are
+	 *  (f * dEw/dd + (1 - f) * dEc/dd) * dd/dx, plus the term
+	 *  (Ew - Ec) * df/dz1 on the z of the first atom
+	 *********************************************************/
+	if(!pEEFW || !pEEFC) {
+		std::cerr << "ERROR 12345: CharmmIMM1Interaction::getEnergyAndDerivatives() is called without setting up the EEF1 interactions" << std::endl;
+		for (unsigned int i=0; i<6; i++) {
+			_dd[i] = 0.0;
+		}
+		return 0;
+	}
+	double distance = distanceDerivative(_dd);
+	CharmmEnergy * pEnergy = CharmmEnergy::instance();
+	const vector<double> & w = pEEFW->Interaction::getParams();
+	const vector<double> & c = pEEFC->Interaction::getParams();
+	double dEw = 0.0;
+	double dEc = 0.0;
+	double Ew = pEnergy->EEF1EnerAndGrad(distance, w[0], w[1], w[2], w[3], w[4], w[5], w[6], w[7], dEw);
+	double Ec = pEnergy->EEF1EnerAndGrad(distance, c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7], dEc);
+	double z = pAtoms[0]->getZ();
+	double fz = pEnergy->IMM1ZtransFunction(z, params[0], params[1]);
+	double dEdd = fz * dEw + (1 - fz) * dEc;
+	for (unsigned int i=0; i<6; i++) {
+		_dd[i] *= dEdd;
+	}
+	_dd[2] += (Ew - Ec) * pEnergy->IMM1ZtransFunctionGrad(z, params[0], params[1]);
+	return fz * Ew + (1 - fz) * Ec;
+}
@@ -61,8 +61,9 @@ namespace MSL {
 			
 			void setParams(std::vector<double>& _imm1W, std::vector<double>& _imm1C, double _halfThickness, double _exponent);
 			double getEnergy();
-			double getEnergy(double _dummy, std::vector<double> *_dd=NULL);// gradient not implemented for IMM1 yet
-			double getEnergy(std::vector<double> *_dd); // gradient not implemented for IMM1 yet - energy computed by this function doesnot apply the switching function even if cutoffs are in place
+			double getEnergy(double _dummy, std::vector<double> *_dd=NULL); // as getEnergy(std::vector<double>*), the distance is recalculated
+			double getEnergy(std::vector<double> *_dd); // used by minimizer - energy computed by this function doesnot apply the switching function even if cutoffs are in place
+			double getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace); // fused, no allocation
 
 			friend std::ostream & operator<<(std::ostream &_os, CharmmIMM1Interaction & _term) {_os << _term.toString(); return _os;};
 			std::string toString() ;
@@ -70,6 +71,9 @@ namespace MSL {
 			//unsigned int getType() const;
 			std::string getName() const;
 			void setUseNonBondCutoffs(bool _flag, double _ctonnb=0.0, double _ctofnb=0.0);
+			bool getUseNonBondCutoffs() const;
+			double getNonBondCutoffOn() const;
+			double getNonBondCutoffOff() const;
 
 			std::vector<double> getEnergyGrad();
 			std::pair<double,std::vector<double> > partialDerivative();
@@ -79,6 +83,8 @@ namespace MSL {
 			void copy(const CharmmIMM1Interaction & _interaction);
 			void setup(Atom* _pA1, Atom* _pA2);
 			void deletePointers();
+			// energy without switching function and dE/dx1,dE/dy1,dE/dz1,dE/dx2,dE/dy2,dE/dz2 in _dd (6 values)
+			double getEnergyAndDerivatives(double * _dd);
 
 			//static const unsigned int type = 2;
 			static const std::string typeName;
@@ -100,18 +106,22 @@ namespace MSL {
 	}
 	inline double CharmmIMM1Interaction::getEnergy(std::vector<double> *_dd){
 		if(_dd != NULL) {
-			std::cerr << "WARNING 12234:  CharmmIMM1Interaction::getEnergy(double _distance, std::vector<double> *_dd) is not implemented to get the gradient" << std::endl;
-			_dd->resize(pAtoms.size() * 2,0.0);
+			// get the gradient
+			_dd->resize(6);
+			return getEnergyAndDerivatives(&(*_dd)[0]);
 		}
-		return getEnergy();
+		double dd[6];
+		return getEnergyAndDerivatives(dd);
+	}
+	inline double CharmmIMM1Interaction::getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace) {
+		double dd[6];
+		double energy = getEnergyAndDerivatives(dd);
+		addGradient(_gradients, dd, 1.0);
+		return energy;
 	}
 	inline double CharmmIMM1Interaction::getEnergy(double _distance, std::vector<double> *_dd){
-		if(_dd != NULL) {
-			std::cerr << "WARNING 12234:  CharmmIMM1Interaction::getEnergy(double _distance, std::vector<double> *_dd) is not implemented to get the gradient" << std::endl;
-			_dd->resize(pAtoms.size() * 2,0.0);
-		}
-		// if cutoffs are in force, this function is not the one to call - use CharmmIMM1Interaction::getEnergy(double _distance, double _groupDistance)
-		return getEnergy();
+		// if cutoffs are in force, this function is not the one to call - use CharmmIMM1Interaction::getEnergy()
+		return getEnergy(_dd);
 	}
 	inline std::string CharmmIMM1Interaction::toString() {
 		char c [1000]; 
@@ -126,15 +136,18 @@ namespace MSL {
 			pEEFC->setUseNonBondCutoffs(_flag,_ctonnb,_ctofnb);
 		}
 	}
+	inline bool CharmmIMM1Interaction::getUseNonBondCutoffs() const {return pEEFW && pEEFW->getUseNonBondCutoffs();}
+	inline double CharmmIMM1Interaction::getNonBondCutoffOn() const {return pEEFW ? pEEFW->getNonBondCutoffOn() : 0.0;}
+	inline double CharmmIMM1Interaction::getNonBondCutoffOff() const {return pEEFW ? pEEFW->getNonBondCutoffOff() : 0.0;}
 	inline std::pair<double,std::vector<double> > CharmmIMM1Interaction::partialDerivative() {
 		std::pair<double, std::vector<double> > partials;
 		partials.first = CartesianGeometry::distanceDerivative(pAtoms[0]->getCoor(),pAtoms[1]->getCoor(),&(partials.second));
 		return partials;
 	}
 	inline std::vector<double> CharmmIMM1Interaction::getEnergyGrad(){
-		std::cerr << "WARNING 12234:  CharmmIMM1Interaction::getEnergyGrad() is not implemented to get the gradient" << std::endl;
-		std::vector<double> tmp(pAtoms.size() * 3,0.0); 
-		return tmp;
+		std::vector<double> dd;
+		getEnergy(&dd);
+		return dd;
 	}
 }
 #endif
@@ -73,7 +73,8 @@ class CharmmImproperInteraction: public FourBodyInteraction {
 		//unsigned int getType() const;
 		std::string getName() const;
 		
-		bool isSelected(std::string _selection1, std::string _selection2) const;
+		bool isSelected(unsigned int _selection1, unsigned int _selection2) const;
+		using Interaction::isSelected;
 		std::pair<double,std::vector<double> > partialDerivative();
 
 	private:
@@ -106,7 +107,7 @@ inline double CharmmImproperInteraction::getEnergy(double _angleRadians, std::ve
 inline std::string CharmmImproperInteraction::toString() { char c [1000]; sprintf(c, "%s %s %s %s %s %9.4f %9.4f %9.4f %20.6f", typeName.c_str(), pAtoms[0]->toString().c_str(), pAtoms[1]->toString().c_str(), pAtoms[2]->toString().c_str(), pAtoms[3]->toString().c_str(), params[0], params[1],pAtoms[0]->dihedral(*pAtoms[1], *pAtoms[2], *pAtoms[3]) , getEnergy()); return (std::string)c; };
 //inline unsigned int CharmmImproperInteraction::getType() const {return type;}
 inline std::string CharmmImproperInteraction::getName() const {return typeName;}
-inline bool CharmmImproperInteraction::isSelected(std::string _selection1, std::string _selection2) const {
+inline bool CharmmImproperInteraction::isSelected(unsigned int _selection1, unsigned int _selection2) const {
 	if (pAtoms[0]->getSelectionFlag(_selection1) && pAtoms[0]->getSelectionFlag(_selection2)) {
 		return true;
 	} else {
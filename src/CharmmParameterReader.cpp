@@ -35,13 +35,16 @@ using namespace std;
 
 
 CharmmParameterReader::CharmmParameterReader() {
+	setup();
 }
 
 CharmmParameterReader::CharmmParameterReader(const string & _filename) {
+	setup();
 	open(_filename);
 }
 
 CharmmParameterReader::CharmmParameterReader(const CharmmParameterReader & _par) {
+	setup();
 	copy(_par);
 }
 
@@ -52,6 +55,11 @@ void CharmmParameterReader::operator=(const CharmmParameterReader & _par) {
 	copy(_par);
 }
 
+void CharmmParameterReader::setup() {
+	wildcardTypeId = Atom::registerTypeId("X");
+	vdwPairSize = 0;
+}
+
 void CharmmParameterReader::copy(const CharmmParameterReader & _par) {
 	reset();
 	bondParamMap = _par.bondParamMap;
@@ -60,7 +68,10 @@ void CharmmParameterReader::copy(const CharmmParameterReader & _par) {
 	dihedralParamMap = _par.dihedralParamMap;
 	improperParamMap = _par.improperParamMap;
 	vdwParamMap = _par.vdwParamMap;
-	vdwParamPairMap = _par.vdwParamPairMap;
+	nbfixParamMap = _par.nbfixParamMap;
+	vdwPairMatrix = _par.vdwPairMatrix;
+	vdwPairRow = _par.vdwPairRow;
+	vdwPairSize = _par.vdwPairSize;
 }
 
 void CharmmParameterReader::reset() {
@@ -71,53 +82,51 @@ void CharmmParameterReader::reset() {
 	dihedralParamMap.clear();
 	improperParamMap.clear();
 	vdwParamMap.clear();
-	vdwParamPairMap.clear();
+	nbfixParamMap.clear();
+	vdwPairMatrix.clear();
+	vdwPairRow.clear();
+	vdwPairSize = 0;
+}
+
+CharmmParameterReader::TypeKey CharmmParameterReader::typeKey(unsigned int _typeId1, unsigned int _typeId2, unsigned int _typeId3, unsigned int _typeId4) {
+	return TypeKey(pair<unsigned int, unsigned int>(_typeId1, _typeId2), pair<unsigned int, unsigned int>(_typeId3, _typeId4));
 }
 
 void CharmmParameterReader::addBond(string _type1, string _type2, double _Kb, double _B0) {
-	bondParamMap[_type1][_type2].clear();
-	bondParamMap[_type1][_type2].push_back(_Kb);
-	bondParamMap[_type1][_type2].push_back(_B0);
+	unsigned int t1 = Atom::registerTypeId(_type1);
+	unsigned int t2 = Atom::registerTypeId(_type2);
+	vector<double> param(2, 0.0);
+	param[0] = _Kb;
+	param[1] = _B0;
+	bondParamMap[typeKey(t1, t2)] = param;
 	if (_type1 != _type2) {
-		bondParamMap[_type2][_type1].clear();
-		bondParamMap[_type2][_type1].push_back(_Kb);
-		bondParamMap[_type2][_type1].push_back(_B0);
-	//	cout << "bondParamMap["<< _type2 << "][" << _type1 << "]" << bondParamMap[_type2][_type1][0] << bondParamMap[_type2][_type1][1] << endl;
+		bondParamMap[typeKey(t2, t1)] = param;
 	}
-//	cout << "bondParamMap["<< _type1 << "][" << _type2 << "]" << bondParamMap[_type1][_type2][0] << bondParamMap[_type1][_type2][1] << endl;
 }
 
 void CharmmParameterReader::addAngle(string _type1, string _type2, string _type3, double _Ktheta, double _Theta0) {
-	angleParamMap[_type1][_type2][_type3].clear();
-	angleParamMap[_type1][_type2][_type3].push_back(_Ktheta);
-	angleParamMap[_type1][_type2][_type3].push_back(_Theta0);
-	//angleParamMap[_type1][_type2][_type3].push_back(_Kub);
-	//angleParamMap[_type1][_type2][_type3].push_back(_S0);
-	//cerr << "UUU added " << _type1 << " " << _type2 << " " << _type3 << endl;
-
+	unsigned int t1 = Atom::registerTypeId(_type1);
+	unsigned int t2 = Atom::registerTypeId(_type2);
+	unsigned int t3 = Atom::registerTypeId(_type3);
+	vector<double> param(2, 0.0);
+	param[0] = _Ktheta;
+	param[1] = _Theta0;
+	angleParamMap[typeKey(t1, t2, t3)] = param;
 	if(_type1 != _type3) {
-		angleParamMap[_type3][_type2][_type1].clear();
-		angleParamMap[_type3][_type2][_type1].push_back(_Ktheta);
-		angleParamMap[_type3][_type2][_type1].push_back(_Theta0);
-		//angleParamMap[_type3][_type2][_type1].push_back(_Kub);
-		//angleParamMap[_type3][_type2][_type1].push_back(_S0);
-	//	cerr << "UUU added " << _type3 << " " << _type2 << " " << _type1 << endl;
+		angleParamMap[typeKey(t3, t2, t1)] = param;
 	}
 }
 
 void CharmmParameterReader::addUreyBradley(string _type1, string _type2, string _type3, double _Kub, double _S0) {
-	ureyBradleyParamMap[_type1][_type2][_type3].clear();
-	//ureyBradleyParamMap[_type1][_type2][_type3].push_back(_Ktheta);
-	//ureyBradleyParamMap[_type1][_type2][_type3].push_back(_Theta0);
-	ureyBradleyParamMap[_type1][_type2][_type3].push_back(_Kub);
-	ureyBradleyParamMap[_type1][_type2][_type3].push_back(_S0);
-
+	unsigned int t1 = Atom::registerTypeId(_type1);
+	unsigned int t2 = Atom::registerTypeId(_type2);
+	unsigned int t3 = Atom::registerTypeId(_type3);
+	vector<double> param(2, 0.0);
+	param[0] = _Kub;
+	param[1] = _S0;
+	ureyBradleyParamMap[typeKey(t1, t2, t3)] = param;
 	if(_type1 != _type3) {
-		ureyBradleyParamMap[_type3][_type2][_type1].clear();
-		//ureyBradleyParamMap[_type3][_type2][_type1].push_back(_Ktheta);
-		//ureyBradleyParamMap[_type3][_type2][_type1].push_back(_Theta0);
-		ureyBradleyParamMap[_type3][_type2][_type1].push_back(_Kub);
-		ureyBradleyParamMap[_type3][_type2][_type1].push_back(_S0);
+		ureyBradleyParamMap[typeKey(t3, t2, t1)] = param;
 	}
 }
 
@@ -133,32 +142,53 @@ void CharmmParameterReader::addDihedral(string _type1, string _type2, string _ty
 	temp.push_back(_N);
 	temp.push_back(_Delta);
 
-	dihedralParamMap[_type4][_type3][_type2][_type1].push_back(temp);
+	unsigned int t1 = Atom::registerTypeId(_type1);
+	unsigned int t2 = Atom::registerTypeId(_type2);
+	unsigned int t3 = Atom::registerTypeId(_type3);
+	unsigned int t4 = Atom::registerTypeId(_type4);
+	dihedralParamMap[typeKey(t4, t3, t2, t1)].push_back(temp);
 	if(!(_type1 == _type4 && _type2 == _type3 )) {
-	//	cout << "Adding Dihedral Map (" << _type1 << "," << _type2 << "," << _type3 << "," << _type4 << ")" << endl;
-		dihedralParamMap[_type1][_type2][_type3][_type4].push_back(temp);
+		dihedralParamMap[typeKey(t1, t2, t3, t4)].push_back(temp);
 	}
 }
 
 void CharmmParameterReader::addImproper(string _type1, string _type2, string _type3, string _type4, double _Kpsi, double _Psi0) {
 
-	improperParamMap[_type4][_type3][_type2][_type1].clear();
-	improperParamMap[_type4][_type3][_type2][_type1].push_back(_Kpsi);
-	improperParamMap[_type4][_type3][_type2][_type1].push_back(_Psi0);
+	unsigned int t1 = Atom::registerTypeId(_type1);
+	unsigned int t2 = Atom::registerTypeId(_type2);
+	unsigned int t3 = Atom::registerTypeId(_type3);
+	unsigned int t4 = Atom::registerTypeId(_type4);
+	vector<double> param(2, 0.0);
+	param[0] = _Kpsi;
+	param[1] = _Psi0;
+	improperParamMap[typeKey(t4, t3, t2, t1)] = param;
 	if(!(_type1 == _type4 && _type2 == _type3)) {
-	//	cout << "Adding Improper Map (" << _type1 << "," << _type2 << "," << _type3 << "," << _type4 << ")" << endl;
-		improperParamMap[_type1][_type2][_type3][_type4].clear();
-		improperParamMap[_type1][_type2][_type3][_type4].push_back(_Kpsi);
-		improperParamMap[_type1][_type2][_type3][_type4].push_back(_Psi0);
+		improperParamMap[typeKey(t1, t2, t3, t4)] = param;
 	}
 }
 
 void CharmmParameterReader::addVdw(string _type1, double _Eps, double _Rmin, double _Eps14, double _Rmin14) {
-	vdwParamMap[_type1].clear();	
-	vdwParamMap[_type1].push_back(_Eps);	
-	vdwParamMap[_type1].push_back(_Rmin);	
-	vdwParamMap[_type1].push_back(_Eps14);	
-	vdwParamMap[_type1].push_back(_Rmin14);	
+	unsigned int t1 = Atom::registerTypeId(_type1);
+	if (vdwParamMap.size() <= t1) {
+		vdwParamMap.resize(t1 + 1);
+	}
+	vdwParamMap[t1].clear();	
+	vdwParamMap[t1].push_back(_Eps);	
+	vdwParamMap[t1].push_back(_Rmin);	
+	vdwParamMap[t1].push_back(_Eps14);	
+	vdwParamMap[t1].push_back(_Rmin14);	
+}
+
+void CharmmParameterReader::addNBFix(string _type1, string _type2, double _Emin, double _Rmin, double _Emin14, double _Rmin14) {
+	unsigned int t1 = Atom::registerTypeId(_type1);
+	unsigned int t2 = Atom::registerTypeId(_type2);
+	vector<double> param(4, 0.0);
+	param[0] = _Emin;
+	param[1] = _Rmin;
+	param[2] = _Emin14;
+	param[3] = _Rmin14;
+	nbfixParamMap[typeKey(t1, t2)] = param;
+	nbfixParamMap[typeKey(t2, t1)] = param;
 }
 
 
@@ -236,7 +266,6 @@ bool CharmmParameterReader::read() {
 				continue;
 			}
 			if ((*k)[0].substr(0, 5) == "NBFIX") {
-				cerr << "WARNING: NBFIX in parameter file not yet supported!!!" << endl;
 				block = NBfix;
 				continue;
 			}
@@ -300,6 +329,13 @@ bool CharmmParameterReader::read() {
 			} else if (block == HBond) {
 				continue;
 			} else if (block == NBfix) {
+				if ((*k).size() == 4) {
+					addNBFix((*k)[0],(*k)[1],MslTools::toDouble((*k)[2]),MslTools::toDouble((*k)[3]),MslTools::toDouble((*k)[2]),MslTools::toDouble((*k)[3]));
+				} else if ((*k).size() == 6) {
+					addNBFix((*k)[0],(*k)[1],MslTools::toDouble((*k)[2]),MslTools::toDouble((*k)[3]),MslTools::toDouble((*k)[4]),MslTools::toDouble((*k)[5]));
+				} else {
+					cerr << "Wrong number of params in the NBFIX block. Should be 4 or 6 but it is " << (*k).size() << endl;
+				}
 				continue;
 			} else if (block == initialized) {
 				cerr << "block value not set!" << endl;
@@ -316,227 +352,109 @@ bool CharmmParameterReader::read() {
 		exit(8123);
 	}
 
+	// the dense matrix of the VDW pairs (with the NBFIX values)
+	createVdwParamPairs();
+
 	return true;
 }
 
-bool CharmmParameterReader::vdwParam(std::vector<double> & _param, std::string _type) const {
-	
-	map<string,vector<double> >::const_iterator found;
+bool CharmmParameterReader::vdwParam(vector<double> & _param, string _type) const {
+	return vdwParam(_param, Atom::findTypeId(_type));
+}
 
-	//cout << "UUU find >" << _type << "<" << endl;
-	if ((found= vdwParamMap.find(_type)) != vdwParamMap.end()) {
-		_param = found->second;
-	//	cout << "   UUU found" << endl;
+bool CharmmParameterReader::vdwParam(vector<double> & _param, unsigned int _typeId) const {
+	if (_typeId < vdwParamMap.size() && vdwParamMap[_typeId].size() > 0) {
+		_param = vdwParamMap[_typeId];
 		return true;
-		//return(found->second);
-	} else {
-		//vector<double> out(4,0.0);
-		//cerr << "vdwParams not found for type type " << _type << endl;
-		//return(out);
-	//	cout << "   UUU NOT found" << endl;
-		_param = vector<double>(4,0.0);
-		return false;
 	}
+	_param = vector<double>(4,0.0);
+	return false;
 }
 
 bool CharmmParameterReader::bondParam(vector<double> & _param, string _type1, string _type2) const{
-
-	map<string, map<string, vector<double> > >::const_iterator found1;
-	map<string, vector<double> > ::const_iterator found2;
-
-	if ((found1 = bondParamMap.find(_type1)) != bondParamMap.end() && (found2 = (found1->second).find(_type2)) != (found1->second).end()) {
-		_param = found2->second;
-		return true;
-		//return(found2->second);
-	} else {
-		//vector<double> out(2,0.0);
-		//cerr << "bondParams not found for types type (" << _type1 << "," << _type2 << ")" << endl;
-		//return(out);
-		_param = vector<double>(2,0.0);
-		return false;
-	}
-
+	return bondParam(_param, Atom::findTypeId(_type1), Atom::findTypeId(_type2));
 }
 
-
-bool CharmmParameterReader::angleParam(vector<double> & _param, string _type1, string _type2, string _type3) const{
-	_param = vector<double>(2, 0.0);
-	//vector<double> out(4, 0.0);
-	//vector<double> out(2, 0.0);
-	map<string , map<string, map<string, vector<double> >  >  >::const_iterator found1; 
-	map<string, map<string, vector<double> > >::const_iterator found2;
-	map<string, vector<double> >::const_iterator found3;
-
-	if ((found1 = angleParamMap.find(_type1)) != angleParamMap.end() && (found2 = (found1->second).find(_type2)) != (found1->second).end() && (found3 = (found2->second).find(_type3)) != (found2->second).end()) {
-		
-		//Assuming the size of the vector is going to be 4. Dangerous??
-		_param[0] = found3->second[0];
-		_param[1] = found3->second[1];
+bool CharmmParameterReader::bondParam(vector<double> & _param, unsigned int _typeId1, unsigned int _typeId2) const{
+	Hash<TypeKey, vector<double> >::Table::const_iterator found = bondParamMap.find(typeKey(_typeId1, _typeId2));
+	if (found != bondParamMap.end()) {
+		_param = found->second;
 		return true;
-	//	out.push_back(found3->second[0]);
-	//	out.push_back(found3->second[1]);
 	}
-
+	_param = vector<double>(2,0.0);
 	return false;
-
 }
 
+bool CharmmParameterReader::angleParam(vector<double> & _param, string _type1, string _type2, string _type3) const{
+	return angleParam(_param, Atom::findTypeId(_type1), Atom::findTypeId(_type2), Atom::findTypeId(_type3));
+}
 
-bool CharmmParameterReader::ureyBradleyParam(vector<double> & _param, string _type1, string _type2, string _type3) const{
-	//vector<double> out(4, 0.0);
-	//vector<double> out(2, 0.0);
+bool CharmmParameterReader::angleParam(vector<double> & _param, unsigned int _typeId1, unsigned int _typeId2, unsigned int _typeId3) const{
 	_param = vector<double>(2, 0.0);
-	map<string , map<string, map<string, vector<double> >  >  >::const_iterator found1; 
-	map<string, map<string, vector<double> > >::const_iterator found2;
-	map<string, vector<double> >::const_iterator found3;
-
-	if ((found1 = ureyBradleyParamMap.find(_type1)) != ureyBradleyParamMap.end() && (found2 = (found1->second).find(_type2)) != (found1->second).end() && (found3 = (found2->second).find(_type3)) != (found2->second).end()) {
-		
-		//Assuming the size of the vector is going to be 4. Dangerous??
-		_param[0] = found3->second[0];
-		_param[1] = found3->second[1];
+	Hash<TypeKey, vector<double> >::Table::const_iterator found = angleParamMap.find(typeKey(_typeId1, _typeId2, _typeId3));
+	if (found != angleParamMap.end()) {
+		_param[0] = found->second[0];
+		_param[1] = found->second[1];
 		return true;
-	//	out.push_back(found3->second[2]);
-	//	out.push_back(found3->second[3]);
-
-//	} else {
-//		out.push_back(0.0);
-//		out.push_back(0.0);
 	}
 	return false;
 }
 
-/*
-bool CharmmParameterReader::angleAndUreyBradleyParam(vector<double> & _param, string _type1, string _type2, string _type3) const{
-	//vector<double> out(4, 0.0);
-	map<string , map<string, map<string, vector<double> >  >  >::const_iterator found1; 
-	map<string, map<string, vector<double> > >::const_iterator found2;
-	map<string, vector<double> >::const_iterator found3;
+bool CharmmParameterReader::ureyBradleyParam(vector<double> & _param, string _type1, string _type2, string _type3) const{
+	return ureyBradleyParam(_param, Atom::findTypeId(_type1), Atom::findTypeId(_type2), Atom::findTypeId(_type3));
+}
 
-	if ((found1 = angleParamMap.find(_type1)) != angleParamMap.end() && (found2 = (found1->second).find(_type2)) != (found1->second).end() && (found3 = (found2->second).find(_type3)) != (found2->second).end()) {
-		
-		//Assuming the size of the vector is going to be 4. Dangerous??
-		_param = found3->second;
-		//out.push_back(found3->second[0]);
-		//out.push_back(found3->second[1]);
-		//out.push_back(found3->second[2]);
-		//out.push_back(found3->second[3]);
+bool CharmmParameterReader::ureyBradleyParam(vector<double> & _param, unsigned int _typeId1, unsigned int _typeId2, unsigned int _typeId3) const{
+	_param = vector<double>(2, 0.0);
+	Hash<TypeKey, vector<double> >::Table::const_iterator found = ureyBradleyParamMap.find(typeKey(_typeId1, _typeId2, _typeId3));
+	if (found != ureyBradleyParamMap.end()) {
+		_param[0] = found->second[0];
+		_param[1] = found->second[1];
+		return true;
 	}
-	_param = vector<double>(4, 0.0);
 	return false;
-
 }
-*/
 
 bool CharmmParameterReader::dihedralParam(vector<vector<double> > & _param, string _type1, string _type2, string _type3, string _type4) const {
+	return dihedralParam(_param, Atom::findTypeId(_type1), Atom::findTypeId(_type2), Atom::findTypeId(_type3), Atom::findTypeId(_type4));
+}
 
-	
-
-
-	map< string, map<string , map<string, map<string, vector<vector<double> > >  >  >  >::const_iterator found1;
-	map<string , map<string, map<string, vector<vector<double> > >  >  >::const_iterator found2; 
-	map<string, map<string, vector<vector<double> > > >::const_iterator found3;
-	map<string, vector<vector<double>  >  >::const_iterator found4;
+bool CharmmParameterReader::dihedralParam(vector<vector<double> > & _param, unsigned int _typeId1, unsigned int _typeId2, unsigned int _typeId3, unsigned int _typeId4) const {
 
 	// if there are multiple entries charmm uses all of them and sum up the energies
 	// but if there are full entries it ignore "wild-carded" (X) entries
-		
-
-	if ((found1 = dihedralParamMap.find(_type1)) != dihedralParamMap.end() && ( found2 = (found1->second).find(_type2)) != (found1->second).end() && (found3 = (found2->second).find(_type3)) != (found2->second).end() && (found4 = (found3->second).find(_type4)) != (found3->second).end()) {
-
-		//return(found4->second);
-		_param = found4->second;
-		return true;
-
-	} else {
-	
-		//wildcard  3 combinations 1, 2,3, x or x,2,3,4|x
-
-		vector<string> tempType1;
-		tempType1.push_back(_type1);
-		tempType1.push_back("X");
-		tempType1.push_back("X");
-		
-		vector<string> tempType4;
-		tempType4.push_back("X");
-		tempType4.push_back(_type4);
-		tempType4.push_back("X");
-		
-		for ( int j= 0; j < 3 ; j++) {   // Loop over each possible wildcard combination
-			string type1 = tempType1[j];
-			string type4 = tempType4[j]; 
-
-		//	cout << "Checking Dihedral Map for (" << type1 << "," << _type2 << "," << _type3 << "," << type4 << ")" << endl;
-			if ((found1 = dihedralParamMap.find(type1)) != dihedralParamMap.end() && ( found2 = (found1->second).find(_type2)) != (found1->second).end() && (found3 = (found2->second).find(_type3)) != (found2->second).end() && (found4 = (found3->second).find(type4)) != (found3->second).end()) {
-
-				//return(found4->second);
-				_param = found4->second;
-				return true;
-			}
-
+	//wildcard  3 combinations 1, 2,3, x or x,2,3,4|x
+	unsigned int types1[4] = {_typeId1, _typeId1, wildcardTypeId, wildcardTypeId};
+	unsigned int types4[4] = {_typeId4, wildcardTypeId, _typeId4, wildcardTypeId};
+	for (unsigned int j=0; j<4; j++) {   // Loop over the full entry and each possible wildcard combination
+		Hash<TypeKey, vector<vector<double> > >::Table::const_iterator found = dihedralParamMap.find(typeKey(types1[j], _typeId2, _typeId3, types4[j]));
+		if (found != dihedralParamMap.end()) {
+			_param = found->second;
+			return true;
 		}
-		//	vector<double> temp(3,0.0);
-		//	out.push_back(temp);
-			
-		//	cerr << "Dihedral Params Not found for type types (" << _type1 << "," << _type2 << "," << _type3 << "," << _type4 << ")" << endl;
-		//	return(out);
-		_param = vector <vector<double> >(1, vector<double>(3,0.0));
-		return false;
 	}
+	_param = vector <vector<double> >(1, vector<double>(3,0.0));
+	return false;
 }
 
-
 bool CharmmParameterReader::improperParam(vector<double> & _param, string _type1, string _type2, string _type3, string _type4) const{
+	return improperParam(_param, Atom::findTypeId(_type1), Atom::findTypeId(_type2), Atom::findTypeId(_type3), Atom::findTypeId(_type4));
+}
 
-	map< string, map<string , map<string, map<string, vector<double> >  >  >  >::const_iterator found1;
-	map<string , map<string, map<string, vector<double> >  >  >::const_iterator found2; 
-	map<string, map<string, vector<double> > >::const_iterator found3;
-	map<string, vector<double> >::const_iterator found4;
-
-	// if there are multiple entries charmm uses all of them and sum up the energies
-	// but if there are full entries it ignore "wild-carded" (X) entries
-		
-
-	if ((found1 = improperParamMap.find(_type1)) != improperParamMap.end() && ( found2 = (found1->second).find(_type2)) != (found1->second).end() && (found3 = (found2->second).find(_type3)) != (found2->second).end() && (found4 = (found3->second).find(_type4)) != (found3->second).end()) {
-
-		//return(found4->second);
-		_param = found4->second;
-		return true;
-
-	} else {
-	
-		//wildcard  3 combinations 1, 2|x ,3 | x, 4 
-
-		vector<string> tempType2;
-		tempType2.push_back(_type2);
-		tempType2.push_back("X");
-		tempType2.push_back("X");
-		
-		vector<string> tempType3;
-		tempType3.push_back("X");
-		tempType3.push_back(_type3);
-		tempType3.push_back("X");
-		
-		for ( int j= 0; j < 3 ; j++) {   // Loop over each possible wildcard combination
-			string type2 = tempType2[j];
-			string type3 = tempType3[j]; 
-
-		//	cout << "Checking Improper Map for (" << _type1 << "," << type2 << "," << type3 << "," << _type4 << ")" << endl;
-			if ((found1 = improperParamMap.find(_type1)) != improperParamMap.end() && ( found2 = (found1->second).find(type2)) != (found1->second).end() && (found3 = (found2->second).find(type3)) != (found2->second).end() && (found4 = (found3->second).find(_type4)) != (found3->second).end()) {
-
-				//return(found4->second);
-				_param = found4->second;
-				return true;
-			}
+bool CharmmParameterReader::improperParam(vector<double> & _param, unsigned int _typeId1, unsigned int _typeId2, unsigned int _typeId3, unsigned int _typeId4) const{
 
+	//wildcard  3 combinations 1, 2|x ,3 | x, 4 
+	unsigned int types2[4] = {_typeId2, _typeId2, wildcardTypeId, wildcardTypeId};
+	unsigned int types3[4] = {_typeId3, wildcardTypeId, _typeId3, wildcardTypeId};
+	for (unsigned int j=0; j<4; j++) {   // Loop over the full entry and each possible wildcard combination
+		Hash<TypeKey, vector<double> >::Table::const_iterator found = improperParamMap.find(typeKey(_typeId1, types2[j], types3[j], _typeId4));
+		if (found != improperParamMap.end()) {
+			_param = found->second;
+			return true;
 		}
-			
-			//cerr << "Improper Params Not found for type types (" << _type1 << "," << _type2 << "," << _type3 << "," << _type4 << ")" << endl;
-			//vector<double>  out(2,0.0);
-			//return(out);
-		_param = vector<double>(2,0.0);
-		return false;
 	}
+	_param = vector<double>(2,0.0);
+	return false;
 }
 		
 		
@@ -550,55 +468,74 @@ bool CharmmParameterReader::improperParam(vector<double> & _param, string _type1
 
 void CharmmParameterReader::createVdwParamPairs(){
 
-
-	map<string,vector<double> >::iterator it;
-	map<string,vector<double> >::iterator it2;
-	map<string,map<string,vector<double> > >::iterator pairIt;
-	map<string,vector<double> >::iterator pairIt2;
-	for (it = vdwParamMap.begin();it != vdwParamMap.end();it++){
-
-		vector<double> p1 = it->second;
-		vector<double> tmp(4,0.0);
-		for (it2 = it;it2 != vdwParamMap.end();++it2){
-			vector<double> p2 = it2->second;
-
+	/*******************************************************************
+	 *  The types with VDW parameters get a row in a dense matrix, each
+	 *  element has the 4 combined values of the pair of types, replaced
+	 *  by the NBFIX values when the pair has one
+	 *******************************************************************/
+	vdwPairRow = vector<unsigned int>(Atom::getNumberOfTypeIds(), Atom::noTypeId);
+	vector<unsigned int> rowTypes;
+	for (unsigned int t=0; t<vdwParamMap.size(); t++) {
+		if (vdwParamMap[t].size() > 0) {
+			vdwPairRow[t] = rowTypes.size();
+			rowTypes.push_back(t);
+		}
+	}
+	vdwPairSize = rowTypes.size();
+	vdwPairMatrix = vector<double>(vdwPairSize * vdwPairSize * 4, 0.0);
+
+	for (unsigned int i=0; i<vdwPairSize; i++) {
+		const vector<double> & p1 = vdwParamMap[rowTypes[i]];
+		for (unsigned int j=i; j<vdwPairSize; j++) {
+			const vector<double> & p2 = vdwParamMap[rowTypes[j]];
+			double tmp[4];
 			tmp[0] = sqrt( p1[0] * p2[0]);
 			tmp[2] = sqrt( p1[2] * p2[2]);
 			tmp[1] = p1[1] + p2[1];
-
-			//tmp.push_back(p1[3] + p2[3]);
 			tmp[3] = (p1[3] + p2[3]);
 
-
-			//cout << "Adding Pair: "<<it->first<<" "<<it2->first<<" "<<tmp[0]<< " vs [ "<<p1[0]<<", "<<p2[0]<<" ] ----> "<<sqrt( p1[0] * p2[0])<<endl;
-			vdwParamPairMap[it->first][it2->first] = tmp;
+			Hash<TypeKey, vector<double> >::Table::const_iterator found = nbfixParamMap.find(typeKey(rowTypes[i], rowTypes[j]));
+			if (found != nbfixParamMap.end()) {
+				// the NBFIX well depths are negative like those of the NONBONDED block
+				tmp[0] = fabs(found->second[0]);
+				tmp[1] = found->second[1];
+				tmp[2] = fabs(found->second[2]);
+				tmp[3] = found->second[3];
+			}
+			for (unsigned int k=0; k<4; k++) {
+				vdwPairMatrix[(i * vdwPairSize + j) * 4 + k] = tmp[k];
+				vdwPairMatrix[(j * vdwPairSize + i) * 4 + k] = tmp[k];
+			}
 		}
-
 	}
 
-
-}
-vector<double> CharmmParameterReader::vdwParamPair(string _type1, string _type2) const {
-
-	map<string,map<string,vector<double> > >::const_iterator found1;
-	map<string,vector<double> >::const_iterator found2;
-	
-	if ( (found1 = vdwParamPairMap.find(_type1)) != vdwParamPairMap.end()) {
-		
-
-		if ( (found2=found1->second.find(_type2)) != found1->second.end()){
-			return found2->second;
+	for (Hash<TypeKey, vector<double> >::Table::const_iterator k=nbfixParamMap.begin(); k!=nbfixParamMap.end(); k++) {
+		unsigned int t1 = k->first.first.first;
+		unsigned int t2 = k->first.first.second;
+		if (t1 <= t2 && (vdwPairRow[t1] == Atom::noTypeId || vdwPairRow[t2] == Atom::noTypeId)) {
+			cerr << "WARNING 8128: NBFIX for types " << Atom::getTypeName(t1) << ", " << Atom::getTypeName(t2) << " ignored, VDW parameters not found in void CharmmParameterReader::createVdwParamPairs()" << endl;
 		}
 	}
-		
-	if ( (found1 = vdwParamPairMap.find(_type2)) != vdwParamPairMap.end()){
-			
-		if ( (found2 = found1->second.find(_type1)) != found1->second.end()){
-			return found2->second;
-		}
+}
 
+const double * CharmmParameterReader::vdwParamPair(unsigned int _typeId1, unsigned int _typeId2) const {
+	if (_typeId1 >= vdwPairRow.size() || _typeId2 >= vdwPairRow.size()) {
+		return NULL;
 	}
+	unsigned int row1 = vdwPairRow[_typeId1];
+	unsigned int row2 = vdwPairRow[_typeId2];
+	if (row1 == Atom::noTypeId || row2 == Atom::noTypeId) {
+		return NULL;
+	}
+	return &vdwPairMatrix[(row1 * vdwPairSize + row2) * 4];
+}
 
+vector<double> CharmmParameterReader::vdwParamPair(string _type1, string _type2) const {
+
+	const double * pPair = vdwParamPair(Atom::findTypeId(_type1), Atom::findTypeId(_type2));
+	if (pPair != NULL) {
+		return vector<double>(pPair, pPair + 4);
+	}
 
 	vector<double> out(4,0.0);
 	cerr << "vdwPairParams not found for types " << _type1 << " "<<_type2<<endl;
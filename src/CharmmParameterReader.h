@@ -39,6 +39,8 @@ You should have received a copy of the GNU Lesser General Public
 //MSL Includes
 #include "Reader.h"
 #include "MslTools.h"
+#include "Atom.h"
+#include "Hash.h"
 
 
 namespace MSL { 
@@ -59,35 +61,53 @@ class CharmmParameterReader : public Reader {
 */
 		void reset();
 
+		/*******************************************************************
+		 *  The atom types are interned at read time (see Atom::registerTypeId)
+		 *  and the parameters are stored by type id: each function exists
+		 *  with the type names and with the type ids (Atom::getTypeId()),
+		 *  which avoid any string lookup
+		 *******************************************************************/
+
 		//VdwParam will return a std::vector with 4 values (Eps,Rmin,Esp14,Rmin14)
 		bool vdwParam(std::vector<double> & _param, std::string _type) const;
+		bool vdwParam(std::vector<double> & _param, unsigned int _typeId) const;
 
 
 		/*******************************************************************
 		 *  VdwParam will return a std::vector with 4 values 
 		 * (sqrt(Eps1*Eps2),Rmin1+Rmin2,sqrt(Esp14_1+Eps14_2),Rmin14_1+Rmin14_2)
-		 * NOTE: note created automatically, need to call createVdwParamPairs() first
+		 *  or the values given in the NBFIX block for the pair.
+		 *  The pairs are stored in a dense matrix of the types that have
+		 *  VDW parameters, built at the end of read() (createVdwParamPairs()
+		 *  rebuilds it)
 		 *******************************************************************/
 		std::vector<double> vdwParamPair(std::string type1, std::string type2) const;
+		// returns a pointer to the 4 values, NULL if either type does not have VDW parameters
+		const double * vdwParamPair(unsigned int _typeId1, unsigned int _typeId2) const;
 		void createVdwParamPairs();
 
 		//bondparam will return a std::vector with 2 values Kb and B0
 		bool bondParam(std::vector<double> & _param, std::string type1, std::string type2) const;
+		bool bondParam(std::vector<double> & _param, unsigned int _typeId1, unsigned int _typeId2) const;
 	
 		//Angle params will return a std::vector with 2 values (Ktheta, Theta0)
 		bool angleParam(std::vector<double> & _param, std::string type1, std::string type2, std::string type3) const;
+		bool angleParam(std::vector<double> & _param, unsigned int _typeId1, unsigned int _typeId2, unsigned int _typeId3) const;
 
 		//Ureybradley param will return a std::vector with 2 values (Kub, S0)
 		bool ureyBradleyParam(std::vector<double> & _param, std::string type1, std::string type2, std::string type3) const;
+		bool ureyBradleyParam(std::vector<double> & _param, unsigned int _typeId1, unsigned int _typeId2, unsigned int _typeId3) const;
 
 		//Combined angle and ureybradley param will return a std::vector with 4 values (Ktheta, Theta0, Kub, S0)
 		//bool angleAndUreyBradleyParam(std::vector<double> & _param, std::string type1, std::string type2, std::string type3) const;
 
 		//Dihedral Params will return a std::vector of vectors with 3 values each(Kchi, N, Delta). The std::vector is for each line in the Dihedral block which contains a match for these four types
 		bool dihedralParam(std::vector<std::vector<double> > & _param, std::string type1, std::string type2, std::string type3, std::string type4) const;
+		bool dihedralParam(std::vector<std::vector<double> > & _param, unsigned int _typeId1, unsigned int _typeId2, unsigned int _typeId3, unsigned int _typeId4) const;
 		
 		//Improper Params will return a std::vector with 2 values (Kpsi,Psi0) 
 		bool improperParam(std::vector<double> & _param, std::string type1, std::string type2, std::string type3, std::string type4) const;
+		bool improperParam(std::vector<double> & _param, unsigned int _typeId1, unsigned int _typeId2, unsigned int _typeId3, unsigned int _typeId4) const;
 
 		/*
 		//To be implemented
@@ -104,31 +124,42 @@ class CharmmParameterReader : public Reader {
 		void addDihedral(std::string type1, std::string type2, std::string type3, std::string type4, double kchi, double N, double Delta);
 		void addImproper(std::string type1, std::string type2, std::string type3, std::string type4, double Kpsi, double Psi0);
 		void addVdw(std::string type1, double Eps, double Rmin, double Esp14, double Rmin14);
+		void addNBFix(std::string type1, std::string type2, double Emin, double Rmin, double Emin14, double Rmin14);
 		//void addEEF1(std::string typeType, std::string solvent, double V, double Gref, double Gfree, double Href, double CPref, double Sigw);
 		
 		void setup();
 		void copy(const CharmmParameterReader & _par);
+
+		// the key of the bonded terms, a tuple of type ids (unused positions are 0)
+		typedef std::pair<std::pair<unsigned int, unsigned int>, std::pair<unsigned int, unsigned int> > TypeKey;
+		static TypeKey typeKey(unsigned int _typeId1, unsigned int _typeId2, unsigned int _typeId3=0, unsigned int _typeId4=0);
 		
 		//Bond params will contain a std::vector with 2 values Kb and B0
-		std::map<std::string, std::map<std::string, std::vector<double> > > bondParamMap;
+		Hash<TypeKey, std::vector<double> >::Table bondParamMap;
 		
-		//Angle params will contain a std::vector with 4 values (Ktheta, Theta0, Kub, S0)
-		std::map<std::string , std::map<std::string, std::map<std::string, std::vector<double> >  >  > angleParamMap;
+		//Angle params will contain a std::vector with 2 values (Ktheta, Theta0)
+		Hash<TypeKey, std::vector<double> >::Table angleParamMap;
 		
 		//Urey Bradley params will contain a std::vector with 2 values (Kub, S0)
-		std::map<std::string , std::map<std::string, std::map<std::string, std::vector<double> >  >  > ureyBradleyParamMap;
+		Hash<TypeKey, std::vector<double> >::Table ureyBradleyParamMap;
 
 		//Dihedral Params will contain a std::vector of vectors with 3 values each(Kchi, N, Delta). The std::vector is for each line in the Dihedral block which contains a match for these four types
-		std::map< std::string, std::map<std::string , std::map<std::string, std::map<std::string, std::vector<std::vector<double> > >  >  >  > dihedralParamMap;
-		
+		Hash<TypeKey, std::vector<std::vector<double> > >::Table dihedralParamMap;
 
 		//Improper Params will contain a std::vector with 2 values (Kpsi,Psi0) 
-		std::map< std::string, std::map<std::string , std::map<std::string, std::map<std::string, std::vector<double> >  >  >  > improperParamMap;
+		Hash<TypeKey, std::vector<double> >::Table improperParamMap;
 		
-		//VdwParams will contain a std::vector with 4 values (Eps,Rmin,Esp14,Rmin14)
-		std::map<std::string,std::vector<double> > vdwParamMap;
-		std::map<std::string,std::map<std::string, std::vector<double> > > vdwParamPairMap;
+		//VdwParams will contain a std::vector with 4 values (Eps,Rmin,Esp14,Rmin14), by type id (empty if not given)
+		std::vector<std::vector<double> > vdwParamMap;
+		//NBFIX pairs will contain a std::vector with 4 values (Emin,Rmin,Emin14,Rmin14)
+		Hash<TypeKey, std::vector<double> >::Table nbfixParamMap;
+
+		// dense matrix of the VDW pairs: 4 values for each pair of rows; the row of a type id is in vdwPairRow
+		std::vector<double> vdwPairMatrix;
+		std::vector<unsigned int> vdwPairRow; // Atom::noTypeId if the type has no VDW parameters
+		unsigned int vdwPairSize;
 
+		unsigned int wildcardTypeId; // the id of the X type
 };
 
 }
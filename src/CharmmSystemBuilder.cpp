@@ -89,6 +89,7 @@ void CharmmSystemBuilder::setup() {
 	halfThickness = 15;
 	exponent = 10;
 	solvent = pEEF1ParReader->getDefaultSolvent();
+	numberOfThreads = 1;
 }
 
 void CharmmSystemBuilder::copy(const CharmmSystemBuilder & _sysBuild) {
@@ -102,6 +103,7 @@ void CharmmSystemBuilder::copy(const CharmmSystemBuilder & _sysBuild) {
 	dielectricConstant = _sysBuild.dielectricConstant;
 	useRdielectric = _sysBuild.useRdielectric;
 	termsToBuild = _sysBuild.termsToBuild;
+	numberOfThreads = _sysBuild.numberOfThreads;
 }
 
 void CharmmSystemBuilder::deletePointers() {
@@ -533,14 +535,14 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 										if(improperFlag) {
 											if(*atmK) {
 												vector<double> param;
-												if (pParReader->bondParam(param, (*atmK)->getType(),(*atmM)->getType())) {
+												if (pParReader->bondParam(param, (*atmK)->getTypeId(),(*atmM)->getTypeId())) {
 													icValues[0] = param[1];
 												}
 											}
 										} else {
 											if(*atmK) {
 												vector<double> param;
-												if (pParReader->bondParam(param, (*atmK)->getType(),(*atmL)->getType())) {
+												if (pParReader->bondParam(param, (*atmK)->getTypeId(),(*atmL)->getTypeId())) {
 													icValues[0] = param[1];
 												}
 											}
@@ -551,14 +553,14 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 										if(improperFlag) {
 											if(*atmK) {
 												vector<double> param;
-												if (pParReader->angleParam(param, (*atmK)->getType(),(*atmM)->getType(),(*atmL)->getType())) {
+												if (pParReader->angleParam(param, (*atmK)->getTypeId(),(*atmM)->getTypeId(),(*atmL)->getTypeId())) {
 													icValues[1] = param[1];
 												}
 											}
 										} else {
 											if(*atmK) {
 												vector<double> param;
-												if (pParReader->angleParam(param, (*atmK)->getType(),(*atmL)->getType(),(*atmM)->getType())) {
+												if (pParReader->angleParam(param, (*atmK)->getTypeId(),(*atmL)->getTypeId(),(*atmM)->getTypeId())) {
 													icValues[1] = param[1];
 												}
 											}
@@ -568,7 +570,7 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 									if (icValues[3] == 0.0) {
 										if(*atmN) {
 											vector<double> param;
-											if (pParReader->angleParam(param, (*atmL)->getType(),(*atmM)->getType(),(*atmN)->getType())) {
+											if (pParReader->angleParam(param, (*atmL)->getTypeId(),(*atmM)->getTypeId(),(*atmN)->getTypeId())) {
 												icValues[3] = param[1];
 											}
 										}
@@ -577,7 +579,7 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 									if (icValues[4] == 0.0) {
 										if(*atmN) {
 											vector<double> param;
-											if (pParReader->bondParam(param, (*atmM)->getType(),(*atmN)->getType())) {
+											if (pParReader->bondParam(param, (*atmM)->getTypeId(),(*atmN)->getTypeId())) {
 												icValues[4] = param[1];
 											}
 										}
@@ -664,16 +666,16 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 						// found a new atom in this bonded term
 						foundIdentityAtom = true;
 					}
-					string type1 = (*a1)->getType();
+					const string & type1 = (*a1)->getType();
 					for(vector<Atom*>::iterator a2 = pAtom2.begin() ; a2 != pAtom2.end(); a2++) {
 						if (!foundIdentityAtom && newAtomsLookupMap.find(*a2) == newAtomsLookupMap.end()) {
 							// no atom is a new atom, do not add this bonded term
 							continue;
 						}
-						string type2 = (*a2)->getType();
+						const string & type2 = (*a2)->getType();
 						(*a1)->setBoundTo(*a2);
 						vector<double> params;
-						if (pParReader->bondParam(params, type1, type2)) {
+						if (pParReader->bondParam(params, (*a1)->getTypeId(), (*a2)->getTypeId())) {
 							if (termsToBuild["CHARMM_BOND"]) {
 								CharmmBondInteraction *pCBI = new CharmmBondInteraction(*(*a1),*(*a2),params[0],params[1]);
 								ESet->addInteraction(pCBI);
@@ -726,28 +728,28 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 							// found a new atom in this bonded term
 							foundIdentityAtom = true;
 						}
-						string type1 = (*a1)->getType();
+						const string & type1 = (*a1)->getType();
 						for(vector<Atom*>::iterator a2 = pAtom2.begin() ; a2 != pAtom2.end(); a2++) {
 							if (!foundIdentityAtom && newAtomsLookupMap.find(*a2) != newAtomsLookupMap.end()) {
 								// found a new atom in this bonded term
 								foundIdentityAtom = true;
 							}
-							string type2 = (*a2)->getType();
+							const string & type2 = (*a2)->getType();
 							for(vector<Atom*>::iterator a3 = pAtom3.begin() ; a3 != pAtom3.end(); a3++) {
 								if (!foundIdentityAtom && newAtomsLookupMap.find(*a3) == newAtomsLookupMap.end()) {
 									// no atom is a new atom, do not add this bonded term
 									continue;
 								}
-								string type3 = (*a3)->getType();
+								const string & type3 = (*a3)->getType();
 								//vector<double> params = pParReader->ureyBradleyParam(type1, type2, type3);
 								vector<double> params;
-								if (pParReader->ureyBradleyParam(params, type1, type2, type3)) {
+								if (pParReader->ureyBradleyParam(params, (*a1)->getTypeId(), (*a2)->getTypeId(), (*a3)->getTypeId())) {
 									if (termsToBuild["CHARMM_U-BR"]) {
 										CharmmUreyBradleyInteraction *pCUI = new CharmmUreyBradleyInteraction(*(*a1),*(*a3),params[0],params[1]);
 										ESet->addInteraction(pCUI);
 									}
 								}
-								if (pParReader->angleParam(params, type1, type2, type3)) {
+								if (pParReader->angleParam(params, (*a1)->getTypeId(), (*a2)->getTypeId(), (*a3)->getTypeId())) {
 									if (termsToBuild["CHARMM_ANGL"]) {
 										CharmmAngleInteraction *pCAI = new CharmmAngleInteraction(*(*a1),*(*a2),*(*a3),params[0],params[1] * M_PI / 180.0); 
 										ESet->addInteraction(pCAI);
@@ -803,28 +805,28 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 							// found a new atom in this bonded term
 							foundIdentityAtom = true;
 						}
-						string type1 = (*a1)->getType();
+						const string & type1 = (*a1)->getType();
 						for(vector<Atom*>::iterator a2 = pAtom2.begin() ; a2 != pAtom2.end(); a2++) {
 							if (!foundIdentityAtom && newAtomsLookupMap.find(*a2) != newAtomsLookupMap.end()) {
 								// found a new atom in this bonded term
 								foundIdentityAtom = true;
 							}
-							string type2 = (*a2)->getType();
+							const string & type2 = (*a2)->getType();
 							for(vector<Atom*>::iterator a3 = pAtom3.begin() ; a3 != pAtom3.end(); a3++) {
 								if (!foundIdentityAtom && newAtomsLookupMap.find(*a3) != newAtomsLookupMap.end()) {
 									// found a new atom in this bonded term
 									foundIdentityAtom = true;
 								}
-								string type3 = (*a3)->getType();
+								const string & type3 = (*a3)->getType();
 								for(vector<Atom*>::iterator a4 = pAtom4.begin() ; a4 != pAtom4.end(); a4++) {
 									if (!foundIdentityAtom && newAtomsLookupMap.find(*a4) == newAtomsLookupMap.end()) {
 										// no atom is a new atom, do not add this bonded term
 										continue;
 									}
-									string type4 = (*a4)->getType();
+									const string & type4 = (*a4)->getType();
 
 									vector<vector <double> > dihedralEntries;
-									if (pParReader->dihedralParam(dihedralEntries, type1, type2, type3, type4)) {
+									if (pParReader->dihedralParam(dihedralEntries, (*a1)->getTypeId(), (*a2)->getTypeId(), (*a3)->getTypeId(), (*a4)->getTypeId())) {
 										// there could be multiple entries for a single dihedral
 										for(int m = 0; m < dihedralEntries.size() ; m++) {
 											// the delta should be expressed in radians
@@ -885,28 +887,28 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 						// found a new atom in this bonded term
 						foundIdentityAtom = true;
 					}
-					string type1 = (*a1)->getType();
+					const string & type1 = (*a1)->getType();
 					for(vector<Atom*>::iterator a2 = pAtom2.begin() ; a2 != pAtom2.end(); a2++) {
 						if (!foundIdentityAtom && newAtomsLookupMap.find(*a2) != newAtomsLookupMap.end()) {
 							// found a new atom in this bonded term
 							foundIdentityAtom = true;
 						}
-						string type2 = (*a2)->getType();
+						const string & type2 = (*a2)->getType();
 						for(vector<Atom*>::iterator a3 = pAtom3.begin() ; a3 != pAtom3.end(); a3++) {
 							if (!foundIdentityAtom && newAtomsLookupMap.find(*a3) != newAtomsLookupMap.end()) {
 								// found a new atom in this bonded term
 								foundIdentityAtom = true;
 							}
-							string type3 = (*a3)->getType();
+							const string & type3 = (*a3)->getType();
 							for(vector<Atom*>::iterator a4 = pAtom4.begin() ; a4 != pAtom4.end(); a4++) {
 								if (!foundIdentityAtom && newAtomsLookupMap.find(*a4) == newAtomsLookupMap.end()) {
 									// no atom is a new atom, do not add this bonded term
 									continue;
 								}
-								string type4 = (*a4)->getType();
+								const string & type4 = (*a4)->getType();
 								//vector<double> improperParams = pParReader->improperParam(type1, type2, type3, type4);	
 								vector<double> improperParams;
-								if (pParReader->improperParam(improperParams, type1, type2, type3, type4)) {
+								if (pParReader->improperParam(improperParams, (*a1)->getTypeId(), (*a2)->getTypeId(), (*a3)->getTypeId(), (*a4)->getTypeId())) {
 									if (termsToBuild["CHARMM_IMPR"]) {
 										CharmmImproperInteraction *pCII = new CharmmImproperInteraction(*(*a1),*(*a2),*(*a3),*(*a4),improperParams[0],improperParams[1]*M_PI/180.0);
 										ESet->addInteraction(pCII);
@@ -936,7 +938,7 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 				foundIdentityAtom = true;
 			}
 
-			string atomItype = (*atomI)->getType();
+			const string & atomItype = (*atomI)->getType();
 
 			for(AtomPointerVector::iterator atomJ = atomI+1; atomJ < atoms.end() ; atomJ++) {
 				if ((*atomI)->isInAlternativeIdentity(*atomJ)) {
@@ -945,7 +947,7 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 				if (!foundIdentityAtom && newAtomsLookupMap.find(*atomJ) != newAtomsLookupMap.end()) {
 					foundIdentityAtom = true;
 				}
-				string atomJtype = (*atomJ)->getType();
+				const string & atomJtype = (*atomJ)->getType();
 				if (pTopReader->getAutoGenerateAngles() && (*atomI)->isOneThree(*atomJ)) {
 					/*******************************************************
 					 *  Add the bond term only if at least one of the 3 atoms
@@ -957,15 +959,15 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 					for (vector<Atom*>::iterator k=middle.begin(); k!=middle.end(); k++) {
 						if (foundIdentityAtom || newAtomsLookupMap.find(*k) != newAtomsLookupMap.end()) {
 							// this angle includes at least one atom in the new residue
-							string middleType = (*k)->getType();
+							const string & middleType = (*k)->getType();
 							vector<double> params;
-							if (pParReader->ureyBradleyParam(params, atomItype, middleType, atomJtype)) {
+							if (pParReader->ureyBradleyParam(params, (*atomI)->getTypeId(), (*k)->getTypeId(), (*atomJ)->getTypeId())) {
 								if (termsToBuild["CHARMM_U-BR"]) {
 									CharmmUreyBradleyInteraction *pCUI = new CharmmUreyBradleyInteraction(*(*atomI),*(*atomJ),params[0],params[1]);
 									ESet->addInteraction(pCUI);
 								}
 							}
-							if (pParReader->angleParam(params, atomItype, middleType, atomJtype)) {
+							if (pParReader->angleParam(params, (*atomI)->getTypeId(), (*k)->getTypeId(), (*atomJ)->getTypeId())) {
 								if (termsToBuild["CHARMM_ANGL"]) {
 									CharmmAngleInteraction *pCAI = new CharmmAngleInteraction(*(*atomI),*(*k),*(*atomJ),params[0],params[1] * M_PI / 180.0); 
 									ESet->addInteraction(pCAI);
@@ -989,7 +991,7 @@ bool CharmmSystemBuilder::addIdentity(Position & _pos, const vector<string> & _r
 						if (foundIdentityAtom || newAtomsLookupMap.find(middleAtoms[0]) != newAtomsLookupMap.end() || newAtomsLookupMap.find(middleAtoms[1]) != newAtomsLookupMap.end()) {
 							// this dihedral includes at least one atom in the new residue
 							vector<vector <double> > dihedralEntries;
-							if (pParReader->dihedralParam(dihedralEntries, atomItype, middleTypes[0], middleTypes[1], atomJtype)) {
+							if (pParReader->dihedralParam(dihedralEntries, (*atomI)->getTypeId(), middleAtoms[0]->getTypeId(), middleAtoms[1]->getTypeId(), (*atomJ)->getTypeId())) {
 								// there could be multiple entries for a single dihedral
 								for(int m = 0; m < dihedralEntries.size() ; m++) {
 									// the delta should be expressed in radians
@@ -1238,14 +1240,14 @@ bool CharmmSystemBuilder::buildSystem(const PolymerSequence & _sequence) {
 											if(improperFlag) {
 												if(*atmK) {
 													vector<double> param;
-													if (pParReader->bondParam(param, (*atmK)->getType(),(*atmM)->getType())) {
+													if (pParReader->bondParam(param, (*atmK)->getTypeId(),(*atmM)->getTypeId())) {
 														icValues[0] = param[1];
 													}
 												}
 											} else {
 												if(*atmK) {
 													vector<double> param;
-													if (pParReader->bondParam(param, (*atmK)->getType(),(*atmL)->getType())) {
+													if (pParReader->bondParam(param, (*atmK)->getTypeId(),(*atmL)->getTypeId())) {
 														icValues[0] = param[1];
 													}
 												}
@@ -1256,14 +1258,14 @@ bool CharmmSystemBuilder::buildSystem(const PolymerSequence & _sequence) {
 											if(improperFlag) {
 												if(*atmK) {
 													vector<double> param;
-													if (pParReader->angleParam(param, (*atmK)->getType(),(*atmM)->getType(),(*atmL)->getType())) {
+													if (pParReader->angleParam(param, (*atmK)->getTypeId(),(*atmM)->getTypeId(),(*atmL)->getTypeId())) {
 														icValues[1] = param[1];
 													}
 												}
 											} else {
 												if(*atmK) {
 													vector<double> param;
-													if (pParReader->angleParam(param, (*atmK)->getType(),(*atmL)->getType(),(*atmM)->getType())) {
+													if (pParReader->angleParam(param, (*atmK)->getTypeId(),(*atmL)->getTypeId(),(*atmM)->getTypeId())) {
 														icValues[1] = param[1];
 													}
 												}
@@ -1273,7 +1275,7 @@ bool CharmmSystemBuilder::buildSystem(const PolymerSequence & _sequence) {
 										if (icValues[3] == 0.0) {
 											if(*atmN) {
 												vector<double> param;
-												if (pParReader->angleParam(param, (*atmL)->getType(),(*atmM)->getType(),(*atmN)->getType())) {
+												if (pParReader->angleParam(param, (*atmL)->getTypeId(),(*atmM)->getTypeId(),(*atmN)->getTypeId())) {
 													icValues[3] = param[1];
 												}
 											}
@@ -1282,7 +1284,7 @@ bool CharmmSystemBuilder::buildSystem(const PolymerSequence & _sequence) {
 										if (icValues[4] == 0.0) {
 											if(*atmN) {
 												vector<double> param;
-												if (pParReader->bondParam(param, (*atmM)->getType(),(*atmN)->getType())) {
+												if (pParReader->bondParam(param, (*atmM)->getTypeId(),(*atmN)->getTypeId())) {
 													icValues[4] = param[1];
 												}
 											}
@@ -1342,12 +1344,12 @@ bool CharmmSystemBuilder::buildSystem(const PolymerSequence & _sequence) {
 					
 					// Now loop over all the pAtom1 and pAtom2 atoms and add an interaction for each combination
 					for(vector<Atom*>::iterator a1 = pAtom1.begin() ; a1 != pAtom1.end(); a1++) {
-						string type1 = (*a1)->getType();
+						const string & type1 = (*a1)->getType();
 						for(vector<Atom*>::iterator a2 = pAtom2.begin() ; a2 != pAtom2.end(); a2++) {
-							string type2 = (*a2)->getType();
+							const string & type2 = (*a2)->getType();
 							(*a1)->setBoundTo(*a2);
 							vector<double> params;
-							if (pParReader->bondParam(params, type1, type2)) {
+							if (pParReader->bondParam(params, (*a1)->getTypeId(), (*a2)->getTypeId())) {
 								if (termsToBuild["CHARMM_BOND"]) {
 									CharmmBondInteraction *pCBI = new CharmmBondInteraction(*(*a1),*(*a2),params[0],params[1]);
 									ESet->addInteraction(pCBI);
@@ -1375,20 +1377,20 @@ bool CharmmSystemBuilder::buildSystem(const PolymerSequence & _sequence) {
 						vector<Atom*> pAtom3 = getAtomPointers(atom3, chItr, posItr, idItr);
 						
 						for(vector<Atom*>::iterator a1 = pAtom1.begin() ; a1 != pAtom1.end(); a1++) {
-							string type1 = (*a1)->getType();
+							const string & type1 = (*a1)->getType();
 							for(vector<Atom*>::iterator a2 = pAtom2.begin() ; a2 != pAtom2.end(); a2++) {
-								string type2 = (*a2)->getType();
+								const string & type2 = (*a2)->getType();
 								for(vector<Atom*>::iterator a3 = pAtom3.begin() ; a3 != pAtom3.end(); a3++) {
-									string type3 = (*a3)->getType();
+									const string & type3 = (*a3)->getType();
 									//vector<double> params = pParReader->ureyBradleyParam(type1, type2, type3);
 									vector<double> params;
-									if (pParReader->ureyBradleyParam(params, type1, type2, type3)) {
+									if (pParReader->ureyBradleyParam(params, (*a1)->getTypeId(), (*a2)->getTypeId(), (*a3)->getTypeId())) {
 										if (termsToBuild["CHARMM_U-BR"]) {
 											CharmmUreyBradleyInteraction *pCUI = new CharmmUreyBradleyInteraction(*(*a1),*(*a3),params[0],params[1]);
 											ESet->addInteraction(pCUI);
 										}
 									}
-									if (pParReader->angleParam(params, type1, type2, type3)) {
+									if (pParReader->angleParam(params, (*a1)->getTypeId(), (*a2)->getTypeId(), (*a3)->getTypeId())) {
 										if (termsToBuild["CHARMM_ANGL"]) {
 											CharmmAngleInteraction *pCAI = new CharmmAngleInteraction(*(*a1),*(*a2),*(*a3),params[0],params[1] * M_PI / 180.0); 
 											ESet->addInteraction(pCAI);
@@ -1420,17 +1422,17 @@ bool CharmmSystemBuilder::buildSystem(const PolymerSequence & _sequence) {
 						vector<Atom*> pAtom4 = getAtomPointers(atom4, chItr, posItr, idItr);
 						
 						for(vector<Atom*>::iterator a1 = pAtom1.begin() ; a1 != pAtom1.end(); a1++) {
-							string type1 = (*a1)->getType();
+							const string & type1 = (*a1)->getType();
 							for(vector<Atom*>::iterator a2 = pAtom2.begin() ; a2 != pAtom2.end(); a2++) {
-								string type2 = (*a2)->getType();
+								const string & type2 = (*a2)->getType();
 								for(vector<Atom*>::iterator a3 = pAtom3.begin() ; a3 != pAtom3.end(); a3++) {
-									string type3 = (*a3)->getType();
+									const string & type3 = (*a3)->getType();
 									for(vector<Atom*>::iterator a4 = pAtom4.begin() ; a4 != pAtom4.end(); a4++) {
-										string type4 = (*a4)->getType();
+										const string & type4 = (*a4)->getType();
 
 										//vector<vector <double> > dihedralEntries = pParReader->dihedralParam(type1, type2, type3, type4);
 										vector<vector <double> > dihedralEntries;
-										if (pParReader->dihedralParam(dihedralEntries, type1, type2, type3, type4)) {
+										if (pParReader->dihedralParam(dihedralEntries, (*a1)->getTypeId(), (*a2)->getTypeId(), (*a3)->getTypeId(), (*a4)->getTypeId())) {
 											// there could be multiple entries for a single dihedral
 											for(int m = 0; m < dihedralEntries.size() ; m++) {
 												// the delta should be expressed in radians
@@ -1468,16 +1470,16 @@ bool CharmmSystemBuilder::buildSystem(const PolymerSequence & _sequence) {
 					vector<Atom*> pAtom4 = getAtomPointers(atom4, chItr, posItr, idItr);
 					
 					for(vector<Atom*>::iterator a1 = pAtom1.begin() ; a1 != pAtom1.end(); a1++) {
-						string type1 = (*a1)->getType();
+						const string & type1 = (*a1)->getType();
 						for(vector<Atom*>::iterator a2 = pAtom2.begin() ; a2 != pAtom2.end(); a2++) {
-							string type2 = (*a2)->getType();
+							const string & type2 = (*a2)->getType();
 							for(vector<Atom*>::iterator a3 = pAtom3.begin() ; a3 != pAtom3.end(); a3++) {
-								string type3 = (*a3)->getType();
+								const string & type3 = (*a3)->getType();
 								for(vector<Atom*>::iterator a4 = pAtom4.begin() ; a4 != pAtom4.end(); a4++) {
-									string type4 = (*a4)->getType();
+									const string & type4 = (*a4)->getType();
 									//vector<double> improperParams = pParReader->improperParam(type1, type2, type3, type4);	
 									vector<double> improperParams;
-									if (pParReader->improperParam(improperParams, type1, type2, type3, type4)) {
+									if (pParReader->improperParam(improperParams, (*a1)->getTypeId(), (*a2)->getTypeId(), (*a3)->getTypeId(), (*a4)->getTypeId())) {
 										if (termsToBuild["CHARMM_IMPR"]) {
 											CharmmImproperInteraction *pCII = new CharmmImproperInteraction(*(*a1),*(*a2),*(*a3),*(*a4),improperParams[0],improperParams[1]*M_PI/180.0);
 											ESet->addInteraction(pCII);
@@ -1501,27 +1503,27 @@ bool CharmmSystemBuilder::buildSystem(const PolymerSequence & _sequence) {
 		AtomPointerVector atoms = pSystem->getAllAtomPointers();
 
 		for(AtomPointerVector::iterator atomI = atoms.begin(); atomI < atoms.end(); atomI++) {
-			string atomItype = (*atomI)->getType();
+			const string & atomItype = (*atomI)->getType();
 
 			for(AtomPointerVector::iterator atomJ = atomI+1; atomJ < atoms.end() ; atomJ++) {
 				if ((*atomI)->isInAlternativeIdentity(*atomJ)) {
 					continue;
 				}
-				string atomJtype = (*atomJ)->getType();
+				const string & atomJtype = (*atomJ)->getType();
 				if (pTopReader->getAutoGenerateAngles() && (*atomI)->isOneThree(*atomJ)) {
 					// autogenerate the angle interactions
 					vector<Atom*> middle = (*atomI)->getOneThreeMiddleAtoms(*atomJ);
 						
 					for (vector<Atom*>::iterator k=middle.begin(); k!=middle.end(); k++) {
-						string middleType = (*k)->getType();
+						const string & middleType = (*k)->getType();
 						vector<double> params;
-						if (pParReader->ureyBradleyParam(params, atomItype, middleType, atomJtype)) {
+						if (pParReader->ureyBradleyParam(params, (*atomI)->getTypeId(), (*k)->getTypeId(), (*atomJ)->getTypeId())) {
 							if (termsToBuild["CHARMM_U-BR"]) {
 								CharmmUreyBradleyInteraction *pCUI = new CharmmUreyBradleyInteraction(*(*atomI),*(*atomJ),params[0],params[1]);
 								ESet->addInteraction(pCUI);
 							}
 						}
-						if (pParReader->angleParam(params, atomItype, middleType, atomJtype)) {
+						if (pParReader->angleParam(params, (*atomI)->getTypeId(), (*k)->getTypeId(), (*atomJ)->getTypeId())) {
 							if (termsToBuild["CHARMM_ANGL"]) {
 								CharmmAngleInteraction *pCAI = new CharmmAngleInteraction(*(*atomI),*(*k),*(*atomJ),params[0],params[1] * M_PI / 180.0); 
 								ESet->addInteraction(pCAI);
@@ -1543,7 +1545,7 @@ bool CharmmSystemBuilder::buildSystem(const PolymerSequence & _sequence) {
 						}
 
 						vector<vector <double> > dihedralEntries;
-						if (pParReader->dihedralParam(dihedralEntries, atomItype, middleTypes[0], middleTypes[1], atomJtype)) {
+						if (pParReader->dihedralParam(dihedralEntries, (*atomI)->getTypeId(), middleAtoms[0]->getTypeId(), middleAtoms[1]->getTypeId(), (*atomJ)->getTypeId())) {
 							// there could be multiple entries for a single dihedral
 							for(int m = 0; m < dihedralEntries.size() ; m++) {
 								// the delta should be expressed in radians
@@ -1619,6 +1621,68 @@ bool CharmmSystemBuilder::buildSystemFromPDB(const AtomPointerVector & _atoms) {
 
 }
 
+void * CharmmSystemBuilder::findNonBondedNeighbors(void * _search) {
+	/********************************************************************************
+	 *  Finds the candidate non-bonded partners J > I for the atoms of a block
+	 *  (the next atoms from *pNextAtom, before end) and classifies the pairs
+	 *  as bonded/1-3 (special) and 1-4 with the BondGraph of the System.
+	 *  Only reads the atoms, so that multiple searches can run in separate threads
+	 ********************************************************************************/
+	NonBondedNeighborSearch * pSearch = (NonBondedNeighborSearch*)_search;
+	const AtomPointerVector & atoms = *(pSearch->pAtoms);
+	const vector<bool> & fixed = *(pSearch->pFixed);
+	const unsigned int chunk = 16;
+	unsigned int first = 0;
+	unsigned int last = 0;
+	for (unsigned int ai = 0; ; ai++) {
+		if (ai >= last) {
+			if (pSearch->pMutex != NULL) {
+				pthread_mutex_lock(pSearch->pMutex);
+			}
+			first = *(pSearch->pNextAtom);
+			*(pSearch->pNextAtom) += chunk;
+			if (pSearch->pMutex != NULL) {
+				pthread_mutex_unlock(pSearch->pMutex);
+			}
+			if (first >= pSearch->end) {
+				break;
+			}
+			ai = first;
+			last = first + chunk < pSearch->end ? first + chunk : pSearch->end;
+		}
+		vector<NonBondedNeighbor> & out = (*(pSearch->pNeighbors))[ai - pSearch->offset];
+		Atom * pAtomI = atoms[ai];
+		if (pSearch->useCutoff && !pAtomI->hasCoor()) {
+			continue;
+		}
+		vector<unsigned int> candidates;
+		if (pSearch->pGrid != NULL) {
+			// the boxes of the atoms without coordinates are empty, they are never returned
+			candidates = pSearch->pGrid->getOverlappingBoxes(ai, true);
+		} else {
+			candidates.reserve(atoms.size() - ai - 1);
+			for (unsigned int aj = ai+1; aj < atoms.size(); aj++) {
+				candidates.push_back(aj);
+			}
+		}
+		for (vector<unsigned int>::iterator k=candidates.begin(); k!=candidates.end(); k++) {
+			unsigned int aj = *k;
+			Atom * pAtomJ = atoms[aj];
+			if (pAtomI->isInAlternativeIdentity(pAtomJ)) {
+				continue;
+			}
+			if (pSearch->ignoreNonVariable && fixed[ai] && fixed[aj]) continue;
+			NonBondedNeighbor neighbor;
+			neighbor.index = aj;
+			unsigned char relationship = pSearch->pBondGraph->getRelationship(ai, aj);
+			neighbor.special = (relationship & (BondGraph::oneTwo | BondGraph::oneThree)) != 0;
+			neighbor.oneFour = (relationship & BondGraph::oneFour) != 0;
+			out.push_back(neighbor);
+		}
+	}
+	return NULL;
+}
+
 bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double _cutnb, bool _ignoreNonVariable) {
 	if (pSystem == NULL) {
 		cerr << "WARNING: uninnitialized System in bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double _cutnb)" << endl;
@@ -1652,6 +1716,7 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 	ESet->eraseTerm("CHARMM_IMM1");
 	ESet->eraseTerm("CHARMM_IMM1REF");
 	AtomPointerVector atoms = pSystem->getAllAtomPointers();
+	const BondGraph & bondGraph = pSystem->getBondGraph();
 
 	bool useSolvation_local = useSolvation;
 	if (!pEEF1ParReader->solventExists(solvent)) {
@@ -1713,6 +1778,83 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 	}
 
 
+	/*********************************************************************************
+	 *  Resolve the VDW and solvation parameters once per atom type
+	 *********************************************************************************/
+	// indexed by the atom type id, the last slot is for atoms without a type
+	vector<unsigned int> typeIndex(Atom::getNumberOfTypeIds() + 1, Atom::noTypeId);
+	vector<unsigned int> atomTypes(atoms.size(), 0);
+	vector<NonBondedTypeParameters> typeParams;
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		unsigned int typeId = atoms[i]->getTypeId();
+		unsigned int slot = typeId == Atom::noTypeId ? typeIndex.size() - 1 : typeId;
+		if (typeIndex[slot] != Atom::noTypeId) {
+			atomTypes[i] = typeIndex[slot];
+			continue;
+		}
+		const string & type = atoms[i]->getType();
+		NonBondedTypeParameters par;
+		par.type = type;
+		par.foundVdw = pParReader->vdwParam(par.vdw, typeId);
+		par.foundEEF1 = false;
+		par.foundWater = false;
+		par.foundChex = false;
+		if (useSolvation_local && !useIMM1) {
+			par.foundEEF1 = pEEF1ParReader->EEF1Param(par.EEF1, type, solvent);
+		} else if (useSolvation_local && useIMM1) {
+			par.foundWater = pEEF1ParReader->EEF1Param(par.water, type, "WATER");
+			par.foundChex = pEEF1ParReader->EEF1Param(par.chex, type, "CHEX");
+		}
+		par.vdwWarned = false;
+		par.EEF1Warned = false;
+		atomTypes[i] = typeParams.size();
+		typeIndex[slot] = typeParams.size();
+		typeParams.push_back(par);
+	}
+	bool buildVdw = termsToBuild["CHARMM_VDW"];
+	bool buildElec = termsToBuild["CHARMM_ELEC"];
+	bool buildEEF1 = termsToBuild["CHARMM_EEF1"];
+	bool buildEEF1Ref = termsToBuild["CHARMM_EEF1REF"];
+	bool buildIMM1 = termsToBuild["CHARMM_IMM1"];
+	bool buildIMM1Ref = termsToBuild["CHARMM_IMM1REF"];
+
+	/*********************************************************************************
+	 *  Neighbor search:
+	 *   - with a cutoff, the padded boxes are placed in a grid (Atom3DGrid) and only
+	 *     the atoms with overlapping boxes are candidates for an interaction, so the
+	 *     search scales linearly with the number of atoms
+	 *   - without a cutoff all the pairs are candidates
+	 *
+	 *  The candidates of a block of atoms are found in parallel (see setNumberOfThreads)
+	 *  and then the interactions are created serially in the same order as the all-pairs
+	 *  double loop (atom I, then atom J > I)
+	 *********************************************************************************/
+	Atom3DGrid * pGrid = NULL;
+	if (_cutnb > 0.0) {
+		for (unsigned int i=0; i<atoms.size(); i++) {
+			if (!atoms[i]->hasCoor()) {
+				// empty box, the atom is not placed in the grid
+				xmin[i] = ymin[i] = zmin[i] = 1.0;
+				xmax[i] = ymax[i] = zmax[i] = 0.0;
+			}
+		}
+		pGrid = new Atom3DGrid(atoms, xmin, xmax, ymin, ymax, zmin, zmax, _cutnb);
+	}
+
+	unsigned int nThreads = numberOfThreads;
+	if (nThreads < 1) {
+		nThreads = 1;
+	}
+	unsigned int blockSize = 1024;
+	if (_cutnb <= 0.0) {
+		// all pairs are stored, keep the block small for large systems
+		blockSize = 4194304 / (atoms.size() + 1) + 1;
+	}
+	if (blockSize < nThreads) {
+		blockSize = nThreads;
+	}
+	vector<vector<NonBondedNeighbor> > neighbors;
+
 	/*********************************************************************************
 	 *
 	 *  ADD THE NON-BONDED INTERACTION TERMS:
@@ -1729,130 +1871,169 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 	 *                            0             2                3             vdw 0
 	 *    void setParams(double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j);
 	 **********************************************************************************/
-	for(AtomPointerVector::iterator atomI = atoms.begin(); atomI < atoms.end(); atomI++) {
-		int ai = atomI - atoms.begin();
-		if (_cutnb > 0.0 && !(*atomI)->hasCoor()) {
-			// no coordinates, skip this atom
-			continue;
+	for (unsigned int blockStart = 0; blockStart < atoms.size(); blockStart += blockSize) {
+		unsigned int blockEnd = blockStart + blockSize;
+		if (blockEnd > atoms.size()) {
+			blockEnd = atoms.size();
 		}
-		string atomItype = (*atomI)->getType();
-		bool foundVdw = true;
-		//vector<double> vdwParamsI = pParReader->vdwParam(atomItype);
-		vector<double> vdwParamsI;
-		if (!pParReader->vdwParam(vdwParamsI, atomItype)) {
-			cerr << "WARNING 49319: VDW parameters not found for type " << atomItype << " in bool CharmmSystemBuilder::updateNonBonded(System & _system, double _ctonnb, double _ctofnb, double _cutnb)" << endl;
-			foundVdw = false;
+		neighbors.assign(blockEnd - blockStart, vector<NonBondedNeighbor>());
+
+		unsigned int nextAtom = blockStart;
+		vector<NonBondedNeighborSearch> searches(nThreads);
+		for (unsigned int t=0; t<nThreads; t++) {
+			searches[t].pAtoms = &atoms;
+			searches[t].pGrid = pGrid;
+			searches[t].pBondGraph = &bondGraph;
+			searches[t].pFixed = &fixed;
+			searches[t].ignoreNonVariable = _ignoreNonVariable;
+			searches[t].useCutoff = _cutnb > 0.0;
+			searches[t].pNextAtom = &nextAtom;
+			searches[t].pMutex = NULL;
+			searches[t].end = blockEnd;
+			searches[t].pNeighbors = &neighbors;
+			searches[t].offset = blockStart;
 		}
-
-		bool foundEEF1 = true; 
-		vector<double> EEF1ParamsI; 
-		vector<double> EEF1ParamsII;  // basically the params for the other solvent
-		if (useSolvation_local && !useIMM1) {
-			if (!pEEF1ParReader->EEF1Param(EEF1ParamsI, atomItype, solvent)) {
-				//cerr << "WARNING 49387: EEF1 parameters not found for type " << atomItype << ", solvent " << solvent << " in bool CharmmSystemBuilder::updateSolvation(System & _system, string _solvent, double _ctonnb, double _ctofnb, double _cutnb)" << endl;
-				foundEEF1 = false;
-			} else {
-				// add the single body term
-				if (termsToBuild["CHARMM_EEF1REF"]) {
-					CharmmEEF1RefInteraction *pCERI = new CharmmEEF1RefInteraction(*(*atomI),EEF1ParamsI[1]);
-					ESet->addInteraction(pCERI);
-				}
-			}
-		} else if (useSolvation_local && useIMM1 && termsToBuild["CHARMM_IMM1REF"]) {
-			if (pEEF1ParReader->EEF1Param(EEF1ParamsI, atomItype, "WATER") &&  pEEF1ParReader->EEF1Param(EEF1ParamsII, atomItype, "CHEX")) {
-				CharmmIMM1RefInteraction *pIMM1R = new CharmmIMM1RefInteraction(*(*atomI),EEF1ParamsI[1],EEF1ParamsII[1],halfThickness,exponent);
-				ESet->addInteraction(pIMM1R);
-			} else {
-				foundEEF1 = false;
+		if (nThreads == 1) {
+			findNonBondedNeighbors(&searches[0]);
+		} else {
+			pthread_mutex_t mutex;
+			pthread_mutex_init(&mutex, NULL);
+			vector<void*> args(nThreads);
+			for (unsigned int t=0; t<nThreads; t++) {
+				searches[t].pMutex = &mutex;
+				args[t] = &searches[t];
 			}
+			MslTools::runThreads(findNonBondedNeighbors, args);
+			pthread_mutex_destroy(&mutex);
 		}
-		
-		for(AtomPointerVector::iterator atomJ = atomI+1; atomJ < atoms.end() ; atomJ++) {
-			int aj = atomJ - atoms.begin();
-			if ((*atomI)->isInAlternativeIdentity(*atomJ)) {
+
+		for (unsigned int ai = blockStart; ai < blockEnd; ai++) {
+			Atom * pAtomI = atoms[ai];
+			if (_cutnb > 0.0 && !pAtomI->hasCoor()) {
+				// no coordinates, skip this atom
 				continue;
 			}
-			if (_ignoreNonVariable && fixed[ai] && fixed[aj]) continue;
-			if (_cutnb > 0.0 && (!(*atomJ)->hasCoor() ||
-				// sufficient condition for the two atoms never being in non-bond cutoff range range
-				((xmax[ai] < xmin[aj]) || (xmax[aj] < xmin[ai]) || (ymax[ai] < ymin[aj]) || (ymax[aj] < ymin[ai]) || (zmax[ai] < zmin[aj]) || (zmax[aj] < zmin[ai])) )) {
-				// no coordinates or atom further away from cutoff, skip this atom
-				continue;
+			NonBondedTypeParameters & parI = typeParams[atomTypes[ai]];
+			bool foundVdw = parI.foundVdw;
+			if (!foundVdw && !parI.vdwWarned) {
+				cerr << "WARNING 49319: VDW parameters not found for type " << parI.type << " in bool CharmmSystemBuilder::updateNonBonded(System & _system, double _ctonnb, double _ctofnb, double _cutnb)" << endl;
+				parI.vdwWarned = true;
 			}
 
-			string atomJtype = (*atomJ)->getType();
-			bool special = false;
-			if ((*atomI)->isBoundTo(*atomJ) || (*atomI)->isOneThree(*atomJ)) {
-				special = true;
-			}
-			bool foundVdw2 = true;
-			vector<double> vdwParamsJ;;
-			if (!pParReader->vdwParam(vdwParamsJ, atomJtype)) {
-				cerr << "WARNING 49319: VDW parameters not found for type " << atomJtype << " in bool CharmmSystemBuilder::updateNonBonded(System & _system, double _ctonnb, double _ctofnb, double _cutnb)" << endl;
-				foundVdw2 = false;
-				//continue;
+			bool foundEEF1 = true; 
+			if (useSolvation_local && !useIMM1) {
+				if (!parI.foundEEF1) {
+					foundEEF1 = false;
+				} else {
+					// add the single body term
+					if (buildEEF1Ref) {
+						CharmmEEF1RefInteraction *pCERI = new CharmmEEF1RefInteraction(*pAtomI,parI.EEF1[1]);
+						ESet->addInteraction(pCERI);
+					}
+				}
+			} else if (useSolvation_local && useIMM1 && buildIMM1Ref) {
+				if (parI.foundWater && parI.foundChex) {
+					CharmmIMM1RefInteraction *pIMM1R = new CharmmIMM1RefInteraction(*pAtomI,parI.water[1],parI.chex[1],halfThickness,exponent);
+					ESet->addInteraction(pIMM1R);
+				} else {
+					foundEEF1 = false;
+				}
 			}
-			if (useSolvation_local && foundEEF1 && !special) {
-				vector<double> EEF1ParamsJ;
-				vector<double> EEF1ParamsJJ;
-				if(!useIMM1) {
-					if (pEEF1ParReader->EEF1Param(EEF1ParamsJ, atomJtype, solvent)) {
-						if (termsToBuild["CHARMM_EEF1"]) {
-							CharmmEEF1Interaction *pCSI = new CharmmEEF1Interaction(*(*atomI),*(*atomJ), EEF1ParamsI[0], EEF1ParamsI[2], EEF1ParamsI[5], vdwParamsI[1], EEF1ParamsJ[0], EEF1ParamsJ[2], EEF1ParamsJ[5], vdwParamsJ[1]);
+
+			vector<NonBondedNeighbor> & neighborsI = neighbors[ai - blockStart];
+			for (vector<NonBondedNeighbor>::iterator n = neighborsI.begin(); n != neighborsI.end(); n++) {
+				Atom * pAtomJ = atoms[n->index];
+				NonBondedTypeParameters & parJ = typeParams[atomTypes[n->index]];
+				bool special = n->special;
+				bool foundVdw2 = parJ.foundVdw;
+				if (!foundVdw2 && !parJ.vdwWarned) {
+					cerr << "WARNING 49319: VDW parameters not found for type " << parJ.type << " in bool CharmmSystemBuilder::updateNonBonded(System & _system, double _ctonnb, double _ctofnb, double _cutnb)" << endl;
+					parJ.vdwWarned = true;
+				}
+				if (useSolvation_local && foundEEF1 && !special) {
+					if(!useIMM1) {
+						if (parJ.foundEEF1) {
+							if (buildEEF1) {
+								CharmmEEF1Interaction *pCSI = new CharmmEEF1Interaction(*pAtomI,*pAtomJ, parI.EEF1[0], parI.EEF1[2], parI.EEF1[5], parI.vdw[1], parJ.EEF1[0], parJ.EEF1[2], parJ.EEF1[5], parJ.vdw[1]);
+								if (_cutnb > 0.0) {
+									// if we are using a cutoff, set the Charmm VDW interaction with
+									// the cutoffs for the switching function
+									pCSI->setUseNonBondCutoffs(true, _ctonnb, _ctofnb);
+								} else {
+									pCSI->setUseNonBondCutoffs(false, 0.0, 0.0);
+								}
+								ESet->addInteraction(pCSI);
+							}
+						} else if (!parJ.EEF1Warned) {
+							cerr << "WARNING 49387: EEF1 parameters not found for type " << parJ.type << ", solvent " << solvent << " in bool CharmmSystemBuilder::updateSolvation(System & _system, string _solvent, double _ctonnb, double _ctofnb, double _cutnb)" << endl;
+							parJ.EEF1Warned = true;
+						}
+					} else {
+						// two double body terms
+						if(buildIMM1) {
+							// NOTE: this reproduces the parameters used by the earlier all-pairs
+							// loop: the water and membrane entries of both atoms are taken from
+							// the type of atom I (membrane) and the membrane vector is zero
+							if (parI.foundWater && parI.foundChex) {
+								vector<double> IMM1ParamsW(8,0.0);
+								IMM1ParamsW[0] = parI.chex[0];
+								IMM1ParamsW[1] = parI.chex[2];
+								IMM1ParamsW[2] = parI.chex[5];
+								IMM1ParamsW[3] = parI.vdw[1];
+								IMM1ParamsW[4] = parI.chex[0];
+								IMM1ParamsW[5] = parI.chex[2];
+								IMM1ParamsW[6] = parI.chex[5];
+								IMM1ParamsW[7] = parJ.vdw[1];
+
+								vector<double> IMM1ParamsC(8,0.0);
+
+								CharmmIMM1Interaction *pCIMM1 = new CharmmIMM1Interaction(*pAtomI,*pAtomJ,IMM1ParamsW,IMM1ParamsC,halfThickness,exponent);
+								if(_cutnb > 0.0) {
+									pCIMM1->setUseNonBondCutoffs(true,_ctonnb, _ctofnb);
+								} else {
+									pCIMM1->setUseNonBondCutoffs(false, 0.0, 0.0);
+								}
+								ESet->addInteraction(pCIMM1);
+							}
+						}
+					}
+				}
+				if (n->oneFour) {
+					if (!special) {
+						// if it is also 1-3 or 1-2 do not add the vdw and elec term
+						if (buildElec) {
+							CharmmElectrostaticInteraction *pCEI = new CharmmElectrostaticInteraction(*pAtomI,*pAtomJ,dielectricConstant,elec14factor, useRdielectric);
+
 							if (_cutnb > 0.0) {
 								// if we are using a cutoff, set the Charmm VDW interaction with
 								// the cutoffs for the switching function
-								pCSI->setUseNonBondCutoffs(true, _ctonnb, _ctofnb);
+								pCEI->setUseNonBondCutoffs(true, _ctonnb, _ctofnb);
 							} else {
-								pCSI->setUseNonBondCutoffs(false, 0.0, 0.0);
+								pCEI->setUseNonBondCutoffs(false, 0.0, 0.0);
 							}
-							ESet->addInteraction(pCSI);
+							ESet->addInteraction(pCEI);
 						}
-					} else {
-						cerr << "WARNING 49387: EEF1 parameters not found for type " << atomJtype << ", solvent " << solvent << " in bool CharmmSystemBuilder::updateSolvation(System & _system, string _solvent, double _ctonnb, double _ctofnb, double _cutnb)" << endl;
-					}
-				} else {
-					// two double body terms
-					if(termsToBuild["CHARMM_IMM1"]) {
-						if (pEEF1ParReader->EEF1Param(EEF1ParamsJ, atomItype, "WATER") && pEEF1ParReader->EEF1Param(EEF1ParamsJJ, atomItype, "CHEX")) {
-							vector<double> IMM1ParamsW(8,0.0);
-							IMM1ParamsW[0] = EEF1ParamsI[0];
-							IMM1ParamsW[1] = EEF1ParamsI[2];
-							IMM1ParamsW[2] = EEF1ParamsI[5];
-							IMM1ParamsW[3] = vdwParamsI[1];
-							IMM1ParamsW[4] = EEF1ParamsJ[0];
-							IMM1ParamsW[5] = EEF1ParamsJ[2];
-							IMM1ParamsW[6] = EEF1ParamsJ[5];
-							IMM1ParamsW[7] = vdwParamsJ[1];
-
-							vector<double> IMM1ParamsC(8,0.0);
-							IMM1ParamsW[0] = EEF1ParamsII[0];
-							IMM1ParamsW[1] = EEF1ParamsII[2];
-							IMM1ParamsW[2] = EEF1ParamsII[5];
-							IMM1ParamsW[3] = vdwParamsI[1];
-							IMM1ParamsW[4] = EEF1ParamsJJ[0];
-							IMM1ParamsW[5] = EEF1ParamsJJ[2];
-							IMM1ParamsW[6] = EEF1ParamsJJ[5];
-							IMM1ParamsW[7] = vdwParamsJ[1];
-
-							CharmmIMM1Interaction *pCIMM1 = new CharmmIMM1Interaction(*(*atomI),*(*atomJ),IMM1ParamsW,IMM1ParamsC,halfThickness,exponent);
-							if(_cutnb > 0.0) {
-								pCIMM1->setUseNonBondCutoffs(true,_ctonnb, _ctofnb);
-							} else {
-								pCIMM1->setUseNonBondCutoffs(false, 0.0, 0.0);
+						if (foundVdw && foundVdw2) {
+							if (buildVdw) {
+								// the pair parameters of the types, with the NBFIX corrections
+								const double * vdwPair = pParReader->vdwParamPair(pAtomI->getTypeId(), pAtomJ->getTypeId());
+								CharmmVdwInteraction *pCVI = new CharmmVdwInteraction(*pAtomI,*pAtomJ, vdwPair[3] * vdwRescalingFactor, vdwPair[2] );
+								if (_cutnb > 0.0) {
+									// if we are using a cutoff, set the Charmm VDW interaction with
+									// the cutoffs for the switching function
+									pCVI->setUseNonBondCutoffs(true, _ctonnb, _ctofnb);
+								} else {
+									pCVI->setUseNonBondCutoffs(false, 0.0, 0.0);
+								}
+								ESet->addInteraction(pCVI);
 							}
-							ESet->addInteraction(pCIMM1);
 						}
 					}
+					special = true;
 				}
-			}
-			if ((*atomI)->isOneFour(*atomJ)) {
 				if (!special) {
-					// if it is also 1-3 or 1-2 do not add the vdw and elec term
-					//vector<double> vdwParamsJ = pParReader->vdwParam(atomJtype);
-					if (termsToBuild["CHARMM_ELEC"]) {
-						CharmmElectrostaticInteraction *pCEI = new CharmmElectrostaticInteraction(*(*atomI),*(*atomJ),dielectricConstant,elec14factor, useRdielectric);
-
+					if (buildElec) {
+						CharmmElectrostaticInteraction *pCEI = new CharmmElectrostaticInteraction(*pAtomI,*pAtomJ,dielectricConstant, 1.0, useRdielectric);
 						if (_cutnb > 0.0) {
 							// if we are using a cutoff, set the Charmm VDW interaction with
 							// the cutoffs for the switching function
@@ -1863,8 +2044,10 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 						ESet->addInteraction(pCEI);
 					}
 					if (foundVdw && foundVdw2) {
-						if (termsToBuild["CHARMM_VDW"]) {
-							CharmmVdwInteraction *pCVI = new CharmmVdwInteraction(*(*atomI),*(*atomJ), (vdwParamsI[3]+vdwParamsJ[3]) * vdwRescalingFactor, sqrt(vdwParamsI[2] * vdwParamsJ[2]) );
+						if (buildVdw) {
+							// the pair parameters of the types, with the NBFIX corrections
+							const double * vdwPair = pParReader->vdwParamPair(pAtomI->getTypeId(), pAtomJ->getTypeId());
+							CharmmVdwInteraction *pCVI = new CharmmVdwInteraction(*pAtomI,*pAtomJ, vdwPair[1] * vdwRescalingFactor, vdwPair[0] );
 							if (_cutnb > 0.0) {
 								// if we are using a cutoff, set the Charmm VDW interaction with
 								// the cutoffs for the switching function
@@ -1874,40 +2057,12 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 							}
 							ESet->addInteraction(pCVI);
 						}
-						
-
-					}
-				}
-				special = true;
-			}
-			if (!special) {
-				if (termsToBuild["CHARMM_ELEC"]) {
-					CharmmElectrostaticInteraction *pCEI = new CharmmElectrostaticInteraction(*(*atomI),*(*atomJ),dielectricConstant, 1.0, useRdielectric);
-					if (_cutnb > 0.0) {
-						// if we are using a cutoff, set the Charmm VDW interaction with
-						// the cutoffs for the switching function
-						pCEI->setUseNonBondCutoffs(true, _ctonnb, _ctofnb);
-					} else {
-						pCEI->setUseNonBondCutoffs(false, 0.0, 0.0);
-					}
-					ESet->addInteraction(pCEI);
-				}
-				if (foundVdw && foundVdw2) {
-					if (termsToBuild["CHARMM_VDW"]) {
-						CharmmVdwInteraction *pCVI = new CharmmVdwInteraction(*(*atomI),*(*atomJ), (vdwParamsI[1]+vdwParamsJ[1]) * vdwRescalingFactor, sqrt(vdwParamsI[0] * vdwParamsJ[0]) );
-						if (_cutnb > 0.0) {
-							// if we are using a cutoff, set the Charmm VDW interaction with
-							// the cutoffs for the switching function
-							pCVI->setUseNonBondCutoffs(true, _ctonnb, _ctofnb);
-						} else {
-							pCVI->setUseNonBondCutoffs(false, 0.0, 0.0);
-						}
-						ESet->addInteraction(pCVI);
 					}
 				}
 			}
 		}
 	}
+	delete pGrid;
 
 	return true;
 }
@@ -1957,7 +2112,7 @@ bool CharmmSystemBuilder::updateSolvation(System & _system, string _solvent, dou
 			// no coordinates, skip this atom
 			continue;
 		}
-		string atomItype = (*atomI)->getType();
+		const string & atomItype = (*atomI)->getType();
 	//	vector<double> vdwParamsI = pParReader->vdwParam(atomItype);
 		vector<double> vdwParamsI;
 		if (!pParReader->vdwParam(vdwParamsI, atomItype)) {
@@ -1983,7 +2138,7 @@ bool CharmmSystemBuilder::updateSolvation(System & _system, string _solvent, dou
 				continue;
 			}
 
-			string atomJtype = (*atomJ)->getType();
+			const string & atomJtype = (*atomJ)->getType();
 			bool special = false;
 			if ((*atomI)->isBoundTo(*atomJ) || (*atomI)->isOneThree(*atomJ)) {
 				special = true;
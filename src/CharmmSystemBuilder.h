@@ -53,6 +53,9 @@ You should have received a copy of the GNU Lesser General Public
 #include "CharmmEEF1Interaction.h"
 #include "CharmmEEF1RefInteraction.h"
 #include "RandomNumberGenerator.h"
+#include "Atom3DGrid.h"
+
+#include <pthread.h>
 
 
 namespace MSL { 
@@ -140,6 +143,10 @@ class CharmmSystemBuilder {
 		void setUseGroupCutoffs(bool _flag);
 		bool getUseGroupCutoffs() const;
 
+		// number of threads used for the neighbor search in updateNonBonded (default 1)
+		void setNumberOfThreads(unsigned int _threads);
+		unsigned int getNumberOfThreads() const;
+
 		bool fail() const; // return false if reading toppar failed
 
 
@@ -181,6 +188,45 @@ class CharmmSystemBuilder {
 		void getAtomPointersFromMulti(std::string _name, std::vector<Atom*> & _out, std::vector<CharmmTopologyResidue*> & _position, std::vector<std::map<std::string, Atom*> > & _atomMap);
 		std::vector<Atom*> getAtomPointers(std::string _name, std::vector<std::vector<std::vector<CharmmTopologyResidue*> > >::iterator & _chItr, std::vector<std::vector<CharmmTopologyResidue*> >::iterator & _posItr, std::vector<CharmmTopologyResidue*>::iterator & _idItr);
 
+		/**************************************************
+		 *  Used by updateNonBonded: the parameters of each
+		 *  atom type are resolved once, the candidate pairs
+		 *  of a block of atoms are found (possibly in
+		 *  separate threads) by findNonBondedNeighbors
+		 **************************************************/
+		struct NonBondedTypeParameters {
+			std::string type;
+			bool foundVdw;
+			std::vector<double> vdw;
+			bool foundEEF1;
+			std::vector<double> EEF1; // for the current solvent
+			bool foundWater;
+			std::vector<double> water; // for IMM1
+			bool foundChex;
+			std::vector<double> chex; // for IMM1
+			bool vdwWarned;
+			bool EEF1Warned;
+		};
+		struct NonBondedNeighbor {
+			unsigned int index;
+			bool special; // bonded or 1-3
+			bool oneFour;
+		};
+		struct NonBondedNeighborSearch {
+			const AtomPointerVector * pAtoms;
+			const Atom3DGrid * pGrid; // NULL if no cutoff is used
+			const BondGraph * pBondGraph; // the 1-2, 1-3 and 1-4 relationships, same atom indeces
+			const std::vector<bool> * pFixed;
+			bool ignoreNonVariable;
+			bool useCutoff;
+			unsigned int * pNextAtom; // shared, the atoms are taken in chunks by the first free thread
+			pthread_mutex_t * pMutex;
+			unsigned int end;
+			unsigned int offset;
+			std::vector<std::vector<NonBondedNeighbor> > * pNeighbors; // indexed by atom - offset
+		};
+		static void * findNonBondedNeighbors(void * _search);
+
 		std::vector<std::vector<std::vector<CharmmTopologyResidue*> > > polymerDefi;
 		std::vector<std::vector<std::vector<std::map<std::string, Atom*> > > > atomMap;
 
@@ -207,6 +253,8 @@ class CharmmSystemBuilder {
 
 		bool fail_flag;
 
+		unsigned int numberOfThreads;
+
 };
 inline void CharmmSystemBuilder::setSystem(System & _system) {
 	reset();
@@ -284,6 +332,8 @@ inline void CharmmSystemBuilder::setUseRdielectric(bool _flag) {useRdielectric =
 inline bool CharmmSystemBuilder::getUseRdielectric() const {return useRdielectric;}
 inline void CharmmSystemBuilder::setUseGroupCutoffs(bool _flag) { useGroupCutoffs = _flag;}
 inline bool CharmmSystemBuilder::getUseGroupCutoffs() const { return useGroupCutoffs; }
+inline void CharmmSystemBuilder::setNumberOfThreads(unsigned int _threads) { numberOfThreads = _threads;}
+inline unsigned int CharmmSystemBuilder::getNumberOfThreads() const { return numberOfThreads; }
 inline bool CharmmSystemBuilder::fail() const { return fail_flag;}
 inline void CharmmSystemBuilder::setSolvent(std::string _solvent) {solvent = _solvent;}
 inline void CharmmSystemBuilder::setIMM1Params(double _halfThickness, double _exponent) {halfThickness = _halfThickness; exponent = _exponent;}
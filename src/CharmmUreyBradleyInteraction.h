@@ -62,6 +62,7 @@ class CharmmUreyBradleyInteraction: public TwoBodyInteraction {
 		
 		double getEnergy();
 		double getEnergy(std::vector<double> *_ad);
+		double getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace); // fused, no allocation
 		double getEnergy(double _distance,std::vector<double> *_ad=NULL);
 		std::vector<double> getEnergyGrad();
 
@@ -95,6 +96,13 @@ inline double CharmmUreyBradleyInteraction::getEnergy() {
 		return getEnergy(distance,_dd);
 	}
 	return getEnergy();
+}
+ inline double CharmmUreyBradleyInteraction::getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace) {
+	double dd[6];
+	double distance = distanceDerivative(dd);
+	double diff = distance - params[1];
+	addGradient(_gradients, dd, 2*params[0]*(diff));
+	return params[0] * (diff*diff);
 }
  inline double CharmmUreyBradleyInteraction::getEnergy(double _distance,std::vector<double> *_dd) {
 	return CharmmEnergy::instance()->spring(_distance, params[0], params[1],_dd);
@@ -52,9 +52,9 @@ CharmmVdwInteraction::~CharmmVdwInteraction() {
 }
 
 void CharmmVdwInteraction::setup(Atom * _pA1, Atom * _pA2, double _rmin, double _Emin) {
-	pAtoms = vector<Atom*>(2, (Atom*)NULL);
+	pAtoms.assign(2, (Atom*)NULL);
 	setAtoms(*_pA1, *_pA2);	
-	params = vector<double>(2, 0.0);
+	params.assign(2, 0.0);
 	setParams(_rmin, _Emin);
 	useNonBondCutoffs = false;
 	nonBondCutoffOn = 997;
@@ -62,6 +62,7 @@ class CharmmVdwInteraction: public TwoBodyInteraction {
 		
 		double getEnergy(); // wrapper function
 		double getEnergy(std::vector<double> *_dd); // used by minimizer - does not apply switching function even if cutoffs are in place 
+		double getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace); // fused, no allocation
 		double getEnergy(double _distance, std::vector<double> *_dd=NULL); // used with no cutoffs
 		double getEnergy(double _distance, double _groupDistance);// used with cutoffs
 
@@ -139,6 +140,17 @@ inline double CharmmVdwInteraction::getEnergy(std::vector<double> *_dd) {
 	}
 	return getEnergy(pAtoms[0]->distance(*pAtoms[1]));
 }
+inline double CharmmVdwInteraction::getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace) {
+	// as CharmmEnergy::LJ, without the switching function
+	double dd[6];
+	double distance = distanceDerivative(dd);
+	double frac = params[0] / distance;
+	double pow6 = frac * frac * frac;
+	pow6 *= pow6;
+	double pow12 = pow6 * pow6;
+	addGradient(_gradients, dd, params[1]*(-12.0*pow12/distance + 12.0*pow6/distance));
+	return params[1] * (pow12 - 2.0 * pow6);
+}
 inline double CharmmVdwInteraction::getEnergy(double _distance, std::vector<double> *_dd) {
 	// called if there are no cutoffs
 	return CharmmEnergy::instance()->LJ(_distance, params[0], params[1],_dd);
@@ -28,12 +28,16 @@ You should have received a copy of the GNU Lesser General Public
 */
 
 #include "ChiStatistics.h"
+#include <fstream>
+#include <algorithm>
 
 using namespace MSL;
 using namespace std;
 
 
 ChiStatistics::ChiStatistics(){
+	chiGridSize = 10.0;
+	gridsNormalized = true;
 	SysEnv env;
 	dofReader.read(env.getEnv("MSL_PDB_2.3_DOF"));
 }
@@ -54,8 +58,12 @@ void ChiStatistics::operator=(const ChiStatistics &_chiStat){
 }
 
 void ChiStatistics::copy(const ChiStatistics &_chiStat){
-	// Emtpy for now..
 	dofReader = _chiStat.dofReader;
+	chiGridSize = _chiStat.chiGridSize;
+	grids = _chiStat.grids;
+	gridNames = _chiStat.gridNames;
+	gridIndex = _chiStat.gridIndex;
+	gridsNormalized = _chiStat.gridsNormalized;
 }
 
 int ChiStatistics::getNumberChis(Residue &_n){
@@ -118,3 +126,184 @@ vector<double> ChiStatistics::getChis(Residue &_n,bool _angleInRadians) {
 
 
 
+
+bool ChiStatistics::readCounts(string _file){
+	ifstream fin(_file.c_str());
+	if (fin.fail()){
+		cerr << "ERROR 4235 cannot read chi counts file "<<_file<<" in ChiStatistics::readCounts(string _file)"<<endl;
+		return false;
+	}
+
+	// read all the entries first, the bin size comes from the spacing of the bin centers
+	vector<string> residues;
+	vector<vector<double> > chiBins;
+	vector<int> counts;
+	vector<double> centers;
+	double gridSize = 0.0;
+	string residue = "";
+	string line;
+	while (getline(fin, line)){
+		if (line.length() <= 1 || line[0] == '#') continue;
+		vector<string> toks = MslTools::tokenize(line," ",false);
+		if (toks.size() == 0) continue;
+		if (toks[0] == "RESN"){
+			if (toks.size() != 2){
+				cerr << "ERROR 4236 ChiStatistics::readCounts(string _file), RESN line not enough tokens: "<<line<<endl;
+				return false;
+			}
+			residue = toks[1];
+		} else if (toks[0] == "GRID" && toks.size() == 2){
+			gridSize = MslTools::toDouble(toks[1]);
+		} else if (toks[0] == "STAT"){
+			if (toks.size() < 3 || residue == ""){
+				cerr << "ERROR 4236 ChiStatistics::readCounts(string _file), STAT line not enough tokens("<<toks.size()<<") or no RESN line before it: "<<line<<endl;
+				return false;
+			}
+			vector<double> chis;
+			for (unsigned int i = 1; i < toks.size() - 1; i++){
+				chis.push_back(MslTools::toDouble(toks[i]));
+				centers.push_back(chis.back());
+			}
+			residues.push_back(residue);
+			chiBins.push_back(chis);
+			counts.push_back(MslTools::toInt(toks.back()));
+		}
+	}
+
+	// without a GRID line, the largest spacing that divides all the distances between the centers
+	if (gridSize <= 0.0){
+		sort(centers.begin(), centers.end());
+		for (unsigned int i = 1; i < centers.size(); i++){
+			double diff = centers[i] - centers[i-1];
+			if (diff < 1.0e-3) continue;
+			if (gridSize == 0.0){
+				gridSize = diff;
+				continue;
+			}
+			while (diff > 1.0e-3){
+				double remainder = fmod(gridSize, diff);
+				gridSize = diff;
+				diff = remainder;
+			}
+		}
+	}
+	if (gridSize > 0.0){
+		chiGridSize = gridSize;
+	}
+
+	for (unsigned int i = 0; i < residues.size(); i++){
+		addStatistics(residues[i], chiBins[i], counts[i]);
+	}
+	return true;
+}
+
+void ChiStatistics::addStatistics(string _residueType, const vector<double> & _chis, int _count){
+	if (_chis.size() == 0 || _count <= 0){
+		return;
+	}
+	map<string,int>::iterator it = gridIndex.find(_residueType);
+	int resType = 0;
+	if (it == gridIndex.end()){
+		resType = grids.size();
+		gridIndex[_residueType] = resType;
+		gridNames.push_back(_residueType);
+		grids.push_back(DihedralGrid(_chis.size(), chiGridSize));
+	} else {
+		resType = it->second;
+		if (grids[resType].getDimensions() != _chis.size()){
+			cerr << "ERROR 4237 ChiStatistics::addStatistics(string _residueType, const vector<double> & _chis, int _count), "<<_chis.size()<<" chis given for "<<_residueType<<" which has "<<grids[resType].getDimensions()<<endl;
+			return;
+		}
+	}
+	grids[resType].addCounts(grids[resType].getAngleIndex(&_chis[0]), _count);
+	gridsNormalized = false;
+}
+
+void ChiStatistics::normalizeGrids(){
+	for (unsigned int i = 0; i < grids.size(); i++){
+		if (!grids[i].isNormalized()){
+			grids[i].normalize();
+		}
+	}
+	gridsNormalized = true;
+}
+
+int ChiStatistics::getResidueTypeIndex(string _resName){
+	map<string,int>::iterator it = gridIndex.find(_resName);
+	if (it == gridIndex.end()){
+		return -1;
+	}
+	return it->second;
+}
+
+bool ChiStatistics::checkChis(string _resName, const vector<double> & _chis, int & _resType){
+	_resType = getResidueTypeIndex(_resName);
+	if (_resType < 0){
+		return false;
+	}
+	if (grids[_resType].getDimensions() != _chis.size()){
+		cerr << "ERROR 4238 ChiStatistics, "<<_chis.size()<<" chis given for "<<_resName<<" which has "<<grids[_resType].getDimensions()<<" in the chi counts"<<endl;
+		return false;
+	}
+	for (unsigned int i = 0; i < _chis.size(); i++){
+		if (_chis[i] == MslTools::doubleMax){
+			return false;
+		}
+	}
+	return true;
+}
+
+int ChiStatistics::getCounts(string _resName, const vector<double> & _chis){
+	int resType = 0;
+	if (!checkChis(_resName, _chis, resType)){
+		return MslTools::intMax;
+	}
+	return grids[resType].getCounts(grids[resType].getAngleIndex(&_chis[0]));
+}
+
+double ChiStatistics::getProbability(string _resName, const vector<double> & _chis, bool _interpolate){
+	int resType = 0;
+	if (!checkChis(_resName, _chis, resType)){
+		return MslTools::doubleMax;
+	}
+	return getProbability(resType, &_chis[0], _interpolate);
+}
+
+double ChiStatistics::getLogProbability(string _resName, const vector<double> & _chis, bool _interpolate){
+	int resType = 0;
+	if (!checkChis(_resName, _chis, resType)){
+		return MslTools::doubleMax;
+	}
+	return getLogProbability(resType, &_chis[0], _interpolate);
+}
+
+double ChiStatistics::getProbability(Residue &_n, bool _interpolate){
+	return getProbability(_n.getResidueName(), getChis(_n), _interpolate);
+}
+
+double ChiStatistics::getLogProbability(Residue &_n, bool _interpolate){
+	return getLogProbability(_n.getResidueName(), getChis(_n), _interpolate);
+}
+
+bool ChiStatistics::writeBinaryFile(string _filename){
+	return DihedralGrid::writeFile(_filename, gridNames, grids);
+}
+
+bool ChiStatistics::readBinaryFile(string _filename){
+	vector<string> names;
+	vector<DihedralGrid> newGrids;
+	if (!DihedralGrid::readFile(_filename, names, newGrids)){
+		return false;
+	}
+	grids = newGrids;
+	gridNames = names;
+	gridIndex.clear();
+	for (unsigned int i = 0; i < grids.size(); i++){
+		gridIndex[gridNames[i]] = i;
+	}
+	if (grids.size() > 0){
+		chiGridSize = grids[0].getBinSize();
+	}
+	normalizeGrids();
+	return true;
+}
@@ -34,6 +34,7 @@ You should have received a copy of the GNU Lesser General Public
 #include "Residue.h"
 #include "DegreeOfFreedomReader.h"
 #include "SysEnv.h"
+#include "DihedralGrid.h"
 
 // STL Includes
 
@@ -69,17 +70,95 @@ class ChiStatistics {
 		double getChi(Residue &_n, int _chiNumber,bool _angleInRadians=false);
 		std::vector<double>  getChis(Residue &_n,bool _angleInRadians=false);
 
+		/***************************************************************
+		 *  Chi statistics: the counts of each residue type in a dense
+		 *  DihedralGrid with one dimension per chi (chi1..chiN, N from
+		 *  the data), and the probabilities and log-probabilities of
+		 *  the bins precomputed.  The text format is the one of the
+		 *  phi/psi counts, with N chi bin centers on the STAT lines:
+		 *     RESN LEU
+		 *     STAT -175 65 12
+		 *  The bin size is given by an optional "GRID 10" line, or is
+		 *  the largest one on which all the bin centers of the file
+		 *  lie (setChiGridSize before addStatistics otherwise).
+		 *  writeBinaryFile / readBinaryFile save and load the grids.
+		 *  The integer functions give an error (and getGrid exits) if
+		 *  the index is not a residue type of the counts.
+		 ***************************************************************/
+		bool readCounts(std::string _file);
+		void addStatistics(std::string _residueType, const std::vector<double> & _chis, int _count);
+		void setChiGridSize(double _gridSize);
+		double getChiGridSize() const;
+
+		int getResidueTypeIndex(std::string _resName); // -1 if the type has no counts
+		const DihedralGrid & getGrid(int _resType);
+		int getCounts(std::string _resName, const std::vector<double> & _chis);
+		double getProbability(int _resType, const double * _chis, bool _interpolate=false);
+		double getLogProbability(int _resType, const double * _chis, bool _interpolate=false);
+		double getProbability(std::string _resName, const std::vector<double> & _chis, bool _interpolate=false);
+		double getLogProbability(std::string _resName, const std::vector<double> & _chis, bool _interpolate=false);
+		double getProbability(Residue &_n, bool _interpolate=false);
+		double getLogProbability(Residue &_n, bool _interpolate=false);
+
+		bool writeBinaryFile(std::string _filename);
+		bool readBinaryFile(std::string _filename);
+
 	private:
 		
 		void copy(const ChiStatistics &_phiPsiStat);
+		void normalizeGrids();
+		bool validResidueType(int _resType);
+		bool checkChis(std::string _resName, const std::vector<double> & _chis, int & _resType);
 		DegreeOfFreedomReader dofReader;
 
+		double chiGridSize;
+		std::vector<DihedralGrid> grids;
+		std::vector<std::string> gridNames;
+		std::map<std::string,int> gridIndex;
+		bool gridsNormalized;
+
 		/*
 		double getChiBin(double _angle);
 		std::map<std::string,std::vector<int> >  chiTable;
 		*/
 
 };
+
+inline void ChiStatistics::setChiGridSize(double _gridSize) { chiGridSize = _gridSize; }
+inline double ChiStatistics::getChiGridSize() const { return chiGridSize; }
+inline bool ChiStatistics::validResidueType(int _resType) {
+	if (!gridsNormalized) {
+		normalizeGrids();
+	}
+	return _resType >= 0 && _resType < (int)grids.size();
+}
+inline const DihedralGrid & ChiStatistics::getGrid(int _resType) {
+	if (!validResidueType(_resType)) {
+		std::cerr << "ERROR 4239 ChiStatistics::getGrid(int _resType) no chi counts for residue type index " << _resType << std::endl;
+		exit(4239);
+	}
+	return grids[_resType];
+}
+inline double ChiStatistics::getProbability(int _resType, const double * _chis, bool _interpolate) {
+	if (!validResidueType(_resType)) {
+		std::cerr << "ERROR 4239 ChiStatistics::getProbability(int _resType, const double * _chis, bool _interpolate) no chi counts for residue type index " << _resType << std::endl;
+		return MslTools::doubleMax;
+	}
+	if (_interpolate) {
+		return grids[_resType].getInterpolatedProbability(_chis);
+	}
+	return grids[_resType].getProbability(_chis);
+}
+inline double ChiStatistics::getLogProbability(int _resType, const double * _chis, bool _interpolate) {
+	if (!validResidueType(_resType)) {
+		std::cerr << "ERROR 4239 ChiStatistics::getLogProbability(int _resType, const double * _chis, bool _interpolate) no chi counts for residue type index " << _resType << std::endl;
+		return MslTools::doubleMax;
+	}
+	if (_interpolate) {
+		return grids[_resType].getInterpolatedLogProbability(_chis);
+	}
+	return grids[_resType].getLogProbability(_chis);
+}
 }
 
 #endif
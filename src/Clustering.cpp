@@ -35,6 +35,7 @@ You should have received a copy of the GNU Lesser General Public
  */
 
 #include "Clustering.h"
+#include <limits>
 
 using namespace MSL;
 
@@ -54,6 +55,7 @@ Clustering::Clustering(){
   markFlag = false;
   nonMatchingValue = 0;
   noMatchFlag = false;
+  linkageElements = 0;
   RNG.setTimeBasedSeed();
   RNG.setRNGType("knuth2");
   cout << "\tRNG Type: "<<RNG.getRNGType()<<" Seed: "<<RNG.getSeed()<<endl;
@@ -66,6 +68,7 @@ Clustering::Clustering(vector<vector< double > > *_distMatrix,vector<string> *_l
    markFlag = false;
    nonMatchingValue = 0;
    noMatchFlag = false;
+   linkageElements = 0;
 
    RNG.setTimeBasedSeed();	
    RNG.setRNGType("knuth2");
@@ -80,6 +83,7 @@ Clustering::Clustering(vector<vector< double > > *_distMatrix){
    markFlag = false;
    nonMatchingValue = 0;
    markFlag = false;
+   linkageElements = 0;
 
    RNG.setTimeBasedSeed();
    RNG.setRNGType("knuth2");	
@@ -676,6 +680,251 @@ void Clustering::CompleteLinkage(){
    }
 }
 
+namespace {
+  bool linkageMergeCloser(const Clustering::LinkageMerge & _a, const Clustering::LinkageMerge & _b) {
+    return _a.distance < _b.distance;
+  }
+  unsigned int linkageRoot(vector<unsigned int> & _parent, unsigned int _i) {
+    unsigned int root = _i;
+    while (_parent[root] != root) root = _parent[root];
+    while (_parent[_i] != root) {
+      unsigned int next = _parent[_i];
+      _parent[_i] = root;
+      _i = next;
+    }
+    return root;
+  }
+}
+
+bool Clustering::SingleLinkage(const CondensedDistanceMatrix & _matrix){
+  unsigned int n = _matrix.size();
+  linkageMerges.clear();
+  linkageElements = n;
+  if (n < 2) return true;
+
+  // SLINK (Sibson 1973) builds the pointer representation of the tree
+  // adding one element at a time: pi is the last element the cluster of
+  // an element joins, at distance lambda.  The elements are added from
+  // the last one, so that the distances of a new element to those
+  // already in are a contiguous row of the matrix
+  const float * d = _matrix.getData();
+  double inf = numeric_limits<double>::infinity();
+  vector<unsigned int> pi(n);
+  vector<double> lambda(n);
+  vector<double> m(n);
+  pi[n-1] = n-1;
+  lambda[n-1] = inf;
+  for (unsigned int i = n-1; i-- > 0;) {
+    pi[i] = i;
+    lambda[i] = inf;
+    const float * row = d + _matrix.index(i, i+1);
+    for (unsigned int j = i+1; j < n; j++) {
+      m[j] = row[j-i-1];
+    }
+    for (unsigned int j = n-1; j > i; j--) {
+      unsigned int p = pi[j];
+      if (lambda[j] >= m[j]) {
+        m[p] = min(m[p], lambda[j]);
+        lambda[j] = m[j];
+        pi[j] = i;
+      } else {
+        m[p] = min(m[p], m[j]);
+      }
+    }
+    for (unsigned int j = n-1; j > i; j--) {
+      if (lambda[j] >= lambda[pi[j]]) pi[j] = i;
+    }
+  }
+
+  // every element but the first one (the last added) joins its pointer
+  vector<LinkageMerge> merges(n-1);
+  for (unsigned int j = 1; j < n; j++) {
+    merges[j-1].cluster1 = j;
+    merges[j-1].cluster2 = pi[j];
+    merges[j-1].distance = lambda[j];
+    merges[j-1].size = 0;
+  }
+  sortLinkageMerges(merges, n);
+  return true;
+}
+
+bool Clustering::AverageLinkage(CondensedDistanceMatrix & _matrix, bool _keepMatrix){
+  return nearestNeighborChain(_matrix, _keepMatrix, true);
+}
+
+bool Clustering::CompleteLinkage(CondensedDistanceMatrix & _matrix, bool _keepMatrix){
+  return nearestNeighborChain(_matrix, _keepMatrix, false);
+}
+
+bool Clustering::nearestNeighborChain(CondensedDistanceMatrix & _matrix, bool _keepMatrix, bool _average){
+  unsigned int n = _matrix.size();
+  linkageMerges.clear();
+  linkageElements = n;
+  if (n < 2) return true;
+
+  CondensedDistanceMatrix copy;
+  float * d = NULL;
+  if (_keepMatrix) {
+    copy = _matrix;
+    d = copy.getData();
+  } else {
+    if (!_matrix.isWritable()) {
+      cerr << "ERROR 78210: the distance matrix is mapped read only, cannot cluster it in place in bool Clustering::nearestNeighborChain(CondensedDistanceMatrix & _matrix, bool _keepMatrix, bool _average)" << endl;
+      return false;
+    }
+    d = _matrix.getData();
+  }
+
+  // Follow nearest neighbors from an active cluster until two clusters
+  // are each other's nearest neighbors, and merge them.  Average and
+  // complete linkage are reducible, so the rest of the chain stays valid
+  // and every cluster is pushed and popped once: O(n^2) overall.  The
+  // merged cluster takes the slot of the second one, whose distances
+  // are updated in place (Lance-Williams)
+  double inf = numeric_limits<double>::infinity();
+  vector<unsigned int> size(n, 1);
+  vector<char> active(n, 1);
+  vector<unsigned int> chain;
+  chain.reserve(n);
+  vector<LinkageMerge> merges;
+  merges.reserve(n-1);
+  unsigned int firstActive = 0;
+  while (merges.size() < n-1) {
+    if (chain.empty()) {
+      while (!active[firstActive]) firstActive++;
+      chain.push_back(firstActive);
+    }
+    unsigned int c = chain.back();
+    // ties go to the previous cluster of the chain, which keeps the chain from cycling
+    unsigned int best = n;
+    double bestDistance = inf;
+    if (chain.size() > 1) {
+      best = chain[chain.size()-2];
+      bestDistance = d[best < c ? _matrix.index(best, c) : _matrix.index(c, best)];
+    }
+    for (unsigned int k = 0; k < c; k++) {
+      if (active[k] && d[_matrix.index(k, c)] < bestDistance) {
+        best = k;
+        bestDistance = d[_matrix.index(k, c)];
+      }
+    }
+    if (c+1 < n) {
+      const float * row = d + _matrix.index(c, c+1);
+      for (unsigned int k = c+1; k < n; k++) {
+        if (active[k] && row[k-c-1] < bestDistance) {
+          best = k;
+          bestDistance = row[k-c-1];
+        }
+      }
+    }
+    if (chain.size() < 2 || best != chain[chain.size()-2]) {
+      chain.push_back(best);
+      continue;
+    }
+
+    chain.pop_back();
+    chain.pop_back();
+    unsigned int a = c;
+    unsigned int b = best;
+    for (unsigned int k = 0; k < n; k++) {
+      if (!active[k] || k == a || k == b) continue;
+      float & db = d[k < b ? _matrix.index(k, b) : _matrix.index(b, k)];
+      double da = d[k < a ? _matrix.index(k, a) : _matrix.index(a, k)];
+      db = _average ? avg(da, db, size[a], size[b]) : max(da, db);
+    }
+    active[a] = 0;
+    size[b] += size[a];
+
+    LinkageMerge merge;
+    merge.cluster1 = a;
+    merge.cluster2 = b;
+    merge.distance = bestDistance;
+    merge.size = 0;
+    merges.push_back(merge);
+  }
+  sortLinkageMerges(merges, n);
+  return true;
+}
+
+void Clustering::sortLinkageMerges(vector<LinkageMerge> & _slotMerges, unsigned int _nElements){
+  // the merges are given by any element of each cluster; sort them by
+  // distance and name the clusters they join
+  stable_sort(_slotMerges.begin(), _slotMerges.end(), linkageMergeCloser);
+  vector<unsigned int> parent(_nElements);
+  vector<unsigned int> clusterId(_nElements);
+  vector<unsigned int> clusterSize(_nElements, 1);
+  for (unsigned int i = 0; i < _nElements; i++) {
+    parent[i] = i;
+    clusterId[i] = i;
+  }
+  linkageMerges.resize(_slotMerges.size());
+  for (unsigned int k = 0; k < _slotMerges.size(); k++) {
+    unsigned int ra = linkageRoot(parent, _slotMerges[k].cluster1);
+    unsigned int rb = linkageRoot(parent, _slotMerges[k].cluster2);
+    LinkageMerge & merge = linkageMerges[k];
+    merge.cluster1 = clusterId[ra] < clusterId[rb] ? clusterId[ra] : clusterId[rb];
+    merge.cluster2 = clusterId[ra] < clusterId[rb] ? clusterId[rb] : clusterId[ra];
+    merge.distance = _slotMerges[k].distance;
+    merge.size = clusterSize[ra] + clusterSize[rb];
+    parent[ra] = rb;
+    clusterId[rb] = _nElements + k;
+    clusterSize[rb] = merge.size;
+  }
+}
+
+vector<unsigned int> Clustering::cutLinkageTree(unsigned int _nMerges) const{
+  // apply the first _nMerges merges and number the clusters by their first element
+  vector<unsigned int> parent(linkageElements + _nMerges);
+  for (unsigned int i = 0; i < parent.size(); i++) parent[i] = i;
+  for (unsigned int k = 0; k < _nMerges; k++) {
+    parent[linkageMerges[k].cluster1] = linkageElements + k;
+    parent[linkageMerges[k].cluster2] = linkageElements + k;
+  }
+  vector<unsigned int> clusters(linkageElements);
+  map<unsigned int, unsigned int> clusterNumber;
+  for (unsigned int i = 0; i < linkageElements; i++) {
+    unsigned int root = linkageRoot(parent, i);
+    map<unsigned int, unsigned int>::iterator found = clusterNumber.find(root);
+    if (found == clusterNumber.end()) {
+      found = clusterNumber.insert(pair<unsigned int, unsigned int>(root, clusterNumber.size())).first;
+    }
+    clusters[i] = found->second;
+  }
+  return clusters;
+}
+
+vector<unsigned int> Clustering::getLinkageClusters(double _cutoff) const{
+  unsigned int nMerges = 0;
+  while (nMerges < linkageMerges.size() && linkageMerges[nMerges].distance <= _cutoff) nMerges++;
+  return cutLinkageTree(nMerges);
+}
+
+vector<unsigned int> Clustering::getLinkageClustersByNumber(unsigned int _nClusters) const{
+  if (_nClusters == 0) _nClusters = 1;
+  return cutLinkageTree(_nClusters >= linkageElements ? 0 : linkageElements - _nClusters);
+}
+
+void Clustering::printLinkageClusters(double _cutoff) const{
+  vector<unsigned int> clusters = getLinkageClusters(_cutoff);
+  unsigned int numClusters = 0;
+  for (unsigned int m = 0; m < clusters.size(); m++) {
+    if (clusters[m] + 1 > numClusters) numClusters = clusters[m] + 1;
+  }
+  vector<vector<unsigned int> > members(numClusters);
+  for (unsigned int m = 0; m < clusters.size(); m++) {
+    members[clusters[m]].push_back(m);
+  }
+  cout << "\nNumber of clusters: " << numClusters << "\tAt cutoff: " << _cutoff << endl;
+  for (unsigned int k = 0; k < numClusters; k++) {
+    cout << "Cluster number " << k << endl;
+    for (unsigned int m = 0; m < members[k].size(); m++) {
+      cout << "\t" << members[k][m];
+      if (elementLabels != NULL) cout << " " << (*elementLabels)[members[k][m]];
+      cout << endl;
+    }
+  }
+}
+
 void Clustering::generateRandomClusters(vector<int> *assignments){
 
   if (clusterFlag.size() != nClusters){
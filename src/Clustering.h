@@ -51,6 +51,7 @@ You should have received a copy of the GNU Lesser General Public
 #include <map>
 #include <vector>
 #include "RandomNumberGenerator.h"
+#include "CondensedDistanceMatrix.h"
 using namespace std;
 
 namespace MSL { 
@@ -70,6 +71,36 @@ class Clustering {
   void   CenterLinkage();
   void   CompleteLinkage();
 
+  /***************************************************************
+   *  Hierarchical clustering of a CondensedDistanceMatrix in
+   *  O(n^2) time.  SingleLinkage runs SLINK and only reads the
+   *  matrix.  AverageLinkage and CompleteLinkage follow the
+   *  nearest-neighbor chain and overwrite the matrix with the
+   *  linkage distances, so they work on a copy unless
+   *  _keepMatrix is false (use false with large or mapped
+   *  matrices, which must then be writable).
+   *
+   *  Nothing is printed: the result is the dendrogram, one merge
+   *  per step in order of increasing distance.  The elements are
+   *  clusters 0..n-1 and merge k creates cluster n+k
+   ***************************************************************/
+  struct LinkageMerge {
+    unsigned int cluster1; // the smaller id
+    unsigned int cluster2;
+    double       distance;
+    unsigned int size;     // number of elements in the new cluster
+  };
+  bool   SingleLinkage(const CondensedDistanceMatrix & _matrix);
+  bool   AverageLinkage(CondensedDistanceMatrix & _matrix, bool _keepMatrix=true);
+  bool   CompleteLinkage(CondensedDistanceMatrix & _matrix, bool _keepMatrix=true);
+
+  const vector<LinkageMerge> & getLinkageMerges() const { return linkageMerges; }
+  // cluster index (0..k-1, by first element) of each element, cutting the dendrogram
+  // above _cutoff or where it has _nClusters clusters
+  vector<unsigned int> getLinkageClusters(double _cutoff) const;
+  vector<unsigned int> getLinkageClustersByNumber(unsigned int _nClusters) const;
+  void   printLinkageClusters(double _cutoff) const;
+
   void   printClusters();
   void   printClusters(double numSTDs);
   double getStatistics(); // return max variance across clusters
@@ -84,6 +115,7 @@ class Clustering {
   void setClustersFrozen(double _maxValue, double _sizePercent);   
   void setElementsFrozen();   
   void setClustersFlag(string _flag);
+  void setElementLabels(vector<string> *_labels) { elementLabels = _labels; }
  private:
 
   void   generateRandomClusters(vector<int> *clusterAssignments);
@@ -93,6 +125,10 @@ class Clustering {
   double min(double i, double j);
   double avg(double i, double j, uint k, uint m);
 
+  bool   nearestNeighborChain(CondensedDistanceMatrix & _matrix, bool _keepMatrix, bool _average);
+  void   sortLinkageMerges(vector<LinkageMerge> & _slotMerges, unsigned int _nElements);
+  vector<unsigned int> cutLinkageTree(unsigned int _nMerges) const;
+
   vector<vector< double > > *distMatrix;
   vector<string>            *elementLabels;
 
@@ -101,6 +137,10 @@ class Clustering {
   vector<int>                centroids;
   vector<int>                clusterAssignments;
 
+  // Variables for the condensed matrix linkages
+  vector<LinkageMerge>       linkageMerges;
+  unsigned int               linkageElements;
+
   RandomNumberGenerator RNG;
 
   struct stats {
@@ -0,0 +1,219 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "CondensedDistanceMatrix.h"
+#include "OptimalRMSDCalculator.h"
+#include <iostream>
+#include <cstring>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace MSL;
+using namespace std;
+
+namespace {
+	const char CDM_TAG[8] = {'M', 'S', 'L', 'C', 'D', 'M', '1', '\0'};
+	const size_t CDM_HEADER = 16; // the tag and the number of elements, keeps the floats aligned
+}
+
+CondensedDistanceMatrix::CondensedDistanceMatrix() {
+	n = 0;
+	pValues = NULL;
+	pMap = NULL;
+	mapSize = 0;
+	writable = true;
+}
+
+CondensedDistanceMatrix::CondensedDistanceMatrix(unsigned int _n) {
+	n = 0;
+	pValues = NULL;
+	pMap = NULL;
+	mapSize = 0;
+	writable = true;
+	resize(_n);
+}
+
+CondensedDistanceMatrix::CondensedDistanceMatrix(const CondensedDistanceMatrix & _matrix) {
+	n = 0;
+	pValues = NULL;
+	pMap = NULL;
+	mapSize = 0;
+	writable = true;
+	operator=(_matrix);
+}
+
+CondensedDistanceMatrix::~CondensedDistanceMatrix() {
+	clear();
+}
+
+void CondensedDistanceMatrix::operator=(const CondensedDistanceMatrix & _matrix) {
+	if (&_matrix == this) {
+		return;
+	}
+	clear();
+	n = _matrix.n;
+	if (_matrix.pValues != NULL) {
+		values.assign(_matrix.pValues, _matrix.pValues + _matrix.getNumberOfValues());
+	}
+	pValues = values.empty() ? NULL : &values[0];
+}
+
+void CondensedDistanceMatrix::clear() {
+	if (pMap != NULL) {
+		munmap(pMap, mapSize);
+		pMap = NULL;
+		mapSize = 0;
+	}
+	vector<float>().swap(values);
+	pValues = NULL;
+	n = 0;
+	writable = true;
+}
+
+void CondensedDistanceMatrix::setup(unsigned int _n) {
+	clear();
+	n = _n;
+	values.assign(getNumberOfValues(), 0.0f);
+	pValues = values.empty() ? NULL : &values[0];
+}
+
+void CondensedDistanceMatrix::resize(unsigned int _n) {
+	setup(_n);
+}
+
+bool CondensedDistanceMatrix::createMapped(string _filename, unsigned int _n) {
+	return mapFile(_filename, _n, true, true);
+}
+
+bool CondensedDistanceMatrix::openMapped(string _filename, bool _writable) {
+	return mapFile(_filename, 0, false, _writable);
+}
+
+bool CondensedDistanceMatrix::mapFile(string _filename, unsigned int _n, bool _create, bool _writable) {
+	clear();
+	int fd = _create ? open(_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(_filename.c_str(), _writable ? O_RDWR : O_RDONLY);
+	if (fd < 0) {
+		cerr << "ERROR 78201: cannot open the distance matrix file " << _filename << " in bool CondensedDistanceMatrix::mapFile(string _filename, unsigned int _n, bool _create, bool _writable)" << endl;
+		return false;
+	}
+	char tag[8];
+	uint64_t elements = _n;
+	if (_create) {
+		n = _n;
+		memcpy(tag, CDM_TAG, 8);
+		if (ftruncate(fd, CDM_HEADER + getNumberOfValues() * sizeof(float)) != 0 || pwrite(fd, tag, 8, 0) != 8 || pwrite(fd, &elements, 8, 8) != 8) {
+			cerr << "ERROR 78202: cannot write the distance matrix file " << _filename << " in bool CondensedDistanceMatrix::mapFile(string _filename, unsigned int _n, bool _create, bool _writable)" << endl;
+			close(fd);
+			n = 0;
+			return false;
+		}
+	} else {
+		struct stat info;
+		if (pread(fd, tag, 8, 0) != 8 || pread(fd, &elements, 8, 8) != 8 || memcmp(tag, CDM_TAG, 8) != 0 || fstat(fd, &info) != 0 || elements > 0xffffffffULL) {
+			cerr << "ERROR 78203: " << _filename << " is not a distance matrix file in bool CondensedDistanceMatrix::mapFile(string _filename, unsigned int _n, bool _create, bool _writable)" << endl;
+			close(fd);
+			return false;
+		}
+		n = (unsigned int)elements;
+		if ((size_t)info.st_size < CDM_HEADER + getNumberOfValues() * sizeof(float)) {
+			cerr << "ERROR 78204: the distance matrix file " << _filename << " is truncated in bool CondensedDistanceMatrix::mapFile(string _filename, unsigned int _n, bool _create, bool _writable)" << endl;
+			close(fd);
+			n = 0;
+			return false;
+		}
+	}
+	mapSize = CDM_HEADER + getNumberOfValues() * sizeof(float);
+	void * pData = mmap(NULL, mapSize, _writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (pData == MAP_FAILED) {
+		cerr << "ERROR 78205: cannot memory map the distance matrix file " << _filename << " in bool CondensedDistanceMatrix::mapFile(string _filename, unsigned int _n, bool _create, bool _writable)" << endl;
+		n = 0;
+		mapSize = 0;
+		return false;
+	}
+	pMap = pData;
+	pValues = (float*)((char*)pMap + CDM_HEADER);
+	writable = _writable;
+	return true;
+}
+
+void CondensedDistanceMatrix::fromMatrix(const vector<vector<double> > & _matrix) {
+	setup(_matrix.size());
+	for (unsigned int i=0; i<n; i++) {
+		for (unsigned int j=0; j<i; j++) {
+			pValues[index(j, i)] = _matrix[i][j];
+		}
+	}
+}
+
+bool CondensedDistanceMatrix::fillFromRMSD(const vector<AtomPointerVector*> & _structures, unsigned int _threads) {
+	unsigned int nAtoms = _structures.empty() ? 0 : _structures[0]->size();
+	vector<float> coor;
+	coor.reserve((size_t)_structures.size() * 3 * nAtoms);
+	for (unsigned int i=0; i<_structures.size(); i++) {
+		if (_structures[i]->size() != nAtoms) {
+			cerr << "ERROR 78206: structure " << i << " has " << _structures[i]->size() << " atoms instead of " << nAtoms << " in bool CondensedDistanceMatrix::fillFromRMSD(const vector<AtomPointerVector*> & _structures, unsigned int _threads)" << endl;
+			return false;
+		}
+		for (unsigned int j=0; j<nAtoms; j++) {
+			const CartesianPoint & p = (*_structures[i])[j]->getCoor();
+			coor.push_back(p.getX());
+			coor.push_back(p.getY());
+			coor.push_back(p.getZ());
+		}
+	}
+	if (nAtoms == 0) {
+		setup(_structures.size());
+		return true;
+	}
+	return fillFromRMSD(coor, nAtoms, _threads);
+}
+
+bool CondensedDistanceMatrix::fillFromRMSD(const vector<float> & _coor, unsigned int _nAtoms, unsigned int _threads) {
+	if (_nAtoms == 0 || _coor.size() % (3 * _nAtoms) != 0) {
+		cerr << "ERROR 78207: the coordinates are not a whole number of structures of " << _nAtoms << " atoms in bool CondensedDistanceMatrix::fillFromRMSD(const vector<float> & _coor, unsigned int _nAtoms, unsigned int _threads)" << endl;
+		return false;
+	}
+	unsigned int structures = _coor.size() / (3 * _nAtoms);
+	if (pMap == NULL || n != structures) {
+		setup(structures);
+	} else if (!writable) {
+		cerr << "ERROR 78208: the distance matrix is mapped read only in bool CondensedDistanceMatrix::fillFromRMSD(const vector<float> & _coor, unsigned int _nAtoms, unsigned int _threads)" << endl;
+		return false;
+	}
+	if (n > 1) {
+		OptimalRMSDCalculator calc;
+		calc.setNumberOfThreads(_threads);
+		calc.manyVsMany(&_coor[0], n, _nAtoms, pValues);
+	}
+	return true;
+}
@@ -0,0 +1,124 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef CONDENSED_DISTANCE_MATRIX_H_
+#define CONDENSED_DISTANCE_MATRIX_H_
+
+#include <vector>
+#include <string>
+#include "AtomPointerVector.h"
+using namespace std;
+
+namespace MSL {
+
+/***************************************************************
+ *  Symmetric distance matrix of n elements stored as its upper
+ *  triangle, row by row, in n*(n-1)/2 floats (the layout of
+ *  OptimalRMSDCalculator::condensedIndex).  The values are kept
+ *  in memory or in a memory mapped file, so that matrices larger
+ *  than the RAM can be built once and clustered many times.
+ *
+ *  File layout: an 8 byte tag ("MSLCDM1"), the number of
+ *  elements as a 64 bit integer, then the floats
+ ***************************************************************/
+class CondensedDistanceMatrix {
+
+ public:
+	CondensedDistanceMatrix();
+	CondensedDistanceMatrix(unsigned int _n); // in memory, all values zero
+	CondensedDistanceMatrix(const CondensedDistanceMatrix & _matrix); // the copy is always in memory
+	~CondensedDistanceMatrix();
+
+	void operator=(const CondensedDistanceMatrix & _matrix);
+
+	void resize(unsigned int _n); // in memory, all values zero
+	bool createMapped(string _filename, unsigned int _n); // new file, all values zero, writable
+	bool openMapped(string _filename, bool _writable = false);
+	void clear();
+
+	unsigned int size() const;
+	size_t getNumberOfValues() const;
+	bool isMapped() const;
+	bool isWritable() const;
+
+	float getValue(unsigned int _i, unsigned int _j) const; // zero on the diagonal
+	void setValue(unsigned int _i, unsigned int _j, float _value);
+	float * getData();
+	const float * getData() const;
+	size_t index(unsigned int _i, unsigned int _j) const; // _i < _j
+
+	// the lower triangle of a square matrix, as read by the Clustering linkages
+	void fromMatrix(const vector<vector<double> > & _matrix);
+
+	/***************************************************************
+	 *  RMSD upon optimal superposition of all pairs of structures
+	 *  (QCP, see OptimalRMSDCalculator::manyVsMany), split among
+	 *  _threads threads.  The structures are packed in floats; the
+	 *  matrix is resized in memory unless it is already mapped
+	 *  with the right size.  Fails if the atom counts differ
+	 ***************************************************************/
+	bool fillFromRMSD(const vector<AtomPointerVector*> & _structures, unsigned int _threads = 1);
+	bool fillFromRMSD(const vector<float> & _coor, unsigned int _nAtoms, unsigned int _threads = 1);
+
+ private:
+	bool mapFile(string _filename, unsigned int _n, bool _create, bool _writable);
+	void setup(unsigned int _n);
+
+	unsigned int n;
+	vector<float> values;
+	float * pValues;
+	void * pMap;
+	size_t mapSize;
+	bool writable;
+};
+
+inline unsigned int CondensedDistanceMatrix::size() const { return n; }
+inline size_t CondensedDistanceMatrix::getNumberOfValues() const { return n < 2 ? 0 : (size_t)n * (n - 1) / 2; }
+inline bool CondensedDistanceMatrix::isMapped() const { return pMap != NULL; }
+inline bool CondensedDistanceMatrix::isWritable() const { return writable; }
+inline size_t CondensedDistanceMatrix::index(unsigned int _i, unsigned int _j) const {
+	return (size_t)_i * n - (size_t)_i * (_i + 1) / 2 + (_j - _i - 1);
+}
+inline float CondensedDistanceMatrix::getValue(unsigned int _i, unsigned int _j) const {
+	if (_i == _j) {
+		return 0.0f;
+	}
+	return _i < _j ? pValues[index(_i, _j)] : pValues[index(_j, _i)];
+}
+inline void CondensedDistanceMatrix::setValue(unsigned int _i, unsigned int _j, float _value) {
+	if (_i != _j) {
+		pValues[_i < _j ? index(_i, _j) : index(_j, _i)] = _value;
+	}
+}
+inline float * CondensedDistanceMatrix::getData() { return pValues; }
+inline const float * CondensedDistanceMatrix::getData() const { return pValues; }
+
+}
+
+#endif // CONDENSED_DISTANCE_MATRIX_H_
@@ -47,9 +47,13 @@ DeadEndElimination::DeadEndElimination(vector<vector<double> > & _selfEnergies,
 	setEnergyTables(&_selfEnergies, &_pairEnergies, &_baselines);
 }
 
+DeadEndElimination::DeadEndElimination(EnergyTable & _table) {
+	setInitialVariables();
+	setEnergyTable(&_table);
+}
+
 void DeadEndElimination::setInitialVariables() {
-	selfEnergy = NULL;
-	pairEnergy = NULL;
+	pTable = NULL;
 	pBaseLines = NULL;
 	verboseLevel = 1;
 	setVerbose(true, 1); // default low level verbose mode
@@ -250,16 +254,35 @@ void DeadEndElimination::setEnergyTables(vector<vector<double> > * _selfEnergyne
 	*/
 
 	/*******************************************************
-	 *  ASSIGN THE POINTERS
+	 *  COPY INTO THE FLAT TABLE (SPARSE, THE PAIRS OF
+	 *  POSITIONS WITH ALL ZERO ENERGIES ARE NOT STORED)
 	 *******************************************************/
-	selfEnergy = _selfEnergynergies;
-	pairEnergy = _pairEnergynergies;
+	ownedTable.setTables(*_selfEnergynergies, *_pairEnergynergies, false, true);
+	responsibleForEnergyTableMemory = true;
+	pTable = &ownedTable;
+	pBaseLines = NULL;
 	if (_pBaselines != NULL) {
 		setBaselines(_pBaselines);
 	}
 	initializeMask();
 }
 
+void DeadEndElimination::setEnergyTable(EnergyTable * _pTable) {
+	if (_pTable == NULL) {
+		cerr << "ERROR 3816: null pointer for the energy table in void DeadEndElimination::setEnergyTable(EnergyTable * _pTable)" << endl;
+		exit(3816);
+	}
+	if (_pTable->getNumberOfPositions() == 0) {
+		cerr << "ERROR 3820: the energy table has zero size in void DeadEndElimination::setEnergyTable(EnergyTable * _pTable)" << endl;
+		exit(3820);
+	}
+	ownedTable.clear();
+	responsibleForEnergyTableMemory = false;
+	pTable = _pTable;
+	pBaseLines = NULL;
+	initializeMask();
+}
+
 void DeadEndElimination::setBaselines(vector<vector<double> > & _baselines) {
 	setBaselines(&_baselines);
 }
@@ -271,13 +294,13 @@ void DeadEndElimination::setBaselines(vector<vector<double> > * _pBaselines) {
 	}
 
 	// baseline and self sizes should match
-	if (_pBaselines->size() != selfEnergy->size()) {
-		cerr << "ERROR 3840: the baseline table (" << _pBaselines->size() << ") has different size than the selfEnergy table (" << selfEnergy->size() << ") at void DeadEndElimination::setBaselines(vector<vector<double> > * _pBaselines)" << endl;
+	if (_pBaselines->size() != pTable->getNumberOfPositions()) {
+		cerr << "ERROR 3840: the baseline table (" << _pBaselines->size() << ") has different size than the selfEnergy table (" << pTable->getNumberOfPositions() << ") at void DeadEndElimination::setBaselines(vector<vector<double> > * _pBaselines)" << endl;
 		exit(3840);
 	}
-	for (int i=0; i<selfEnergy->size(); i++) {
-		if ((*selfEnergy)[i].size() != (*_pBaselines)[i].size()) {
-			cerr << "ERROR 3844: at position " << i << " the baseline table (" << (*_pBaselines)[i].size() << ") has different size than the selfEnergy table (" << (*selfEnergy)[i].size() << ") at void DeadEndElimination::setBaselines(vector<vector<double> > * _pBaselines)" << endl;
+	for (int i=0; i<pTable->getNumberOfPositions(); i++) {
+		if (pTable->getNumberOfRotamers(i) != (*_pBaselines)[i].size()) {
+			cerr << "ERROR 3844: at position " << i << " the baseline table (" << (*_pBaselines)[i].size() << ") has different size than the selfEnergy table (" << pTable->getNumberOfRotamers(i) << ") at void DeadEndElimination::setBaselines(vector<vector<double> > * _pBaselines)" << endl;
 			exit(3844);
 		}
 	}
@@ -290,18 +313,18 @@ void DeadEndElimination::setBaselines(vector<vector<double> > * _pBaselines) {
 
 void DeadEndElimination::initializeMask() {
 	alive.clear();
-	for (unsigned int ip=0; ip<selfEnergy->size(); ip++) {
-		unsigned int ir = (*selfEnergy)[ip].size();
+	for (unsigned int ip=0; ip<pTable->getNumberOfPositions(); ip++) {
+		unsigned int ir = pTable->getNumberOfRotamers(ip);
 		alive.push_back(vector<bool>(ir, true));
 	}
 	flaggedPair.clear();
-	for (unsigned int ip=0; ip<pairEnergy->size(); ip++) {
+	for (unsigned int ip=0; ip<pTable->getNumberOfPositions(); ip++) {
 		flaggedPair.push_back(vector<vector<vector<bool> > >());
-		for (unsigned int ir=0; ir<(*pairEnergy)[ip].size(); ir++) {
+		for (unsigned int ir=0; ir<pTable->getNumberOfRotamers(ip); ir++) {
 			flaggedPair[ip].push_back(vector<vector<bool> >());
-			for (unsigned int jp=0; jp<(*pairEnergy)[ip][ir].size(); jp++) {
+			for (unsigned int jp=0; jp<ip; jp++) {
 				flaggedPair[ip][ir].push_back(vector<bool>());
-				for (unsigned int jr=0; jr<(*pairEnergy)[ip][ir][jp].size(); jr++) {
+				for (unsigned int jr=0; jr<pTable->getNumberOfRotamers(jp); jr++) {
 					flaggedPair[ip][ir][jp].push_back(false);
 				}
 			}
@@ -327,14 +350,14 @@ bool DeadEndElimination::runSimpleGoldsteinSingles() {
 	while(true) {
 		bool eliminatedSomething = false;
 		// for each position...
-		for (unsigned int posI=0; posI<pairEnergy->size(); posI++) {
+		for (unsigned int posI=0; posI<pTable->getNumberOfPositions(); posI++) {
 			// ... for each rotamer at the position...
-			for (unsigned int rotR=0; rotR<(*pairEnergy)[posI].size(); rotR++) {
+			for (unsigned int rotR=0; rotR<pTable->getNumberOfRotamers(posI); rotR++) {
 				if (!alive[posI][rotR]) {
 					// eliminated already
 					continue;
 				}
-				for (unsigned int rotT=rotR+1; rotT<(*pairEnergy)[posI].size(); rotT++) {
+				for (unsigned int rotT=rotR+1; rotT<pTable->getNumberOfRotamers(posI); rotT++) {
 					// ... for each other rotamer at the position...
 					if (!alive[posI][rotT]) {
 						continue;
@@ -388,7 +411,7 @@ bool DeadEndElimination::simpleGoldsteinSinglesIteration(unsigned int _posI, uns
 	}
 	//cout << "UUU DEE 2" << endl;
 	// add the self energies
-	double Er = (*selfEnergy)[_posI][_rotR] - (*selfEnergy)[_posI][_rotT];
+	double Er = pTable->getSelfEnergy(_posI, _rotR) - pTable->getSelfEnergy(_posI, _rotT);
 	//cout << "UUU DEE 3" << endl;
 	// possibly add the baselines
 	//cout << "UUU DEE 4" << endl;
@@ -406,7 +429,7 @@ bool DeadEndElimination::simpleGoldsteinSinglesIteration(unsigned int _posI, uns
 	if (afterPair_flag) {	
 	
 		// for all other positions
-		for (unsigned int posJ=0; posJ<pairEnergy->size(); posJ++) {
+		for (unsigned int posJ=0; posJ<pTable->getNumberOfPositions(); posJ++) {
 			double min = 0.0;
 			double max = 0.0;
 			//bool found = false;
@@ -436,14 +459,12 @@ bool DeadEndElimination::simpleGoldsteinSinglesIteration(unsigned int _posI, uns
 		}
 	} else {
 
-		// for all other positions
-		for (unsigned int posJ=0; posJ<pairEnergy->size(); posJ++) {
+		// for all other positions (only the neighbors stored in the table interact)
+		const vector<unsigned int> & neighbors = pTable->getNeighbors(_posI);
+		for (unsigned int n=0; n<neighbors.size(); n++) {
+			unsigned int posJ = neighbors[n];
 			double min = 0.0;
 			double max = 0.0;
-			//bool found = false;
-			if (posJ==_posI) {
-				continue;
-			}
 			minDiffIrItJuSingle(_posI, _rotR, _rotT, posJ, min, max);
 			Er += min;
 			Et -= max;
@@ -488,9 +509,9 @@ void DeadEndElimination::minDiffIrItJuSingle(unsigned int _posI, unsigned int _r
 	bool found = false;
 	// the table of pair energies (with N positions) is the half of the matrix with I = 0 -> N and J = 0 -> (I-1)
 	if (_posI > _posJ) {
-		for (unsigned int rotJ=0; rotJ<(*pairEnergy)[_posI][_rotR][_posJ].size(); rotJ++) {
+		for (unsigned int rotJ=0; rotJ<pTable->getNumberOfRotamers(_posJ); rotJ++) {
 			if (alive[_posJ][rotJ]) {
-				double diff = (*pairEnergy)[_posI][_rotR][_posJ][rotJ] - (*pairEnergy)[_posI][_rotT][_posJ][rotJ];
+				double diff = pTable->getPairEnergy(_posI, _rotR, _posJ, rotJ) - pTable->getPairEnergy(_posI, _rotT, _posJ, rotJ);
 				if (!found) {
 					found = true;
 					_min = diff;
@@ -506,9 +527,9 @@ void DeadEndElimination::minDiffIrItJuSingle(unsigned int _posI, unsigned int _r
 			}
 		}
 	} else {
-		for (unsigned int rotJ=0; rotJ<(*pairEnergy)[_posJ].size(); rotJ++) {
+		for (unsigned int rotJ=0; rotJ<pTable->getNumberOfRotamers(_posJ); rotJ++) {
 			if (alive[_posJ][rotJ]) {
-				double diff = (*pairEnergy)[_posJ][rotJ][_posI][_rotR] - (*pairEnergy)[_posJ][rotJ][_posI][_rotT];
+				double diff = pTable->getPairEnergy(_posJ, rotJ, _posI, _rotR) - pTable->getPairEnergy(_posJ, rotJ, _posI, _rotT);
 				if (!found) {
 					found = true;
 					_min = diff;
@@ -548,7 +569,7 @@ void DeadEndElimination::minDiffIrItJuSingleAfterPair(unsigned int _posI, unsign
 	// the table of pair energies (with N positions) is the half of the matrix with I = 0 -> N and J = 0 -> (I-1)
 	if (_posI > _posJ) {
 		// if all R (or T) pairs with J rotamers are flagged, eliminate R (or T)
-		for (unsigned int rotJ=0; rotJ<(*pairEnergy)[_posI][_rotR][_posJ].size(); rotJ++) {
+		for (unsigned int rotJ=0; rotJ<pTable->getNumberOfRotamers(_posJ); rotJ++) {
 			if (!alive[_posJ][rotJ]) {
 				continue;
 			}
@@ -568,9 +589,9 @@ void DeadEndElimination::minDiffIrItJuSingleAfterPair(unsigned int _posI, unsign
 		if (_eliminateR || _eliminateT) {
 			return;
 		}
-		for (unsigned int rotJ=0; rotJ<(*pairEnergy)[_posI][_rotR][_posJ].size(); rotJ++) {
+		for (unsigned int rotJ=0; rotJ<pTable->getNumberOfRotamers(_posJ); rotJ++) {
 			if (alive[_posJ][rotJ]) {
-				double diff = (*pairEnergy)[_posI][_rotR][_posJ][rotJ] - (*pairEnergy)[_posI][_rotT][_posJ][rotJ];
+				double diff = pTable->getPairEnergy(_posI, _rotR, _posJ, rotJ) - pTable->getPairEnergy(_posI, _rotT, _posJ, rotJ);
 				if (!found) {
 					found = true;
 					_min = diff;
@@ -586,7 +607,7 @@ void DeadEndElimination::minDiffIrItJuSingleAfterPair(unsigned int _posI, unsign
 			}
 		}
 	} else {
-		for (unsigned int rotJ=0; rotJ<(*pairEnergy)[_posJ].size(); rotJ++) {
+		for (unsigned int rotJ=0; rotJ<pTable->getNumberOfRotamers(_posJ); rotJ++) {
 			if (!alive[_posJ][rotJ]) {
 				continue;
 			}
@@ -606,9 +627,9 @@ void DeadEndElimination::minDiffIrItJuSingleAfterPair(unsigned int _posI, unsign
 		if (_eliminateR || _eliminateT) {
 			return;
 		}
-		for (unsigned int rotJ=0; rotJ<(*pairEnergy)[_posJ].size(); rotJ++) {
+		for (unsigned int rotJ=0; rotJ<pTable->getNumberOfRotamers(_posJ); rotJ++) {
 			if (alive[_posJ][rotJ]) {
-				double diff = (*pairEnergy)[_posJ][rotJ][_posI][_rotR] - (*pairEnergy)[_posJ][rotJ][_posI][_rotT];
+				double diff = pTable->getPairEnergy(_posJ, rotJ, _posI, _rotR) - pTable->getPairEnergy(_posJ, rotJ, _posI, _rotT);
 				if (!found) {
 					found = true;
 					_min = diff;
@@ -661,25 +682,25 @@ unsigned int DeadEndElimination::runSimpleGoldsteinPairsOnce() {
 
 	unsigned int flagged = flaggedCounter; // subtract from flaggedCounter at the end to get number of pairs flagged in this iteration
 
-	for (unsigned int posI1=0; posI1<pairEnergy->size(); posI1++) {
+	for (unsigned int posI1=0; posI1<pTable->getNumberOfPositions(); posI1++) {
 		for (unsigned int posI2=0; posI2<posI1; posI2++) {
 			// ... for each pair of rotamers at the position...
-			for (unsigned int rotR1=0; rotR1<(*pairEnergy)[posI1].size(); rotR1++) {
+			for (unsigned int rotR1=0; rotR1<pTable->getNumberOfRotamers(posI1); rotR1++) {
 				if (!alive[posI1][rotR1]) {
 					// eliminated already
 					continue;
 				}
-				for (unsigned int rotR2=0; rotR2<(*pairEnergy)[posI1][rotR1][posI2].size(); rotR2++) {
+				for (unsigned int rotR2=0; rotR2<pTable->getNumberOfRotamers(posI2); rotR2++) {
 					if (flaggedPair[posI1][rotR1][posI2][rotR2] || !alive[posI2][rotR2]) {
 						// eliminated already
 						continue;
 					}
 					// ... for each other pair of rotamers at the position...
-					for (unsigned int rotT1=0; rotT1<(*pairEnergy)[posI1].size(); rotT1++) {
+					for (unsigned int rotT1=0; rotT1<pTable->getNumberOfRotamers(posI1); rotT1++) {
 						if (!alive[posI1][rotT1]) {
 							continue;
 						}
-						for (unsigned int rotT2=0; rotT2<(*pairEnergy)[posI1][rotR1][posI2].size(); rotT2++) {
+						for (unsigned int rotT2=0; rotT2<pTable->getNumberOfRotamers(posI2); rotT2++) {
 							if (flaggedPair[posI1][rotR1][posI2][rotR2] || flaggedPair[posI1][rotT1][posI2][rotT2] || !alive[posI2][rotT2] || (rotR1 == rotT1 && rotR2 == rotT2)) {
 								continue;
 							}
@@ -735,8 +756,8 @@ bool DeadEndElimination::simpleGoldsteinPairIteration(unsigned int _posI1, unsig
 	 *  
 	 ********************************************/
 	// add th self energies
-	double Er = (*selfEnergy)[_posI1][_rotR1] + (*selfEnergy)[_posI2][_rotR2] - (*selfEnergy)[_posI1][_rotT1] - (*selfEnergy)[_posI2][_rotT2];
-	//cout << (*selfEnergy)[_posI1][_rotR1] << " " << (*selfEnergy)[_posI2][_rotR2] << " " << (*selfEnergy)[_posI1][_rotT1] << " " << (*selfEnergy)[_posI2][_rotT2] << endl;
+	double Er = pTable->getSelfEnergy(_posI1, _rotR1) + pTable->getSelfEnergy(_posI2, _rotR2) - pTable->getSelfEnergy(_posI1, _rotT1) - pTable->getSelfEnergy(_posI2, _rotT2);
+	//cout << pTable->getSelfEnergy(_posI1, _rotR1) << " " << pTable->getSelfEnergy(_posI2, _rotR2) << " " << pTable->getSelfEnergy(_posI1, _rotT1) << " " << pTable->getSelfEnergy(_posI2, _rotT2) << endl;
 
 	// possibly add the baselines
 	if (pBaseLines != NULL) {
@@ -744,19 +765,23 @@ bool DeadEndElimination::simpleGoldsteinPairIteration(unsigned int _posI1, unsig
 	}
 
 	// add the pair interactions of the R and T pairs
-	Er += (*pairEnergy)[_posI1][_rotR1][_posI2][_rotR2] - (*pairEnergy)[_posI1][_rotT1][_posI2][_rotT2];
-	//cout << (*pairEnergy)[_posI1][_rotR1][_posI2][_rotR2] << " " << (*pairEnergy)[_posI1][_rotT1][_posI2][_rotT2] << endl;
+	Er += pTable->getPairEnergy(_posI1, _rotR1, _posI2, _rotR2) - pTable->getPairEnergy(_posI1, _rotT1, _posI2, _rotT2);
+	//cout << pTable->getPairEnergy(_posI1, _rotR1, _posI2, _rotR2) << " " << pTable->getPairEnergy(_posI1, _rotT1, _posI2, _rotT2) << endl;
 	double Et = -Er;
 
 //DEE SGP: pair pos/rot-pos/rot 10/2-6/1 flagged for elimination by 10/6-6/30
 	
 	// for all other positions
-	for (unsigned int posJ=0; posJ<pairEnergy->size(); posJ++) {
+	for (unsigned int posJ=0; posJ<pTable->getNumberOfPositions(); posJ++) {
 		double min = 0.0;
 		double max = 0.0;
 		if (posJ==_posI1 || posJ==_posI2) {
 			continue;
 		}
+		if (!pTable->isPairStored(_posI1, posJ) && !pTable->isPairStored(_posI2, posJ)) {
+			// no interaction with either position
+			continue;
+		}
 
 		minDiffIrItJuDouble(_posI1, _rotR1, _rotT1, _posI2, _rotR2, _rotT2, posJ, min, max);
 		//cout << Er << " " << _posI1 << " " <<  _rotR1 << " " <<  _rotT1 << " " << _posI2 << " " << _rotR2 << " " <<  _rotT2 << " " << posJ << " " << min << " " << max << endl;
@@ -808,8 +833,8 @@ void DeadEndElimination::minDiffIrItJuDouble(unsigned int _posI1, unsigned int _
 	bool found = false;
 	// the table of pair energies (with N positions) is the half of the matrix with I = 0 -> N and J = 0 -> (I-1)
 	if (_posI2 > _posJ) {
-		for (unsigned int jr=0; jr<(*pairEnergy)[_posI1][_rotR1][_posJ].size(); jr++) {
-			double diff = (*pairEnergy)[_posI1][_rotR1][_posJ][jr] + (*pairEnergy)[_posI2][_rotR2][_posJ][jr] - (*pairEnergy)[_posI1][_rotT1][_posJ][jr] - (*pairEnergy)[_posI2][_rotT2][_posJ][jr];
+		for (unsigned int jr=0; jr<pTable->getNumberOfRotamers(_posJ); jr++) {
+			double diff = pTable->getPairEnergy(_posI1, _rotR1, _posJ, jr) + pTable->getPairEnergy(_posI2, _rotR2, _posJ, jr) - pTable->getPairEnergy(_posI1, _rotT1, _posJ, jr) - pTable->getPairEnergy(_posI2, _rotT2, _posJ, jr);
 
 			if (!found) {
 				found = true;
@@ -825,8 +850,8 @@ void DeadEndElimination::minDiffIrItJuDouble(unsigned int _posI1, unsigned int _
 			}
 		}
 	} else if (_posI1 > _posJ) {
-		for (unsigned int jr=0; jr<(*pairEnergy)[_posI1][_rotR1][_posJ].size(); jr++) {
-			double diff = (*pairEnergy)[_posI1][_rotR1][_posJ][jr] + (*pairEnergy)[_posJ][jr][_posI2][_rotR2] - (*pairEnergy)[_posI1][_rotT1][_posJ][jr] - (*pairEnergy)[_posJ][jr][_posI2][_rotT2];
+		for (unsigned int jr=0; jr<pTable->getNumberOfRotamers(_posJ); jr++) {
+			double diff = pTable->getPairEnergy(_posI1, _rotR1, _posJ, jr) + pTable->getPairEnergy(_posJ, jr, _posI2, _rotR2) - pTable->getPairEnergy(_posI1, _rotT1, _posJ, jr) - pTable->getPairEnergy(_posJ, jr, _posI2, _rotT2);
 			if (!found) {
 				found = true;
 				_min = diff;
@@ -841,8 +866,8 @@ void DeadEndElimination::minDiffIrItJuDouble(unsigned int _posI1, unsigned int _
 			}
 		}
 	} else {
-		for (unsigned int jr=0; jr<(*pairEnergy)[_posJ].size(); jr++) {
-			double diff = (*pairEnergy)[_posJ][jr][_posI1][_rotR1] + (*pairEnergy)[_posJ][jr][_posI2][_rotR2] - (*pairEnergy)[_posJ][jr][_posI1][_rotT1] - (*pairEnergy)[_posJ][jr][_posI2][_rotT2];
+		for (unsigned int jr=0; jr<pTable->getNumberOfRotamers(_posJ); jr++) {
+			double diff = pTable->getPairEnergy(_posJ, jr, _posI1, _rotR1) + pTable->getPairEnergy(_posJ, jr, _posI2, _rotR2) - pTable->getPairEnergy(_posJ, jr, _posI1, _rotT1) - pTable->getPairEnergy(_posJ, jr, _posI2, _rotT2);
 			if (!found) {
 				found = true;
 				_min = diff;
@@ -959,120 +984,27 @@ bool DeadEndElimination::writeMaskAsBinaryFile(const string _filename) const {
 
 void DeadEndElimination::readEnergyTable(string _filename){
 
-	/*
-	  ENERGY TABLE FILE FORMAT:
-	  
-	  # COMMENT LINES
-	  # SELF TERMS
-	  #  POSITION_INDEX ROTAMER_INDEX SELF_ENERGY
-	  0 0 -0.5
-	  0 1 -0.3
-	  1 0  0.1
-	  ..
-
-	  # PAIR TERMS
-	  #  POSITION_INDEX ROTAMER_INDEX POSITION_INDEX ROTAMER_INDEX PAIR_ENERGY
-	  0 0 1 0 -0.2
-	  0 0 1 1  0.5
-	  ...
-	  
-	*/
+	// text (the format of the energyTable program) or binary energy table, see
+	// EnergyTable::readTextFile and EnergyTable::writeBinaryFile.  A binary table
+	// is memory mapped read-only
 
 	// This object is now responsible for the energy table memory.
 	responsibleForEnergyTableMemory = true;
 
-	selfEnergy = new vector<vector<double> >();
-	pairEnergy = new vector<vector<vector<vector<double> > > >();
-
-	ifstream fin;
-	string line;
-	try {
-		fin.open(_filename.c_str());
-		if (fin.fail()){
-			cerr << "ERROR 8904 in DeadEndElimination::readEnergyTable opening file "<<_filename<<endl;
-			exit(8904);
-		}
-		
-		bool firstPair = true;
-		while (!fin.fail()){
-			getline(fin,line);
-			if (line[0] == '#') continue;
-			if (line.length() <= 1) continue;
-
-
-
-			vector<string> toks = MslTools::tokenize(line);
-
-			
-			// self Energy Line has 3 numbers on it
-			if (toks.size() == 3){
-				int posIndex = MslTools::toInt(toks[0]);
-				if (selfEnergy->size() < posIndex+1){
-					vector<double> tmp;
-					selfEnergy->push_back(tmp);
-				}
-
-				(*selfEnergy)[posIndex].push_back(MslTools::toDouble(toks[2]));
-				
-			}
-
-
-
-			// pair Energy Line has 5 numbers on it
-			/*
-			  TODO:
-			     Make sure pairEnergy is not a full sized table.
-			      it should only be a triangle - lower triangular.
-			      resize(i+1) for pairEnergy[i]?
-			 */
-			if (toks.size() == 5){
-
-				if (firstPair){
-					pairEnergy->resize(selfEnergy->size());
-					// For each position resize to
-					// num rotamers
-					for (uint i = 0; i < selfEnergy->size();i++){
-						(*pairEnergy)[i].resize((*selfEnergy)[i].size());
-
-						// For each rotamer,
-						// resize to num positions
-						for (uint j = 0; j < (*selfEnergy)[i].size();j++){
-							(*pairEnergy)[i][j].resize((*selfEnergy).size());
-
-							// For each position resize to num rotamers
-							for (uint k = 0; k < (*selfEnergy).size();k++){
-								(*pairEnergy)[i][j][k].resize((*selfEnergy)[k].size());
-
-							}
-						}
+	pTable = &ownedTable;
+	pBaseLines = NULL;
 
-					}
-				}
-				firstPair = false;
-				
-				// Add to pairEnergy object. Indices pairEnergy[POS1][ROT1][POS2][ROT2] = ENERGY;
-				(*pairEnergy)[MslTools::toInt(toks[0])][MslTools::toInt(toks[1])][MslTools::toInt(toks[2])][MslTools::toInt(toks[3])] = MslTools::toDouble(toks[4]);
-
-				// Add symmetric entries into the pairEnergy table ****NO NEED****
-				// pairEnergy[MslTools::toInt(toks[2])][MslTools::toInt(toks[3])][MslTools::toInt(toks[0])][MslTools::toInt(toks[1])] = MslTools::toDouble(toks[4]);
-				
-			}
-		}
-	} catch (...){
-		cerr << "ERROR 7809 in DeadEndElimination::readEnergyTable in file: "<<_filename<<endl;
-		exit(7809);
+	if (!ownedTable.readFile(_filename)){
+		cerr << "ERROR 8904 in DeadEndElimination::readEnergyTable reading file "<<_filename<<endl;
+		exit(8904);
 	}
 
-
-	totalNumPositions = (*selfEnergy).size();
-	alive.clear();
-	alive.resize(totalNumPositions);
+	// all rotamers alive (and the flagged pairs, used by the pair eliminations)
+	initializeMask();
+	totalNumPositions = pTable->getNumberOfPositions();
+	totalNumRotamers = 0;
 	for (uint i = 0; i < alive.size();i++){
-		alive[i].resize((*selfEnergy)[i].size());
 		totalNumRotamers += alive[i].size();
-		for (uint j = 0; j < alive[i].size();j++){
-			alive[i][j] = true;
-		}
 	}
 
 }
@@ -1080,10 +1012,10 @@ void DeadEndElimination::readEnergyTable(string _filename){
 
 void DeadEndElimination::printMe(bool _selfOnly){
 	fprintf(stdout,"Self terms:\n");
-	for (uint i = 0; i < (*selfEnergy).size();i++){
-		for (uint j = 0; j < (*selfEnergy)[i].size();j++){
+	for (uint i = 0; i < pTable->getNumberOfPositions();i++){
+		for (uint j = 0; j < pTable->getNumberOfRotamers(i);j++){
 
-			fprintf(stdout, "    %4d %4d %8.3f", i, j, (*selfEnergy)[i][j]);
+			fprintf(stdout, "    %4d %4d %8.3f", i, j, pTable->getSelfEnergy(i, j));
 			if (alive[i][j]) {
 				fprintf(stdout, " **** ");
 			}
@@ -1099,15 +1031,15 @@ void DeadEndElimination::printMe(bool _selfOnly){
 	}
 
 	fprintf(stdout,"Pair terms:\n");
-	for (uint i = 0; i < (*pairEnergy).size();i++){
-		for (uint j = 0; j < (*pairEnergy)[i].size();j++){
-			//for (uint k = i+1 ; k < (*pairEnergy)[i][j].size();k++){	
-			for (uint k = 0 ; k < (*pairEnergy)[i][j].size();k++){	
+	for (uint i = 0; i < pTable->getNumberOfPositions();i++){
+		for (uint j = 0; j < pTable->getNumberOfRotamers(i);j++){
+			//for (uint k = i+1 ; k < pTable->getNumberOfPositions();k++){	
+			for (uint k = 0 ; k < pTable->getNumberOfPositions();k++){	
 				if (i == k){
 					continue;
 				}
-				for (uint l = 0 ; l < (*pairEnergy)[i][j][k].size();l++){	
-					fprintf(stdout, "    %4d %4d %4d %4d %8.3f", i, j, k, l, (*pairEnergy)[i][j][k][l]);
+				for (uint l = 0 ; l < pTable->getNumberOfRotamers(k);l++){	
+					fprintf(stdout, "    %4d %4d %4d %4d %8.3f", i, j, k, l, pTable->getPairEnergy(i, j, k, l));
 
 					if (alive[i][j] && alive[k][l]) {
 						fprintf(stdout, " **** ");
@@ -37,6 +37,7 @@ You should have received a copy of the GNU Lesser General Public
 #include <sys/stat.h>
 //#include <math.h>
 #include "MslTools.h"
+#include "EnergyTable.h"
 
 /*! \brief Dead End Elimination class
  */
@@ -47,6 +48,7 @@ class DeadEndElimination {
 		DeadEndElimination();
 		DeadEndElimination(std::vector<std::vector<double> > & _selfEnergies, std::vector<std::vector<std::vector<std::vector<double> > > > & _pairEnergies);
 		DeadEndElimination(std::vector<std::vector<double> > & _selfEnergies, std::vector<std::vector<std::vector<std::vector<double> > > > & _pairEnergies, std::vector<std::vector<double> > & _baselines);
+		DeadEndElimination(EnergyTable & _table);
 		~DeadEndElimination();
 
 
@@ -55,6 +57,8 @@ class DeadEndElimination {
 		void setEnergyTables(std::vector<std::vector<double> > & _selfEnergies, std::vector<std::vector<std::vector<std::vector<double> > > > & _pairEnergies);
 		void setEnergyTables(std::vector<std::vector<double> > & _selfEnergies, std::vector<std::vector<std::vector<std::vector<double> > > > & _pairEnergies, std::vector<std::vector<double> > & _baselines);
 		void setEnergyTables(std::vector<std::vector<double> > * _pSelfEnergies, std::vector<std::vector<std::vector<std::vector<double> > > > * _pPairEnergies, std::vector<std::vector<double> > * _pBaselines);
+		// use a flat energy table directly (not copied, the table must outlive the object)
+		void setEnergyTable(EnergyTable * _pTable);
 
 		void setBaselines(std::vector<std::vector<double> > & _baselines);
 		void setBaselines(std::vector<std::vector<double> > * _pBaselines);
@@ -100,8 +104,8 @@ class DeadEndElimination {
 		void minDiffIrItJuSingleAfterPair(unsigned int _posI, unsigned int _rotR, unsigned int _rotT, unsigned int _posJ, double & _min, double & _max, bool & _eliminateR, bool & _eliminateT);
 		void minDiffIrItJuDouble(unsigned int _posI1, unsigned int _rotR1, unsigned int _rotT1, unsigned int _posI2, unsigned int _rotR2, unsigned int _rotT2, unsigned int _posJ, double & _min, double & _max);
 
-		std::vector<std::vector<double> > * selfEnergy;
-		std::vector<std::vector<std::vector<std::vector<double> > > > * pairEnergy;
+		EnergyTable * pTable;
+		EnergyTable ownedTable; // holds the converted nested tables or the table read from file
 		std::vector<std::vector<double> > * pBaseLines;
 		
 
@@ -0,0 +1,279 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "DihedralGrid.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <stdint.h>
+
+using namespace MSL;
+using namespace std;
+
+// binary file format
+#define DIHEDRALGRID_MAGIC "MSLDGRD"
+#define DIHEDRALGRID_VERSION 1
+#define DIHEDRALGRID_BYTEORDER 0x01020304
+
+namespace {
+	struct DihedralGridFileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		uint32_t grids;
+		uint32_t reserved;
+	};
+	// before each grid, followed by the name and the counts
+	struct DihedralGridRecord {
+		uint32_t nameBytes;
+		uint32_t dimensions;
+		double binSize;
+	};
+}
+
+DihedralGrid::DihedralGrid() {
+	setup(0, 10.0);
+}
+
+DihedralGrid::DihedralGrid(unsigned int _dimensions, double _binSize) {
+	setup(_dimensions, _binSize);
+}
+
+DihedralGrid::DihedralGrid(const DihedralGrid & _grid) {
+	copy(_grid);
+}
+
+DihedralGrid::~DihedralGrid() {
+}
+
+void DihedralGrid::operator=(const DihedralGrid & _grid) {
+	copy(_grid);
+}
+
+void DihedralGrid::copy(const DihedralGrid & _grid) {
+	dimensions = _grid.dimensions;
+	nBins = _grid.nBins;
+	binSize = _grid.binSize;
+	total = _grid.total;
+	normalized = _grid.normalized;
+	emptyLogProbability = _grid.emptyLogProbability;
+	counts = _grid.counts;
+	probabilities = _grid.probabilities;
+	logProbabilities = _grid.logProbabilities;
+}
+
+void DihedralGrid::setup(unsigned int _dimensions, double _binSize) {
+	dimensions = _dimensions;
+	binSize = _binSize;
+	nBins = (unsigned int)(360.0 / _binSize + 0.5);
+	if (nBins == 0) {
+		nBins = 1;
+	}
+	unsigned int bins = 1;
+	for (unsigned int i=0; i<dimensions; i++) {
+		bins *= nBins;
+	}
+	if (dimensions == 0) {
+		bins = 0;
+	}
+	counts.assign(bins, 0);
+	probabilities.clear();
+	logProbabilities.clear();
+	total = 0;
+	normalized = false;
+	emptyLogProbability = 0.0;
+}
+
+void DihedralGrid::clearCounts() {
+	counts.assign(counts.size(), 0);
+	probabilities.clear();
+	logProbabilities.clear();
+	total = 0;
+	normalized = false;
+}
+
+bool DihedralGrid::getBinFromCenter(double _center, unsigned int & _bin) const {
+	double bin = (_center + 180.0) / binSize - 0.5;
+	double rounded = floor(bin + 0.5);
+	if (fabs(bin - rounded) > 1.0e-6 || rounded < 0.0 || rounded >= nBins) {
+		return false;
+	}
+	_bin = (unsigned int)rounded;
+	return true;
+}
+
+void DihedralGrid::normalize() {
+	probabilities.assign(counts.size(), 0.0);
+	logProbabilities.assign(counts.size(), 0.0);
+	double denominator = total > 0 ? (double)total : 1.0;
+	emptyLogProbability = log(0.5 / denominator);
+	for (unsigned int i=0; i<counts.size(); i++) {
+		probabilities[i] = counts[i] / denominator;
+		if (counts[i] > 0) {
+			logProbabilities[i] = log(probabilities[i]);
+		} else {
+			logProbabilities[i] = emptyLogProbability;
+		}
+	}
+	normalized = true;
+}
+
+double DihedralGrid::getInterpolatedProbability(const double * _angles) const {
+	// lower bin and weight of the upper bin for each angle, on the grid of the bin centers
+	unsigned int lower[32];
+	unsigned int upper[32];
+	double weight[32];
+	for (unsigned int i=0; i<dimensions; i++) {
+		double position = (_angles[i] + 180.0) / binSize - 0.5;
+		double bin = floor(position);
+		weight[i] = position - bin;
+		lower[i] = getBin(-180.0 + (bin + 0.5) * binSize);
+		upper[i] = lower[i] + 1 == nBins ? 0 : lower[i] + 1;
+	}
+
+	double probability = 0.0;
+	unsigned int corners = 1u << dimensions;
+	for (unsigned int c=0; c<corners; c++) {
+		unsigned int index = 0;
+		double w = 1.0;
+		for (unsigned int i=0; i<dimensions; i++) {
+			if (c & (1u << (dimensions - 1 - i))) {
+				index = index * nBins + upper[i];
+				w *= weight[i];
+			} else {
+				index = index * nBins + lower[i];
+				w *= 1.0 - weight[i];
+			}
+		}
+		probability += w * probabilities[index];
+	}
+	return probability;
+}
+
+double DihedralGrid::getInterpolatedLogProbability(const double * _angles) const {
+	double probability = getInterpolatedProbability(_angles);
+	if (probability <= 0.0) {
+		return emptyLogProbability;
+	}
+	double logProbability = log(probability);
+	return logProbability > emptyLogProbability ? logProbability : emptyLogProbability;
+}
+
+bool DihedralGrid::writeFile(string _filename, const vector<string> & _names, const vector<DihedralGrid> & _grids) {
+	if (_names.size() != _grids.size()) {
+		cerr << "ERROR 78301: the number of names (" << _names.size() << ") does not match the number of grids (" << _grids.size() << ") in bool DihedralGrid::writeFile(string _filename, const vector<string> & _names, const vector<DihedralGrid> & _grids)" << endl;
+		return false;
+	}
+
+	DihedralGridFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, DIHEDRALGRID_MAGIC, 8);
+	header.version = DIHEDRALGRID_VERSION;
+	header.byteOrder = DIHEDRALGRID_BYTEORDER;
+	header.grids = _grids.size();
+
+	ofstream fout;
+	fout.open(_filename.c_str(), ios::out | ios::binary | ios::trunc);
+	if (fout.fail()) {
+		cerr << "ERROR 78302: cannot write file " << _filename << " in bool DihedralGrid::writeFile(string _filename, const vector<string> & _names, const vector<DihedralGrid> & _grids)" << endl;
+		return false;
+	}
+	fout.write((const char*)&header, sizeof(header));
+	for (unsigned int i=0; i<_grids.size(); i++) {
+		DihedralGridRecord record;
+		memset(&record, 0, sizeof(record));
+		record.nameBytes = _names[i].size();
+		record.dimensions = _grids[i].dimensions;
+		record.binSize = _grids[i].binSize;
+		fout.write((const char*)&record, sizeof(record));
+		fout.write(_names[i].data(), _names[i].size());
+		if (_grids[i].counts.size() > 0) {
+			fout.write((const char*)&_grids[i].counts[0], _grids[i].counts.size() * sizeof(uint32_t));
+		}
+	}
+	fout.close();
+	if (fout.fail()) {
+		cerr << "ERROR 78302: cannot write file " << _filename << " in bool DihedralGrid::writeFile(string _filename, const vector<string> & _names, const vector<DihedralGrid> & _grids)" << endl;
+		return false;
+	}
+	return true;
+}
+
+bool DihedralGrid::readFile(string _filename, vector<string> & _names, vector<DihedralGrid> & _grids) {
+	ifstream fin(_filename.c_str(), ios::in | ios::binary);
+	DihedralGridFileHeader header;
+	fin.read((char*)&header, sizeof(header));
+	if (fin.fail() || memcmp(header.magic, DIHEDRALGRID_MAGIC, 8) != 0) {
+		cerr << "ERROR 78303: " << _filename << " is not a binary dihedral grid file in bool DihedralGrid::readFile(string _filename, vector<string> & _names, vector<DihedralGrid> & _grids)" << endl;
+		return false;
+	}
+	if (header.version != DIHEDRALGRID_VERSION || header.byteOrder != DIHEDRALGRID_BYTEORDER) {
+		cerr << "ERROR 78304: unsupported version (" << header.version << ") or byte order of the binary dihedral grid file " << _filename << " in bool DihedralGrid::readFile(string _filename, vector<string> & _names, vector<DihedralGrid> & _grids)" << endl;
+		return false;
+	}
+
+	_names.assign(header.grids, "");
+	_grids.assign(header.grids, DihedralGrid());
+	for (unsigned int i=0; i<header.grids; i++) {
+		DihedralGridRecord record;
+		fin.read((char*)&record, sizeof(record));
+		if (fin.fail() || record.dimensions > 8 || record.binSize <= 0.0) {
+			fin.setstate(ios::failbit);
+			break;
+		}
+		vector<char> name(record.nameBytes + 1, '\0');
+		fin.read(&name[0], record.nameBytes);
+		_names[i] = &name[0];
+
+		_grids[i].setup(record.dimensions, record.binSize);
+		if (_grids[i].counts.size() > 0) {
+			fin.read((char*)&_grids[i].counts[0], _grids[i].counts.size() * sizeof(uint32_t));
+		}
+		for (unsigned int j=0; j<_grids[i].counts.size(); j++) {
+			_grids[i].total += _grids[i].counts[j];
+		}
+	}
+	if (fin.fail()) {
+		cerr << "ERROR 78305: truncated or corrupt binary dihedral grid file " << _filename << " in bool DihedralGrid::readFile(string _filename, vector<string> & _names, vector<DihedralGrid> & _grids)" << endl;
+		_names.clear();
+		_grids.clear();
+		return false;
+	}
+	return true;
+}
+
+bool DihedralGrid::isBinaryFile(string _filename) {
+	ifstream fin(_filename.c_str(), ios::in | ios::binary);
+	char magic[8];
+	fin.read(magic, 8);
+	if (fin.fail()) {
+		return false;
+	}
+	return memcmp(magic, DIHEDRALGRID_MAGIC, 8) == 0;
+}
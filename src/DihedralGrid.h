@@ -0,0 +1,169 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef DIHEDRALGRID_H
+#define DIHEDRALGRID_H
+
+#include <vector>
+#include <string>
+#include <cmath>
+
+namespace MSL {
+
+/***************************************************************
+ *  Periodic histogram of one or more dihedral angles (phi/psi,
+ *  chi1..chiN), with nBins = 360/binSize bins per angle over
+ *  [-180, 180).  Bin i of an angle covers
+ *  [-180 + i*binSize, -180 + (i+1)*binSize) and the bins of all
+ *  the angles are stored flat, the last angle running fastest.
+ *
+ *  Counts are added to the bins, then normalize() computes the
+ *  probability (counts / total) and the log-probability of every
+ *  bin once, so that a query is an index computation and a load.
+ *  Empty bins get the log of half a count over the total, which
+ *  keeps the logs finite.
+ *
+ *  Grids are saved and loaded in groups with names (one per
+ *  residue type) by writeFile and readFile.  File layout:
+ *  a header (8 byte tag "MSLDGRD", version, byte order, number of
+ *  grids), then for each grid the length of its name, the number
+ *  of angles, the bin size, the name and the counts as 32 bit
+ *  unsigned integers
+ ***************************************************************/
+class DihedralGrid {
+	public:
+		DihedralGrid();
+		DihedralGrid(unsigned int _dimensions, double _binSize);
+		DihedralGrid(const DihedralGrid & _grid);
+		~DihedralGrid();
+
+		void operator=(const DihedralGrid & _grid);
+
+		void setup(unsigned int _dimensions, double _binSize); // all counts zero
+		void clearCounts();
+
+		unsigned int getDimensions() const;
+		double getBinSize() const;
+		unsigned int getNumberOfBins() const; // per angle
+		unsigned int size() const; // all the bins
+
+		// bin of an angle in degrees, any value is wrapped into [-180, 180)
+		unsigned int getBin(double _angle) const;
+		double getBinCenter(unsigned int _bin) const;
+		// the bin of which _center is the center, false if it is not one
+		bool getBinFromCenter(double _center, unsigned int & _bin) const;
+		// flat index of a bin per angle
+		unsigned int getIndex(const unsigned int * _bins) const;
+		unsigned int getIndex(unsigned int _bin1, unsigned int _bin2) const;
+		unsigned int getAngleIndex(const double * _angles) const;
+
+		void addCounts(unsigned int _index, unsigned int _counts);
+		unsigned int getCounts(unsigned int _index) const;
+		unsigned int getTotal() const;
+
+		void normalize();
+		bool isNormalized() const;
+		double getProbability(unsigned int _index) const;
+		double getLogProbability(unsigned int _index) const;
+		double getProbability(const double * _angles) const;
+		double getLogProbability(const double * _angles) const;
+
+		/***************************************************************
+		 *  Multilinear interpolation of the probability between the
+		 *  centers of the 2^N surrounding bins (bilinear for phi/psi),
+		 *  periodic across +/-180
+		 ***************************************************************/
+		double getInterpolatedProbability(const double * _angles) const;
+		double getInterpolatedLogProbability(const double * _angles) const;
+
+		static bool writeFile(std::string _filename, const std::vector<std::string> & _names, const std::vector<DihedralGrid> & _grids);
+		static bool readFile(std::string _filename, std::vector<std::string> & _names, std::vector<DihedralGrid> & _grids);
+		static bool isBinaryFile(std::string _filename);
+
+	private:
+		void copy(const DihedralGrid & _grid);
+
+		unsigned int dimensions;
+		unsigned int nBins;
+		double binSize;
+		unsigned int total;
+		bool normalized;
+		double emptyLogProbability;
+
+		std::vector<unsigned int> counts;
+		std::vector<double> probabilities;
+		std::vector<double> logProbabilities;
+};
+
+inline unsigned int DihedralGrid::getDimensions() const { return dimensions; }
+inline double DihedralGrid::getBinSize() const { return binSize; }
+inline unsigned int DihedralGrid::getNumberOfBins() const { return nBins; }
+inline unsigned int DihedralGrid::size() const { return counts.size(); }
+inline unsigned int DihedralGrid::getBin(double _angle) const {
+	int bin = (int)floor((_angle + 180.0) / binSize);
+	if (bin < 0 || bin >= (int)nBins) {
+		bin %= (int)nBins;
+		if (bin < 0) {
+			bin += nBins;
+		}
+	}
+	return bin;
+}
+inline double DihedralGrid::getBinCenter(unsigned int _bin) const { return -180.0 + (_bin + 0.5) * binSize; }
+inline unsigned int DihedralGrid::getIndex(const unsigned int * _bins) const {
+	unsigned int index = 0;
+	for (unsigned int i=0; i<dimensions; i++) {
+		index = index * nBins + _bins[i];
+	}
+	return index;
+}
+inline unsigned int DihedralGrid::getIndex(unsigned int _bin1, unsigned int _bin2) const { return _bin1 * nBins + _bin2; }
+inline unsigned int DihedralGrid::getAngleIndex(const double * _angles) const {
+	unsigned int index = 0;
+	for (unsigned int i=0; i<dimensions; i++) {
+		index = index * nBins + getBin(_angles[i]);
+	}
+	return index;
+}
+inline void DihedralGrid::addCounts(unsigned int _index, unsigned int _counts) {
+	counts[_index] += _counts;
+	total += _counts;
+	normalized = false;
+}
+inline unsigned int DihedralGrid::getCounts(unsigned int _index) const { return counts[_index]; }
+inline unsigned int DihedralGrid::getTotal() const { return total; }
+inline bool DihedralGrid::isNormalized() const { return normalized; }
+inline double DihedralGrid::getProbability(unsigned int _index) const { return probabilities[_index]; }
+inline double DihedralGrid::getLogProbability(unsigned int _index) const { return logProbabilities[_index]; }
+inline double DihedralGrid::getProbability(const double * _angles) const { return probabilities[getAngleIndex(_angles)]; }
+inline double DihedralGrid::getLogProbability(const double * _angles) const { return logProbabilities[getAngleIndex(_angles)]; }
+
+}
+
+#endif
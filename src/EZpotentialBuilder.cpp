@@ -59,9 +59,9 @@ void EZpotentialBuilder::operator=( EZpotentialBuilder & _sysBuild) {
 
 void EZpotentialBuilder::setup() {
 	pSystem = NULL;
-	setParams();
 	useCB_flag = false;
 	addTermini_flag = false;
+	setParams();
 }
 
 void EZpotentialBuilder::copy( EZpotentialBuilder & _sysBuild) {
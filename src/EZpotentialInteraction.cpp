@@ -82,4 +82,44 @@ double EZpotentialInteraction::getEnergy(double _Zcoor, const vector<double> & _
 	}
 }
 
-
+double EZpotentialInteraction::getEnergy(double _Zcoor, const vector<double> & _param, bool _sigmoidalFunction, double & _dEdZ) const { 
+	/*********************************************************
+	 *  The energy is a function of |Z|, flat beyond 25 A:
+	 *
+	 *  sigmoidal:  E = E0 / (1 + (|Z|/Zmid)^n)
+	 *              dE/d|Z| = -E0 * n * (|Z|/Zmid)^(n-1) / (Zmid * (1 + (|Z|/Zmid)^n)^2)
+	 *
+	 *  gaussian:   E = E0 * exp(-(|Z| - Zmin)^2 / (2 * sigma^2))
+	 *              dE/d|Z| = -E * (|Z| - Zmin) / sigma^2
+	 *
+	 *  and dE/dZ = sign(Z) * dE/d|Z|
+	 *********************************************************/
+	double sign = 1.0;
+	if(_Zcoor < 0) {
+		_Zcoor = -1*_Zcoor;
+		sign = -1.0;
+	}
+	bool flat = false;
+	if (_Zcoor > 25.0) {
+		_Zcoor = 25.0;
+		flat = true;
+	}
+	double energy = 0.0;
+	if (_sigmoidalFunction) {
+		double zRel_n = pow((_Zcoor/_param[1]), _param[2]);
+		energy = _param[0] / ( 1 + zRel_n);
+		_dEdZ = 0.0;
+		if (_Zcoor > 0.0) {
+			_dEdZ = -_param[0] * _param[2] * zRel_n / (_Zcoor * (1 + zRel_n) * (1 + zRel_n));
+		}
+	} else {
+		energy = _param[2]*exp(-((_Zcoor-_param[1])*(_Zcoor-_param[1])) / (2*_param[0]*_param[0]));
+		_dEdZ = -energy * (_Zcoor-_param[1]) / (_param[0]*_param[0]);
+	}
+	if (flat) {
+		_dEdZ = 0.0;
+	} else {
+		_dEdZ *= sign;
+	}
+	return energy;
+}
@@ -74,9 +74,12 @@ namespace MSL {
 			
 			double getEnergy();
 			double getEnergy(double _Zcoor, const std::vector<double> & _param, bool _sigmoidalFunction) const;
-			double getEnergy(std::vector<double> *paramDerivatives); // derivatives not implemented
-			double getEnergy(double _param, std::vector<double> *paramDerivatives=NULL); // derivatives not implemented
-			std::vector<double> getEnergyGrad(); // derivatives not implemented
+			// as above, also returns dE/dZ in _dEdZ
+			double getEnergy(double _Zcoor, const std::vector<double> & _param, bool _sigmoidalFunction, double & _dEdZ) const;
+			double getEnergy(std::vector<double> *paramDerivatives); // computes dE/dx,dE/dy,dE/dz
+			double getEnergy(double _param, std::vector<double> *paramDerivatives=NULL); // energy at Z = _param, paramDerivatives (dZ/dx,dZ/dy,dZ/dz) are multiplied by dE/dZ
+			double getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace); // fused, no allocation
+			std::vector<double> getEnergyGrad();
 
 			friend std::ostream & operator<<(std::ostream &_os, EZpotentialInteraction & _term) {_os << _term.toString(); return _os;};
 			std::string toString() ;
@@ -107,20 +110,41 @@ namespace MSL {
 	inline std::string EZpotentialInteraction::getName() const {return typeName;}
 
 	inline std::pair<double,std::vector<double> > EZpotentialInteraction::partialDerivative() {
-		std::cerr << "ERROR 38984: std::pair<double,std::vector<double> > EZpotentialInteraction::partialDerivative() is not implemented" << std::endl;
-		exit(38984);
+		// the parameter is the Z coordinate
+		std::pair<double, std::vector<double> > partials;
+		partials.first = pAtoms[0]->getZ();
+		partials.second = std::vector<double>(3, 0.0);
+		partials.second[2] = 1.0;
+		return partials;
 	}
 	inline double EZpotentialInteraction::getEnergy(std::vector<double> *_dd) {
-		std::cerr << "ERROR 38989: double EZpotentialInteraction::getEnergy(std::vector<double> *_dd) is not implemented" << std::endl;
-		exit(38989);
+		if (_dd != NULL) {
+			_dd->assign(3, 0.0);
+			return getEnergy(pAtoms[0]->getZ(), params, isSigmoidal_flag, (*_dd)[2]);
+		}
+		return getEnergy();
 	}
 	inline double EZpotentialInteraction::getEnergy(double _param, std::vector<double> *paramDerivatives) {
-		std::cerr << "ERROR 38994: double EZpotentialInteraction::getEnergy(double _param, std::vector<double> *paramDerivatives) is not implemented" << std::endl;
-		exit(38994);
+		if (paramDerivatives != NULL) {
+			double dEdZ = 0.0;
+			double energy = getEnergy(_param, params, isSigmoidal_flag, dEdZ);
+			for (unsigned int i=0; i<paramDerivatives->size(); i++) {
+				(*paramDerivatives)[i] *= dEdZ;
+			}
+			return energy;
+		}
+		return getEnergy(_param, params, isSigmoidal_flag);
+	}
+	inline double EZpotentialInteraction::getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace) {
+		double dd[3] = {0.0, 0.0, 0.0};
+		double energy = getEnergy(pAtoms[0]->getZ(), params, isSigmoidal_flag, dd[2]);
+		addGradient(_gradients, dd, 1.0);
+		return energy;
 	}
 	inline std::vector<double> EZpotentialInteraction::getEnergyGrad() {
-		std::cerr << "ERROR 38999: std::vector<double> EZpotentialInteraction::getEnergyGrad() is not implemented" << std::endl;
-		exit(38999);
+		std::vector<double> dd;
+		getEnergy(&dd);
+		return dd;
 	}
 }
 
@@ -28,6 +28,9 @@ You should have received a copy of the GNU Lesser General Public
 */
 
 #include "EnergySet.h"
+#include "AtomGroup.h"
+#include "CharmmEnergy.h"
+#include <algorithm>
 
 using namespace MSL;
 using namespace std;
@@ -64,6 +67,9 @@ void EnergySet::deletePointers() {
 	}
 	energyTerms.clear();
 	weights.clear();
+	packedNonBondedCurrent = false;
+	deltaCurrent = false;
+	neighborListCurrent = false;
 
 	
 }
@@ -76,6 +82,9 @@ void EnergySet::eraseTerm(string _term) {
 			delete *l;
 		}
 		energyTerms.erase(it);
+		packedNonBondedCurrent = false;
+		deltaCurrent = false;
+		neighborListCurrent = false;
 	}
 	for (map<string, double>::iterator k=weights.begin(); k!=weights.end(); k++) {
 		if (k->first == _term) {
@@ -90,6 +99,17 @@ void EnergySet::setup() {
 	stamp = 0;
 	totalEnergy = 0.0;
 	checkForCoordinates_flag = false;
+	usePackedNonBonded = false;
+	packedNonBondedCurrent = false;
+	deltaCurrent = false;
+	neighborListCurrent = false;
+	deltaRebuilt = false;
+	deltaResynced = false;
+	deltaResyncInterval = 1000;
+	deltaMovesSinceResync = 0;
+	deltaStamp = 0;
+	neighborListSkin = 2.0;
+	neighborListBuilds = 0;
 }
 
 
@@ -131,6 +151,9 @@ void EnergySet::addInteraction(Interaction * _interaction) {
 	// in the map
 	string name = _interaction->getName();
 	energyTerms[name].push_back(_interaction);
+	packedNonBondedCurrent = false;
+	deltaCurrent = false;
+	neighborListCurrent = false;
 	if (activeEnergyTerms.find(name) == activeEnergyTerms.end()) {
 		activeEnergyTerms[name] = true;
 	}
@@ -172,6 +195,25 @@ double EnergySet::calculateEnergy(string _selection1, string _selection2, bool _
 	termTotal.clear();
 	totalEnergy = 0.0;
 	totalNumberOfInteractions = 0;
+
+	// convert the selection names to integer ids once, the interactions test them on the atoms' selection bits
+	unsigned int sele1 = Atom::noSelectionId;
+	unsigned int sele2 = Atom::noSelectionId;
+	if (!_noSelect) {
+		sele1 = Atom::findSelectionId(_selection1);
+		sele2 = Atom::findSelectionId(_selection2);
+	}
+
+	// the packed non bonded terms are only used without selections
+	bool usePacked = usePackedNonBonded && _noSelect;
+	if (usePacked) {
+		if (!packedNonBondedCurrent || !packedNonBonded.isCurrent(energyTerms)) {
+			packedNonBonded.build(energyTerms);
+			packedNonBondedCurrent = true;
+		}
+		packedNonBonded.gatherCoordinates(_activeOnly, checkForCoordinates_flag);
+	}
+
 	for (map<string, vector<Interaction*> >::iterator k=energyTerms.begin(); k!=energyTerms.end(); k++) {
 		// for all the terms
 		if (activeEnergyTerms.find(k->first) == activeEnergyTerms.end() || !activeEnergyTerms[k->first]) {
@@ -180,16 +222,20 @@ double EnergySet::calculateEnergy(string _selection1, string _selection2, bool _
 		}
 		double tmpTermTotal = 0.0;
 		unsigned int tmpTermCounter = 0;
-		for (vector<Interaction*>::const_iterator l=k->second.begin(); l!=k->second.end(); l++) {
-			// for all the interactions
-			if ((!_activeOnly || (*l)->isActive()) && (_noSelect || (*l)->isSelected(_selection1, _selection2)) && (!checkForCoordinates_flag || (*l)->atomsHaveCoordinates())) {
-				tmpTermCounter++;
-				tmpTermTotal += (*l)->getEnergy(); 
-
-				// Error checking code, add BOND Interactions to a hash, lookup later.
-				//if ((*l)->getName() == "CHARMM_BOND"){
-				//MSLOUT.getStaticLookup()[(*l)->toString()] = (*l)->getEnergy();
-				//}
+		if (usePacked && packedNonBonded.hasTerm(k->first)) {
+			tmpTermTotal = packedNonBonded.calcTermEnergy(k->first, tmpTermCounter);
+		} else {
+			for (vector<Interaction*>::const_iterator l=k->second.begin(); l!=k->second.end(); l++) {
+				// for all the interactions
+				if ((!_activeOnly || (*l)->isActive()) && (_noSelect || (*l)->isSelected(sele1, sele2)) && (!checkForCoordinates_flag || (*l)->atomsHaveCoordinates())) {
+					tmpTermCounter++;
+					tmpTermTotal += (*l)->getEnergy(); 
+
+					// Error checking code, add BOND Interactions to a hash, lookup later.
+					//if ((*l)->getName() == "CHARMM_BOND"){
+					//MSLOUT.getStaticLookup()[(*l)->toString()] = (*l)->getEnergy();
+					//}
+				}
 			}
 		}
 		interactionCounter[k->first] = tmpTermCounter;
@@ -294,6 +340,12 @@ void EnergySet::saveEnergySubsetAllAtoms(string _subsetName, string _selection1,
 void EnergySet::saveEnergySubset(string _subsetName, string _selection1, string _selection2, bool _noSelect, bool _activeOnly) {
 
 	energyTermsSubsets[_subsetName].clear(); // reset the subset if existing
+	unsigned int sele1 = Atom::noSelectionId;
+	unsigned int sele2 = Atom::noSelectionId;
+	if (!_noSelect) {
+		sele1 = Atom::findSelectionId(_selection1);
+		sele2 = Atom::findSelectionId(_selection2);
+	}
 	for (map<string, vector<Interaction*> >::iterator k=energyTerms.begin(); k!=energyTerms.end(); k++) {
 		// for all the terms
 		if (activeEnergyTerms.find(k->first) == activeEnergyTerms.end() || !activeEnergyTerms[k->first]) {
@@ -302,7 +354,7 @@ void EnergySet::saveEnergySubset(string _subsetName, string _selection1, string
 		}
 		for (vector<Interaction*>::const_iterator l=k->second.begin(); l!=k->second.end(); l++) {
 			// for all the interactions
-			if ((!_activeOnly || (*l)->isActive()) && (_noSelect || (*l)->isSelected(_selection1, _selection2)) && (!checkForCoordinates_flag || (*l)->atomsHaveCoordinates())) {
+			if ((!_activeOnly || (*l)->isActive()) && (_noSelect || (*l)->isSelected(sele1, sele2)) && (!checkForCoordinates_flag || (*l)->atomsHaveCoordinates())) {
 				// add the interaction to the subset
 				energyTermsSubsets[_subsetName][k->first].push_back(*l);
 			}
@@ -310,6 +362,204 @@ void EnergySet::saveEnergySubset(string _subsetName, string _selection1, string
 	}
 }
 
+/*   FUNCTIONS FOR INCREMENTAL (DELTA) ENERGY CALCULATION   */
+double EnergySet::initializeEnergyDelta() {
+	deltaTerms.clear();
+	deltaAtomIndex.clear();
+	deltaChanges.clear();
+	deltaMovedAtoms.clear();
+	deltaStamp = 0;
+	deltaRebuilt = false;
+	deltaResynced = false;
+	deltaMovesSinceResync = 0;
+
+	for (map<string, vector<Interaction*> >::iterator k=energyTerms.begin(); k!=energyTerms.end(); k++) {
+		// for all the terms
+		if (activeEnergyTerms.find(k->first) == activeEnergyTerms.end() || !activeEnergyTerms[k->first]) {
+			// inactive term, don't calculate it
+			continue;
+		}
+		unsigned int termIndex = deltaTerms.size();
+		deltaTerms.push_back(DeltaTerm());
+		DeltaTerm & term = deltaTerms.back();
+		term.name = k->first;
+		term.pInteractions = &(k->second);
+		term.energies = vector<double>(k->second.size(), 0.0);
+		term.counted = vector<bool>(k->second.size(), false);
+		term.visited = vector<unsigned int>(k->second.size(), 0);
+		term.total = 0.0;
+		term.counter = 0;
+		term.savedTotal = 0.0;
+		term.savedCounter = 0;
+		for (unsigned int i=0; i<k->second.size(); i++) {
+			Interaction * pInteraction = k->second[i];
+			vector<Atom*> & atoms = pInteraction->getAtomPointers();
+			for (vector<Atom*>::iterator a=atoms.begin(); a!=atoms.end(); a++) {
+				if (*a != NULL) {
+					deltaAtomIndex[*a].push_back(pair<unsigned int, unsigned int>(termIndex, i));
+				}
+			}
+			if (pInteraction->isActive() && (!checkForCoordinates_flag || pInteraction->atomsHaveCoordinates())) {
+				term.energies[i] = pInteraction->getEnergy();
+				term.counted[i] = true;
+				term.total += term.energies[i];
+				term.counter++;
+			}
+		}
+	}
+	deltaCurrent = true;
+	updateDeltaTotals();
+	return totalEnergy;
+}
+
+double EnergySet::calcEnergyDelta() {
+	double previousEnergy = totalEnergy;
+	if (!deltaCurrent) {
+		// the interactions or the active terms changed, recalculate everything
+		initializeEnergyDelta();
+		deltaRebuilt = true;
+		return totalEnergy - previousEnergy;
+	}
+	deltaChanges.clear();
+	deltaRebuilt = false;
+	deltaResynced = false;
+	for (vector<DeltaTerm>::iterator t=deltaTerms.begin(); t!=deltaTerms.end(); t++) {
+		t->savedTotal = t->total;
+		t->savedCounter = t->counter;
+	}
+	deltaStamp++;
+	if (deltaStamp == 0) {
+		// the stamp wrapped around, reset the visits
+		for (vector<DeltaTerm>::iterator t=deltaTerms.begin(); t!=deltaTerms.end(); t++) {
+			t->visited.assign(t->visited.size(), 0);
+		}
+		deltaStamp = 1;
+	}
+
+	// add the other atoms of the groups of the moved atoms (the group center affects the switching function)
+	vector<Atom*> atoms;
+	for (vector<Atom*>::iterator k=deltaMovedAtoms.begin(); k!=deltaMovedAtoms.end(); k++) {
+		AtomGroup * pGroup = (*k)->getParentGroup();
+		if (pGroup != NULL) {
+			atoms.insert(atoms.end(), pGroup->begin(), pGroup->end());
+		} else {
+			atoms.push_back(*k);
+		}
+	}
+	sort(atoms.begin(), atoms.end());
+	atoms.erase(unique(atoms.begin(), atoms.end()), atoms.end());
+	deltaMovedAtoms.clear();
+
+	for (vector<Atom*>::iterator k=atoms.begin(); k!=atoms.end(); k++) {
+		map<Atom*, vector<pair<unsigned int, unsigned int> > >::iterator found = deltaAtomIndex.find(*k);
+		if (found == deltaAtomIndex.end()) {
+			continue;
+		}
+		for (vector<pair<unsigned int, unsigned int> >::iterator l=found->second.begin(); l!=found->second.end(); l++) {
+			DeltaTerm & term = deltaTerms[l->first];
+			unsigned int i = l->second;
+			if (term.visited[i] == deltaStamp) {
+				// already recalculated from another atom
+				continue;
+			}
+			term.visited[i] = deltaStamp;
+			DeltaChange change;
+			change.term = l->first;
+			change.index = i;
+			change.energy = term.energies[i];
+			change.counted = term.counted[i];
+			deltaChanges.push_back(change);
+
+			if (term.counted[i]) {
+				term.total -= term.energies[i];
+				term.counter--;
+			}
+			Interaction * pInteraction = (*term.pInteractions)[i];
+			if (pInteraction->isActive() && (!checkForCoordinates_flag || pInteraction->atomsHaveCoordinates())) {
+				term.energies[i] = pInteraction->getEnergy();
+				term.counted[i] = true;
+				term.total += term.energies[i];
+				term.counter++;
+			} else {
+				term.energies[i] = 0.0;
+				term.counted[i] = false;
+			}
+		}
+	}
+	if (deltaChanges.size() > 0) {
+		deltaMovesSinceResync++;
+		if (deltaResyncInterval > 0 && deltaMovesSinceResync >= deltaResyncInterval) {
+			// remove the rounding errors accumulated by the updates
+			sumDeltaTerms();
+			deltaResynced = true;
+		}
+	}
+	updateDeltaTotals();
+	return totalEnergy - previousEnergy;
+}
+
+void EnergySet::resyncEnergyDelta() {
+	if (!deltaCurrent) {
+		return;
+	}
+	sumDeltaTerms();
+	updateDeltaTotals();
+}
+
+void EnergySet::sumDeltaTerms() {
+	// the totals summed in the same order as in initializeEnergyDelta
+	for (vector<DeltaTerm>::iterator t=deltaTerms.begin(); t!=deltaTerms.end(); t++) {
+		t->total = 0.0;
+		t->counter = 0;
+		for (unsigned int i=0; i<t->energies.size(); i++) {
+			if (t->counted[i]) {
+				t->total += t->energies[i];
+				t->counter++;
+			}
+		}
+	}
+	deltaMovesSinceResync = 0;
+}
+
+void EnergySet::rejectEnergyDelta() {
+	if (deltaRebuilt) {
+		// the cache was rebuilt on the rejected coordinates, it needs to be rebuilt again
+		deltaCurrent = false;
+		deltaRebuilt = false;
+		deltaChanges.clear();
+		return;
+	}
+	for (vector<DeltaChange>::reverse_iterator k=deltaChanges.rbegin(); k!=deltaChanges.rend(); k++) {
+		deltaTerms[k->term].energies[k->index] = k->energy;
+		deltaTerms[k->term].counted[k->index] = k->counted;
+	}
+	if (deltaResynced) {
+		// the saved totals are from before the resync
+		sumDeltaTerms();
+		deltaResynced = false;
+	} else {
+		for (vector<DeltaTerm>::iterator t=deltaTerms.begin(); t!=deltaTerms.end(); t++) {
+			t->total = t->savedTotal;
+			t->counter = t->savedCounter;
+		}
+	}
+	deltaChanges.clear();
+	updateDeltaTotals();
+}
+
+void EnergySet::updateDeltaTotals() {
+	interactionCounter.clear();
+	termTotal.clear();
+	totalEnergy = 0.0;
+	totalNumberOfInteractions = 0;
+	for (vector<DeltaTerm>::iterator t=deltaTerms.begin(); t!=deltaTerms.end(); t++) {
+		interactionCounter[t->name] = t->counter;
+		termTotal[t->name] = t->total * weights[t->name];
+		totalEnergy += termTotal[t->name];
+		totalNumberOfInteractions += t->counter;
+	}
+}
+
 /*   FUNCTIONS FOR ENERGY CALCULATION: DONE   */
 
 string EnergySet::getSummary(unsigned int _precision) const{
@@ -375,6 +625,13 @@ double EnergySet::getTermEnergy(string _name) const {
 
 
 double EnergySet::calcEnergyAndEnergyGradient(vector<double> &_gradients){
+	if (_gradients.size() == 0) {
+		return calcEnergyAndEnergyGradient((double*)NULL);
+	}
+	return calcEnergyAndEnergyGradient(&_gradients[0]);
+}
+
+double EnergySet::calcEnergyAndEnergyGradient(double * _gradients){
 	
 	// TODO: should we use term weights in minimization?
 	// For each interaction
@@ -383,49 +640,223 @@ double EnergySet::calcEnergyAndEnergyGradient(vector<double> &_gradients){
 
 
 		// Only compute active energy terms
-		if (activeEnergyTerms.find(k->first) == activeEnergyTerms.end() || !activeEnergyTerms[k->first]) {
+		map<string, bool>::const_iterator active = activeEnergyTerms.find(k->first);
+		if (active == activeEnergyTerms.end() || !active->second) {
 			// inactive term
 			continue;
 		}
 
-		// Loop over each interaction
+		// Loop over each interaction, the energy and the gradient are computed
+		// in a single pass and the gradient is added directly to the buffer
 		for (vector<Interaction*>::const_iterator l=k->second.begin(); l!=k->second.end(); l++) {
-
-
 			// If interaction is active...
 			if ((*l)->isActive()){  
+				energy += (*l)->getEnergyAndAddGradient(_gradients, gradientWorkspace);
+			}
+		}
+	}
 
-				vector<Atom *> &ats = (*l)->getAtomPointers();
-				/*
-				cout << "Calculating gradient of "<<(*l)->getName()<<endl;
-				for (uint a = 0; a < ats.size();a++){
-					cout << "\t"<<ats[a]->toString()<<endl;
-				}
-				*/
-				// TODO: combine partialDerivative and getEnergy with the gradients into a single function
-				//cout << "Partials: "<<partials.first<<" "<<partials.second.size()<<endl;
-				vector<double> gradient;
-				double e  = (*l)->getEnergy(&gradient);
-				energy += e;
+	return energy;
+}
 
-				for (uint a = 0; a < ats.size();a++){
-					
-					if (ats[a]->getMinimizationIndex() == -1){
-						continue;
+// adds _factor * _atomGradients (dE/dx1,dE/dy1,dE/dz1...) to the flat gradient of the minimized atoms
+static void addScaledGradient(double * _gradients, const vector<Atom*> & _atoms, const double * _atomGradients, double _factor) {
+	for (unsigned int a=0; a<_atoms.size(); a++) {
+		int index = _atoms[a]->getMinimizationIndex();
+		if (index == -1) {
+			continue;
+		}
+		double * pGradient = _gradients + 3 * (index - 1);
+		pGradient[0] += _atomGradients[3*a] * _factor;
+		pGradient[1] += _atomGradients[3*a+1] * _factor;
+		pGradient[2] += _atomGradients[3*a+2] * _factor;
+	}
+}
+
+void EnergySet::buildNeighborList() {
+	/***********************************************************
+	 *  Verlet list: all interactions without cutoffs, and the
+	 *  ones with cutoffs whose atom groups are within the
+	 *  cutoff plus the skin.  The atoms that are not in a
+	 *  group are treated as a group of a single atom (as in
+	 *  Atom::getGroupGeometricCenter)
+	 ***********************************************************/
+	neighborTerms.clear();
+	neighborGroupAtoms.clear();
+	neighborTrackedAtoms.clear();
+	neighborReferenceCoors.clear();
+
+	// first pass, assign the groups
+	map<void*, int> groupIndex;
+	for (map<string, vector<Interaction*> >::iterator k=energyTerms.begin(); k!=energyTerms.end(); k++) {
+		for (vector<Interaction*>::iterator l=k->second.begin(); l!=k->second.end(); l++) {
+			if (!(*l)->getUseNonBondCutoffs()) {
+				continue;
+			}
+			for (unsigned int i=0; i<2; i++) {
+				Atom * pAtom = (*l)->getAtom(i);
+				void * key = pAtom->getParentGroup() == NULL ? (void*)pAtom : (void*)pAtom->getParentGroup();
+				if (groupIndex.find(key) != groupIndex.end()) {
+					continue;
+				}
+				groupIndex[key] = neighborGroupAtoms.size();
+				neighborGroupAtoms.push_back(vector<Atom*>());
+				if (pAtom->getParentGroup() == NULL) {
+					neighborGroupAtoms.back().push_back(pAtom);
+				} else {
+					AtomGroup & group = *(pAtom->getParentGroup());
+					for (unsigned int j=0; j<group.size(); j++) {
+						neighborGroupAtoms.back().push_back(group[j]);
 					}
-					int fullGradIndex = 3*ats[a]->getMinimizationIndex();
-					int localGradIndex = 3*(a+1);
-					
-					_gradients[fullGradIndex-3] += gradient[localGradIndex-3];
-					_gradients[fullGradIndex-2] += gradient[localGradIndex-2];
-					_gradients[fullGradIndex-1] += gradient[localGradIndex-1];
+				}
+				neighborTrackedAtoms.insert(neighborTrackedAtoms.end(), neighborGroupAtoms.back().begin(), neighborGroupAtoms.back().end());
+			}
+		}
+	}
+	for (vector<Atom*>::iterator k=neighborTrackedAtoms.begin(); k!=neighborTrackedAtoms.end(); k++) {
+		neighborReferenceCoors.push_back((*k)->getCoor());
+	}
+	updateNeighborGroupCenters();
 
+	// second pass, the pairs
+	for (map<string, vector<Interaction*> >::iterator k=energyTerms.begin(); k!=energyTerms.end(); k++) {
+		neighborTerms.push_back(NeighborTerm());
+		NeighborTerm & term = neighborTerms.back();
+		term.name = k->first;
+		for (vector<Interaction*>::iterator l=k->second.begin(); l!=k->second.end(); l++) {
+			NeighborPair pair;
+			pair.pInteraction = *l;
+			pair.group1 = -1;
+			pair.group2 = -1;
+			pair.cutoffOn = 0.0;
+			pair.cutoffOff = 0.0;
+			if ((*l)->getUseNonBondCutoffs()) {
+				Atom * pAtom1 = (*l)->getAtom(0);
+				Atom * pAtom2 = (*l)->getAtom(1);
+				pair.group1 = groupIndex[pAtom1->getParentGroup() == NULL ? (void*)pAtom1 : (void*)pAtom1->getParentGroup()];
+				pair.group2 = groupIndex[pAtom2->getParentGroup() == NULL ? (void*)pAtom2 : (void*)pAtom2->getParentGroup()];
+				pair.cutoffOn = (*l)->getNonBondCutoffOn();
+				pair.cutoffOff = (*l)->getNonBondCutoffOff();
+				double listCutoff = pair.cutoffOff + neighborListSkin;
+				if (neighborGroupCenters[pair.group1].distance2(neighborGroupCenters[pair.group2]) > listCutoff * listCutoff) {
+					continue;
 				}
 			}
+			term.pairs.push_back(pair);
 		}
 	}
+	neighborListCurrent = true;
+	neighborListBuilds++;
+}
 
-	return energy;
+bool EnergySet::neighborListNeedsRebuild() const {
+	// the group centers cannot move more than their atoms, if no atom moved more than half of the skin
+	// no pair outside the list can be within the cutoff
+	double maxDisplacement2 = neighborListSkin * neighborListSkin / 4.0;
+	for (unsigned int i=0; i<neighborTrackedAtoms.size(); i++) {
+		if (neighborTrackedAtoms[i]->getCoor().distance2(neighborReferenceCoors[i]) > maxDisplacement2) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void EnergySet::updateNeighborGroupCenters() {
+	// same arithmetic as AtomPointerVector::getGeometricCenter, so that the energy is identical to calcEnergy()
+	neighborGroupCenters.resize(neighborGroupAtoms.size());
+	for (unsigned int i=0; i<neighborGroupAtoms.size(); i++) {
+		CartesianPoint tmp(0.0, 0.0, 0.0);
+		for (unsigned int j=0; j<neighborGroupAtoms[i].size(); j++) {
+			tmp += neighborGroupAtoms[i][j]->getCoor();
+		}
+		neighborGroupCenters[i] = tmp/(double)neighborGroupAtoms[i].size();
+	}
+}
+
+double EnergySet::calcSwitchedEnergyAndEnergyGradient(double * _gradients) {
+	if (!neighborListCurrent || neighborListNeedsRebuild()) {
+		buildNeighborList();
+	} else {
+		updateNeighborGroupCenters();
+	}
+
+	interactionCounter.clear();
+	termTotal.clear();
+	totalEnergy = 0.0;
+	totalNumberOfInteractions = 0;
+
+	CharmmEnergy * pCE = CharmmEnergy::instance();
+	for (vector<NeighborTerm>::iterator k=neighborTerms.begin(); k!=neighborTerms.end(); k++) {
+		// Only compute active energy terms
+		map<string, bool>::const_iterator active = activeEnergyTerms.find(k->name);
+		if (active == activeEnergyTerms.end() || !active->second) {
+			// inactive term
+			continue;
+		}
+		double weight = weights[k->name];
+		double tmpTermTotal = 0.0;
+		unsigned int tmpTermCounter = 0;
+		for (vector<NeighborPair>::const_iterator l=k->pairs.begin(); l!=k->pairs.end(); l++) {
+			Interaction * pInter = l->pInteraction;
+			if (!pInter->isActive() || (checkForCoordinates_flag && !pInter->atomsHaveCoordinates())) {
+				continue;
+			}
+			double factor = 1.0;
+			double groupDistance = 0.0;
+			if (l->group1 != -1) {
+				groupDistance = neighborGroupCenters[l->group1].distance(neighborGroupCenters[l->group2]);
+				if (groupDistance > l->cutoffOff) {
+					// out of cutofnb
+					continue;
+				} else if (groupDistance > l->cutoffOn) {
+					factor = pCE->switchingFunction(groupDistance, l->cutoffOn, l->cutoffOff);
+				}
+			}
+			tmpTermCounter++;
+			if (_gradients == NULL) {
+				tmpTermTotal += pInter->getEnergy((vector<double>*)NULL) * factor;
+			} else if (factor == 1.0 && weight == 1.0) {
+				// the common case, no allocation
+				tmpTermTotal += pInter->getEnergyAndAddGradient(_gradients, gradientWorkspace);
+			} else {
+				gradientWorkspace.clear();
+				double energy = pInter->getEnergy(&gradientWorkspace);
+				tmpTermTotal += energy * factor;
+				vector<Atom*> & atoms = pInter->getAtomPointers();
+				if (gradientWorkspace.size() >= 3 * atoms.size()) {
+					addScaledGradient(_gradients, atoms, &gradientWorkspace[0], factor * weight);
+				}
+				if (factor != 1.0) {
+					// derivative of the switching function, distributed over the atoms of the two groups:
+					// d(SW)/dx = SW'(R) * (c1 - c2)/R * 1/n for the atoms of the first group (opposite for the second)
+					double dSW = weight * energy * pCE->switchingFunctionGrad(groupDistance, l->cutoffOn, l->cutoffOff) / groupDistance;
+					CartesianPoint direction = neighborGroupCenters[l->group1] - neighborGroupCenters[l->group2];
+					for (unsigned int g=0; g<2; g++) {
+						const vector<Atom*> & groupAtoms = neighborGroupAtoms[g == 0 ? l->group1 : l->group2];
+						CartesianPoint atomGradient = direction * (dSW / (double)groupAtoms.size());
+						if (g == 1) {
+							atomGradient = -atomGradient;
+						}
+						for (vector<Atom*>::const_iterator m=groupAtoms.begin(); m!=groupAtoms.end(); m++) {
+							int index = (*m)->getMinimizationIndex();
+							if (index == -1) {
+								continue;
+							}
+							double * pGradient = _gradients + 3 * (index - 1);
+							pGradient[0] += atomGradient.getX();
+							pGradient[1] += atomGradient.getY();
+							pGradient[2] += atomGradient.getZ();
+						}
+					}
+				}
+			}
+		}
+		interactionCounter[k->name] = tmpTermCounter;
+		termTotal[k->name] = tmpTermTotal * weight;
+		totalEnergy += termTotal[k->name];
+		totalNumberOfInteractions += tmpTermCounter;
+	}
+	return totalEnergy;
 }
 
 void EnergySet::calcEnergyGradient(vector<double> &_gradients){
@@ -485,6 +916,9 @@ void EnergySet::clearAllInteractions(){
 	}
 	energyTerms.clear();
 	weights.clear();
+	packedNonBondedCurrent = false;
+	deltaCurrent = false;
+	neighborListCurrent = false;
 }
 
 void EnergySet::deleteInteractionsWithAtom(Atom & _a, string _type) {
@@ -515,5 +949,8 @@ void EnergySet::deleteInteractionsWithAtoms(AtomPointerVector & _atomVec, string
 		}
 	}
 	energyTermsSubsets.clear();
+	packedNonBondedCurrent = false;
+	deltaCurrent = false;
+	neighborListCurrent = false;
 }
 
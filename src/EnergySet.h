@@ -37,6 +37,7 @@ You should have received a copy of the GNU Lesser General Public
 
 #include "Interaction.h"
 #include "SpringConstraintInteraction.h"
+#include "PackedNonBondedEnergy.h"
 //#include "CharmmVdwInteraction.h"
 //#include "CharmmBondInteraction.h"
 //#include "CharmmElectrostaticInteraction.h"
@@ -107,9 +108,35 @@ class EnergySet {
 
 		void calcEnergyGradient(std::vector<double> &_gradients);
 		double calcEnergyAndEnergyGradient(std::vector<double> &_gradients);
+		// used by the minimizer: adds the gradient to a flat buffer of 3 * (number of minimized atoms), indexed
+		// by the minimization index of the atoms (see Interaction::getEnergyAndAddGradient), no memory is allocated
+		double calcEnergyAndEnergyGradient(double * _gradients);
 
 		double calcEnergyWithoutSwitchingFunction();
 
+		/***********************************************************
+		 *  Energy and gradient with the switching function of the
+		 *  CHARMM non bonded terms (the energy is the same as
+		 *  calcEnergy(), the gradient is weighted as well).  The gradient
+		 *  includes the derivative of the switching function, which
+		 *  depends on the centers of the atom groups of the two atoms.
+		 *
+		 *  The interactions are taken from a Verlet neighbor list:
+		 *  the pairs with cutoffs are kept if their group centers
+		 *  are within the cutoff plus a skin distance.  The list is
+		 *  rebuilt only when an atom has moved more than half of the
+		 *  skin since the last build.  If the gradient buffer is NULL
+		 *  only the energy is computed.
+		 *
+		 *  Call resetNeighborList() if the atom groups change (for
+		 *  example when the identity of a position is switched)
+		 ***********************************************************/
+		double calcSwitchedEnergyAndEnergyGradient(double * _gradients);
+		void setNeighborListSkin(double _skin);
+		double getNeighborListSkin() const;
+		unsigned int getNumberOfNeighborListBuilds() const; // since the creation of the object
+		void resetNeighborList();
+
 		/* Calculate the energies including the interactions that inlcude atoms that belong to inactive side chains */
 		double calcEnergyAllAtoms();
 		double calcEnergyAllAtoms(std::string _selection);
@@ -168,6 +195,58 @@ class EnergySet {
 		void setCheckForCoordinates(bool _flag);
 		bool getCheckForCoordinates() const;
 
+		/**************************************************
+		 *  Calculate the CHARMM_VDW and CHARMM_ELEC terms
+		 *  with packed pair lists and a vectorized kernel
+		 *  (see PackedNonBondedEnergy.h). Used by calcEnergy()
+		 *  and calcEnergyAllAtoms() without selections.
+		 *  The pair lists are rebuilt automatically when
+		 *  the interactions change
+		 **************************************************/
+		void setUsePackedNonBonded(bool _flag);
+		bool getUsePackedNonBonded() const;
+
+		/**************************************************
+		 *  Incremental (delta) energy, for moves that change
+		 *  only a few atoms (i.e. Monte Carlo moves):
+		 *
+		 *    ESet->initializeEnergyDelta(); // full calculation, caches each interaction
+		 *    ... move some atoms ...
+		 *    ESet->markMoved(movedAtoms);
+		 *    double dE = ESet->calcEnergyDelta(); // only the interactions of the moved atoms
+		 *    if (accepted) {
+		 *        ESet->acceptEnergyDelta();
+		 *    } else {
+		 *        ... restore the coordinates ...
+		 *        ESet->rejectEnergyDelta(); // restores the cached energies, no calculation
+		 *    }
+		 *
+		 *  The energy is the same as calcEnergy() (active atoms,
+		 *  no selection) and the term totals (getTotalEnergy,
+		 *  getTermEnergy, getSummary) are updated.  The
+		 *  interactions of all the atoms in the group of a moved
+		 *  atom are recalculated, since the switching function
+		 *  depends on the group centers.  If interactions are
+		 *  added or removed, or the active terms change, the
+		 *  cache is rebuilt by the next calcEnergyDelta.
+		 *
+		 *  The term totals are updated by adding and subtracting
+		 *  the changes: to avoid the accumulation of rounding
+		 *  errors over long runs they are summed again from the
+		 *  cached energies every n moves (the calls of
+		 *  calcEnergyDelta that recalculated some interactions,
+		 *  default 1000, 0 never), or by resyncEnergyDelta()
+		 **************************************************/
+		double initializeEnergyDelta();
+		void markMoved(Atom & _atom);
+		void markMoved(AtomPointerVector & _atoms);
+		double calcEnergyDelta();
+		void acceptEnergyDelta();
+		void rejectEnergyDelta();
+		void resyncEnergyDelta();
+		void setEnergyDeltaResyncInterval(unsigned int _moves);
+		unsigned int getEnergyDeltaResyncInterval() const;
+
 	private:
 		void deletePointers();
 		void setup();
@@ -193,6 +272,67 @@ class EnergySet {
 
 		unsigned int stamp;
 
+		std::vector<double> gradientWorkspace; // reused by calcEnergyAndEnergyGradient
+
+		bool usePackedNonBonded;
+		bool packedNonBondedCurrent;
+		PackedNonBondedEnergy packedNonBonded;
+
+		// cache for the incremental energy
+		struct DeltaTerm {
+			std::string name;
+			std::vector<Interaction*> * pInteractions;
+			std::vector<double> energies; // unweighted
+			std::vector<bool> counted; // active with coordinates
+			std::vector<unsigned int> visited; // stamp of the last calcEnergyDelta
+			double total;
+			unsigned int counter;
+			double savedTotal; // before the last calcEnergyDelta
+			unsigned int savedCounter;
+		};
+		struct DeltaChange {
+			unsigned int term;
+			unsigned int index;
+			double energy;
+			bool counted;
+		};
+		void updateDeltaTotals();
+		void sumDeltaTerms();
+		bool deltaCurrent;
+		bool deltaRebuilt;
+		bool deltaResynced; // by the last calcEnergyDelta
+		unsigned int deltaResyncInterval;
+		unsigned int deltaMovesSinceResync;
+		unsigned int deltaStamp;
+		std::vector<DeltaTerm> deltaTerms;
+		std::map<Atom*, std::vector<std::pair<unsigned int, unsigned int> > > deltaAtomIndex; // atom -> term, interaction
+		std::vector<Atom*> deltaMovedAtoms;
+		std::vector<DeltaChange> deltaChanges; // undo log of the last calcEnergyDelta
+
+		// Verlet neighbor list for calcSwitchedEnergyAndEnergyGradient
+		struct NeighborPair {
+			Interaction * pInteraction;
+			int group1; // -1 if the interaction has no cutoffs
+			int group2;
+			double cutoffOn;
+			double cutoffOff;
+		};
+		struct NeighborTerm {
+			std::string name;
+			std::vector<NeighborPair> pairs;
+		};
+		void buildNeighborList();
+		bool neighborListNeedsRebuild() const;
+		void updateNeighborGroupCenters();
+		bool neighborListCurrent;
+		double neighborListSkin;
+		unsigned int neighborListBuilds;
+		std::vector<NeighborTerm> neighborTerms;
+		std::vector<std::vector<Atom*> > neighborGroupAtoms;
+		std::vector<CartesianPoint> neighborGroupCenters;
+		std::vector<Atom*> neighborTrackedAtoms;
+		std::vector<CartesianPoint> neighborReferenceCoors;
+
 
 };
 
@@ -202,6 +342,7 @@ inline std::map<std::string, std::map<std::string,std::vector<Interaction*> > >
 inline void EnergySet::setTermActive(std::string _termName, bool _active) {
 	if (energyTerms.find(_termName) != energyTerms.end()) {
 		activeEnergyTerms[_termName] = _active;
+		deltaCurrent = false;
 	//	std::cout << "UUU set " <<  _termName << " " << activeEnergyTerms[_termName] << std::endl;
 	}
 }
@@ -213,11 +354,13 @@ inline bool EnergySet::isTermActive(std::string _termName) const {
 	return false;
 }
 inline void EnergySet::setAllTermsInactive() {
+	deltaCurrent = false;
 	for (std::map<std::string, bool>::iterator k=activeEnergyTerms.begin(); k!=activeEnergyTerms.end(); k++) {
 		k->second = false;
 	}
 }
 inline void EnergySet::setAllTermsActive() {
+	deltaCurrent = false;
 	for (std::map<std::string, bool>::iterator k=activeEnergyTerms.begin(); k!=activeEnergyTerms.end(); k++) {
 		k->second = true;
 	}
@@ -229,8 +372,19 @@ inline unsigned int EnergySet::getTotalNumberOfInteractionsCalculated() const {
 inline double EnergySet::getTotalEnergy() const {
 	return(totalEnergy);
 }
-inline void EnergySet::setCheckForCoordinates(bool _flag) {checkForCoordinates_flag = _flag;}
+inline void EnergySet::setCheckForCoordinates(bool _flag) {checkForCoordinates_flag = _flag; deltaCurrent = false;}
 inline bool EnergySet::getCheckForCoordinates() const {return checkForCoordinates_flag;}
+inline void EnergySet::setUsePackedNonBonded(bool _flag) {usePackedNonBonded = _flag; packedNonBondedCurrent = false; packedNonBonded.clear();}
+inline bool EnergySet::getUsePackedNonBonded() const {return usePackedNonBonded;}
+inline void EnergySet::markMoved(Atom & _atom) {deltaMovedAtoms.push_back(&_atom);}
+inline void EnergySet::markMoved(AtomPointerVector & _atoms) {deltaMovedAtoms.insert(deltaMovedAtoms.end(), _atoms.begin(), _atoms.end());}
+inline void EnergySet::acceptEnergyDelta() {deltaChanges.clear(); deltaRebuilt = false; deltaResynced = false;}
+inline void EnergySet::setEnergyDeltaResyncInterval(unsigned int _moves) {deltaResyncInterval = _moves;}
+inline unsigned int EnergySet::getEnergyDeltaResyncInterval() const {return deltaResyncInterval;}
+inline void EnergySet::setNeighborListSkin(double _skin) {neighborListSkin = _skin; neighborListCurrent = false;}
+inline double EnergySet::getNeighborListSkin() const {return neighborListSkin;}
+inline unsigned int EnergySet::getNumberOfNeighborListBuilds() const {return neighborListBuilds;}
+inline void EnergySet::resetNeighborList() {neighborListCurrent = false;}
 
 inline unsigned int EnergySet::getTotalNumberOfInteractions(std::string _type){
 	std::map<std::string,std::vector<Interaction*> >::iterator it;
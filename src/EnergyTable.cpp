@@ -0,0 +1,785 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "EnergyTable.h"
+#include "MslTools.h"
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace MSL;
+using namespace std;
+
+// the pair blocks start on a 64 byte boundary (a cache line)
+#define ENERGYTABLE_ALIGNMENT 64
+
+// binary file format
+#define ENERGYTABLE_MAGIC "MSLETBL"
+#define ENERGYTABLE_VERSION 1
+#define ENERGYTABLE_BYTEORDER 0x01020304
+#define ENERGYTABLE_FLAG_FLOAT 1
+
+namespace {
+	// the header of the binary file, followed by:
+	//   rotamers               uint32 x positions
+	//   stored pairs           uint8 x positions*(positions-1)/2 (i > j, ordered by i then j)
+	//   rotamer labels         labelBytes (null terminated strings, one for each rotamer, or none)
+	//   self energies          double x selfSize
+	//   padding to bufferStart (a multiple of the alignment)
+	//   pair energies          double or float x bufferSize, the in memory layout of the buffer
+	struct EnergyTableFileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		uint32_t flags;
+		uint32_t reserved;
+		uint64_t positions;
+		uint64_t labelBytes;
+		uint64_t selfSize;
+		uint64_t bufferSize;
+		uint64_t bufferStart;
+		double fixedEnergy;
+	};
+}
+
+EnergyTable::EnergyTable() {
+	setup();
+}
+
+EnergyTable::EnergyTable(const vector<unsigned int> & _rotamers, bool _useFloat) {
+	setup();
+	resize(_rotamers, _useFloat);
+}
+
+EnergyTable::EnergyTable(const vector<vector<double> > & _selfEnergies, const vector<vector<vector<vector<double> > > > & _pairEnergies, bool _useFloat, bool _sparse) {
+	setup();
+	setTables(_selfEnergies, _pairEnergies, _useFloat, _sparse);
+}
+
+EnergyTable::EnergyTable(const EnergyTable & _table) {
+	setup();
+	copy(_table);
+}
+
+EnergyTable::~EnergyTable() {
+	deletePointers();
+}
+
+void EnergyTable::operator=(const EnergyTable & _table) {
+	copy(_table);
+}
+
+void EnergyTable::setup() {
+	useFloat = false;
+	storedPairCount = 0;
+	bufferSize = 0;
+	pDoubleBuffer = NULL;
+	pFloatBuffer = NULL;
+	fixedEnergy = 0.0;
+	pMap = NULL;
+	mapSize = 0;
+}
+
+void EnergyTable::copy(const EnergyTable & _table) {
+	if (&_table == this) {
+		return;
+	}
+	allocate(_table.rotamers, &_table.storedPairs, _table.useFloat);
+	selfEnergies = _table.selfEnergies;
+	if (useFloat) {
+		for (size_t k=0; k<bufferSize; k++) {
+			pFloatBuffer[k] = _table.pFloatBuffer[k];
+		}
+	} else {
+		for (size_t k=0; k<bufferSize; k++) {
+			pDoubleBuffer[k] = _table.pDoubleBuffer[k];
+		}
+	}
+	fixedEnergy = _table.fixedEnergy;
+	rotamerLabels = _table.rotamerLabels;
+}
+
+void EnergyTable::deletePointers() {
+	if (pMap != NULL) {
+		// the buffer points inside the mapped file
+		munmap(pMap, mapSize);
+		pMap = NULL;
+		mapSize = 0;
+	} else {
+		free(pDoubleBuffer);
+		free(pFloatBuffer);
+	}
+	pDoubleBuffer = NULL;
+	pFloatBuffer = NULL;
+	bufferSize = 0;
+}
+
+void EnergyTable::clear() {
+	deletePointers();
+	rotamers.clear();
+	selfOffsets.clear();
+	selfEnergies.clear();
+	pairOffsets.clear();
+	storedPairs.clear();
+	neighbors.clear();
+	storedPairCount = 0;
+	fixedEnergy = 0.0;
+	rotamerLabels.clear();
+}
+
+void EnergyTable::resize(const vector<unsigned int> & _rotamers, bool _useFloat) {
+	allocate(_rotamers, NULL, _useFloat);
+}
+
+void EnergyTable::resize(const vector<unsigned int> & _rotamers, const vector<vector<bool> > & _interacting, bool _useFloat) {
+	if (_interacting.size() != _rotamers.size()) {
+		cerr << "ERROR 39107: the interacting pairs table (" << _interacting.size() << ") has different size than the number of positions (" << _rotamers.size() << ") in void EnergyTable::resize(const vector<unsigned int> & _rotamers, const vector<vector<bool> > & _interacting, bool _useFloat)" << endl;
+		exit(39107);
+	}
+	for (unsigned int i=0; i<_interacting.size(); i++) {
+		if (_interacting[i].size() < i) {
+			cerr << "ERROR 39108: at position " << i << " the interacting pairs table has " << _interacting[i].size() << " positions (less than " << i << ") in void EnergyTable::resize(const vector<unsigned int> & _rotamers, const vector<vector<bool> > & _interacting, bool _useFloat)" << endl;
+			exit(39108);
+		}
+	}
+	allocate(_rotamers, &_interacting, _useFloat);
+}
+
+void EnergyTable::allocate(const vector<unsigned int> & _rotamers, const vector<vector<bool> > * _pInteracting, bool _useFloat, bool _allocateBuffer) {
+	// copy the arguments before clearing, they could belong to this object
+	vector<unsigned int> rots = _rotamers;
+	vector<vector<bool> > stored(rots.size());
+	for (unsigned int i=0; i<rots.size(); i++) {
+		stored[i].resize(i, true);
+		if (_pInteracting != NULL) {
+			for (unsigned int j=0; j<i; j++) {
+				stored[i][j] = (*_pInteracting)[i][j];
+			}
+		}
+	}
+	clear();
+	useFloat = _useFloat;
+	rotamers.swap(rots);
+	storedPairs.swap(stored);
+
+	unsigned int selfSize = 0;
+	unsigned int maxRotamers = 0;
+	for (unsigned int i=0; i<rotamers.size(); i++) {
+		selfOffsets.push_back(selfSize);
+		selfSize += rotamers[i];
+		if (rotamers[i] > maxRotamers) {
+			maxRotamers = rotamers[i];
+		}
+	}
+	selfEnergies.resize(selfSize, 0.0);
+
+	neighbors.resize(rotamers.size());
+	bool allStored = true;
+	for (unsigned int i=0; i<rotamers.size(); i++) {
+		for (unsigned int j=0; j<i; j++) {
+			if (storedPairs[i][j]) {
+				neighbors[i].push_back(j);
+				neighbors[j].push_back(i);
+				storedPairCount++;
+			} else {
+				allStored = false;
+			}
+		}
+	}
+	for (unsigned int i=0; i<neighbors.size(); i++) {
+		sort(neighbors[i].begin(), neighbors[i].end());
+	}
+
+	// each block is padded to a multiple of the alignment; the pairs that are not
+	// stored share a block of zeros at the beginning of the buffer, large enough
+	// for any pair of positions
+	size_t elementSize = useFloat ? sizeof(float) : sizeof(double);
+	size_t alignElements = ENERGYTABLE_ALIGNMENT / elementSize;
+	bufferSize = 0;
+	if (!allStored) {
+		size_t blockSize = (size_t)maxRotamers * maxRotamers;
+		bufferSize += (blockSize + alignElements - 1) / alignElements * alignElements;
+	}
+	pairOffsets.resize(rotamers.size());
+	for (unsigned int i=0; i<rotamers.size(); i++) {
+		for (unsigned int j=0; j<i; j++) {
+			if (!storedPairs[i][j]) {
+				pairOffsets[i].push_back(0);
+				continue;
+			}
+			pairOffsets[i].push_back(bufferSize);
+			size_t blockSize = (size_t)rotamers[i] * rotamers[j];
+			bufferSize += (blockSize + alignElements - 1) / alignElements * alignElements;
+		}
+	}
+	if (bufferSize == 0 || !_allocateBuffer) {
+		// the buffer of a binary file is mapped by the caller
+		return;
+	}
+
+	void * pBuffer = NULL;
+	if (posix_memalign(&pBuffer, ENERGYTABLE_ALIGNMENT, bufferSize * elementSize) != 0) {
+		cerr << "ERROR 39105: cannot allocate " << bufferSize * elementSize << " bytes in void EnergyTable::allocate(const vector<unsigned int> & _rotamers, const vector<vector<bool> > * _pInteracting, bool _useFloat, bool _allocateBuffer)" << endl;
+		exit(39105);
+	}
+	if (useFloat) {
+		pFloatBuffer = (float*)pBuffer;
+		for (size_t k=0; k<bufferSize; k++) {
+			pFloatBuffer[k] = 0.0f;
+		}
+	} else {
+		pDoubleBuffer = (double*)pBuffer;
+		for (size_t k=0; k<bufferSize; k++) {
+			pDoubleBuffer[k] = 0.0;
+		}
+	}
+}
+
+void EnergyTable::setTables(const vector<vector<double> > & _selfEnergies, const vector<vector<vector<vector<double> > > > & _pairEnergies, bool _useFloat, bool _sparse) {
+	// check that the legacy tables are consistent
+	if (_selfEnergies.size() != _pairEnergies.size()) {
+		cerr << "ERROR 39110: the self energy table (" << _selfEnergies.size() << ") has different size than the pair energy table (" << _pairEnergies.size() << ") in void EnergyTable::setTables(const vector<vector<double> > & _selfEnergies, const vector<vector<vector<vector<double> > > > & _pairEnergies, bool _useFloat, bool _sparse)" << endl;
+		exit(39110);
+	}
+	vector<unsigned int> rots;
+	for (unsigned int i=0; i<_selfEnergies.size(); i++) {
+		rots.push_back(_selfEnergies[i].size());
+	}
+	for (unsigned int i=0; i<_pairEnergies.size(); i++) {
+		if (_pairEnergies[i].size() != rots[i]) {
+			cerr << "ERROR 39115: at position " << i << " the pair energy table (" << _pairEnergies[i].size() << ") has different size than the self energy table (" << rots[i] << ") in void EnergyTable::setTables(const vector<vector<double> > & _selfEnergies, const vector<vector<vector<vector<double> > > > & _pairEnergies, bool _useFloat, bool _sparse)" << endl;
+			exit(39115);
+		}
+		for (unsigned int ir=0; ir<_pairEnergies[i].size(); ir++) {
+			// the legacy tables can be full square or lower diagonal, only the lower diagonal is used
+			if (_pairEnergies[i][ir].size() < i) {
+				cerr << "ERROR 39120: at position " << i << ", rotamer " << ir << ", unexpected size (" << _pairEnergies[i][ir].size() << " < " << i << ") in void EnergyTable::setTables(const vector<vector<double> > & _selfEnergies, const vector<vector<vector<vector<double> > > > & _pairEnergies, bool _useFloat, bool _sparse)" << endl;
+				exit(39120);
+			}
+			for (unsigned int j=0; j<i; j++) {
+				if (_pairEnergies[i][ir][j].size() != rots[j]) {
+					cerr << "ERROR 39125: at position " << i << ", rotamer " << ir << ", second position " << j << ", the pair energy table (" << _pairEnergies[i][ir][j].size() << ") has different size than the self energy table (" << rots[j] << ") in void EnergyTable::setTables(const vector<vector<double> > & _selfEnergies, const vector<vector<vector<vector<double> > > > & _pairEnergies, bool _useFloat, bool _sparse)" << endl;
+					exit(39125);
+				}
+			}
+		}
+	}
+
+	// in a sparse table only the pairs with some non zero energy are stored
+	vector<vector<bool> > interacting(rots.size());
+	for (unsigned int i=0; i<rots.size(); i++) {
+		interacting[i].resize(i, !_sparse);
+		for (unsigned int j=0; j<i && _sparse; j++) {
+			for (unsigned int ir=0; ir<rots[i] && !interacting[i][j]; ir++) {
+				for (unsigned int jr=0; jr<rots[j]; jr++) {
+					if (_pairEnergies[i][ir][j][jr] != 0.0) {
+						interacting[i][j] = true;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	resize(rots, interacting, _useFloat);
+	for (unsigned int i=0; i<_selfEnergies.size(); i++) {
+		for (unsigned int ir=0; ir<rots[i]; ir++) {
+			setSelfEnergy(i, ir, _selfEnergies[i][ir]);
+			for (unsigned int j=0; j<i; j++) {
+				for (unsigned int jr=0; jr<rots[j]; jr++) {
+					setPairEnergy(i, ir, j, jr, _pairEnergies[i][ir][j][jr]);
+				}
+			}
+		}
+	}
+}
+
+void EnergyTable::getTables(vector<vector<double> > & _selfEnergies, vector<vector<vector<vector<double> > > > & _pairEnergies) const {
+	_selfEnergies.clear();
+	_pairEnergies.clear();
+	for (unsigned int i=0; i<rotamers.size(); i++) {
+		_selfEnergies.push_back(vector<double>(rotamers[i], 0.0));
+		_pairEnergies.push_back(vector<vector<vector<double> > >(rotamers[i]));
+		for (unsigned int ir=0; ir<rotamers[i]; ir++) {
+			_selfEnergies[i][ir] = getSelfEnergy(i, ir);
+			for (unsigned int j=0; j<i; j++) {
+				_pairEnergies[i][ir].push_back(vector<double>(rotamers[j], 0.0));
+				for (unsigned int jr=0; jr<rotamers[j]; jr++) {
+					_pairEnergies[i][ir][j][jr] = getPairEnergy(i, ir, j, jr);
+				}
+			}
+		}
+	}
+}
+
+size_t EnergyTable::getMemoryUsage() const {
+	size_t out = bufferSize * (useFloat ? sizeof(float) : sizeof(double));
+	out += selfEnergies.size() * sizeof(double);
+	out += (rotamers.size() + selfOffsets.size()) * sizeof(unsigned int);
+	for (unsigned int i=0; i<pairOffsets.size(); i++) {
+		out += pairOffsets[i].size() * sizeof(size_t) + storedPairs[i].size() / 8;
+		out += neighbors[i].size() * sizeof(unsigned int);
+	}
+	return out;
+}
+
+void EnergyTable::setRotamerLabels(const vector<vector<string> > & _labels) {
+	if (_labels.size() != 0) {
+		bool fail = _labels.size() != rotamers.size();
+		for (unsigned int i=0; i<_labels.size() && !fail; i++) {
+			fail = _labels[i].size() != rotamers[i];
+		}
+		if (fail) {
+			cerr << "ERROR 39140: the rotamer labels do not match the number of rotamers of the table in void EnergyTable::setRotamerLabels(const vector<vector<string> > & _labels)" << endl;
+			exit(39140);
+		}
+	}
+	rotamerLabels = _labels;
+}
+
+bool EnergyTable::isBinaryFile(string _filename) {
+	ifstream fin(_filename.c_str(), ios::in | ios::binary);
+	char magic[8];
+	fin.read(magic, 8);
+	if (fin.fail()) {
+		return false;
+	}
+	return memcmp(magic, ENERGYTABLE_MAGIC, 8) == 0;
+}
+
+bool EnergyTable::readFile(string _filename, bool _memoryMap) {
+	if (isBinaryFile(_filename)) {
+		return readBinaryFile(_filename, _memoryMap);
+	}
+	return readTextFile(_filename);
+}
+
+bool EnergyTable::readTextFile(string _filename, bool _useFloat) {
+
+	/*
+	  TEXT FORMAT (as written by the energyTable program):
+
+	  # COMMENT LINES
+	  # SELF TERMS
+	  #  POSITION_INDEX ROTAMER_INDEX SELF_ENERGY
+	  0 0 -0.5
+	  0 1 -0.3
+	  1 0  0.1
+	  ..
+
+	  # PAIR TERMS
+	  #  POSITION_INDEX ROTAMER_INDEX POSITION_INDEX ROTAMER_INDEX PAIR_ENERGY
+	  0 0 1 0 -0.2
+	  0 0 1 1  0.5
+	  ...
+
+	  Fixed: -12.5
+
+	  The table is symmetric, a pair can be given in either order or in both (in which
+	  case the lower triangle entry, POS1 > POS2, takes precedence).  Only the pairs of
+	  positions with some non zero energy are stored.  The optional comment lines
+	    #LABEL POSITION_INDEX ROTAMER_INDEX LABEL
+	  give the rotamer labels.
+	*/
+
+	clear();
+
+	ifstream fin;
+	fin.open(_filename.c_str());
+	if (fin.fail()) {
+		cerr << "ERROR 39205: cannot open file " << _filename << " in bool EnergyTable::readTextFile(string _filename, bool _useFloat)" << endl;
+		return false;
+	}
+
+	vector<vector<double> > selfEnergy;
+	vector<vector<unsigned int> > pairIndices;
+	vector<double> pairEnergy;
+	vector<vector<unsigned int> > labelIndices;
+	vector<string> labels;
+	double fixed = 0.0;
+	string line;
+	while (getline(fin, line)) {
+		vector<string> toks = MslTools::tokenize(line);
+		if (toks.size() == 0) {
+			continue;
+		}
+		if (toks[0] == "#LABEL" && toks.size() >= 4) {
+			vector<unsigned int> indices(2, 0);
+			indices[0] = MslTools::toInt(toks[1]);
+			indices[1] = MslTools::toInt(toks[2]);
+			labelIndices.push_back(indices);
+			labels.push_back(MslTools::joinLines(vector<string>(toks.begin() + 3, toks.end()), " "));
+			continue;
+		}
+		if (toks[0][0] == '#') {
+			continue;
+		}
+		if (toks.size() == 2 && toks[0] == "Fixed:") {
+			fixed = MslTools::toDouble(toks[1]);
+		} else if (toks.size() == 3) {
+			// self energy line: POS ROT ENERGY
+			int pos = MslTools::toInt(toks[0]);
+			int rot = MslTools::toInt(toks[1]);
+			if (pos < 0 || rot < 0) {
+				cerr << "ERROR 39215: negative index in line \"" << line << "\" of file " << _filename << " in bool EnergyTable::readTextFile(string _filename, bool _useFloat)" << endl;
+				return false;
+			}
+			if (pos >= selfEnergy.size()) {
+				selfEnergy.resize(pos + 1);
+			}
+			if (rot >= selfEnergy[pos].size()) {
+				selfEnergy[pos].resize(rot + 1, 0.0);
+			}
+			selfEnergy[pos][rot] = MslTools::toDouble(toks[2]);
+		} else if (toks.size() == 5) {
+			// pair energy line: POS1 ROT1 POS2 ROT2 ENERGY, stored once the
+			// self terms have given the size of the table
+			vector<unsigned int> indices(4, 0);
+			for (unsigned int k=0; k<4; k++) {
+				int index = MslTools::toInt(toks[k]);
+				if (index < 0) {
+					cerr << "ERROR 39215: negative index in line \"" << line << "\" of file " << _filename << " in bool EnergyTable::readTextFile(string _filename, bool _useFloat)" << endl;
+					return false;
+				}
+				indices[k] = index;
+			}
+			if (indices[0] == indices[2]) {
+				cerr << "WARNING 39210: ignoring the pair line of a position with itself \"" << line << "\" in bool EnergyTable::readTextFile(string _filename, bool _useFloat)" << endl;
+				continue;
+			}
+			pairIndices.push_back(indices);
+			pairEnergy.push_back(MslTools::toDouble(toks[4]));
+		}
+	}
+
+	vector<unsigned int> rots(selfEnergy.size(), 0);
+	for (unsigned int i=0; i<selfEnergy.size(); i++) {
+		rots[i] = selfEnergy[i].size();
+	}
+	// only the pairs of positions with some non zero energy in the file are stored
+	vector<vector<bool> > interacting(rots.size());
+	for (unsigned int i=0; i<rots.size(); i++) {
+		interacting[i].resize(i, false);
+	}
+	for (unsigned int k=0; k<pairIndices.size(); k++) {
+		unsigned int p1 = pairIndices[k][0];
+		unsigned int p2 = pairIndices[k][2];
+		if (p1 >= rots.size() || p2 >= rots.size() || pairIndices[k][1] >= rots[p1] || pairIndices[k][3] >= rots[p2]) {
+			cerr << "ERROR 39215: pair " << p1 << " " << pairIndices[k][1] << " " << p2 << " " << pairIndices[k][3] << " out of the range of the self energies in file " << _filename << " in bool EnergyTable::readTextFile(string _filename, bool _useFloat)" << endl;
+			return false;
+		}
+		if (pairEnergy[k] != 0.0) {
+			interacting[max(p1, p2)][min(p1, p2)] = true;
+		}
+	}
+
+	resize(rots, interacting, _useFloat);
+	for (unsigned int i=0; i<selfEnergy.size(); i++) {
+		for (unsigned int ir=0; ir<selfEnergy[i].size(); ir++) {
+			setSelfEnergy(i, ir, selfEnergy[i][ir]);
+		}
+	}
+	// the upper triangle entries are stored first so that a lower
+	// triangle entry for the same pair takes precedence
+	for (unsigned int pass=0; pass<2; pass++) {
+		for (unsigned int k=0; k<pairIndices.size(); k++) {
+			bool lower = pairIndices[k][0] > pairIndices[k][2];
+			if (lower != (pass == 1)) {
+				continue;
+			}
+			setPairEnergy(pairIndices[k][0], pairIndices[k][1], pairIndices[k][2], pairIndices[k][3], pairEnergy[k]);
+		}
+	}
+	fixedEnergy = fixed;
+
+	if (labels.size() > 0) {
+		rotamerLabels.resize(rots.size());
+		for (unsigned int i=0; i<rots.size(); i++) {
+			rotamerLabels[i].resize(rots[i], "");
+		}
+		for (unsigned int k=0; k<labels.size(); k++) {
+			if (labelIndices[k][0] < rots.size() && labelIndices[k][1] < rots[labelIndices[k][0]]) {
+				rotamerLabels[labelIndices[k][0]][labelIndices[k][1]] = labels[k];
+			}
+		}
+	}
+	return true;
+}
+
+bool EnergyTable::writeTextFile(string _filename) const {
+	FILE * pFile = fopen(_filename.c_str(), "w");
+	if (pFile == NULL) {
+		cerr << "ERROR 39220: cannot write file " << _filename << " in bool EnergyTable::writeTextFile(string _filename) const" << endl;
+		return false;
+	}
+	// the energies are written with all their digits so that the table can be converted back and forth
+	if (rotamerLabels.size() > 0) {
+		fprintf(pFile, "# ROTAMER LABELS\n#  #LABEL POSITION_INDEX ROTAMER_INDEX LABEL\n");
+		for (unsigned int i=0; i<rotamerLabels.size(); i++) {
+			for (unsigned int ir=0; ir<rotamerLabels[i].size(); ir++) {
+				fprintf(pFile, "#LABEL %6u %6u %s\n", i, ir, rotamerLabels[i][ir].c_str());
+			}
+		}
+	}
+	fprintf(pFile, "# SELF TERMS\n#  POSITION_INDEX ROTAMER_INDEX SELF_ENERGY\n");
+	for (unsigned int i=0; i<rotamers.size(); i++) {
+		for (unsigned int ir=0; ir<rotamers[i]; ir++) {
+			fprintf(pFile, "%6u %6u %.17g\n", i, ir, getSelfEnergy(i, ir));
+		}
+	}
+	// only the stored pairs, once (lower triangle)
+	fprintf(pFile, "# PAIR TERMS\n#  POSITION_INDEX ROTAMER_INDEX POSITION_INDEX ROTAMER_INDEX PAIR_ENERGY\n");
+	for (unsigned int i=0; i<rotamers.size(); i++) {
+		for (unsigned int j=0; j<i; j++) {
+			if (!storedPairs[i][j]) {
+				continue;
+			}
+			for (unsigned int ir=0; ir<rotamers[i]; ir++) {
+				for (unsigned int jr=0; jr<rotamers[j]; jr++) {
+					fprintf(pFile, "%6u %6u %6u %6u %.17g\n", i, ir, j, jr, getPairEnergy(i, ir, j, jr));
+				}
+			}
+		}
+	}
+	fprintf(pFile, "Fixed: %.17g\n", fixedEnergy);
+	bool fail = ferror(pFile) != 0;
+	if (fclose(pFile) != 0 || fail) {
+		cerr << "ERROR 39220: cannot write file " << _filename << " in bool EnergyTable::writeTextFile(string _filename) const" << endl;
+		return false;
+	}
+	return true;
+}
+
+bool EnergyTable::writeBinaryFile(string _filename) const {
+	size_t elementSize = useFloat ? sizeof(float) : sizeof(double);
+	size_t numberOfPairs = rotamers.size() * (rotamers.size() - (rotamers.size() > 0)) / 2;
+
+	vector<uint32_t> rots(rotamers.begin(), rotamers.end());
+	vector<uint8_t> stored;
+	stored.reserve(numberOfPairs);
+	for (unsigned int i=0; i<storedPairs.size(); i++) {
+		for (unsigned int j=0; j<i; j++) {
+			stored.push_back(storedPairs[i][j]);
+		}
+	}
+	string labelData;
+	for (unsigned int i=0; i<rotamerLabels.size(); i++) {
+		for (unsigned int ir=0; ir<rotamerLabels[i].size(); ir++) {
+			labelData += rotamerLabels[i][ir];
+			labelData += '\0';
+		}
+	}
+
+	EnergyTableFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, ENERGYTABLE_MAGIC, 8);
+	header.version = ENERGYTABLE_VERSION;
+	header.byteOrder = ENERGYTABLE_BYTEORDER;
+	header.flags = useFloat ? ENERGYTABLE_FLAG_FLOAT : 0;
+	header.positions = rotamers.size();
+	header.labelBytes = labelData.size();
+	header.selfSize = selfEnergies.size();
+	header.bufferSize = bufferSize;
+	size_t metaEnd = sizeof(header) + rots.size() * sizeof(uint32_t) + stored.size() + labelData.size() + selfEnergies.size() * sizeof(double);
+	header.bufferStart = (metaEnd + ENERGYTABLE_ALIGNMENT - 1) / ENERGYTABLE_ALIGNMENT * ENERGYTABLE_ALIGNMENT;
+	header.fixedEnergy = fixedEnergy;
+
+	ofstream fout;
+	fout.open(_filename.c_str(), ios::out | ios::binary | ios::trunc);
+	if (fout.fail()) {
+		cerr << "ERROR 39225: cannot write file " << _filename << " in bool EnergyTable::writeBinaryFile(string _filename) const" << endl;
+		return false;
+	}
+	fout.write((const char*)&header, sizeof(header));
+	if (rots.size() > 0) {
+		fout.write((const char*)&rots[0], rots.size() * sizeof(uint32_t));
+	}
+	if (stored.size() > 0) {
+		fout.write((const char*)&stored[0], stored.size());
+	}
+	fout.write(labelData.data(), labelData.size());
+	if (selfEnergies.size() > 0) {
+		fout.write((const char*)&selfEnergies[0], selfEnergies.size() * sizeof(double));
+	}
+	vector<char> padding(header.bufferStart - metaEnd, 0);
+	if (padding.size() > 0) {
+		fout.write(&padding[0], padding.size());
+	}
+	if (bufferSize > 0) {
+		fout.write(useFloat ? (const char*)pFloatBuffer : (const char*)pDoubleBuffer, bufferSize * elementSize);
+	}
+	fout.close();
+	if (fout.fail()) {
+		cerr << "ERROR 39225: cannot write file " << _filename << " in bool EnergyTable::writeBinaryFile(string _filename) const" << endl;
+		return false;
+	}
+	return true;
+}
+
+namespace {
+	bool readAt(int _fd, void * _pData, size_t _size, size_t _offset) {
+		char * pData = (char*)_pData;
+		while (_size > 0) {
+			ssize_t bytes = pread(_fd, pData, _size, _offset);
+			if (bytes <= 0) {
+				return false;
+			}
+			pData += bytes;
+			_size -= bytes;
+			_offset += bytes;
+		}
+		return true;
+	}
+}
+
+bool EnergyTable::readBinaryFile(string _filename, bool _memoryMap) {
+	clear();
+
+	int fd = open(_filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		cerr << "ERROR 39230: cannot open file " << _filename << " in bool EnergyTable::readBinaryFile(string _filename, bool _memoryMap)" << endl;
+		return false;
+	}
+	struct stat fileStat;
+	EnergyTableFileHeader header;
+	if (fstat(fd, &fileStat) != 0 || !readAt(fd, &header, sizeof(header), 0) || memcmp(header.magic, ENERGYTABLE_MAGIC, 8) != 0) {
+		cerr << "ERROR 39235: " << _filename << " is not a binary energy table in bool EnergyTable::readBinaryFile(string _filename, bool _memoryMap)" << endl;
+		close(fd);
+		return false;
+	}
+	if (header.version != ENERGYTABLE_VERSION || header.byteOrder != ENERGYTABLE_BYTEORDER) {
+		cerr << "ERROR 39235: unsupported version (" << header.version << ") or byte order of the binary energy table " << _filename << " in bool EnergyTable::readBinaryFile(string _filename, bool _memoryMap)" << endl;
+		close(fd);
+		return false;
+	}
+
+	// check the sizes before reading anything
+	bool isFloat = (header.flags & ENERGYTABLE_FLAG_FLOAT) != 0;
+	size_t elementSize = isFloat ? sizeof(float) : sizeof(double);
+	uint64_t fileSize = fileStat.st_size;
+	uint64_t numberOfPairs = header.positions * (header.positions - (header.positions > 0)) / 2;
+	uint64_t metaEnd = sizeof(header) + header.positions * sizeof(uint32_t) + numberOfPairs + header.labelBytes + header.selfSize * sizeof(double);
+	if (header.positions > fileSize || header.selfSize > fileSize || header.labelBytes > fileSize || metaEnd > header.bufferStart || header.bufferStart % ENERGYTABLE_ALIGNMENT != 0 || header.bufferSize > fileSize || header.bufferStart + header.bufferSize * elementSize > fileSize) {
+		cerr << "ERROR 39240: the binary energy table " << _filename << " is truncated or corrupted in bool EnergyTable::readBinaryFile(string _filename, bool _memoryMap)" << endl;
+		close(fd);
+		return false;
+	}
+
+	vector<char> meta(metaEnd - sizeof(header));
+	if (meta.size() > 0 && !readAt(fd, &meta[0], meta.size(), sizeof(header))) {
+		cerr << "ERROR 39240: the binary energy table " << _filename << " is truncated or corrupted in bool EnergyTable::readBinaryFile(string _filename, bool _memoryMap)" << endl;
+		close(fd);
+		return false;
+	}
+	const char * pMeta = meta.size() > 0 ? &meta[0] : NULL;
+	vector<unsigned int> rots(header.positions, 0);
+	for (unsigned int i=0; i<rots.size(); i++) {
+		uint32_t value;
+		memcpy(&value, pMeta, sizeof(uint32_t));
+		rots[i] = value;
+		pMeta += sizeof(uint32_t);
+	}
+	vector<vector<bool> > stored(rots.size());
+	for (unsigned int i=0; i<rots.size(); i++) {
+		for (unsigned int j=0; j<i; j++) {
+			stored[i].push_back(*pMeta != 0);
+			pMeta++;
+		}
+	}
+	vector<string> labels;
+	const char * pLabelsEnd = pMeta + header.labelBytes;
+	while (pMeta < pLabelsEnd) {
+		const char * pEnd = (const char*)memchr(pMeta, '\0', pLabelsEnd - pMeta);
+		if (pEnd == NULL) {
+			pEnd = pLabelsEnd;
+		}
+		labels.push_back(string(pMeta, pEnd));
+		pMeta = pEnd + 1;
+	}
+	pMeta = pLabelsEnd;
+
+	// compute the layout of the buffer, allocate it only if the file is not mapped
+	allocate(rots, &stored, isFloat, !_memoryMap);
+	bool consistent = bufferSize == header.bufferSize && selfEnergies.size() == header.selfSize;
+	if (labels.size() > 0 && labels.size() != selfEnergies.size()) {
+		consistent = false;
+	}
+	if (!consistent) {
+		cerr << "ERROR 39245: the layout of the binary energy table " << _filename << " is inconsistent in bool EnergyTable::readBinaryFile(string _filename, bool _memoryMap)" << endl;
+		clear();
+		close(fd);
+		return false;
+	}
+	if (selfEnergies.size() > 0) {
+		memcpy(&selfEnergies[0], pMeta, selfEnergies.size() * sizeof(double));
+	}
+	if (labels.size() > 0) {
+		rotamerLabels.resize(rots.size());
+		for (unsigned int i=0; i<rots.size(); i++) {
+			rotamerLabels[i].assign(labels.begin() + selfOffsets[i], labels.begin() + selfOffsets[i] + rots[i]);
+		}
+	}
+	fixedEnergy = header.fixedEnergy;
+
+	if (bufferSize > 0) {
+		if (_memoryMap) {
+			// the pair energies stay in the page cache, shared by all the processes mapping the file
+			void * pData = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+			if (pData == MAP_FAILED) {
+				cerr << "ERROR 39250: cannot memory map the binary energy table " << _filename << " in bool EnergyTable::readBinaryFile(string _filename, bool _memoryMap)" << endl;
+				clear();
+				close(fd);
+				return false;
+			}
+			pMap = pData;
+			mapSize = fileSize;
+			if (useFloat) {
+				pFloatBuffer = (float*)((char*)pMap + header.bufferStart);
+			} else {
+				pDoubleBuffer = (double*)((char*)pMap + header.bufferStart);
+			}
+		} else {
+			void * pBuffer = useFloat ? (void*)pFloatBuffer : (void*)pDoubleBuffer;
+			if (!readAt(fd, pBuffer, bufferSize * elementSize, header.bufferStart)) {
+				cerr << "ERROR 39240: the binary energy table " << _filename << " is truncated or corrupted in bool EnergyTable::readBinaryFile(string _filename, bool _memoryMap)" << endl;
+				clear();
+				close(fd);
+				return false;
+			}
+		}
+	}
+	close(fd);
+	return true;
+}
@@ -0,0 +1,237 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef ENERGYTABLE_H
+#define ENERGYTABLE_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+/*************************************************************
+ *  Self and pair energy table of a rotamer optimization.
+ *
+ *  The self energies are stored in a single array (offset by
+ *  position).  The pair energies are stored in one contiguous
+ *  row-major block (rotI x rotJ) for each pair of positions
+ *  i > j (lower diagonal as the legacy nested tables
+ *  pairE[i][rotI][j][rotJ]), each block aligned to 64 bytes
+ *  inside a single buffer; an offset table gives the start of
+ *  each block.  The pair energies can optionally be stored in
+ *  single precision to halve the memory (the values are
+ *  returned as double).
+ *
+ *  The table can be sparse: only the blocks of the interacting
+ *  position pairs are stored, the others all point to a single
+ *  shared block of zeros (so the lookup has no branch).  The
+ *  optimizers can iterate over getNeighbors(pos) to skip the
+ *  pairs that are not stored.
+ *
+ *  setTables() and getTables() convert from and to the legacy
+ *  vector<vector<vector<vector<double> > > > form
+ *
+ *  The table can be saved in the text format of the energyTable
+ *  program (readTextFile/writeTextFile) or in a binary format
+ *  (readBinaryFile/writeBinaryFile): a header (version, number
+ *  of positions and rotamers, fixed energy, rotamer labels),
+ *  the self energies and then the pair buffer exactly as it is
+ *  laid out in memory.  A binary file is memory mapped read-only
+ *  by default, so that the pair energies are not copied and the
+ *  processes that read the same file share its pages.  A mapped
+ *  table cannot be modified (copy it to get a writable table).
+ *  readFile() detects the format.
+ *************************************************************/
+
+/* ERROR CODE 39xxx */
+
+namespace MSL { 
+class EnergyTable {
+	public:
+		EnergyTable();
+		EnergyTable(const std::vector<unsigned int> & _rotamers, bool _useFloat=false);
+		EnergyTable(const std::vector<std::vector<double> > & _selfEnergies, const std::vector<std::vector<std::vector<std::vector<double> > > > & _pairEnergies, bool _useFloat=false, bool _sparse=false);
+		EnergyTable(const EnergyTable & _table);
+		~EnergyTable();
+
+		void operator=(const EnergyTable & _table);
+
+		// allocate the table for the given number of rotamers by position, all energies are set to zero
+		void resize(const std::vector<unsigned int> & _rotamers, bool _useFloat=false);
+		// sparse table: only the pairs with _interacting[i][j] = true (j < i) are stored
+		void resize(const std::vector<unsigned int> & _rotamers, const std::vector<std::vector<bool> > & _interacting, bool _useFloat=false);
+		void clear();
+
+		// conversion from and to the legacy nested tables (if _sparse the pairs with all zero energies are not stored)
+		void setTables(const std::vector<std::vector<double> > & _selfEnergies, const std::vector<std::vector<std::vector<std::vector<double> > > > & _pairEnergies, bool _useFloat=false, bool _sparse=false);
+		void getTables(std::vector<std::vector<double> > & _selfEnergies, std::vector<std::vector<std::vector<std::vector<double> > > > & _pairEnergies) const;
+
+		unsigned int getNumberOfPositions() const;
+		unsigned int getNumberOfRotamers(unsigned int _pos) const;
+		const std::vector<unsigned int> & getNumberOfRotamers() const;
+		bool getUseFloat() const;
+
+		// the pairs stored in a sparse table (all pairs are stored in a dense table)
+		bool isPairStored(unsigned int _posI, unsigned int _posJ) const;
+		const std::vector<unsigned int> & getNeighbors(unsigned int _pos) const;
+		unsigned int getNumberOfStoredPairs() const;
+
+		double getSelfEnergy(unsigned int _pos, unsigned int _rot) const;
+		void setSelfEnergy(unsigned int _pos, unsigned int _rot, double _energy);
+
+		// the positions can be given in any order (the table is symmetric), _posI != _posJ.
+		// Setting a non zero energy for a pair that is not stored is an error
+		double getPairEnergy(unsigned int _posI, unsigned int _rotI, unsigned int _posJ, unsigned int _rotJ) const;
+		void setPairEnergy(unsigned int _posI, unsigned int _rotI, unsigned int _posJ, unsigned int _rotJ, double _energy);
+
+		// constant energy of the positions that are not part of the table (the "Fixed:" line of the text format)
+		void setFixedEnergy(double _energy);
+		double getFixedEnergy() const;
+
+		// optional description of the rotamers, i.e. "A,37:3" ([position][rotamer], either empty or one for each rotamer)
+		void setRotamerLabels(const std::vector<std::vector<std::string> > & _labels);
+		const std::vector<std::vector<std::string> > & getRotamerLabels() const;
+
+		// file input/output, the readers return false (and leave the table empty) if the file cannot be read
+		bool readFile(std::string _filename, bool _memoryMap=true); // binary or text
+		bool readTextFile(std::string _filename, bool _useFloat=false);
+		bool writeTextFile(std::string _filename) const;
+		bool readBinaryFile(std::string _filename, bool _memoryMap=true);
+		bool writeBinaryFile(std::string _filename) const;
+		static bool isBinaryFile(std::string _filename);
+		bool getMemoryMapped() const;
+
+		// memory used by the energies and the offset tables, in bytes (including the mapped pair energies)
+		size_t getMemoryUsage() const;
+
+	private:
+		void setup();
+		void copy(const EnergyTable & _table);
+		void deletePointers();
+		void allocate(const std::vector<unsigned int> & _rotamers, const std::vector<std::vector<bool> > * _pInteracting, bool _useFloat, bool _allocateBuffer=true);
+		size_t getPairIndex(unsigned int _posI, unsigned int _rotI, unsigned int _posJ, unsigned int _rotJ) const;
+
+		bool useFloat;
+		std::vector<unsigned int> rotamers;
+		std::vector<unsigned int> selfOffsets; // index of the first rotamer of each position in selfEnergies
+		std::vector<double> selfEnergies;
+		std::vector<std::vector<size_t> > pairOffsets; // [i][j] (j < i) start of the i,j block in the buffer
+		std::vector<std::vector<bool> > storedPairs; // [i][j] (j < i) false if the i,j block is the shared zero block
+		std::vector<std::vector<unsigned int> > neighbors; // the positions stored with each position
+		unsigned int storedPairCount;
+		size_t bufferSize; // number of elements in the buffer
+		double * pDoubleBuffer;
+		float * pFloatBuffer;
+
+		double fixedEnergy;
+		std::vector<std::vector<std::string> > rotamerLabels;
+
+		void * pMap; // the mapped binary file (the pair buffer points inside it)
+		size_t mapSize;
+};
+
+inline unsigned int EnergyTable::getNumberOfPositions() const {
+	return rotamers.size();
+}
+inline unsigned int EnergyTable::getNumberOfRotamers(unsigned int _pos) const {
+	return rotamers[_pos];
+}
+inline const std::vector<unsigned int> & EnergyTable::getNumberOfRotamers() const {
+	return rotamers;
+}
+inline bool EnergyTable::getUseFloat() const {
+	return useFloat;
+}
+inline bool EnergyTable::isPairStored(unsigned int _posI, unsigned int _posJ) const {
+	if (_posI > _posJ) {
+		return storedPairs[_posI][_posJ];
+	} else if (_posI < _posJ) {
+		return storedPairs[_posJ][_posI];
+	}
+	return false;
+}
+inline const std::vector<unsigned int> & EnergyTable::getNeighbors(unsigned int _pos) const {
+	return neighbors[_pos];
+}
+inline unsigned int EnergyTable::getNumberOfStoredPairs() const {
+	return storedPairCount;
+}
+inline void EnergyTable::setFixedEnergy(double _energy) {
+	fixedEnergy = _energy;
+}
+inline double EnergyTable::getFixedEnergy() const {
+	return fixedEnergy;
+}
+inline const std::vector<std::vector<std::string> > & EnergyTable::getRotamerLabels() const {
+	return rotamerLabels;
+}
+inline bool EnergyTable::getMemoryMapped() const {
+	return pMap != NULL;
+}
+inline double EnergyTable::getSelfEnergy(unsigned int _pos, unsigned int _rot) const {
+	return selfEnergies[selfOffsets[_pos] + _rot];
+}
+inline void EnergyTable::setSelfEnergy(unsigned int _pos, unsigned int _rot, double _energy) {
+	selfEnergies[selfOffsets[_pos] + _rot] = _energy;
+}
+inline size_t EnergyTable::getPairIndex(unsigned int _posI, unsigned int _rotI, unsigned int _posJ, unsigned int _rotJ) const {
+	if (_posI > _posJ) {
+		return pairOffsets[_posI][_posJ] + (size_t)_rotI * rotamers[_posJ] + _rotJ;
+	} else {
+		return pairOffsets[_posJ][_posI] + (size_t)_rotJ * rotamers[_posI] + _rotI;
+	}
+}
+inline double EnergyTable::getPairEnergy(unsigned int _posI, unsigned int _rotI, unsigned int _posJ, unsigned int _rotJ) const {
+	if (useFloat) {
+		return pFloatBuffer[getPairIndex(_posI, _rotI, _posJ, _rotJ)];
+	}
+	return pDoubleBuffer[getPairIndex(_posI, _rotI, _posJ, _rotJ)];
+}
+inline void EnergyTable::setPairEnergy(unsigned int _posI, unsigned int _rotI, unsigned int _posJ, unsigned int _rotJ, double _energy) {
+	if (!isPairStored(_posI, _posJ)) {
+		if (_energy != 0.0) {
+			std::cerr << "ERROR 39130: non zero energy for the pair of positions " << _posI << " and " << _posJ << " that is not stored in void EnergyTable::setPairEnergy(unsigned int _posI, unsigned int _rotI, unsigned int _posJ, unsigned int _rotJ, double _energy)" << std::endl;
+			exit(39130);
+		}
+		return;
+	}
+	if (pMap != NULL) {
+		std::cerr << "ERROR 39135: the table is memory mapped read-only in void EnergyTable::setPairEnergy(unsigned int _posI, unsigned int _rotI, unsigned int _posJ, unsigned int _rotJ, double _energy)" << std::endl;
+		exit(39135);
+	}
+	if (useFloat) {
+		pFloatBuffer[getPairIndex(_posI, _rotI, _posJ, _rotJ)] = (float)_energy;
+	} else {
+		pDoubleBuffer[getPairIndex(_posI, _rotI, _posJ, _rotJ)] = _energy;
+	}
+}
+
+}
+
+#endif
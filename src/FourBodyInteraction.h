@@ -57,7 +57,8 @@ class FourBodyInteraction: public Interaction {
 		double getDihedral() const;
 		double getDihedralRadians() const;
 		
-		bool isSelected(std::string _selection1, std::string _selection2) const;
+		bool isSelected(unsigned int _selection1, unsigned int _selection2) const;
+		using Interaction::isSelected;
 		bool isActive() const;
 
 		virtual double getEnergy()=0;
@@ -78,7 +79,7 @@ inline void FourBodyInteraction::setAtoms(std::vector<Atom*> _atoms) { if (_atom
 inline void FourBodyInteraction::setAtoms(Atom & _a1, Atom & _a2, Atom & _a3, Atom & _a4) { pAtoms[0] = &_a1; pAtoms[1] = &_a2; pAtoms[2] = &_a3;; pAtoms[3] = &_a4; }
 inline double FourBodyInteraction::getDihedral() const {return pAtoms[0]->dihedral(*pAtoms[1], *pAtoms[2], *pAtoms[3]);}
 inline double FourBodyInteraction::getDihedralRadians() const {return pAtoms[0]->dihedralRadians(*pAtoms[1], *pAtoms[2], *pAtoms[3]);}
-inline bool FourBodyInteraction::isSelected(std::string _selection1, std::string _selection2) const {
+inline bool FourBodyInteraction::isSelected(unsigned int _selection1, unsigned int _selection2) const {
 	if (improper_selection) {
 		// improper, select on the first atom
 		if (pAtoms[0]->getSelectionFlag(_selection1) && pAtoms[0]->getSelectionFlag(_selection2)) {
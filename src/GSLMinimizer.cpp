@@ -65,10 +65,14 @@ void GSLMinimizer::setup(EnergySet* _es, AtomPointerVector* _av){
 		}
 	}
 	
+	coordinatesSynced = false;
 	stepsize = 0.1;
 	tolerance = 0.01;
 	maxIterations = 200;
 	minimizeAlgorithm = BFGS;
+	useNeighborList = false;
+	neighborListSkin = 2.0;
+	neighborListBuilds = 0;
 }
 
 void GSLMinimizer::resetConstraints() {
@@ -148,6 +152,15 @@ bool GSLMinimizer::minimize(){
 	size = retval = iter = status = 0;
 	int coordinateSize = pAtoms->size()*3;
 
+	// the atoms could have been moved since the last minimization
+	coordinatesSynced = false;
+	unsigned int buildsAtStart = 0;
+	if (useNeighborList) {
+		// the atoms could have been moved, or the interactions changed, the list is rebuilt
+		pEset->setNeighborListSkin(neighborListSkin);
+		buildsAtStart = pEset->getNumberOfNeighborListBuilds();
+	}
+
 	// Compute the initial value
 	double initialValue, minimizedValue, deltaValue;
 	minimizedValue = deltaValue = MslTools::doubleMax;
@@ -305,6 +318,10 @@ bool GSLMinimizer::minimize(){
 		deltaValue     = (minimizedValue - initialValue);
 		//fprintf(stdout,"==> Minimized Value: %8.3f.  Value before minimization: %8.3f\n",minimizedValue,initialValue);
 	}
+	neighborListBuilds = 0;
+	if (useNeighborList) {
+		neighborListBuilds = pEset->getNumberOfNeighborListBuilds() - buildsAtStart;
+	}
 	gsl_vector_free(ss);
 	gsl_vector_free(gslData);
 
@@ -339,45 +356,82 @@ void GSLMinimizer::my_static_fdf(const gsl_vector *_xvec_ptr, void *_params,doub
 
 
 double GSLMinimizer::my_f(const gsl_vector *_xvec_ptr, void *_params){
+	if (useNeighborList) {
+		// switched energy, consistent with the gradient
+		return pEset->calcSwitchedEnergyAndEnergyGradient((double*)NULL);
+	}
 	// Calculate energy without the switching function.
 	return pEset->calcEnergyWithoutSwitchingFunction();
 }
 
 void GSLMinimizer::my_df(const gsl_vector *_xvec_ptr, void *_params, gsl_vector *_df) {
-
-	vector<double> gradient(pAtoms->size()*3,0.0);
-	pEset->calcEnergyGradient(gradient);
-
-	for (uint i=0; i < gradient.size();i+=1){
-		gsl_vector_set(_df, i, gradient[i]);
-	}
+	calcEnergyAndGradient(_df);
 }
 
 void GSLMinimizer::my_fdf(const gsl_vector *_x, void *_params, double *_f, gsl_vector *_df) {
-	// New way compute Energy and Gradient with single EnergySet Function
-	vector<double> gradient(pAtoms->size() * 3,0.0);
-	
-	*_f = pEset->calcEnergyAndEnergyGradient(gradient);
+	// Compute Energy and Gradient in a single pass with the EnergySet
+	*_f = calcEnergyAndGradient(_df);
 	//cout << "Energy: " << *_f << endl;
+}
 
-	for (uint i=0; i < gradient.size();i+=1){
-		gsl_vector_set(_df, i, gradient[i]);
+double GSLMinimizer::calcEnergyAndGradient(gsl_vector *_df) {
+	// the interactions add their gradient directly into the GSL vector
+	// (indexed by the minimization index of the atoms)
+	gsl_vector_set_zero(_df);
+	if (_df->size == 0) {
+		if (useNeighborList) {
+			return pEset->calcSwitchedEnergyAndEnergyGradient((double*)NULL);
+		}
+		return pEset->calcEnergyAndEnergyGradient((double*)NULL);
 	}
-	// Old way, this works but is less efficient.
-	/*
-       *f = my_f(x, params); 
-       my_df(x, params, df);
-	*/
+	if (_df->stride == 1) {
+		if (useNeighborList) {
+			return pEset->calcSwitchedEnergyAndEnergyGradient(_df->data);
+		}
+		return pEset->calcEnergyAndEnergyGradient(_df->data);
+	}
+	gradientBuffer.assign(_df->size, 0.0);
+	double energy = 0.0;
+	if (useNeighborList) {
+		energy = pEset->calcSwitchedEnergyAndEnergyGradient(&gradientBuffer[0]);
+	} else {
+		energy = pEset->calcEnergyAndEnergyGradient(&gradientBuffer[0]);
+	}
+	for (uint i=0; i < gradientBuffer.size();i++){
+		gsl_vector_set(_df, i, gradientBuffer[i]);
+	}
+	return energy;
 }
 
 
 void GSLMinimizer::resetCoordinates(const gsl_vector *_xvec_ptr){
 	
 	//cout << "Reset Coords "<<(*pAtoms).size()<<","<<(*pAtoms).size()*3<<endl;
+	uint coordinateSize = pAtoms->size()*3;
+	const double * x = _xvec_ptr->data;
+	size_t stride = _xvec_ptr->stride;
+	if (coordinatesSynced && syncedCoordinates.size() == coordinateSize) {
+		bool changed = false;
+		for (uint i=0;i<coordinateSize;i++) {
+			if (x[i*stride] != syncedCoordinates[i]) {
+				changed = true;
+				break;
+			}
+		}
+		if (!changed) {
+			// same point of the previous call, the atoms are already there
+			return;
+		}
+	}
+	syncedCoordinates.resize(coordinateSize);
 	uint a = 0;
-	for (uint i=0;i<pAtoms->size()*3;i+=3) {
-		(*pAtoms)[a]->setCoor(gsl_vector_get(_xvec_ptr,i),gsl_vector_get(_xvec_ptr,i+1),gsl_vector_get(_xvec_ptr,i+2));
+	for (uint i=0;i<coordinateSize;i+=3) {
+		syncedCoordinates[i] = x[i*stride];
+		syncedCoordinates[i+1] = x[(i+1)*stride];
+		syncedCoordinates[i+2] = x[(i+2)*stride];
+		(*pAtoms)[a]->setCoor(syncedCoordinates[i],syncedCoordinates[i+1],syncedCoordinates[i+2]);
 		a++;
 	}
+	coordinatesSynced = true;
 
 }
@@ -74,6 +74,18 @@ class GSLMinimizer  {
 		void setMinimizeAlgorithm(int _minAlgo);
 		int getMinimizeAlgorithm();
 
+		/* By default (false) the energy is calculated without the switching function on all
+		 * interactions, as in the older versions.  If true, the energy and the gradient include the
+		 * switching function of the non bonded terms, and the interactions come from a neighbor list
+		 * (see EnergySet::calcSwitchedEnergyAndEnergyGradient) which is rebuilt only when an atom
+		 * moved more than half of the skin
+		 */
+		void setUseNeighborList(bool _flag);
+		bool getUseNeighborList();
+		void setNeighborListSkin(double _skin);
+		double getNeighborListSkin();
+		unsigned int getNumberOfNeighborListBuilds(); // during the last minimization
+
 		/* Restrict Minimization when using pAtoms...
 		* Adds CONSTRAINT interactions to the system's energySet to simulate pAtoms on a spring
 		* So once minimization is done, a single call to removeConstraints is necessary
@@ -103,6 +115,9 @@ class GSLMinimizer  {
 		double tolerance;
 		int    maxIterations;
 		int    minimizeAlgorithm;    
+		bool   useNeighborList;
+		double neighborListSkin;
+		unsigned int neighborListBuilds;
 
 		void addSpringInteraction(Atom* a1, double _springConstant);
 
@@ -111,6 +126,13 @@ class GSLMinimizer  {
 
 		void setup(EnergySet* _es, AtomPointerVector* _av);
 		void resetCoordinates(const gsl_vector *xvec_ptr);
+		double calcEnergyAndGradient(gsl_vector *_df);
+
+		// the coordinates last copied to the atoms: GSL often evaluates the energy and
+		// the gradient at the same point, the atoms are updated only if the point changed
+		std::vector<double> syncedCoordinates;
+		bool coordinatesSynced;
+		std::vector<double> gradientBuffer; // used only if the GSL gradient is not contiguous
 
 		// Defining function pointers
 		double  my_f   (const gsl_vector *xvec_ptr, void *params);
@@ -139,4 +161,10 @@ inline int GSLMinimizer::getMaxIterations(){ return maxIterations;}
 inline void GSLMinimizer::setMinimizeAlgorithm(int _minAlgo){ minimizeAlgorithm = _minAlgo; }
 inline int GSLMinimizer::getMinimizeAlgorithm(){ return minimizeAlgorithm;}
 
+inline void GSLMinimizer::setUseNeighborList(bool _flag){ useNeighborList = _flag; }
+inline bool GSLMinimizer::getUseNeighborList(){ return useNeighborList;}
+inline void GSLMinimizer::setNeighborListSkin(double _skin){ neighborListSkin = _skin; }
+inline double GSLMinimizer::getNeighborListSkin(){ return neighborListSkin;}
+inline unsigned int GSLMinimizer::getNumberOfNeighborListBuilds(){ return neighborListBuilds;}
+
 };
@@ -38,5 +38,15 @@ Interaction::Interaction() {
 Interaction::~Interaction() {
 }
 
+double Interaction::getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace) {
+	// clear keeps the capacity, the derivative functions resize the vector
+	_workspace.clear();
+	double energy = getEnergy(&_workspace);
+	if (_workspace.size() >= 3 * pAtoms.size()) {
+		addGradient(_gradients, &_workspace[0], 1.0);
+	}
+	return energy;
+}
+
 
 
@@ -31,6 +31,7 @@ You should have received a copy of the GNU Lesser General Public
 #define INTERACTION_H
 
 #include <vector>
+#include <cmath>
 
 #include "Atom.h"
 
@@ -55,7 +56,10 @@ class Interaction {
 		void setParams(std::vector<double> _params);
 		bool hasAtom(Atom * _pAtom) const;
 
-		virtual bool isSelected(std::string _sele1, std::string _sele2) const=0;
+		// selection test on the integer ids of the atom selections (see Selectable::findSelectionId)
+		virtual bool isSelected(unsigned int _sele1, unsigned int _sele2) const=0;
+		// wrapper, converts the selection names to ids
+		bool isSelected(std::string _sele1, std::string _sele2) const;
 		virtual bool isActive() const=0;
 		virtual double getEnergy()=0;
 
@@ -66,6 +70,19 @@ class Interaction {
 		virtual double getEnergy(std::vector<double> *_paramDerivatives)=0; // computes dE/dx1,dE/dy1,dE/dz1.....and stores in _paramDerivatives and returns energy
 		virtual std::vector<double> getEnergyGrad()=0; // computes  and returns dE/dx1,dE/dy1,dE/dz1....
 
+		// used by the minimizer, as getEnergy(std::vector<double>*) but the dE/dx,dE/dy,dE/dz of each atom are added to
+		// the flat gradient of the minimized atoms, _gradients[3*(i-1)], [3*(i-1)+1], [3*(i-1)+2] where i is the
+		// minimization index of the atom (the atoms with index -1 are skipped).  _workspace is reused between calls
+		// so that no memory is allocated; the most common interactions override it with a fused computation
+		virtual double getEnergyAndAddGradient(double * _gradients, std::vector<double> & _workspace);
+
+		// the CHARMM non bonded terms can be switched off between two cutoffs, as a function of the distance
+		// between the centers of the atom groups of their first two atoms (see CharmmEnergy::switchingFunction).
+		// The other interactions do not use cutoffs
+		virtual bool getUseNonBondCutoffs() const;
+		virtual double getNonBondCutoffOn() const;
+		virtual double getNonBondCutoffOff() const;
+
 
 		virtual bool reset();
 		
@@ -89,6 +106,11 @@ class Interaction {
 		 *************************************************/
 		enum SelectionTypes { none=0, single=1, distance=2, angle=3, dihedral=4, improper=5 };
 		Interaction();
+		// adds _factor * _atomGradients (dE/dx1,dE/dy1,dE/dz1...) to the flat gradient of the minimized atoms
+		void addGradient(double * _gradients, const double * _atomGradients, double _factor) const;
+		// distance of the first two atoms and its derivative (as CartesianGeometry::distanceDerivative)
+		double distanceDerivative(double * _derivative) const;
+
 		std::vector<Atom*> pAtoms;
 		std::vector<double> params;
 
@@ -104,7 +126,11 @@ inline Atom * Interaction::operator[](size_t _n) {return pAtoms[_n];}
 inline double Interaction::operator()(size_t _n) {return params[_n];}
 inline void Interaction::setAtoms(std::vector<Atom*> _atoms) {pAtoms = _atoms;}
 inline void Interaction::setParams(std::vector<double> _params) {params = _params;}
+inline bool Interaction::isSelected(std::string _sele1, std::string _sele2) const {return isSelected(Atom::findSelectionId(_sele1), Atom::findSelectionId(_sele2));}
 inline void Interaction::update() {} // emtpy function, some terms, like charmm elec might need to update
+inline bool Interaction::getUseNonBondCutoffs() const {return false;}
+inline double Interaction::getNonBondCutoffOn() const {return 0.0;}
+inline double Interaction::getNonBondCutoffOff() const {return 0.0;}
 inline bool Interaction::atomsHaveCoordinates() const {
 	for (std::vector<Atom*>::const_iterator k=pAtoms.begin(); k!=pAtoms.end(); k++) {
 		if (*k == NULL || !(*k)->hasCoor()) {
@@ -117,6 +143,42 @@ inline bool Interaction::reset() {
 	std::cerr << "Reset not Implemented for this interaction type" << std::endl;
 	return false;
 }
+inline void Interaction::addGradient(double * _gradients, const double * _atomGradients, double _factor) const {
+	for (unsigned int a=0; a<pAtoms.size(); a++) {
+		int index = pAtoms[a]->getMinimizationIndex();
+		if (index == -1) {
+			continue;
+		}
+		double * pGradient = _gradients + 3 * (index - 1);
+		pGradient[0] += _atomGradients[3*a] * _factor;
+		pGradient[1] += _atomGradients[3*a+1] * _factor;
+		pGradient[2] += _atomGradients[3*a+2] * _factor;
+	}
+}
+inline double Interaction::distanceDerivative(double * _derivative) const {
+	const CartesianPoint & p1 = pAtoms[0]->getCoor();
+	const CartesianPoint & p2 = pAtoms[1]->getCoor();
+	double dx = p1.getX() - p2.getX();
+	double dy = p1.getY() - p2.getY();
+	double dz = p1.getZ() - p2.getZ();
+	double dist = sqrt(dx * dx + dy * dy + dz * dz);
+	if (dist < 0.0000000000000001) {
+		_derivative[0] = (p1.getX() < p2.getX() ? -1 : 1);
+		_derivative[1] = (p1.getY() < p2.getY() ? -1 : 1);
+		_derivative[2] = (p1.getZ() < p2.getZ() ? -1 : 1);
+		_derivative[3] = (p2.getX() < p1.getX() ? -1 : 1);
+		_derivative[4] = (p2.getY() < p1.getY() ? -1 : 1);
+		_derivative[5] = (p2.getZ() < p1.getZ() ? -1 : 1);
+	} else {
+		_derivative[0] = dx / dist;
+		_derivative[1] = dy / dist;
+		_derivative[2] = dz / dist;
+		_derivative[3] = - _derivative[0];
+		_derivative[4] = - _derivative[1];
+		_derivative[5] = - _derivative[2];
+	}
+	return dist;
+}
 inline bool Interaction::hasAtom(Atom * _pAtom) const {
 	for (std::vector<Atom*>::const_iterator k=pAtoms.begin(); k!=pAtoms.end(); k++) {
 		if (_pAtom == *k) {
@@ -58,29 +58,19 @@ void MonteCarloOptimization::deletePointers() {
 }
 
 void MonteCarloOptimization::deleteEnergyTables() {
-	if(responsibleForEnergyTableMemory ) {
-		if(selfEnergy) {
-			delete selfEnergy;
-			selfEnergy = NULL;
-		}
-		if(pairEnergy) {
-			delete pairEnergy;
-			pairEnergy = NULL;
-		}
-	}
+	ownedTable.clear();
+	pTable = NULL;
 }
 
 
 void MonteCarloOptimization::setup() {
 	// Set defaults
-	selfEnergy              = NULL;
-	pairEnergy              = NULL;
+	pTable                  = NULL;
 
 	totalNumPositions       = 0;
 	initType                = LOWESTSELF;
 	numStoredConfigurations = 10;
 
-	responsibleForEnergyTableMemory = false;
 	pRng = new RandomNumberGenerator;
 	deleteRng = true;
 
@@ -91,7 +81,7 @@ void MonteCarloOptimization::setup() {
 void MonteCarloOptimization::setSelfPairManager(SelfPairManager* _pSpm) {
 	pSpm = _pSpm;
 	if(pSpm) {
-		addEnergyTable(pSpm->getSelfEnergy(),pSpm->getPairEnergy());
+		addEnergyTable(pSpm->getEnergyTable());
 	}
 
 	totalNumPositions = pSpm->getNumberOfVariablePositions();
@@ -101,136 +91,20 @@ void MonteCarloOptimization::setSelfPairManager(SelfPairManager* _pSpm) {
 
 void MonteCarloOptimization::readEnergyTable(string _filename){
 
-	/*
-	  ENERGY TABLE FILE FORMAT:
-	  
-	  # COMMENT LINES
-	  # SELF TERMS
-	  #  POSITION_INDEX ROTAMER_INDEX SELF_ENERGY
-	  0 0 -0.5
-	  0 1 -0.3
-	  1 0  0.1
-	  ..
-
-	  # PAIR TERMS
-	  #  POSITION_INDEX ROTAMER_INDEX POSITION_INDEX ROTAMER_INDEX PAIR_ENERGY
-	  0 0 1 0 -0.2
-	  0 0 1 1  0.5
-	  ...
-	  
-	*/
+	// text (the format of the energyTable program) or binary energy table, see
+	// EnergyTable::readTextFile and EnergyTable::writeBinaryFile.  A binary table
+	// is memory mapped read-only
 
 	// This object is now responsible for the energy table memory.
 
 	deleteEnergyTables();
 
-	responsibleForEnergyTableMemory = true;
-
-	selfEnergy = new vector<vector<double> >();
-	pairEnergy = new vector<vector<vector<vector<double> > > >();
-
-	ifstream fin;
-	string line;
-	try {
-		fin.open(_filename.c_str());
-		if (fin.fail()){
-			cerr << "ERROR 8904 in MonteCarloOptimization::readEnergyTable opening file "<<_filename<<endl;
-			exit(8904);
-		}
-		
-		bool firstPair = true;
-		while (!fin.fail()){
-			getline(fin,line);
-			if (line[0] == '#') continue;
-			if (line.length() <= 1) continue;
-
-
-
-			vector<string> toks = MslTools::tokenize(line);
-
-			
-			// self Energy Line has 3 numbers on it
-			if (toks.size() == 3){
-				int posIndex = MslTools::toInt(toks[0]);
-				if (selfEnergy->size() < posIndex+1){
-					vector<double> tmp;
-					selfEnergy->push_back(tmp);
-				}
-
-				(*selfEnergy)[posIndex].push_back(MslTools::toDouble(toks[2]));
-				
-			}
-
-
-
-			// pair Energy Line has 5 numbers on it
-			/*
-			  TODO:
-			     Make sure pairEnergy is not a full sized table.
-			      it should only be a triangle - lower triangular.
-			      resize(i+1) for pairEnergy[i]?
-			 */
-			if (toks.size() == 5){
-
-				if (firstPair){
-					pairEnergy->resize(selfEnergy->size());
-					// For each position resize to
-					// num rotamers
-					for (uint i = 0; i < selfEnergy->size();i++){
-						(*pairEnergy)[i].resize((*selfEnergy)[i].size());
-
-						// For each rotamer,
-						// resize to num positions in lower triangle
-						for (uint j = 0; j < (*selfEnergy)[i].size();j++){
-							(*pairEnergy)[i][j].resize(i);
-
-							// For each position resize to num rotamers
-							for (uint k = 0; k < (*pairEnergy)[i][j].size();k++){
-								(*pairEnergy)[i][j][k].resize((*selfEnergy)[k].size());
-
-							}
-						}
-
-					}
-				}
-				firstPair = false;
-				
-				// Add to pairEnergy object. Indices pairEnergy[POS1][ROT1][POS2][ROT2] = ENERGY;
-				int p1 = MslTools::toInt(toks[0]);
-				int r1 = MslTools::toInt(toks[1]);
-				int p2 = MslTools::toInt(toks[2]);
-				int r2 = MslTools::toInt(toks[3]);
-				if(p1 > p2) {
-					(*pairEnergy)[p1][r1][p2][r2] = MslTools::toDouble(toks[4]);
-				} else if(p2 > p1) {
-					(*pairEnergy)[p2][r2][p1][r1] = MslTools::toDouble(toks[4]);
-				} else {
-					cerr << "WARNING 12343: IGNORING LINE: " << line << endl;
-				}
-
-				// Add symmetric entries into the pairEnergy table ****NO NEED****
-				// pairEnergy[toInt(toks[2])][toInt(toks[3])][toInt(toks[0])][toInt(toks[1])] = toDouble(toks[4]);
-				
-			}
-		}
-	} catch (...){
-		cerr << "ERROR 7809 in MonteCarloOptimization::readEnergyTable in file: "<<_filename<<endl;
-		exit(7809);
-	}
-
-
-	totalNumPositions = (*selfEnergy).size();
-	inputMasks.clear();
-	inputMasks.resize(totalNumPositions);
-	currentState.clear();
-	currentState.resize(totalNumPositions);
-	for (uint i = 0; i < inputMasks.size();i++){
-		inputMasks[i].resize((*selfEnergy)[i].size());
-		currentState[i] = 0;
-		for (uint j = 0; j < inputMasks[i].size();j++){
-			inputMasks[i][j] = true;
-		}
+	if (!ownedTable.readFile(_filename)){
+		cerr << "ERROR 8904 in MonteCarloOptimization::readEnergyTable reading file "<<_filename<<endl;
+		exit(8904);
 	}
+	pTable = &ownedTable;
+	initializeStates();
 
 }
 
@@ -336,24 +210,33 @@ void MonteCarloOptimization::addEnergyTable(vector<vector<double> > &_selfEnergy
 
 	deleteEnergyTables();
 
-	selfEnergy = &_selfEnergy;
-	pairEnergy = &_pairEnergy; 
-	responsibleForEnergyTableMemory = false;
-	
-	totalNumPositions = _selfEnergy.size();
+	// the nested tables are copied into a flat table owned by this object (the
+	// pairs of positions with all zero energies are not stored)
+	ownedTable.setTables(_selfEnergy, _pairEnergy, false, true);
+	pTable = &ownedTable;
+	initializeStates();
+}
+
+void MonteCarloOptimization::addEnergyTable(EnergyTable & _table) {
+	deleteEnergyTables();
+
+	pTable = &_table;
+	initializeStates();
+}
+
+void MonteCarloOptimization::initializeStates() {
+	totalNumPositions = pTable->getNumberOfPositions();
 	inputMasks.clear();
 	inputMasks.resize(totalNumPositions);
 	currentState.clear();
 	currentState.resize(totalNumPositions);
 	for (uint i = 0; i < inputMasks.size();i++){
-		inputMasks[i].resize((*selfEnergy)[i].size());
+		inputMasks[i].resize(pTable->getNumberOfRotamers(i));
 		currentState[i] = 0;
 		for (uint j = 0; j < inputMasks[i].size();j++){
 			inputMasks[i][j] = true;
 		}
 	}
-
-	
 }
 
 
@@ -498,7 +381,7 @@ void MonteCarloOptimization::initialize(){
 			if (pSpm){
 			  numTotalRotamers = pSpm->getNumberOfRotamers()[i];
 			} else {
-			  numTotalRotamers = (*selfEnergy)[i].size();
+			  numTotalRotamers = pTable->getNumberOfRotamers(i);
 			}
 			int rot       = pRng->getRandomInt(numTotalRotamers-1);
 			for (uint j = 0; j < numTotalRotamers;j++){
@@ -511,7 +394,7 @@ void MonteCarloOptimization::initialize(){
 				if (pSpm){
 				  selfE = pSpm->computeSelfE(i,j);
 				} else {
-				  selfE = (*selfEnergy)[i][j];
+				  selfE = pTable->getSelfEnergy(i, j);
 				}
 			        MSLOUT.stream() << "\tRotamer: "<<j<<" selfE: "<<selfE<<endl;
 				if (selfE < energy){
@@ -536,7 +419,7 @@ void MonteCarloOptimization::initialize(){
 			if (pSpm){
 			  numTotalRotamers = pSpm->getNumberOfRotamers()[pos];
 			} else {
-			  numTotalRotamers = (*selfEnergy)[pos].size();
+			  numTotalRotamers = pTable->getNumberOfRotamers(pos);
 			}
 			int rot       = pRng->getRandomInt(numTotalRotamers-1);
 
@@ -563,7 +446,7 @@ void MonteCarloOptimization::initialize(){
 			if (pSpm){
 			  numRotamers = pSpm->getNumberOfRotamers()[energies[i].first];
 			} else {
-			  numRotamers = (*selfEnergy)[energies[i].first].size();
+			  numRotamers = pTable->getNumberOfRotamers(energies[i].first);
 			}
 
 
@@ -614,7 +497,7 @@ double MonteCarloOptimization::getEnergy(int _pos, int _rot){
 		for (uint i = 0;i <currentState.size();i++){
 			int pos2 = i;
 			int rot2 = currentState[i];
-			if (_pos == pos2) continue;
+			if (_pos == pos2 || !pTable->isPairStored(_pos, pos2)) continue;
 			// IF _pos is LINKED THEN WHAT?
 			// Then if pos2 is linked to _pos, we need to use _rot instead of rot2?
 			if (_pos > pos2){
@@ -624,17 +507,17 @@ double MonteCarloOptimization::getEnergy(int _pos, int _rot){
 			}
 		}
 	} else {
-		energy += (*selfEnergy)[_pos][_rot];
+		energy += pTable->getSelfEnergy(_pos, _rot);
 		for (uint i = 0;i <currentState.size();i++){
 			int pos2 = i;
 			int rot2 = currentState[i];
-			if (_pos == pos2) continue;
+			if (_pos == pos2 || !pTable->isPairStored(_pos, pos2)) continue;
 			// IF _pos is LINKED THEN WHAT?
 			// Then if pos2 is linked to _pos, we need to use _rot instead of rot2?
 			if (_pos > pos2){
-				energy += (*pairEnergy)[_pos][_rot][pos2][rot2];
+				energy += pTable->getPairEnergy(_pos, _rot, pos2, rot2);
 			} else {
-				energy += (*pairEnergy)[pos2][rot2][_pos][_rot];
+				energy += pTable->getPairEnergy(pos2, rot2, _pos, _rot);
 			}
 		}
 	}
@@ -644,7 +527,7 @@ double MonteCarloOptimization::getEnergy(int _pos, int _rot){
 double MonteCarloOptimization::getStateEnergy(vector<unsigned int> _states) {
 	double energy = 0.0;
 	// Check that the states are indeed valid
-	if(_states.size() != selfEnergy->size()) {
+	if(_states.size() != pTable->getNumberOfPositions()) {
 		cerr << "ERROR: The number of positions doesnot agree with selfEnergy Table in double MonteCarloOptimization::getStateEnergy(vector<unsigned int> _states) " << endl;
 		return energy;
 	}
@@ -654,18 +537,20 @@ double MonteCarloOptimization::getStateEnergy(vector<unsigned int> _states) {
 	} else {
 		for (uint i = 0 ;i < _states.size();i++){
 			
-			//MSLOUT.stream() << "Adding self: "<<(*selfEnergy)[i][currentState[i]]<<endl;
-			if( _states[i] < (*selfEnergy)[i].size()) {
-				energy += (*selfEnergy)[i][_states[i]];
+			//MSLOUT.stream() << "Adding self: "<<pTable->getSelfEnergy(i, currentState[i])<<endl;
+			if( _states[i] < pTable->getNumberOfRotamers(i)) {
+				energy += pTable->getSelfEnergy(i, _states[i]);
 			} else {
 				cerr << "ERROR: SelfEnergyTable for Position " << i << " doesnot contain rotamer " << _states[i] << " in double MonteCarloOptimization::getStateEnergy(vector<unsigned int> _states) " << endl;
 				return energy;
 			}
 			for (uint j = 0; j < i;j++){
-				//MSLOUT.stream() << "Adding Position "<<i<<" to "<<j<<" which is "<<(*pairEnergy)[i][currentState[i]][j][currentState[jxo]]<<endl;
+				//MSLOUT.stream() << "Adding Position "<<i<<" to "<<j<<" which is "<<pTable->getPairEnergy(i, currentState[i], j, currentState[jxo])<<endl;
 				
-				//energy += (*pairEnergy)[j][currentState[j]][i][currentState[i]];
-				energy += (*pairEnergy)[i][_states[i]][j][_states[j]];
+				//energy += pTable->getPairEnergy(j, currentState[j], i, currentState[i]);
+				if (pTable->isPairStored(i, j)) {
+					energy += pTable->getPairEnergy(i, _states[i], j, _states[j]);
+				}
 			}
 		}
 	}
@@ -681,13 +566,15 @@ double MonteCarloOptimization::getStateEnergy(){
 	} else {
 		for (uint i = 0 ;i < totalNumPositions;i++){
 			
-			//MSLOUT.stream() << "Adding self: "<<(*selfEnergy)[i][currentState[i]]<<endl;
-			energy += (*selfEnergy)[i][currentState[i]];
+			//MSLOUT.stream() << "Adding self: "<<pTable->getSelfEnergy(i, currentState[i])<<endl;
+			energy += pTable->getSelfEnergy(i, currentState[i]);
 			for (uint j = 0; j < i;j++){
-				//MSLOUT.stream() << "Adding Position "<<i<<" to "<<j<<" which is "<<(*pairEnergy)[i][currentState[i]][j][currentState[jxo]]<<endl;
+				//MSLOUT.stream() << "Adding Position "<<i<<" to "<<j<<" which is "<<pTable->getPairEnergy(i, currentState[i], j, currentState[jxo])<<endl;
 				
-				//energy += (*pairEnergy)[j][currentState[j]][i][currentState[i]];
-				energy += (*pairEnergy)[i][currentState[i]][j][currentState[j]];
+				//energy += pTable->getPairEnergy(j, currentState[j], i, currentState[i]);
+				if (pTable->isPairStored(i, j)) {
+					energy += pTable->getPairEnergy(i, currentState[i], j, currentState[j]);
+				}
 
 			}
 		}
@@ -697,10 +584,10 @@ double MonteCarloOptimization::getStateEnergy(){
 
 void MonteCarloOptimization::printMe(bool _selfOnly){
 	fprintf(stdout,"Self terms:\n");
-	for (uint i = 0; i < (*selfEnergy).size();i++){
-		for (uint j = 0; j < (*selfEnergy)[i].size();j++){
+	for (uint i = 0; i < pTable->getNumberOfPositions();i++){
+		for (uint j = 0; j < pTable->getNumberOfRotamers(i);j++){
 
-			fprintf(stdout, "    %4d %4d %8.3f", i, j, (*selfEnergy)[i][j]);
+			fprintf(stdout, "    %4d %4d %8.3f", i, j, pTable->getSelfEnergy(i, j));
 			// alive Rotamers	
 			if (bestState[i] == j) {
 				fprintf(stdout, " **** ");
@@ -717,15 +604,15 @@ void MonteCarloOptimization::printMe(bool _selfOnly){
 	}
 
 	fprintf(stdout,"Pair terms:\n");
-	for (uint i = 0; i < (*pairEnergy).size();i++){
-		for (uint j = 0; j < (*pairEnergy)[i].size();j++){
-			//for (uint k = i+1 ; k < (*pairEnergy)[i][j].size();k++){	
-			for (uint k = 0 ; k < (*pairEnergy)[i][j].size();k++){	
+	for (uint i = 0; i < pTable->getNumberOfPositions();i++){
+		for (uint j = 0; j < pTable->getNumberOfRotamers(i);j++){
+			//for (uint k = i+1 ; k < pTable->getNumberOfPositions();k++){	
+			for (uint k = 0 ; k < i;k++){	
 				if (i == k){
 					continue;
 				}
-				for (uint l = 0 ; l < (*pairEnergy)[i][j][k].size();l++){	
-					fprintf(stdout, "    %4d %4d %4d %4d %8.3f", i, j, k, l, (*pairEnergy)[i][j][k][l]);
+				for (uint l = 0 ; l < pTable->getNumberOfRotamers(k);l++){	
+					fprintf(stdout, "    %4d %4d %4d %4d %8.3f", i, j, k, l, pTable->getPairEnergy(i, j, k, l));
 
 					// alive Rotamers	
 					if (bestState[i] == j && bestState[k] == l) {
@@ -747,7 +634,7 @@ void MonteCarloOptimization::setInitializationState(INITTYPE _type, std::string
 	initType = _type;
 	if(_userDef != "") {
 		std::vector<string> toks = MslTools::tokenize(_userDef,":");
-		if(toks.size() != selfEnergy->size()) {
+		if(toks.size() != pTable->getNumberOfPositions()) {
 			cerr << "ERROR 2456 no: of states in _userDef does not match with EnergyTables" << endl;
 			return;
 		}
@@ -817,13 +704,13 @@ int MonteCarloOptimization::selectRandomStateAtPosition(int _position) const {
 		return 0;
 	}
 
-	if ((*selfEnergy)[_position].size() == 1) {
+	if (pTable->getNumberOfRotamers(_position) == 1) {
 		return 0;
 	}
 
 	vector<double> residualP;
 	double sumP = 0.0;
-	for (int i=0; i<(*selfEnergy)[_position].size(); i++) {
+	for (int i=0; i<pTable->getNumberOfRotamers(_position); i++) {
 		if (i == currentState[_position] || !inputMasks[_position][i]) {
 			residualP.push_back(0.0);
 		} else {
@@ -846,7 +733,7 @@ vector<vector<bool> > MonteCarloOptimization::getMask() {
 	vector<vector<bool> > aliveRotamers;
 	aliveRotamers.resize(totalNumPositions);
 	for(int i = 0; i < aliveRotamers.size(); i++) {
-		aliveRotamers[i].resize((*selfEnergy)[i].size(),false);
+		aliveRotamers[i].resize(pTable->getNumberOfRotamers(i),false);
 	}
 	for(int i = 0; i < totalNumPositions; i++) {
 		aliveRotamers[i][bestState[i]] = true;
@@ -41,6 +41,7 @@ You should have received a copy of the GNU Lesser General Public
 #include "MonteCarloManager.h"
 #include "SelfPairManager.h"
 #include "MslTools.h"
+#include "EnergyTable.h"
 
 
 namespace MSL { 
@@ -64,6 +65,8 @@ class MonteCarloOptimization {
 		void readEnergyTable(std::string _filename);
 		// The pairTable has to be lower triangular.  
 		void addEnergyTable(std::vector<std::vector<double> > &_selfEnergy, std::vector<std::vector<std::vector<std::vector<double> > > > &_pairEnergy); 
+		// The flat table is used directly (not copied), it must outlive the object
+		void addEnergyTable(EnergyTable & _table);
 		void setSelfPairManager(SelfPairManager* _pSpm);//must be set if in onTheFlyMode
 
 
@@ -122,6 +125,7 @@ class MonteCarloOptimization {
 		void initialize();
 		void deletePointers();
 		void deleteEnergyTables();
+		void initializeStates();
 		void selectRotamer(int _pos,int _rot); // update currentState
 		int selectRandomStateAtPosition(int _position) const;
 		std::string getRotString(int _pos, int _rot);
@@ -129,8 +133,8 @@ class MonteCarloOptimization {
 
 
 		// Member Variables
-		std::vector<std::vector<double> > *selfEnergy;
-		std::vector<std::vector<std::vector<std::vector<double > > > > *pairEnergy;
+		EnergyTable * pTable;
+		EnergyTable ownedTable; // holds the converted nested tables or the table read from file
 		std::vector<std::vector<bool> > inputMasks; 
 		std::map<std::string,double> configurationMap;
 
@@ -152,7 +156,6 @@ class MonteCarloOptimization {
 
 		// Energy table parameters
 		int totalNumPositions;
-		bool responsibleForEnergyTableMemory;
 
 		// Utility variables
 		RandomNumberGenerator * pRng;
@@ -173,13 +176,13 @@ inline std::vector<unsigned int>& MonteCarloOptimization::getInitState() { retur
 inline void MonteCarloOptimization::setNumberOfStoredConfigurations(int _numConfs){ numStoredConfigurations = _numConfs; }
 inline int MonteCarloOptimization::getNumberOfStoredConfigurations() { return numStoredConfigurations; }
 
-inline int MonteCarloOptimization::getNumPositions() { if (selfEnergy == NULL) { return 0; } return (*selfEnergy).size();}
+inline int MonteCarloOptimization::getNumPositions() { if (pTable == NULL) { return 0; } return pTable->getNumberOfPositions();}
 inline int MonteCarloOptimization::getNumRotamers(int _index) { 
-	if (selfEnergy == NULL || _index >= (*selfEnergy).size()) { 
+	if (pTable == NULL || _index >= pTable->getNumberOfPositions()) { 
 		return 0; 
 	} 
 
-	return (*selfEnergy)[_index].size();
+	return pTable->getNumberOfRotamers(_index);
 }
 
 inline void MonteCarloOptimization::setInputRotamerMasks(std::vector<std::vector<bool> > &_inputMasks) { inputMasks = _inputMasks; }
@@ -31,6 +31,7 @@ You should have received a copy of the GNU Lesser General Public
 #include "MslTools.h"
 #include <numeric>    //inner_product
 #include <functional> //plus, equal_to, not2
+#include <pthread.h>
 
 using namespace MSL;
 using namespace std;
@@ -1847,3 +1848,22 @@ vector<double> MslTools::getBoltzmannProbabilities(double _temp, vector<double>&
 	}
 	return probs;
 }
+
+void MslTools::runThreads(void * (*_function)(void*), const vector<void*> & _args) {
+	if (_args.empty()) {
+		return;
+	}
+	vector<pthread_t> threads(_args.size());
+	vector<bool> started(_args.size(), false);
+	for (unsigned int t=1; t<_args.size(); t++) {
+		if (pthread_create(&threads[t], NULL, _function, _args[t]) == 0) {
+			started[t] = true;
+		}
+	}
+	_function(_args[0]);
+	for (unsigned int t=1; t<_args.size(); t++) {
+		if (started[t]) {
+			pthread_join(threads[t], NULL);
+		}
+	}
+}
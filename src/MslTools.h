@@ -225,6 +225,16 @@ namespace MSL{
 	std::string getRandomAlphaNumString(unsigned int _size, bool _alphaOnly=false);
 	//unsigned int getRandomInt(unsigned int _max);
 
+	/*
+             ******************************************
+	     *          THREADS
+	     ******************************************
+	*/
+	// Runs _function on each of the _args, the first in the calling thread and the others in new threads, and
+	// returns when all are done.  The runs must share their work (e.g. take the next item from a counter under
+	// a mutex): if a thread cannot be created, the others take its share
+	void runThreads(void * (*_function)(void*), const std::vector<void*> & _args);
+
 	/*
               ******************************************
               * Tools to convert different AA codes.
@@ -55,7 +55,8 @@ namespace MSL {
 			void setAtoms(std::vector<Atom*> _atoms);
 			void setAtoms(Atom & _a1);
 
-			bool isSelected(std::string _selection1, std::string _selection2) const;
+			bool isSelected(unsigned int _selection1, unsigned int _selection2) const;
+			using Interaction::isSelected;
 			bool isActive() const;
 
 			virtual double getEnergy()=0;
@@ -73,7 +74,7 @@ namespace MSL {
 
 	inline void OneBodyInteraction::setAtoms(std::vector<Atom*> _atoms) { if (_atoms.size() != 1) {std::cerr << "ERROR 37967: invalid number of atoms in inline void OneBodyInteraction::setAtoms(std::vector<Atom*> _atoms)" << std::endl; exit(37967);} pAtoms = _atoms;}
 	inline void OneBodyInteraction::setAtoms(Atom & _a1) { pAtoms[0] = &_a1;}
-	inline bool OneBodyInteraction::isSelected(std::string _selection1, std::string _selection2) const {
+	inline bool OneBodyInteraction::isSelected(unsigned int _selection1, unsigned int _selection2) const {
 		if (pAtoms[0]->getSelectionFlag(_selection1) && pAtoms[0]->getSelectionFlag(_selection2)) {
 			return true;
 		} else {
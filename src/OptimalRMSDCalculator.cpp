@@ -29,6 +29,7 @@ You should have received a copy of the GNU Lesser General Public
 
 #include <iostream>
 #include <math.h>
+#include <pthread.h>
 #include "OptimalRMSDCalculator.h"
 #include "AtomPointerVector.h"
 
@@ -391,3 +392,479 @@ bool OptimalRMSDCalculator::Kabsch(AtomPointerVector &_align, AtomPointerVector
 
 	return true;
 }
+
+/**************************************************************************
+  QCP (quaternion characteristic polynomial) RMSD, Theobald (2005) Acta
+  Cryst A61:478 and Liu, Agrafiotis & Theobald (2010) J Comput Chem 31:1561.
+  For centered structures a (align) and b (ref) with inner product matrix
+  S[i][j] = sum a_i b_j, the RMSD is sqrt(2 (E0 - lambda) / n), where
+  E0 = (Ga + Gb) / 2 (half the sum of the squared norms) and lambda is the
+  largest eigenvalue of Horn's 4x4 key matrix K built from S.  lambda is
+  the largest root of det(K - x I) = x^4 + c2 x^2 + c1 x + c0, found by
+  Newton's method from E0 (an upper bound).
+ **************************************************************************/
+namespace {
+
+	// structures centered into contiguous x, y, z arrays (one block of 3 * nAtoms per structure)
+	template <class T>
+	struct QcpCentered {
+		std::vector<T> coor;
+		std::vector<double> g; // squared norm of each centered structure
+		std::vector<double> center;
+		unsigned int nAtoms;
+	};
+
+	template <class T>
+	void qcpCenter(const T * _coor, unsigned int _nStructures, unsigned int _nAtoms, QcpCentered<T> & _centered) {
+		_centered.nAtoms = _nAtoms;
+		_centered.coor.resize((size_t)3 * _nAtoms * _nStructures);
+		_centered.g.resize(_nStructures);
+		_centered.center.resize(3 * _nStructures);
+		for (unsigned int s=0; s<_nStructures; s++) {
+			const T * in = _coor + (size_t)3 * _nAtoms * s;
+			T * x = &_centered.coor[(size_t)3 * _nAtoms * s];
+			T * y = x + _nAtoms;
+			T * z = y + _nAtoms;
+			double c[3] = {0.0, 0.0, 0.0};
+			for (unsigned int i=0; i<_nAtoms; i++) {
+				c[0] += in[3*i];
+				c[1] += in[3*i+1];
+				c[2] += in[3*i+2];
+			}
+			for (unsigned int k=0; k<3; k++) {
+				c[k] /= (double)_nAtoms;
+				_centered.center[3*s+k] = c[k];
+			}
+			double g = 0.0;
+			for (unsigned int i=0; i<_nAtoms; i++) {
+				x[i] = (T)(in[3*i] - c[0]);
+				y[i] = (T)(in[3*i+1] - c[1]);
+				z[i] = (T)(in[3*i+2] - c[2]);
+				g += (double)x[i] * x[i] + (double)y[i] * y[i] + (double)z[i] * z[i];
+			}
+			_centered.g[s] = g;
+		}
+	}
+
+	// the 9 inner products, accumulated in 4 independent lanes so that the loop vectorizes
+	template <class T>
+	void qcpInnerProduct(const T * _a, const T * _b, unsigned int _nAtoms, double _S[9]) {
+		const T * ax = _a;
+		const T * ay = _a + _nAtoms;
+		const T * az = ay + _nAtoms;
+		const T * bx = _b;
+		const T * by = _b + _nAtoms;
+		const T * bz = by + _nAtoms;
+		double acc[9][4];
+		for (unsigned int k=0; k<9; k++) {
+			for (unsigned int l=0; l<4; l++) {
+				acc[k][l] = 0.0;
+			}
+		}
+		unsigned int i = 0;
+		for (; i+4<=_nAtoms; i+=4) {
+			for (unsigned int l=0; l<4; l++) {
+				double x1 = ax[i+l];
+				double y1 = ay[i+l];
+				double z1 = az[i+l];
+				double x2 = bx[i+l];
+				double y2 = by[i+l];
+				double z2 = bz[i+l];
+				acc[0][l] += x1 * x2;
+				acc[1][l] += x1 * y2;
+				acc[2][l] += x1 * z2;
+				acc[3][l] += y1 * x2;
+				acc[4][l] += y1 * y2;
+				acc[5][l] += y1 * z2;
+				acc[6][l] += z1 * x2;
+				acc[7][l] += z1 * y2;
+				acc[8][l] += z1 * z2;
+			}
+		}
+		for (; i<_nAtoms; i++) {
+			double x1 = ax[i];
+			double y1 = ay[i];
+			double z1 = az[i];
+			acc[0][0] += x1 * bx[i];
+			acc[1][0] += x1 * by[i];
+			acc[2][0] += x1 * bz[i];
+			acc[3][0] += y1 * bx[i];
+			acc[4][0] += y1 * by[i];
+			acc[5][0] += y1 * bz[i];
+			acc[6][0] += z1 * bx[i];
+			acc[7][0] += z1 * by[i];
+			acc[8][0] += z1 * bz[i];
+		}
+		for (unsigned int k=0; k<9; k++) {
+			_S[k] = (acc[k][0] + acc[k][1]) + (acc[k][2] + acc[k][3]);
+		}
+	}
+
+	// the inner products of a raw structure (x, y, z of each atom) with a centered one: as the
+	// centered structure sums to zero the structure does not need to be centered, only its
+	// squared norm is corrected by its center
+	template <class T>
+	double qcpRawInnerProduct(const T * _a, const T * _b, unsigned int _nAtoms, double _S[9]) {
+		const T * bx = _b;
+		const T * by = _b + _nAtoms;
+		const T * bz = by + _nAtoms;
+		double S[9] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+		double c[3] = {0.0, 0.0, 0.0};
+		double g = 0.0;
+		for (unsigned int i=0; i<_nAtoms; i++) {
+			double x1 = _a[3*i];
+			double y1 = _a[3*i+1];
+			double z1 = _a[3*i+2];
+			double x2 = bx[i];
+			double y2 = by[i];
+			double z2 = bz[i];
+			c[0] += x1;
+			c[1] += y1;
+			c[2] += z1;
+			g += x1 * x1 + y1 * y1 + z1 * z1;
+			S[0] += x1 * x2;
+			S[1] += x1 * y2;
+			S[2] += x1 * z2;
+			S[3] += y1 * x2;
+			S[4] += y1 * y2;
+			S[5] += y1 * z2;
+			S[6] += z1 * x2;
+			S[7] += z1 * y2;
+			S[8] += z1 * z2;
+		}
+		for (unsigned int k=0; k<9; k++) {
+			_S[k] = S[k];
+		}
+		return g - (c[0] * c[0] + c[1] * c[1] + c[2] * c[2]) / (double)_nAtoms;
+	}
+
+	double det3(double _a00, double _a01, double _a02, double _a10, double _a11, double _a12, double _a20, double _a21, double _a22) {
+		return _a00 * (_a11 * _a22 - _a12 * _a21) - _a01 * (_a10 * _a22 - _a12 * _a20) + _a02 * (_a10 * _a21 - _a11 * _a20);
+	}
+
+	double det4(const double _m[4][4]) {
+		double s0 = _m[0][0] * _m[1][1] - _m[1][0] * _m[0][1];
+		double s1 = _m[0][0] * _m[1][2] - _m[1][0] * _m[0][2];
+		double s2 = _m[0][0] * _m[1][3] - _m[1][0] * _m[0][3];
+		double s3 = _m[0][1] * _m[1][2] - _m[1][1] * _m[0][2];
+		double s4 = _m[0][1] * _m[1][3] - _m[1][1] * _m[0][3];
+		double s5 = _m[0][2] * _m[1][3] - _m[1][2] * _m[0][3];
+		double c5 = _m[2][2] * _m[3][3] - _m[3][2] * _m[2][3];
+		double c4 = _m[2][1] * _m[3][3] - _m[3][1] * _m[2][3];
+		double c3 = _m[2][1] * _m[3][2] - _m[3][1] * _m[2][2];
+		double c2 = _m[2][0] * _m[3][3] - _m[3][0] * _m[2][3];
+		double c1 = _m[2][0] * _m[3][2] - _m[3][0] * _m[2][2];
+		double c0 = _m[2][0] * _m[3][1] - _m[3][0] * _m[2][1];
+		return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+	}
+
+	// RMSD from the inner products; if _rotation is not NULL it gets the rotation of a onto b
+	double qcpSolve(const double _S[9], double _ga, double _gb, unsigned int _nAtoms, double (*_rotation)[3]) {
+		const double Sxx = _S[0], Sxy = _S[1], Sxz = _S[2];
+		const double Syx = _S[3], Syy = _S[4], Syz = _S[5];
+		const double Szx = _S[6], Szy = _S[7], Szz = _S[8];
+
+		double K[4][4];
+		K[0][0] = Sxx + Syy + Szz;
+		K[0][1] = K[1][0] = Syz - Szy;
+		K[0][2] = K[2][0] = Szx - Sxz;
+		K[0][3] = K[3][0] = Sxy - Syx;
+		K[1][1] = Sxx - Syy - Szz;
+		K[1][2] = K[2][1] = Sxy + Syx;
+		K[1][3] = K[3][1] = Szx + Sxz;
+		K[2][2] = -Sxx + Syy - Szz;
+		K[2][3] = K[3][2] = Syz + Szy;
+		K[3][3] = -Sxx - Syy + Szz;
+
+		double c2 = -2.0 * (Sxx*Sxx + Sxy*Sxy + Sxz*Sxz + Syx*Syx + Syy*Syy + Syz*Syz + Szx*Szx + Szy*Szy + Szz*Szz);
+		double c1 = -8.0 * det3(Sxx, Sxy, Sxz, Syx, Syy, Syz, Szx, Szy, Szz);
+		double c0 = det4(K);
+
+		double e0 = (_ga + _gb) / 2.0;
+		double lambda = e0;
+		for (unsigned int i=0; i<50; i++) {
+			double old = lambda;
+			double x2 = lambda * lambda;
+			double b = (x2 + c2) * lambda;
+			double a = b + c1;
+			double denominator = 2.0 * x2 * lambda + b + a;
+			if (denominator == 0.0) {
+				break;
+			}
+			lambda -= (a * lambda + c0) / denominator;
+			if (fabs(lambda - old) < fabs(1.0e-11 * lambda)) {
+				break;
+			}
+		}
+		double msd = 2.0 * (e0 - lambda) / (double)_nAtoms;
+		if (msd < 0.0) {
+			msd = 0.0;
+		}
+
+		if (_rotation != NULL) {
+			// the quaternion is a non-null column of the adjugate of K - lambda I
+			double M[4][4];
+			for (unsigned int i=0; i<4; i++) {
+				for (unsigned int j=0; j<4; j++) {
+					M[i][j] = K[i][j];
+				}
+				M[i][i] -= lambda;
+			}
+			double q[4] = {1.0, 0.0, 0.0, 0.0};
+			double best = 0.0;
+			for (unsigned int r=0; r<4; r++) {
+				double cof[4];
+				double norm = 0.0;
+				for (unsigned int c=0; c<4; c++) {
+					// minor without row r and column c
+					double sub[3][3];
+					unsigned int si = 0;
+					for (unsigned int i=0; i<4; i++) {
+						if (i == r) continue;
+						unsigned int sj = 0;
+						for (unsigned int j=0; j<4; j++) {
+							if (j == c) continue;
+							sub[si][sj++] = M[i][j];
+						}
+						si++;
+					}
+					cof[c] = ((r + c) % 2 == 0 ? 1.0 : -1.0) * det3(sub[0][0], sub[0][1], sub[0][2], sub[1][0], sub[1][1], sub[1][2], sub[2][0], sub[2][1], sub[2][2]);
+					norm += cof[c] * cof[c];
+				}
+				if (norm > best) {
+					best = norm;
+					for (unsigned int c=0; c<4; c++) {
+						q[c] = cof[c];
+					}
+				}
+			}
+			if (best > 0.0) {
+				best = sqrt(best);
+				for (unsigned int c=0; c<4; c++) {
+					q[c] /= best;
+				}
+			} else {
+				// degenerate largest eigenvalue (e.g. collinear atoms), any rotation is optimal
+				q[0] = 1.0; q[1] = q[2] = q[3] = 0.0;
+			}
+			double q00 = q[0]*q[0], q11 = q[1]*q[1], q22 = q[2]*q[2], q33 = q[3]*q[3];
+			double q01 = q[0]*q[1], q02 = q[0]*q[2], q03 = q[0]*q[3];
+			double q12 = q[1]*q[2], q13 = q[1]*q[3], q23 = q[2]*q[3];
+			_rotation[0][0] = q00 + q11 - q22 - q33;
+			_rotation[0][1] = 2.0 * (q12 - q03);
+			_rotation[0][2] = 2.0 * (q13 + q02);
+			_rotation[1][0] = 2.0 * (q12 + q03);
+			_rotation[1][1] = q00 - q11 + q22 - q33;
+			_rotation[1][2] = 2.0 * (q23 - q01);
+			_rotation[2][0] = 2.0 * (q13 - q02);
+			_rotation[2][1] = 2.0 * (q23 + q01);
+			_rotation[2][2] = q00 - q11 - q22 + q33;
+		}
+		return sqrt(msd);
+	}
+
+	template <class T>
+	struct QcpRunner {
+		const QcpCentered<T> * pRef;         // oneVsMany only
+		const T * pRaw;                      // oneVsMany only, the structures are not centered
+		const QcpCentered<T> * pStructures;  // manyVsMany only
+		unsigned int nStructures;
+		double * pOneVsMany;                 // output of oneVsMany, or NULL
+		float * pManyVsMany;                 // condensed output of manyVsMany, or NULL
+		unsigned int tileSize;
+		unsigned int nTileRows;
+		unsigned int * pNext;                // shared, the work is taken in chunks (oneVsMany) or tiles by the first free thread
+		pthread_mutex_t * pMutex;
+	};
+
+	template <class T>
+	void * runQcp(void * _runner) {
+		QcpRunner<T> * pRunner = (QcpRunner<T>*)_runner;
+		const unsigned int nAtoms = pRunner->pRef != NULL ? pRunner->pRef->nAtoms : pRunner->pStructures->nAtoms;
+		const size_t block = (size_t)3 * nAtoms;
+		const unsigned int n = pRunner->nStructures;
+		const unsigned int chunk = pRunner->pOneVsMany != NULL ? 64 : 1;
+		unsigned int nWork = pRunner->pOneVsMany != NULL ? n : pRunner->nTileRows * (pRunner->nTileRows + 1) / 2;
+		double S[9];
+		while (true) {
+			unsigned int first = 0;
+			if (pRunner->pMutex != NULL) {
+				pthread_mutex_lock(pRunner->pMutex);
+			}
+			first = *(pRunner->pNext);
+			*(pRunner->pNext) += chunk;
+			if (pRunner->pMutex != NULL) {
+				pthread_mutex_unlock(pRunner->pMutex);
+			}
+			if (first >= nWork) {
+				break;
+			}
+			if (pRunner->pOneVsMany != NULL) {
+				const QcpCentered<T> & ref = *(pRunner->pRef);
+				for (unsigned int s=first; s<first+chunk && s<n; s++) {
+					double g = qcpRawInnerProduct(pRunner->pRaw + block * s, &ref.coor[0], nAtoms, S);
+					pRunner->pOneVsMany[s] = qcpSolve(S, g, ref.g[0], nAtoms, NULL);
+				}
+			} else {
+				const QcpCentered<T> & structures = *(pRunner->pStructures);
+				// tile (ti, tj) with ti <= tj, numbered along the rows of the upper triangle
+				unsigned int ti = 0;
+				unsigned int remaining = first;
+				while (remaining >= pRunner->nTileRows - ti) {
+					remaining -= pRunner->nTileRows - ti;
+					ti++;
+				}
+				unsigned int tj = ti + remaining;
+				unsigned int iEnd = (ti + 1) * pRunner->tileSize;
+				unsigned int jEnd = (tj + 1) * pRunner->tileSize;
+				for (unsigned int i=ti*pRunner->tileSize; i<iEnd && i<n; i++) {
+					unsigned int j = tj * pRunner->tileSize;
+					if (j <= i) {
+						j = i + 1;
+					}
+					for (; j<jEnd && j<n; j++) {
+						qcpInnerProduct(&structures.coor[block * i], &structures.coor[block * j], nAtoms, S);
+						pRunner->pManyVsMany[OptimalRMSDCalculator::condensedIndex(i, j, n)] = (float)qcpSolve(S, structures.g[i], structures.g[j], nAtoms, NULL);
+					}
+				}
+			}
+		}
+		return NULL;
+	}
+
+	template <class T>
+	void qcpRun(std::vector<QcpRunner<T> > & _runners, unsigned int _nThreads, unsigned int _nWork) {
+		unsigned int next = 0;
+		if (_nThreads > _nWork) {
+			_nThreads = _nWork;
+		}
+		if (_nThreads <= 1) {
+			_runners[0].pNext = &next;
+			_runners[0].pMutex = NULL;
+			runQcp<T>(&_runners[0]);
+			return;
+		}
+		pthread_mutex_t mutex;
+		pthread_mutex_init(&mutex, NULL);
+		_runners.resize(_nThreads, _runners[0]);
+		for (unsigned int t=0; t<_nThreads; t++) {
+			_runners[t].pNext = &next;
+			_runners[t].pMutex = &mutex;
+		}
+		vector<void*> args(_nThreads);
+		for (unsigned int t=0; t<_nThreads; t++) {
+			args[t] = &_runners[t];
+		}
+		MslTools::runThreads(runQcp<T>, args);
+		pthread_mutex_destroy(&mutex);
+	}
+
+	template <class T>
+	void qcpOneVsMany(const T * _ref, const T * _structures, unsigned int _nStructures, unsigned int _nAtoms, double * _rmsd, unsigned int _nThreads) {
+		if (_nStructures == 0 || _nAtoms == 0) {
+			return;
+		}
+		QcpCentered<T> ref;
+		qcpCenter(_ref, 1, _nAtoms, ref);
+		std::vector<QcpRunner<T> > runners(1);
+		runners[0].pRef = &ref;
+		runners[0].pRaw = _structures;
+		runners[0].pStructures = NULL;
+		runners[0].nStructures = _nStructures;
+		runners[0].pOneVsMany = _rmsd;
+		runners[0].pManyVsMany = NULL;
+		runners[0].tileSize = 0;
+		runners[0].nTileRows = 0;
+		qcpRun(runners, _nThreads, (_nStructures + 63) / 64);
+	}
+
+	template <class T>
+	void qcpManyVsMany(const T * _structures, unsigned int _nStructures, unsigned int _nAtoms, float * _rmsd, unsigned int _nThreads) {
+		if (_nStructures < 2 || _nAtoms == 0) {
+			return;
+		}
+		QcpCentered<T> structures;
+		qcpCenter(_structures, _nStructures, _nAtoms, structures);
+		// a tile of rows and one of columns (about 3*nAtoms*tileSize values each) stay in cache
+		unsigned int tileSize = 16384 / (3 * _nAtoms * sizeof(T));
+		if (tileSize < 4) {
+			tileSize = 4;
+		}
+		std::vector<QcpRunner<T> > runners(1);
+		runners[0].pRef = NULL;
+		runners[0].pRaw = NULL;
+		runners[0].pStructures = &structures;
+		runners[0].nStructures = _nStructures;
+		runners[0].pOneVsMany = NULL;
+		runners[0].pManyVsMany = _rmsd;
+		runners[0].tileSize = tileSize;
+		runners[0].nTileRows = (_nStructures + tileSize - 1) / tileSize;
+		qcpRun(runners, _nThreads, runners[0].nTileRows * (runners[0].nTileRows + 1) / 2);
+	}
+}
+
+void OptimalRMSDCalculator::packCoordinates(AtomPointerVector & _atoms, vector<double> & _coor) {
+	_coor.reserve(_coor.size() + 3 * _atoms.size());
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		_coor.push_back(_atoms[i]->getX());
+		_coor.push_back(_atoms[i]->getY());
+		_coor.push_back(_atoms[i]->getZ());
+	}
+}
+
+double OptimalRMSDCalculator::qcpRMSD(AtomPointerVector &_align, AtomPointerVector &_ref, bool setTransRot) {
+	if (_align.size() != _ref.size()) {
+		cout << "Two proteins have different length!" << endl;
+		rmsd = 999999.0;
+		return rmsd;
+	}
+	vector<double> align;
+	vector<double> ref;
+	packCoordinates(_align, align);
+	packCoordinates(_ref, ref);
+	if (align.empty()) {
+		cout << "Protein length is zero!" << endl;
+		rmsd = 999999.0;
+		return rmsd;
+	}
+	return qcpRMSD(&align[0], &ref[0], _align.size(), setTransRot);
+}
+
+double OptimalRMSDCalculator::qcpRMSD(const double * _align, const double * _ref, unsigned int _nAtoms, bool setTransRot) {
+	if (_nAtoms == 0) {
+		cout << "Protein length is zero!" << endl;
+		rmsd = 999999.0;
+		return rmsd;
+	}
+	QcpCentered<double> align;
+	QcpCentered<double> ref;
+	qcpCenter(_align, 1, _nAtoms, align);
+	qcpCenter(_ref, 1, _nAtoms, ref);
+	double S[9];
+	qcpInnerProduct(&align.coor[0], &ref.coor[0], _nAtoms, S);
+	if (!setTransRot) {
+		rmsd = qcpSolve(S, align.g[0], ref.g[0], _nAtoms, NULL);
+		return rmsd;
+	}
+	rmsd = qcpSolve(S, align.g[0], ref.g[0], _nAtoms, u);
+	for (int i = 0; i < 3; i++) {
+		t[i] = ref.center[i] - u[i][0] * align.center[0] - u[i][1] * align.center[1] - u[i][2] * align.center[2];
+	}
+	return rmsd;
+}
+
+void OptimalRMSDCalculator::oneVsMany(const double * _ref, const double * _structures, unsigned int _nStructures, unsigned int _nAtoms, double * _rmsd) {
+	qcpOneVsMany(_ref, _structures, _nStructures, _nAtoms, _rmsd, numberOfThreads);
+}
+
+void OptimalRMSDCalculator::oneVsMany(const float * _ref, const float * _structures, unsigned int _nStructures, unsigned int _nAtoms, double * _rmsd) {
+	qcpOneVsMany(_ref, _structures, _nStructures, _nAtoms, _rmsd, numberOfThreads);
+}
+
+void OptimalRMSDCalculator::manyVsMany(const double * _structures, unsigned int _nStructures, unsigned int _nAtoms, float * _rmsd) {
+	qcpManyVsMany(_structures, _nStructures, _nAtoms, _rmsd, numberOfThreads);
+}
+
+void OptimalRMSDCalculator::manyVsMany(const float * _structures, unsigned int _nStructures, unsigned int _nAtoms, float * _rmsd) {
+	qcpManyVsMany(_structures, _nStructures, _nAtoms, _rmsd, numberOfThreads);
+}
@@ -40,7 +40,7 @@ class OptimalRMSDCalculator {
 
  public:
   
-	OptimalRMSDCalculator() {}
+	OptimalRMSDCalculator() { numberOfThreads = 1; }
 	~OptimalRMSDCalculator() {}
 
 	// getters
@@ -53,6 +53,41 @@ class OptimalRMSDCalculator {
 	// quickly calculate RMSD upon optimal superposition without generating the rotation matrix
 	double bestRMSD(AtomPointerVector &_align, AtomPointerVector &_ref, bool* _suc = NULL, bool setTransRot = false);
 
+	/***************************************************************
+	 *  RMSD upon optimal superposition by the quaternion
+	 *  characteristic polynomial (QCP) method, on packed
+	 *  coordinates: x, y, z of the _nAtoms atoms of a structure,
+	 *  the structures one after the other (float or double).
+	 *  The reference (and every structure of manyVsMany) is
+	 *  centered once into contiguous x, y, z arrays; oneVsMany
+	 *  reads the other structures in place, and the centered inner
+	 *  products are derived from their sums.  The largest
+	 *  eigenvalue is found by Newton's method on the
+	 *  characteristic polynomial.  The rotation is
+	 *  only built if setTransRot is true (then lastRotation and
+	 *  lastTranslation move _align onto _ref, as with bestRMSD)
+	 ***************************************************************/
+	static void packCoordinates(AtomPointerVector & _atoms, std::vector<double> & _coor); // appends the coordinates
+	double qcpRMSD(AtomPointerVector &_align, AtomPointerVector &_ref, bool setTransRot = false);
+	double qcpRMSD(const double * _align, const double * _ref, unsigned int _nAtoms, bool setTransRot = false);
+
+	// RMSD of each of the _nStructures structures on _ref
+	void oneVsMany(const double * _ref, const double * _structures, unsigned int _nStructures, unsigned int _nAtoms, double * _rmsd);
+	void oneVsMany(const float * _ref, const float * _structures, unsigned int _nStructures, unsigned int _nAtoms, double * _rmsd);
+	void oneVsMany(const std::vector<double> & _ref, const std::vector<double> & _structures, unsigned int _nAtoms, std::vector<double> & _rmsd);
+	void oneVsMany(const std::vector<float> & _ref, const std::vector<float> & _structures, unsigned int _nAtoms, std::vector<double> & _rmsd);
+
+	// RMSD of all pairs, in a condensed upper triangle of _nStructures*(_nStructures-1)/2 values (see condensedIndex),
+	// computed in tiles of structures
+	void manyVsMany(const double * _structures, unsigned int _nStructures, unsigned int _nAtoms, float * _rmsd);
+	void manyVsMany(const float * _structures, unsigned int _nStructures, unsigned int _nAtoms, float * _rmsd);
+	void manyVsMany(const std::vector<double> & _structures, unsigned int _nAtoms, std::vector<float> & _rmsd);
+	void manyVsMany(const std::vector<float> & _structures, unsigned int _nAtoms, std::vector<float> & _rmsd);
+	static size_t condensedIndex(unsigned int _i, unsigned int _j, unsigned int _nStructures); // _i < _j
+
+	void setNumberOfThreads(unsigned int _threads); // the structures (oneVsMany) and tiles (manyVsMany) are split among the threads (default 1)
+	unsigned int getNumberOfThreads() const;
+
  protected:
 	// implemetation of Kabsch algoritm for optimal superposition
 	bool Kabsch(AtomPointerVector &_align, AtomPointerVector &_ref, int mode);
@@ -62,8 +97,41 @@ class OptimalRMSDCalculator {
 	double t[3];    // translation vector
 	double u[3][3]; // rotation matrix
 
+	unsigned int numberOfThreads;
 };
 
+inline void OptimalRMSDCalculator::oneVsMany(const std::vector<double> & _ref, const std::vector<double> & _structures, unsigned int _nAtoms, std::vector<double> & _rmsd) {
+	_rmsd.resize(_nAtoms == 0 ? 0 : _structures.size() / (3 * _nAtoms));
+	if (!_rmsd.empty()) {
+		oneVsMany(&_ref[0], &_structures[0], _rmsd.size(), _nAtoms, &_rmsd[0]);
+	}
+}
+inline void OptimalRMSDCalculator::oneVsMany(const std::vector<float> & _ref, const std::vector<float> & _structures, unsigned int _nAtoms, std::vector<double> & _rmsd) {
+	_rmsd.resize(_nAtoms == 0 ? 0 : _structures.size() / (3 * _nAtoms));
+	if (!_rmsd.empty()) {
+		oneVsMany(&_ref[0], &_structures[0], _rmsd.size(), _nAtoms, &_rmsd[0]);
+	}
+}
+inline void OptimalRMSDCalculator::manyVsMany(const std::vector<double> & _structures, unsigned int _nAtoms, std::vector<float> & _rmsd) {
+	unsigned int n = _nAtoms == 0 ? 0 : _structures.size() / (3 * _nAtoms);
+	_rmsd.resize(n < 2 ? 0 : (size_t)n * (n - 1) / 2);
+	if (!_rmsd.empty()) {
+		manyVsMany(&_structures[0], n, _nAtoms, &_rmsd[0]);
+	}
+}
+inline void OptimalRMSDCalculator::manyVsMany(const std::vector<float> & _structures, unsigned int _nAtoms, std::vector<float> & _rmsd) {
+	unsigned int n = _nAtoms == 0 ? 0 : _structures.size() / (3 * _nAtoms);
+	_rmsd.resize(n < 2 ? 0 : (size_t)n * (n - 1) / 2);
+	if (!_rmsd.empty()) {
+		manyVsMany(&_structures[0], n, _nAtoms, &_rmsd[0]);
+	}
+}
+inline size_t OptimalRMSDCalculator::condensedIndex(unsigned int _i, unsigned int _j, unsigned int _nStructures) {
+	return (size_t)_i * _nStructures - (size_t)_i * (_i + 1) / 2 + (_j - _i - 1);
+}
+inline void OptimalRMSDCalculator::setNumberOfThreads(unsigned int _threads) { numberOfThreads = _threads; }
+inline unsigned int OptimalRMSDCalculator::getNumberOfThreads() const { return numberOfThreads; }
+
 }
 
 #endif // OPTIMAL_RMSD_CALCULATOR_H_
@@ -29,6 +29,10 @@ You should have received a copy of the GNU Lesser General Public
 
 #include "PDBFormat.h"
 
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+
 using namespace MSL;
 using namespace std;
 
@@ -241,6 +245,143 @@ PDBFormat::AtomData PDBFormat::parseAtomLine(const string &_pdbAtomLine){
 }
 
 
+/*
+  Helpers of the in-place atom line parser: they read the
+  columns [_start, _start + _size) clipped to the line length
+  and trim them like MslTools::trim does
+ */
+static inline bool isTrimmed(char _c) {
+	return _c == ' ' || _c == '\t' || _c == '\n' || _c == '\r';
+}
+
+static unsigned int trimmedField(const char * _line, unsigned int _length, unsigned int _start, unsigned int _size, const char *& _field) {
+	unsigned int end = _start + _size;
+	if (end > _length) {
+		end = _length;
+	}
+	while (_start < end && isTrimmed(_line[_start])) {
+		_start++;
+	}
+	while (end > _start && isTrimmed(_line[end-1])) {
+		end--;
+	}
+	_field = _line + _start;
+	return end - _start;
+}
+
+static void copyField(const char * _line, unsigned int _length, unsigned int _start, unsigned int _size, char * _dest) {
+	const char * field = NULL;
+	unsigned int n = trimmedField(_line, _length, _start, _size, field);
+	memcpy(_dest, field, n);
+	_dest[n] = '\0';
+}
+
+/*
+  Numbers are only accepted when they look like what the stream
+  extraction of MslTools::toInt/toDouble accepts, anything else
+  sends the caller back to the original parser (which reports the error)
+ */
+static bool numberField(const char * _line, unsigned int _length, unsigned int _start, unsigned int _size, bool _decimal, char * _buffer) {
+	const char * field = NULL;
+	unsigned int n = trimmedField(_line, _length, _start, _size, field);
+	if (n == 0) {
+		return false;
+	}
+	memcpy(_buffer, field, n);
+	_buffer[n] = '\0';
+	if (_decimal && strpbrk(_buffer, "xXpP") != NULL) {
+		// hexadecimal floats are read by strtod but not by the streams
+		return false;
+	}
+	const char * p = _buffer;
+	if (*p == '+' || *p == '-') {
+		p++;
+	}
+	if (_decimal && *p == '.') {
+		p++;
+	}
+	return isdigit((unsigned char)*p);
+}
+
+static bool fastInt(const char * _line, unsigned int _length, unsigned int _start, unsigned int _size, int & _value) {
+	char buffer[32];
+	if (!numberField(_line, _length, _start, _size, false, buffer)) {
+		return false;
+	}
+	errno = 0;
+	long value = strtol(buffer, NULL, 10);
+	if (errno != 0 || value > INT_MAX || value < INT_MIN) {
+		return false;
+	}
+	_value = value;
+	return true;
+}
+
+static bool fastDouble(const char * _line, unsigned int _length, unsigned int _start, unsigned int _size, double & _value) {
+	char buffer[32];
+	if (!numberField(_line, _length, _start, _size, true, buffer)) {
+		return false;
+	}
+	char * end = NULL;
+	errno = 0;
+	double value = strtod(buffer, &end);
+	// a dangling exponent or sign is an error for the stream extraction
+	if (errno != 0 || end == buffer || (*end != '\0' && strchr("eE+-.0123456789", *end) != NULL)) {
+		return false;
+	}
+	_value = value;
+	return true;
+}
+
+void PDBFormat::parseAtomLine(const char * _line, unsigned int _length, AtomData & _atom) {
+	_atom.clear();
+
+	if (_length >= E_RECORD_NAME)    copyField(_line, _length, S_RECORD_NAME, L_RECORD_NAME, _atom.D_RECORD_NAME);
+	if (_length >= E_ATOM_NAME)      copyField(_line, _length, S_ATOM_NAME, L_ATOM_NAME, _atom.D_ATOM_NAME);
+	if (_length >= E_RES_NAME)       copyField(_line, _length, S_RES_NAME, L_RES_NAME, _atom.D_RES_NAME);
+	if (_length >= E_ALT_LOC)        copyField(_line, _length, S_ALT_LOC, L_ALT_LOC, _atom.D_ALT_LOC);
+	if (_length >= E_CHAIN_ID)       copyField(_line, _length, S_CHAIN_ID, L_CHAIN_ID, _atom.D_CHAIN_ID);
+	if (_length >= E_I_CODE)         copyField(_line, _length, S_I_CODE, L_I_CODE, _atom.D_I_CODE);
+	if (_length >= E_SEG_ID)         copyField(_line, _length, S_SEG_ID, L_SEG_ID, _atom.D_SEG_ID);
+
+	if (_length >= E_ELEMENT_SYMBOL) {
+		// same element rules as the string parser
+		const char * element = NULL;
+		if (trimmedField(_line, _length, S_ELEMENT_SYMBOL, L_ELEMENT_SYMBOL, element) > 0) {
+			copyField(_line, _length, S_ELEMENT_SYMBOL, L_ELEMENT_SYMBOL, _atom.D_ELEMENT_SYMBOL);
+		} else {
+			const char * atomname = _line + S_ATOM_NAME;
+			if (isdigit(atomname[0]) ||  atomname[0] == ' '){
+				copyField(atomname, 2, 1, 1, _atom.D_ELEMENT_SYMBOL);
+			} else if (atomname[0] == 'H'  && isdigit(atomname[2]) && isdigit(atomname[3])){
+				copyField(atomname, 1, 0, 1, _atom.D_ELEMENT_SYMBOL);
+			} else {
+				copyField(atomname, 2, 0, 2, _atom.D_ELEMENT_SYMBOL);
+			}
+		}
+	}
+
+	bool ok = true;
+	if (ok && _length >= E_SERIAL)    ok = fastInt(_line, _length, S_SERIAL, L_SERIAL, _atom.D_SERIAL);
+	if (ok && _length >= E_RES_SEQ)   ok = fastInt(_line, _length, S_RES_SEQ, L_RES_SEQ, _atom.D_RES_SEQ);
+	if (ok && _length >= E_X)         ok = fastDouble(_line, _length, S_X, L_X, _atom.D_X);
+	if (ok && _length >= E_Y)         ok = fastDouble(_line, _length, S_Y, L_Y, _atom.D_Y);
+	if (ok && _length >= E_Z)         ok = fastDouble(_line, _length, S_Z, L_Z, _atom.D_Z);
+	if (ok && _length >= E_OCCUP)     ok = fastDouble(_line, _length, S_OCCUP, L_OCCUP, _atom.D_OCCUP);
+	if (ok && _length >= E_CHARGE) {
+		const char * charge = NULL;
+		if (trimmedField(_line, _length, S_CHARGE, L_CHARGE, charge) > 0) {
+			ok = fastDouble(_line, _length, S_CHARGE, L_CHARGE, _atom.D_CHARGE);
+		}
+	}
+	if (ok && _length >= E_TEMP_FACT) ok = fastDouble(_line, _length, S_TEMP_FACT, L_TEMP_FACT, _atom.D_TEMP_FACT);
+
+	if (!ok) {
+		// unusual content, let the original parser deal with it
+		_atom = parseAtomLine(string(_line, _length));
+	}
+}
+
 PDBFormat::AtomData PDBFormat::createAtomData(string _resName, Real &_x, Real &_y, Real &_z, string _element){
 	Atom a(_resName, _x,_y,_z,_element);
 	return createAtomData(a);
@@ -598,6 +598,8 @@ class PDBFormat {
 		static SymData  parseSymLine(const std::string &_symLine);
 		static BioUData parseBioULine(const std::string &_bioULine);
 		static AtomData parseAtomLine(const std::string &_pdbAtomLine);
+		// same result as above, reading the columns in place from a line that is not null terminated
+		static void parseAtomLine(const char * _line, unsigned int _length, AtomData & _atom);
 		static ModelData parseModelLine(const std::string &_pdbModelLine);
 		static AtomData createAtomData(const Atom &_at);
 		static AtomData createAtomData(std::string _resName, Real &_x, Real &_y, Real &_z, std::string _element);
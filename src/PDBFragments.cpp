@@ -34,6 +34,7 @@ You should have received a copy of the GNU Lesser General Public
 #include "AtomSelection.h"
 #include "MslExceptions.h"
 #include "MslOut.h"
+#include <climits>
 
 // BOOST Includes
 #include <boost/regex.hpp>
@@ -49,6 +50,9 @@ int PDBFragments::searchForMatchingDualFragments(System &_sys1, std::vector<std:
 
         int numDualLoops = 0;
 
+        // the results are appended after those of the last search
+        collectHits();
+
         if (_stemResidues1.size() != 2) throw MslSizeException(MslTools::stringf("PDBFragments::searchForMatchingDualFragments stemResidue1 != 2, it = %d",_stemResidues1.size()));
 
         Position &stem1res1 = _sys1.getPosition(_stemResidues1[0]);
@@ -218,16 +222,12 @@ int PDBFragments::searchForMatchingDualFragments(System &_sys1, std::vector<std:
 		     }
 
 
-		     // Load PDB and extract region
-		     string allAtomFileName = MslTools::stringf("%s/%s.pdb",pdbDir.c_str(),loop1Res1.getSegID().c_str());
-		     
-		     System allAtomSys;
-		     allAtomSys.readPdb(allAtomFileName);
-
-		     // Reset segid..
-		     for (uint ats = 0; ats < allAtomSys.getAtomPointers().size();ats++){
-		       allAtomSys.getAtom(ats).setSegID("");
+		     // Get the PDB (atoms are copied before being moved) and extract region
+		     System * pSource = getSourceStructure(loop1Res1.getSegID());
+		     if (pSource == NULL){
+		       continue;
 		     }
+		     System & allAtomSys = *pSource;
 
 		     // Good stem1,stem2 alignment, move the loops onto 
 		     AtomContainer *dualLoops = new AtomContainer();
@@ -286,6 +286,9 @@ int PDBFragments::searchForMatchingDualFragments(System &_sys1, std::vector<std:
 
         int numDualLoops = 0;
 
+        // the results are appended after those of the last search
+        collectHits();
+
         if (_stemResidues1.size() != 2) throw MslSizeException(MslTools::stringf("PDBFragments::searchForMatchingDualFragments stemResidue1 != 2, it = %d",_stemResidues1.size()));
 
         Position &stem1res1 = _sys1.getPosition(_stemResidues1[0]);
@@ -486,6 +489,7 @@ int PDBFragments::searchForMatchingFragmentsSpots(System &_sys, std::vector<std:
 
 	// Remove last set of results
 	lastResults.clear();
+	clearHits();
 
 	// Clear our set of matched sequences
 	matchedSequences.clear();
@@ -643,11 +647,12 @@ int PDBFragments::searchForMatchingFragmentsSpots(System &_sys, std::vector<std:
 
 
 			// align and print winning fragment
-			// Make a copy of frag stem, so not to effect original atoms
-			AtomPointerVector fragStem; 
-			fragStem.push_back(fragDB[i]);
-			fragStem.push_back(fragDB[secondPositionIndex]);
-			fragStem.push_back(fragDB[thirdPositionIndex]);
+			// Make a copy of frag stem, so not to effect original atoms (the search index reads them)
+			AtomContainer fragStemCopy;
+			fragStemCopy.addAtom(*fragDB[i]);
+			fragStemCopy.addAtom(*fragDB[secondPositionIndex]);
+			fragStemCopy.addAtom(*fragDB[thirdPositionIndex]);
+			AtomPointerVector & fragStem = fragStemCopy.getAtomPointers();
 			// Align the fragStem to stem to see if it matches well enough...
 			Transforms tm;
 			fragStem.saveCoor("pre");
@@ -709,74 +714,74 @@ int PDBFragments::searchForMatchingFragmentsSpots(System &_sys, std::vector<std:
 			              Atom &at1 = fullFragCA.getAtom(0);
 			              Atom &at2 = fullFragCA.getAtom(fullFragCA.size()-1);
 
-				      string allAtomFileName = MslTools::stringf("%s/%s.pdb",pdbDir.c_str(),at1.getSegID().c_str());
-
-				      System allAtomSys;
-				      allAtomSys.readPdb(allAtomFileName);
-				      for (uint ats = 0; ats < allAtomSys.getAtomPointers().size();ats++){
-					allAtomSys.getAtom(ats).setSegID("");
+				      System * pSource = getSourceStructure(at1.getSegID());
+				      if (pSource == NULL){
+					continue;
 				      }
 
-				      AtomSelection sel2(allAtomSys.getAtomPointers());
+				      AtomSelection sel2(pSource->getAtomPointers());
 
-			    	      stringstream ss;
+				      stringstream ss;
 				      char tmpstr[100];
-				      //sprintf(tmpstr,"chain %1s and resi %d-%-d and name CA",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
 				      sprintf(tmpstr,"chain %1s and resi %d-%-d and name CA",	fragDB[i]->getChainId().c_str(),fragDB[i]->getResidueNumber(),fragDB[thirdPositionIndex]->getResidueNumber());
 				      ss << tmpstr;
 				      AtomPointerVector caAts = sel2.select(ss.str());
 
+				      // Copy the atoms to be moved, the source structure is shared by the following hits
+				      ss.str("");
+				      char tmpstr2[100];
+				      sprintf(tmpstr2,"chain %1s and resi %d-%-d",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
+				      ss << tmpstr2;
+				      AtomContainer * pResult = new AtomContainer(sel2.select(ss.str()));
 
-				      if (!tm.rmsdAlignment(caAts,fullFragCA.getAtomPointers(),allAtomSys.getAtomPointers())){
+				      // Get BB atoms from stem-equivalent residues
+				      AtomPointerVector allAts_stemBBats;
+				      Position &stem1eq  = pSource->getPosition(MslTools::getPositionId(fragDB[i]->getChainId(),fragDB[i]->getResidueNumber(),fragDB[i]->getResidueIcode()));
+				      allAts_stemBBats.push_back(new Atom(stem1eq.getAtom("N")));
+				      allAts_stemBBats.push_back(new Atom(stem1eq.getAtom("CA")));
+				      allAts_stemBBats.push_back(new Atom(stem1eq.getAtom("C")));
+
+				      Position &stem2eq  = pSource->getPosition(MslTools::getPositionId(fragDB[secondPositionIndex]->getChainId(),fragDB[secondPositionIndex]->getResidueNumber(),fragDB[secondPositionIndex]->getResidueIcode()));
+				      allAts_stemBBats.push_back(new Atom(stem2eq.getAtom("N")));
+				      allAts_stemBBats.push_back(new Atom(stem2eq.getAtom("CA")));
+				      allAts_stemBBats.push_back(new Atom(stem2eq.getAtom("C")));
+
+				      Position &stem3eq  = pSource->getPosition(MslTools::getPositionId(fragDB[thirdPositionIndex]->getChainId(),fragDB[thirdPositionIndex]->getResidueNumber(),fragDB[thirdPositionIndex]->getResidueIcode()));
+				      allAts_stemBBats.push_back(new Atom(stem3eq.getAtom("N")));
+				      allAts_stemBBats.push_back(new Atom(stem3eq.getAtom("CA")));
+				      allAts_stemBBats.push_back(new Atom(stem3eq.getAtom("C")));
+
+				      AtomPointerVector moveable = pResult->getAtomPointers() + allAts_stemBBats;
+				      if (!tm.rmsdAlignment(caAts,fullFragCA.getAtomPointers(),moveable)){
 					MSLOUT.stream() << "Problem aligning all atoms using the C-alpha trace"<<endl;
-					MSLOUT.stream() << "PDB: "<<allAtomFileName<<endl;
-					MSLOUT.stream() << "\tTrying to align with: "<<ss.str()<<endl;
-					MSLOUT.stream() << "\tSystem: "<<allAtomSys.getSizes();
-					MSLOUT.stream() << "\tSelected: "<<caAts.size()<<" atoms using '"<<ss.str()<<"'"<<endl;
+					MSLOUT.stream() << "PDB: "<<at1.getSegID()<<endl;
+					MSLOUT.stream() << "\tTrying to align with: "<<tmpstr<<endl;
+					MSLOUT.stream() << "\tSystem: "<<pSource->getSizes();
+					MSLOUT.stream() << "\tSelected: "<<caAts.size()<<" atoms using '"<<tmpstr<<"'"<<endl;
 					MSLOUT.stream() << "\tReference: "<<fullFragCA.getAtomPointers().size()<<" atoms"<<endl;
 					MSLOUT.stream() << fullFragCA.getAtomPointers();
+					allAts_stemBBats.deletePointers();
+					delete pResult;
 					continue;
 				      } 
-
-				      // Get BB atoms from stem-equivalent residues
-				      AtomPointerVector allAts_stemBBats;
-				      Position &stem1eq  = allAtomSys.getPosition(MslTools::getPositionId(fragDB[i]->getChainId(),fragDB[i]->getResidueNumber(),fragDB[i]->getResidueIcode()));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("N"));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("CA"));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("C"));
-
-				      Position &stem2eq  = allAtomSys.getPosition(MslTools::getPositionId(fragDB[secondPositionIndex]->getChainId(),fragDB[secondPositionIndex]->getResidueNumber(),fragDB[secondPositionIndex]->getResidueIcode()));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("N"));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("CA"));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("C"));
-
-				      Position &stem3eq  = allAtomSys.getPosition(MslTools::getPositionId(fragDB[thirdPositionIndex]->getChainId(),fragDB[thirdPositionIndex]->getResidueNumber(),fragDB[thirdPositionIndex]->getResidueIcode()));
-				      allAts_stemBBats.push_back(&stem3eq.getAtom("N"));
-				      allAts_stemBBats.push_back(&stem3eq.getAtom("CA"));
-				      allAts_stemBBats.push_back(&stem3eq.getAtom("C"));
-				      	
+					
 				      double bbRMSD = allAts_stemBBats.rmsd(stemBBats);
-
+				      allAts_stemBBats.deletePointers();
 
 				      if (bbRMSD > _rmsdTol){
+					delete pResult;
 					continue;
 				      }
 				      fprintf(stdout,"(%4s and chain %1s and resi %3d-%3d)  %8.3f ",
-					      fragDB[i]->getSegID().c_str(),
-					      fragDB[i]->getChainId().c_str(),
-					      fragDB[i]->getResidueNumber(),
-					      fragDB[thirdPositionIndex]->getResidueNumber(),
-					      rmsd);
+					fragDB[i]->getSegID().c_str(),
+					fragDB[i]->getChainId().c_str(),
+					fragDB[i]->getResidueNumber(),
+					fragDB[thirdPositionIndex]->getResidueNumber(),
+					rmsd);
 
 				      fprintf(stdout, "%8.3f",bbRMSD);
 
-				      ss.str("");
-				      char tmpstr2[100];
-				      sprintf(tmpstr2,"chain %1s and resi %d-%-d",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
-				      ss << tmpstr2;
-				      AtomPointerVector allAts = sel2.select(ss.str());
-				      lastResults.push_back(new AtomContainer());
-				      lastResults.back()->addAtoms(allAts);
+				      lastResults.push_back(pResult);
 
 
 
@@ -809,6 +814,7 @@ int PDBFragments::searchForMatchingFragmentsLinear(System &_sys, string &_startR
   
   // Remove last set of results
   lastResults.clear();
+  clearHits();
 
   // Clear our set of matched sequences
   matchedSequences.clear();
@@ -828,19 +834,44 @@ int PDBFragments::searchForMatchingFragmentsLinear(System &_sys, string &_startR
 
 
   MSLOUT.stream() << "FragDB.size(): "<<fragDB.size()<<endl;
-  // Now loop over all fragments in database checking for ones of the correct size
+
+  // Find the fragments of the correct size within the RMSD tolerance using the index
+  FragmentQuery query;
+  query.pRef = &bbAts;
+  for (uint j = 0; j <= residueSeparation;j++){
+    query.offsets.push_back(j);
+  }
+  query.span = residueSeparation;
+  query.firstEnd = fragDB.size() > residueSeparation ? fragDB.size()-residueSeparation : 0;
+  query.rmsdTol = _rmsdTol;
+  query.checkTol = sqrt(2.0 * bbAts.size()) * _rmsdTol;
+  double spanDistance = bbAts(0).distance(bbAts(bbAts.size()-1));
+  query.minSpanDistance = spanDistance - query.checkTol;
+  query.maxSpanDistance = spanDistance + query.checkTol;
+  if (bbAts.size() > 2){
+    uint mid = bbAts.size() / 2;
+    query.checkA.push_back(0);
+    query.checkB.push_back(mid);
+    query.checkDistance.push_back(bbAts(0).distance(bbAts(mid)));
+    query.checkA.push_back(mid);
+    query.checkB.push_back(bbAts.size()-1);
+    query.checkDistance.push_back(bbAts(mid).distance(bbAts(bbAts.size()-1)));
+  }
+  query.stems = false;
+  vector<pair<unsigned int, double> > matches;
+  findMatchingWindows(query, matches);
+
+  // Compile the sequence filter once for all the matches
+  boost::regex sequenceFilter;
+  if (_regex != ""){
+    sequenceFilter.assign(_regex);
+  }
+
   int matchIndex = 0; // Index for keeping track of matches
   Transforms tm;
-  stringstream ss;
-  for (uint i = 0 ; i < fragDB.size()-residueSeparation;i++){
-
-    // Filter by pdb/chain breaks
-    if (fragDB(i).getSegID() != fragDB(i+residueSeparation).getSegID()){
-      continue;
-    }
-    if (fragDB(i).getChainId() != fragDB(i+residueSeparation).getChainId()){
-      continue;
-    }
+  for (uint m = 0; m < matches.size();m++){
+    uint i = matches[m].first;
+    double rmsd = matches[m].second;
 
     AtomPointerVector fragBB;
     string matchSeq = "";
@@ -849,25 +880,17 @@ int PDBFragments::searchForMatchingFragmentsLinear(System &_sys, string &_startR
       matchSeq += MslTools::getOneLetterCode(fragDB(i+j).getResidueName());
     }
 
+    matchIndex++;
 
-    fragBB.saveCoor("pre");
-    if (!tm.rmsdAlignment(fragBB,bbAts)){
-      cerr << "ERROR in alignment: "<<fragBB.size()<<" "<<bbAts.size()<<endl;
-      continue;
-    }
-
-    double rmsd = fragBB.rmsd(bbAts);
-    if (rmsd > _rmsdTol){
+    // the all-atom coordinates are read later, but a hit is only counted if its structure is there
+    if (pdbDir != "" && !sourceExists(fragDB(i).getSegID())){
+      MSLOUT.stream() << "Skipping hit, cannot open the structure of "<<fragDB(i).getSegID()<<" in "<<pdbDir<<endl;
       continue;
     }
 
-    
-    matchIndex++;
-    
-
 
     if (_regex != ""){
-      if (!boost::regex_search(matchSeq.c_str(),boost::regex(_regex))){
+      if (!boost::regex_search(matchSeq.c_str(),sequenceFilter)){
 	MSLOUT.stream() << "RegEx NOT Matched. "<<matchSeq<<endl;
 	continue;
       } else {
@@ -895,45 +918,20 @@ int PDBFragments::searchForMatchingFragmentsLinear(System &_sys, string &_startR
 	    rmsd);
 
 
-    if (pdbDir != ""){
-      fragBB.applySavedCoor("pre");
-      Atom &at1 = fragBB(0);
-      Atom &at2 = fragBB(fragBB.size()-1);
-      string allAtomFileName = MslTools::stringf("%s/%s.pdb",pdbDir.c_str(),at1.getSegID().c_str());
-
-
-      System allAtomSys;
-      allAtomSys.readPdb(allAtomFileName);
-      for (uint ats = 0; ats < allAtomSys.getAtomPointers().size();ats++){
-	allAtomSys.getAtom(ats).setSegID("");
-      }
-
-      if (!tm.rmsdAlignment(fragBB,bbAts,allAtomSys.getAtomPointers())){
-	cerr << "ERROR in alignment2: "<<fragBB.size()<<" "<<bbAts.size()<<endl;
-	continue;
-      }
-
-
-      lastResults.push_back(new AtomContainer());
-      if (includeFullFile){
-	lastResults.back()->addAtoms(allAtomSys.getAtomPointers());
-      } else {
-	AtomSelection sel2(allAtomSys.getAtomPointers());
-	ss.str("");
-	char tmpstr2[100];
-	sprintf(tmpstr2,"chain %1s and resi %d-%-d",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
-	ss << tmpstr2;
-	AtomPointerVector allAts = sel2.select(ss.str());
-	lastResults.back()->addAtoms(allAts);
-      }
-
-    } else {
-
-      // Add CA only atoms..
-      lastResults.push_back(new AtomContainer());
-      lastResults.back()->addAtoms(fragDB);
-
+    // Keep the hit as a CA trace aligned onto the query, the all-atom coordinates are read on request
+    FragmentHit * pHit = new FragmentHit;
+    pHit->first = i;
+    pHit->size = fragBB.size();
+    pHit->rmsd = rmsd;
+    pHit->sequence = matchSeq;
+    for (uint j = 0; j < fragBB.size();j++){
+      pHit->caTrace.push_back(new Atom(fragBB(j)));
     }
+    tm.rmsdAlignment(pHit->caTrace,bbAts);
+    pHit->pAtoms = NULL;
+    pHit->materialized = false;
+    lastHits.push_back(pHit);
+    hitsCollected = false;
 
     numFrags++;
   }
@@ -962,6 +960,7 @@ int PDBFragments::searchForMatchingFragmentsStems(System &_sys, vector<string> &
 
 	// Remove last set of results
 	lastResults.clear();
+	clearHits();
 
 	// Clear our set of matched sequences
 	matchedSequences.clear();
@@ -1044,111 +1043,69 @@ int PDBFragments::searchForMatchingFragmentsStems(System &_sys, vector<string> &
 		}
 
 		MSLOUT.stream() << "FragDB.size(): "<<fragDB.size()<<endl;
-		// Now loop over all fragments in database checking for ones of the correct size
+
+		// Find the fragments of the correct size that pass the gap, distance and RMSD filters using the index
 		double tol = 64; // Tolerance of distance to be deviant from stems in Angstroms^2
+		FragmentQuery query;
+		query.pRef = &stems;
+		for (uint n = 0; n < stem1.size();n++){
+			query.offsets.push_back(n);
+		}
+		for (uint n = 0; n < stem2.size();n++){
+			query.offsets.push_back(stem1.size()+_numResiduesInFragment+n);
+		}
+		query.span = query.offsets.back();
+		uint windowSize = _numResiduesInFragment+stem1.size()+stem2.size();
+		query.firstEnd = fragDB.size() > windowSize ? fragDB.size()-windowSize : 0;
+		query.rmsdTol = _rmsdTol;
+		query.checkTol = sqrt(2.0 * stems.size()) * _rmsdTol;
+
+		// The end CAs must pass both the RMSD bound and the stem-to-stem distance filter
+		double spanDistanceSq = stemDistanceSq.back();
+		double spanDistance = sqrt(spanDistanceSq);
+		query.minSpanDistance = spanDistance - query.checkTol;
+		query.maxSpanDistance = spanDistance + query.checkTol;
+		if (spanDistanceSq > tol && sqrt(spanDistanceSq - tol) > query.minSpanDistance){
+			query.minSpanDistance = sqrt(spanDistanceSq - tol);
+		}
+		if (sqrt(spanDistanceSq + tol) < query.maxSpanDistance){
+			query.maxSpanDistance = sqrt(spanDistanceSq + tol);
+		}
+		query.stems = true;
+		query.stem1Size = stem1.size();
+		query.stem2Size = stem2.size();
+		query.gap = _numResiduesInFragment;
+		query.stemDistanceSq = stemDistanceSq;
+		query.stemDistanceTol = tol;
+		vector<pair<unsigned int, double> > matches;
+		findMatchingWindows(query, matches);
+
+		// Compile the sequence filter once for all the matches
+		boost::regex sequenceFilter;
+		if (_regex != ""){
+			sequenceFilter.assign(_regex);
+		}
+
 		int matchIndex = 0; // Index for keeping track of matches
-		for (uint i = 0 ; i < fragDB.size()-(_numResiduesInFragment+stem1.size()+stem2.size());i++){
+		Transforms tm;
+		int index = 0;
+		for (uint m = 0; m < matches.size();m++){
+			uint i = matches[m].first;
+			double rmsd = matches[m].second;
+			MSLOUT.stream() << "RMSD: "<<rmsd<<endl;
 
-			// Get proposed ctermStem
+			// Get the matching ctermStem
 			AtomPointerVector ctermStem;
 			for (uint n = 0; n < stem1.size();n++){
 				ctermStem.push_back(fragDB[i+n]);
 			}
 
-			// Get proposed ntermStem
+			// Get the matching ntermStem
 			AtomPointerVector ntermStem;
 			for (uint n = 0; n < stem2.size();n++){
 				ntermStem.push_back(fragDB[i+stem1.size()+_numResiduesInFragment+n]);
 			}
 
-			// Check for same PDB
-			if (ctermStem(0).getSegID() != ntermStem(ntermStem.size()-1).getSegID()){
-			  //fprintf(stdout,"New PDB: %4s to %4s\n",ctermStem[0]->getSegID().c_str(),ntermStem(ntermStem.size()-1).getSegID().c_str());
-
-				// Jump ahead to move past all pdb1 v pdb2 tests
-				i = i + _numResiduesInFragment+stem1.size();
-				continue;
-			}
-
-
-			// Check for same Chain
-			if (ctermStem(0).getChainId() != ntermStem(ntermStem.size()-1).getChainId()){
-				/*
-				fprintf(stdout,"New Chain: %4s %1s to %4s %1s\n",
-					ctermStem[0]->getSegID().c_str(),
-					ctermStem[0]->getChainId().c_str(),					
-					ntermStem(ntermStem.size()-1).getSegID().c_str(),
-					ntermStem(ntermStem.size()-1).getChainId().c_str());
-				*/
-				// Jump ahead to move past all chain1 v chain2 tests
-				i = i + _numResiduesInFragment+stem1.size();
-				continue;
-			}
-
-
-			// Check for a gap (PDB Structures have gaps).
-			if ( abs(ctermStem[ctermStem.size()-1]->getResidueNumber() - ntermStem[0]->getResidueNumber()) != _numResiduesInFragment+1){
-				/*
-				fprintf(stdout," Gap found at residue %4s %1s %4d %3s and %4s %1s %4d %3s\n",
-					ctermStem[ctermStem.size()-1]->getSegID().c_str(),
-					ctermStem[ctermStem.size()-1]->getChainId().c_str(),
-					ctermStem[ctermStem.size()-1]->getResidueNumber(),
-					ctermStem[ctermStem.size()-1]->getResidueName().c_str(),
-					ntermStem[0]->getSegID().c_str(),
-					ntermStem[0]->getChainId().c_str(),
-					ntermStem[0]->getResidueNumber(),
-					ntermStem[0]->getResidueName().c_str());
-				*/
-				// Jump ahead to move past gap
-				i = i + _numResiduesInFragment+stem1.size();
-				continue;
-			}
-			
-
-			// Distance Filter... are the proposed stems close enough ?
-			bool passDistanceFilter = true;
-			int index = 0;
-
-			// Check against compiled list of distance-squared's
-			for (uint c = 0; c < ctermStem.size();c++){
-
-			  /*
-				  fprintf(stdout," Checking residue %1s %4d %3s\n",
-				  ctermStem[c]->getChainId().c_str(),
-				  ctermStem[c]->getResidueNumber(),
-				  ctermStem[c]->getResidueName().c_str());
-			  */
-				for (uint n = 0; n < ntermStem.size();n++){
-
-					double distSq = ctermStem[c]->distance2(*ntermStem[n]);
-
-					/*
-					  fprintf(stdout," \t%1s %4d %3s = %8.3f vs %8.3f\n",
-					  ntermStem[n]->getChainId().c_str(),
-					  ntermStem[n]->getResidueNumber(),
-					  ntermStem[n]->getResidueName().c_str(),distSq,stemDistanceSq[index]);
-					*/
-					if (fabs(stemDistanceSq[index++] - distSq) > tol){
-						passDistanceFilter = false;
-						break;
-					}
-				}
-
-				if (!passDistanceFilter){
-					break;
-				}
-			}
-
-
-
-			// Continue if the distance filter not passed
-			if (!passDistanceFilter) {
-				continue;
-			}
-			MSLOUT.stream() << "PASSED DISTANCE FILTER!"<<endl;
-
-			// align and print winning fragment
-
 			// Make a copy of frag stem, so not to effect original atoms
 			AtomPointerVector fragStem;
 			for (uint ct = 0; ct < ctermStem.size();ct++){
@@ -1157,25 +1114,9 @@ int PDBFragments::searchForMatchingFragmentsStems(System &_sys, vector<string> &
 			for (uint nt = 0; nt < ntermStem.size();nt++){
 				fragStem.push_back(new Atom(ntermStem(nt)));
 			}
-
-			// Align the fragStem to stem to see if it matches well enough...
-			Transforms tm;
 			fragStem.saveCoor("pre");
-			tm.rmsdAlignment(fragStem,stems);
-			
-			double rmsd = fragStem.rmsd(stems);
-			MSLOUT.stream() << "RMSD: "<<rmsd<<endl;
-
-			// Continue if the RMSD filter not passed
-			if (rmsd > _rmsdTol){
-				continue;
-			}
-
-
-
 
 			matchIndex++;
-			fragStem.applySavedCoor("pre");
 
 			//lastResults->writePdb("/tmp/preAdd.pdb");
 
@@ -1232,7 +1173,7 @@ int PDBFragments::searchForMatchingFragmentsStems(System &_sys, vector<string> &
 			if (_regex != ""){
 
 
-			  if (!boost::regex_search(matchSeq.c_str(),boost::regex(_regex))){
+			  if (!boost::regex_search(matchSeq.c_str(),sequenceFilter)){
 			    MSLOUT.stream() << "RegEx NOT Matched. "<<matchSeq<<endl;
 			    continue;
 			  } else {
@@ -1264,72 +1205,72 @@ int PDBFragments::searchForMatchingFragmentsStems(System &_sys, vector<string> &
 			              Atom &at1 = tmpChain.getAtom(0);
 			              Atom &at2 = tmpChain.getAtom(tmpChain.atomSize()-1);
 
-				      string allAtomFileName = MslTools::stringf("%s/%s.pdb",pdbDir.c_str(),at1.getSegID().c_str());
-				      MSLOUT.stream() << "Opening "<<allAtomFileName<<endl;
-				      System allAtomSys;
-				      allAtomSys.readPdb(allAtomFileName);
-				      for (uint ats = 0; ats < allAtomSys.getAtomPointers().size();ats++){
-					allAtomSys.getAtom(ats).setSegID("");
+				      System * pSource = getSourceStructure(at1.getSegID());
+				      if (pSource == NULL){
+					successful = false;
+					continue;
 				      }
 
-				      AtomSelection sel2(allAtomSys.getAtomPointers());
+				      AtomSelection sel2(pSource->getAtomPointers());
 
-			    	      stringstream ss;
+				      stringstream ss;
 				      char tmpstr[100];
-				      //sprintf(tmpstr,"chain %1s and resi %d-%-d and name CA",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
 				      sprintf(tmpstr,"chain %1s and resi %d-%-d and name CA",	ctermStem[0]->getChainId().c_str(),ctermStem[0]->getResidueNumber(),ntermStem[ntermStem.size()-1]->getResidueNumber());
 				      ss << tmpstr;
 				      AtomPointerVector caAts = sel2.select(ss.str());
 
+				      // Copy the atoms to be moved, the source structure is shared by the following hits
+				      AtomContainer * pResult = new AtomContainer();
+				      if (includeFullFile){
+					pResult->addAtoms(pSource->getAtomPointers());
+				      } else {
+					ss.str("");
+					char tmpstr2[100];
+					sprintf(tmpstr2,"chain %1s and resi %d-%-d",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
+					ss << tmpstr2;
+					pResult->addAtoms(sel2.select(ss.str()));
+				      }
 
-				      if (!tm.rmsdAlignment(caAts,tmpChain.getAtomPointers(),allAtomSys.getAtomPointers())){
+				      // Get BB atoms from stem-equivalent residues
+				      AtomPointerVector allAts_stemBBats;
+				      Position &stem1eq  = pSource->getPosition(MslTools::getPositionId(ctermStem[0]->getChainId(),ctermStem[0]->getResidueNumber(),ctermStem[0]->getResidueIcode()));
+				      allAts_stemBBats.push_back(new Atom(stem1eq.getAtom("N")));
+				      allAts_stemBBats.push_back(new Atom(stem1eq.getAtom("CA")));
+				      allAts_stemBBats.push_back(new Atom(stem1eq.getAtom("C")));
+
+				      Position &stem2eq  = pSource->getPosition(MslTools::getPositionId(ntermStem[ntermStem.size()-1]->getChainId(),ntermStem[ntermStem.size()-1]->getResidueNumber(),ntermStem[ntermStem.size()-1]->getResidueIcode()));
+				      allAts_stemBBats.push_back(new Atom(stem2eq.getAtom("N")));
+				      allAts_stemBBats.push_back(new Atom(stem2eq.getAtom("CA")));
+				      allAts_stemBBats.push_back(new Atom(stem2eq.getAtom("C")));
+
+				      AtomPointerVector moveable = pResult->getAtomPointers() + allAts_stemBBats;
+				      if (!tm.rmsdAlignment(caAts,tmpChain.getAtomPointers(),moveable)){
 					MSLOUT.stream() << "Problem aligning all atoms using the C-alpha trace"<<endl;
-					MSLOUT.stream() << "PDB: "<<allAtomFileName<<endl;
-					MSLOUT.stream() << "\tTrying to align with: "<<ss.str()<<endl;
-					MSLOUT.stream() << "\tSystem: "<<allAtomSys.getSizes();
-					MSLOUT.stream() << "\tSelected: "<<caAts.size()<<" atoms using '"<<ss.str()<<"'"<<endl;
+					MSLOUT.stream() << "PDB: "<<at1.getSegID()<<endl;
+					MSLOUT.stream() << "\tTrying to align with: "<<tmpstr<<endl;
+					MSLOUT.stream() << "\tSystem: "<<pSource->getSizes();
+					MSLOUT.stream() << "\tSelected: "<<caAts.size()<<" atoms using '"<<tmpstr<<"'"<<endl;
 					MSLOUT.stream() << "\tReference: "<<tmpChain.getAtomPointers().size()<<" atoms"<<endl;
 					MSLOUT.stream() << tmpChain.getAtomPointers();
+					allAts_stemBBats.deletePointers();
+					delete pResult;
 					successful = false;
 					continue;
 				      } 
-
-				      // Get BB atoms from stem-equivalent residues
-				      AtomPointerVector allAts_stemBBats;
-				      //Position &stem1eq  = allAtomSys.getPosition(MslTools::getPositionId(at1.getChainId(),at1.getResidueNumber(),at1.getResidueIcode()));
-				      Position &stem1eq  = allAtomSys.getPosition(MslTools::getPositionId(ctermStem[0]->getChainId(),ctermStem[0]->getResidueNumber(),ctermStem[0]->getResidueIcode()));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("N"));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("CA"));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("C"));
-
-				      //Position &stem2eq  = allAtomSys.getPosition(MslTools::getPositionId(at2.getChainId(),at2.getResidueNumber()+stem2.size()-1,at2.getResidueIcode()));
-				      Position &stem2eq  = allAtomSys.getPosition(MslTools::getPositionId(ntermStem[ntermStem.size()-1]->getChainId(),ntermStem[ntermStem.size()-1]->getResidueNumber(),ntermStem[ntermStem.size()-1]->getResidueIcode()));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("N"));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("CA"));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("C"));
-				      	
+					
 				      double bbRMSD = allAts_stemBBats.rmsd(stemBBats);
+				      allAts_stemBBats.deletePointers();
 
 				      MSLOUT.stream() << "BB RMSD: "<<bbRMSD<<endl;
 				      fprintf(stdout, "%8.3f",bbRMSD);
 				      if (bbRMSD > 1.51){
+					delete pResult;
 					successful = false;
 					continue;
 				      }
 				      MSLOUT.stream() << "ADDDDDDDDDDDDDDDDDING COORDS"<<endl;
 
-
-				      lastResults.push_back(new AtomContainer());
-				      if (includeFullFile){
-					lastResults.back()->addAtoms(allAtomSys.getAtomPointers());
-				      } else {
-					ss.str("");
-					char tmpstr2[100];
-					sprintf(tmpstr2,"chain %1s and resi %d-%-d",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
-					ss << tmpstr2;
-					AtomPointerVector allAts = sel2.select(ss.str());
-					lastResults.back()->addAtoms(allAts);
-				      }
+				      lastResults.push_back(pResult);
 
 
 
@@ -1384,3 +1325,301 @@ int PDBFragments::searchForMatchingFragmentsStems(System &_sys, vector<string> &
 }
 
 
+
+void PDBFragments::indexFragmentDatabase() {
+	indexCoor.resize(3 * fragDB.size());
+	indexChain.resize(fragDB.size());
+	indexResidueNumber.resize(fragDB.size());
+	spanIndices.clear();
+
+	map<pair<string, string>, unsigned int> chainKeys;
+	for (uint i = 0; i < fragDB.size(); i++) {
+		indexCoor[3*i] = fragDB[i]->getX();
+		indexCoor[3*i+1] = fragDB[i]->getY();
+		indexCoor[3*i+2] = fragDB[i]->getZ();
+		pair<string, string> segChain(fragDB[i]->getSegID(), fragDB[i]->getChainId());
+		map<pair<string, string>, unsigned int>::iterator found = chainKeys.find(segChain);
+		if (found == chainKeys.end()) {
+			found = chainKeys.insert(pair<pair<string, string>, unsigned int>(segChain, chainKeys.size())).first;
+		}
+		indexChain[i] = found->second;
+		indexResidueNumber[i] = fragDB[i]->getResidueNumber();
+	}
+}
+
+const vector<pair<float, unsigned int> > & PDBFragments::getSpanIndex(unsigned int _span) {
+	map<unsigned int, vector<pair<float, unsigned int> > >::iterator found = spanIndices.find(_span);
+	if (found != spanIndices.end()) {
+		return found->second;
+	}
+	vector<pair<float, unsigned int> > & windows = spanIndices[_span];
+	for (uint i = 0; i + _span < indexChain.size(); i++) {
+		if (indexChain[i] == indexChain[i + _span]) {
+			windows.push_back(pair<float, unsigned int>((float)getIndexDistance(i, i + _span), i));
+		}
+	}
+	sort(windows.begin(), windows.end());
+	return windows;
+}
+
+double PDBFragments::scoreWindow(const FragmentQuery & _query, unsigned int _first, OptimalRMSDCalculator & _calc, AtomPointerVector & _window) const {
+	// returns the RMSD of the window starting at _first, or -1.0 if it does not pass the filters
+	for (uint k = 0; k < _query.checkA.size(); k++) {
+		double d = getIndexDistance(_first + _query.offsets[_query.checkA[k]], _first + _query.offsets[_query.checkB[k]]);
+		if (fabs(d - _query.checkDistance[k]) > _query.checkTol) {
+			return -1.0;
+		}
+	}
+
+	if (_query.stems) {
+		// Check for a gap (PDB Structures have gaps).
+		unsigned int lastOfStem1 = _first + _query.stem1Size - 1;
+		unsigned int firstOfStem2 = _first + _query.stem1Size + _query.gap;
+		if (abs(indexResidueNumber[lastOfStem1] - indexResidueNumber[firstOfStem2]) != _query.gap + 1) {
+			return -1.0;
+		}
+
+		// Distance Filter... are the proposed stems close enough ?
+		uint index = 0;
+		for (uint c = 0; c < _query.stem1Size; c++) {
+			for (uint n = 0; n < _query.stem2Size; n++) {
+				double d = getIndexDistance(_first + c, firstOfStem2 + n);
+				if (fabs(_query.stemDistanceSq[index++] - d * d) > _query.stemDistanceTol) {
+					return -1.0;
+				}
+			}
+		}
+	}
+
+	for (uint k = 0; k < _query.offsets.size(); k++) {
+		_window[k] = fragDB[_first + _query.offsets[k]];
+	}
+	bool success = false;
+	double rmsd = _calc.bestRMSD(_window, *_query.pRef, &success);
+	if (!success || rmsd > _query.rmsdTol) {
+		return -1.0;
+	}
+	return rmsd;
+}
+
+void * PDBFragments::runCandidates(void * _runner) {
+	FragmentRunner * pRunner = (FragmentRunner*)_runner;
+	const vector<unsigned int> & candidates = *(pRunner->pCandidates);
+	vector<double> & rmsd = *(pRunner->pRmsd);
+	const unsigned int chunk = 64;
+	OptimalRMSDCalculator calc;
+	AtomPointerVector window(pRunner->pQuery->offsets.size(), NULL);
+	while (true) {
+		unsigned int first = 0;
+		if (pRunner->pMutex != NULL) {
+			pthread_mutex_lock(pRunner->pMutex);
+		}
+		first = *(pRunner->pNextCandidate);
+		*(pRunner->pNextCandidate) += chunk;
+		if (pRunner->pMutex != NULL) {
+			pthread_mutex_unlock(pRunner->pMutex);
+		}
+		if (first >= candidates.size()) {
+			break;
+		}
+		for (unsigned int i=first; i<first+chunk && i<candidates.size(); i++) {
+			// each candidate is written only by the thread that scores it
+			rmsd[i] = pRunner->pFragments->scoreWindow(*(pRunner->pQuery), candidates[i], calc, window);
+		}
+	}
+	return NULL;
+}
+
+void PDBFragments::findMatchingWindows(const FragmentQuery & _query, vector<pair<unsigned int, double> > & _matches) {
+	_matches.clear();
+	if (_query.minSpanDistance > _query.maxSpanDistance) {
+		return;
+	}
+
+	// the windows in the distance range (with a margin for the single precision of the index)
+	const vector<pair<float, unsigned int> > & windows = getSpanIndex(_query.span);
+	vector<pair<float, unsigned int> >::const_iterator begin = lower_bound(windows.begin(), windows.end(), pair<float, unsigned int>((float)(_query.minSpanDistance - 0.001), 0));
+	vector<pair<float, unsigned int> >::const_iterator end = upper_bound(begin, windows.end(), pair<float, unsigned int>((float)(_query.maxSpanDistance + 0.001), UINT_MAX));
+	vector<unsigned int> candidates;
+	candidates.reserve(end - begin);
+	for (vector<pair<float, unsigned int> >::const_iterator k = begin; k != end; k++) {
+		if (k->second < _query.firstEnd) {
+			candidates.push_back(k->second);
+		}
+	}
+	// in database order, the order of the linear scan
+	sort(candidates.begin(), candidates.end());
+	MSLOUT.stream() << "Superimposing "<<candidates.size()<<" of "<<windows.size()<<" fragments"<<endl;
+
+	vector<double> rmsd(candidates.size(), -1.0);
+	unsigned int nextCandidate = 0;
+	unsigned int nThreads = numberOfThreads;
+	if (nThreads > candidates.size()) {
+		nThreads = candidates.size();
+	}
+	if (nThreads <= 1) {
+		FragmentRunner runner;
+		runner.pFragments = this;
+		runner.pQuery = &_query;
+		runner.pCandidates = &candidates;
+		runner.pRmsd = &rmsd;
+		runner.pNextCandidate = &nextCandidate;
+		runner.pMutex = NULL;
+		runCandidates(&runner);
+	} else {
+		pthread_mutex_t mutex;
+		pthread_mutex_init(&mutex, NULL);
+		vector<FragmentRunner> runners(nThreads);
+		for (unsigned int t=0; t<nThreads; t++) {
+			runners[t].pFragments = this;
+			runners[t].pQuery = &_query;
+			runners[t].pCandidates = &candidates;
+			runners[t].pRmsd = &rmsd;
+			runners[t].pNextCandidate = &nextCandidate;
+			runners[t].pMutex = &mutex;
+		}
+		vector<void*> args(nThreads);
+		for (unsigned int t=0; t<nThreads; t++) {
+			args[t] = &runners[t];
+		}
+		MslTools::runThreads(runCandidates, args);
+		pthread_mutex_destroy(&mutex);
+	}
+
+	for (uint i = 0; i < candidates.size(); i++) {
+		if (rmsd[i] >= 0.0) {
+			_matches.push_back(pair<unsigned int, double>(candidates[i], rmsd[i]));
+		}
+	}
+}
+
+void PDBFragments::clearHits() {
+	for (uint i = 0; i < lastHits.size(); i++) {
+		lastHits[i]->caTrace.deletePointers();
+		// once collected the atoms belong to lastResults
+		if (!hitsCollected && lastHits[i]->pAtoms != NULL) {
+			delete lastHits[i]->pAtoms;
+		}
+		delete lastHits[i];
+	}
+	lastHits.clear();
+	hitsCollected = true;
+}
+
+void PDBFragments::materializeHit(FragmentHit & _hit) {
+	_hit.materialized = true;
+	_hit.pAtoms = NULL;
+	if (pdbDir == "") {
+		// Add CA only atoms..
+		_hit.pAtoms = new AtomContainer(_hit.caTrace);
+		return;
+	}
+
+	Atom &at1 = fragDB(_hit.first);
+	Atom &at2 = fragDB(_hit.first + _hit.size - 1);
+	System * pSource = getSourceStructure(at1.getSegID());
+	if (pSource == NULL) {
+		return;
+	}
+
+	// Copy the atoms to be moved, the source structure is shared by the other hits
+	AtomContainer * pAtoms = new AtomContainer();
+	if (includeFullFile) {
+		pAtoms->addAtoms(pSource->getAtomPointers());
+	} else {
+		AtomSelection sel(pSource->getAtomPointers());
+		pAtoms->addAtoms(sel.select(MslTools::stringf("chain %1s and resi %d-%-d", at1.getChainId().c_str(), at1.getResidueNumber(), at2.getResidueNumber())));
+	}
+
+	// The fragment superimposed onto its aligned CA trace carries the all-atom copies onto the query
+	AtomPointerVector fragCopy;
+	for (uint j = 0; j < _hit.size; j++) {
+		fragCopy.push_back(new Atom(fragDB(_hit.first + j)));
+	}
+	Transforms tm;
+	bool aligned = tm.rmsdAlignment(fragCopy, _hit.caTrace, pAtoms->getAtomPointers());
+	fragCopy.deletePointers();
+	if (!aligned) {
+		cerr << "ERROR in alignment2: "<<_hit.size<<" "<<_hit.caTrace.size()<<endl;
+		delete pAtoms;
+		return;
+	}
+	_hit.pAtoms = pAtoms;
+}
+
+void PDBFragments::collectHits() {
+	if (hitsCollected) {
+		return;
+	}
+	for (uint i = 0; i < lastHits.size(); i++) {
+		if (!lastHits[i]->materialized) {
+			materializeHit(*lastHits[i]);
+		}
+		if (lastHits[i]->pAtoms != NULL) {
+			lastResults.push_back(lastHits[i]->pAtoms);
+		}
+	}
+	hitsCollected = true;
+}
+
+System * PDBFragments::getSourceStructure(string _segID) {
+	string fileName = MslTools::stringf("%s/%s.pdb",pdbDir.c_str(),_segID.c_str());
+	map<string, list<pair<string, System*> >::iterator>::iterator found = sourceCacheIndex.find(fileName);
+	if (found != sourceCacheIndex.end()) {
+		// move it to the front, the least recently used are at the back
+		sourceCache.splice(sourceCache.begin(), sourceCache, found->second);
+		return sourceCache.front().second;
+	}
+
+	MSLOUT.stream() << "Opening "<<fileName<<endl;
+	System * pSource = new System;
+	if (!pSource->readPdb(fileName)) {
+		cerr << "ERROR 2343 PDBFragments::getSourceStructure() cannot read " << fileName << endl;
+		delete pSource;
+		return NULL;
+	}
+	for (uint ats = 0; ats < pSource->getAtomPointers().size();ats++){
+		pSource->getAtom(ats).setSegID("");
+	}
+
+	// without a cache the structure is only kept until the next one is read
+	if (uncachedSource != NULL) {
+		delete uncachedSource;
+		uncachedSource = NULL;
+	}
+	if (sourceCacheSize == 0) {
+		uncachedSource = pSource;
+		return pSource;
+	}
+	while (sourceCache.size() >= sourceCacheSize) {
+		sourceCacheIndex.erase(sourceCache.back().first);
+		delete sourceCache.back().second;
+		sourceCache.pop_back();
+	}
+	sourceCache.push_front(pair<string, System*>(fileName, pSource));
+	sourceCacheIndex[fileName] = sourceCache.begin();
+	return pSource;
+}
+
+bool PDBFragments::sourceExists(string _segID) {
+	map<string, bool>::iterator found = sourceFound.find(_segID);
+	if (found != sourceFound.end()) {
+		return found->second;
+	}
+	bool exists = MslTools::fileExists(MslTools::stringf("%s/%s.pdb",pdbDir.c_str(),_segID.c_str()));
+	sourceFound[_segID] = exists;
+	return exists;
+}
+
+void PDBFragments::clearSourceCache() {
+	for (list<pair<string, System*> >::iterator k = sourceCache.begin(); k != sourceCache.end(); k++) {
+		delete k->second;
+	}
+	sourceCache.clear();
+	sourceCacheIndex.clear();
+	if (uncachedSource != NULL) {
+		delete uncachedSource;
+		uncachedSource = NULL;
+	}
+	sourceFound.clear();
+}
@@ -31,10 +31,13 @@ You should have received a copy of the GNU Lesser General Public
 #define PDBFRAGMENTS_H
 
 #include <string>
+#include <list>
+#include <pthread.h>
 
 #include "AtomPointerVector.h"
 #include "AtomContainer.h"
 #include "System.h"
+#include "OptimalRMSDCalculator.h"
 
 namespace MSL { 
 class PDBFragments{
@@ -75,29 +78,125 @@ class PDBFragments{
 		void printMe();
 
 		void setIncludeFullFile(bool _flag); 
+
+		void setNumberOfThreads(unsigned int _threads); // the candidate fragments are superimposed by the threads (default 1)
+		unsigned int getNumberOfThreads() const;
+
+		// Hits of the last linear search: the CA trace of the fragment is kept aligned onto the query, the
+		// all-atom coordinates (from pdbDir) are only read by getHitAtoms() or getAtomContainers().  With
+		// a pdbDir, the hits whose structure cannot be opened there are not counted
+		unsigned int getNumberOfHits() const;
+		double getHitRMSD(unsigned int _n) const;
+		std::string getHitSequence(unsigned int _n) const;
+		AtomPointerVector & getHitCAtrace(unsigned int _n);
+		AtomContainer * getHitAtoms(unsigned int _n); // NULL if the source structure could not be read or aligned
+
+		// The structures read from pdbDir are parsed once and kept for the following hits and searches
+		void setSourceCacheSize(unsigned int _size); // number of structures kept, the least recently used is dropped (default 20, 0 keeps none)
+		unsigned int getSourceCacheSize() const;
+		void clearSourceCache();
+
 	private:
+		/***************************************************************
+		 *  Search index of the fragment database, built when it is
+		 *  loaded: the CA coordinates in a flat array, an integer key
+		 *  for each segID/chain and the residue numbers.  For each span
+		 *  the windows that do not change segID/chain are sorted by the
+		 *  distance between their end CAs (built by the first search
+		 *  with that span).  If the RMSD of N atoms is at most tol,
+		 *  any distance between two of them differs by at most
+		 *  sqrt(2N)*tol, so only the windows in that distance range
+		 *  are superimposed, and without moving the database atoms
+		 ***************************************************************/
+		struct FragmentQuery {
+			AtomPointerVector * pRef;          // the query atoms
+			std::vector<unsigned int> offsets; // residue of the window (from the first) of each query atom
+			unsigned int span;                 // residue of the window (from the first) of the last query atom
+			unsigned int firstEnd;             // the first residue of a window must be below this
+			double rmsdTol;
+			double minSpanDistance;            // range of the distance between the end CAs of the window
+			double maxSpanDistance;
+			std::vector<unsigned int> checkA;  // other pairs of query atoms whose distance is checked before superimposing
+			std::vector<unsigned int> checkB;
+			std::vector<double> checkDistance;
+			double checkTol;
+			// searches by stems: the residue numbering must be contiguous between the stems and
+			// the stem-to-stem distances squared must be within stemDistanceTol of the query
+			bool stems;
+			unsigned int stem1Size;
+			unsigned int stem2Size;
+			int gap;
+			std::vector<double> stemDistanceSq;
+			double stemDistanceTol;
+		};
+		struct FragmentRunner {
+			const PDBFragments * pFragments;
+			const FragmentQuery * pQuery;
+			const std::vector<unsigned int> * pCandidates;
+			std::vector<double> * pRmsd;      // one per candidate, negative if the window was rejected
+			unsigned int * pNextCandidate;    // shared, the candidates are taken in chunks by the first free thread
+			pthread_mutex_t * pMutex;
+		};
+		void indexFragmentDatabase();
+		const std::vector<std::pair<float, unsigned int> > & getSpanIndex(unsigned int _span);
+		double getIndexDistance(unsigned int _i, unsigned int _j) const;
+		double scoreWindow(const FragmentQuery & _query, unsigned int _first, OptimalRMSDCalculator & _calc, AtomPointerVector & _window) const;
+		static void * runCandidates(void * _runner);
+		void findMatchingWindows(const FragmentQuery & _query, std::vector<std::pair<unsigned int, double> > & _matches);
+
+		struct FragmentHit {
+			unsigned int first;          // first residue of the fragment in fragDB
+			unsigned int size;
+			double rmsd;
+			std::string sequence;
+			AtomPointerVector caTrace;   // copies of the fragment atoms, aligned onto the query
+			AtomContainer * pAtoms;      // built on request
+			bool materialized;
+		};
+		void clearHits();
+		void materializeHit(FragmentHit & _hit);
+		void collectHits();
+		System * getSourceStructure(std::string _segID); // the structure is shared, it should not be moved
+		bool sourceExists(std::string _segID); // the structure of the segID can be opened in pdbDir
+
 		std::string fragDbFile;
 		dbAtoms fragType;
 		std::string bbqTable;
-		AtomPointerVector fragDB;
+		AtomPointerVector fragDB; // owns the atoms read from fragDbFile
 		std::string pdbDir;
 		bool includeFullFile;
 		map<std::string,std::string> matchedSequences;
 		vector<AtomContainer *> lastResults;
+
+		std::vector<double> indexCoor;          // CA x, y, z of each residue of fragDB
+		std::vector<unsigned int> indexChain;   // integer key of the segID/chain of each residue
+		std::vector<int> indexResidueNumber;
+		std::map<unsigned int, std::vector<std::pair<float, unsigned int> > > spanIndices;
+		unsigned int numberOfThreads;
+
+		std::vector<FragmentHit*> lastHits;
+		bool hitsCollected; // the hits are in lastResults
+
+		std::list<std::pair<std::string, System*> > sourceCache; // most recently used first
+		std::map<std::string, std::list<std::pair<std::string, System*> >::iterator> sourceCacheIndex;
+		unsigned int sourceCacheSize;
+		System * uncachedSource; // the last structure read when the cache size is 0, deleted by the next read
+		std::map<std::string, bool> sourceFound; // by sourceExists(), per segID
 };
 
 inline void PDBFragments::setFragDB(std::string _fragdb) { fragDbFile = _fragdb;}
-inline void PDBFragments::setPdbDir(std::string _pdbdir) { pdbDir = _pdbdir;}
+inline void PDBFragments::setPdbDir(std::string _pdbdir) { pdbDir = _pdbdir; sourceFound.clear();}
 inline void PDBFragments::setBBQTable(std::string _table) { bbqTable = _table;}
-inline vector<AtomContainer*> & PDBFragments::getAtomContainers() { return lastResults;}		
+inline vector<AtomContainer*> & PDBFragments::getAtomContainers() { collectHits(); return lastResults;}		
 inline AtomPointerVector PDBFragments::getAtomPointers() { 
+  collectHits();
   AtomPointerVector ats;
   for (uint i =0;  i < lastResults.size();i++){
     ats += lastResults[i]->getAtomPointers();
   }
   return ats;
 }
-inline PDBFragments::PDBFragments() { 	fragType   = caOnly; pdbDir = ""; fragDbFile = ""; bbqTable="";}
+inline PDBFragments::PDBFragments() { 	fragType   = caOnly; pdbDir = ""; fragDbFile = ""; bbqTable=""; includeFullFile = false; numberOfThreads = 1; hitsCollected = true; sourceCacheSize = 20; uncachedSource = NULL;}
 inline PDBFragments::PDBFragments(std::string _fragDbFile,std::string _BBQTableForBackboneAtoms) {
 	fragDbFile = _fragDbFile;
 	pdbDir = "";
@@ -108,11 +207,21 @@ inline PDBFragments::PDBFragments(std::string _fragDbFile,std::string _BBQTableF
 		fragType   = caOnly;
 	}
 	bbqTable = _BBQTableForBackboneAtoms;
+	includeFullFile = false;
+	numberOfThreads = 1;
+	hitsCollected = true;
+	sourceCacheSize = 20;
+	uncachedSource = NULL;
 
 }
 inline PDBFragments::~PDBFragments() {
+	clearHits();
+	clearSourceCache();
+	fragDB.deletePointers(); // the atoms were allocated by load_checkpoint
 }
 inline void PDBFragments::loadFragmentDatabase(){
+	clearHits();
+	fragDB.deletePointers();
 	fragDB.load_checkpoint(fragDbFile);
 	cout << "FragDB: "<<fragDB.getName()<<" has "<<fragDB.size()<<" atoms."<<endl;
 	if (fragDB.getName() == "ca-only"){
@@ -123,6 +232,7 @@ inline void PDBFragments::loadFragmentDatabase(){
 	  fragType = allAtoms;
 	}
 
+	indexFragmentDatabase();
 }
 
 inline map<std::string,std::string> & PDBFragments::getMatchedSequences(){
@@ -137,6 +247,33 @@ inline void PDBFragments::printMe(){
 inline void PDBFragments::setIncludeFullFile(bool _flag){
   includeFullFile = _flag;
 }
+inline void PDBFragments::setNumberOfThreads(unsigned int _threads) {numberOfThreads = _threads;}
+inline unsigned int PDBFragments::getNumberOfThreads() const {return numberOfThreads;}
+inline unsigned int PDBFragments::getNumberOfHits() const {return lastHits.size();}
+inline double PDBFragments::getHitRMSD(unsigned int _n) const {return lastHits[_n]->rmsd;}
+inline std::string PDBFragments::getHitSequence(unsigned int _n) const {return lastHits[_n]->sequence;}
+inline AtomPointerVector & PDBFragments::getHitCAtrace(unsigned int _n) {return lastHits[_n]->caTrace;}
+inline AtomContainer * PDBFragments::getHitAtoms(unsigned int _n) {
+	if (!lastHits[_n]->materialized) {
+		materializeHit(*lastHits[_n]);
+	}
+	return lastHits[_n]->pAtoms;
+}
+inline void PDBFragments::setSourceCacheSize(unsigned int _size) {
+	sourceCacheSize = _size;
+	while (sourceCache.size() > sourceCacheSize) {
+		sourceCacheIndex.erase(sourceCache.back().first);
+		delete sourceCache.back().second;
+		sourceCache.pop_back();
+	}
+}
+inline unsigned int PDBFragments::getSourceCacheSize() const {return sourceCacheSize;}
+inline double PDBFragments::getIndexDistance(unsigned int _i, unsigned int _j) const {
+	double dx = indexCoor[3*_i] - indexCoor[3*_j];
+	double dy = indexCoor[3*_i+1] - indexCoor[3*_j+1];
+	double dz = indexCoor[3*_i+2] - indexCoor[3*_j+2];
+	return sqrt(dx*dx + dy*dy + dz*dz);
+}
 
 }
 
@@ -140,8 +140,32 @@ void PDBReader::deletePointers() {
  * ATOM and HETATM information.  All other information 
  * (REMARKS, HEADER, TITLE, SEQRES, HET, etc.) is
  * simply ignored.
+ *
+ * The input is scanned in place (memory mapped when it is a
+ * file, inflated first when it is gzip compressed) and the
+ * atom lines are parsed column by column without creating
+ * strings.
  */
 bool PDBReader::read(bool _noHydrogens) {
+	return parseContent(_noHydrogens, NULL, NULL);
+}
+
+/**
+ * Streaming read of multi-model files: the atoms of each model
+ * are handed to _callback(atoms, modelNumber, _data) as soon as
+ * the model ends (ENDMDL, a new MODEL or the end of the file)
+ * and deleted when the callback returns, so that only one model
+ * is in memory at a time.  The model numbers are counted from 1.
+ * Reading stops early if the callback returns false.
+ */
+bool PDBReader::readModels(ModelCallback _callback, void * _data, bool _noHydrogens) {
+	if (_callback == NULL) {
+		return false;
+	}
+	return parseContent(_noHydrogens, _callback, _data);
+}
+
+bool PDBReader::parseContent(bool _noHydrogens, ModelCallback _callback, void * _data) {
 	if (!is_open()) {
 		return false;
 	}
@@ -149,185 +173,67 @@ bool PDBReader::read(bool _noHydrogens) {
 
 	try { 
 
+		if (!loadContent()) {
+			return false;
+		}
 
 		numberOfModels = 0;
 		string currentResidue = "";
 		map<string, vector<PDBFormat::AtomData> > currentResidueAtoms;
 		bool foundMissingStart = false;
+		unsigned int modelsDelivered = 0;
+
+		// the bounding box is tracked in locals and stored at the end
+		double minX = boundingCoords["minX"];
+		double maxX = boundingCoords["maxX"];
+		double minY = boundingCoords["minY"];
+		double maxY = boundingCoords["maxY"];
+		double minZ = boundingCoords["minZ"];
+		double maxZ = boundingCoords["maxZ"];
+
+		// a PDB line is about 81 bytes: reserve the pointers for a file of atoms
+		if (_callback == NULL) {
+			atoms.reserve(atoms.size() + (contentEnd - contentBegin) / 81 + 1);
+		}
 
-		while (!endOfFileTest()){
-			string line = Reader::getLine();
-	//		string header 	= line.substr(PDBFormat::S_RECORD_NAME, PDBFormat::L_RECORD_NAME);
-			// check the length
-			string header = "";
-			if (line.size() >= PDBFormat::S_RECORD_NAME + PDBFormat::L_RECORD_NAME) {
-				header 	= line.substr(PDBFormat::S_RECORD_NAME, PDBFormat::L_RECORD_NAME);
-			}
-
-		// Deal with remark parsing..
-			if (header == "REMARK"){
-				// REMEMBER TO VALIDATE THE SUBSTR!!! (most important, the skip cannot be more than the srting length)
-				if (line.size() >= PDBFormat::S_SYMMRECORD + PDBFormat::L_SYMMRECORD && line.substr(7,3) == "290"){
-					string symlinetype = line.substr(PDBFormat::S_SYMMRECORD,PDBFormat::L_SYMMRECORD);
-					if (symlinetype != "SMTRY"){
-						continue;
-					}
-
-					PDBFormat::SymData sym = PDBFormat::parseSymLine(line);
-
-					if (symmetryRotations.size() < sym.D_SYMMINDEX){
-						symmetryRotations.push_back(new Matrix(3,3,0.0));
-						(*symmetryRotations.back())[0][0] = 1.0;
-						(*symmetryRotations.back())[1][1] = 1.0;
-						(*symmetryRotations.back())[2][2] = 1.0;
-						symmetryTranslations.push_back(new CartesianPoint(0.0,0.0,0.0));
-					}
-					(*symmetryRotations[sym.D_SYMMINDEX-1])[sym.D_SYMMLINE-1][0] = sym.D_SYMMX;
-					(*symmetryRotations[sym.D_SYMMINDEX-1])[sym.D_SYMMLINE-1][1] = sym.D_SYMMY;
-					(*symmetryRotations[sym.D_SYMMINDEX-1])[sym.D_SYMMLINE-1][2] = sym.D_SYMMZ;
-					(*symmetryTranslations[sym.D_SYMMINDEX-1])[sym.D_SYMMLINE-1] = sym.D_SYMTRANS;
-					
-				}
-				if (line.size() >= PDBFormat::S_BIOURECORD + PDBFormat::L_BIOURECORD && line.substr(7,3) == "350"){
-					/*
-					  This does not handle multiple BIOMT sections for different chains.
-					  Therefore BIO UNIT matrices are not stored properly and BIO UNITS will not be properly generated.
-					  See 3DVH as an example (its in testData.h)
-					 */
-					string biolinetype = line.substr(PDBFormat::S_BIOURECORD,PDBFormat::L_BIOURECORD);
-					if (biolinetype != "BIOMT"){
-						continue;
-					}
-
-					PDBFormat::BioUData bio = PDBFormat::parseBioULine(line);
-
-					if (biounitRotations.size() < bio.D_BIOUINDEX){
-						biounitRotations.push_back(new Matrix(3,3,0.0));
-						(*biounitRotations.back())[0][0] = 1.0;
-						(*biounitRotations.back())[1][1] = 1.0;
-						(*biounitRotations.back())[2][2] = 1.0;
-						biounitTranslations.push_back(new CartesianPoint(0.0,0.0,0.0));
-					}
-					(*biounitRotations[bio.D_BIOUINDEX-1])[bio.D_BIOULINE-1][0] = bio.D_BIOUX;
-					(*biounitRotations[bio.D_BIOUINDEX-1])[bio.D_BIOULINE-1][1] = bio.D_BIOUY;
-					(*biounitRotations[bio.D_BIOUINDEX-1])[bio.D_BIOULINE-1][2] = bio.D_BIOUZ;
-
-					(*biounitTranslations[bio.D_BIOUINDEX-1])[bio.D_BIOULINE-1] = bio.D_BIOUTRANS;
-				}
-				// NOTE: CHANGE TO USE PDBFormat FOR MISSING ATOMS AND RESIDUES!!!!
-				if(line.size() >= 27 && line.substr(7,3) == "465") {
-					// missing residues
-					if (!foundMissingStart) {
-						if (line.substr(0,27) == "REMARK 465     RES C SSSEQI") {
-							foundMissingStart = true;
-						}
-					} else { 
-						if(line.substr(11,1) == " " && line.substr(15,1) != " " && line.substr(13,1) != "M") {
-							MissingResidue res;	
-							res.model = line.substr(13,1) == " " ? 0 : MslTools::toInt(line.substr(13,1));
-							res.resName = line.substr(15,3);
-							res.chainId = line.substr(19,1);
-							res.resNum = MslTools::toInt(MslTools::trim(line.substr(22,4)));
-							res.resIcode = line.substr(26,1);
-							misRes.push_back(res);
-						} else {
-							continue;
-						}
-					}
-				}
-
-				if(line.size() >= 27 && line.substr(7,3) == "470") {
-					// missing atoms
-					if(line.substr(11,1) == " " && line.substr(15,1) != " " && line.substr(13,1) != "M") {
-						MissingAtoms mAtoms;	
-						mAtoms.model = line.substr(13,1) == " " ? 0 : MslTools::toInt(line.substr(13,1));
-						mAtoms.resName = line.substr(15,3);
-						mAtoms.chainId = line.substr(19,1);
-						mAtoms.resNum = MslTools::toInt(line.substr(20,4));
-						mAtoms.resIcode = line.substr(24,1);
-						string temp = line.substr(27);
-						mAtoms.atoms = MslTools::tokenize(MslTools::trim(temp));
-						misAtoms.push_back(mAtoms);
-
-					} else {
-						continue;
-					}
-				}
+		PDBFormat::AtomData atom;
+		const char * pos = contentBegin;
+		const char * line = NULL;
+		unsigned int length = 0;
+		while (nextLine(pos, line, length)){
+			if (length < PDBFormat::S_RECORD_NAME + PDBFormat::L_RECORD_NAME) {
+				continue;
 			}
+			const char * header = line + PDBFormat::S_RECORD_NAME;
 
-			if (header == "SCALE1" || header == "SCALE2" || header == "SCALE3"){
-					PDBFormat::ScaleData scale = PDBFormat::parseScaleLine(line);
-					
-					(*scaleRotation)[scale.D_SCALELINE-1][0] = scale.D_SCALEX;
-					(*scaleRotation)[scale.D_SCALELINE-1][1] = scale.D_SCALEY;
-					(*scaleRotation)[scale.D_SCALELINE-1][2] = scale.D_SCALEZ;
-
-					(*scaleTranslation)[scale.D_SCALELINE-1] = scale.D_SCALETRANS;
-					
-			}
-			if (header == "CRYST1"){
-				PDBFormat::CrystData cryst = PDBFormat::parseCrystLine(line);
-
-				unitCellParams.push_back(cryst.D_CRYSTA);
-				unitCellParams.push_back(cryst.D_CRYSTB);
-				unitCellParams.push_back(cryst.D_CRYSTC);
-				unitCellParams.push_back(cryst.D_CRYSTALPHA);
-				unitCellParams.push_back(cryst.D_CRYSTBETA);
-				unitCellParams.push_back(cryst.D_CRYSTGAMMA);
-				
-			}
-			
-			if (header == "MODEL "){
-				PDBFormat::ModelData model = PDBFormat::parseModelLine(line);
-				
-				if (!model.D_ENDMODEL_FLAG) {
-					// we are currently ignoring the model number, just counting them,
-					// this allow support for PDB files that are not properly formatted with
-					// model numbers
-					numberOfModels++;
-				}
-			}
-			
-			if (header == "ATOM  " || header == "HETATM"){
-				PDBFormat::AtomData atom = PDBFormat::parseAtomLine(line);
-				string elem = atom.D_ELEMENT_SYMBOL;
-				if (_noHydrogens && elem == "H") {  continue; }
+			if (memcmp(header, "ATOM  ", 6) == 0 || memcmp(header, "HETATM", 6) == 0){
+				PDBFormat::parseAtomLine(line, length, atom);
+				if (_noHydrogens && !strcmp(atom.D_ELEMENT_SYMBOL, "H")) {  continue; }
 
 
 				// NORMAL READING MODE = singleAltLocFlag is false;
 				if (!singleAltLocFlag){
-					atoms.push_back(new Atom);
-
-					// atom name, residue name, residue icode, chain id, coor, element
-					atoms.back()->setName(atom.D_ATOM_NAME);
-					atoms.back()->setResidueName(atom.D_RES_NAME);
-					atoms.back()->setResidueIcode(atom.D_I_CODE);
-					atoms.back()->setResidueNumber(atom.D_RES_SEQ);
-					atoms.back()->setChainId(!strcmp(atom.D_CHAIN_ID, "") ? atom.D_SEG_ID : atom.D_CHAIN_ID);
-					atoms.back()->setCoor(atom.D_X,atom.D_Y, atom.D_Z);
-					atoms.back()->setElement(atom.D_ELEMENT_SYMBOL);
-					atoms.back()->setTempFactor(atom.D_TEMP_FACT);
-					atoms.back()->setSegID(atom.D_SEG_ID);
-
-					if (atom.D_X < boundingCoords["minX"]){
-						boundingCoords["minX"] = atom.D_X;
+					atoms.push_back(createAtom(atom));
+
+					if (atom.D_X < minX){
+						minX = atom.D_X;
 					}
-					if (atom.D_X > boundingCoords["maxX"]){
-						boundingCoords["maxX"] = atom.D_X;
+					if (atom.D_X > maxX){
+						maxX = atom.D_X;
 					}
 
-					if (atom.D_Y < boundingCoords["minY"]){
-						boundingCoords["minY"] = atom.D_Y;
+					if (atom.D_Y < minY){
+						minY = atom.D_Y;
 					}
-					if (atom.D_Y > boundingCoords["maxY"]){
-						boundingCoords["maxY"] = atom.D_Y;
+					if (atom.D_Y > maxY){
+						maxY = atom.D_Y;
 					}
 
-					if (atom.D_Z < boundingCoords["minZ"]){
-						boundingCoords["minZ"] = atom.D_Z;
+					if (atom.D_Z < minZ){
+						minZ = atom.D_Z;
 					}
-					if (atom.D_Z > boundingCoords["maxZ"]){
-						boundingCoords["maxZ"] = atom.D_Z;
+					if (atom.D_Z > maxZ){
+						maxZ = atom.D_Z;
 					}
 
 
@@ -358,9 +264,32 @@ bool PDBReader::read(bool _noHydrogens) {
 					currentResidue = resDescription.str();
 				}
 
+				continue;
+			}
+
+			if (_callback != NULL && (memcmp(header, "ENDMDL", 6) == 0 || memcmp(header, "MODEL ", 6) == 0)) {
+				if (!deliverModel(_callback, _data, modelsDelivered, currentResidue, currentResidueAtoms)) {
+					break;
+				}
+			}
+
+			// the other records are rare, they are parsed from a string
+			if (memcmp(header, "REMARK", 6) == 0 || memcmp(header, "SCALE", 5) == 0 || memcmp(header, "CRYST1", 6) == 0 || memcmp(header, "MODEL ", 6) == 0) {
+				parseRecordLine(string(line, length), foundMissingStart);
 			}
 
 		}
+		if (_callback != NULL) {
+			deliverModel(_callback, _data, modelsDelivered, currentResidue, currentResidueAtoms);
+		}
+		releaseContent();
+
+		boundingCoords["minX"] = minX;
+		boundingCoords["maxX"] = maxX;
+		boundingCoords["minY"] = minY;
+		boundingCoords["maxY"] = maxY;
+		boundingCoords["minZ"] = minZ;
+		boundingCoords["maxZ"] = maxZ;
 
 		boundingCoords["deltaX"] = boundingCoords["maxX"] - boundingCoords["minX"];
 		boundingCoords["deltaY"] = boundingCoords["maxY"] - boundingCoords["minY"];
@@ -389,12 +318,183 @@ bool PDBReader::read(bool _noHydrogens) {
 		
 	} catch(...){
 		cerr << "ERROR 5623 in PDBReader::read()\n";
+		releaseContent();
 		return false;
 	}
 
 	return true;
 }
 
+/**
+ * Parses the REMARK 290/350/465/470, SCALEn, CRYST1 and MODEL records
+ */
+void PDBReader::parseRecordLine(const string & _line, bool & _foundMissingStart) {
+	string header = _line.substr(PDBFormat::S_RECORD_NAME, PDBFormat::L_RECORD_NAME);
+
+	// Deal with remark parsing..
+	if (header == "REMARK"){
+		// REMEMBER TO VALIDATE THE SUBSTR!!! (most important, the skip cannot be more than the srting length)
+		if (_line.size() >= PDBFormat::S_SYMMRECORD + PDBFormat::L_SYMMRECORD && _line.substr(7,3) == "290"){
+			string symlinetype = _line.substr(PDBFormat::S_SYMMRECORD,PDBFormat::L_SYMMRECORD);
+			if (symlinetype != "SMTRY"){
+				return;
+			}
+
+			PDBFormat::SymData sym = PDBFormat::parseSymLine(_line);
+
+			if (symmetryRotations.size() < sym.D_SYMMINDEX){
+				symmetryRotations.push_back(new Matrix(3,3,0.0));
+				(*symmetryRotations.back())[0][0] = 1.0;
+				(*symmetryRotations.back())[1][1] = 1.0;
+				(*symmetryRotations.back())[2][2] = 1.0;
+				symmetryTranslations.push_back(new CartesianPoint(0.0,0.0,0.0));
+			}
+			(*symmetryRotations[sym.D_SYMMINDEX-1])[sym.D_SYMMLINE-1][0] = sym.D_SYMMX;
+			(*symmetryRotations[sym.D_SYMMINDEX-1])[sym.D_SYMMLINE-1][1] = sym.D_SYMMY;
+			(*symmetryRotations[sym.D_SYMMINDEX-1])[sym.D_SYMMLINE-1][2] = sym.D_SYMMZ;
+			(*symmetryTranslations[sym.D_SYMMINDEX-1])[sym.D_SYMMLINE-1] = sym.D_SYMTRANS;
+			
+		}
+		if (_line.size() >= PDBFormat::S_BIOURECORD + PDBFormat::L_BIOURECORD && _line.substr(7,3) == "350"){
+			/*
+			  This does not handle multiple BIOMT sections for different chains.
+			  Therefore BIO UNIT matrices are not stored properly and BIO UNITS will not be properly generated.
+			  See 3DVH as an example (its in testData.h)
+			 */
+			string biolinetype = _line.substr(PDBFormat::S_BIOURECORD,PDBFormat::L_BIOURECORD);
+			if (biolinetype != "BIOMT"){
+				return;
+			}
+
+			PDBFormat::BioUData bio = PDBFormat::parseBioULine(_line);
+
+			if (biounitRotations.size() < bio.D_BIOUINDEX){
+				biounitRotations.push_back(new Matrix(3,3,0.0));
+				(*biounitRotations.back())[0][0] = 1.0;
+				(*biounitRotations.back())[1][1] = 1.0;
+				(*biounitRotations.back())[2][2] = 1.0;
+				biounitTranslations.push_back(new CartesianPoint(0.0,0.0,0.0));
+			}
+			(*biounitRotations[bio.D_BIOUINDEX-1])[bio.D_BIOULINE-1][0] = bio.D_BIOUX;
+			(*biounitRotations[bio.D_BIOUINDEX-1])[bio.D_BIOULINE-1][1] = bio.D_BIOUY;
+			(*biounitRotations[bio.D_BIOUINDEX-1])[bio.D_BIOULINE-1][2] = bio.D_BIOUZ;
+
+			(*biounitTranslations[bio.D_BIOUINDEX-1])[bio.D_BIOULINE-1] = bio.D_BIOUTRANS;
+		}
+		// NOTE: CHANGE TO USE PDBFormat FOR MISSING ATOMS AND RESIDUES!!!!
+		if(_line.size() >= 27 && _line.substr(7,3) == "465") {
+			// missing residues
+			if (!_foundMissingStart) {
+				if (_line.substr(0,27) == "REMARK 465     RES C SSSEQI") {
+					_foundMissingStart = true;
+				}
+			} else { 
+				if(_line.substr(11,1) == " " && _line.substr(15,1) != " " && _line.substr(13,1) != "M") {
+					MissingResidue res;	
+					res.model = _line.substr(13,1) == " " ? 0 : MslTools::toInt(_line.substr(13,1));
+					res.resName = _line.substr(15,3);
+					res.chainId = _line.substr(19,1);
+					res.resNum = MslTools::toInt(MslTools::trim(_line.substr(22,4)));
+					res.resIcode = _line.substr(26,1);
+					misRes.push_back(res);
+				} else {
+					return;
+				}
+			}
+		}
+
+		if(_line.size() >= 27 && _line.substr(7,3) == "470") {
+			// missing atoms
+			if(_line.substr(11,1) == " " && _line.substr(15,1) != " " && _line.substr(13,1) != "M") {
+				MissingAtoms mAtoms;	
+				mAtoms.model = _line.substr(13,1) == " " ? 0 : MslTools::toInt(_line.substr(13,1));
+				mAtoms.resName = _line.substr(15,3);
+				mAtoms.chainId = _line.substr(19,1);
+				mAtoms.resNum = MslTools::toInt(_line.substr(20,4));
+				mAtoms.resIcode = _line.substr(24,1);
+				string temp = _line.substr(27);
+				mAtoms.atoms = MslTools::tokenize(MslTools::trim(temp));
+				misAtoms.push_back(mAtoms);
+
+			} else {
+				return;
+			}
+		}
+	}
+
+	if (header == "SCALE1" || header == "SCALE2" || header == "SCALE3"){
+			PDBFormat::ScaleData scale = PDBFormat::parseScaleLine(_line);
+			
+			(*scaleRotation)[scale.D_SCALELINE-1][0] = scale.D_SCALEX;
+			(*scaleRotation)[scale.D_SCALELINE-1][1] = scale.D_SCALEY;
+			(*scaleRotation)[scale.D_SCALELINE-1][2] = scale.D_SCALEZ;
+
+			(*scaleTranslation)[scale.D_SCALELINE-1] = scale.D_SCALETRANS;
+			
+	}
+	if (header == "CRYST1"){
+		PDBFormat::CrystData cryst = PDBFormat::parseCrystLine(_line);
+
+		unitCellParams.push_back(cryst.D_CRYSTA);
+		unitCellParams.push_back(cryst.D_CRYSTB);
+		unitCellParams.push_back(cryst.D_CRYSTC);
+		unitCellParams.push_back(cryst.D_CRYSTALPHA);
+		unitCellParams.push_back(cryst.D_CRYSTBETA);
+		unitCellParams.push_back(cryst.D_CRYSTGAMMA);
+		
+	}
+	
+	if (header == "MODEL "){
+		PDBFormat::ModelData model = PDBFormat::parseModelLine(_line);
+		
+		if (!model.D_ENDMODEL_FLAG) {
+			// we are currently ignoring the model number, just counting them,
+			// this allow support for PDB files that are not properly formatted with
+			// model numbers
+			numberOfModels++;
+		}
+	}
+}
+
+Atom * PDBReader::createAtom(const PDBFormat::AtomData & _atom) {
+	Atom * pAtom = new Atom;
+
+	// atom name, residue name, residue icode, chain id, coor, element
+	pAtom->setName(_atom.D_ATOM_NAME);
+	pAtom->setResidueName(_atom.D_RES_NAME);
+	pAtom->setResidueIcode(_atom.D_I_CODE);
+	pAtom->setResidueNumber(_atom.D_RES_SEQ);
+	pAtom->setChainId(!strcmp(_atom.D_CHAIN_ID, "") ? _atom.D_SEG_ID : _atom.D_CHAIN_ID);
+	pAtom->setCoor(_atom.D_X,_atom.D_Y, _atom.D_Z);
+	pAtom->setElement(_atom.D_ELEMENT_SYMBOL);
+	pAtom->setTempFactor(_atom.D_TEMP_FACT);
+	pAtom->setSegID(_atom.D_SEG_ID);
+	return pAtom;
+}
+
+/**
+ * Hands the atoms of the current model to the streaming callback and
+ * deletes them.  Returns the value of the callback (false stops the reading).
+ */
+bool PDBReader::deliverModel(ModelCallback _callback, void * _data, unsigned int & _modelsDelivered, string & _currentResidue, map<string, vector<PDBFormat::AtomData> > & _currentResidueAtoms) {
+	if (singleAltLocFlag && !_currentResidueAtoms.empty()) {
+		// the last residue of the model
+		addAtoms(_currentResidueAtoms, discoverProperResidueAltLoc(_currentResidueAtoms));
+		_currentResidueAtoms.clear();
+		_currentResidue = "";
+	}
+	if (atoms.empty()) {
+		return true;
+	}
+
+	_modelsDelivered++;
+	bool keepReading = _callback(atoms, _modelsDelivered, _data);
+	for (AtomPointerVector::iterator k=atoms.begin(); k!=atoms.end(); k++) {
+		delete *k;
+	}
+	atoms.clear();
+	return keepReading;
+}
 
 
 void PDBReader::addAtoms(map<string, vector<PDBFormat::AtomData> > &_currentResidueAtoms, string _altLoc){
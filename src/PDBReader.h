@@ -84,6 +84,14 @@ class PDBReader : public Reader {
 		bool read(bool _noHydrogens=false);
 		bool read(std::string &_inputString);
 
+		/*
+		  Streaming read, one model at a time: the callback receives the atoms
+		  of each model (numbered from 1), which are deleted when it returns.
+		  Return false from the callback to stop reading.
+		 */
+		typedef bool (*ModelCallback)(AtomPointerVector & _atoms, unsigned int _model, void * _data);
+		bool readModels(ModelCallback _callback, void * _data=NULL, bool _noHydrogens=false);
+
 		AtomPointerVector & getAtomPointers(); 
 		unsigned int size() const;
 		Atom * operator[](unsigned int _n);
@@ -125,6 +133,10 @@ class PDBReader : public Reader {
 	private:
 		void deletePointers();
 		void parsePDBLine(std::string _pdbline);
+		bool parseContent(bool _noHydrogens, ModelCallback _callback, void * _data);
+		void parseRecordLine(const std::string & _line, bool & _foundMissingStart);
+		Atom * createAtom(const PDBFormat::AtomData & _atom);
+		bool deliverModel(ModelCallback _callback, void * _data, unsigned int & _modelsDelivered, std::string & _currentResidue, std::map<std::string, std::vector<PDBFormat::AtomData> > & _currentResidueAtoms);
 		std::string discoverProperResidueAltLoc(std::map<std::string, std::vector<PDBFormat::AtomData> > &_currentResidueAtoms);
 		void addAtoms(std::map<std::string, std::vector<PDBFormat::AtomData> > &_currentResidueAtoms, std::string _altLoc);
 
@@ -693,14 +693,14 @@ bool PDBTopologyBuilder::buildSystem(const PolymerSequence & _sequence) {
 											if(improperFlag) {
 												if(*atmK) {
 													vector<double> param;
-													if (pParReader->bondParam(param, (*atmK)->getType(),(*atmM)->getType())) {
+													if (pParReader->bondParam(param, (*atmK)->getTypeId(),(*atmM)->getTypeId())) {
 														icValues[0] = param[1];
 													}
 												}
 											} else {
 												if(*atmK) {
 													vector<double> param;
-													if (pParReader->bondParam(param, (*atmK)->getType(),(*atmL)->getType())) {
+													if (pParReader->bondParam(param, (*atmK)->getTypeId(),(*atmL)->getTypeId())) {
 														icValues[0] = param[1];
 													}
 												}
@@ -711,14 +711,14 @@ bool PDBTopologyBuilder::buildSystem(const PolymerSequence & _sequence) {
 											if(improperFlag) {
 												if(*atmK) {
 													vector<double> param;
-													if (pParReader->angleParam(param, (*atmK)->getType(),(*atmM)->getType(),(*atmL)->getType())) {
+													if (pParReader->angleParam(param, (*atmK)->getTypeId(),(*atmM)->getTypeId(),(*atmL)->getTypeId())) {
 														icValues[1] = param[1];
 													}
 												}
 											} else {
 												if(*atmK) {
 													vector<double> param;
-													if (pParReader->angleParam(param, (*atmK)->getType(),(*atmL)->getType(),(*atmM)->getType())) {
+													if (pParReader->angleParam(param, (*atmK)->getTypeId(),(*atmL)->getTypeId(),(*atmM)->getTypeId())) {
 														icValues[1] = param[1];
 													}
 												}
@@ -728,7 +728,7 @@ bool PDBTopologyBuilder::buildSystem(const PolymerSequence & _sequence) {
 										if (icValues[3] == 0.0) {
 											if(*atmN) {
 												vector<double> param;
-												if (pParReader->angleParam(param, (*atmL)->getType(),(*atmM)->getType(),(*atmN)->getType())) {
+												if (pParReader->angleParam(param, (*atmL)->getTypeId(),(*atmM)->getTypeId(),(*atmN)->getTypeId())) {
 													icValues[3] = param[1];
 												}
 											}
@@ -737,7 +737,7 @@ bool PDBTopologyBuilder::buildSystem(const PolymerSequence & _sequence) {
 										if (icValues[4] == 0.0) {
 											if(*atmN) {
 												vector<double> param;
-												if (pParReader->bondParam(param, (*atmM)->getType(),(*atmN)->getType())) {
+												if (pParReader->bondParam(param, (*atmM)->getTypeId(),(*atmN)->getTypeId())) {
 													icValues[4] = param[1];
 												}
 											}
@@ -0,0 +1,413 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "PackedNonBondedEnergy.h"
+#include "AtomGroup.h"
+
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace MSL;
+using namespace std;
+
+const string PackedNonBondedEnergy::vdwTerm = "CHARMM_VDW";
+const string PackedNonBondedEnergy::elecTerm = "CHARMM_ELEC";
+
+/*************************************************************
+ *  Scalar and vector versions of the pair energies.  The order
+ *  of the operations replicates the one in CharmmEnergy so that
+ *  the results are the same bit by bit
+ *************************************************************/
+namespace {
+	inline double packedSwitch(double _energy, double _groupDistance, double _rOn, double _rOff) {
+		if (_groupDistance > _rOff) {
+			return 0.0;
+		} else if (_groupDistance > _rOn) {
+			double t1 = _groupDistance - _rOff;
+			double t3 = (_rOff-_rOn) * (_rOff-_rOn) * (_rOff-_rOn);
+			return _energy * (t1 * t1 * (_rOff + (2.0 * _groupDistance) - (3.0 * _rOn)) / t3);
+		}
+		return _energy;
+	}
+	inline double packedLJ(double _d, double _rmin, double _Emin) {
+		double frac = _rmin / _d;
+		double pow6 = frac * frac * frac;
+		pow6 *= pow6;
+		double pow12 = pow6 * pow6;
+		return _Emin * (pow12 - 2.0 * pow6);
+	}
+	inline double packedCoulomb(double _d, double _factor, double _Rdep) {
+		double energy = _factor / _d;
+		if (_Rdep != 0.0) {
+			energy = energy / _d;
+		}
+		return energy;
+	}
+#ifdef __SSE2__
+	inline __m128d packedSwitch(__m128d _energy, __m128d _groupDistance, __m128d _rOn, __m128d _rOff) {
+		__m128d t1 = _mm_sub_pd(_groupDistance, _rOff);
+		__m128d width = _mm_sub_pd(_rOff, _rOn);
+		__m128d t3 = _mm_mul_pd(_mm_mul_pd(width, width), width);
+		__m128d t2 = _mm_sub_pd(_mm_add_pd(_rOff, _mm_mul_pd(_mm_set1_pd(2.0), _groupDistance)), _mm_mul_pd(_mm_set1_pd(3.0), _rOn));
+		__m128d switched = _mm_mul_pd(_energy, _mm_div_pd(_mm_mul_pd(_mm_mul_pd(t1, t1), t2), t3));
+		__m128d beyondOff = _mm_cmpgt_pd(_groupDistance, _rOff);
+		__m128d beyondOn = _mm_cmpgt_pd(_groupDistance, _rOn);
+		__m128d out = _mm_or_pd(_mm_and_pd(beyondOn, switched), _mm_andnot_pd(beyondOn, _energy));
+		return _mm_andnot_pd(beyondOff, out);
+	}
+	inline __m128d packedDistance(const double * _x, const double * _y, const double * _z, unsigned int _a0, unsigned int _b0, unsigned int _a1, unsigned int _b1) {
+		__m128d dx = _mm_sub_pd(_mm_set_pd(_x[_a1], _x[_a0]), _mm_set_pd(_x[_b1], _x[_b0]));
+		__m128d dy = _mm_sub_pd(_mm_set_pd(_y[_a1], _y[_a0]), _mm_set_pd(_y[_b1], _y[_b0]));
+		__m128d dz = _mm_sub_pd(_mm_set_pd(_z[_a1], _z[_a0]), _mm_set_pd(_z[_b1], _z[_b0]));
+		return _mm_sqrt_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz)));
+	}
+#endif
+	inline double packedDistance(const double * _x, const double * _y, const double * _z, unsigned int _a, unsigned int _b) {
+		double dx = _x[_a] - _x[_b];
+		double dy = _y[_a] - _y[_b];
+		double dz = _z[_a] - _z[_b];
+		return sqrt((dx*dx)+(dy*dy)+(dz*dz));
+	}
+}
+
+PackedNonBondedEnergy::PackedNonBondedEnergy() {
+	clear();
+}
+
+PackedNonBondedEnergy::~PackedNonBondedEnergy() {
+}
+
+void PackedNonBondedEnergy::clear() {
+	atoms.clear();
+	atomGroup.clear();
+	groups.clear();
+	groupOwner.clear();
+	x.clear();
+	y.clear();
+	z.clear();
+	gx.clear();
+	gy.clear();
+	gz.clear();
+	atomMask.clear();
+	gathered = false;
+
+	PairList * lists[2] = {&vdwPairs, &elecPairs};
+	for (unsigned int i=0; i<2; i++) {
+		lists[i]->atom1.clear();
+		lists[i]->atom2.clear();
+		lists[i]->param1.clear();
+		lists[i]->param2.clear();
+		lists[i]->cutOn.clear();
+		lists[i]->cutOff.clear();
+		lists[i]->energies.clear();
+		lists[i]->useCutoffs = false;
+		lists[i]->sourceSize = 0;
+		lists[i]->packed = false;
+	}
+}
+
+unsigned int PackedNonBondedEnergy::getAtomIndex(Atom * _pAtom, map<Atom*, unsigned int> & _atomIndex, map<AtomGroup*, unsigned int> & _groupIndex) {
+	map<Atom*, unsigned int>::iterator found = _atomIndex.find(_pAtom);
+	if (found != _atomIndex.end()) {
+		return found->second;
+	}
+	unsigned int index = atoms.size();
+	_atomIndex[_pAtom] = index;
+	atoms.push_back(_pAtom);
+
+	// atoms without a group use their own coordinates as the group center
+	AtomGroup * pGroup = _pAtom->getParentGroup();
+	if (pGroup == NULL) {
+		atomGroup.push_back(groups.size());
+		groups.push_back(NULL);
+		groupOwner.push_back(index);
+	} else {
+		map<AtomGroup*, unsigned int>::iterator foundGroup = _groupIndex.find(pGroup);
+		if (foundGroup != _groupIndex.end()) {
+			atomGroup.push_back(foundGroup->second);
+		} else {
+			_groupIndex[pGroup] = groups.size();
+			atomGroup.push_back(groups.size());
+			groups.push_back(pGroup);
+			groupOwner.push_back(index);
+		}
+	}
+	return index;
+}
+
+void PackedNonBondedEnergy::build(map<string, vector<Interaction*> > & _energyTerms) {
+	clear();
+
+	map<Atom*, unsigned int> atomIndex;
+	map<AtomGroup*, unsigned int> groupIndex;
+
+	map<string, vector<Interaction*> >::iterator found = _energyTerms.find(vdwTerm);
+	if (found != _energyTerms.end()) {
+		vector<Interaction*> & inters = found->second;
+		vdwPairs.sourceSize = inters.size();
+		vdwPairs.packed = true;
+		for (unsigned int i=0; i<inters.size(); i++) {
+			CharmmVdwInteraction * pInter = dynamic_cast<CharmmVdwInteraction*>(inters[i]);
+			if (pInter == NULL || pInter->getAtom(0) == NULL || pInter->getAtom(1) == NULL) {
+				// not a regular CHARMM vdw interaction, leave the term to the EnergySet
+				vdwPairs.packed = false;
+				break;
+			}
+			vdwPairs.atom1.push_back(getAtomIndex(pInter->getAtom(0), atomIndex, groupIndex));
+			vdwPairs.atom2.push_back(getAtomIndex(pInter->getAtom(1), atomIndex, groupIndex));
+			vdwPairs.param1.push_back(pInter->getRmin());
+			vdwPairs.param2.push_back(pInter->getEmin());
+			if (pInter->getUseNonBondCutoffs()) {
+				vdwPairs.useCutoffs = true;
+				vdwPairs.cutOn.push_back(pInter->getNonBondCutoffOn());
+				vdwPairs.cutOff.push_back(pInter->getNonBondCutoffOff());
+			} else {
+				vdwPairs.cutOn.push_back(HUGE_VAL);
+				vdwPairs.cutOff.push_back(HUGE_VAL);
+			}
+		}
+		if (!vdwPairs.packed) {
+			vdwPairs.atom1.clear();
+			vdwPairs.atom2.clear();
+			vdwPairs.param1.clear();
+			vdwPairs.param2.clear();
+			vdwPairs.cutOn.clear();
+			vdwPairs.cutOff.clear();
+			vdwPairs.useCutoffs = false;
+		}
+		vdwPairs.energies = vector<double>(vdwPairs.atom1.size(), 0.0);
+	}
+
+	found = _energyTerms.find(elecTerm);
+	if (found != _energyTerms.end()) {
+		vector<Interaction*> & inters = found->second;
+		elecPairs.sourceSize = inters.size();
+		elecPairs.packed = true;
+		for (unsigned int i=0; i<inters.size(); i++) {
+			CharmmElectrostaticInteraction * pInter = dynamic_cast<CharmmElectrostaticInteraction*>(inters[i]);
+			if (pInter == NULL || pInter->getAtom(0) == NULL || pInter->getAtom(1) == NULL) {
+				elecPairs.packed = false;
+				break;
+			}
+			elecPairs.atom1.push_back(getAtomIndex(pInter->getAtom(0), atomIndex, groupIndex));
+			elecPairs.atom2.push_back(getAtomIndex(pInter->getAtom(1), atomIndex, groupIndex));
+			elecPairs.param1.push_back(pInter->getPrecomputedFactor());
+			elecPairs.param2.push_back(pInter->getUseRdielectric() ? 1.0 : 0.0);
+			if (pInter->getUseNonBondCutoffs()) {
+				elecPairs.useCutoffs = true;
+				elecPairs.cutOn.push_back(pInter->getNonBondCutoffOn());
+				elecPairs.cutOff.push_back(pInter->getNonBondCutoffOff());
+			} else {
+				elecPairs.cutOn.push_back(HUGE_VAL);
+				elecPairs.cutOff.push_back(HUGE_VAL);
+			}
+		}
+		if (!elecPairs.packed) {
+			elecPairs.atom1.clear();
+			elecPairs.atom2.clear();
+			elecPairs.param1.clear();
+			elecPairs.param2.clear();
+			elecPairs.cutOn.clear();
+			elecPairs.cutOff.clear();
+			elecPairs.useCutoffs = false;
+		}
+		elecPairs.energies = vector<double>(elecPairs.atom1.size(), 0.0);
+	}
+
+	x = vector<double>(atoms.size(), 0.0);
+	y = vector<double>(atoms.size(), 0.0);
+	z = vector<double>(atoms.size(), 0.0);
+	atomMask = vector<unsigned char>(atoms.size(), 1);
+	gx = vector<double>(groups.size(), 0.0);
+	gy = vector<double>(groups.size(), 0.0);
+	gz = vector<double>(groups.size(), 0.0);
+}
+
+bool PackedNonBondedEnergy::isCurrent(map<string, vector<Interaction*> > & _energyTerms) const {
+	map<string, vector<Interaction*> >::const_iterator found = _energyTerms.find(vdwTerm);
+	unsigned int size = 0;
+	if (found != _energyTerms.end()) {
+		size = found->second.size();
+	}
+	if (size != vdwPairs.sourceSize) {
+		return false;
+	}
+	found = _energyTerms.find(elecTerm);
+	size = 0;
+	if (found != _energyTerms.end()) {
+		size = found->second.size();
+	}
+	if (size != elecPairs.sourceSize) {
+		return false;
+	}
+	return true;
+}
+
+void PackedNonBondedEnergy::gatherCoordinates(bool _activeOnly, bool _checkForCoordinates) {
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		CartesianPoint & coor = atoms[i]->getCoor();
+		x[i] = coor.getX();
+		y[i] = coor.getY();
+		z[i] = coor.getZ();
+		atomMask[i] = (!_activeOnly || atoms[i]->getActive()) && (!_checkForCoordinates || atoms[i]->hasCoor());
+	}
+	if (vdwPairs.useCutoffs || elecPairs.useCutoffs) {
+		// the switching function uses the distance between the geometric centers of the groups
+		for (unsigned int i=0; i<groups.size(); i++) {
+			if (groups[i] == NULL) {
+				unsigned int owner = groupOwner[i];
+				gx[i] = x[owner];
+				gy[i] = y[owner];
+				gz[i] = z[owner];
+			} else {
+				CartesianPoint & center = groups[i]->getGeometricCenter();
+				gx[i] = center.getX();
+				gy[i] = center.getY();
+				gz[i] = center.getZ();
+			}
+		}
+	}
+	gathered = true;
+}
+
+double PackedNonBondedEnergy::calcTermEnergy(const string & _term, unsigned int & _counter) {
+	_counter = 0;
+	if (!gathered) {
+		cerr << "ERROR 35003: coordinates not gathered in double PackedNonBondedEnergy::calcTermEnergy(const string & _term, unsigned int & _counter)" << endl;
+		exit(35003);
+	}
+	if (_term == vdwTerm && vdwPairs.packed) {
+		calcVdw(vdwPairs);
+		return sumPairs(vdwPairs, _counter);
+	} else if (_term == elecTerm && elecPairs.packed) {
+		calcElec(elecPairs);
+		return sumPairs(elecPairs, _counter);
+	}
+	cerr << "WARNING 35008: term " << _term << " was not packed in double PackedNonBondedEnergy::calcTermEnergy(const string & _term, unsigned int & _counter)" << endl;
+	return 0.0;
+}
+
+double PackedNonBondedEnergy::sumPairs(const PairList & _list, unsigned int & _counter) const {
+	// sum serially in the original order of the interactions
+	double total = 0.0;
+	for (unsigned int k=0; k<_list.energies.size(); k++) {
+		if (atomMask[_list.atom1[k]] && atomMask[_list.atom2[k]]) {
+			total += _list.energies[k];
+			_counter++;
+		}
+	}
+	return total;
+}
+
+void PackedNonBondedEnergy::calcVdw(PairList & _list) {
+	unsigned int n = _list.atom1.size();
+	if (n == 0) {
+		return;
+	}
+	const unsigned int * a = &_list.atom1[0];
+	const unsigned int * b = &_list.atom2[0];
+	const double * rmin = &_list.param1[0];
+	const double * Emin = &_list.param2[0];
+	const double * on = &_list.cutOn[0];
+	const double * off = &_list.cutOff[0];
+	const double * px = &x[0];
+	const double * py = &y[0];
+	const double * pz = &z[0];
+	double * e = &_list.energies[0];
+
+	unsigned int k = 0;
+#ifdef __SSE2__
+	const __m128d two = _mm_set1_pd(2.0);
+	for (; k+1<n; k+=2) {
+		__m128d d = packedDistance(px, py, pz, a[k], b[k], a[k+1], b[k+1]);
+		__m128d frac = _mm_div_pd(_mm_loadu_pd(rmin+k), d);
+		__m128d pow6 = _mm_mul_pd(_mm_mul_pd(frac, frac), frac);
+		pow6 = _mm_mul_pd(pow6, pow6);
+		__m128d pow12 = _mm_mul_pd(pow6, pow6);
+		__m128d energy = _mm_mul_pd(_mm_loadu_pd(Emin+k), _mm_sub_pd(pow12, _mm_mul_pd(two, pow6)));
+		if (_list.useCutoffs) {
+			const unsigned int * g = &atomGroup[0];
+			__m128d gd = packedDistance(&gx[0], &gy[0], &gz[0], g[a[k]], g[b[k]], g[a[k+1]], g[b[k+1]]);
+			energy = packedSwitch(energy, gd, _mm_loadu_pd(on+k), _mm_loadu_pd(off+k));
+		}
+		_mm_storeu_pd(e+k, energy);
+	}
+#endif
+	for (; k<n; k++) {
+		e[k] = packedLJ(packedDistance(px, py, pz, a[k], b[k]), rmin[k], Emin[k]);
+		if (_list.useCutoffs) {
+			double gd = packedDistance(&gx[0], &gy[0], &gz[0], atomGroup[a[k]], atomGroup[b[k]]);
+			e[k] = packedSwitch(e[k], gd, on[k], off[k]);
+		}
+	}
+}
+
+void PackedNonBondedEnergy::calcElec(PairList & _list) {
+	unsigned int n = _list.atom1.size();
+	if (n == 0) {
+		return;
+	}
+	const unsigned int * a = &_list.atom1[0];
+	const unsigned int * b = &_list.atom2[0];
+	const double * factor = &_list.param1[0];
+	const double * Rdep = &_list.param2[0];
+	const double * on = &_list.cutOn[0];
+	const double * off = &_list.cutOff[0];
+	const double * px = &x[0];
+	const double * py = &y[0];
+	const double * pz = &z[0];
+	double * e = &_list.energies[0];
+
+	unsigned int k = 0;
+#ifdef __SSE2__
+	const __m128d zero = _mm_setzero_pd();
+	for (; k+1<n; k+=2) {
+		__m128d d = packedDistance(px, py, pz, a[k], b[k], a[k+1], b[k+1]);
+		__m128d energy = _mm_div_pd(_mm_loadu_pd(factor+k), d);
+		// r-dependent dielectric: divide once more by the distance
+		__m128d useRdep = _mm_cmpneq_pd(_mm_loadu_pd(Rdep+k), zero);
+		energy = _mm_or_pd(_mm_and_pd(useRdep, _mm_div_pd(energy, d)), _mm_andnot_pd(useRdep, energy));
+		if (_list.useCutoffs) {
+			const unsigned int * g = &atomGroup[0];
+			__m128d gd = packedDistance(&gx[0], &gy[0], &gz[0], g[a[k]], g[b[k]], g[a[k+1]], g[b[k+1]]);
+			energy = packedSwitch(energy, gd, _mm_loadu_pd(on+k), _mm_loadu_pd(off+k));
+		}
+		_mm_storeu_pd(e+k, energy);
+	}
+#endif
+	for (; k<n; k++) {
+		e[k] = packedCoulomb(packedDistance(px, py, pz, a[k], b[k]), factor[k], Rdep[k]);
+		if (_list.useCutoffs) {
+			double gd = packedDistance(&gx[0], &gy[0], &gz[0], atomGroup[a[k]], atomGroup[b[k]]);
+			e[k] = packedSwitch(e[k], gd, on[k], off[k]);
+		}
+	}
+}
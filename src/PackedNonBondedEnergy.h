@@ -0,0 +1,161 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef PACKEDNONBONDEDENERGY_H
+#define PACKEDNONBONDEDENERGY_H
+
+#include <vector>
+#include <string>
+#include <map>
+
+#include "Interaction.h"
+#include "CharmmVdwInteraction.h"
+#include "CharmmElectrostaticInteraction.h"
+
+/*************************************************************
+ *  Packed evaluation of the CHARMM non bonded terms (CHARMM_VDW
+ *  and CHARMM_ELEC) for the EnergySet.
+ *
+ *  The interactions are converted once into atom index pair
+ *  lists with flat parameter arrays (rmin/Emin for the vdw,
+ *  the precomputed Kq*q1*q2*rescal/diel factor for the elec).
+ *  At every calculation the current coordinates and the group
+ *  centers (for the switching function) are gathered into
+ *  contiguous buffers and the energies are computed with a
+ *  SSE2 kernel (scalar fallback if SSE2 is not available).
+ *
+ *  The per-pair arithmetic is identical to CharmmEnergy::LJ,
+ *  LJSwitched, coulombEnerPrecomputed and
+ *  coulombEnerPrecomputedSwitched and the pair energies are
+ *  summed in the order of the interactions in the EnergySet,
+ *  so the term totals are the same as the ones obtained by
+ *  calling getEnergy() on the individual interactions.
+ *
+ *  Only the calculation of the whole energy (no selections)
+ *  is handled here, the EnergySet falls back to the regular
+ *  path for everything else
+ *************************************************************/
+
+/* ERROR CODE 35xxx */
+
+namespace MSL { 
+class PackedNonBondedEnergy {
+	public:
+		PackedNonBondedEnergy();
+		~PackedNonBondedEnergy();
+
+		// (re)build the pair lists from the terms of an EnergySet
+		void build(std::map<std::string, std::vector<Interaction*> > & _energyTerms);
+		void clear();
+
+		// false if the interactions have changed after the last build
+		bool isCurrent(std::map<std::string, std::vector<Interaction*> > & _energyTerms) const;
+
+		// true for CHARMM_VDW and CHARMM_ELEC if they were packed
+		bool hasTerm(const std::string & _term) const;
+
+		/*************************************************************
+		 *  Copy the current coordinates and group centers into the
+		 *  buffers, it needs to be called once before calculating the
+		 *  terms.  Pairs with inactive atoms (if _activeOnly) or 
+		 *  without coordinates (if _checkForCoordinates) are skipped
+		 *************************************************************/
+		void gatherCoordinates(bool _activeOnly, bool _checkForCoordinates);
+
+		// returns the unweighted energy of the term and the number of interactions calculated
+		double calcTermEnergy(const std::string & _term, unsigned int & _counter);
+
+		unsigned int getNumberOfAtoms() const;
+		unsigned int getNumberOfPairs(const std::string & _term) const;
+
+	private:
+		struct PairList {
+			std::vector<unsigned int> atom1;
+			std::vector<unsigned int> atom2;
+			// vdw: rmin, Emin;  elec: Kq*q1*q2*rescal/diel, 1.0 if r-dependent dielectric (0.0 otherwise)
+			std::vector<double> param1;
+			std::vector<double> param2;
+			// cutoffs for the switching function (useCutoffs is true if at least one interaction uses them)
+			std::vector<double> cutOn;
+			std::vector<double> cutOff;
+			bool useCutoffs;
+			// the pair energies of the last calculation
+			std::vector<double> energies;
+			unsigned int sourceSize;
+			bool packed;
+		};
+
+		unsigned int getAtomIndex(Atom * _pAtom, std::map<Atom*, unsigned int> & _atomIndex, std::map<AtomGroup*, unsigned int> & _groupIndex);
+		void calcVdw(PairList & _list);
+		void calcElec(PairList & _list);
+		double sumPairs(const PairList & _list, unsigned int & _counter) const;
+
+		std::vector<Atom*> atoms;
+		std::vector<unsigned int> atomGroup;
+		std::vector<AtomGroup*> groups;
+		std::vector<unsigned int> groupOwner; // first atom of each group (used when there is no AtomGroup)
+
+		// gathered coordinates
+		std::vector<double> x;
+		std::vector<double> y;
+		std::vector<double> z;
+		std::vector<double> gx;
+		std::vector<double> gy;
+		std::vector<double> gz;
+		std::vector<unsigned char> atomMask;
+		bool gathered;
+
+		PairList vdwPairs;
+		PairList elecPairs;
+
+		static const std::string vdwTerm;
+		static const std::string elecTerm;
+};
+
+inline unsigned int PackedNonBondedEnergy::getNumberOfAtoms() const {return atoms.size();}
+inline bool PackedNonBondedEnergy::hasTerm(const std::string & _term) const {
+	if (_term == vdwTerm) {
+		return vdwPairs.packed;
+	} else if (_term == elecTerm) {
+		return elecPairs.packed;
+	}
+	return false;
+}
+inline unsigned int PackedNonBondedEnergy::getNumberOfPairs(const std::string & _term) const {
+	if (_term == vdwTerm) {
+		return vdwPairs.atom1.size();
+	} else if (_term == elecTerm) {
+		return elecPairs.atom1.size();
+	}
+	return 0;
+}
+
+}
+
+#endif
@@ -40,6 +40,10 @@ bool PhiPsiReader::read() {
 		return false;
 	}
 
+	// the tables saved with PhiPsiStatistics::writeBinaryFile are loaded directly
+	if (fileName != "" && PhiPsiStatistics::isBinaryFile(fileName)) {
+		return phiPsiStat.readBinaryFile(fileName);
+	}
 	
 	try { 
 		string residue = "";
@@ -47,7 +47,9 @@ You should have received a copy of the GNU Lesser General Public
 
 /**
  * This class will provide an object which is able
- * to read in and interpret PhiPsi files.
+ * to read in and interpret PhiPsi files, in the text
+ * format or in the binary format written by
+ * PhiPsiStatistics::writeBinaryFile.
  */
 namespace MSL { 
 class PhiPsiReader : public Reader {
@@ -36,6 +36,9 @@ using namespace std;
 
 PhiPsiStatistics::PhiPsiStatistics(){
     gridSize = 0.0f;
+    tableCurrent = true;
+    gridsCurrent = false;
+    gridsUsable = false;
 }
 PhiPsiStatistics::PhiPsiStatistics(const PhiPsiStatistics &_phiPsiStat){
 	copy(_phiPsiStat);
@@ -48,11 +51,20 @@ void PhiPsiStatistics::operator=(const PhiPsiStatistics &_phiPsiStat){
 }
 void PhiPsiStatistics::copy(const PhiPsiStatistics &_phiPsiStat){
 
-    phiPsiTable = _phiPsiStat.getPhiPsiCounts();
+    phiPsiTable = _phiPsiStat.phiPsiTable;
+    tableCurrent = _phiPsiStat.tableCurrent;
     gridSize = _phiPsiStat.gridSize;
+    grids = _phiPsiStat.grids;
+    gridNames = _phiPsiStat.gridNames;
+    gridIndex = _phiPsiStat.gridIndex;
+    gridsCurrent = _phiPsiStat.gridsCurrent;
+    gridsUsable = _phiPsiStat.gridsUsable;
 }
 
 void PhiPsiStatistics::addStatisitics(string _residueType, string _phiBin, string _psiBin, int _count){
+	updateTable();
+	gridsCurrent = false;
+
 	stringstream ss;
 	ss << _residueType<<":"<<_phiBin<<":"<<_psiBin;
 
@@ -77,6 +89,7 @@ void PhiPsiStatistics::addStatisitics(string _residueType, string _phiBin, strin
 
 
 int PhiPsiStatistics::operator()(string _key){
+	updateTable();
 
 	map<string,int>::iterator it;
 	it = phiPsiTable.find(_key);
@@ -88,18 +101,66 @@ int PhiPsiStatistics::operator()(string _key){
 }
 
 int PhiPsiStatistics::getCounts(string resName, double phi, double psi){
-    stringstream ss;
-	ss << resName <<":"<<getPhiPsiBin(phi)<<":"<<getPhiPsiBin(psi);
-
-	//cout << "Key: "<<ss.str()<<"."<<endl;
-	map<string, int>::iterator it;
-	it = phiPsiTable.find(ss.str());
-	if (it == phiPsiTable.end()){
+	int counts = 0;
+	if (!findCounts(resName, phi, psi, counts)){
+		stringstream ss;
+		ss << resName <<":"<<getPhiPsiBin(phi)<<":"<<getPhiPsiBin(psi);
 		cout << "No Phi/Psi entry found for " << ss.str() << "." <<endl;
 		return MslTools::intMax;
 	}
 	
-	return it->second;
+	return counts;
+}
+
+bool PhiPsiStatistics::findCounts(const string &_resName, double _phi, double _psi, int &_counts){
+	if (!gridsCurrent){
+		updateGrids();
+	}
+	if (gridsUsable){
+		map<string,int>::iterator it = gridIndex.find(_resName);
+		if (it == gridIndex.end()){
+			return false;
+		}
+		const DihedralGrid &grid = grids[it->second];
+		unsigned int phiBin = 0;
+		unsigned int psiBin = 0;
+		if (!grid.getBinFromCenter(getPhiPsiBin(_phi), phiBin) || !grid.getBinFromCenter(getPhiPsiBin(_psi), psiBin)){
+			return false;
+		}
+		_counts = grid.getCounts(grid.getIndex(phiBin, psiBin));
+		return true;
+	}
+
+	stringstream ss;
+	ss << _resName <<":"<<getPhiPsiBin(_phi)<<":"<<getPhiPsiBin(_psi);
+	map<string, int>::iterator it = phiPsiTable.find(ss.str());
+	if (it == phiPsiTable.end()){
+		return false;
+	}
+	_counts = it->second;
+	return true;
+}
+
+bool PhiPsiStatistics::findTotal(const string &_resName, int &_total){
+	// the totals are the keys without bins of the table (the subtotals read
+	// from the file, and ALL only after computeTotalCounts)
+	map<string,int>::iterator it;
+	if (!tableCurrent){
+		// loaded from a binary file, the table would be rebuilt with the totals of the grids
+		it = gridIndex.find(_resName);
+		if (it == gridIndex.end()){
+			return false;
+		}
+		_total = grids[it->second].getTotal();
+		return true;
+	}
+
+	it = phiPsiTable.find(_resName);
+	if (it == phiPsiTable.end()){
+		return false;
+	}
+	_total = it->second;
+	return true;
 }
 
 int PhiPsiStatistics::getCounts(const Residue &nMinus1, const Residue &n, const Residue &nPlus1){
@@ -119,15 +180,10 @@ double PhiPsiStatistics::getFreqInBin(string resName, double phi, double psi){
 	}
 	double AAxyzDouble = (double)AAxyz;
 
-	stringstream allkey;
-	allkey << "ALL" << ":" << getPhiPsiBin(phi) << ":" << getPhiPsiBin(psi);
-
-	map<string,int>::iterator it;
-	it = phiPsiTable.find(allkey.str());
-	if (it == phiPsiTable.end()){
+	int AAallyz = 0;
+	if (!findCounts("ALL", phi, psi, AAallyz)){
 		return MslTools::doubleMax;
 	}
-	int AAallyz = it->second;
 	double AAallyzDouble = (double)AAallyz;
 
 
@@ -144,12 +200,10 @@ double PhiPsiStatistics::getProbability(string &resName, double phi, double psi)
 	}
 
 	// Total number of counts for residue type "resName"
-	map<string,int>::iterator it;
-	it = phiPsiTable.find(resName);
-	if (it == phiPsiTable.end()) {
+	int AAx   = 0;
+	if (!findTotal(resName, AAx)) {
 		return MslTools::doubleMax;
 	}
-	int AAx   = it->second;
 	
 	double AAxyzDouble = (double)AAxyz;
 	double AAxDouble   = (double)AAx;
@@ -178,22 +232,14 @@ double PhiPsiStatistics::getProbabilityAll(double phi, double psi){
 	int AAallyz = 0;
 	int AAall   = 0;
 
-	stringstream allkey;
-	allkey << "ALL" << ":" << getPhiPsiBin(phi) << ":" << getPhiPsiBin(psi);
-
-	map<string,int>::iterator it;
-	it = phiPsiTable.find(allkey.str());
-	if (it == phiPsiTable.end()){
+	if (!findCounts("ALL", phi, psi, AAallyz)){
 		return MslTools::doubleMax;
 	}
-	AAallyz = it->second;
 	double AAallyzDouble = (double)AAallyz;
 
-	it = phiPsiTable.find("ALL");
-	if (it == phiPsiTable.end()){
+	if (!findTotal("ALL", AAall)){
 		return MslTools::doubleMax;
 	}
-	AAall = it->second;
 
 	double AAallDouble   = (double)AAall;
 
@@ -254,6 +300,9 @@ double PhiPsiStatistics::getPropensity(const Residue &nMinus1, const Residue &n,
 
 
 void PhiPsiStatistics::computeTotalCounts(){
+	updateTable();
+	gridsCurrent = false;
+
 	map<string,int>::iterator phiPsiIt;
 	map<string,int> runningTotalByRes;
 	int runningTotal = 0;
@@ -345,6 +394,7 @@ pair<double,double> PhiPsiStatistics::getRandomPhiPsi(std::string _resType){
 
     // If we do not have a random number generator, then build one for this residue type
     if (itRand == phiPsiRandom.end()){
+	    updateTable();
 	    std::map<std::string,int>::iterator itPhiPsi = phiPsiTable.find(_resType);
 
 	    // If we have no data on this residue type then error.
@@ -406,3 +456,160 @@ pair<double,double> PhiPsiStatistics::getRandomPhiPsi(std::string _resType){
 
 
 
+
+map<string,int> PhiPsiStatistics::getPhiPsiCounts() const {
+	updateTable();
+	return phiPsiTable;
+}
+
+void PhiPsiStatistics::updateGrids(){
+	grids.clear();
+	gridNames.clear();
+	gridIndex.clear();
+	gridsCurrent = true;
+	gridsUsable = false;
+
+	// the bins must tile [-180, 180)
+	if (gridSize <= 0.0 || fabs(floor(360.0 / gridSize + 0.5) * gridSize - 360.0) > 1.0e-6){
+		return;
+	}
+
+	vector<unsigned int> filled;
+	for (map<string,int>::iterator it = phiPsiTable.begin(); it != phiPsiTable.end(); it++){
+		vector<string> toks = MslTools::tokenize(it->first, ":");
+		if (toks.size() != 3) continue;
+
+		map<string,int>::iterator found = gridIndex.find(toks[0]);
+		int resType = 0;
+		if (found == gridIndex.end()){
+			resType = grids.size();
+			gridIndex[toks[0]] = resType;
+			gridNames.push_back(toks[0]);
+			grids.push_back(DihedralGrid(2, gridSize));
+			filled.push_back(0);
+		} else {
+			resType = found->second;
+		}
+
+		DihedralGrid &grid = grids[resType];
+		unsigned int phiBin = 0;
+		unsigned int psiBin = 0;
+		if (it->second < 0 || !grid.getBinFromCenter(MslTools::toDouble(toks[1]), phiBin) || !grid.getBinFromCenter(MslTools::toDouble(toks[2]), psiBin)){
+			grids.clear();
+			gridNames.clear();
+			gridIndex.clear();
+			return;
+		}
+		grid.addCounts(grid.getIndex(phiBin, psiBin), it->second);
+		filled[resType]++;
+	}
+
+	// every bin must have an entry, or the missing ones would not be reported as missing
+	for (unsigned int i=0; i < grids.size(); i++){
+		if (filled[i] != grids[i].size()){
+			grids.clear();
+			gridNames.clear();
+			gridIndex.clear();
+			return;
+		}
+		grids[i].normalize();
+	}
+	gridsUsable = true;
+}
+
+void PhiPsiStatistics::updateTable() const {
+	if (tableCurrent) return;
+
+	phiPsiTable.clear();
+	for (unsigned int i=0; i < grids.size(); i++){
+		const DihedralGrid &grid = grids[i];
+		for (unsigned int phiBin = 0; phiBin < grid.getNumberOfBins(); phiBin++){
+			for (unsigned int psiBin = 0; psiBin < grid.getNumberOfBins(); psiBin++){
+				stringstream ss;
+				ss << gridNames[i]<<":"<<grid.getBinCenter(phiBin)<<":"<<grid.getBinCenter(psiBin);
+				phiPsiTable[ss.str()] = grid.getCounts(grid.getIndex(phiBin, psiBin));
+			}
+		}
+		phiPsiTable[gridNames[i]] = grid.getTotal();
+	}
+	tableCurrent = true;
+}
+
+int PhiPsiStatistics::getResidueTypeIndex(string _resName){
+	if (!gridsCurrent){
+		updateGrids();
+	}
+	map<string,int>::iterator it = gridIndex.find(_resName);
+	if (it == gridIndex.end()){
+		return -1;
+	}
+	return it->second;
+}
+
+double PhiPsiStatistics::getLogProbability(string _resName, double _phi, double _psi, bool _interpolate){
+	int resType = getResidueTypeIndex(_resName);
+	if (resType < 0){
+		cerr << "ERROR 3440 PhiPsiStatistics::getLogProbability(string _resName, double _phi, double _psi, bool _interpolate) no dense table for residue type "<<_resName<<endl;
+		return MslTools::doubleMax;
+	}
+	return getLogProbability(resType, _phi, _psi, _interpolate);
+}
+
+double PhiPsiStatistics::getLogProbability(const Residue &nMinus1, const Residue &n, const Residue &nPlus1, bool _interpolate){
+	double phi = getPhi(nMinus1, n);
+	double psi = getPsi(n, nPlus1);
+	if (phi == MslTools::doubleMax || psi == MslTools::doubleMax){
+		return MslTools::doubleMax;
+	}
+	return getLogProbability(n.getResidueName(), phi, psi, _interpolate);
+}
+
+bool PhiPsiStatistics::writeBinaryFile(string _filename){
+	if (!gridsCurrent){
+		updateGrids();
+	}
+	if (!gridsUsable){
+		cerr << "ERROR 3441 PhiPsiStatistics::writeBinaryFile(string _filename) the counts are not a complete regular grid over [-180, 180), cannot write "<<_filename<<endl;
+		return false;
+	}
+	return DihedralGrid::writeFile(_filename, gridNames, grids);
+}
+
+bool PhiPsiStatistics::readBinaryFile(string _filename){
+	vector<string> names;
+	vector<DihedralGrid> newGrids;
+	if (!DihedralGrid::readFile(_filename, names, newGrids)){
+		return false;
+	}
+	for (unsigned int i=0; i < newGrids.size(); i++){
+		if (newGrids[i].getDimensions() != 2 || newGrids[i].getBinSize() != newGrids[0].getBinSize()){
+			cerr << "ERROR 3442 PhiPsiStatistics::readBinaryFile(string _filename) "<<_filename<<" does not contain phi/psi grids of a single bin size"<<endl;
+			return false;
+		}
+	}
+
+	grids = newGrids;
+	gridNames = names;
+	gridIndex.clear();
+	for (unsigned int i=0; i < grids.size(); i++){
+		gridIndex[gridNames[i]] = i;
+		grids[i].normalize();
+	}
+	if (grids.size() > 0){
+		gridSize = grids[0].getBinSize();
+	}
+	gridsCurrent = true;
+	gridsUsable = true;
+
+	phiPsiTable.clear();
+	tableCurrent = false;
+	for (map<string,PhiPsiRNG *>::iterator it = phiPsiRandom.begin(); it != phiPsiRandom.end(); it++){
+		delete it->second;
+	}
+	phiPsiRandom.clear();
+	return true;
+}
+
+bool PhiPsiStatistics::isBinaryFile(string _filename){
+	return DihedralGrid::isBinaryFile(_filename);
+}
@@ -34,6 +34,7 @@ You should have received a copy of the GNU Lesser General Public
 //MSL Includes
 #include "Residue.h"
 #include "RandomNumberGenerator.h"
+#include "DihedralGrid.h"
 
 // STL Includes
 #include <stdio.h>
@@ -73,15 +74,60 @@ class PhiPsiStatistics {
 		
 		std::pair<double,double> getRandomPhiPsi(std::string _resType);
 
-		std::map<std::string,int>  getPhiPsiCounts() const { return phiPsiTable; }
+		std::map<std::string,int>  getPhiPsiCounts() const;
 		double getPhiPsiBin(double _angle);
+
+		/***************************************************************
+		 *  Dense tables: the counts of each residue type (and of ALL,
+		 *  after computeTotalCounts) in a DihedralGrid indexed by
+		 *  integer phi and psi bins, with the probabilities and
+		 *  log-probabilities precomputed.  They are built from the
+		 *  string keyed counts on the first query after the counts
+		 *  change, or loaded from a binary file, in which case the
+		 *  string keys are only rebuilt if they are asked for.
+		 *
+		 *  The functions above are wrappers with unchanged results:
+		 *  they keep the binning of getPhiPsiBin (which puts the
+		 *  angles in (-gridSize, 0) in the first positive bin).  The
+		 *  functions below bin with floor((angle + 180) / gridSize).
+		 *  Tables that are not a complete regular grid over
+		 *  [-180, 180) are only available through the string keys
+		 *  (hasGrids() is false).  The integer functions give an error
+		 *  (and getGrid exits) if the index is not a valid residue
+		 *  type of the dense tables.
+		 ***************************************************************/
+		bool hasGrids();
+		int getResidueTypeIndex(std::string _resName); // -1 if the type is not in the table
+		const DihedralGrid & getGrid(int _resType);
+		double getProbability(int _resType, double _phi, double _psi, bool _interpolate=false);
+		double getLogProbability(int _resType, double _phi, double _psi, bool _interpolate=false);
+		double getLogProbability(std::string _resName, double _phi, double _psi, bool _interpolate=false);
+		double getLogProbability(const Residue &nMinus1, const Residue &n, const Residue &nPlus1, bool _interpolate=false);
+
+		bool writeBinaryFile(std::string _filename);
+		bool readBinaryFile(std::string _filename);
+		static bool isBinaryFile(std::string _filename);
+
 	private:
      
 
 		void copy(const PhiPsiStatistics &_phiPsiStat);
+		bool findCounts(const std::string &_resName, double _phi, double _psi, int &_counts);
+		bool findTotal(const std::string &_resName, int &_total);
+		void updateGrids();
+		void updateTable() const;
+		bool validResidueType(int _resType);
                 double gridSize;
 
-		std::map<std::string,int> phiPsiTable;
+		// the string keyed counts are rebuilt from the grids when needed (tableCurrent is false)
+		mutable std::map<std::string,int> phiPsiTable;
+		mutable bool tableCurrent;
+
+		std::vector<DihedralGrid> grids;
+		std::vector<std::string> gridNames;
+		std::map<std::string,int> gridIndex;
+		bool gridsCurrent;
+		bool gridsUsable;
 
 		struct PhiPsiRNG {
 		    RandomNumberGenerator rng;
@@ -116,6 +162,49 @@ inline	void   PhiPsiStatistics::setGridSize(double _gridSize){
 inline 	double PhiPsiStatistics::getGridSize(){
   return gridSize;
 }	
+inline bool PhiPsiStatistics::hasGrids() {
+	if (!gridsCurrent) {
+		updateGrids();
+	}
+	return gridsUsable;
+}
+inline bool PhiPsiStatistics::validResidueType(int _resType) {
+	if (!gridsCurrent) {
+		updateGrids();
+	}
+	return gridsUsable && _resType >= 0 && _resType < (int)grids.size();
+}
+inline const DihedralGrid & PhiPsiStatistics::getGrid(int _resType) {
+	if (!validResidueType(_resType)) {
+		std::cerr << "ERROR 3443 PhiPsiStatistics::getGrid(int _resType) no dense table for residue type index " << _resType << std::endl;
+		exit(3443);
+	}
+	return grids[_resType];
+}
+inline double PhiPsiStatistics::getProbability(int _resType, double _phi, double _psi, bool _interpolate) {
+	if (!validResidueType(_resType)) {
+		std::cerr << "ERROR 3443 PhiPsiStatistics::getProbability(int _resType, double _phi, double _psi, bool _interpolate) no dense table for residue type index " << _resType << std::endl;
+		return MslTools::doubleMax;
+	}
+	const DihedralGrid & grid = grids[_resType];
+	if (_interpolate) {
+		double angles[2] = {_phi, _psi};
+		return grid.getInterpolatedProbability(angles);
+	}
+	return grid.getProbability(grid.getIndex(grid.getBin(_phi), grid.getBin(_psi)));
+}
+inline double PhiPsiStatistics::getLogProbability(int _resType, double _phi, double _psi, bool _interpolate) {
+	if (!validResidueType(_resType)) {
+		std::cerr << "ERROR 3443 PhiPsiStatistics::getLogProbability(int _resType, double _phi, double _psi, bool _interpolate) no dense table for residue type index " << _resType << std::endl;
+		return MslTools::doubleMax;
+	}
+	const DihedralGrid & grid = grids[_resType];
+	if (_interpolate) {
+		double angles[2] = {_phi, _psi};
+		return grid.getInterpolatedLogProbability(angles);
+	}
+	return grid.getLogProbability(grid.getIndex(grid.getBin(_phi), grid.getBin(_psi)));
+}
 
 }
 
@@ -311,6 +311,7 @@ class Position {
 		bool hideIdentity(std::string _resName);
 
 		bool getHidden(const Residue* _pRes) const; // is the residue hidden?
+		unsigned int hiddenIdentitySize() const; // number of hidden identities
 
 		// returns values in degrees [-180,180), doubleMax if not found
 		double getPhi();
@@ -373,6 +374,7 @@ inline void Position::setParentChain(Chain * _chain) {pParentChain = _chain;};
 inline Chain * Position::getParentChain() const {return pParentChain;};
 //inline unsigned int Position::size() const {std::cerr << "WARNING: using deprecated Position::size() function.  Use identitySize() instead" << std::endl; return identities.size();}; // number of identities
 inline unsigned int Position::identitySize() const {return identities.size();}; // number of identities
+inline unsigned int Position::hiddenIdentitySize() const {return hiddenIdentities.size();};
 inline unsigned int Position::residueSize() const {return identities.size();}; // number of identities
 inline unsigned int Position::atomSize() const { return activeAtoms.size(); }; // number of atoms in the current identity
 inline unsigned int Position::allAtomSize() const { return activeAndInactiveAtoms.size(); }; // number of atoms in the current identity
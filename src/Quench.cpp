@@ -36,7 +36,7 @@ using namespace std;
 static SysEnv SYSENV;
 
 Quench::Quench()
-	: calculator(SYSENV.getEnv("MSL_CHARMM_PAR")), currentRotamers(0), currentAllRotamers(0), monomericSurroundEnergies(0)
+	: calculator(SYSENV.getEnv("MSL_CHARMM_PAR")), currentRotamers(0), currentAllRotamers(0)
 {
 	topfile = SYSENV.getEnv("MSL_CHARMM_TOP");
 	parfile = SYSENV.getEnv("MSL_CHARMM_PAR");
@@ -44,12 +44,15 @@ Quench::Quench()
 	numberLargeRotamers = -1;
 	numberSmallRotamers = -1;
 	rotLevel = "";
+	numberOfThreads = 1;
+	randomSeed = 0;
+	threadsAllowed = true;
 
 	calculator.setNonBondedCutoffs(8,12); // 0->8 is full 8-12 is switched, >12 is 0.
 }
 
 Quench::Quench(string _topfile, string _parfile, string _rotlib)
-: calculator(_parfile), currentRotamers(0), currentAllRotamers(0), monomericSurroundEnergies(0)
+: calculator(_parfile), currentRotamers(0), currentAllRotamers(0)
 {
 	topfile = _topfile;
 	parfile = _parfile;
@@ -57,6 +60,9 @@ Quench::Quench(string _topfile, string _parfile, string _rotlib)
 	numberLargeRotamers = -1;
 	numberSmallRotamers = -1;
 	rotLevel = "";
+	numberOfThreads = 1;
+	randomSeed = 0;
+	threadsAllowed = true;
 
 	calculator.setNonBondedCutoffs(8,12); // 0->8 is full 8-12 is switched, >12 is 0.
 }
@@ -127,35 +133,7 @@ void Quench::setUpSystem(System & _initialSystem, System & _outputSystem, uint _
 		}
 	}
 
-	for (uint i = 0; i < _outputSystem.positionSize(); i++) {
-		Position & posVar = _outputSystem.getPosition(i);
-
-		if (posVar.getTotalNumberOfRotamers() == 1) { currentAllRotamers.push_back(0); continue; }
-
-		stringstream ss;
-		ss << _outputSystem.getPosition(i).getChainId() << " " << _outputSystem.getPosition(i).getResidueNumber();
-
-		selfEnergies[ss.str()] = vector<double>(0);
-
-		double minSelf = MslTools::doubleMax;
-		uint minSelfPos = 0;
-
-		for (uint j = 0; j < posVar.getTotalNumberOfRotamers(); j++) {
-			double self = calculator.calculateSelfEnergy(_outputSystem,i,j);
-			self += calculator.calculateBackgroundEnergy(_outputSystem,i,j);
-			selfEnergies[ss.str()].push_back(self);
-
-			if (self < minSelf) {
-				minSelf = self;
-				minSelfPos = j;
-			}
-		}
-
-		currentRotamers.push_back(minSelfPos);
-		currentAllRotamers.push_back(minSelfPos);
-
-		posVar.setActiveRotamer(minSelfPos);
-	}
+	setUpBuiltSystem(_outputSystem);
 
 }
 
@@ -214,35 +192,7 @@ void Quench::setUpSystem(System & _initialSystem, System & _outputSystem, uint _
 		}
 	}
 
-	for (uint i = 0; i < _outputSystem.positionSize(); i++) {
-		Position & posVar = _outputSystem.getPosition(i);
-
-		if (posVar.getTotalNumberOfRotamers() == 1) { currentAllRotamers.push_back(0); continue; }
-
-		stringstream ss;
-		ss << _outputSystem.getPosition(i).getChainId() << " " << _outputSystem.getPosition(i).getResidueNumber();
-
-		selfEnergies[ss.str()] = vector<double>(0);
-
-		double minSelf = MslTools::doubleMax;
-		uint minSelfPos = 0;
-
-		for (uint j = 0; j < posVar.getTotalNumberOfRotamers(); j++) {
-			double self = calculator.calculateSelfEnergy(_outputSystem,i,j);
-			self += calculator.calculateBackgroundEnergy(_outputSystem,i,j);
-			selfEnergies[ss.str()].push_back(self);
-
-			if (self < minSelf) {
-				minSelf = self;
-				minSelfPos = j;
-			}
-		}
-
-		currentRotamers.push_back(minSelfPos);
-		currentAllRotamers.push_back(minSelfPos);
-
-		posVar.setActiveRotamer(minSelfPos);
-	}
+	setUpBuiltSystem(_outputSystem);
 
 }
 
@@ -308,35 +258,7 @@ void Quench::setUpSystem(System & _initialSystem, System & _outputSystem, uint _
 		}
 	}
 
-	for (uint i = 0; i < _outputSystem.positionSize(); i++) {
-		Position & posVar = _outputSystem.getPosition(i);
-
-		if (posVar.getTotalNumberOfRotamers() == 1) { currentAllRotamers.push_back(0); continue; }
-
-		stringstream ss;
-		ss << _outputSystem.getPosition(i).getChainId() << " " << _outputSystem.getPosition(i).getResidueNumber();
-
-		selfEnergies[ss.str()] = vector<double>(0);
-
-		double minSelf = MslTools::doubleMax;
-		uint minSelfPos = 0;
-
-		for (uint j = 0; j < posVar.getTotalNumberOfRotamers(); j++) {
-			double self = tbd.calculateSelfEnergy(_outputSystem,i,j);
-			self += tbd.calculateBackgroundEnergy(_outputSystem,i,j,true);
-			selfEnergies[ss.str()].push_back(self);
-
-			if (self < minSelf) {
-				minSelf = self;
-				minSelfPos = j;
-			}
-		}
-
-		currentRotamers.push_back(minSelfPos);
-		currentAllRotamers.push_back(minSelfPos);
-
-		posVar.setActiveRotamer(minSelfPos);
-	}
+	setUpBuiltSystem(_outputSystem, tbd);
 
 }
 
@@ -394,23 +316,24 @@ void Quench::setUpSystem(System & _initialSystem, System & _outputSystem, uint _
 		}
 	}
 
-	for (uint i = 0; i < _outputSystem.positionSize(); i++) {
-		Position & posVar = _outputSystem.getPosition(i);
+	setUpBuiltSystem(_outputSystem, tbd);
 
-		if (posVar.getTotalNumberOfRotamers() == 1) { currentAllRotamers.push_back(0); continue; }
+}
 
-		stringstream ss;
-		ss << _outputSystem.getPosition(i).getChainId() << " " << _outputSystem.getPosition(i).getResidueNumber();
+void Quench::setUpBuiltSystem(System & _mySystem) {
+	selfEnergies.assign(_mySystem.positionSize(), vector<double>());
+	for (uint i = 0; i < _mySystem.positionSize(); i++) {
+		Position & posVar = _mySystem.getPosition(i);
 
-		selfEnergies[ss.str()] = vector<double>(0);
+		if (posVar.getTotalNumberOfRotamers() == 1) { currentAllRotamers.push_back(0); continue; }
 
 		double minSelf = MslTools::doubleMax;
 		uint minSelfPos = 0;
 
 		for (uint j = 0; j < posVar.getTotalNumberOfRotamers(); j++) {
-			double self = tbd.calculateSelfEnergy(_outputSystem,i,j);
-			self += tbd.calculateBackgroundEnergy(_outputSystem,i,j,true);
-			selfEnergies[ss.str()].push_back(self);
+			double self = calculator.calculateSelfEnergy(_mySystem,i,j);
+			self += calculator.calculateBackgroundEnergy(_mySystem,i,j);
+			selfEnergies[i].push_back(self);
 
 			if (self < minSelf) {
 				minSelf = self;
@@ -423,7 +346,34 @@ void Quench::setUpSystem(System & _initialSystem, System & _outputSystem, uint _
 
 		posVar.setActiveRotamer(minSelfPos);
 	}
+}
+
+void Quench::setUpBuiltSystem(System & _mySystem, TwoBodyDistanceDependentPotentialTable & tbd) {
+	selfEnergies.assign(_mySystem.positionSize(), vector<double>());
+	for (uint i = 0; i < _mySystem.positionSize(); i++) {
+		Position & posVar = _mySystem.getPosition(i);
+
+		if (posVar.getTotalNumberOfRotamers() == 1) { currentAllRotamers.push_back(0); continue; }
 
+		double minSelf = MslTools::doubleMax;
+		uint minSelfPos = 0;
+
+		for (uint j = 0; j < posVar.getTotalNumberOfRotamers(); j++) {
+			double self = tbd.calculateSelfEnergy(_mySystem,i,j);
+			self += tbd.calculateBackgroundEnergy(_mySystem,i,j,true);
+			selfEnergies[i].push_back(self);
+
+			if (self < minSelf) {
+				minSelf = self;
+				minSelfPos = j;
+			}
+		}
+
+		currentRotamers.push_back(minSelfPos);
+		currentAllRotamers.push_back(minSelfPos);
+
+		posVar.setActiveRotamer(minSelfPos);
+	}
 }
 
 void Quench::runPreSetUpQuench(System & _mySystem){
@@ -435,149 +385,35 @@ void Quench::runPreSetUpQuench(System & _mySystem, TwoBodyDistanceDependentPoten
 }
 
 void Quench::runPreSetUpQuench(System & _mySystem, uint _numIterations, TwoBodyDistanceDependentPotentialTable & tbd){
-	vector < vector < vector < vector<double> > > > surroundEnergies(_mySystem.positionSize());
-	for (uint i = 0; i < surroundEnergies.size(); i++) {
-		surroundEnergies[i].resize(_mySystem.getPosition(i).getTotalNumberOfRotamers());
-		for (uint j = 0; j < surroundEnergies[i].size(); j++) {
-			surroundEnergies[i][j].resize(_mySystem.positionSize());
-			for (uint k = 0; k < surroundEnergies[i][j].size(); k++) {
-				surroundEnergies[i][j][k].resize(_mySystem.getPosition(k).getTotalNumberOfRotamers(),MslTools::doubleMax);
-			}
-		}
-	}
+	setUpSurroundCache(_mySystem, getCutoff(&tbd));
 
-	uint numLoops = 0;
-	uint changes = MslTools::intMax;
-	// So that we only index variable positions in currentRotamers
-	PDBWriter writer;
 	RandomNumberGenerator rng(false);
-	//rng.setRNGTimeBasedSeed();
-	vector<int> shuffledOrder;
-	vector<int> variablePosOrder;
+	rng.setSeed(randomSeed); // 0 seeds with the current time
+	vector<unsigned int> shuffledOrder;
 	for (uint i = 0; i < _mySystem.positionSize(); i++) {
-		Position & posVar = _mySystem.getPosition(i);
-		variablePosOrder.push_back(shuffledOrder.size());
-		if (posVar.getTotalNumberOfRotamers() > 1) {
+		if (_mySystem.getPosition(i).getTotalNumberOfRotamers() > 1) {
 			shuffledOrder.push_back(i);
 		}
 	}
-	int totalNum = shuffledOrder.size();
 	random_shuffle(shuffledOrder.begin(),shuffledOrder.end(),rng);
-	double overallEnergy = 0.;
-	while ((numLoops < _numIterations) && (changes > 0)) {
-
-		overallEnergy = 0.;
-		changes = 0;
-
-		for (uint i = 0; i < totalNum; i++) {
-			int thisPos = shuffledOrder[i];
-			Position & posVar = _mySystem.getPosition(thisPos);
-
-			stringstream ss;
-			ss << _mySystem.getPosition(thisPos).getChainId() << " " << _mySystem.getPosition(thisPos).getResidueNumber();
 
-			double minTotal = MslTools::doubleMax;
-			uint minTotalPos = 0;
-
-			for (uint j = 0; j < posVar.getTotalNumberOfRotamers(); j++) {
-				double self = selfEnergies[ss.str()][j];
-				double surround = tbd.calculateSurroundingEnergy(_mySystem,thisPos,j,surroundEnergies, currentAllRotamers, true);
-				double total = self + surround;
-
-				if (total < minTotal) {
-					minTotal = total;
-					minTotalPos = j;
-				}
-			}
-
-			if (minTotal == MslTools::doubleMax) { cerr << "Warning: Bad clash!" << endl; }
-			overallEnergy += minTotal;
-
-			if (currentRotamers[variablePosOrder[thisPos]] != minTotalPos) {
-				changes++;
-				currentRotamers[variablePosOrder[thisPos]] = minTotalPos;
-				currentAllRotamers[thisPos] = minTotalPos;
-			}
-			posVar.setActiveRotamer(minTotalPos);
-			cout << thisPos << " " << minTotal << endl;
-		}
-
-		numLoops++;
-		cout << "New loop: " << numLoops << " " << overallEnergy << endl;
-	}
+	runSweeps(_mySystem, shuffledOrder, _numIterations, &tbd, true);
 }
 
 void Quench::runPreSetUpQuench(System & _mySystem, uint _numIterations){
-	vector < vector < vector < vector<double> > > > surroundEnergies(_mySystem.positionSize());
-	for (uint i = 0; i < surroundEnergies.size(); i++) {
-		surroundEnergies[i].resize(_mySystem.getPosition(i).getTotalNumberOfRotamers());
-		for (uint j = 0; j < surroundEnergies[i].size(); j++) {
-			surroundEnergies[i][j].resize(_mySystem.positionSize());
-			for (uint k = 0; k < surroundEnergies[i][j].size(); k++) {
-				surroundEnergies[i][j][k].resize(_mySystem.getPosition(k).getTotalNumberOfRotamers(),MslTools::doubleMax);
-			}
-		}
-	}
+	setUpSurroundCache(_mySystem, getCutoff(NULL));
 
-	uint numLoops = 0;
-	uint changes = MslTools::intMax;
-	// So that we only index variable positions in currentRotamers
-	PDBWriter writer;
 	RandomNumberGenerator rng(false);
-	//rng.setRNGTimeBasedSeed();
-	vector<int> shuffledOrder;
-	vector<int> variablePosOrder;
+	rng.setSeed(randomSeed); // 0 seeds with the current time
+	vector<unsigned int> shuffledOrder;
 	for (uint i = 0; i < _mySystem.positionSize(); i++) {
-		Position & posVar = _mySystem.getPosition(i);
-		variablePosOrder.push_back(shuffledOrder.size());
-		if (posVar.getTotalNumberOfRotamers() > 1) {
+		if (_mySystem.getPosition(i).getTotalNumberOfRotamers() > 1) {
 			shuffledOrder.push_back(i);
 		}
 	}
-	int totalNum = shuffledOrder.size();
 	random_shuffle(shuffledOrder.begin(),shuffledOrder.end(),rng);
-	double overallEnergy = 0.;
-	while ((numLoops < _numIterations) && (changes > 0)) {
-
-		overallEnergy = 0.;
-		changes = 0;
-
-		for (uint i = 0; i < totalNum; i++) {
-			int thisPos = shuffledOrder[i];
-			Position & posVar = _mySystem.getPosition(thisPos);
-
-			stringstream ss;
-			ss << _mySystem.getPosition(thisPos).getChainId() << " " << _mySystem.getPosition(thisPos).getResidueNumber();
-
-			double minTotal = MslTools::doubleMax;
-			uint minTotalPos = 0;
-
-			for (uint j = 0; j < posVar.getTotalNumberOfRotamers(); j++) {
-				double self = selfEnergies[ss.str()][j];
-				double surround = calculator.calculateSurroundingEnergy(_mySystem,thisPos,j,surroundEnergies, currentAllRotamers);
-				double total = self + surround;
-
-				if (total < minTotal) {
-					minTotal = total;
-					minTotalPos = j;
-				}
-			}
-
-			if (minTotal == MslTools::doubleMax) { cerr << "Warning: Bad clash!" << endl; }
-			overallEnergy += minTotal;
-
-			if (currentRotamers[variablePosOrder[thisPos]] != minTotalPos) {
-				changes++;
-				currentRotamers[variablePosOrder[thisPos]] = minTotalPos;
-				currentAllRotamers[thisPos] = minTotalPos;
-			}
-			posVar.setActiveRotamer(minTotalPos);
-			cout << thisPos << " " << minTotal << endl;
-		}
 
-		numLoops++;
-		cout << "New loop: " << numLoops << " " << overallEnergy << endl;
-	}
+	runSweeps(_mySystem, shuffledOrder, _numIterations, NULL, true);
 }
 
 System Quench::runQuench(System & _initialSystem){
@@ -630,16 +466,7 @@ System Quench::runQuench(System & _initialSystem, uint _numIterations, TwoBodyDi
 }
 
 void Quench::setUpMonomericSurroundEnergies(System & _mySystem) {
-	monomericSurroundEnergies.resize(_mySystem.positionSize());
-	for (uint i = 0; i < monomericSurroundEnergies.size(); i++) {
-		monomericSurroundEnergies[i].resize(_mySystem.getPosition(i).getTotalNumberOfRotamers());
-		for (uint j = 0; j < monomericSurroundEnergies[i].size(); j++) {
-			monomericSurroundEnergies[i][j].resize(_mySystem.positionSize());
-			for (uint k = 0; k < monomericSurroundEnergies[i][j].size(); k++) {
-				monomericSurroundEnergies[i][j][k].resize(_mySystem.getPosition(k).getTotalNumberOfRotamers(),MslTools::doubleMax);
-			}
-		}
-	}
+	monomericSurroundEnergies.clear();
 }
 
 double Quench::runPreSetUpQuenchOnDimer(System & _mySystem){
@@ -647,73 +474,338 @@ double Quench::runPreSetUpQuenchOnDimer(System & _mySystem){
 }
 
 double Quench::runPreSetUpQuenchOnDimer(System & _mySystem, uint _numIterations){
-	vector < vector < vector < vector<double> > > > surroundEnergies(_mySystem.positionSize());
-	for (uint i = 0; i < surroundEnergies.size(); i++) {
-		surroundEnergies[i].resize(_mySystem.getPosition(i).getTotalNumberOfRotamers());
-		for (uint j = 0; j < surroundEnergies[i].size(); j++) {
-			surroundEnergies[i][j].resize(_mySystem.positionSize());
-			for (uint k = 0; k < surroundEnergies[i][j].size(); k++) {
-				if (_mySystem.getPosition(i).getChainId() == _mySystem.getPosition(k).getChainId()) { surroundEnergies[i][j][k] = monomericSurroundEnergies[i][j][k]; }
-				else { surroundEnergies[i][j][k].resize(_mySystem.getPosition(k).getTotalNumberOfRotamers(),MslTools::doubleMax); }
-			}
+	setUpSurroundCache(_mySystem, getCutoff(NULL));
+
+	// the energies within a chain are kept from the previous calls
+	for (uint b = 0; b < surroundBlocks.size(); b++) {
+		SurroundBlock & block = surroundBlocks[b];
+		if (_mySystem.getPosition(block.position1).getChainId() != _mySystem.getPosition(block.position2).getChainId()) {
+			continue;
+		}
+		map<pair<unsigned int, unsigned int>, vector<double> >::iterator found = monomericSurroundEnergies.find(pair<unsigned int, unsigned int>(block.position1, block.position2));
+		if (found != monomericSurroundEnergies.end() && found->second.size() == block.rotamers1 * block.rotamers2) {
+			block.energies.swap(found->second);
 		}
 	}
 
-	uint numLoops = 0;
-	uint changes = MslTools::intMax;
-	// So that we only index variable positions in currentRotamers
-	uint variablePosCounter = 0;
-	PDBWriter writer;
-	while ((numLoops < _numIterations) && (changes > 0)) {
-
-		changes = 0;
-		variablePosCounter = 0;
-
-		for (uint i = 0; i < _mySystem.positionSize(); i++) {
-			Position & posVar = _mySystem.getPosition(i);
+	vector<unsigned int> order;
+	for (uint i = 0; i < _mySystem.positionSize(); i++) {
+		if (_mySystem.getPosition(i).getTotalNumberOfRotamers() > 1) {
+			order.push_back(i);
+		}
+	}
+	runSweeps(_mySystem, order, _numIterations, NULL, false);
 
-			if (posVar.getTotalNumberOfRotamers() > 1) {
-				stringstream ss;
-				ss << _mySystem.getPosition(i).getChainId() << " " << _mySystem.getPosition(i).getResidueNumber();
+	for (uint b = 0; b < surroundBlocks.size(); b++) {
+		SurroundBlock & block = surroundBlocks[b];
+		if (block.energies.size() > 0 && _mySystem.getPosition(block.position1).getChainId() == _mySystem.getPosition(block.position2).getChainId()) {
+			monomericSurroundEnergies[pair<unsigned int, unsigned int>(block.position1, block.position2)] = block.energies;
+		}
+	}
+        OnTheFlyManager otfmanager(&_mySystem, parfile);
+	return otfmanager.calculateStateEnergy(_mySystem,currentRotamers);
 
-				double minTotal = MslTools::doubleMax;
-				uint minTotalPos = 0;
+}
 
-				for (uint j = 0; j < posVar.getTotalNumberOfRotamers(); j++) {
-					double self = selfEnergies[ss.str()][j];
-					double surround = calculator.calculateSurroundingEnergy(_mySystem,i,j,surroundEnergies, currentAllRotamers);
-					double total = self + surround;
+double Quench::getCutoff(TwoBodyDistanceDependentPotentialTable * _pTbd) {
+	// 0 means that all the positions interact
+	if (_pTbd == NULL) {
+		return calculator.getNonBondedCutoffOff();
+	}
+	// beyond the cutoff, every atom pair contributes the value above the cutoff
+	if (_pTbd->getValueAboveCutoff() != 0.0) {
+		return 0.0;
+	}
+	return _pTbd->getMaxDistCutoff();
+}
 
-					if (total < minTotal) {
-						minTotal = total;
-						minTotalPos = j;
+void Quench::setUpSurroundCache(System & _mySystem, double _cutoff) {
+	uint n = _mySystem.positionSize();
+	surroundBlocks.clear();
+	neighbors.assign(n, vector<unsigned int>());
+	neighborBlocks.assign(n, vector<unsigned int>());
+	threadsAllowed = true;
+
+	// the sphere that contains all the atoms of each variable position in all its rotamers
+	vector<bool> variable(n, false);
+	vector<CartesianPoint> centers(n, CartesianPoint(0.0, 0.0, 0.0));
+	vector<double> radii(n, 0.0);
+	for (uint i = 0; i < n; i++) {
+		Position & pos = _mySystem.getPosition(i);
+		if (pos.getLinkedPositionType() != Position::UNLINKED) {
+			threadsAllowed = false;
+		}
+		if (pos.getTotalNumberOfRotamers() <= 1) {
+			continue;
+		}
+		variable[i] = true;
+		if (_cutoff <= 0.0) {
+			continue;
+		}
+		double x = 0.0;
+		double y = 0.0;
+		double z = 0.0;
+		unsigned int count = 0;
+		for (uint id = 0; id < pos.identitySize(); id++) {
+			AtomPointerVector & atoms = pos.getIdentity(id).getAtomPointers();
+			for (uint a = 0; a < atoms.size(); a++) {
+				vector<CartesianPoint*> & coor = atoms[a]->getAllCoor();
+				for (uint c = 0; c < coor.size(); c++) {
+					x += coor[c]->getX();
+					y += coor[c]->getY();
+					z += coor[c]->getZ();
+					count++;
+				}
+			}
+		}
+		if (count == 0) {
+			continue;
+		}
+		centers[i] = CartesianPoint(x / count, y / count, z / count);
+		for (uint id = 0; id < pos.identitySize(); id++) {
+			AtomPointerVector & atoms = pos.getIdentity(id).getAtomPointers();
+			for (uint a = 0; a < atoms.size(); a++) {
+				vector<CartesianPoint*> & coor = atoms[a]->getAllCoor();
+				for (uint c = 0; c < coor.size(); c++) {
+					double d = centers[i].distance(*coor[c]);
+					if (d > radii[i]) {
+						radii[i] = d;
 					}
 				}
+			}
+		}
+	}
+
+	for (uint i = 0; i < n; i++) {
+		if (!variable[i]) continue;
+		for (uint k = i + 1; k < n; k++) {
+			if (!variable[k]) continue;
+			if (_cutoff > 0.0 && centers[i].distance(centers[k]) > radii[i] + radii[k] + _cutoff) continue;
+
+			SurroundBlock block;
+			block.position1 = i;
+			block.position2 = k;
+			block.rotamers1 = _mySystem.getPosition(i).getTotalNumberOfRotamers();
+			block.rotamers2 = _mySystem.getPosition(k).getTotalNumberOfRotamers();
+			neighbors[i].push_back(k);
+			neighborBlocks[i].push_back(surroundBlocks.size());
+			neighbors[k].push_back(i);
+			neighborBlocks[k].push_back(surroundBlocks.size());
+			surroundBlocks.push_back(block);
+		}
+	}
+}
+
+void Quench::runSweeps(System & _mySystem, vector<unsigned int> & _order, uint _numIterations, TwoBodyDistanceDependentPotentialTable * _pTbd, bool _print) {
+	uint n = _mySystem.positionSize();
+
+	// So that we only index variable positions in currentRotamers
+	vector<unsigned int> variablePosOrder(n, 0);
+	unsigned int variableCounter = 0;
+	for (uint i = 0; i < n; i++) {
+		variablePosOrder[i] = variableCounter;
+		if (_mySystem.getPosition(i).getTotalNumberOfRotamers() > 1) {
+			variableCounter++;
+		}
+	}
+
+	// each position goes in the batch after the last of its neighbors that precede it in the order
+	vector<int> orderIndex(n, -1);
+	for (uint t = 0; t < _order.size(); t++) {
+		orderIndex[_order[t]] = t;
+	}
+	vector<unsigned int> batchOf(n, 0);
+	vector<vector<unsigned int> > batches;
+	for (uint t = 0; t < _order.size(); t++) {
+		unsigned int p = _order[t];
+		unsigned int b = 0;
+		for (uint k = 0; k < neighbors[p].size(); k++) {
+			int neighborIndex = orderIndex[neighbors[p][k]];
+			if (neighborIndex >= 0 && neighborIndex < (int)t && batchOf[neighbors[p][k]] + 1 > b) {
+				b = batchOf[neighbors[p][k]] + 1;
+			}
+		}
+		batchOf[p] = b;
+		if (b >= batches.size()) {
+			batches.resize(b + 1);
+		}
+		batches[b].push_back(p);
+	}
+
+	sweepRotamers.assign(n, 0);
+	sweepEnergies.assign(n, 0.0);
+	uint numLoops = 0;
+	uint changes = MslTools::intMax;
+	double overallEnergy = 0.;
+	while ((numLoops < _numIterations) && (changes > 0)) {
+
+		overallEnergy = 0.;
+		changes = 0;
 
-				if (minTotal == MslTools::doubleMax) { cerr << "Warning: Bad clash!" << endl; }
+		for (uint b = 0; b < batches.size(); b++) {
+			runBatch(_mySystem, batches[b], _pTbd);
 
-				if (currentRotamers[variablePosCounter] != minTotalPos) {
+			for (uint i = 0; i < batches[b].size(); i++) {
+				unsigned int thisPos = batches[b][i];
+				if (currentRotamers[variablePosOrder[thisPos]] != sweepRotamers[thisPos]) {
 					changes++;
-					currentRotamers[variablePosCounter] = minTotalPos;
-					currentAllRotamers[i] = minTotalPos;
+					currentRotamers[variablePosOrder[thisPos]] = sweepRotamers[thisPos];
+					currentAllRotamers[thisPos] = sweepRotamers[thisPos];
 				}
-				posVar.setActiveRotamer(minTotalPos);
-				variablePosCounter++;
+				_mySystem.getPosition(thisPos).setActiveRotamer(sweepRotamers[thisPos]);
+			}
+		}
+
+		for (uint t = 0; t < _order.size(); t++) {
+			unsigned int thisPos = _order[t];
+			if (sweepEnergies[thisPos] == MslTools::doubleMax) { cerr << "Warning: Bad clash!" << endl; }
+			overallEnergy += sweepEnergies[thisPos];
+			if (_print) {
+				cout << thisPos << " " << sweepEnergies[thisPos] << endl;
 			}
 		}
 
 		numLoops++;
+		if (_print) {
+			cout << "New loop: " << numLoops << " " << overallEnergy << endl;
+		}
 	}
+}
 
-	for (uint i = 0; i < surroundEnergies.size(); i++) {
-		for (uint j = 0; j < surroundEnergies[i].size(); j++) {
-			for (uint k = 0; k < surroundEnergies[i][j].size(); k++) {
-				if (_mySystem.getPosition(i).getChainId() == _mySystem.getPosition(k).getChainId()) { monomericSurroundEnergies[i][j][k] = surroundEnergies[i][j][k]; }
+void * Quench::runSweepThread(void * _sweep) {
+	SweepThread * pSweep = (SweepThread*)_sweep;
+	const vector<unsigned int> & batch = *(pSweep->pBatch);
+	while (true) {
+		unsigned int i = 0;
+		if (pSweep->pMutex != NULL) {
+			pthread_mutex_lock(pSweep->pMutex);
+		}
+		i = (*(pSweep->pNext))++;
+		if (pSweep->pMutex != NULL) {
+			pthread_mutex_unlock(pSweep->pMutex);
+		}
+		if (i >= batch.size()) {
+			break;
+		}
+		pSweep->pQuench->quenchPosition(*(pSweep->pSystem), batch[i], pSweep->pTbd);
+	}
+	return NULL;
+}
+
+void Quench::runBatch(System & _mySystem, const vector<unsigned int> & _batch, TwoBodyDistanceDependentPotentialTable * _pTbd) {
+	unsigned int next = 0;
+	unsigned int nThreads = threadsAllowed ? numberOfThreads : 1;
+	if (nThreads > _batch.size()) {
+		nThreads = _batch.size();
+	}
+	if (nThreads <= 1) {
+		SweepThread sweep;
+		sweep.pQuench = this;
+		sweep.pSystem = &_mySystem;
+		sweep.pTbd = _pTbd;
+		sweep.pBatch = &_batch;
+		sweep.pNext = &next;
+		sweep.pMutex = NULL;
+		runSweepThread(&sweep);
+		return;
+	}
+
+	pthread_mutex_t mutex;
+	pthread_mutex_init(&mutex, NULL);
+	vector<SweepThread> sweeps(nThreads);
+	for (unsigned int t=0; t<nThreads; t++) {
+		sweeps[t].pQuench = this;
+		sweeps[t].pSystem = &_mySystem;
+		sweeps[t].pTbd = _pTbd;
+		sweeps[t].pBatch = &_batch;
+		sweeps[t].pNext = &next;
+		sweeps[t].pMutex = &mutex;
+	}
+	vector<void*> args(nThreads);
+	for (unsigned int t=0; t<nThreads; t++) {
+		args[t] = &sweeps[t];
+	}
+	MslTools::runThreads(runSweepThread, args);
+	pthread_mutex_destroy(&mutex);
+}
+
+void Quench::quenchPosition(System & _mySystem, unsigned int _position, TwoBodyDistanceDependentPotentialTable * _pTbd) {
+	Position & posVar = _mySystem.getPosition(_position);
+
+	double minTotal = MslTools::doubleMax;
+	uint minTotalPos = 0;
+
+	for (uint j = 0; j < posVar.getTotalNumberOfRotamers(); j++) {
+		AtomPointerVector & atoms = setRotamerAtoms(posVar, j);
+		double self = selfEnergies[_position][j];
+		double surround = calculateSurroundEnergy(_mySystem, _position, j, atoms, _pTbd);
+		double total = self + surround;
+
+		if (total < minTotal) {
+			minTotal = total;
+			minTotalPos = j;
+		}
+	}
+	sweepRotamers[_position] = minTotalPos;
+	sweepEnergies[_position] = minTotal;
+}
+
+double Quench::calculateSurroundEnergy(System & _mySystem, unsigned int _position, unsigned int _rotamer, AtomPointerVector & _atoms, TwoBodyDistanceDependentPotentialTable * _pTbd) {
+	double energy = 0.0;
+	for (uint n = 0; n < neighbors[_position].size(); n++) {
+		unsigned int i = neighbors[_position][n];
+		SurroundBlock & block = surroundBlocks[neighborBlocks[_position][n]];
+		if (block.energies.size() == 0) {
+			block.energies.assign(block.rotamers1 * block.rotamers2, MslTools::doubleMax);
+		}
+		double & pairEnergy = _position == block.position1 ? block.energies[_rotamer * block.rotamers2 + currentAllRotamers[i]] : block.energies[currentAllRotamers[i] * block.rotamers2 + _rotamer];
+		if (pairEnergy == MslTools::doubleMax) {
+			if (_pTbd == NULL) {
+				map<string,double> energies = calculator.calculatePairwiseNonBondedEnergy(_atoms, _mySystem.getPosition(i).getAtomPointers());
+				pairEnergy = energies["TOTAL"];
+			} else {
+				// same arguments as TwoBodyDistanceDependentPotentialTable::calculateSurroundingEnergy(..., true)
+				pairEnergy = _pTbd->calculatePairwiseNonBondedEnergy(_mySystem, _atoms, _mySystem.getPosition(i).getAtomPointers(), true);
 			}
 		}
+		energy += pairEnergy;
 	}
-        OnTheFlyManager otfmanager(&_mySystem, parfile);
-	return otfmanager.calculateStateEnergy(_mySystem,currentRotamers);
+	return energy;
+}
+
+AtomPointerVector & Quench::setRotamerAtoms(Position & _pos, unsigned int _rotamer) {
+	// linked positions are changed together (the sweeps are serial then)
+	if (_pos.getLinkedPositionType() != Position::UNLINKED) {
+		_pos.setActiveRotamer(_rotamer);
+		return _pos.getAtomPointers();
+	}
+	for (uint i = 0; i < _pos.identitySize(); i++) {
+		Residue & identity = _pos.getIdentity(i);
+		if (_rotamer < identity.getNumberOfRotamers()) {
+			identity.setActiveConformation(_rotamer);
+			return identity.getAtomPointers();
+		}
+		_rotamer -= identity.getNumberOfRotamers();
+	}
+	return _pos.getAtomPointers();
+}
 
+size_t Quench::getNumberOfCachedPairEnergies() const {
+	size_t out = 0;
+	for (uint b = 0; b < surroundBlocks.size(); b++) {
+		out += surroundBlocks[b].energies.size();
+	}
+	return out;
 }
 
+size_t Quench::getNumberOfCalculatedPairEnergies() const {
+	size_t out = 0;
+	for (uint b = 0; b < surroundBlocks.size(); b++) {
+		for (uint i = 0; i < surroundBlocks[b].energies.size(); i++) {
+			if (surroundBlocks[b].energies[i] != MslTools::doubleMax) {
+				out++;
+			}
+		}
+	}
+	return out;
+}
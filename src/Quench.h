@@ -50,6 +50,7 @@ You should have received a copy of the GNU Lesser General Public
 #include "CharmmSystemBuilder.h"
 #include "RandomNumberGenerator.h"
 #include "TwoBodyDistanceDependentPotentialTable.h"
+#include <pthread.h>
 
 // Namespaces
 
@@ -73,6 +74,8 @@ class Quench {
 		void setUpSystem(System & _initialSystem, System & _outputSystem, uint _numRotamers);
 		void setUpSystem(System & _initialSystem, System & _outputSystem, std::vector<int> & variablePositions);
 		void setUpSystem(System & _initialSystem, System & _outputSystem, uint _numRotamers, std::vector<int> & variablePositions);
+		// self energies and starting rotamers of a system that has its rotamers already (the last step of setUpSystem)
+		void setUpBuiltSystem(System & _mySystem);
 
 		void setUpMonomericSurroundEnergies(System & _mySystem);
 		double runPreSetUpQuenchOnDimer(System & _mySystem); // Returns CHARMM energy
@@ -81,6 +84,20 @@ class Quench {
 		void setRotamerLevel(std::string _rotLevel);
 		void setVariableNumberRotamers(int _largeSideChainsNumRot, int _smallSideChainsNumRot);
 
+		// number of threads used in the quench sweeps (1 by default)
+		void setNumberOfThreads(unsigned int _threads);
+		unsigned int getNumberOfThreads() const;
+
+		// seed of the shuffling of the positions; 0, the default, uses the current
+		// time in seconds (see RandomNumberGenerator::setSeed), so two quenches started
+		// in the same second shuffle the same way
+		void setRandomSeed(int _seed);
+		int getRandomSeed() const;
+
+		// pair energies stored by the surround cache of the last quench (allocated and calculated)
+		size_t getNumberOfCachedPairEnergies() const;
+		size_t getNumberOfCalculatedPairEnergies() const;
+
 		// For knowledge based potentials
 		System runQuench(System & _initialSystem, TwoBodyDistanceDependentPotentialTable & tbd);
 		System runQuench(System & _initialSystem, uint _numIterations, TwoBodyDistanceDependentPotentialTable & tbd);
@@ -91,9 +108,57 @@ class Quench {
 		void setUpSystem(System & _initialSystem, System & _outputSystem, uint _numRotamers, TwoBodyDistanceDependentPotentialTable & tbd);
 		void setUpSystem(System & _initialSystem, System & _outputSystem, std::vector<int> & variablePositions, TwoBodyDistanceDependentPotentialTable & tbd);
 		void setUpSystem(System & _initialSystem, System & _outputSystem, uint _numRotamers, std::vector<int> & variablePositions, TwoBodyDistanceDependentPotentialTable & tbd);
+		void setUpBuiltSystem(System & _mySystem, TwoBodyDistanceDependentPotentialTable & tbd);
 
 	protected:
 
+		/***************************************************************
+		 *  Surround cache: the pair energies of the rotamers of two
+		 *  variable positions are only stored if the positions can
+		 *  interact, that is if the spheres that contain all their
+		 *  atoms in all their rotamers come within the non bonded
+		 *  cutoff (the energy of the others is exactly zero).  Each
+		 *  such pair has a block of rotamers1 x rotamers2 energies
+		 *  that is allocated on first use and filled one energy at a
+		 *  time (doubleMax until calculated).
+		 ***************************************************************/
+		struct SurroundBlock {
+			unsigned int position1; // position1 < position2
+			unsigned int position2;
+			unsigned int rotamers1;
+			unsigned int rotamers2;
+			std::vector<double> energies; // [rotamer1 * rotamers2 + rotamer2], empty until used
+		};
+
+		/***************************************************************
+		 *  The positions are quenched in batches: a position goes in
+		 *  the batch after the last one of its neighbors that come
+		 *  before it in the sweep order, so the positions of a batch
+		 *  do not interact and are quenched by different threads, with
+		 *  the same result as the serial sweep in that order.  The
+		 *  threads only change the conformation of the identities of
+		 *  their position (not its active identity, which would
+		 *  re-index the chain); the new rotamers are applied after the
+		 *  batch
+		 ***************************************************************/
+		struct SweepThread {
+			Quench * pQuench;
+			System * pSystem;
+			TwoBodyDistanceDependentPotentialTable * pTbd; // NULL for the CHARMM calculator
+			const std::vector<unsigned int> * pBatch;
+			unsigned int * pNext; // shared, positions are taken in order by the first free thread
+			pthread_mutex_t * pMutex;
+		};
+		static void * runSweepThread(void * _sweep);
+
+		void setUpSurroundCache(System & _mySystem, double _cutoff);
+		double getCutoff(TwoBodyDistanceDependentPotentialTable * _pTbd);
+		void runSweeps(System & _mySystem, std::vector<unsigned int> & _order, uint _numIterations, TwoBodyDistanceDependentPotentialTable * _pTbd, bool _print);
+		void runBatch(System & _mySystem, const std::vector<unsigned int> & _batch, TwoBodyDistanceDependentPotentialTable * _pTbd);
+		void quenchPosition(System & _mySystem, unsigned int _position, TwoBodyDistanceDependentPotentialTable * _pTbd);
+		double calculateSurroundEnergy(System & _mySystem, unsigned int _position, unsigned int _rotamer, AtomPointerVector & _atoms, TwoBodyDistanceDependentPotentialTable * _pTbd);
+		AtomPointerVector & setRotamerAtoms(Position & _pos, unsigned int _rotamer);
+
 		std::string topfile;
 		std::string parfile;
 		std::string rotlib;
@@ -105,12 +170,28 @@ class Quench {
 		CharmmEnergyCalculator calculator;
 		std::vector<uint> currentRotamers;
 		std::vector<uint> currentAllRotamers;
-		std::map<std::string, std::vector<double> > selfEnergies;
-		std::vector < std::vector < std::vector < std::vector<double> > > > monomericSurroundEnergies;
+		std::vector<std::vector<double> > selfEnergies; // by position, empty for the fixed ones
+
+		std::vector<SurroundBlock> surroundBlocks;
+		std::vector<std::vector<unsigned int> > neighbors; // variable positions that interact with each one, increasing
+		std::vector<std::vector<unsigned int> > neighborBlocks; // and their block in surroundBlocks
+		std::vector<unsigned int> sweepRotamers; // result of quenchPosition
+		std::vector<double> sweepEnergies;
+		bool threadsAllowed; // false if there are linked positions
+
+		// intra chain blocks of the dimer quench, kept between calls, by (position1, position2)
+		std::map<std::pair<unsigned int, unsigned int>, std::vector<double> > monomericSurroundEnergies;
+
+		unsigned int numberOfThreads;
+		int randomSeed;
 
 };
 inline void Quench::setVariableNumberRotamers(int _largeSideChainsNumRot, int _smallSideChainsNumRot) { numberLargeRotamers = _largeSideChainsNumRot; numberSmallRotamers = _smallSideChainsNumRot;}
 inline void Quench::setRotamerLevel(std::string _rotLevel) { rotLevel = _rotLevel; }
+inline void Quench::setNumberOfThreads(unsigned int _threads) { numberOfThreads = _threads; }
+inline unsigned int Quench::getNumberOfThreads() const { return numberOfThreads; }
+inline void Quench::setRandomSeed(int _seed) { randomSeed = _seed; }
+inline int Quench::getRandomSeed() const { return randomSeed; }
 
 }
 
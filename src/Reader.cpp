@@ -30,6 +30,17 @@ You should have received a copy of the GNU Lesser General Public
 
 #include "Reader.h"
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <iterator>
+
+#ifdef __ZLIB__
+#include <zlib.h>
+#endif
+
 using namespace MSL;
 using namespace std;
 
@@ -65,7 +76,134 @@ string Reader::getLine() {
 
 
 void Reader::copy(const Reader &_anotherReader){
-	
+	// the content block belongs to the open input, it is not shared
+	releaseContent();
+}
+
+bool Reader::loadContent() {
+	releaseContent();
+
+	switch (fileHandler) {
+		case cstyle:
+			return false;
+		case cppstyle: {
+			if (fileStream.fail()) {
+				return false;
+			}
+			streamoff start = fileStream.tellg();
+			if (start < 0) {
+				start = 0;
+			}
+			int fd = ::open(fileName.c_str(), O_RDONLY);
+			if (fd >= 0) {
+				struct stat fileStat;
+				if (fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && fileStat.st_size > start) {
+					void * map = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+					if (map != MAP_FAILED) {
+						madvise(map, fileStat.st_size, MADV_SEQUENTIAL);
+						mappedContent = map;
+						mappedSize = fileStat.st_size;
+						contentBegin = (const char *)map + start;
+						contentEnd = (const char *)map + mappedSize;
+					}
+				}
+				::close(fd);
+			}
+			if (mappedContent == NULL) {
+				// not a mappable file (a pipe, an empty file...), read the stream in one go
+				contentBuffer.assign(istreambuf_iterator<char>(fileStream), istreambuf_iterator<char>());
+				contentBegin = contentBuffer.data();
+				contentEnd = contentBegin + contentBuffer.size();
+			}
+			fileStream.setstate(ios::eofbit);
+			break;
+		}
+		case stringstyle: {
+			if (stringStreamPtr == NULL || stringStreamPtr->fail()) {
+				return false;
+			}
+			streamoff start = stringStreamPtr->tellg();
+			contentBuffer = stringStreamPtr->str();
+			if (start > 0) {
+				contentBuffer.erase(0, start);
+			}
+			contentBegin = contentBuffer.data();
+			contentEnd = contentBegin + contentBuffer.size();
+			stringStreamPtr->setstate(ios::eofbit);
+			break;
+		}
+	}
+
+	// gzip magic number
+	if (contentEnd - contentBegin >= 2 && (unsigned char)contentBegin[0] == 0x1f && (unsigned char)contentBegin[1] == 0x8b) {
+		return inflateContent();
+	}
+	return true;
+}
+
+bool Reader::inflateContent() {
+#ifdef __ZLIB__
+	string out;
+	out.reserve(4 * (contentEnd - contentBegin));
+
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	// 15 + 32: maximum window, gzip or zlib header detected automatically
+	if (inflateInit2(&zs, 15 + 32) != Z_OK) {
+		cerr << "ERROR 11021: Reader::inflateContent() cannot initialize zlib for file " << fileName << endl;
+		releaseContent();
+		return false;
+	}
+	zs.next_in = (Bytef *)contentBegin;
+	zs.avail_in = contentEnd - contentBegin;
+
+	char chunk[262144];
+	int status = Z_OK;
+	while (true) {
+		zs.next_out = (Bytef *)chunk;
+		zs.avail_out = sizeof(chunk);
+		status = inflate(&zs, Z_NO_FLUSH);
+		if (status != Z_OK && status != Z_STREAM_END) {
+			break;
+		}
+		out.append(chunk, sizeof(chunk) - zs.avail_out);
+		if (status == Z_STREAM_END) {
+			if (zs.avail_in == 0) {
+				break;
+			}
+			// concatenated gzip members
+			inflateReset(&zs);
+		}
+	}
+	inflateEnd(&zs);
+
+	if (status != Z_STREAM_END) {
+		cerr << "ERROR 11022: Reader::inflateContent() corrupted compressed data in file " << fileName << endl;
+		releaseContent();
+		return false;
+	}
+
+	releaseContent();
+	contentBuffer.swap(out);
+	contentBegin = contentBuffer.data();
+	contentEnd = contentBegin + contentBuffer.size();
+	return true;
+#else
+	cerr << "ERROR 11023: Reader::inflateContent() file " << fileName << " is gzip compressed, recompile MSL with MSL_ZLIB=T to read it" << endl;
+	releaseContent();
+	return false;
+#endif
+}
+
+void Reader::releaseContent() {
+	if (mappedContent != NULL) {
+		munmap(mappedContent, mappedSize);
+	}
+	mappedContent = NULL;
+	mappedSize = 0;
+	string().swap(contentBuffer);
+	contentBegin = NULL;
+	contentEnd = NULL;
 }
 
 bool Reader::read(string &_inputString){
@@ -41,6 +41,7 @@ You should have received a copy of the GNU Lesser General Public
 // STL Includes
 #include <iostream>
 #include <vector>
+#include <cstring>
 
 namespace MSL { 
 class Reader : public File {
@@ -62,22 +63,63 @@ class Reader : public File {
 		virtual bool read(std::string &_inputString);
 		std::string getLine();
 	protected:		
+		/*
+		  Bulk access for the fast readers: loadContent() makes the rest of
+		  the input available as one block between contentBegin and
+		  contentEnd (memory mapped for plain files, inflated when the data
+		  is gzip compressed) and moves the stream to its end.  nextLine()
+		  walks the block one line at a time without copying it.
+		 */
+		bool loadContent();
+		void releaseContent();
+		bool nextLine(const char *& _pos, const char *& _line, unsigned int & _length) const;
+
+		const char * contentBegin;
+		const char * contentEnd;
 	private:
 		void copy(const Reader &_anotherReader);
+		void initContent();
+		bool inflateContent();
 		
+		void * mappedContent;
+		size_t mappedSize;
+		std::string contentBuffer;
 		
 };
 
 //INLINES GO HERE
-inline Reader::Reader():File((const std::string)"",0) {}
-inline Reader::Reader(const std::string &_filename) : File(_filename,0) {}
-inline Reader::Reader(const std::string &_filename, int &_mode) : File(_filename,0) {}
-inline Reader::Reader(std::stringstream &_ss) : File(_ss) {}
-inline Reader::Reader(const Reader &_anotherReader) : File(_anotherReader) { copy(_anotherReader); }
+inline Reader::Reader():File((const std::string)"",0) { initContent(); }
+inline Reader::Reader(const std::string &_filename) : File(_filename,0) { initContent(); }
+inline Reader::Reader(const std::string &_filename, int &_mode) : File(_filename,0) { initContent(); }
+inline Reader::Reader(std::stringstream &_ss) : File(_ss) { initContent(); }
+inline Reader::Reader(const Reader &_anotherReader) : File(_anotherReader) { initContent(); copy(_anotherReader); }
 inline void Reader::operator=(const Reader &_anotherReader) { copy(_anotherReader); }
 
 
-inline Reader::~Reader() {}
+inline Reader::~Reader() { releaseContent(); }
+
+inline void Reader::initContent() {
+	contentBegin = NULL;
+	contentEnd = NULL;
+	mappedContent = NULL;
+	mappedSize = 0;
+}
+
+inline bool Reader::nextLine(const char *& _pos, const char *& _line, unsigned int & _length) const {
+	if (_pos >= contentEnd) {
+		return false;
+	}
+	_line = _pos;
+	const char * eol = (const char *)memchr(_pos, '\n', contentEnd - _pos);
+	if (eol == NULL) {
+		eol = contentEnd;
+		_pos = contentEnd;
+	} else {
+		_pos = eol + 1;
+	}
+	_length = eol - _line;
+	return true;
+}
 }
 
 #endif
@@ -62,6 +62,12 @@ Residue::~Residue() {
 }
 
 void Residue::addSelectableFunctions(){
+	// the function tables are shared by all residues, fill them once
+	static bool added = false;
+	if (added) {
+		return;
+	}
+	added = true;
 
 	addStringFunction("RESN", &Residue::getResidueName);
 	addIntFunction("RESI", &Residue::getResidueNumber);
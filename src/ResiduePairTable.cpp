@@ -50,8 +50,9 @@ void ResiduePairTable::operator=(const ResiduePairTable &_rpt){
 
 
 void ResiduePairTable::copy(const ResiduePairTable &_rpt){
-	map<string,double>::iterator it;
-    pairTable = _rpt.getPairTable();
+    pairTable = _rpt.pairTable;
+    residueIds = _rpt.residueIds;
+    denseTable = _rpt.denseTable;
 
 }
 
@@ -59,22 +60,29 @@ void ResiduePairTable::addResiduePair(string _res1,string _res2,double _value){
 	stringstream ss;
 	ss << _res1<<":"<<_res2;
 	pairTable[ss.str()] = _value;
-}
-
-
-double ResiduePairTable::getValue(string _res1, string _res2){
-	stringstream ss;
-	ss << _res1<<":"<<_res2;
 
-	map<string,double>::iterator it;
-	it = pairTable.find(ss.str());
-	if (it == pairTable.end()){
-		return MslTools::doubleMax;
+	// intern the names, the dense table grows with a new residue
+	for (unsigned int n=0; n<2; n++) {
+		string & res = n == 0 ? _res1 : _res2;
+		if (residueIds.find(res) != residueIds.end()) {
+			continue;
+		}
+		unsigned int size = residueIds.size();
+		vector<double> grown((size+1) * (size+1), MslTools::doubleMax);
+		for (unsigned int i=0; i<size; i++) {
+			for (unsigned int j=0; j<size; j++) {
+				grown[i * (size+1) + j] = denseTable[i * size + j];
+			}
+		}
+		denseTable.swap(grown);
+		residueIds[res] = size;
 	}
+	denseTable[residueIds[_res1] * residueIds.size() + residueIds[_res2]] = _value;
+}
 
 
-	return it->second;
-	
+double ResiduePairTable::getValue(string _res1, string _res2){
+	return getValue(getResidueId(_res1), getResidueId(_res2));
 }
 
 
@@ -48,12 +48,33 @@ class ResiduePairTable {
 	
 		double getValue(std::string _r1, std::string _r2);
 
+		// the residue names are interned in integer ids, the values are kept in a dense table
+		int getResidueId(const std::string & _res) const; // -1 if not in the table
+		double getValue(int _id1, int _id2) const; // MslTools::doubleMax if not in the table
+
 		std::map<std::string,double> getPairTable() const { return pairTable; }
 	private:
 
 		void copy(const ResiduePairTable &_rpt);
 		std::map<std::string,double> pairTable;
+
+		std::map<std::string,int> residueIds;
+		std::vector<double> denseTable; // residueIds.size() x residueIds.size()
 };
+
+inline int ResiduePairTable::getResidueId(const std::string & _res) const {
+	std::map<std::string,int>::const_iterator found = residueIds.find(_res);
+	if (found == residueIds.end()) {
+		return -1;
+	}
+	return found->second;
+}
+inline double ResiduePairTable::getValue(int _id1, int _id2) const {
+	if (_id1 < 0 || _id2 < 0) {
+		return MslTools::doubleMax;
+	}
+	return denseTable[_id1 * residueIds.size() + _id2];
+}
 }
 
 #endif
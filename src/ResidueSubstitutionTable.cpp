@@ -72,15 +72,15 @@ bool ResidueSubstitutionTable::isResidueInSubstitutionTable(Residue &_res) {
 
 Residue ResidueSubstitutionTable::replaceResidue(Residue &_res) {
     // If this residue isn't in our list of residues to be replaced,
-    // just return it!
-    if( !isResidueInSubstitutionTable(_res) )
+    // just return it!  (a single lookup, the replacement info is not copied)
+    const_iterator found = find( _res.getResidueName() );
+    if( found == end() )
         return _res;
 
     // Clone the current residue, and find the replacement info.
     Residue newRes;
-    ReplacementInfo ri = find( _res.getResidueName() )->second;
-    string newName = ri.first;
-    AtomHash ah = ri.second;
+    const string & newName = found->second.first;
+    const AtomHash & ah = found->second.second;
 
     // Loop over all of the atoms in the residue.
     for(int i=0; i < _res.size(); ++i ){
@@ -0,0 +1,56 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "RigidTransform.h"
+
+using namespace MSL;
+using namespace std;
+
+void RigidTransform::apply(double * _coor, size_t _nPoints) const {
+	const double xx = rotation[0][0], xy = rotation[0][1], xz = rotation[0][2];
+	const double yx = rotation[1][0], yy = rotation[1][1], yz = rotation[1][2];
+	const double zx = rotation[2][0], zy = rotation[2][1], zz = rotation[2][2];
+	const double tx = t[0], ty = t[1], tz = t[2];
+	double * p = _coor;
+	double * end = _coor + 3 * _nPoints;
+	for (; p != end; p += 3) {
+		double x = p[0];
+		double y = p[1];
+		double z = p[2];
+		p[0] = xx * x + xy * y + xz * z + tx;
+		p[1] = yx * x + yy * y + yz * z + ty;
+		p[2] = zx * x + zy * y + zz * z + tz;
+	}
+}
+
+string RigidTransform::toString() const {
+	char c[100];
+	sprintf(c, "\n[%10.6f %10.6f %10.6f]", t[0], t[1], t[2]);
+	return rotation.toString() + (string)c;
+}
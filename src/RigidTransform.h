@@ -0,0 +1,157 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef RIGIDTRANSFORM_H
+#define RIGIDTRANSFORM_H
+
+#include <string>
+#include <vector>
+
+#include "Rotation3.h"
+
+namespace MSL { 
+
+/*****************************************************************
+ *  A rotation followed by a translation, p' = R p + t, held by
+ *  value.  Transforms keeps its history in one: every rotation
+ *  and translation is composed into it, and applyHistory applies
+ *  the result in one step
+ *****************************************************************/
+class RigidTransform {
+	public:
+		RigidTransform(); // identity
+		RigidTransform(const Rotation3 & _rot);
+		RigidTransform(const Rotation3 & _rot, const CartesianPoint & _translation);
+		static RigidTransform rotationAbout(const Rotation3 & _rot, const CartesianPoint & _center); // p' = R (p - _center) + _center
+
+		const Rotation3 & getRotation() const;
+		CartesianPoint getTranslation() const;
+		void setRotation(const Rotation3 & _rot);
+		void setTranslation(const CartesianPoint & _translation);
+		void reset(); // identity
+
+		RigidTransform operator*(const RigidTransform & _transform) const; // _transform first, then this
+		CartesianPoint operator*(const CartesianPoint & _p) const;
+		RigidTransform getInverse() const;
+
+		// compose a step after the current transform
+		void translate(const CartesianPoint & _translation);
+		void rotate(const Rotation3 & _rot, const CartesianPoint & _center=CartesianPoint(0.0, 0.0, 0.0));
+
+		void apply(CartesianPoint & _p) const;
+		void apply(double & _x, double & _y, double & _z) const;
+		// x, y, z of _nPoints consecutive points, in one pass
+		void apply(double * _coor, size_t _nPoints) const;
+		void apply(std::vector<double> & _coor) const;
+
+		std::string toString() const;
+		friend std::ostream & operator<<(std::ostream &_os, const RigidTransform & _transform) {_os << _transform.toString(); return _os;};
+
+	private:
+		Rotation3 rotation;
+		double t[3];
+};
+
+// INLINE FUNCTIONS
+inline RigidTransform::RigidTransform() { t[0] = t[1] = t[2] = 0.0; }
+inline RigidTransform::RigidTransform(const Rotation3 & _rot) : rotation(_rot) { t[0] = t[1] = t[2] = 0.0; }
+inline RigidTransform::RigidTransform(const Rotation3 & _rot, const CartesianPoint & _translation) : rotation(_rot) {
+	t[0] = _translation.getX();
+	t[1] = _translation.getY();
+	t[2] = _translation.getZ();
+}
+inline RigidTransform RigidTransform::rotationAbout(const Rotation3 & _rot, const CartesianPoint & _center) {
+	RigidTransform out(_rot);
+	out.t[0] = -_center.getX();
+	out.t[1] = -_center.getY();
+	out.t[2] = -_center.getZ();
+	_rot.apply(out.t[0], out.t[1], out.t[2]);
+	out.t[0] += _center.getX();
+	out.t[1] += _center.getY();
+	out.t[2] += _center.getZ();
+	return out;
+}
+inline const Rotation3 & RigidTransform::getRotation() const { return rotation; }
+inline CartesianPoint RigidTransform::getTranslation() const { return CartesianPoint(t[0], t[1], t[2]); }
+inline void RigidTransform::setRotation(const Rotation3 & _rot) { rotation = _rot; }
+inline void RigidTransform::setTranslation(const CartesianPoint & _translation) { t[0] = _translation.getX(); t[1] = _translation.getY(); t[2] = _translation.getZ(); }
+inline void RigidTransform::reset() { rotation = Rotation3(); t[0] = t[1] = t[2] = 0.0; }
+inline void RigidTransform::apply(double & _x, double & _y, double & _z) const {
+	rotation.apply(_x, _y, _z);
+	_x += t[0];
+	_y += t[1];
+	_z += t[2];
+}
+inline void RigidTransform::apply(CartesianPoint & _p) const {
+	double x = _p.getX();
+	double y = _p.getY();
+	double z = _p.getZ();
+	apply(x, y, z);
+	_p.setCoor(x, y, z);
+}
+inline CartesianPoint RigidTransform::operator*(const CartesianPoint & _p) const {
+	CartesianPoint out(_p);
+	apply(out);
+	return out;
+}
+inline RigidTransform RigidTransform::operator*(const RigidTransform & _transform) const {
+	// R1 (R2 p + t2) + t1
+	RigidTransform out(rotation * _transform.rotation);
+	out.t[0] = _transform.t[0];
+	out.t[1] = _transform.t[1];
+	out.t[2] = _transform.t[2];
+	apply(out.t[0], out.t[1], out.t[2]);
+	return out;
+}
+inline RigidTransform RigidTransform::getInverse() const {
+	// R^T (p - t)
+	RigidTransform out(rotation.getTranspose());
+	out.t[0] = -t[0];
+	out.t[1] = -t[1];
+	out.t[2] = -t[2];
+	out.rotation.apply(out.t[0], out.t[1], out.t[2]);
+	return out;
+}
+inline void RigidTransform::translate(const CartesianPoint & _translation) {
+	t[0] += _translation.getX();
+	t[1] += _translation.getY();
+	t[2] += _translation.getZ();
+}
+inline void RigidTransform::rotate(const Rotation3 & _rot, const CartesianPoint & _center) {
+	*this = rotationAbout(_rot, _center) * *this;
+}
+inline void RigidTransform::apply(std::vector<double> & _coor) const {
+	if (!_coor.empty()) {
+		apply(&_coor[0], _coor.size() / 3);
+	}
+}
+
+}
+
+#endif
@@ -0,0 +1,112 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "Rotation3.h"
+
+using namespace MSL;
+using namespace std;
+
+Rotation3::Rotation3(const Matrix & _matrix) {
+	if (_matrix.getRows() != 3 || _matrix.getCols() != 3) {
+		cerr << "ERROR 9144: incorrect matrix size (" << _matrix.getRows() << "x" << _matrix.getCols() << ") in Rotation3::Rotation3(const Matrix & _matrix)" << endl;
+		exit(9144);
+	}
+	for (unsigned int i=0; i<3; i++) {
+		for (unsigned int j=0; j<3; j++) {
+			m[i][j] = _matrix.getElement(i, j);
+		}
+	}
+}
+
+bool Rotation3::operator==(const Rotation3 & _rot) const {
+	for (unsigned int i=0; i<3; i++) {
+		for (unsigned int j=0; j<3; j++) {
+			if (m[i][j] != _rot.m[i][j]) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void Rotation3::apply(double * _coor, size_t _nPoints) const {
+	// the elements in locals, so that the loop does not reload them after each store
+	const double xx = m[0][0], xy = m[0][1], xz = m[0][2];
+	const double yx = m[1][0], yy = m[1][1], yz = m[1][2];
+	const double zx = m[2][0], zy = m[2][1], zz = m[2][2];
+	double * p = _coor;
+	double * end = _coor + 3 * _nPoints;
+	for (; p != end; p += 3) {
+		double x = p[0];
+		double y = p[1];
+		double z = p[2];
+		p[0] = xx * x + xy * y + xz * z;
+		p[1] = yx * x + yy * y + yz * z;
+		p[2] = zx * x + zy * y + zz * z;
+	}
+}
+
+void Rotation3::apply(double * _coor, size_t _nPoints, const CartesianPoint & _center) const {
+	// R(p - c) + c = Rp + (c - Rc)
+	const double xx = m[0][0], xy = m[0][1], xz = m[0][2];
+	const double yx = m[1][0], yy = m[1][1], yz = m[1][2];
+	const double zx = m[2][0], zy = m[2][1], zz = m[2][2];
+	double cx = _center.getX();
+	double cy = _center.getY();
+	double cz = _center.getZ();
+	const double tx = cx - (xx * cx + xy * cy + xz * cz);
+	const double ty = cy - (yx * cx + yy * cy + yz * cz);
+	const double tz = cz - (zx * cx + zy * cy + zz * cz);
+	double * p = _coor;
+	double * end = _coor + 3 * _nPoints;
+	for (; p != end; p += 3) {
+		double x = p[0];
+		double y = p[1];
+		double z = p[2];
+		p[0] = xx * x + xy * y + xz * z + tx;
+		p[1] = yx * x + yy * y + yz * z + ty;
+		p[2] = zx * x + zy * y + zz * z + tz;
+	}
+}
+
+Matrix Rotation3::toMatrix() const {
+	Matrix out(3, 3, 0.0);
+	for (unsigned int i=0; i<3; i++) {
+		for (unsigned int j=0; j<3; j++) {
+			out[i][j] = m[i][j];
+		}
+	}
+	return out;
+}
+
+string Rotation3::toString() const {
+	char c[200];
+	sprintf(c, "[%10.6f %10.6f %10.6f]\n[%10.6f %10.6f %10.6f]\n[%10.6f %10.6f %10.6f]", m[0][0], m[0][1], m[0][2], m[1][0], m[1][1], m[1][2], m[2][0], m[2][1], m[2][2]);
+	return (string)c;
+}
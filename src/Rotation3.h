@@ -0,0 +1,140 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef ROTATION3_H
+#define ROTATION3_H
+
+#include <string>
+#include <cstddef>
+
+#include "CartesianPoint.h"
+#include "Matrix.h"
+
+namespace MSL { 
+
+/*****************************************************************
+ *  A 3x3 rotation held by value (no heap allocation), for the
+ *  transformations that Transforms and CartesianGeometry apply
+ *  to every moved atom.  Element access is m[row][col] as with
+ *  Matrix, and a point is rotated as a column vector (the same
+ *  convention as CartesianPoint *= Matrix).  Matrix remains the
+ *  type for general algebra: toMatrix and the Matrix constructor
+ *  convert between the two
+ *****************************************************************/
+class Rotation3 {
+	public:
+		Rotation3(); // identity
+		Rotation3(double _xx, double _xy, double _xz, double _yx, double _yy, double _yz, double _zx, double _zy, double _zz);
+		explicit Rotation3(const Matrix & _matrix); // the matrix must be 3x3
+
+		double * operator[](unsigned int _row);
+		const double * operator[](unsigned int _row) const;
+		bool operator==(const Rotation3 & _rot) const;
+		bool operator!=(const Rotation3 & _rot) const;
+
+		Rotation3 operator*(const Rotation3 & _rot) const; // _rot first, then this
+		CartesianPoint operator*(const CartesianPoint & _p) const;
+		Rotation3 getTranspose() const; // the inverse rotation
+		double getDeterminant() const;
+
+		void apply(CartesianPoint & _p) const;
+		void apply(CartesianPoint & _p, const CartesianPoint & _center) const; // rotation about _center
+		void apply(double & _x, double & _y, double & _z) const;
+		// x, y, z of _nPoints consecutive points, in one pass
+		void apply(double * _coor, size_t _nPoints) const;
+		void apply(double * _coor, size_t _nPoints, const CartesianPoint & _center) const;
+
+		Matrix toMatrix() const;
+		std::string toString() const;
+		friend std::ostream & operator<<(std::ostream &_os, const Rotation3 & _rot) {_os << _rot.toString(); return _os;};
+
+	private:
+		double m[3][3];
+};
+
+// INLINE FUNCTIONS
+inline Rotation3::Rotation3() {
+	m[0][0] = 1.0; m[0][1] = 0.0; m[0][2] = 0.0;
+	m[1][0] = 0.0; m[1][1] = 1.0; m[1][2] = 0.0;
+	m[2][0] = 0.0; m[2][1] = 0.0; m[2][2] = 1.0;
+}
+inline Rotation3::Rotation3(double _xx, double _xy, double _xz, double _yx, double _yy, double _yz, double _zx, double _zy, double _zz) {
+	m[0][0] = _xx; m[0][1] = _xy; m[0][2] = _xz;
+	m[1][0] = _yx; m[1][1] = _yy; m[1][2] = _yz;
+	m[2][0] = _zx; m[2][1] = _zy; m[2][2] = _zz;
+}
+inline double * Rotation3::operator[](unsigned int _row) { return m[_row]; }
+inline const double * Rotation3::operator[](unsigned int _row) const { return m[_row]; }
+inline bool Rotation3::operator!=(const Rotation3 & _rot) const { return !(*this == _rot); }
+inline Rotation3 Rotation3::operator*(const Rotation3 & _rot) const {
+	Rotation3 out;
+	for (unsigned int i=0; i<3; i++) {
+		for (unsigned int j=0; j<3; j++) {
+			out.m[i][j] = m[i][0] * _rot.m[0][j] + m[i][1] * _rot.m[1][j] + m[i][2] * _rot.m[2][j];
+		}
+	}
+	return out;
+}
+inline Rotation3 Rotation3::getTranspose() const {
+	return Rotation3(m[0][0], m[1][0], m[2][0], m[0][1], m[1][1], m[2][1], m[0][2], m[1][2], m[2][2]);
+}
+inline double Rotation3::getDeterminant() const {
+	return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+inline void Rotation3::apply(double & _x, double & _y, double & _z) const {
+	double x = m[0][0] * _x + m[0][1] * _y + m[0][2] * _z;
+	double y = m[1][0] * _x + m[1][1] * _y + m[1][2] * _z;
+	double z = m[2][0] * _x + m[2][1] * _y + m[2][2] * _z;
+	_x = x;
+	_y = y;
+	_z = z;
+}
+inline void Rotation3::apply(CartesianPoint & _p) const {
+	double x = _p.getX();
+	double y = _p.getY();
+	double z = _p.getZ();
+	apply(x, y, z);
+	_p.setCoor(x, y, z);
+}
+inline void Rotation3::apply(CartesianPoint & _p, const CartesianPoint & _center) const {
+	double x = _p.getX() - _center.getX();
+	double y = _p.getY() - _center.getY();
+	double z = _p.getZ() - _center.getZ();
+	apply(x, y, z);
+	_p.setCoor(x + _center.getX(), y + _center.getY(), z + _center.getZ());
+}
+inline CartesianPoint Rotation3::operator*(const CartesianPoint & _p) const {
+	CartesianPoint out(_p);
+	apply(out);
+	return out;
+}
+
+}
+
+#endif
@@ -25,7 +25,7 @@ class SasaAtom {
 		void deleteOcclusionPoints();
 		double calcSasa();
 		double getSasa() const;
-		//void setSasa(double _s);
+		void setSasa(double _s);
 		CartesianPoint * getCenter() const;
 
 		bool buildOcclusionPoints(unsigned int _n);
@@ -72,6 +72,7 @@ inline double SasaAtom::calcSasa() {
 }
 
 inline double SasaAtom::getSasa() const { return sasa;}
+inline void SasaAtom::setSasa(double _s) { sasa = _s;}
 inline CartesianPoint * SasaAtom::getCenter() const { return pCenter;}
 inline void SasaAtom::deleteOcclusionPoints() { ss->deleteAllPoints();}
 inline bool SasaAtom::buildOcclusionPoints(unsigned int _n) { numberOfPoints = _n; return ss->buildOcclusionPoints(*pCenter, totalRadius, numberOfPoints);}
@@ -59,6 +59,11 @@ SasaCalculator::SasaCalculator(SasaCalculator &_sasaCalculator) {
 	probeRadius = _sasaCalculator.probeRadius;
 	atomRadii = _sasaCalculator.atomRadii;
 	setTFactor = _sasaCalculator.setTFactor;
+	unitSphereX = _sasaCalculator.unitSphereX;
+	unitSphereY = _sasaCalculator.unitSphereY;
+	unitSphereZ = _sasaCalculator.unitSphereZ;
+	neighborList = _sasaCalculator.neighborList;
+	numberOfThreads = _sasaCalculator.numberOfThreads;
 }
 
 
@@ -86,6 +91,11 @@ void SasaCalculator::setup(int _noOcclusionPoints, double _probeRadius) {
 	atomRadii["CU"] = 1.38;
 	atomRadii["P"] = 2.15;
 	setTFactor = false;
+	unitSphereX.clear();
+	unitSphereY.clear();
+	unitSphereZ.clear();
+	neighborList.clear();
+	numberOfThreads = 1;
 	
 	// TODO : Find proper values for these
 	//	SasaCalculator::atomRadii["F"] = 1.38;
@@ -120,38 +130,206 @@ void SasaCalculator::deletePointers() {
 
 
 void SasaCalculator::calcSasa() {
-	//vector<vector<SasaAtom*> > distList = findNeighbors(sasaAtoms);
-	vector<AtomPointerVector> distList = findNeighbors();
+	findNeighbors(neighborList);
 
-//	AtomSasa.clear();
-//	ResidueSasa.clear();
-//	ChainSasa.clear();
+	vector<unsigned int> atomIndices(atoms.size());
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		atomIndices[i] = i;
+	}
+	calcAtomsSasa(atomIndices);
+}
 
-	for(int curAtom = 0; curAtom < sasaAtoms.size(); curAtom++) {
-		//Atom* thisAtom = sasaAtoms[curAtom]->getAtom();
-		sasaAtoms[curAtom]->buildOcclusionPoints(noOcclusionPoints);
+void SasaCalculator::calcSasa(AtomPointerVector & _changedAtoms) {
+	if (neighborList.size() != atoms.size()) {
+		// no previous calculation
+		calcSasa();
+		return;
+	}
 
-		bool purge_flag = false;
-		for (unsigned int neighbour = 0; neighbour < distList[curAtom].size(); neighbour++) {
-			if (neighbour == distList[curAtom].size() - 1) {
-				purge_flag = true;
-			}
-			sasaAtoms[curAtom]->removeOccluded(*distList[curAtom][neighbour], purge_flag);	
-			if (sasaAtoms[curAtom]->getSurfaceSphereCurrentSize() == 0) {
-				break;
-			}
+	map<Atom*, unsigned int> atomIndex;
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		atomIndex[atoms[i]] = i;
+	}
+	vector<bool> changed(atoms.size(), false);
+	for (unsigned int i=0; i<_changedAtoms.size(); i++) {
+		map<Atom*, unsigned int>::iterator found = atomIndex.find(_changedAtoms[i]);
+		if (found != atomIndex.end()) {
+			changed[found->second] = true;
 		}
+	}
 
-		atoms[curAtom]->setSasa(sasaAtoms[curAtom]->calcSasa());
-		if (setTFactor) {
-			atoms[curAtom]->setTempFactor(sasaAtoms[curAtom]->getSasa());
+	// an atom needs to be recalculated if it changed or if a changed
+	// atom was a neighbor before or is a neighbor now
+	vector<vector<unsigned int> > newNeighborList;
+	findNeighbors(newNeighborList);
+	vector<unsigned int> atomIndices;
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		bool recalculate = changed[i];
+		for (unsigned int j=0; j<neighborList[i].size() && !recalculate; j++) {
+			recalculate = changed[neighborList[i][j]];
+		}
+		for (unsigned int j=0; j<newNeighborList[i].size() && !recalculate; j++) {
+			recalculate = changed[newNeighborList[i][j]];
 		}
-	//	ChainSasa[atoms[curAtom]->getChainId()] += sasaAtoms[curAtom]->getSasa();
-	//	string resnumIcode
-	//	ResidueSasa[[atoms[curAtom]->getChainId()]
-		sasaAtoms[curAtom]->deleteOcclusionPoints();		 // Delete the built occlusion points
+		if (recalculate) {
+			atomIndices.push_back(i);
+		}
+	}
+	neighborList.swap(newNeighborList);
+	calcAtomsSasa(atomIndices);
+}
 
-	} 
+void SasaCalculator::buildUnitSphere() {
+	/**************************************************************
+	 *  The same golden section spiral of SurfaceSphere::buildOcclusionPoints
+	 *  on a sphere of radius 1 centered on the origin
+	 **************************************************************/
+	unsigned int n = 0;
+	if (noOcclusionPoints > 0) {
+		n = noOcclusionPoints;
+	}
+	if (unitSphereX.size() == n) {
+		return;
+	}
+	unitSphereX.resize(n);
+	unitSphereY.resize(n);
+	unitSphereZ.resize(n);
+	double dlongitude = M_PI*(3-sqrt(5));
+	double longitude = 0.0;
+	double dz = 2.0/(double)n;
+	double z = 1.0 - dz/2.0;
+	for (unsigned int i=0; i < n; i++) {
+		double r = sqrt(1-z*z);
+		unitSphereX[i] = cos(longitude)*r;
+		unitSphereY[i] = sin(longitude)*r;
+		unitSphereZ[i] = z;
+		z = z-dz;
+		longitude = longitude + dlongitude;
+	}
+}
+
+double SasaCalculator::calcAtomSasa(unsigned int _atomIndex, SasaWorkspace & _workspace) const {
+	unsigned int n = unitSphereX.size();
+	if (n == 0) {
+		return 0.0;
+	}
+	// the radius and center of the atom are read from the Atom like those of
+	// its neighbors, so that a radius changed after addAtoms is used for both
+	double probe = sasaAtoms[_atomIndex]->getProbeRadius();
+	double totalRadius = atoms[_atomIndex]->getRadius() + probe;
+	const CartesianPoint & center = atoms[_atomIndex]->getCoor();
+
+	_workspace.x.resize(n);
+	_workspace.y.resize(n);
+	_workspace.z.resize(n);
+	double * x = &_workspace.x[0];
+	double * y = &_workspace.y[0];
+	double * z = &_workspace.z[0];
+	double cx = center.getX();
+	double cy = center.getY();
+	double cz = center.getZ();
+	for (unsigned int k=0; k<n; k++) {
+		x[k] = unitSphereX[k]*totalRadius + cx;
+		y[k] = unitSphereY[k]*totalRadius + cy;
+		z[k] = unitSphereZ[k]*totalRadius + cz;
+	}
+
+	// the neighbors are sorted by distance, the closest take away most of the surface.
+	// The exposed points are moved to the front without branching
+	unsigned int exposed = n;
+	const vector<unsigned int> & neighbors = neighborList[_atomIndex];
+	for (unsigned int j=0; j<neighbors.size() && exposed > 0; j++) {
+		const CartesianPoint & neighborCenter = atoms[neighbors[j]]->getCoor();
+		double nx = neighborCenter.getX();
+		double ny = neighborCenter.getY();
+		double nz = neighborCenter.getZ();
+		double effectiveRadius = atoms[neighbors[j]]->getRadius() + probe;
+		unsigned int kept = 0;
+		for (unsigned int k=0; k<exposed; k++) {
+			double dx = x[k] - nx;
+			double dy = y[k] - ny;
+			double dz = z[k] - nz;
+			// same test as SasaAtom::removeOccluded, so that the result is identical
+			bool occluded = sqrt((dx*dx)+(dy*dy)+(dz*dz)) <= effectiveRadius;
+			x[kept] = x[k];
+			y[kept] = y[k];
+			z[kept] = z[k];
+			kept += !occluded;
+		}
+		exposed = kept;
+	}
+	return (double)exposed/(double)n * 4.0 * M_PI * pow(totalRadius,2.0);
+}
+
+void SasaCalculator::setAtomSasa(unsigned int _atomIndex, double _sasa) {
+	// keep the radius of the SasaAtom current with the one used
+	sasaAtoms[_atomIndex]->setRadius(atoms[_atomIndex]->getRadius());
+	sasaAtoms[_atomIndex]->setSasa(_sasa);
+	atoms[_atomIndex]->setSasa(_sasa);
+	if (setTFactor) {
+		atoms[_atomIndex]->setTempFactor(_sasa);
+	}
+}
+
+void * SasaCalculator::runAtoms(void * _runner) {
+	SasaRunner * pRunner = (SasaRunner*)_runner;
+	const vector<unsigned int> & atomIndices = *(pRunner->pAtoms);
+	const unsigned int chunk = 16;
+	SasaWorkspace workspace;
+	while (true) {
+		unsigned int first = 0;
+		if (pRunner->pMutex != NULL) {
+			pthread_mutex_lock(pRunner->pMutex);
+		}
+		first = *(pRunner->pNextAtom);
+		*(pRunner->pNextAtom) += chunk;
+		if (pRunner->pMutex != NULL) {
+			pthread_mutex_unlock(pRunner->pMutex);
+		}
+		if (first >= atomIndices.size()) {
+			break;
+		}
+		for (unsigned int i=first; i<first+chunk && i<atomIndices.size(); i++) {
+			// each atom is written only by the thread that calculates it
+			pRunner->pCalculator->setAtomSasa(atomIndices[i], pRunner->pCalculator->calcAtomSasa(atomIndices[i], workspace));
+		}
+	}
+	return NULL;
+}
+
+void SasaCalculator::calcAtomsSasa(const vector<unsigned int> & _atomIndices) {
+	buildUnitSphere();
+
+	unsigned int nextAtom = 0;
+	unsigned int nThreads = numberOfThreads;
+	if (nThreads > _atomIndices.size()) {
+		nThreads = _atomIndices.size();
+	}
+	if (nThreads <= 1) {
+		SasaRunner runner;
+		runner.pCalculator = this;
+		runner.pAtoms = &_atomIndices;
+		runner.pNextAtom = &nextAtom;
+		runner.pMutex = NULL;
+		runAtoms(&runner);
+		return;
+	}
+
+	pthread_mutex_t mutex;
+	pthread_mutex_init(&mutex, NULL);
+	vector<SasaRunner> runners(nThreads);
+	for (unsigned int t=0; t<nThreads; t++) {
+		runners[t].pCalculator = this;
+		runners[t].pAtoms = &_atomIndices;
+		runners[t].pNextAtom = &nextAtom;
+		runners[t].pMutex = &mutex;
+	}
+	vector<void*> args(nThreads);
+	for (unsigned int t=0; t<nThreads; t++) {
+		args[t] = &runners[t];
+	}
+	MslTools::runThreads(runAtoms, args);
+	pthread_mutex_destroy(&mutex);
 }
  
 
@@ -219,8 +397,10 @@ string SasaCalculator::getSasaTable(bool _byAtom) {
 	return ss.str();
 }
 
-vector<AtomPointerVector> SasaCalculator::findNeighbors() {
-	vector<AtomPointerVector> distList(atoms.size());
+void SasaCalculator::findNeighbors(vector<vector<unsigned int> > & _neighbors) {
+	vector<vector<unsigned int> > & distList = _neighbors;
+	distList.clear();
+	distList.resize(atoms.size());
 	//vector<vector<SasaAtom*> > distList(_sasaAtoms.size());
 	vector<vector<double> > distVals(atoms.size());
 //	unsigned int dCounter = 0;
@@ -241,9 +421,9 @@ vector<AtomPointerVector> SasaCalculator::findNeighbors() {
 				double d = atoms[i]->distance(*atoms[j]);
 		//		dCounter++;
 				if(d < (r1 + r2 + 2 * probeRadius )) {
-					distList[i].push_back(atoms[j]);
+					distList[i].push_back(j);
 					distVals[i].push_back(d);
-					distList[j].push_back(atoms[i]);
+					distList[j].push_back(i);
 					distVals[j].push_back(d);
 				} 
 			}
@@ -254,7 +434,7 @@ vector<AtomPointerVector> SasaCalculator::findNeighbors() {
 				index[j] = j;
 			}
 			MslTools::quickSortWithIndex(distVals[i], index);
-			AtomPointerVector tmpDistList (distList[i].size(), NULL);
+			vector<unsigned int> tmpDistList (distList[i].size(), 0);
 			for (unsigned int j=0; j<index.size(); j++) {
 				tmpDistList[j] = distList[i][ index[j] ];
 			}
@@ -277,6 +457,10 @@ vector<AtomPointerVector> SasaCalculator::findNeighbors() {
 		Atom3DGrid grid(atoms, rMax1+rMax2+2*probeRadius);
 		*/
 		Atom3DGrid grid(atoms, 5+2*probeRadius);
+		map<Atom*, unsigned int> atomIndex;
+		for (unsigned int i=0; i<atoms.size(); i++) {
+			atomIndex[atoms[i]] = i;
+		}
 		for (int i = 0; i< atoms.size(); i++) {
 			double r1 = atoms[i]->getRadius();
 			if (r1 <= 0) {
@@ -293,7 +477,7 @@ vector<AtomPointerVector> SasaCalculator::findNeighbors() {
 				double d = atoms[i]->distance(*neighbors[j]);
 			//	dCounter++;
 				if(d < (r1 + r2 + 2 * probeRadius )) {
-					distList[i].push_back(neighbors[j]);
+					distList[i].push_back(atomIndex[neighbors[j]]);
 					distVals[i].push_back(d);
 					//distList[j].push_back(atoms[i]);
 					//distVals[j].push_back(d);
@@ -306,7 +490,7 @@ vector<AtomPointerVector> SasaCalculator::findNeighbors() {
 				index[j] = j;
 			}
 			MslTools::quickSortWithIndex(distVals[i], index);
-			AtomPointerVector tmpDistList (distList[i].size(), NULL);
+			vector<unsigned int> tmpDistList (distList[i].size(), 0);
 			for (unsigned int j=0; j<index.size(); j++) {
 				tmpDistList[j] = distList[i][ index[j] ];
 			}
@@ -315,7 +499,6 @@ vector<AtomPointerVector> SasaCalculator::findNeighbors() {
 		}
 	}
 	//cout << "UUUU d counter " << dCounter << endl;
-	return distList;
 }
 
 void SasaCalculator::printSasaTable(bool _byAtom) {
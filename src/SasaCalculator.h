@@ -30,6 +30,7 @@ You should have received a copy of the GNU Lesser General Public
 #define SASACALCULATOR_H
 
 #include <sstream>
+#include <pthread.h>
 
 #include "AtomPointerVector.h"
 #include "SurfaceSphere.h"
@@ -64,6 +65,11 @@ class SasaCalculator {
 		void addAtoms(AtomPointerVector& _atoms);
 		std::vector<SasaAtom*> & getAtomPointers();
 		void calcSasa();
+		// recalculate only the atoms given (because they moved or their radius changed)
+		// and those that were or are now their neighbors, the other atoms keep their SASA.
+		// The radii are always read from the atoms (Atom::getRadius).
+		// It requires a previous calcSasa(), otherwise all atoms are calculated
+		void calcSasa(AtomPointerVector & _changedAtoms);
 	//	double getAtomSasa(std::string _atomId); // use "A 7 CA" or "A,7,CA"
 		double getResidueSasa(std::string _positionId); // use "A 7" or "A,7"
 		std::string getSasaTable(bool _byAtom=true); // if _byAtom == false print residue sasa
@@ -87,12 +93,40 @@ class SasaCalculator {
 		void setTempFactorWithSasa(bool _flag); // if true saves the sasa also on the B factor
 		bool getTempFactorWithSasa() const;
 
+		void setNumberOfThreads(unsigned int _threads); // the atoms are split among the threads (default 1)
+		unsigned int getNumberOfThreads() const;
+
 //		bool readRadiiMap(std::string _mapFile); TO BE IMPLEMENTED!!!
 
 	private:
 		void setup(int _noOcclusionPoints, double _probeRadius);
 		//std::vector<std::vector<SasaAtom*> > findNeighbors();
-		std::vector<AtomPointerVector> findNeighbors();
+		void findNeighbors(std::vector<std::vector<unsigned int> > & _neighbors); // indeces of the neighbors, sorted by distance
+
+		/***************************************************************
+		 *  The SASA of an atom is the fraction of the points of a sphere
+		 *  (radius + probe) that are not within radius + probe of any of
+		 *  its neighbors.  The points are the same for all atoms on a
+		 *  unit sphere (built once) scaled and translated on the atom.
+		 *  They are kept in contiguous arrays, and the points that are
+		 *  still exposed are packed at the front after each neighbor
+		 ***************************************************************/
+		struct SasaWorkspace {
+			std::vector<double> x;
+			std::vector<double> y;
+			std::vector<double> z;
+		};
+		struct SasaRunner {
+			SasaCalculator * pCalculator;
+			const std::vector<unsigned int> * pAtoms;
+			unsigned int * pNextAtom; // shared, the atoms are taken in chunks by the first free thread
+			pthread_mutex_t * pMutex;
+		};
+		void buildUnitSphere();
+		double calcAtomSasa(unsigned int _atomIndex, SasaWorkspace & _workspace) const;
+		void setAtomSasa(unsigned int _atomIndex, double _sasa);
+		static void * runAtoms(void * _runner);
+		void calcAtomsSasa(const std::vector<unsigned int> & _atomIndices);
 
 		std::map <std::string,double> atomRadii;
 	//	std::map <std::string, std::map<std::string, std::map<std::string, double> > > AtomSasa;
@@ -107,6 +141,12 @@ class SasaCalculator {
 		double probeRadius;
 
 		bool setTFactor;
+
+		std::vector<double> unitSphereX;
+		std::vector<double> unitSphereY;
+		std::vector<double> unitSphereZ;
+		std::vector<std::vector<unsigned int> > neighborList; // from the last calculation
+		unsigned int numberOfThreads;
 };
 
 
@@ -118,6 +158,8 @@ inline std::map <std::string,double> SasaCalculator::getRadiiMap() const {return
 inline void SasaCalculator::setRadiiMap(const std::map <std::string,double> & _radiiMap) {atomRadii = _radiiMap;}
 inline void SasaCalculator::setTempFactorWithSasa(bool _flag) {setTFactor = _flag;}
 inline bool SasaCalculator::getTempFactorWithSasa() const {return setTFactor;}
+inline void SasaCalculator::setNumberOfThreads(unsigned int _threads) {numberOfThreads = _threads;}
+inline unsigned int SasaCalculator::getNumberOfThreads() const {return numberOfThreads;}
 inline std::string SasaCalculator::getResidueSasaTable() {return getSasaTable(false);}
 inline void SasaCalculator::printResidueSasaTable() {printSasaTable(false);}
 //inline double getAtomSasa(std::string _chain_resnumr_name) {
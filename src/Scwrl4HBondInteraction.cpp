@@ -36,6 +36,74 @@ using namespace std;
 
 
 const string Scwrl4HBondInteraction::typeName = "SCWRL4_HBOND";
+
+/*************************************************************
+ *  Derivative of the cosine of the angle between _u and _v
+ *  by the components of _u (_gu) and of _v (_gv)
+ *************************************************************/
+static void cosAngleGradient(const CartesianPoint & _u, const CartesianPoint & _v, CartesianPoint & _gu, CartesianPoint & _gv) {
+	double lu = _u.length();
+	double lv = _v.length();
+	double cosAngle = (_u * _v) / (lu * lv);
+	_gu = _v / (lu * lv) - _u * (cosAngle / (lu * lu));
+	_gv = _u / (lu * lv) - _v * (cosAngle / (lv * lv));
+}
+
+/*************************************************************
+ *  Chain rule through the vector e = P - B, where P is built by
+ *  CartesianGeometry::buildRadians(B, C, D, distance, angle,
+ *  dihedral):  given _ge = dF/de it adds dF/dB, dF/dC and dF/dD
+ *  to _gB, _gC and _gD.  With u the unit vector of B - C and
+ *  c = C - D
+ *
+ *    e = u * rcos + unit(c - u (c.u)) * rsincos + unit(u x c) * rsinsin
+ *************************************************************/
+static void builtVectorGradient(const CartesianPoint & _B, const CartesianPoint & _C, const CartesianPoint & _D, double _angle, double _dihedral, double _distance, const CartesianPoint & _ge, CartesianPoint & _gB, CartesianPoint & _gC, CartesianPoint & _gD) {
+	CartesianPoint b = _B - _C;
+	double lb = b.length();
+	CartesianPoint u = b / lb;
+	CartesianPoint c = _C - _D;
+
+	double angle2 = M_PI - _angle;
+	double dihe2 = M_PI + _dihedral;
+	double rsin = _distance * sin(angle2);
+	double rcos = _distance * cos(angle2);
+	double rsinsin = rsin * sin(dihe2);
+	double rsincos = rsin * cos(dihe2);
+
+	double cu = c * u;
+	CartesianPoint w = c - u * cu;
+	double lw = w.length();
+	CartesianPoint m = w / lw;
+	CartesianPoint x = u.cross(c);
+	double lx = x.length();
+	CartesianPoint k = x / lx;
+
+	CartesianPoint gm = _ge * rsincos;
+	CartesianPoint gk = _ge * rsinsin;
+	CartesianPoint gu = _ge * rcos;
+
+	// through the normalizations
+	CartesianPoint gw = (gm - m * (m * gm)) / lw;
+	CartesianPoint gx = (gk - k * (k * gk)) / lx;
+
+	// x = u x c
+	gu += c.cross(gx);
+	CartesianPoint gc = gx.cross(u);
+
+	// w = c - u (c.u)
+	double gwu = gw * u;
+	gc += gw - u * gwu;
+	gu -= c * gwu + gw * cu;
+
+	// u = unit(B - C)
+	CartesianPoint gb = (gu - u * (u * gu)) / lb;
+
+	_gB += gb;
+	_gC -= gb;
+	_gC += gc;
+	_gD -= gc;
+}
 // parameters from "G.G.Krivov et al,Improved prediction of protein side-chain conformations with SCWRL4"
 
 
@@ -109,7 +177,10 @@ void Scwrl4HBondInteraction::printParameters() {
 }
 
 
-double Scwrl4HBondInteraction::getW() {
+double Scwrl4HBondInteraction::getW(std::vector<double> * _dw) {
+	if (_dw != NULL) {
+		_dw->assign(15, 0.0);
+	}
 	double d = pAtoms[0]->distance(*pAtoms[2]);
 	if(d >= (params[4] + params[5]) || d <= (params[4] - params[5]) ) {
 		// this means d is outside the maximum allowed range i.e) d0 +- sig_d 
@@ -173,9 +244,11 @@ double Scwrl4HBondInteraction::getW() {
 
 
 			double cos_beta = cos_beta_e1;
+			unsigned int electronDihedral = 2;
 			if (cos_beta_e2 > cos_beta_e1) {
 				// check which of the angles is closer to optimal and use that
 				cos_beta = cos_beta_e2;
+				electronDihedral = 3;
 			}
 
 			if (cos_beta <= params[8]) {
@@ -190,7 +263,47 @@ double Scwrl4HBondInteraction::getW() {
 				double denominator = params[5] * sqrt((1-params[7]) * (1-params[8])); 
 				// computes w and returns
 				// w = sqrt(t1 * t2 * t3)/denominator
-				return sqrt(t1 * t2 * t3)/denominator;
+				double w = sqrt(t1 * t2 * t3)/denominator;
+
+				if (_dw != NULL) {
+					/*****************************************************
+					 *  dw = w/2 * (dt1/t1 + dt2/t2 + dt3/t3)
+					 *
+					 *  dt1 = -2 (d - d0) dd
+					 *  dt2 = d cos(alpha), the angle between -n and e0
+					 *  dt3 = d cos(beta), the angle between n and the
+					 *        electron (built from the three acceptor atoms)
+					 *****************************************************/
+					CartesianPoint g[5];
+					double f1 = w / 2.0 / t1;
+					double f2 = w / 2.0 / t2;
+					double f3 = w / 2.0 / t3;
+
+					CartesianPoint gd = n * (-2.0 * (d - params[4]) / d * f1);
+					g[0] += gd;
+					g[2] -= gd;
+
+					CartesianPoint gu;
+					CartesianPoint gv;
+					cosAngleGradient(n * -1.0, e0, gu, gv);
+					g[2] += gu * f2;
+					g[0] += (gv - gu) * f2;
+					g[1] -= gv * f2;
+
+					e = (CartesianGeometry::buildRadians(pAtoms[2]->getCoor(),pAtoms[3]->getCoor(),pAtoms[4]->getCoor(),params[0],params[1],params[electronDihedral])) - pAtoms[2]->getCoor();
+					CartesianPoint ge;
+					cosAngleGradient(n, e, gu, ge);
+					g[0] += gu * f3;
+					g[2] -= gu * f3;
+					builtVectorGradient(pAtoms[2]->getCoor(), pAtoms[3]->getCoor(), pAtoms[4]->getCoor(), params[1], params[electronDihedral], params[0], ge * f3, g[2], g[3], g[4]);
+
+					for (unsigned int i=0; i<5; i++) {
+						(*_dw)[3*i] = g[i].getX();
+						(*_dw)[3*i+1] = g[i].getY();
+						(*_dw)[3*i+2] = g[i].getZ();
+					}
+				}
+				return w;
 			}
 
 		}        
@@ -202,3 +315,15 @@ double Scwrl4HBondInteraction::getEnergy() {
 	return(scalingFactor * getW() * pAtoms[0]->getCharge() * pAtoms[2]->getCharge() * params[6]);
 }
 
+double Scwrl4HBondInteraction::getEnergy(std::vector<double> *_dd) {
+	if(_dd) {
+		double factor = scalingFactor * pAtoms[0]->getCharge() * pAtoms[2]->getCharge() * params[6];
+		double w = getW(_dd);
+		for (unsigned int i=0; i<_dd->size(); i++) {
+			(*_dd)[i] *= factor;
+		}
+		// same order of the products as getEnergy()
+		return(scalingFactor * w * pAtoms[0]->getCharge() * pAtoms[2]->getCharge() * params[6]);
+	}
+	return getEnergy();
+}
@@ -74,9 +74,11 @@ namespace MSL {
 
 			std::string getName() const;
 			friend std::ostream & operator<<(std::ostream &_os, Scwrl4HBondInteraction & _term) {_os << _term.toString(); return _os;};
-			bool isSelected (std::string _sele1, std::string _sele2) const;
+			bool isSelected(unsigned int _sele1, unsigned int _sele2) const;
+			using Interaction::isSelected;
 			bool isActive () const;
-			double getW() ;
+			// if _dw is given it receives dw/dx,dw/dy,dw/dz of the five atoms
+			double getW(std::vector<double> * _dw=NULL);
 			void setScalingFactor(double _scalingFactor);
 			double getScalingFactor() const;
 			void printParameters();
@@ -114,7 +116,7 @@ namespace MSL {
 		params[8] = cos(_beta_max );
 	 }
 	inline std::vector<double> Scwrl4HBondInteraction::getParams() const {return params;};
-	inline bool Scwrl4HBondInteraction::isSelected(std::string _sele1, std::string _sele2) const {
+	inline bool Scwrl4HBondInteraction::isSelected(unsigned int _sele1, unsigned int _sele2) const {
 		if((pAtoms[0]->getSelectionFlag(_sele1) && pAtoms[2]->getSelectionFlag(_sele2)) || (pAtoms[2]->getSelectionFlag(_sele1) && pAtoms[0]->getSelectionFlag(_sele2))) {
 			return true;
 		} else {
@@ -136,13 +138,6 @@ namespace MSL {
 		getEnergy(&(partials.second));
 		return partials;
 	}
-	inline double Scwrl4HBondInteraction::getEnergy(std::vector<double> *_dd) {
-		if(_dd) {
-			std::cerr << "Scwrl4HBondInteraction::partialDerivative is not implemented" << std::endl;
-			_dd->resize(pAtoms.size(),0.0);
-		}
-		return getEnergy();
-	}
 }
 
 #endif
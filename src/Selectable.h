@@ -34,6 +34,8 @@ You should have received a copy of the GNU Lesser General Public
 // STL Includes
 #include <string>
 #include <map>
+#include <vector>
+#include <bitset>
 
 // MSL Includes
 #include "Real.h"
@@ -44,6 +46,7 @@ You should have received a copy of the GNU Lesser General Public
 #ifdef __BOOST__
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include <boost/serialization/split_member.hpp>
 #endif
 
 // Namespaces
@@ -83,8 +86,8 @@ template <class T> class Selectable : public KeyLookup {
 
 		
 		inline void addStringFunction(std::string _key, std::string(T::*_fpt)() const){
-			keyValuePairStrings[_key] = _fpt;
-			validKeywords[_key] = "string";	
+			keyValuePairStrings()[_key] = _fpt;
+			validKeywords()[_key] = "string";	
 			//std::cout << "Added: "<<_key<<" to std::strings"<<std::endl;
 			
 		}
@@ -96,125 +99,248 @@ template <class T> class Selectable : public KeyLookup {
 		}
 		*/
 		inline std::string getString(std::string _key){
-			return ((*ptTObj).*(keyValuePairStrings[_key]))();
+			return ((*ptTObj).*(keyValuePairStrings()[_key]))();
 		}
 
 
 		inline void addRealFunction(std::string _key, Real(T::*_fpt)() const){
-			keyValuePairReals[_key] = _fpt;
-			validKeywords[_key] = "real";
+			keyValuePairReals()[_key] = _fpt;
+			validKeywords()[_key] = "real";
 		}
 
 		inline Real getReal(std::string _key){
-			return ((*ptTObj).*(keyValuePairReals[_key]))();
+			return ((*ptTObj).*(keyValuePairReals()[_key]))();
 		}
 
 		inline void addIntFunction(std::string _key, int(T::*_fpt)() const){
-			keyValuePairInts[_key] = _fpt;
-			validKeywords[_key] = "int";
+			keyValuePairInts()[_key] = _fpt;
+			validKeywords()[_key] = "int";
 		}
 
 		inline int getInt(std::string _key){
-			return ((*ptTObj).*(keyValuePairInts[_key]))();
+			return ((*ptTObj).*(keyValuePairInts()[_key]))();
 		}
 
 
 		inline void addBoolFunction(std::string _key, bool(T::*_fpt)() const){
-			keyValuePairBools[_key] = _fpt;
-			validKeywords[_key] = "bool";
+			keyValuePairBools()[_key] = _fpt;
+			validKeywords()[_key] = "bool";
 		}
 
 		inline bool getBool(std::string _key){
-			return ((*ptTObj).*(keyValuePairBools[_key]))();
+			return ((*ptTObj).*(keyValuePairBools()[_key]))();
 		}
 
 		inline void addQueryBoolFunction(std::string _key, bool(T::*_fpt)(std::string _arg)){
-			keyValuePairQueryBools[_key] = _fpt;
-			validKeywords[_key] = "queryBool";
+			keyValuePairQueryBools()[_key] = _fpt;
+			validKeywords()[_key] = "queryBool";
 		}
 
 		inline bool getQueryBool(std::string _key, std::string _arg){
-		  return ((*ptTObj).*(keyValuePairQueryBools[_key]))(_arg);
+		  return ((*ptTObj).*(keyValuePairQueryBools()[_key]))(_arg);
 		}
 
 
 		inline std::string isValidKeyword(std::string _key){
 			Hash<std::string,std::string>::Table::iterator it;
-			it = validKeywords.find(_key);
-			if (it == validKeywords.end()) {
+			it = validKeywords().find(_key);
+			if (it == validKeywords().end()) {
 				return "";
 			} 
 			return it->second;
 		}
 
 
-		inline void setSelectionFlag(std::string _key, bool _flag) { _key = MslTools::toUpper(_key); selectionFlags[_key] = _flag; }
-		inline bool getSelectionFlag(std::string _key) { 
+		/***********************************************************
+		 *  Selection flags
+		 *
+		 *  Each selection name is registered once (upper case) in
+		 *  a registry shared by all objects of type T and receives
+		 *  a compact integer id.  The first selectionBitSize ids
+		 *  are stored as bits in a fixed-size bitset, so that
+		 *  getSelectionFlag(unsigned int) is a single bit test.
+		 *  Ids beyond that (i.e. when a program creates a very
+		 *  large number of selection names) fall back on a hash
+		 *  keyed by name.
+		 *
+		 *  Hot loops (i.e. Interaction::isSelected) should convert
+		 *  the names to ids once with findSelectionId and use the
+		 *  integer functions.  The string functions are wrappers
+		 *  ************************************************************/
+		static const unsigned int selectionBitSize = 64;
+		static const unsigned int noSelectionId = (unsigned int)-1;
+
+		// returns the id of a selection, registering the name if new
+		static inline unsigned int registerSelectionId(std::string _key) {
 			_key = MslTools::toUpper(_key);
-			Hash<std::string,bool>::Table::iterator it = selectionFlags.find(_key); 
+			typename std::map<std::string,unsigned int>::iterator found = selectionIdTable().find(_key);
+			if (found != selectionIdTable().end()) {
+				return found->second;
+			}
+			unsigned int id = selectionIdNames().size();
+			selectionIdTable()[_key] = id;
+			selectionIdNames().push_back(_key);
+			return id;
+		}
+		// returns the id of a selection or noSelectionId if the name was never registered (no object is selected by it)
+		static inline unsigned int findSelectionId(std::string _key) {
+			_key = MslTools::toUpper(_key);
+			typename std::map<std::string,unsigned int>::const_iterator found = selectionIdTable().find(_key);
+			if (found != selectionIdTable().end()) {
+				return found->second;
+			}
+			return noSelectionId;
+		}
+		static inline std::string getSelectionName(unsigned int _id) {
+			if (_id < selectionIdNames().size()) {
+				return selectionIdNames()[_id];
+			}
+			return "";
+		}
 
+		inline void setSelectionFlag(std::string _key, bool _flag) { setSelectionFlag(registerSelectionId(_key), _flag); }
+		inline void setSelectionFlag(unsigned int _id, bool _flag) {
+			if (_id < selectionBitSize) {
+				selectionBits.set(_id, _flag);
+			} else if (_id < selectionIdNames().size()) {
+				selectionFlags[selectionIdNames()[_id]] = _flag;
+			}
+		}
+		inline bool getSelectionFlag(std::string _key) { 
+			return getSelectionFlag(findSelectionId(_key));
+		}
+		inline bool getSelectionFlag(unsigned int _id) const {
+			if (_id < selectionBitSize) {
+				return selectionBits.test(_id);
+			}
+			if (_id >= selectionIdNames().size()) {
+				return false;
+			}
+			Hash<std::string,bool>::Table::const_iterator it = selectionFlags.find(selectionIdNames()[_id]); 
 			if (it != selectionFlags.end()){
-				return selectionFlags[_key];  
+				return it->second;
 			}
-
-
 			return false;
 		}
 
 
 		inline void printAllFlags(){
-			Hash<std::string,bool>::Table::iterator it;
-			for (it = selectionFlags.begin(); it != selectionFlags.end(); it++){
-				if (it->second){
-					if (it != selectionFlags.begin()){
+			bool first = true;
+			for (unsigned int i=0; i < selectionIdNames().size(); i++) {
+				if (getSelectionFlag(i)) {
+					if (!first){
 						std::cout << " , ";
 					}
-					std::cout <<it->first;
+					std::cout << selectionIdNames()[i];
+					first = false;
 				}
 			}
 		}
 	
 		inline void clearFlag(std::string _key){
-			_key = MslTools::toUpper(_key);
-			Hash<std::string,bool>::Table::iterator it = selectionFlags.find(_key); 
-
-			if (it != selectionFlags.end()){
-				selectionFlags.erase(it);  
+			clearFlag(findSelectionId(_key));
+		}
+		inline void clearFlag(unsigned int _id){
+			if (_id < selectionBitSize) {
+				selectionBits.reset(_id);
+			} else if (_id < selectionIdNames().size()) {
+				Hash<std::string,bool>::Table::iterator it = selectionFlags.find(selectionIdNames()[_id]); 
+				if (it != selectionFlags.end()){
+					selectionFlags.erase(it);  
+				}
 			}
 		}
 
 		inline void clearAllFlags(){
+			selectionBits.reset();
 			selectionFlags.clear();
 		}
 		
 
 	private:
 		T *ptTObj;
-		std::map<std::string,std::string (T::*)() const> keyValuePairStrings;
-		std::map<std::string,Real (T::*)() const>   keyValuePairReals;
-		std::map<std::string,int (T::*)() const>    keyValuePairInts;
-		std::map<std::string,bool (T::*)() const>   keyValuePairBools;
 
-		std::map<std::string,bool (T::*)(std::string)>   keyValuePairQueryBools;
+		/*
+		  The keyword functions are the same for all objects of type T:
+		  the tables are shared (like the selection registry below) so
+		  that constructing an object does not rebuild them
+		 */
+		static inline std::map<std::string,std::string (T::*)() const> & keyValuePairStrings() {
+			static std::map<std::string,std::string (T::*)() const> table;
+			return table;
+		}
+		static inline std::map<std::string,Real (T::*)() const> & keyValuePairReals() {
+			static std::map<std::string,Real (T::*)() const> table;
+			return table;
+		}
+		static inline std::map<std::string,int (T::*)() const> & keyValuePairInts() {
+			static std::map<std::string,int (T::*)() const> table;
+			return table;
+		}
+		static inline std::map<std::string,bool (T::*)() const> & keyValuePairBools() {
+			static std::map<std::string,bool (T::*)() const> table;
+			return table;
+		}
+		static inline std::map<std::string,bool (T::*)(std::string)> & keyValuePairQueryBools() {
+			static std::map<std::string,bool (T::*)(std::string)> table;
+			return table;
+		}
+		static inline Hash<std::string,std::string>::Table & validKeywords() {
+			static Hash<std::string,std::string>::Table table;
+			return table;
+		}
+
+		std::bitset<selectionBitSize> selectionBits; // flags of the first selectionBitSize selection ids
+		Hash<std::string,bool>::Table selectionFlags; // flags of the selection ids beyond selectionBitSize
 
-		Hash<std::string,std::string>::Table validKeywords;
-		Hash<std::string,bool>::Table selectionFlags;
+		// the registry of the selection names, shared by all objects of type T
+		static inline std::map<std::string,unsigned int> & selectionIdTable() {
+			static std::map<std::string,unsigned int> table;
+			return table;
+		}
+		static inline std::vector<std::string> & selectionIdNames() {
+			static std::vector<std::string> names;
+			return names;
+		}
 
 
 #ifdef __BOOST__		
 		friend class boost::serialization::access;		
 
 
-		template<class Archive> inline void serialize(Archive & ar, const unsigned int version){
+		// the selection ids are only valid within a process, the flags are archived by name
+		template<class Archive> inline void save(Archive & ar, const unsigned int version) const {
 			ar & ptTObj;
-			ar & keyValuePairStrings;
-			ar & keyValuePairReals;
-			ar & keyValuePairInts; 
-			ar & keyValuePairBools;
-
-			ar & validKeywords;
-			ar & selectionFlags;
+			ar & keyValuePairStrings();
+			ar & keyValuePairReals();
+			ar & keyValuePairInts(); 
+			ar & keyValuePairBools();
+
+			ar & validKeywords();
+			Hash<std::string,bool>::Table flags;
+			for (unsigned int i=0; i < selectionIdNames().size(); i++) {
+				if (getSelectionFlag(i)) {
+					flags[selectionIdNames()[i]] = true;
+				}
+			}
+			ar & flags;
+		}
+		template<class Archive> inline void load(Archive & ar, const unsigned int version){
+			ar & ptTObj;
+			ar & keyValuePairStrings();
+			ar & keyValuePairReals();
+			ar & keyValuePairInts(); 
+			ar & keyValuePairBools();
+
+			ar & validKeywords();
+			Hash<std::string,bool>::Table flags;
+			ar & flags;
+			clearAllFlags();
+			for (Hash<std::string,bool>::Table::iterator it = flags.begin(); it != flags.end(); it++) {
+				setSelectionFlag(it->first, it->second);
+			}
 		}
+		BOOST_SERIALIZATION_SPLIT_MEMBER()
 #endif
 		
 };
@@ -31,10 +31,6 @@ You should have received a copy of the GNU Lesser General Public
 #include "SelfConsistentMeanField.h"
 
 SelfConsistentMeanField::SelfConsistentMeanField() {
-	pFixed = NULL;
-	pSelfE = NULL;
-	pPairE = NULL;
-	pBaseLines = NULL;
 	setup();
 }
 
@@ -58,6 +54,11 @@ SelfConsistentMeanField::SelfConsistentMeanField(double & _fixEnergy, vector<vec
 	setEnergyTables(&_fixEnergy, &_selfEnergies, &_pairEnergies, &_baselines);
 }
 
+SelfConsistentMeanField::SelfConsistentMeanField(EnergyTable & _table) {
+	setup();
+	setEnergyTable(NULL, &_table, NULL);
+}
+
 SelfConsistentMeanField::~SelfConsistentMeanField() {
 	deletePointers();
 }
@@ -131,16 +132,49 @@ void SelfConsistentMeanField::setEnergyTables(double * _pFixEnergy, vector<vecto
 	}
 
 	/*******************************************************
-	 *  ASSIGN THE POINTERS
+	 *  COPY INTO THE FLAT TABLE AND ASSIGN THE POINTERS
+	 *  (THE PAIRS OF POSITIONS WITH ALL ZERO ENERGIES ARE
+	 *  NOT STORED)
 	 *******************************************************/
-	pSelfE = _pSelfEnergies;
-	pPairE = _pPairEnergies;
+	ownedTable.setTables(*_pSelfEnergies, *_pPairEnergies, false, true);
+	pTable = &ownedTable;
+	pFixed = _pFixEnergy;
+	pBaseLines = _pBaselines;
+	initialize();
+}
+
+void SelfConsistentMeanField::setEnergyTable(double * _pFixEnergy, EnergyTable * _pTable, vector<vector<double> > * _pBaselines) {
+	if (_pTable == NULL) {
+		cerr << "ERROR 7140: null pointer for the energy table in void SelfConsistentMeanField::setEnergyTable(double * _pFixEnergy, EnergyTable * _pTable, vector<vector<double> > * _pBaselines)" << endl;
+		exit(7140);
+	}
+	if (_pTable->getNumberOfPositions() == 0) {
+		cerr << "ERROR 7146: the energy table has zero size in void SelfConsistentMeanField::setEnergyTable(double * _pFixEnergy, EnergyTable * _pTable, vector<vector<double> > * _pBaselines)" << endl;
+		exit(7146);
+	}
+	if (_pBaselines != NULL) {
+	       	if (_pBaselines->size() != _pTable->getNumberOfPositions()) {
+			cerr << "ERROR 7161: the baseline table (" << _pBaselines->size() << ") has different size than the energy table (" << _pTable->getNumberOfPositions() << ") in void SelfConsistentMeanField::setEnergyTable(double * _pFixEnergy, EnergyTable * _pTable, vector<vector<double> > * _pBaselines)" << endl;
+			exit(7161);
+		}
+		for (int i=0; i<_pTable->getNumberOfPositions(); i++) {
+			if (_pTable->getNumberOfRotamers(i) != (*_pBaselines)[i].size()) {
+				cerr << "ERROR 7164: at position " << i << " the baseline table (" << (*_pBaselines)[i].size() << ") has different size than the energy table (" << _pTable->getNumberOfRotamers(i) << ") in void SelfConsistentMeanField::setEnergyTable(double * _pFixEnergy, EnergyTable * _pTable, vector<vector<double> > * _pBaselines)" << endl;
+				exit(7164);
+			}
+		}
+	}
+	ownedTable.clear();
+	pTable = _pTable;
 	pFixed = _pFixEnergy;
 	pBaseLines = _pBaselines;
 	initialize();
 }
 
 void SelfConsistentMeanField::setup() {
+	pFixed = NULL;
+	pTable = NULL;
+	pBaseLines = NULL;
 	T = 298.0; 
 	RT = MslTools::R * T;
 	lambda = 0.9;
@@ -178,9 +212,9 @@ void SelfConsistentMeanField::initializeProbs() {
 	selfConsE.clear();
 	cycleCounter = 0;
 	currentState.clear();
-	//cout << "UUUQ pSelfE size " << pSelfE->size() << endl;
-	for (int i=0; i<pSelfE->size(); i++) {
-		//cout << "UUUQ pSelfE[" << i << "] size " << (*pSelfE)[i].size() << endl;
+	//cout << "UUUQ pSelfE size " << pTable->getNumberOfPositions() << endl;
+	for (int i=0; i<pTable->getNumberOfPositions(); i++) {
+		//cout << "UUUQ pSelfE[" << i << "] size " << pTable->getNumberOfRotamers(i) << endl;
 		// count the number of alive rotamers
 		int aliveRots = 0;
 		for (unsigned int j=0; j<mask[i].size(); j++) {
@@ -192,9 +226,9 @@ void SelfConsistentMeanField::initializeProbs() {
 			cerr << "ERROR 54912: no available state in mask in void SelfConsistentMeanField::initialize()" << endl;
 			exit(54912);
 		}
-		//int aliveRots = (*pSelfE)[i].size();
+		//int aliveRots = pTable->getNumberOfRotamers(i);
 		// assign a default 1/num_of_rots probability to everything (including the dead ones)
-		p.push_back(vector<double>((*pSelfE)[i].size(), (double)1/(double)aliveRots));
+		p.push_back(vector<double>(pTable->getNumberOfRotamers(i), (double)1/(double)aliveRots));
 		// zero the dead rots
 		for (unsigned int j=0; j<mask[i].size(); j++) {
 			//cout << "UUUQ " << i << endl;
@@ -203,7 +237,7 @@ void SelfConsistentMeanField::initializeProbs() {
 			}
 			//cout << "  UUUQ " << i << " " << j << " " << p[i][j] << endl;
 		}
-		selfConsE.push_back(vector<double>((*pSelfE)[i].size(), 0.0));
+		selfConsE.push_back(vector<double>(pTable->getNumberOfRotamers(i), 0.0));
 		currentState.push_back(-1);
 	}
 	//for (unsigned int i=0; i<p.size(); i++) {
@@ -215,18 +249,18 @@ void SelfConsistentMeanField::initializeProbs() {
 
 void SelfConsistentMeanField::initializeMask() {
 	mask.clear();
-	for (int i=0; i<pSelfE->size(); i++) {
-		int rots = (*pSelfE)[i].size();
+	for (int i=0; i<pTable->getNumberOfPositions(); i++) {
+		int rots = pTable->getNumberOfRotamers(i);
 		mask.push_back(vector<bool>(rots, true));
 	}
 }
 
 void SelfConsistentMeanField::setMask(vector<vector<bool> > _mask) {
-	if (pSelfE->size() != _mask.size()) {
+	if (pTable->getNumberOfPositions() != _mask.size()) {
 		// ERROR
 	}
-	for (unsigned int i=0; i<pSelfE->size(); i++) {
-		if ((*pSelfE)[i].size() != _mask[i].size()) {
+	for (unsigned int i=0; i<pTable->getNumberOfPositions(); i++) {
+		if (pTable->getNumberOfRotamers(i) != _mask[i].size()) {
 			// ERROR
 		}
 	}
@@ -260,7 +294,7 @@ void SelfConsistentMeanField::readMaskFromFile(string _filename) {
 		exit(2846);
 	}
 	expectedSize += sizeof(int);
-	if (size != pSelfE->size()) {
+	if (size != pTable->getNumberOfPositions()) {
 		cerr << "ERROR 2849: unmatching size of mask table in file " << _filename << " in void SelfConsistentMeanField::readMaskFromFile(string _filename)" << endl;
 		exit(2849);
 	}
@@ -273,7 +307,7 @@ void SelfConsistentMeanField::readMaskFromFile(string _filename) {
 			exit(2853);
 		}
 		expectedSize += sizeof(int);
-		if (size2 != (*pSelfE)[i].size()) {
+		if (size2 != pTable->getNumberOfRotamers(i)) {
 			cerr << "ERROR 2857: unmatching size of mask table in file " << _filename << " in void SelfConsistentMeanField::readMaskFromFile(string _filename)" << endl;
 			exit(2857);
 		}
@@ -331,27 +365,30 @@ void SelfConsistentMeanField::cycle() {
 	 *  Calculate the new average energy of the rotames, based
 	 *  on the current probabilities
 	 ************************************************/
-	for (int i=0; i<pSelfE->size(); i++) {
-		for (int ir=0; ir<(*pSelfE)[i].size(); ir++) {
+	for (int i=0; i<pTable->getNumberOfPositions(); i++) {
+		for (int ir=0; ir<pTable->getNumberOfRotamers(i); ir++) {
 			if (mask[i][ir]) {
 				if (pBaseLines != NULL) {
-					selfConsE[i][ir] = (*pBaseLines)[i][ir] + (*pSelfE)[i][ir];
+					selfConsE[i][ir] = (*pBaseLines)[i][ir] + pTable->getSelfEnergy(i, ir);
 				} else {
-					selfConsE[i][ir] = (*pSelfE)[i][ir];
+					selfConsE[i][ir] = pTable->getSelfEnergy(i, ir);
 				}
 			} else {
 				selfConsE[i][ir] = 1e+100;
 			}
 		}
 	}
-	for (int i=0; i<pPairE->size(); i++) {
-		for (int j=0; j<i; j++) {
-			for (int ir=0; ir<(*pPairE)[i].size(); ir++) {
+	for (int i=0; i<pTable->getNumberOfPositions(); i++) {
+		// only the positions stored in the table interact (the neighbors are sorted)
+		const vector<unsigned int> & neighbors = pTable->getNeighbors(i);
+		for (unsigned int n=0; n<neighbors.size() && neighbors[n]<i; n++) {
+			int j = neighbors[n];
+			for (int ir=0; ir<pTable->getNumberOfRotamers(i); ir++) {
 				if (mask[i][ir]) {
-					for (int jr=0; jr<(*pPairE)[j].size(); jr++) {
+					for (int jr=0; jr<pTable->getNumberOfRotamers(j); jr++) {
 						if (mask[j][jr]) {
-							selfConsE[i][ir] += p[j][jr] * (*pPairE)[i][ir][j][jr];
-							selfConsE[j][jr] += p[i][ir] * (*pPairE)[i][ir][j][jr];
+							selfConsE[i][ir] += p[j][jr] * pTable->getPairEnergy(i, ir, j, jr);
+							selfConsE[j][jr] += p[i][ir] * pTable->getPairEnergy(i, ir, j, jr);
 						}
 					}
 				}
@@ -589,17 +626,18 @@ double SelfConsistentMeanField::getStateEnergy(vector<unsigned int> _state) cons
 		energy += *pFixed;
 	}
 	
-	for (int i=0; i<pSelfE->size(); i++) {
+	for (int i=0; i<pTable->getNumberOfPositions(); i++) {
 		if (pBaseLines != NULL) {
-			energy += (*pBaseLines)[i][_state[i]] + (*pSelfE)[i][_state[i]];
+			energy += (*pBaseLines)[i][_state[i]] + pTable->getSelfEnergy(i, _state[i]);
 		} else {
-			energy += (*pSelfE)[i][_state[i]];
+			energy += pTable->getSelfEnergy(i, _state[i]);
 		}
 	}
 			
-	for (int i=0; i<pPairE->size(); i++) {
-		for (int j=0; j<i; j++) {
-			energy += (*pPairE)[i][_state[i]][j][_state[j]];
+	for (int i=0; i<pTable->getNumberOfPositions(); i++) {
+		const vector<unsigned int> & neighbors = pTable->getNeighbors(i);
+		for (unsigned int n=0; n<neighbors.size() && neighbors[n]<i; n++) {
+			energy += pTable->getPairEnergy(i, _state[i], neighbors[n], _state[neighbors[n]]);
 		}
 	}
 	return energy;
@@ -611,21 +649,23 @@ double SelfConsistentMeanField::getAverageEnergy() {
 		energy += *pFixed;
 	}
 	
-	for (int i=0; i<pSelfE->size(); i++) {
-		for (int ir=0; ir<(*pSelfE)[i].size(); ir++) {
+	for (int i=0; i<pTable->getNumberOfPositions(); i++) {
+		for (int ir=0; ir<pTable->getNumberOfRotamers(i); ir++) {
 			if (pBaseLines != NULL) {
-				energy += p[i][ir] * ((*pBaseLines)[i][ir] + (*pSelfE)[i][ir]);
+				energy += p[i][ir] * ((*pBaseLines)[i][ir] + pTable->getSelfEnergy(i, ir));
 			} else {
-				energy += p[i][ir] * (*pSelfE)[i][ir];
+				energy += p[i][ir] * pTable->getSelfEnergy(i, ir);
 			}
 		}
 	}
 			
-	for (int i=0; i<pPairE->size(); i++) {
-		for (int ir=0; ir<(*pPairE)[i].size(); ir++) {
-			for (int j=0; j<i; j++) {
-				for (int jr=0; jr<(*pPairE)[j].size(); jr++) {
-					energy += p[i][ir] * p[j][jr] * (*pPairE)[i][ir][j][jr];
+	for (int i=0; i<pTable->getNumberOfPositions(); i++) {
+		for (int ir=0; ir<pTable->getNumberOfRotamers(i); ir++) {
+			const vector<unsigned int> & neighbors = pTable->getNeighbors(i);
+			for (unsigned int n=0; n<neighbors.size() && neighbors[n]<i; n++) {
+				int j = neighbors[n];
+				for (int jr=0; jr<pTable->getNumberOfRotamers(j); jr++) {
+					energy += p[i][ir] * p[j][jr] * pTable->getPairEnergy(i, ir, j, jr);
 				}
 			}
 		}
@@ -670,7 +710,7 @@ vector<unsigned int> SelfConsistentMeanField::runMC(double _startingTemperature,
 
 	while (!MCMngr.getComplete()) {
 		// make atleast 1 move and update the current state
-		stateVec = moveRandomState(pRng->getRandomInt(pSelfE->size() - 1) + 1); 
+		stateVec = moveRandomState(pRng->getRandomInt(pTable->getNumberOfPositions() - 1) + 1); 
 		//stateVec = moveRandomState(); 
 		stateP = getStateP(stateVec);
 		if (verbose) {
@@ -40,6 +40,7 @@ You should have received a copy of the GNU Lesser General Public
 
 #include "MslTools.h"
 #include "MonteCarloManager.h"
+#include "EnergyTable.h"
 
 using namespace std;
 using namespace MSL;
@@ -55,6 +56,7 @@ class SelfConsistentMeanField {
 		SelfConsistentMeanField(double & fixEnergy, vector<vector<double> > & selfEnergies, vector<vector<vector<vector<double> > > > & pairEnergies);
 		SelfConsistentMeanField(vector<vector<double> > & _selfEnergies, vector<vector<vector<vector<double> > > > & _pairEnergies, vector<vector<double> > & _baselines);
 		SelfConsistentMeanField(double & _fixEnergy, vector<vector<double> > & _selfEnergies, vector<vector<vector<vector<double> > > > & _pairEnergies, vector<vector<double> > & _baselines);
+		SelfConsistentMeanField(EnergyTable & _table);
 		~SelfConsistentMeanField();
 
 		void setEnergyTables(vector<vector<double> > & _selfEnergies, vector<vector<vector<vector<double> > > > & _pairEnergies);
@@ -62,6 +64,8 @@ class SelfConsistentMeanField {
 		void setEnergyTables(vector<vector<double> > & _selfEnergies, vector<vector<vector<vector<double> > > > & _pairEnergies, vector<vector<double> > & _baselines);
 		void setEnergyTables(double & _fixEnergy, vector<vector<double> > & _selfEnergies, vector<vector<vector<vector<double> > > > & _pairEnergies, vector<vector<double> > & _baselines);
 		void setEnergyTables(double * _pFixEnergy, vector<vector<double> > * _pSelfEnergies, vector<vector<vector<vector<double> > > > * _pPairEnergies, vector<vector<double> > * _pBaselines);
+		// use a flat energy table directly (not copied, the table must outlive the object); _pFixEnergy and _pBaselines can be NULL
+		void setEnergyTable(double * _pFixEnergy, EnergyTable * _pTable, vector<vector<double> > * _pBaselines=NULL);
 
 		//void getExternalRNG(RandomNumberGenerator * _pExternalRNG);
 
@@ -116,8 +120,8 @@ class SelfConsistentMeanField {
 		RandomNumberGenerator * pRng;
 
 		double * pFixed;
-		vector<vector<double> > * pSelfE;
-		vector<vector<vector<vector<double> > > > * pPairE;
+		EnergyTable * pTable;
+		EnergyTable ownedTable; // holds the converted nested tables
 		vector<vector<double> > * pBaseLines;
 		
 
@@ -83,6 +83,9 @@ void SelfPairManager::setup() {
 
 	onTheFly = false; // precompute pair energies by default
 
+	numberOfThreads = 1;
+	sparsePairTable = true;
+
 	// MCO Options
 	mcStartT = 1000.0;
 	mcEndT = 0.5;
@@ -535,449 +538,484 @@ void SelfPairManager::calculateFixedEnergies() {
 
 	}
 }
-void SelfPairManager::calculateSelfEnergies() {
-	selfE.clear();
-	selfEbyTerm.clear();
-	selfCount.clear();
-	selfCountByTerm.clear();
+void SelfPairManager::addMissingWeights() {
+	// the weight map is only read while the tables are built: make
+	// sure that every term has an entry (0.0 as the [] operator would give)
+	for (map<string, vector<Interaction*> >::iterator k=pEnergyTerms->begin(); k!=pEnergyTerms->end(); k++) {
+		if (weights.find(k->first) == weights.end()) {
+			weights[k->first] = 0.0;
+		}
+	}
+}
 
-	//IdRotAbsIndex.clear();
-	vector<unsigned int> rotCoor(3, 0);
+void * SelfPairManager::buildTableBlocks(void * _builder) {
+	TableBuilder * pBuilder = (TableBuilder*)_builder;
+	const vector<TableBlock> & blocks = *(pBuilder->pBlocks);
+	while (true) {
+		unsigned int b = 0;
+		if (pBuilder->pMutex != NULL) {
+			pthread_mutex_lock(pBuilder->pMutex);
+		}
+		b = (*(pBuilder->pNextBlock))++;
+		if (pBuilder->pMutex != NULL) {
+			pthread_mutex_unlock(pBuilder->pMutex);
+		}
+		if (b >= blocks.size()) {
+			break;
+		}
+		if (blocks[b].j == 0) {
+			pBuilder->pManager->calculateSelfBlock(blocks[b].i, blocks[b].ii);
+		} else {
+			pBuilder->pManager->calculatePairBlock(blocks[b].i, blocks[b].ii, blocks[b].j, blocks[b].jj, pBuilder->recalculate);
+		}
+	}
+	return NULL;
+}
 
-	rotamerDescriptors.clear();
-	rotamerPos_Id_Rot.clear();
+void SelfPairManager::runTableBlocks(const vector<TableBlock> & _blocks, bool _recalculate) {
+	/***************************************************************
+	 *  The blocks given cannot share an identity: each thread takes
+	 *  the next block available until they are all done. Every table
+	 *  element is calculated by a single block in the same order as
+	 *  in the serial calculation, therefore the result does not
+	 *  depend on the number of threads
+	 ***************************************************************/
+	unsigned int nextBlock = 0;
+	unsigned int nThreads = numberOfThreads;
+	if (nThreads > _blocks.size()) {
+		nThreads = _blocks.size();
+	}
+	if (nThreads <= 1) {
+		TableBuilder builder;
+		builder.pManager = this;
+		builder.pBlocks = &_blocks;
+		builder.pNextBlock = &nextBlock;
+		builder.pMutex = NULL;
+		builder.recalculate = _recalculate;
+		buildTableBlocks(&builder);
+		return;
+	}
 
+	pthread_mutex_t mutex;
+	pthread_mutex_init(&mutex, NULL);
+	vector<TableBuilder> builders(nThreads);
+	for (unsigned int t=0; t<nThreads; t++) {
+		builders[t].pManager = this;
+		builders[t].pBlocks = &_blocks;
+		builders[t].pNextBlock = &nextBlock;
+		builders[t].pMutex = &mutex;
+		builders[t].recalculate = _recalculate;
+	}
+	vector<void*> args(nThreads);
+	for (unsigned int t=0; t<nThreads; t++) {
+		args[t] = &builders[t];
+	}
+	MslTools::runThreads(buildTableBlocks, args);
+	pthread_mutex_destroy(&mutex);
+}
 
-	/*********************************************************
-	 *  HERE!!!!
-	 *    invert [i][j][ii][jj]
-	 *
-	 *    to [i][ii][j][jj]
-	 *
-	 *
-	 *    DONE?
+void SelfPairManager::runPairTableBlocks(bool _recalculate) {
+	if (numberOfThreads <= 1) {
+		// serial, all pair blocks in table order
+		vector<TableBlock> blocks;
+		for (unsigned int i=1; i<subdividedInteractions.size(); i++) {
+			for (unsigned int ii=0; ii<subdividedInteractions[i].size(); ii++) {
+				for (unsigned int j=1; j<i; j++) {
+					for (unsigned int jj=0; jj<subdividedInteractions[i][ii][j].size(); jj++) {
+						TableBlock block = {i, ii, j, jj};
+						blocks.push_back(block);
+					}
+				}
+			}
+		}
+		runTableBlocks(blocks, _recalculate);
+		return;
+	}
+
+	/***************************************************************
+	 *  Two pair blocks can run at the same time only if they do not
+	 *  share an identity. The identities are paired with a round
+	 *  robin tournament (circle method): in each round every
+	 *  identity appears at most once, and every pair of identities
+	 *  meets in exactly one round. Pairs of identities of the same
+	 *  position are not pair blocks and are skipped.
 	 *
-	 *********************************************************/
-	//cout << "SUBDIV: "<<subdividedInteractions.size()<<endl;
-	// interaction with the fixed atoms
+	 *  With the non bonded cutoffs the interactions call
+	 *  Atom::groupDistance without a stamp, which calculates the
+	 *  group centers without writing the cache of the AtomGroup
+	 ***************************************************************/
+
+	vector<pair<unsigned int, unsigned int> > identities;
 	for (unsigned int i=1; i<subdividedInteractions.size(); i++) {
-		// LOOP LEVEL 1: for each position i
-		selfE.push_back(vector<double>());
+		for (unsigned int ii=0; ii<subdividedInteractions[i].size(); ii++) {
+			identities.push_back(pair<unsigned int, unsigned int>(i, ii));
+		}
+	}
+	unsigned int nNodes = identities.size();
+	if (nNodes % 2 == 1) {
+		// a dummy identity (the one resting in each round)
+		nNodes++;
+	}
+	for (unsigned int round=0; round+1<nNodes; round++) {
+		vector<TableBlock> blocks;
+		for (unsigned int n=0; n<nNodes/2; n++) {
+			unsigned int a = (n == 0) ? 0 : (round + n) % (nNodes - 1) + 1;
+			unsigned int b = (round + nNodes - 1 - n) % (nNodes - 1) + 1;
+			if (a >= identities.size() || b >= identities.size()) {
+				continue;
+			}
+			if (identities[a].first == identities[b].first) {
+				continue;
+			}
+			if (identities[a].first < identities[b].first) {
+				swap(a, b);
+			}
+			TableBlock block = {identities[a].first, identities[a].second, identities[b].first, identities[b].second};
+			blocks.push_back(block);
+		}
+		runTableBlocks(blocks, _recalculate);
+	}
+}
+
+void SelfPairManager::calculateSelfBlock(unsigned int _i, unsigned int _ii) {
+	unsigned int totalConfI = variableIdentities[_i][_ii]->getNumberOfRotamers();
+	unsigned int offset = rotamerOffsets[_i][_ii];
+	for(unsigned int cI = 0; cI < totalConfI; cI++) {
+		// LOOP LEVEL 3: for each conformation  compute selfE and if greater than threshold discard it
+		setIdentityConformation(_i, _ii, cI);
+		double energy = 0;
+		unsigned count = 0;
+		map<string,unsigned int> countByTerm;
+		map<string,double> energyByTerm;
+		for (map<string, vector<Interaction*> >::iterator k=subdividedInteractions[_i][_ii][0][0].begin(); k!= subdividedInteractions[_i][_ii][0][0].end(); k++) {
+
+			// LOOP LEVEL 4 for each energy term
+			if (!pESet->isTermActive(k->first)) {
+				// inactive term
+				continue;
+			}
+			if(saveEbyTerm) {
+				countByTerm[k->first] = k->second.size(); 
+			}
+			count += k->second.size();
+			double E = 0.0;
+			for (vector<Interaction*>::iterator l=k->second.begin(); l!= k->second.end(); l++) {
+				E += (*l)->getEnergy();
+			}
+			E *= weights.find(k->first)->second;
+			energy += E;
+			if(saveEbyTerm) {
+				energyByTerm[k->first] += E; 
+			}
+		}
+
+		// compute energies with self
+		for (map<string, vector<Interaction*> >::iterator k=subdividedInteractions[_i][_ii][_i][0].begin(); k!= subdividedInteractions[_i][_ii][_i][0].end(); k++) {
+			// LOOP LEVEL 4 for each energy term
+			if (!pESet->isTermActive(k->first)) {
+				// inactive term
+				continue;
+			}
+			if(saveEbyTerm) {
+				countByTerm[k->first] += k->second.size(); 
+			}
+			if(saveInteractionCount) {
+				count += k->second.size();
+			}
+			double E = 0.0;
+			for (vector<Interaction*>::iterator l=k->second.begin(); l!= k->second.end(); l++) {
+				E += (*l)->getEnergy();
+			}
+			E *= weights.find(k->first)->second;
+			energy += E;
+			if(saveEbyTerm) {
+				energyByTerm[k->first] += E; 
+			}
+		}
+		energyTable.setSelfEnergy(_i-1, offset + cI, energy);
 		if(saveInteractionCount) {
-			selfCount.push_back(vector<unsigned int>());
+			selfCount[_i-1][offset + cI] = count;
 		}
 		if(saveEbyTerm) {
-			selfEbyTerm.push_back(vector<map<string, double> >());
-			selfCountByTerm.push_back(vector<map<string, unsigned int> >());
+			selfEbyTerm[_i-1][offset + cI] = energyByTerm;
+			selfCountByTerm[_i-1][offset + cI] = countByTerm;
 		}
+	}
+}
 
-		rotamerDescriptors.push_back(vector<string>());
-		rotamerPos_Id_Rot.push_back(vector<vector<unsigned int> >());
+void SelfPairManager::calculatePairBlock(unsigned int _i, unsigned int _ii, unsigned int _j, unsigned int _jj, bool _recalculate) {
+	if (!saveEbyTerm && !saveInteractionCount && onTheFly) {
+		// nothing to precompute
+		return;
+	}
+	unsigned int totalConfI = variableIdentities[_i][_ii]->getNumberOfRotamers();
+	unsigned int totalConfJ = variableIdentities[_j][_jj]->getNumberOfRotamers();
+	map<string, vector<Interaction*> > & interactions = subdividedInteractions[_i][_ii][_j][_jj];
+	if (interactions.empty() && !_recalculate) {
+		// the two identities do not interact, the entries are already zero
+		return;
+	}
+	bool changeConformations = !interactions.empty();
 
-		unsigned overallConfI = 0;
-		//cout << "\tSUBDIV: "<<subdividedInteractions[i].size()<<endl;
-		for (unsigned int ii=0; ii<subdividedInteractions[i].size(); ii++) {
-			// LOOP LEVEL 2: for each identity ii at position i
+	for (unsigned int cI=0; cI<totalConfI; cI++) {
+		//  LOOP LEVEL 3: for each rotamer of pos/identity i/ii 
+		if (changeConformations) {
+			setIdentityConformation(_i, _ii, cI);
+		}
+		unsigned int rotI = rotamerOffsets[_i][_ii] + cI;
 
-			unsigned int totalConfI = variableIdentities[i][ii]->getNumberOfRotamers();
-			string chain = variableIdentities[i][ii]->getChainId();
-			string resName = variableIdentities[i][ii]->getResidueName();
-			int resNum = variableIdentities[i][ii]->getResidueNumber();
-			string iCode = variableIdentities[i][ii]->getResidueIcode();
-			unsigned int posIndex = variablePosIndex[variablePositions[i]];
-			//cout << "Position: "<<resNum<<" "<<resName<<endl;
-			//cout << "\t\tRotamers: "<<totalConfI<<endl;
-			for (unsigned int cI=0; cI<totalConfI; cI++) {
-				char c [1000];
-				// TO DO: adde the linked to the string
-				sprintf(c, "Position %1s %4d%1s (%4u), identity %-4s (%2u), rotamer %3u (%3u)", chain.c_str(), resNum, iCode.c_str(), posIndex, resName.c_str(), ii, cI, overallConfI + cI);
-				rotamerDescriptors[i-1].push_back((string)c);
-				rotamerPos_Id_Rot[i-1].push_back(vector<unsigned int>());
-				rotamerPos_Id_Rot[i-1].back().push_back(posIndex);
-				rotamerPos_Id_Rot[i-1].back().push_back(ii);
-				rotamerPos_Id_Rot[i-1].back().push_back(cI);
+		for (unsigned int cJ=0; cJ<totalConfJ; cJ++) {
+			//  LOOP LEVEL 6: for each rotamer of pos/identity j/jj 
+			if (changeConformations) {
+				setIdentityConformation(_j, _jj, cJ);
+			}
+			unsigned int rotJ = rotamerOffsets[_j][_jj] + cJ;
 
+			if (_recalculate && pairEFlag[_i-1][rotI][_j-1][rotJ]) {
+				// saved energy
+				continue;
 			}
+			double pairEnergy = 0.0;
 
-			for(unsigned int cI = 0; cI < totalConfI; cI++) {
-				// LOOP LEVEL 3: for each conformation  compute selfE and if greater than threshold discard it
-				variableIdentities[i][ii]->setActiveConformation(cI);
-			//	cout << "UUU " << i << " " << slaveIdentities.size() << endl;
-			//	cout << "  UUU " << ii << " " << slaveIdentities[i].size() << endl;
-				for (unsigned int iii=0; iii<slaveIdentities[i][ii].size(); iii++) {
-					slaveIdentities[i][ii][iii]->setActiveConformation(cI);
+			// finally calculate the energies
+			for (map<string, vector<Interaction*> >::iterator k=interactions.begin(); k!= interactions.end(); k++) {
+				if (!pESet->isTermActive(k->first)) {
+					// inactive term
+					continue;
 				}
-				double energy = 0;
-				unsigned count = 0;
-				map<string,unsigned int> countByTerm;
-				map<string,double> energyByTerm;
-				for (map<string, vector<Interaction*> >::iterator k=subdividedInteractions[i][ii][0][0].begin(); k!= subdividedInteractions[i][ii][0][0].end(); k++) {
-
-					// LOOP LEVEL 4 for each energy term
-					if (!pESet->isTermActive(k->first)) {
-						// inactive term
-						continue;
-					}
-					if(saveEbyTerm) {
-						countByTerm[k->first] = k->second.size(); 
-					}
-					count += k->second.size();
-					double E = 0.0;
-					for (vector<Interaction*>::iterator l=k->second.begin(); l!= k->second.end(); l++) {
-						E += (*l)->getEnergy();
-						//double e = (*l)->getEnergy();
-						//energy += e;
-						//if(saveEbyTerm) {
-						//	energyByTerm[k->first] += e; 
-						//}
-					}
-					E *= weights[k->first];
-					energy += E;
-					if(saveEbyTerm) {
-						energyByTerm[k->first] += E; 
+				if(saveInteractionCount && !_recalculate) {
+					pairCount[_i-1][rotI][_j-1][rotJ] += k->second.size();
+				}
+				if(saveEbyTerm) {
+					pairEbyTerm[_i-1][rotI][_j-1][rotJ][k->first] = 0;
+					if (!_recalculate) {
+						pairCountByTerm[_i-1][rotI][_j-1][rotJ][k->first] = k->second.size();
 					}
 				}
 
-				// compute energies with self
-				for (map<string, vector<Interaction*> >::iterator k=subdividedInteractions[i][ii][i][0].begin(); k!= subdividedInteractions[i][ii][i][0].end(); k++) {
-					// LOOP LEVEL 4 for each energy term
-					if (!pESet->isTermActive(k->first)) {
-						// inactive term
-						continue;
-					}
-					if(saveEbyTerm) {
-						countByTerm[k->first] += k->second.size(); 
-					}
-					if(saveInteractionCount) {
-						count += k->second.size();
-					}
+				if(!onTheFly) {
 					double E = 0.0;
 					for (vector<Interaction*>::iterator l=k->second.begin(); l!= k->second.end(); l++) {
 						E += (*l)->getEnergy();
-						//double e = (*l)->getEnergy();
-						//energy += e;
-						//if(saveEbyTerm) {
-						//	energyByTerm[k->first] += e; 
-						//}
 					}
-					E *= weights[k->first];
-					energy += E;
+					E *= weights.find(k->first)->second;
+					pairEnergy += E;
 					if(saveEbyTerm) {
-						energyByTerm[k->first] += E; 
+						pairEbyTerm[_i-1][rotI][_j-1][rotJ][k->first] += E;
 					}
 				}
-				//cout << "\t\t\tENERGY["<<selfE.size()-1<<"]["<<selfE.back().size()+1<<"]: "<<energy<<endl;
-				selfE.back().push_back(energy);
-				if(saveInteractionCount) {
-					selfCount.back().push_back(count);
-				}
-				if(saveEbyTerm) {
-					selfEbyTerm.back().push_back(energyByTerm);
-					selfCountByTerm.back().push_back(countByTerm);
-				}
 			}
-			overallConfI += totalConfI;
+			energyTable.setPairEnergy(_i-1, rotI, _j-1, rotJ, pairEnergy);
 		}
 	}
-
 }
-void SelfPairManager::recalculateNonSavedPairEnergies(vector<vector<vector<vector<bool> > > > savedPairEnergies) {
-	pairEFlag = savedPairEnergies;
 
+void SelfPairManager::calculateSelfEnergies() {
+	selfEbyTerm.clear();
+	selfCount.clear();
+	selfCountByTerm.clear();
+
+	//IdRotAbsIndex.clear();
+	vector<unsigned int> rotCoor(3, 0);
+
+	rotamerDescriptors.clear();
+	rotamerPos_Id_Rot.clear();
+	rotamerOffsets.clear();
+	addMissingWeights();
+
+	// allocate the tables and the descriptors, the energies are calculated by blocks
+	vector<TableBlock> blocks;
+	vector<unsigned int> rotamers;
 	for (unsigned int i=1; i<subdividedInteractions.size(); i++) {
 		// LOOP LEVEL 1: for each position i
-		unsigned int rotI = -1;
+		rotamerDescriptors.push_back(vector<string>());
+		rotamerPos_Id_Rot.push_back(vector<vector<unsigned int> >());
+		rotamerOffsets.push_back(vector<unsigned int>());
 
+		unsigned overallConfI = 0;
 		for (unsigned int ii=0; ii<subdividedInteractions[i].size(); ii++) {
 			// LOOP LEVEL 2: for each identity ii at position i
 
-			// get the number of rotamer for the position and their particular identity
-			unsigned int totalConfI = 1;
-			// a self or a pair interaction
-			totalConfI = variableIdentities[i][ii]->getNumberOfRotamers();
-			// set the i/ii-th residue the initial rotamer
-			variableIdentities[i][ii]->setActiveConformation(0);
-			for (unsigned int iii=0; iii<slaveIdentities[i][ii].size(); iii++) {
-				slaveIdentities[i][ii][iii]->setActiveConformation(0);
-			}
-
+			unsigned int totalConfI = variableIdentities[i][ii]->getNumberOfRotamers();
 			string chain = variableIdentities[i][ii]->getChainId();
 			string resName = variableIdentities[i][ii]->getResidueName();
+			int resNum = variableIdentities[i][ii]->getResidueNumber();
 			string iCode = variableIdentities[i][ii]->getResidueIcode();
-
+			unsigned int posIndex = variablePosIndex[variablePositions[i]];
 			for (unsigned int cI=0; cI<totalConfI; cI++) {
-				//  LOOP LEVEL 3: for each rotamer of pos/identity i/ii 
-
-				rotI++;
-				if (cI > 0) {
-					// change the rotamer of i/ii
-					variableIdentities[i][ii]->setActiveConformation(cI);
-					for (unsigned int iii=0; iii<slaveIdentities[i][ii].size(); iii++) {
-						slaveIdentities[i][ii][iii]->setActiveConformation(cI);
-					}
-				}
-
-				for (unsigned int j=1; j<subdividedInteractions[i][ii].size(); j++) {
-					// LOOP LEVEL 4: for each position j
-
-					if (j == i ) {
-						continue; // self
-					}
-
-					unsigned int rotJ = -1;
-					for (unsigned int jj=0; jj<subdividedInteractions[i][ii][j].size(); jj++) {
-						// LOOP LEVEL 5: for each identity jj
-
-						// get the number of rotamer for the position and their particular identity
-						unsigned int totalConfJ = variableIdentities[j][jj]->getNumberOfRotamers();
-						// set the j/jj-th residue the initial rotamer
-						variableIdentities[j][jj]->setActiveConformation(0);
-						for (unsigned int jjj=0; jjj<slaveIdentities[j][jj].size(); jjj++) {
-							slaveIdentities[j][jj][jjj]->setActiveConformation(0);
-						}
-
-						for (unsigned int cJ=0; cJ<totalConfJ; cJ++) {
-							//  LOOP LEVEL 6: for each rotamer of pos/identity j/jj 
-
-							rotJ++;
+				char c [1000];
+				// TO DO: adde the linked to the string
+				sprintf(c, "Position %1s %4d%1s (%4u), identity %-4s (%2u), rotamer %3u (%3u)", chain.c_str(), resNum, iCode.c_str(), posIndex, resName.c_str(), ii, cI, overallConfI + cI);
+				rotamerDescriptors[i-1].push_back((string)c);
+				rotamerPos_Id_Rot[i-1].push_back(vector<unsigned int>());
+				rotamerPos_Id_Rot[i-1].back().push_back(posIndex);
+				rotamerPos_Id_Rot[i-1].back().push_back(ii);
+				rotamerPos_Id_Rot[i-1].back().push_back(cI);
 
-							if (cJ > 0) {
-								// change the rotamer of j/jj
-								variableIdentities[j][jj]->setActiveConformation(cJ);
-								for (unsigned int jjj=0; jjj<slaveIdentities[j][jj].size(); jjj++) {
-									slaveIdentities[j][jj][jjj]->setActiveConformation(cJ);
-								}
-							}
+			}
+			rotamerOffsets[i-1].push_back(overallConfI);
+			TableBlock block = {i, ii, 0, 0};
+			blocks.push_back(block);
+			overallConfI += totalConfI;
+		}
 
-							if((saveEbyTerm || saveInteractionCount || !onTheFly) && !pairEFlag[i-1][rotI][j-1][rotJ]) {	
-								// finally calculate the energies
-								pairE[i-1][rotI][j-1][rotJ] = 0.0;
+		rotamers.push_back(overallConfI);
+		if(saveInteractionCount) {
+			selfCount.push_back(vector<unsigned int>(overallConfI, 0));
+		}
+		if(saveEbyTerm) {
+			selfEbyTerm.push_back(vector<map<string, double> >(overallConfI));
+			selfCountByTerm.push_back(vector<map<string, unsigned int> >(overallConfI));
+		}
+	}
+	// the offsets are indexed by position like subdividedInteractions
+	rotamerOffsets.insert(rotamerOffsets.begin(), vector<unsigned int>());
 
-								for (map<string, vector<Interaction*> >::iterator k=subdividedInteractions[i][ii][j][jj].begin(); k!= subdividedInteractions[i][ii][j][jj].end(); k++) {
-									if (!pESet->isTermActive(k->first)) {
-										// inactive term
-										continue;
-									}
-									if (saveEbyTerm) {
-										pairEbyTerm[i-1][rotI][j-1][rotJ][k->first] = 0.0;
-									}
+	updateEnergyTable(rotamers, false);
 
-									if(!onTheFly) {
-										double E = 0.0;
+	// self blocks never share an identity
+	runTableBlocks(blocks, false);
+}
 
-										for (vector<Interaction*>::iterator l=k->second.begin(); l!= k->second.end(); l++) {
-											E += (*l)->getEnergy();
-										}
-										E *= weights[k->first];
-										pairE[i-1][rotI][j-1][rotJ] += E;
-										if(saveEbyTerm) {
-											pairEbyTerm[i-1][rotI][j-1][rotJ][k->first] += E;
-										}
-									}
-								}
-								//cout << "N " << i-1 << " " << rotI << " " << j-1 << " " << rotJ << " : " << pairE[i-1][rotI][j-1][rotJ] << endl;
-							}
-							//else { 
-							//	cout << "S " << i-1 << " " << rotI << " " << j-1 << " " << rotJ << " : " << pairE[i-1][rotI][j-1][rotJ] << endl;
-							//}
+void SelfPairManager::updateEnergyTable(const vector<unsigned int> & _rotamers, bool _clearPairs) {
+	// the pair energies are kept (for recalculateNonSavedPairEnergies) unless
+	// cleared or the number of rotamers has changed, the self energies are
+	// kept unless the number of rotamers has changed
+	const vector<unsigned int> & rotamers = _rotamers;
+	vector<vector<double> > selfEnergies;
+	if (rotamers == energyTable.getNumberOfRotamers()) {
+		for (unsigned int i=0; i<rotamers.size(); i++) {
+			selfEnergies.push_back(vector<double>(rotamers[i], 0.0));
+			for (unsigned int j=0; j<rotamers[i]; j++) {
+				selfEnergies[i][j] = energyTable.getSelfEnergy(i, j);
+			}
+		}
+	}
+	vector<vector<bool> > interacting;
+	findInteractingPairs(interacting);
+	if (_clearPairs || rotamers != energyTable.getNumberOfRotamers()) {
+		energyTable.resize(rotamers, interacting);
+	} else {
+		// keep the stored pairs, add the new interacting pairs
+		bool missing = false;
+		for (unsigned int i=0; i<interacting.size(); i++) {
+			for (unsigned int j=0; j<i; j++) {
+				if (energyTable.isPairStored(i, j)) {
+					interacting[i][j] = true;
+				} else if (interacting[i][j]) {
+					missing = true;
+				}
+			}
+		}
+		if (missing) {
+			EnergyTable newTable;
+			newTable.resize(rotamers, interacting);
+			for (unsigned int i=0; i<rotamers.size(); i++) {
+				for (unsigned int ir=0; ir<rotamers[i]; ir++) {
+					for (unsigned int j=0; j<i; j++) {
+						for (unsigned int jr=0; jr<rotamers[j]; jr++) {
+							newTable.setPairEnergy(i, ir, j, jr, energyTable.getPairEnergy(i, ir, j, jr));
 						}
 					}
 				}
 			}
+			energyTable = newTable;
 		}
 	}
-	
-	/*
-	//cout << "UUU Fixed Energy: " << fixE << " (" << fixCount << ") " <<pairE.size()<<" "<<selfE.size()<<" "<<selfCount.size()<< endl;
-	for (unsigned int i=0; i<pairE.size(); i++) {
-		for (unsigned int j=0; j<pairE[i].size(); j++) {
-		        //cout << "UUU Self Energy " << i << "/" << j << ": " << selfE[i][j] << endl;//" (" << selfCount[i][j] << ")" << endl;
-			for (unsigned int k=0; k<pairE[i][j].size(); k++) {
-				for (unsigned int l=0; l<pairE[i][j][k].size(); l++) {
-				  cout << "UUU Pair Energy " << i << "/" << j << " - " << k << "/" << l << ": " << pairE[i][j][k][l] <<endl;  //<< " (" << pairCount[i][j][k][l] << ")" << endl;
-				  energySum += pairE[i][j][k][l];
+	for (unsigned int i=0; i<selfEnergies.size(); i++) {
+		for (unsigned int j=0; j<selfEnergies[i].size(); j++) {
+			energyTable.setSelfEnergy(i, j, selfEnergies[i][j]);
+		}
+	}
+}
+
+void SelfPairManager::findInteractingPairs(vector<vector<bool> > & _interacting) const {
+	// with the sparse table the pairs of positions that have no interaction between
+	// any of their identities (for example beyond the non bonded cutoff) are not stored
+	_interacting.clear();
+	for (unsigned int i=1; i<subdividedInteractions.size(); i++) {
+		_interacting.push_back(vector<bool>(i-1, !sparsePairTable));
+		if (!sparsePairTable) {
+			continue;
+		}
+		for (unsigned int j=1; j<i; j++) {
+			for (unsigned int ii=0; ii<subdividedInteractions[i].size() && !_interacting[i-1][j-1]; ii++) {
+				for (unsigned int jj=0; jj<subdividedInteractions[i][ii][j].size() && !_interacting[i-1][j-1]; jj++) {
+					const map<string, vector<Interaction*> > & interactions = subdividedInteractions[i][ii][j][jj];
+					for (map<string, vector<Interaction*> >::const_iterator k=interactions.begin(); k!=interactions.end(); k++) {
+						if (!k->second.empty()) {
+							_interacting[i-1][j-1] = true;
+							break;
+						}
+					}
 				}
 			}
 		}
 	}
-	*/
+}
 
+void SelfPairManager::recalculateNonSavedPairEnergies(vector<vector<vector<vector<bool> > > > savedPairEnergies) {
+	pairEFlag = savedPairEnergies;
+	addMissingWeights();
+	runPairTableBlocks(true);
 }
 
 void SelfPairManager::calculatePairEnergies() {
 
-	pairE.clear();
+	// a copy, the table is resized
+	vector<unsigned int> rotamers = energyTable.getNumberOfRotamers();
+	updateEnergyTable(rotamers, true);
 	pairEFlag.clear();
 	pairEbyTerm.clear();
 	pairCount.clear();
 	pairCountByTerm.clear();
+	addMissingWeights();
 
+	// allocate the tables, the energies are calculated by blocks
 	for (unsigned int i=1; i<subdividedInteractions.size(); i++) {
 		// LOOP LEVEL 1: for each position i
+		unsigned int totalRotI = energyTable.getNumberOfRotamers(i-1);
+		vector<unsigned int> totalRotJ;
+		for (unsigned int j=1; j<i; j++) {
+			totalRotJ.push_back(energyTable.getNumberOfRotamers(j-1));
+		}
 
-		// not a fixed energy, increment the tables
-		pairE.push_back(vector<vector<vector<double> > >());
 		if(onTheFly) {
-			pairEFlag.push_back(vector<vector<vector<bool> > >());
+			pairEFlag.push_back(vector<vector<vector<bool> > >(totalRotI));
 		}
-
 		if(saveInteractionCount) {
-			pairCount.push_back(vector<vector<vector<unsigned int> > >());
+			pairCount.push_back(vector<vector<vector<unsigned int> > >(totalRotI));
 		}
-
 		if(saveEbyTerm) {
-			pairEbyTerm.push_back(vector<vector<vector<map<string, double> > > >());
-			pairCountByTerm.push_back(vector<vector<vector<map<string, unsigned int> > > >());
+			pairEbyTerm.push_back(vector<vector<vector<map<string, double> > > >(totalRotI));
+			pairCountByTerm.push_back(vector<vector<vector<map<string, unsigned int> > > >(totalRotI));
 		}
-		
-		unsigned int rotI = -1;
-		unsigned int overallConfI = 0;
-		for (unsigned int ii=0; ii<subdividedInteractions[i].size(); ii++) {
-			// LOOP LEVEL 2: for each identity ii at position i
-
-			// get the number of rotamer for the position and their particular identity
-			unsigned int totalConfI = 1;
-			// a self or a pair interaction
-			totalConfI = variableIdentities[i][ii]->getNumberOfRotamers();
-			// set the i/ii-th residue the initial rotamer
-			variableIdentities[i][ii]->setActiveConformation(0);
-			for (unsigned int iii=0; iii<slaveIdentities[i][ii].size(); iii++) {
-				slaveIdentities[i][ii][iii]->setActiveConformation(0);
-			}
-
-			string chain = variableIdentities[i][ii]->getChainId();
-			string resName = variableIdentities[i][ii]->getResidueName();
-			string iCode = variableIdentities[i][ii]->getResidueIcode();
-			overallConfI += totalConfI;
-
-			for (unsigned int cI=0; cI<totalConfI; cI++) {
-				//  LOOP LEVEL 3: for each rotamer of pos/identity i/ii 
-
-				rotI++;
-				pairE[i-1].push_back(vector<vector<double> >());
+		for (unsigned int rotI=0; rotI<totalRotI; rotI++) {
+			for (unsigned int j=0; j<totalRotJ.size(); j++) {
 				if(onTheFly) {
-					pairEFlag[i-1].push_back(vector<vector<bool> >());
+					pairEFlag[i-1][rotI].push_back(vector<bool>(totalRotJ[j], false));
 				}
-
-				if(saveEbyTerm) {
-					pairEbyTerm[i-1].push_back(vector<vector<map<string, double> > >());
-					pairCountByTerm[i-1].push_back(vector<vector<map<string, unsigned int> > >());
-				}
-				
 				if(saveInteractionCount) {
-					pairCount[i-1].push_back(vector<vector<unsigned int> >());
+					pairCount[i-1][rotI].push_back(vector<unsigned int>(totalRotJ[j], 0));
 				}
-				
-				
-				if (cI > 0) {
-					// change the rotamer of i/ii
-					variableIdentities[i][ii]->setActiveConformation(cI);
-					for (unsigned int iii=0; iii<slaveIdentities[i][ii].size(); iii++) {
-						slaveIdentities[i][ii][iii]->setActiveConformation(cI);
-					}
-				}
-
-				for (unsigned int j=1; j<subdividedInteractions[i][ii].size(); j++) {
-					// LOOP LEVEL 4: for each position j
-
-					if (j == i ) {
-						continue; // self
-					}
-
-					pairE[i-1][rotI].push_back(vector<double>());
-					if(onTheFly) {
-						pairEFlag[i-1][rotI].push_back(vector<bool>());
-					}
-					if(saveInteractionCount) {
-						pairCount[i-1][rotI].push_back(vector<unsigned int>());
-					}
-
-					if(saveEbyTerm) {
-						pairEbyTerm[i-1][rotI].push_back(vector<map<string, double> >());
-						pairCountByTerm[i-1][rotI].push_back(vector<map<string, unsigned int> >());
-					}
-
-					unsigned int rotJ = -1;
-					for (unsigned int jj=0; jj<subdividedInteractions[i][ii][j].size(); jj++) {
-						// LOOP LEVEL 5: for each identity jj
-
-						// get the number of rotamer for the position and their particular identity
-						unsigned int totalConfJ = variableIdentities[j][jj]->getNumberOfRotamers();
-						// set the j/jj-th residue the initial rotamer
-						variableIdentities[j][jj]->setActiveConformation(0);
-						for (unsigned int jjj=0; jjj<slaveIdentities[j][jj].size(); jjj++) {
-							slaveIdentities[j][jj][jjj]->setActiveConformation(0);
-						}
-
-						for (unsigned int cJ=0; cJ<totalConfJ; cJ++) {
-							//  LOOP LEVEL 6: for each rotamer of pos/identity j/jj 
-
-							rotJ++;
-
-							pairE[i-1][rotI][j-1].push_back(0.0);
-							if(onTheFly) {
-								pairEFlag[i-1][rotI][j-1].push_back(false);
-							}
-
-							if(saveEbyTerm) {
-								pairEbyTerm[i-1][rotI][j-1].push_back(map<string, double>());
-								pairCountByTerm[i-1][rotI][j-1].push_back(map<string, unsigned int>());
-							}
-							if(saveInteractionCount) {
-								pairCount[i-1][rotI][j-1].push_back(0);
-							}
-
-							if (cJ > 0) {
-								// change the rotamer of j/jj
-								variableIdentities[j][jj]->setActiveConformation(cJ);
-								for (unsigned int jjj=0; jjj<slaveIdentities[j][jj].size(); jjj++) {
-									slaveIdentities[j][jj][jjj]->setActiveConformation(cJ);
-								}
-							}
-
-							if(saveEbyTerm || saveInteractionCount || !onTheFly) {	
-								// finally calculate the energies
-								for (map<string, vector<Interaction*> >::iterator k=subdividedInteractions[i][ii][j][jj].begin(); k!= subdividedInteractions[i][ii][j][jj].end(); k++) {
-									if (!pESet->isTermActive(k->first)) {
-										// inactive term
-										continue;
-									}
-									if(saveInteractionCount) {
-										pairCount[i-1][rotI][j-1][rotJ] += k->second.size();
-									}
-									if(saveEbyTerm) {
-										pairEbyTerm[i-1][rotI][j-1][rotJ][k->first] = 0;
-										pairCountByTerm[i-1][rotI][j-1][rotJ][k->first] = k->second.size();
-									}
-
-									if(!onTheFly) {
-										double E = 0.0;
-										for (vector<Interaction*>::iterator l=k->second.begin(); l!= k->second.end(); l++) {
-											E += (*l)->getEnergy();
-										}
-										E *= weights[k->first];
-										pairE[i-1][rotI][j-1][rotJ] += E;
-										if(saveEbyTerm) {
-											pairEbyTerm[i-1][rotI][j-1][rotJ][k->first] += E;
-										}
-									}
-								}
-							}
-						}
-					}
+				if(saveEbyTerm) {
+					pairEbyTerm[i-1][rotI].push_back(vector<map<string, double> >(totalRotJ[j]));
+					pairCountByTerm[i-1][rotI].push_back(vector<map<string, unsigned int> >(totalRotJ[j]));
 				}
 			}
 		}
 	}
+
+	runPairTableBlocks(false);
 	
 	/*
-	cout << "UUU Fixed Energy: " << fixE << " (" << fixCount << ") " <<pairE.size()<<" "<<selfE.size()<<" "<<selfCount.size()<< endl;
-	for (unsigned int i=0; i<pairE.size(); i++) {
-		for (unsigned int j=0; j<pairE[i].size(); j++) {
-		        cout << "UUU Self Energy " << i << "/" << j << ": " << selfE[i][j] << endl;//" (" << selfCount[i][j] << ")" << endl;
-			for (unsigned int k=0; k<pairE[i][j].size(); k++) {
-				for (unsigned int l=0; l<pairE[i][j][k].size(); l++) {
-				  cout << "UUU Pair Energy " << i << "/" << j << " - " << k << "/" << l << ": " << pairE[i][j][k][l] <<endl;  //<< " (" << pairCount[i][j][k][l] << ")" << endl;
+	cout << "UUU Fixed Energy: " << fixE << " (" << fixCount << ") " <<energyTable.getNumberOfPositions()<<" "<<selfCount.size()<< endl;
+	for (unsigned int i=0; i<energyTable.getNumberOfPositions(); i++) {
+		for (unsigned int j=0; j<energyTable.getNumberOfRotamers(i); j++) {
+		        cout << "UUU Self Energy " << i << "/" << j << ": " << energyTable.getSelfEnergy(i, j) << endl;//" (" << selfCount[i][j] << ")" << endl;
+			for (unsigned int k=0; k<i; k++) {
+				for (unsigned int l=0; l<energyTable.getNumberOfRotamers(k); l++) {
+				  cout << "UUU Pair Energy " << i << "/" << j << " - " << k << "/" << l << ": " << energyTable.getPairEnergy(i, j, k, l) <<endl;  //<< " (" << pairCount[i][j][k][l] << ")" << endl;
 				}
 			}
 		}
@@ -1004,7 +1042,7 @@ double SelfPairManager::getAliveCombinations() const {
 
 double SelfPairManager::computeSelfE(unsigned pos, unsigned rot) {
 	// when onTheFly is implemented for selfE this will need to be updated
-	return selfE[pos][rot];
+	return energyTable.getSelfEnergy(pos, rot);
 
 }
 double SelfPairManager::computePairE(unsigned pos1, unsigned rot1, unsigned pos2, unsigned rot2, string _term) {
@@ -1013,7 +1051,7 @@ double SelfPairManager::computePairE(unsigned pos1, unsigned rot1, unsigned pos2
 		return 0.0;
 	}
 	if(!onTheFly) {
-	  return pairE[pos1][rot1][pos2][rot2]; 
+	  return energyTable.getPairEnergy(pos1, rot1, pos2, rot2); 
 	}
 	if(!pairEFlag[pos1][rot1][pos2][rot2]) {
 	  // cout << pos1 << "," << rot1 << "," << pos2 << "," <<  rot2 << " " << endl;
@@ -1025,7 +1063,7 @@ double SelfPairManager::computePairE(unsigned pos1, unsigned rot1, unsigned pos2
 		variablePositions[pos1 + 1]->setActiveRotamer(rot1);
 		variablePositions[pos2 + 1]->setActiveRotamer(rot2);
 
-		pairE[pos1][rot1][pos2][rot2] = 0.0;
+		double pairEnergy = 0.0;
 		for (map<string, vector<Interaction*> >::iterator k=subdividedInteractions[pos1+1][id1][pos2+1][id2].begin(); k!= subdividedInteractions[pos1 + 1][id1][pos2 + 1][id2].end(); k++) {
 			if (!pESet->isTermActive(k->first)) {
 				// inactive term
@@ -1036,11 +1074,12 @@ double SelfPairManager::computePairE(unsigned pos1, unsigned rot1, unsigned pos2
 				E += (*l)->getEnergy();
 			}
 			E *= weights[k->first];
-			pairE[pos1][rot1][pos2][rot2] += E;
+			pairEnergy += E;
 			if(saveEbyTerm) {
 				pairEbyTerm[pos1][rot1][pos2][rot2][k->first] += E;
 			}
 		}
+		energyTable.setPairEnergy(pos1, rot1, pos2, rot2, pairEnergy);
 		// Assume pairEFlag array exists 
 		pairEFlag[pos1][rot1][pos2][rot2] = true;
 	      }
@@ -1048,7 +1087,7 @@ double SelfPairManager::computePairE(unsigned pos1, unsigned rot1, unsigned pos2
 
 	
 	if (_term == "") {
-		return pairE[pos1][rot1][pos2][rot2]; 
+		return energyTable.getPairEnergy(pos1, rot1, pos2, rot2); 
 	} else {
 		return pairEbyTerm[pos1][rot1][pos2][rot2][_term]; 
 	}
@@ -1085,8 +1124,8 @@ double SelfPairManager::getStateEnergy(vector<unsigned int> _overallRotamerState
 		// term does not exist
 		return 0.0;
 	}
-	if (_overallRotamerStates.size() != pairE.size()) {
-		cerr << "ERROR 54917: incorrect number of positions in input (" << _overallRotamerStates.size() << " != " << pairE.size() << " in double SelfPairManager::getStateEnergy(vector<unsigned int> _overallRotamerStates, string _term)" << endl;
+	if (_overallRotamerStates.size() != energyTable.getNumberOfPositions()) {
+		cerr << "ERROR 54917: incorrect number of positions in input (" << _overallRotamerStates.size() << " != " << energyTable.getNumberOfPositions() << " in double SelfPairManager::getStateEnergy(vector<unsigned int> _overallRotamerStates, string _term)" << endl;
 		exit(54917);
 	}
 
@@ -1094,13 +1133,17 @@ double SelfPairManager::getStateEnergy(vector<unsigned int> _overallRotamerState
 	double out = 0.0;
 	if (_term == "") {
 		out += fixE;
-		for (unsigned int i=0; i<pairE.size(); i++) {
-			if (_overallRotamerStates[i] >= pairE[i].size()) {
-				cerr << "ERROR 54922: incorrect number of rotamer in variable position " << i << " in input (" << _overallRotamerStates[i] << " >= " << pairE[i].size() << " in double SelfPairManager::getStateEnergy(vector<unsigned int> _overallRotamerStates, string _term)" << endl;
+		for (unsigned int i=0; i<energyTable.getNumberOfPositions(); i++) {
+			if (_overallRotamerStates[i] >= energyTable.getNumberOfRotamers(i)) {
+				cerr << "ERROR 54922: incorrect number of rotamer in variable position " << i << " in input (" << _overallRotamerStates[i] << " >= " << energyTable.getNumberOfRotamers(i) << " in double SelfPairManager::getStateEnergy(vector<unsigned int> _overallRotamerStates, string _term)" << endl;
 				exit(54922);
 			}
-			out += selfE[i][_overallRotamerStates[i]];
+			out += energyTable.getSelfEnergy(i, _overallRotamerStates[i]);
 			for (unsigned int j=0; j<i; j++) {
+				if (!energyTable.isPairStored(i, j)) {
+					// no interactions between the two positions
+					continue;
+				}
 				out += computePairE(i,_overallRotamerStates[i],j,_overallRotamerStates[j]);
 			}
 		}
@@ -1237,12 +1280,27 @@ double SelfPairManager::getFixedEnergy() const {
 	return fixE;
 }
 
-std::vector<std::vector<double> > & SelfPairManager::getSelfEnergy() {
-	return selfE;	
+const std::vector<std::vector<double> > & SelfPairManager::getSelfEnergy() {
+	// legacy nested copy of the self table, rebuilt at every call
+	legacySelfE.clear();
+	for (unsigned int i=0; i<energyTable.getNumberOfPositions(); i++) {
+		legacySelfE.push_back(vector<double>(energyTable.getNumberOfRotamers(i), 0.0));
+		for (unsigned int j=0; j<legacySelfE[i].size(); j++) {
+			legacySelfE[i][j] = energyTable.getSelfEnergy(i, j);
+		}
+	}
+	return legacySelfE;	
+}
+
+const std::vector<std::vector<std::vector<std::vector<double> > > > & SelfPairManager::getPairEnergy() {
+	// legacy nested copy of the pair table, rebuilt at every call
+	vector<vector<double> > self;
+	energyTable.getTables(self, legacyPairE);
+	return legacyPairE;	
 }
 
-std::vector<std::vector<std::vector<std::vector<double> > > > & SelfPairManager::getPairEnergy() {
-	return pairE;	
+EnergyTable & SelfPairManager::getEnergyTable() {
+	return energyTable;
 }
 
 void SelfPairManager::setRunDEE(bool _singles, bool _pairs) {
@@ -1311,8 +1369,8 @@ void SelfPairManager::runOptimizer() {
 	 *  residue only, vs the whole rotameric space at all other positions
 	 *****************************************/
 
-	for (unsigned int i=0; i < selfE.size(); i++) {
-		unsigned int rots = selfE[i].size();
+	for (unsigned int i=0; i < energyTable.getNumberOfPositions(); i++) {
+		unsigned int rots = energyTable.getNumberOfRotamers(i);
 		aliveMask.push_back(vector<bool>(rots, true));
 		aliveRotamers.push_back(vector<unsigned int>());
 		for (unsigned int j=0; j<rots; j++) {
@@ -1366,10 +1424,7 @@ double SelfPairManager::runDeadEndElimination() {
 
 	//bool singleSolution = false;
 
-	vector<vector<double> >& oligomersSelf = getSelfEnergy();
-	vector<vector<vector<vector<double> > > >& oligomersPair = getPairEnergy();
-
-	DeadEndElimination DEE(oligomersSelf, oligomersPair);
+	DeadEndElimination DEE(energyTable);
 	double finalCombinations = DEE.getTotalCombinations();
 
 	if (verbose) {
@@ -1469,12 +1524,10 @@ void SelfPairManager::runSelfConsistentMeanField() {
 	time (&startSCMFtime);
 
 	double oligomerFixed = getFixedEnergy();
-	vector<vector<double> > & oligomersSelf = getSelfEnergy();
-	vector<vector<vector<vector<double> > > >& oligomersPair = getPairEnergy();
 
 	SelfConsistentMeanField SCMF;
 	SCMF.setRandomNumberGenerator(pRng);
-	SCMF.setEnergyTables(oligomerFixed,oligomersSelf,oligomersPair);
+	SCMF.setEnergyTable(&oligomerFixed, &energyTable);
 	SCMF.setT(SCMFtemperature);
 	SCMF.setVerbose(verbose);
 	if (runDEE) {
@@ -1528,16 +1581,12 @@ void SelfPairManager::runUnbiasedMonteCarlo() {
 	 *                     === Unbiased MONTE CARLO OPTIMIZATION ===
 	 ******************************************************************************/
 
-	vector<vector<double> > & oligomersSelf = getSelfEnergy();
-	vector<vector<vector<vector<double> > > >& oligomersPair = getPairEnergy();
-
-		
 //	an unbiased monte carlo method using the most probable SCMF state as the start
 	MonteCarloOptimization MCO;
 	if(onTheFly) {
 		MCO.setSelfPairManager(this);
 	} else {
-		MCO.addEnergyTable(oligomersSelf, oligomersPair);
+		MCO.addEnergyTable(energyTable);
 	}
 	MCO.setRandomNumberGenerator(pRng);
 	if(runSCMF) {
@@ -1596,13 +1645,13 @@ int SelfPairManager::selectRandomStateAtPosition(int _position,vector<unsigned i
 		cerr << "ERROR 72960: position " << _position << " out of range in int SelfPairManager::selectRandomStateAtPosition(int _position,vector<unsigned int>& _currentState) const " << endl;
 		return 0;
 	}
-	if (selfE[_position].size() == 1) {
+	if (energyTable.getNumberOfRotamers(_position) == 1) {
 		return 0;
 	}
 
 	vector<double> residualP;
 	double sumP = 0.0;
-	for (int i=0; i<selfE[_position].size(); i++) {
+	for (int i=0; i<energyTable.getNumberOfRotamers(_position); i++) {
 		if (i == _currentState[_position] || !aliveMask[_position][i]) {
 			residualP.push_back(0.0);
 		} else {
@@ -1621,7 +1670,7 @@ int SelfPairManager::selectRandomStateAtPosition(int _position,vector<unsigned i
 }
 
 void SelfPairManager::getRandomState(vector<unsigned int>& _currentState) {
-	for (int i=0; i<selfE.size(); i++) {
+	for (int i=0; i<energyTable.getNumberOfPositions(); i++) {
 		_currentState[i] = selectRandomStateAtPosition(i,_currentState);
 	}
 }
@@ -1654,8 +1703,8 @@ void SelfPairManager::runGreedyOptimizer(int _cycles, std::vector< std::vector<b
 
 	// Reset the aliveMask, we dont really need it, but the getRandomState needs it
 	aliveMask.clear();
-	for (unsigned int i=0; i < selfE.size(); i++) {
-		aliveMask.push_back(vector<bool>(selfE[i].size(), true));
+	for (unsigned int i=0; i < energyTable.getNumberOfPositions(); i++) {
+		aliveMask.push_back(vector<bool>(energyTable.getNumberOfRotamers(i), true));
 	}
 
 	double energy=MslTools::doubleMax;
@@ -1717,8 +1766,9 @@ void SelfPairManager::runGreedyOptimizer(int _cycles, std::vector< std::vector<b
 vector<unsigned int> SelfPairManager::runLP(bool _runMIP) {
 #ifdef __GLPK__
 		LinearProgrammingOptimization lpo;
-		vector<vector<double> >& oligomersSelf = getSelfEnergy();
-		vector<vector<vector<vector<double> > > >& oligomersPair = getPairEnergy();
+		vector<vector<double> > oligomersSelf;
+		vector<vector<vector<vector<double> > > > oligomersPair;
+		energyTable.getTables(oligomersSelf, oligomersPair);
 		lpo.addEnergyTable(oligomersSelf,oligomersPair);
 		lpo.setVerbose(verbose);
 		return lpo.getSolution(_runMIP);
@@ -1739,7 +1789,7 @@ double SelfPairManager::computeSelfE(string _posId, string _resName, string _ter
   Position &pos = pSys->getPosition(_posId);
   int posIndex = variablePosIndex[&pos];
 
-  //cout << "Variable index for position["<<_posId<<"] = "<<posIndex<<" number of rotamers: "<<variableCount[posIndex-1]<<" "<<variableCount.size()<<" "<<variableIdentities.size()<<" "<<variableIdentities[posIndex].size()<<" "<<selfE.size()<<" "<<selfE[0].size()<<" "<<selfEbyTerm.size()<<endl;
+  //cout << "Variable index for position["<<_posId<<"] = "<<posIndex<<" number of rotamers: "<<variableCount[posIndex-1]<<" "<<variableCount.size()<<" "<<variableIdentities.size()<<" "<<variableIdentities[posIndex].size()<<" "<<energyTable.getNumberOfPositions()<<" "<<energyTable.getNumberOfRotamers(0)<<" "<<selfEbyTerm.size()<<endl;
 
   // Iterate over rotamers at this position: variableCount[posIndex]
   double minE = MslTools::doubleMax;
@@ -1753,7 +1803,7 @@ double SelfPairManager::computeSelfE(string _posId, string _resName, string _ter
     //cout << "Rotamer["<<i<<","<<rotamerIndex<<"]: is "<<variableIdentities[posIndex][rotamerIndex]->getResidueName()<<" looking for "<<_resName<<endl;
 
     double E = 0.0;
-    E = selfE[posIndex-1][i];
+    E = energyTable.getSelfEnergy(posIndex-1, i);
 
     if (E < minE){
       minE = E;
@@ -33,8 +33,10 @@ You should have received a copy of the GNU Lesser General Public
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <pthread.h>
 
 #include "DeadEndElimination.h"
+#include "EnergyTable.h"
 #include "Enumerator.h"
 #include "MonteCarloManager.h"
 #include "MonteCarloOptimization.h"
@@ -93,11 +95,14 @@ class SelfPairManager {
 
 		double getFixedEnergy() const;
 
-		// gets the reduced self energy table if cutoff is applied
-		std::vector<std::vector<double> > & getSelfEnergy(); 		
+		// gets the reduced self energy table if cutoff is applied (a nested copy of the energy table)
+		const std::vector<std::vector<double> > & getSelfEnergy(); 		
 
-		// gets the reduced pair energy table if cutoff is applied
-		std::vector<std::vector<std::vector<std::vector<double> > > > & getPairEnergy(); 
+		// gets the reduced pair energy table if cutoff is applied (a nested copy of the energy table)
+		const std::vector<std::vector<std::vector<std::vector<double> > > > & getPairEnergy(); 
+
+		// the self and pair energies in a flat table, used directly by the optimizers
+		EnergyTable & getEnergyTable();
 
 		// Side Chain Optimization Functions
 		void setRunDEE(bool _singles, bool _pairs = false); 
@@ -109,6 +114,14 @@ class SelfPairManager {
 		void setMCOptions(double _startT, double _endT, int _nCycles, int _shape, int _maxReject, int _deltaSteps, double _minDeltaE);
 
 		void setOnTheFly(bool _onTheFly);
+
+		// number of threads used to build the self and pair energy tables (1 by default)
+		void setNumberOfThreads(unsigned int _threads);
+		unsigned int getNumberOfThreads() const;
+
+		// store only the pair energies of the positions that interact (default true)
+		void setSparsePairTable(bool _sparse);
+		bool getSparsePairTable() const;
 		
 		void setEnumerationLimit(int _enumLimit);
 
@@ -151,6 +164,37 @@ class SelfPairManager {
 		void calculatePairEnergies();
 		void recalculateNonSavedPairEnergies(std::vector<std::vector<std::vector<std::vector<bool> > > > savedPairEnergies);
 
+		/***************************************************************
+		 *  The tables are filled by blocks: a self block is a
+		 *  position/identity (j = jj = 0), a pair block is the product
+		 *  of two identities at different positions. A block only
+		 *  changes the active conformation of its own identities (and
+		 *  their slaves), so blocks that do not share an identity can
+		 *  be calculated at the same time by different threads
+		 ***************************************************************/
+		struct TableBlock {
+			unsigned int i;
+			unsigned int ii;
+			unsigned int j;
+			unsigned int jj;
+		};
+		struct TableBuilder {
+			SelfPairManager * pManager;
+			const std::vector<TableBlock> * pBlocks;
+			unsigned int * pNextBlock; // shared, blocks are taken in order by the first free thread
+			pthread_mutex_t * pMutex;
+			bool recalculate; // only pair energies that are not flagged in pairEFlag
+		};
+		static void * buildTableBlocks(void * _builder);
+		void runTableBlocks(const std::vector<TableBlock> & _blocks, bool _recalculate);
+		void runPairTableBlocks(bool _recalculate);
+		void calculateSelfBlock(unsigned int _i, unsigned int _ii);
+		void calculatePairBlock(unsigned int _i, unsigned int _ii, unsigned int _j, unsigned int _jj, bool _recalculate);
+		void setIdentityConformation(unsigned int _i, unsigned int _ii, unsigned int _conf);
+		void addMissingWeights();
+		void updateEnergyTable(const std::vector<unsigned int> & _rotamers, bool _clearPairs);
+		void findInteractingPairs(std::vector<std::vector<bool> > & _interacting) const;
+
 		double runDeadEndElimination(); // returns the finalCombinations
 		void runEnumeration();
 		void runSelfConsistentMeanField();
@@ -173,8 +217,9 @@ class SelfPairManager {
 		std::vector<std::vector<std::vector<Residue*> > > slaveIdentities;
 
 		double fixE;
-		std::vector<std::vector<double> > selfE;
-		std::vector<std::vector<std::vector<std::vector<double> > > > pairE;
+		EnergyTable energyTable; // the self and pair energies
+		std::vector<std::vector<double> > legacySelfE; // returned by getSelfEnergy()
+		std::vector<std::vector<std::vector<std::vector<double> > > > legacyPairE; // returned by getPairEnergy()
 		std::vector<std::vector<std::vector<std::vector<bool> > > > pairEFlag; // true if the energy is computed already and available
 
 		bool saveEbyTerm;
@@ -210,6 +255,10 @@ class SelfPairManager {
 
 		bool onTheFly; // if true, pair energies are not precomputed
 
+		unsigned int numberOfThreads;
+		bool sparsePairTable;
+		std::vector<std::vector<unsigned int> > rotamerOffsets; // [i][ii] index of the first rotamer of identity ii in the tables of position i
+
 		std::vector<std::vector<unsigned int> > aliveRotamers;
 		std::vector<std::vector<bool> > aliveMask;
 		std::vector<unsigned int> mostProbableSCMFstate;
@@ -325,21 +374,39 @@ inline void SelfPairManager::saveInteractionCounts(bool _save) {
 inline void SelfPairManager::setOnTheFly(bool _onTheFly) {
 	onTheFly = _onTheFly;
 }
+inline void SelfPairManager::setNumberOfThreads(unsigned int _threads) {
+	numberOfThreads = _threads;
+}
+inline unsigned int SelfPairManager::getNumberOfThreads() const {
+	return numberOfThreads;
+}
+inline void SelfPairManager::setSparsePairTable(bool _sparse) {
+	sparsePairTable = _sparse;
+}
+inline bool SelfPairManager::getSparsePairTable() const {
+	return sparsePairTable;
+}
+inline void SelfPairManager::setIdentityConformation(unsigned int _i, unsigned int _ii, unsigned int _conf) {
+	variableIdentities[_i][_ii]->setActiveConformation(_conf);
+	for (unsigned int iii=0; iii<slaveIdentities[_i][_ii].size(); iii++) {
+		slaveIdentities[_i][_ii][iii]->setActiveConformation(_conf);
+	}
+}
 inline void SelfPairManager::setEnumerationLimit(int _enumLimit) {
 	enumerationLimit = _enumLimit;
 }
 
 inline int SelfPairManager::getNumPositions() { 
-	return selfE.size();
+	return energyTable.getNumberOfPositions();
 }
 
 inline int SelfPairManager::getNumRotamers(int _position) {
 
-	if ( _position >= selfE.size()) { 
+	if ( _position >= energyTable.getNumberOfPositions()) { 
 		return 0; 
 	} 
 
-	return selfE[_position].size();
+	return energyTable.getNumberOfRotamers(_position);
 }
 
 
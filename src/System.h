@@ -42,6 +42,7 @@ You should have received a copy of the GNU Lesser General Public
 #include "EnergySet.h"
 #include "PDBTopology.h"
 #include "VectorPair.h"
+#include "BondGraph.h"
 
 namespace MSL { 
 
@@ -133,6 +134,12 @@ class System {
 
 		AtomPointerVector & getAtomPointers();
 		AtomPointerVector & getAllAtomPointers();
+		/***************************************************
+		 *  The bonded topology of all the atoms (active and
+		 *  inactive, same indeces of getAllAtomPointers),
+		 *  rebuilt when needed if atoms or bonds have changed
+		 ***************************************************/
+		BondGraph & getBondGraph();
 		Atom & operator[](unsigned int _index);
 		Atom & operator[](std::string _atomId);
 		Atom & getAtom(unsigned int _index);
@@ -314,6 +321,7 @@ class System {
 		 *********************************************/
 		AtomPointerVector activeAtoms;
 		AtomPointerVector activeAndInactiveAtoms;
+		BondGraph bondGraph;
 		bool noUpdateIndex_flag;
 
 		std::map<std::string, Chain*>::iterator foundChain;
@@ -414,6 +422,12 @@ inline Residue & System::getResidue(std::string _chain, int _resnum, std::string
 inline Residue & System::getResidue(std::string _identityId) {return getIdentity(_identityId);}
 inline AtomPointerVector & System::getAtomPointers() {return activeAtoms;}
 inline AtomPointerVector & System::getAllAtomPointers() {return activeAndInactiveAtoms;}
+inline BondGraph & System::getBondGraph() {
+	if (!bondGraph.isCurrent(activeAndInactiveAtoms)) {
+		bondGraph.build(activeAndInactiveAtoms);
+	}
+	return bondGraph;
+}
 inline Atom & System::operator[](unsigned int _index) {return *(activeAtoms[_index]);}
 inline Atom & System::operator[](std::string _atomId) {return getAtom(_atomId);}
 inline Atom & System::getAtom(unsigned int _index) {return *(activeAtoms[_index]);}
@@ -0,0 +1,192 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "SystemSnapshotFormat.h"
+#include "CharmmBondInteraction.h"
+#include "CharmmAngleInteraction.h"
+#include "CharmmUreyBradleyInteraction.h"
+#include "CharmmDihedralInteraction.h"
+#include "CharmmImproperInteraction.h"
+#include "CharmmVdwInteraction.h"
+#include "CharmmElectrostaticInteraction.h"
+#include "CharmmEEF1Interaction.h"
+#include "CharmmEEF1RefInteraction.h"
+#include "CharmmIMM1RefInteraction.h"
+
+#include <fstream>
+#include <iterator>
+
+using namespace MSL;
+using namespace std;
+
+
+const char * SystemSnapshotFormat::magic() {
+	static const char m[8] = {'M', 'S', 'L', 'S', 'N', 'A', 'P', '\0'};
+	return m;
+}
+
+unsigned long long SystemSnapshotFormat::checksum(const char * _data, size_t _size) {
+	// FNV-1a, on 8 bytes at a time, then the remaining bytes
+	unsigned long long hash = 14695981039346656037ULL;
+	size_t i = 0;
+	for (; i+8<=_size; i+=8) {
+		unsigned long long word;
+		memcpy(&word, _data + i, 8);
+		hash ^= word;
+		hash *= 1099511628211ULL;
+	}
+	for (; i<_size; i++) {
+		hash ^= (unsigned char)_data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+bool SystemSnapshotFormat::fileChecksum(string _file, unsigned long long & _checksum) {
+	ifstream in(_file.c_str(), ios::in | ios::binary);
+	if (!in.is_open()) {
+		return false;
+	}
+	string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	_checksum = checksum(content.data(), content.size());
+	return true;
+}
+
+bool SystemSnapshotFormat::encodeInteraction(Interaction & _interaction, vector<double> & _values) {
+	_values.clear();
+	string name = _interaction.getName();
+	if (name == "CHARMM_BOND" || name == "CHARMM_ANGL" || name == "CHARMM_U-BR" || name == "CHARMM_IMPR" || name == "CHARMM_EEF1REF" || name == "CHARMM_IMM1REF") {
+		// the parameters are all the state
+		_values = _interaction.getParams();
+		return true;
+	}
+	if (name == "CHARMM_DIHE") {
+		// the terms of a multiple dihedral, 3 values each
+		vector<vector<double> > & multi = ((CharmmDihedralInteraction&)_interaction).getMultipleParams();
+		for (unsigned int i=0; i<multi.size(); i++) {
+			if (multi[i].size() != 3) {
+				return false;
+			}
+			_values.insert(_values.end(), multi[i].begin(), multi[i].end());
+		}
+		return true;
+	}
+	if (name == "CHARMM_VDW") {
+		CharmmVdwInteraction & vdw = (CharmmVdwInteraction&)_interaction;
+		_values = vdw.getParams();
+		_values.push_back(vdw.getUseNonBondCutoffs());
+		_values.push_back(vdw.getNonBondCutoffOn());
+		_values.push_back(vdw.getNonBondCutoffOff());
+		return true;
+	}
+	if (name == "CHARMM_ELEC") {
+		// the charge factor is recalculated from the atoms
+		CharmmElectrostaticInteraction & elec = (CharmmElectrostaticInteraction&)_interaction;
+		_values.push_back(elec.getDielectricConstant());
+		_values.push_back(elec.getElec14factor());
+		_values.push_back(elec.getUseRdielectric());
+		_values.push_back(elec.getUseNonBondCutoffs());
+		_values.push_back(elec.getNonBondCutoffOn());
+		_values.push_back(elec.getNonBondCutoffOff());
+		return true;
+	}
+	if (name == "CHARMM_EEF1") {
+		CharmmEEF1Interaction & eef1 = (CharmmEEF1Interaction&)_interaction;
+		_values = eef1.getParams();
+		_values.push_back(eef1.getUseNonBondCutoffs());
+		_values.push_back(eef1.getNonBondCutoffOn());
+		_values.push_back(eef1.getNonBondCutoffOff());
+		return true;
+	}
+	return false;
+}
+
+SystemSnapshotFormat::InteractionType SystemSnapshotFormat::interactionType(const string & _name) {
+	if (_name == "CHARMM_BOND") { return BOND; }
+	if (_name == "CHARMM_ANGL") { return ANGLE; }
+	if (_name == "CHARMM_U-BR") { return UREY_BRADLEY; }
+	if (_name == "CHARMM_IMPR") { return IMPROPER; }
+	if (_name == "CHARMM_DIHE") { return DIHEDRAL; }
+	if (_name == "CHARMM_VDW") { return VDW; }
+	if (_name == "CHARMM_ELEC") { return ELEC; }
+	if (_name == "CHARMM_EEF1") { return EEF1; }
+	if (_name == "CHARMM_EEF1REF") { return EEF1REF; }
+	if (_name == "CHARMM_IMM1REF") { return IMM1REF; }
+	return UNKNOWN;
+}
+
+Interaction * SystemSnapshotFormat::decodeInteraction(const string & _name, const vector<Atom*> & _atoms, const vector<double> & _values) {
+	return decodeInteraction(interactionType(_name), _atoms, _values);
+}
+
+Interaction * SystemSnapshotFormat::decodeInteraction(InteractionType _type, const vector<Atom*> & _atoms, const vector<double> & _values) {
+	const vector<Atom*> & a = _atoms;
+	const vector<double> & v = _values;
+	if (_type == BOND && a.size() == 2 && v.size() == 2) {
+		return new CharmmBondInteraction(*a[0], *a[1], v[0], v[1]);
+	}
+	if (_type == ANGLE && a.size() == 3 && v.size() == 2) {
+		return new CharmmAngleInteraction(*a[0], *a[1], *a[2], v[0], v[1]);
+	}
+	if (_type == UREY_BRADLEY && a.size() == 2 && v.size() == 2) {
+		return new CharmmUreyBradleyInteraction(*a[0], *a[1], v[0], v[1]);
+	}
+	if (_type == IMPROPER && a.size() == 4 && v.size() == 2) {
+		return new CharmmImproperInteraction(*a[0], *a[1], *a[2], *a[3], v[0], v[1]);
+	}
+	if (_type == DIHEDRAL && a.size() == 4 && v.size() > 0 && v.size() % 3 == 0) {
+		vector<vector<double> > multi;
+		for (unsigned int i=0; i<v.size(); i+=3) {
+			multi.push_back(vector<double>(v.begin() + i, v.begin() + i + 3));
+		}
+		return new CharmmDihedralInteraction(*a[0], *a[1], *a[2], *a[3], multi);
+	}
+	if (_type == VDW && a.size() == 2 && v.size() == 5) {
+		CharmmVdwInteraction * vdw = new CharmmVdwInteraction(*a[0], *a[1], v[0], v[1]);
+		vdw->setUseNonBondCutoffs(v[2] != 0.0, v[3], v[4]);
+		return vdw;
+	}
+	if (_type == ELEC && a.size() == 2 && v.size() == 6) {
+		CharmmElectrostaticInteraction * elec = new CharmmElectrostaticInteraction(*a[0], *a[1], v[0], v[1], v[2] != 0.0);
+		elec->setUseNonBondCutoffs(v[3] != 0.0, v[4], v[5]);
+		return elec;
+	}
+	if (_type == EEF1 && a.size() == 2 && v.size() == 11) {
+		CharmmEEF1Interaction * eef1 = new CharmmEEF1Interaction(*a[0], *a[1], v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+		eef1->setUseNonBondCutoffs(v[8] != 0.0, v[9], v[10]);
+		return eef1;
+	}
+	if (_type == EEF1REF && a.size() == 1 && v.size() == 1) {
+		return new CharmmEEF1RefInteraction(*a[0], v[0]);
+	}
+	if (_type == IMM1REF && a.size() == 1 && v.size() == 4) {
+		return new CharmmIMM1RefInteraction(*a[0], v[0], v[1], v[2], v[3]);
+	}
+	return NULL;
+}
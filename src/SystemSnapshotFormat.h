@@ -0,0 +1,116 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef SYSTEMSNAPSHOTFORMAT_H
+#define SYSTEMSNAPSHOTFORMAT_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "Interaction.h"
+
+namespace MSL { 
+	/*******************************************************************
+	 *  Binary snapshot of a built System (see SystemSnapshotWriter and
+	 *  SystemSnapshotReader).  The numbers are stored in the native
+	 *  byte order, which is checked with a byte order mark.
+	 *
+	 *  Header (headerSize bytes):
+	 *    magic "MSLSNAP" + '\0', version, byte order mark,
+	 *    size of the payload, checksum of the payload
+	 *  Payload (counts are unsigned int, strings are a count and
+	 *  the characters, coordinates and parameters are doubles):
+	 *    - source files: name and checksum of the content
+	 *    - atoms, by position, identity and atom: residue and atom
+	 *      data, then all conformations (visible, hidden with their
+	 *      absolute indices, active one)
+	 *    - the active identity of each position
+	 *    - bonds (pairs of atom indeces)
+	 *    - IC table (4 atom indeces, -1 for none, 5 values, improper)
+	 *    - energy terms: name, weight, active flag, interactions
+	 *      (atom indeces and the values of encodeInteraction)
+	 *
+	 *  Only the interaction types known by encodeInteraction (the CHARMM
+	 *  terms but IMM1) can be stored
+	 *******************************************************************/
+	class SystemSnapshotFormat {
+		public:
+			static const char * magic(); // 8 characters
+			static const unsigned int version = 1;
+			static const unsigned int byteOrderMark = 0x01020304;
+			static const unsigned int headerSize = 32;
+
+			// 64 bit FNV-1a hash, on 8 byte words (the content of a file for fileChecksum)
+			static unsigned long long checksum(const char * _data, size_t _size);
+			static bool fileChecksum(std::string _file, unsigned long long & _checksum);
+
+			// the parameters of an interaction as a list of values, false if the type is not supported
+			static bool encodeInteraction(Interaction & _interaction, std::vector<double> & _values);
+			// a new interaction from its name, atoms and values (NULL if the type or the values are not valid)
+			static Interaction * decodeInteraction(const std::string & _name, const std::vector<Atom*> & _atoms, const std::vector<double> & _values);
+			// the same from the type of the name, resolved once for all the interactions of a term
+			enum InteractionType { UNKNOWN=0, BOND=1, ANGLE=2, UREY_BRADLEY=3, IMPROPER=4, DIHEDRAL=5, VDW=6, ELEC=7, EEF1=8, EEF1REF=9, IMM1REF=10 };
+			static InteractionType interactionType(const std::string & _name);
+			static Interaction * decodeInteraction(InteractionType _type, const std::vector<Atom*> & _atoms, const std::vector<double> & _values);
+
+			// binary values appended to a buffer / read from memory (false at the end of the data)
+			template <class T> static void put(std::string & _buffer, const T & _value);
+			static void putString(std::string & _buffer, const std::string & _value);
+			template <class T> static bool get(const char *& _pos, const char * _end, T & _value);
+			static bool getString(const char *& _pos, const char * _end, std::string & _value);
+	};
+
+	template <class T> inline void SystemSnapshotFormat::put(std::string & _buffer, const T & _value) {
+		_buffer.append((const char *)&_value, sizeof(T));
+	}
+	inline void SystemSnapshotFormat::putString(std::string & _buffer, const std::string & _value) {
+		put(_buffer, (unsigned int)_value.size());
+		_buffer.append(_value);
+	}
+	template <class T> inline bool SystemSnapshotFormat::get(const char *& _pos, const char * _end, T & _value) {
+		if (_end - _pos < (long)sizeof(T)) {
+			return false;
+		}
+		memcpy(&_value, _pos, sizeof(T));
+		_pos += sizeof(T);
+		return true;
+	}
+	inline bool SystemSnapshotFormat::getString(const char *& _pos, const char * _end, std::string & _value) {
+		unsigned int size = 0;
+		if (!get(_pos, _end, size) || _end - _pos < (long)size) {
+			return false;
+		}
+		_value.assign(_pos, size);
+		_pos += size;
+		return true;
+	}
+}
+
+#endif
@@ -0,0 +1,421 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "SystemSnapshotReader.h"
+#include "EnergySet.h"
+#include "IcTable.h"
+
+using namespace MSL;
+using namespace std;
+
+
+/*
+  The content of the snapshot is parsed first and the System is
+  created only when the whole file has been read
+ */
+namespace {
+struct SnapshotAtom {
+	string chain;
+	int resnum;
+	string icode;
+	string resName;
+	string name;
+	string element;
+	string type;
+	string segId;
+	double charge;
+	double radius;
+	double tempFactor;
+	unsigned int groupNumber;
+	char hasCoor;
+	vector<CartesianPoint> coor;
+	vector<CartesianPoint> hiddenCoor;
+	vector<unsigned int> hiddenIndices;
+	unsigned int active;
+};
+
+struct SnapshotIcEntry {
+	int atoms[4];
+	vector<double> vals;
+	char improper;
+};
+
+// the interactions are validated when parsed and created later from the content
+struct SnapshotTerm {
+	string name;
+	SystemSnapshotFormat::InteractionType type;
+	double weight;
+	char active;
+	unsigned int size;
+	const char * interactions;
+};
+}
+
+static bool truncatedSnapshot(const string & _file) {
+	cerr << "ERROR 11147: unexpected end of the data in System snapshot " << _file << endl;
+	return false;
+}
+
+static bool getPoint(const char *& _pos, const char * _end, CartesianPoint & _point) {
+	double x = 0.0;
+	double y = 0.0;
+	double z = 0.0;
+	if (!SystemSnapshotFormat::get(_pos, _end, x) || !SystemSnapshotFormat::get(_pos, _end, y) || !SystemSnapshotFormat::get(_pos, _end, z)) {
+		return false;
+	}
+	_point.setCoor(x, y, z);
+	return true;
+}
+
+bool SystemSnapshotReader::addSourceFile(string _file) {
+	unsigned long long sum = 0;
+	if (!SystemSnapshotFormat::fileChecksum(_file, sum)) {
+		cerr << "ERROR 11131: cannot read source file " << _file << " in bool SystemSnapshotReader::addSourceFile(string _file)" << endl;
+		return false;
+	}
+	sourceFiles.push_back(_file);
+	sourceChecksums.push_back(sum);
+	return true;
+}
+
+bool SystemSnapshotReader::read(System & _sys) {
+	if (_sys.getAllAtomPointers().size() != 0) {
+		cerr << "ERROR 11141: the System is not empty in bool SystemSnapshotReader::read(System & _sys)" << endl;
+		return false;
+	}
+	if (!loadContent()) {
+		cerr << "ERROR 11142: cannot read System snapshot " << fileName << endl;
+		return false;
+	}
+	bool result = readContent(_sys);
+	releaseContent();
+	return result;
+}
+
+bool SystemSnapshotReader::readContent(System & _sys) {
+	typedef SystemSnapshotFormat F;
+	const char * pos = contentBegin;
+	const char * end = contentEnd;
+
+	/*********************************************
+	 *  Header: check everything before parsing
+	 *********************************************/
+	unsigned int version = 0;
+	unsigned int byteOrder = 0;
+	unsigned long long size = 0;
+	unsigned long long sum = 0;
+	if (end - pos < (long)F::headerSize || memcmp(pos, F::magic(), 8) != 0) {
+		cerr << "ERROR 11143: " << fileName << " is not a System snapshot" << endl;
+		return false;
+	}
+	pos += 8;
+	F::get(pos, end, version);
+	F::get(pos, end, byteOrder);
+	F::get(pos, end, size);
+	F::get(pos, end, sum);
+	if (byteOrder != F::byteOrderMark) {
+		cerr << "ERROR 11144: System snapshot " << fileName << " was written on a machine with a different byte order" << endl;
+		return false;
+	}
+	if (version != F::version) {
+		cerr << "ERROR 11145: System snapshot " << fileName << " has format version " << version << ", expected " << F::version << endl;
+		return false;
+	}
+	if (size != (unsigned long long)(end - pos) || F::checksum(pos, size) != sum) {
+		cerr << "ERROR 11146: System snapshot " << fileName << " is corrupted (checksum mismatch)" << endl;
+		return false;
+	}
+
+	/*********************************************
+	 *  Source files: the snapshot is out of date
+	 *  if any of them has changed
+	 *********************************************/
+	unsigned int nSources = 0;
+	if (!F::get(pos, end, nSources)) {
+		return truncatedSnapshot(fileName);
+	}
+	vector<string> storedFiles(nSources);
+	vector<unsigned long long> storedChecksums(nSources, 0);
+	for (unsigned int i=0; i<nSources; i++) {
+		if (!F::getString(pos, end, storedFiles[i]) || !F::get(pos, end, storedChecksums[i])) {
+			return truncatedSnapshot(fileName);
+		}
+	}
+	if (sourceChecksums.size() > 0) {
+		if (sourceChecksums.size() != nSources) {
+			cerr << "WARNING 11148: System snapshot " << fileName << " was written from " << nSources << " source files, " << sourceChecksums.size() << " given" << endl;
+			return false;
+		}
+		for (unsigned int i=0; i<nSources; i++) {
+			if (sourceChecksums[i] != storedChecksums[i]) {
+				cerr << "WARNING 11148: System snapshot " << fileName << " is out of date, source file " << sourceFiles[i] << " has changed (was " << storedFiles[i] << ")" << endl;
+				return false;
+			}
+		}
+	}
+
+	/*********************************************
+	 *  Atoms
+	 *********************************************/
+	unsigned int nAtoms = 0;
+	if (!F::get(pos, end, nAtoms)) {
+		return truncatedSnapshot(fileName);
+	}
+	vector<SnapshotAtom> snapAtoms(nAtoms);
+	for (unsigned int i=0; i<nAtoms; i++) {
+		SnapshotAtom & a = snapAtoms[i];
+		if (!F::getString(pos, end, a.chain) || !F::get(pos, end, a.resnum) || !F::getString(pos, end, a.icode) || !F::getString(pos, end, a.resName) || !F::getString(pos, end, a.name) || !F::getString(pos, end, a.element) || !F::getString(pos, end, a.type) || !F::getString(pos, end, a.segId)) {
+			return truncatedSnapshot(fileName);
+		}
+		if (!F::get(pos, end, a.charge) || !F::get(pos, end, a.radius) || !F::get(pos, end, a.tempFactor) || !F::get(pos, end, a.groupNumber) || !F::get(pos, end, a.hasCoor)) {
+			return truncatedSnapshot(fileName);
+		}
+		unsigned int n = 0;
+		if (!F::get(pos, end, n) || (unsigned long long)(end - pos) < (unsigned long long)n * 3 * sizeof(double)) {
+			return truncatedSnapshot(fileName);
+		}
+		a.coor.resize(n);
+		for (unsigned int j=0; j<n; j++) {
+			getPoint(pos, end, a.coor[j]);
+		}
+		if (!F::get(pos, end, n) || (unsigned long long)(end - pos) < (unsigned long long)n * (sizeof(unsigned int) + 3 * sizeof(double))) {
+			return truncatedSnapshot(fileName);
+		}
+		a.hiddenCoor.resize(n);
+		a.hiddenIndices.resize(n);
+		for (unsigned int j=0; j<n; j++) {
+			F::get(pos, end, a.hiddenIndices[j]);
+			getPoint(pos, end, a.hiddenCoor[j]);
+		}
+		if (!F::get(pos, end, a.active)) {
+			return truncatedSnapshot(fileName);
+		}
+		if (a.active >= a.coor.size()) {
+			cerr << "ERROR 11149: invalid conformations for atom " << a.name << " in System snapshot " << fileName << endl;
+			return false;
+		}
+	}
+
+	/*********************************************
+	 *  Active identities
+	 *********************************************/
+	unsigned int nPositions = 0;
+	if (!F::get(pos, end, nPositions)) {
+		return truncatedSnapshot(fileName);
+	}
+	vector<int> activeIdentities(nPositions, 0);
+	for (unsigned int i=0; i<nPositions; i++) {
+		if (!F::get(pos, end, activeIdentities[i])) {
+			return truncatedSnapshot(fileName);
+		}
+	}
+
+	/*********************************************
+	 *  Bonds
+	 *********************************************/
+	unsigned int nBonds = 0;
+	if (!F::get(pos, end, nBonds) || (unsigned long long)(end - pos) < (unsigned long long)nBonds * 2 * sizeof(unsigned int)) {
+		return truncatedSnapshot(fileName);
+	}
+	vector<unsigned int> bonds(nBonds * 2, 0);
+	for (unsigned int i=0; i<bonds.size(); i++) {
+		F::get(pos, end, bonds[i]);
+		if (bonds[i] >= nAtoms) {
+			cerr << "ERROR 11149: invalid bond in System snapshot " << fileName << endl;
+			return false;
+		}
+	}
+
+	/*********************************************
+	 *  IC table
+	 *********************************************/
+	unsigned int nIc = 0;
+	if (!F::get(pos, end, nIc)) {
+		return truncatedSnapshot(fileName);
+	}
+	vector<SnapshotIcEntry> icEntries(nIc);
+	for (unsigned int i=0; i<nIc; i++) {
+		SnapshotIcEntry & ic = icEntries[i];
+		for (unsigned int j=0; j<4; j++) {
+			if (!F::get(pos, end, ic.atoms[j])) {
+				return truncatedSnapshot(fileName);
+			}
+			if (ic.atoms[j] >= (int)nAtoms || (ic.atoms[j] < 0 && (j == 1 || j == 2))) {
+				cerr << "ERROR 11149: invalid IC entry in System snapshot " << fileName << endl;
+				return false;
+			}
+		}
+		ic.vals = vector<double>(5, 0.0);
+		for (unsigned int j=0; j<5; j++) {
+			if (!F::get(pos, end, ic.vals[j])) {
+				return truncatedSnapshot(fileName);
+			}
+		}
+		if (!F::get(pos, end, ic.improper)) {
+			return truncatedSnapshot(fileName);
+		}
+	}
+
+	/*********************************************
+	 *  Energy terms
+	 *********************************************/
+	unsigned int nTerms = 0;
+	if (!F::get(pos, end, nTerms)) {
+		return truncatedSnapshot(fileName);
+	}
+	vector<SnapshotTerm> terms(nTerms);
+	for (unsigned int i=0; i<nTerms; i++) {
+		SnapshotTerm & t = terms[i];
+		unsigned int nInteractions = 0;
+		if (!F::getString(pos, end, t.name) || !F::get(pos, end, t.weight) || !F::get(pos, end, t.active) || !F::get(pos, end, nInteractions)) {
+			return truncatedSnapshot(fileName);
+		}
+		t.type = F::interactionType(t.name);
+		if (t.type == F::UNKNOWN && nInteractions > 0) {
+			cerr << "ERROR 11149: unknown term " << t.name << " in System snapshot " << fileName << endl;
+			return false;
+		}
+		t.size = nInteractions;
+		t.interactions = pos;
+		for (unsigned int j=0; j<nInteractions; j++) {
+			unsigned int n = 0;
+			if (!F::get(pos, end, n) || (unsigned long long)(end - pos) < (unsigned long long)n * sizeof(unsigned int)) {
+				return truncatedSnapshot(fileName);
+			}
+			for (unsigned int k=0; k<n; k++) {
+				unsigned int index = 0;
+				F::get(pos, end, index);
+				if (index >= nAtoms) {
+					cerr << "ERROR 11149: invalid " << t.name << " interaction in System snapshot " << fileName << endl;
+					return false;
+				}
+			}
+			if (!F::get(pos, end, n) || (unsigned long long)(end - pos) < (unsigned long long)n * sizeof(double)) {
+				return truncatedSnapshot(fileName);
+			}
+			pos += n * sizeof(double);
+		}
+	}
+
+	/*********************************************
+	 *  Create the System: the atoms are added in
+	 *  the order they were written (by position,
+	 *  identity and atom), the order is verified
+	 *********************************************/
+	AtomPointerVector newAtoms;
+	newAtoms.reserve(nAtoms);
+	for (unsigned int i=0; i<nAtoms; i++) {
+		SnapshotAtom & a = snapAtoms[i];
+		Atom * pAtom = new Atom;
+		pAtom->setChainId(a.chain);
+		pAtom->setResidueNumber(a.resnum);
+		pAtom->setResidueIcode(a.icode);
+		pAtom->setResidueName(a.resName);
+		pAtom->setName(a.name);
+		pAtom->setElement(a.element);
+		pAtom->setType(a.type);
+		pAtom->setSegID(a.segId);
+		pAtom->setCharge(a.charge);
+		pAtom->setRadius(a.radius);
+		pAtom->setTempFactor(a.tempFactor);
+		pAtom->setGroupNumber(a.groupNumber);
+		newAtoms.push_back(pAtom);
+	}
+	_sys.addAtoms(newAtoms, true);
+	for (AtomPointerVector::iterator k=newAtoms.begin(); k!=newAtoms.end(); k++) {
+		delete *k;
+	}
+
+	AtomPointerVector & atoms = _sys.getAllAtomPointers();
+	if (atoms.size() != nAtoms || _sys.positionSize() != nPositions) {
+		cerr << "ERROR 11150: the atoms of System snapshot " << fileName << " could not be recreated" << endl;
+		return false;
+	}
+	for (unsigned int i=0; i<nAtoms; i++) {
+		SnapshotAtom & a = snapAtoms[i];
+		Atom & atom = *atoms[i];
+		if (atom.getName() != a.name || atom.getResidueName() != a.resName || atom.getResidueNumber() != a.resnum || atom.getChainId() != a.chain || atom.getResidueIcode() != a.icode) {
+			cerr << "ERROR 11150: the atoms of System snapshot " << fileName << " could not be recreated in the same order" << endl;
+			return false;
+		}
+		atom.setConformationState(a.coor, a.hiddenCoor, a.hiddenIndices, a.active);
+		atom.setHasCoordinates(a.hasCoor != 0);
+	}
+	for (unsigned int i=0; i<nPositions; i++) {
+		_sys.getPosition(i).setActiveIdentity(activeIdentities[i], false);
+	}
+
+	for (unsigned int i=0; i<bonds.size(); i+=2) {
+		atoms[bonds[i]]->setBoundTo(atoms[bonds[i+1]]);
+	}
+
+	for (unsigned int i=0; i<nIc; i++) {
+		SnapshotIcEntry & ic = icEntries[i];
+		Atom * icAtoms[4];
+		for (unsigned int j=0; j<4; j++) {
+			icAtoms[j] = ic.atoms[j] < 0 ? NULL : atoms[ic.atoms[j]];
+		}
+		_sys.addIcEntry(icAtoms[0], icAtoms[1], icAtoms[2], icAtoms[3], 0.0, 0.0, 0.0, 0.0, 0.0, ic.improper != 0);
+		// the values are stored as they are (angles in radians)
+		_sys.getIcTable().back()->getValues() = ic.vals;
+	}
+
+	EnergySet * pESet = _sys.getEnergySet();
+	vector<Atom*> interactionAtoms;
+	vector<double> values;
+	for (unsigned int i=0; i<nTerms; i++) {
+		SnapshotTerm & t = terms[i];
+		pos = t.interactions;
+		for (unsigned int j=0; j<t.size; j++) {
+			unsigned int n = 0;
+			F::get(pos, end, n);
+			interactionAtoms.resize(n);
+			for (unsigned int k=0; k<n; k++) {
+				unsigned int index = 0;
+				F::get(pos, end, index);
+				interactionAtoms[k] = atoms[index];
+			}
+			F::get(pos, end, n);
+			values.resize(n);
+			for (unsigned int k=0; k<n; k++) {
+				F::get(pos, end, values[k]);
+			}
+			Interaction * pInteraction = F::decodeInteraction(t.type, interactionAtoms, values);
+			if (pInteraction == NULL) {
+				cerr << "ERROR 11151: cannot create " << t.name << " interaction from System snapshot " << fileName << endl;
+				return false;
+			}
+			pESet->addInteraction(pInteraction);
+		}
+		pESet->setWeight(t.name, t.weight);
+		pESet->setTermActive(t.name, t.active != 0);
+	}
+
+	return true;
+}
@@ -0,0 +1,81 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef SYSTEMSNAPSHOTREADER_H
+#define SYSTEMSNAPSHOTREADER_H
+/*
+  Loads a System saved by SystemSnapshotWriter.  The file is memory
+  mapped and validated (format version, byte order, checksum of the
+  content) before anything is created; if source files are given,
+  their checksums must match the ones the snapshot was written from,
+  otherwise the snapshot is out of date and read() returns false so
+  that the caller can rebuild the System from the inputs.
+ */
+// MSL Includes
+#include "Reader.h"
+#include "System.h"
+#include "SystemSnapshotFormat.h"
+
+// STL Includes
+#include <vector>
+#include <string>
+
+namespace MSL { 
+class SystemSnapshotReader : public Reader {
+	public:
+		// Constructors/Destructors
+		SystemSnapshotReader();
+		SystemSnapshotReader(const std::string &_filename);
+		SystemSnapshotReader(std::stringstream &_stream);
+		virtual ~SystemSnapshotReader();
+
+		// the current input files, in the same order given to the writer (false if the file cannot be read)
+		bool addSourceFile(std::string _file);
+		void clearSourceFiles();
+
+		// loads the snapshot into an empty System
+		bool read(System & _sys);
+
+	protected:		
+	private:
+		bool readContent(System & _sys);
+
+		std::vector<std::string> sourceFiles;
+		std::vector<unsigned long long> sourceChecksums;
+};
+
+//Inlines go HERE
+inline SystemSnapshotReader::SystemSnapshotReader() : Reader() {}
+inline SystemSnapshotReader::SystemSnapshotReader(const std::string &_filename) : Reader(_filename) {}
+inline SystemSnapshotReader::SystemSnapshotReader(std::stringstream &_stream) : Reader(_stream) {}
+inline SystemSnapshotReader::~SystemSnapshotReader() {}
+inline void SystemSnapshotReader::clearSourceFiles() {sourceFiles.clear(); sourceChecksums.clear();}
+}
+
+#endif
@@ -0,0 +1,216 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "SystemSnapshotWriter.h"
+#include "EnergySet.h"
+#include "IcTable.h"
+
+#include <map>
+#include <algorithm>
+
+using namespace MSL;
+using namespace std;
+
+
+bool SystemSnapshotWriter::addSourceFile(string _file) {
+	unsigned long long sum = 0;
+	if (!SystemSnapshotFormat::fileChecksum(_file, sum)) {
+		cerr << "ERROR 11131: cannot read source file " << _file << " in bool SystemSnapshotWriter::addSourceFile(string _file)" << endl;
+		return false;
+	}
+	sourceFiles.push_back(_file);
+	sourceChecksums.push_back(sum);
+	return true;
+}
+
+bool SystemSnapshotWriter::write(System & _sys) {
+	typedef SystemSnapshotFormat F;
+
+	// what the snapshot cannot restore is refused before anything is written
+	for (unsigned int i=0; i<_sys.positionSize(); i++) {
+		Position & pos = _sys.getPosition(i);
+		if (pos.getLinkedPositionType() != Position::UNLINKED) {
+			cerr << "ERROR 11135: position " << pos.getPositionId() << " is linked, linked positions cannot be stored in bool SystemSnapshotWriter::write(System & _sys)" << endl;
+			return false;
+		}
+		if (pos.hiddenIdentitySize() > 0) {
+			cerr << "ERROR 11136: position " << pos.getPositionId() << " has hidden identities, unhide them before writing in bool SystemSnapshotWriter::write(System & _sys)" << endl;
+			return false;
+		}
+	}
+	EnergySet * pESet = _sys.getEnergySet();
+	map<string, vector<Interaction*> > * terms = pESet->getEnergyTerms();
+	if (terms->find("CHARMM_IMM1") != terms->end() && (*terms)["CHARMM_IMM1"].size() > 0) {
+		cerr << "ERROR 11137: IMM1 interactions cannot be stored in bool SystemSnapshotWriter::write(System & _sys)" << endl;
+		return false;
+	}
+
+	string payload;
+
+	// source files
+	F::put(payload, (unsigned int)sourceFiles.size());
+	for (unsigned int i=0; i<sourceFiles.size(); i++) {
+		F::putString(payload, sourceFiles[i]);
+		F::put(payload, sourceChecksums[i]);
+	}
+
+	// the atoms of all identities, with all their conformations
+	AtomPointerVector & atoms = _sys.getAllAtomPointers();
+	map<Atom*, int> atomIndex;
+	vector<CartesianPoint> coor;
+	vector<CartesianPoint> hiddenCoor;
+	vector<unsigned int> hiddenIndices;
+	unsigned int active = 0;
+	F::put(payload, (unsigned int)atoms.size());
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		Atom & a = *atoms[i];
+		atomIndex[atoms[i]] = i;
+		F::putString(payload, a.getChainId());
+		F::put(payload, a.getResidueNumber());
+		F::putString(payload, a.getResidueIcode());
+		F::putString(payload, a.getResidueName());
+		F::putString(payload, a.getName());
+		F::putString(payload, a.getElement());
+		F::putString(payload, a.getType());
+		F::putString(payload, a.getSegID());
+		F::put(payload, (double)a.getCharge());
+		F::put(payload, (double)a.getRadius());
+		F::put(payload, (double)a.getTempFactor());
+		F::put(payload, a.getGroupNumber());
+		F::put(payload, (char)a.hasCoor());
+
+		a.getConformationState(coor, hiddenCoor, hiddenIndices, active);
+		F::put(payload, (unsigned int)coor.size());
+		for (unsigned int j=0; j<coor.size(); j++) {
+			F::put(payload, (double)coor[j].getX());
+			F::put(payload, (double)coor[j].getY());
+			F::put(payload, (double)coor[j].getZ());
+		}
+		F::put(payload, (unsigned int)hiddenCoor.size());
+		for (unsigned int j=0; j<hiddenCoor.size(); j++) {
+			F::put(payload, hiddenIndices[j]);
+			F::put(payload, (double)hiddenCoor[j].getX());
+			F::put(payload, (double)hiddenCoor[j].getY());
+			F::put(payload, (double)hiddenCoor[j].getZ());
+		}
+		F::put(payload, active);
+	}
+
+	// active identities
+	F::put(payload, _sys.positionSize());
+	for (unsigned int i=0; i<_sys.positionSize(); i++) {
+		F::put(payload, _sys.getPosition(i).getActiveIdentity());
+	}
+
+	// bonds, each pair once, sorted (the order of getBonds depends on how the bonds were made)
+	vector<unsigned int> bonds;
+	vector<unsigned int> partners;
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		vector<Atom*> bonded = atoms[i]->getBonds();
+		partners.clear();
+		for (unsigned int j=0; j<bonded.size(); j++) {
+			map<Atom*, int>::iterator found = atomIndex.find(bonded[j]);
+			if (found != atomIndex.end() && (unsigned int)found->second > i) {
+				partners.push_back(found->second);
+			}
+		}
+		sort(partners.begin(), partners.end());
+		for (unsigned int j=0; j<partners.size(); j++) {
+			bonds.push_back(i);
+			bonds.push_back(partners[j]);
+		}
+	}
+	F::put(payload, (unsigned int)bonds.size() / 2);
+	for (unsigned int i=0; i<bonds.size(); i++) {
+		F::put(payload, bonds[i]);
+	}
+
+	// IC table
+	IcTable & icTable = _sys.getIcTable();
+	F::put(payload, (unsigned int)icTable.size());
+	for (IcTable::iterator k=icTable.begin(); k!=icTable.end(); k++) {
+		Atom * icAtoms[4] = {(*k)->getAtom1(), (*k)->getAtom2(), (*k)->getAtom3(), (*k)->getAtom4()};
+		for (unsigned int j=0; j<4; j++) {
+			int index = -1;
+			if (icAtoms[j] != NULL) {
+				map<Atom*, int>::iterator found = atomIndex.find(icAtoms[j]);
+				if (found == atomIndex.end()) {
+					cerr << "ERROR 11132: IC entry " << **k << " has an atom that is not in the System in bool SystemSnapshotWriter::write(System & _sys)" << endl;
+					return false;
+				}
+				index = found->second;
+			}
+			F::put(payload, index);
+		}
+		vector<double> & vals = (*k)->getValues();
+		for (unsigned int j=0; j<5; j++) {
+			F::put(payload, vals[j]);
+		}
+		F::put(payload, (char)(*k)->isImproper());
+	}
+
+	// energy terms
+	vector<double> values;
+	F::put(payload, (unsigned int)terms->size());
+	for (map<string, vector<Interaction*> >::iterator k=terms->begin(); k!=terms->end(); k++) {
+		F::putString(payload, k->first);
+		F::put(payload, pESet->getWeight(k->first));
+		F::put(payload, (char)pESet->isTermActive(k->first));
+		F::put(payload, (unsigned int)k->second.size());
+		for (vector<Interaction*>::iterator l=k->second.begin(); l!=k->second.end(); l++) {
+			if (!F::encodeInteraction(**l, values)) {
+				cerr << "ERROR 11133: interaction type " << (*l)->getName() << " cannot be stored in bool SystemSnapshotWriter::write(System & _sys)" << endl;
+				return false;
+			}
+			vector<Atom*> & pAtoms = (*l)->getAtomPointers();
+			F::put(payload, (unsigned int)pAtoms.size());
+			for (unsigned int j=0; j<pAtoms.size(); j++) {
+				map<Atom*, int>::iterator found = atomIndex.find(pAtoms[j]);
+				if (found == atomIndex.end()) {
+					cerr << "ERROR 11134: " << (*l)->getName() << " interaction with an atom that is not in the System in bool SystemSnapshotWriter::write(System & _sys)" << endl;
+					return false;
+				}
+				F::put(payload, (unsigned int)found->second);
+			}
+			F::put(payload, (unsigned int)values.size());
+			for (unsigned int j=0; j<values.size(); j++) {
+				F::put(payload, values[j]);
+			}
+		}
+	}
+
+	// header
+	string header(F::magic(), 8);
+	F::put(header, (unsigned int)F::version);
+	F::put(header, (unsigned int)F::byteOrderMark);
+	F::put(header, (unsigned long long)payload.size());
+	F::put(header, F::checksum(payload.data(), payload.size()));
+
+	return Writer::write(header) && Writer::write(payload);
+}
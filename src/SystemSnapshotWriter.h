@@ -0,0 +1,81 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef SYSTEMSNAPSHOTWRITER_H
+#define SYSTEMSNAPSHOTWRITER_H
+/*
+  Writes a built System (atoms with all their conformations,
+  identities, bonds, IC table and energy terms) to a binary
+  snapshot that SystemSnapshotReader loads without rebuilding
+  from topology and parameter files.  See SystemSnapshotFormat
+  for the layout.
+ */
+// MSL Includes
+#include "Writer.h"
+#include "System.h"
+#include "SystemSnapshotFormat.h"
+
+// STL Includes
+#include <vector>
+#include <string>
+
+namespace MSL { 
+class SystemSnapshotWriter : public Writer {
+	public:
+		// Constructors/Destructors
+		SystemSnapshotWriter();
+		SystemSnapshotWriter(const std::string &_filename);
+		virtual ~SystemSnapshotWriter();
+
+		/*
+		  The input files the System was built from (topology, parameters,
+		  PDB...): their checksum is stored so that the reader can tell if
+		  the snapshot is still current.  False if the file cannot be read
+		 */
+		bool addSourceFile(std::string _file);
+		void clearSourceFiles();
+
+		// false, without writing, if the System has linked positions, hidden identities,
+		// IMM1 or any other interaction that cannot be stored
+		bool write(System & _sys);
+
+	protected:		
+	private:
+		std::vector<std::string> sourceFiles;
+		std::vector<unsigned long long> sourceChecksums;
+};
+
+//Inlines go HERE
+inline SystemSnapshotWriter::SystemSnapshotWriter() : Writer() {}
+inline SystemSnapshotWriter::SystemSnapshotWriter(const std::string &_filename) : Writer(_filename) {}
+inline SystemSnapshotWriter::~SystemSnapshotWriter() {}
+inline void SystemSnapshotWriter::clearSourceFiles() {sourceFiles.clear(); sourceChecksums.clear();}
+}
+
+#endif
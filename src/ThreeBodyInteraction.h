@@ -57,7 +57,8 @@ class ThreeBodyInteraction: public Interaction {
 		double getAngle() const;
 		double getAngleRadians() const;
 		
-		bool isSelected(std::string _selection1, std::string _selection2) const;
+		bool isSelected(unsigned int _selection1, unsigned int _selection2) const;
+		using Interaction::isSelected;
 		bool isActive() const;
 
 		virtual double getEnergy()=0;
@@ -77,7 +78,7 @@ inline void ThreeBodyInteraction::setAtoms(std::vector<Atom*> _atoms) { if (_ato
 inline void ThreeBodyInteraction::setAtoms(Atom & _a1, Atom & _a2, Atom & _a3) { pAtoms[0] = &_a1; pAtoms[1] = &_a2; pAtoms[2] = &_a3; }
 inline double ThreeBodyInteraction::getAngle() const {return pAtoms[0]->angle(*pAtoms[1], *pAtoms[2]);}
 inline double ThreeBodyInteraction::getAngleRadians() const {return pAtoms[0]->angleRadians(*pAtoms[1], *pAtoms[2]);}
-inline bool ThreeBodyInteraction::isSelected(std::string _selection1, std::string _selection2) const {
+inline bool ThreeBodyInteraction::isSelected(unsigned int _selection1, unsigned int _selection2) const {
 	if (pAtoms[1]->getSelectionFlag(_selection1) && pAtoms[1]->getSelectionFlag(_selection2)) {
 		return true;
 	} else {
@@ -36,11 +36,7 @@ static MslOut MSLOUT("Transforms");
 
 Transforms::Transforms() {
 
-	frame["O"] = CartesianPoint(0.0, 0.0, 0.0);
-	frame["X"] = CartesianPoint(1.0, 0.0, 0.0);
-	frame["Y"] = CartesianPoint(0.0, 1.0, 0.0);
-
-	lastRotMatrix = Matrix(3, 3, 0.0);
+	lastRotation = Rotation3(0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
 	lastTranslation = CartesianPoint(0,0,0);
 	saveHistory_flag = false;
 	transformAllCoors_flag = true;
@@ -50,8 +46,8 @@ Transforms::Transforms() {
 
 Transforms::Transforms(const Transforms & _transform) {
 	saveHistory_flag = _transform.saveHistory_flag;
-	frame = _transform.frame;
-	lastRotMatrix = _transform.lastRotMatrix;
+	history = _transform.history;
+	lastRotation = _transform.lastRotation;
 	lastTranslation = _transform.lastTranslation;
 	transformAllCoors_flag = _transform.transformAllCoors_flag;
 	naturalMovementOnSetDOF_flag = _transform.naturalMovementOnSetDOF_flag;
@@ -76,23 +72,31 @@ void Transforms::translateAtom(Atom & _atom, const CartesianPoint & _p) {
 	}
 }
 
-void Transforms::rotateAtom(Atom & _atom, const Matrix & _rotMatrix, const CartesianPoint & _rotCenter) {
+void Transforms::rotateAtom(Atom & _atom, const Rotation3 & _rot, const CartesianPoint & _rotCenter) {
 	if (transformAllCoors_flag) {
 		for (vector<CartesianPoint *>::iterator m=_atom.getAllCoor().begin(); m!=_atom.getAllCoor().end(); m++) {
-			*(*m) -= _rotCenter;
-			*(*m) *= _rotMatrix;
-			*(*m) += _rotCenter;
+			_rot.apply(*(*m), _rotCenter);
 		}
 		// hidden alt coors
 		for (vector<CartesianPoint *>::iterator m=_atom.getHiddenCoor().begin(); m!=_atom.getHiddenCoor().end(); m++) {
-			*(*m) -= _rotCenter;
-			*(*m) *= _rotMatrix;
-			*(*m) += _rotCenter;
+			_rot.apply(*(*m), _rotCenter);
 		}
 	} else {
-		_atom.getCoor() -= _rotCenter;
-		_atom.getCoor() *= _rotMatrix;
-		_atom.getCoor() += _rotCenter;
+		_rot.apply(_atom.getCoor(), _rotCenter);
+	}
+}
+
+void Transforms::transformAtom(Atom & _atom, const RigidTransform & _transform) {
+	if (transformAllCoors_flag) {
+		for (vector<CartesianPoint *>::iterator m=_atom.getAllCoor().begin(); m!=_atom.getAllCoor().end(); m++) {
+			_transform.apply(*(*m));
+		}
+		// hidden alt coors
+		for (vector<CartesianPoint *>::iterator m=_atom.getHiddenCoor().begin(); m!=_atom.getHiddenCoor().end(); m++) {
+			_transform.apply(*(*m));
+		}
+	} else {
+		_transform.apply(_atom.getCoor());
 	}
 }
 
@@ -107,16 +111,12 @@ bool Transforms::alignAtom(Atom & _atom, const CartesianPoint & _target, const C
 			for (unsigned int i=0; i<pts.size(); i++) {
 				// the active was already transformed
 				if (i != active) {
-					*pts[i] -= _rotCenter;
-					*pts[i] *= lastRotMatrix;
-					*pts[i] += _rotCenter;
+					lastRotation.apply(*pts[i], _rotCenter);
 				}
 			}
 			// hidden alt coors
 			for (vector<CartesianPoint *>::iterator m=_atom.getHiddenCoor().begin(); m!=_atom.getHiddenCoor().end(); m++) {
-				*(*m) -= _rotCenter;
-				*(*m) *= lastRotMatrix;
-				*(*m) += _rotCenter;
+				lastRotation.apply(*(*m), _rotCenter);
 			}
 		}
 		return true;
@@ -133,16 +133,12 @@ bool Transforms::orientAtom(Atom & _atom, const CartesianPoint & _target, const
 			for (unsigned int i=0; i<pts.size(); i++) {
 				// the active was already transformed
 				if (i != active) {
-					*pts[i] -= _axis1;
-					*pts[i] *= lastRotMatrix;
-					*pts[i] += _axis1;
+					lastRotation.apply(*pts[i], _axis1);
 				}
 			}
 			// hidden alt coors
 			for (vector<CartesianPoint *>::iterator m=_atom.getHiddenCoor().begin(); m!=_atom.getHiddenCoor().end(); m++) {
-				*(*m) -= _axis1;
-				*(*m) *= lastRotMatrix;
-				*(*m) += _axis1;
+				lastRotation.apply(*(*m), _axis1);
 			}
 		}
 		return true;
@@ -156,68 +152,65 @@ bool Transforms::orientAtom(Atom & _atom, const CartesianPoint & _target, const
 void Transforms::translate(Atom & _atom, const CartesianPoint & _p) {
 	translateAtom(_atom, _p);
 	if (saveHistory_flag) {
-		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-			k->second += _p;
-		}
+		history.translate(_p);
 	}
 	lastTranslation = _p;
 }
 
 void Transforms::Xrotate(Atom & _atom, double _degrees) {
-	lastRotMatrix = CartesianGeometry::getXRotationMatrix(_degrees);
-	rotateAtom(_atom, lastRotMatrix);
+	lastRotation = CartesianGeometry::getXRotation(_degrees);
+	rotateAtom(_atom, lastRotation);
 	if (saveHistory_flag) {
-		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-			k->second *= lastRotMatrix;
-		}
+		history.rotate(lastRotation);
 	}
 }
 
 void Transforms::Yrotate(Atom & _atom, double _degrees) {
-	lastRotMatrix = CartesianGeometry::getYRotationMatrix(_degrees);
-	rotateAtom(_atom, lastRotMatrix);
+	lastRotation = CartesianGeometry::getYRotation(_degrees);
+	rotateAtom(_atom, lastRotation);
 	if (saveHistory_flag) {
-		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-			k->second *= lastRotMatrix;
-		}
+		history.rotate(lastRotation);
 	}
 }
 
 void Transforms::Zrotate(Atom & _atom, double _degrees) {
-	lastRotMatrix = CartesianGeometry::getZRotationMatrix(_degrees);
-	rotateAtom(_atom, lastRotMatrix);
+	lastRotation = CartesianGeometry::getZRotation(_degrees);
+	rotateAtom(_atom, lastRotation);
 	if (saveHistory_flag) {
-		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-			k->second *= lastRotMatrix;
-		}
+		history.rotate(lastRotation);
 	}
 }
 
 void Transforms::rotate(Atom & _atom, double _degrees, const CartesianPoint & _axisFromRotCenter, const CartesianPoint & _rotCenter) {
-	Matrix m = CartesianGeometry::getRotationMatrix(_degrees, _axisFromRotCenter - _rotCenter);
+	Rotation3 m = CartesianGeometry::getRotation(_degrees, _axisFromRotCenter - _rotCenter);
 	rotate(_atom, m, _rotCenter);
 }
 
 void Transforms::rotate(Atom & _atom, const Matrix & _rotMatrix, const CartesianPoint & _rotCenter) {
-	rotateAtom(_atom, _rotMatrix, _rotCenter);
+	rotate(_atom, Rotation3(_rotMatrix), _rotCenter);
+}
+
+void Transforms::rotate(Atom & _atom, const Rotation3 & _rot, const CartesianPoint & _rotCenter) {
+	rotateAtom(_atom, _rot, _rotCenter);
 	if (saveHistory_flag) {
-		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-			k->second -= _rotCenter;
-			k->second *= _rotMatrix;
-			k->second += _rotCenter;
-		}
+		history.rotate(_rot, _rotCenter);
 	}
-	lastRotMatrix = _rotMatrix;
+	lastRotation = _rot;
+}
+
+void Transforms::transform(Atom & _atom, const RigidTransform & _transform) {
+	transformAtom(_atom, _transform);
+	if (saveHistory_flag) {
+		history = _transform * history;
+	}
+	lastRotation = _transform.getRotation();
+	lastTranslation = _transform.getTranslation();
 }
 
 bool Transforms::align(Atom & _atom, const CartesianPoint & _target, const CartesianPoint & _rotCenter) {
 	if (alignAtom(_atom, _target, _rotCenter)) {
 		if (saveHistory_flag) {
-			for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-				k->second -= _rotCenter;
-				k->second *= lastRotMatrix;
-				k->second += _rotCenter;
-			}
+			history.rotate(lastRotation, _rotCenter);
 		}
 		return true;
 	}
@@ -227,11 +220,7 @@ bool Transforms::align(Atom & _atom, const CartesianPoint & _target, const Carte
 bool Transforms::orient(Atom & _atom, const CartesianPoint & _target, const CartesianPoint & _axis1, const CartesianPoint & _axis2) {
 	if (orientAtom(_atom, _target, _axis1, _axis2)) {
 		if (saveHistory_flag) {
-			for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-				k->second -= _axis1;
-				k->second *= lastRotMatrix;
-				k->second += _axis1;
-			}
+			history.rotate(lastRotation, _axis1);
 		}
 		return true;
 	}
@@ -243,69 +232,89 @@ void Transforms::translate(AtomPointerVector & _atoms, CartesianPoint _p) {
 		translateAtom(*(*k), _p);
 	} 
 	if (saveHistory_flag) {
-		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-			k->second += _p;
-		}
+		history.translate(_p);
 	}
 	lastTranslation = _p;
 }
 
 void Transforms::Xrotate(AtomPointerVector & _atoms, double _degrees) {
-	lastRotMatrix = CartesianGeometry::getXRotationMatrix(_degrees);
+	lastRotation = CartesianGeometry::getXRotation(_degrees);
 
 	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-		rotateAtom(*(*k), lastRotMatrix);
+		rotateAtom(*(*k), lastRotation);
 	} 
 	if (saveHistory_flag) {
-		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-			k->second *= lastRotMatrix;
-		}
+		history.rotate(lastRotation);
 	}
 }
 
 void Transforms::Yrotate(AtomPointerVector & _atoms, double _degrees) {
-	lastRotMatrix = CartesianGeometry::getYRotationMatrix(_degrees);
+	lastRotation = CartesianGeometry::getYRotation(_degrees);
 
 	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-		rotateAtom(*(*k), lastRotMatrix);
+		rotateAtom(*(*k), lastRotation);
 	} 
 	if (saveHistory_flag) {
-		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-			k->second *= lastRotMatrix;
-		}
+		history.rotate(lastRotation);
 	}
 }
 
 void Transforms::Zrotate(AtomPointerVector & _atoms, double _degrees) {
-	lastRotMatrix = CartesianGeometry::getZRotationMatrix(_degrees);
+	lastRotation = CartesianGeometry::getZRotation(_degrees);
 
 	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-		rotateAtom(*(*k), lastRotMatrix);
+		rotateAtom(*(*k), lastRotation);
 	} 
 	if (saveHistory_flag) {
-		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-			k->second *= lastRotMatrix;
-		}
+		history.rotate(lastRotation);
 	}
 }
 
 void Transforms::rotate(AtomPointerVector & _atoms, double _degrees, const CartesianPoint & _axisFromRotCenter, const CartesianPoint & _rotCenter) {
-	Matrix m = CartesianGeometry::getRotationMatrix(_degrees, _axisFromRotCenter - _rotCenter);
+	Rotation3 m = CartesianGeometry::getRotation(_degrees, _axisFromRotCenter - _rotCenter);
 	rotate(_atoms, m, _rotCenter);
 }
 
 void Transforms::rotate(AtomPointerVector & _atoms, const Matrix & _rotMatrix, const CartesianPoint & _rotCenter) {
+	rotate(_atoms, Rotation3(_rotMatrix), _rotCenter);
+}
+
+void Transforms::rotate(AtomPointerVector & _atoms, const Rotation3 & _rot, const CartesianPoint & _rotCenter) {
 	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-		rotateAtom(*(*k), _rotMatrix, _rotCenter);
+		rotateAtom(*(*k), _rot, _rotCenter);
 	} 
 	if (saveHistory_flag) {
-		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-			k->second -= _rotCenter;
-			k->second *= _rotMatrix;
-			k->second += _rotCenter;
-		}
+		history.rotate(_rot, _rotCenter);
+	}
+	lastRotation = _rot;
+}
+
+void Transforms::transform(AtomPointerVector & _atoms, const RigidTransform & _transform) {
+	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
+		transformAtom(*(*k), _transform);
+	} 
+	if (saveHistory_flag) {
+		history = _transform * history;
+	}
+	lastRotation = _transform.getRotation();
+	lastTranslation = _transform.getTranslation();
+}
+
+void Transforms::rotate(double * _coor, unsigned int _nPoints, const Rotation3 & _rot, const CartesianPoint & _rotCenter) {
+	_rot.apply(_coor, _nPoints, _rotCenter);
+	if (saveHistory_flag) {
+		history.rotate(_rot, _rotCenter);
 	}
-	lastRotMatrix = _rotMatrix;
+	lastRotation = _rot;
+}
+
+void Transforms::transform(double * _coor, unsigned int _nPoints, const RigidTransform & _transform) {
+	_transform.apply(_coor, _nPoints);
+	if (saveHistory_flag) {
+		history = _transform * history;
+	}
+	lastRotation = _transform.getRotation();
+	lastTranslation = _transform.getTranslation();
 }
 
 
@@ -313,14 +322,10 @@ bool Transforms::align(AtomPointerVector & _atoms, const CartesianPoint & _refer
 	CartesianPoint refCopy(_reference);
 	if (align(refCopy, _target, _rotCenter)) {
 		for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-			rotateAtom(*(*k), lastRotMatrix, _rotCenter);
+			rotateAtom(*(*k), lastRotation, _rotCenter);
 		}
 		if (saveHistory_flag) {
-			for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-				k->second -= _rotCenter;
-				k->second *= lastRotMatrix;
-				k->second += _rotCenter;
-			}
+			history.rotate(lastRotation, _rotCenter);
 		}
 		return true;
 	}
@@ -337,10 +342,7 @@ bool Transforms::align(CartesianPoint & _object, const CartesianPoint & _target,
 	 *         the rotation around axis is the same value 'angle'
 	 *         of the dihedral, and not '-angle'
 	 ***********************************************************/
-	lastRotMatrix = Matrix(3, 3, 0.0);
-	lastRotMatrix[0][0] = 1;
-	lastRotMatrix[1][1] = 1;
-	lastRotMatrix[2][2] = 1;
+	lastRotation = Rotation3();
 	
 	CartesianPoint newTarget = _target - _rotCenter;
 	if (newTarget.length() == 0) {
@@ -359,9 +361,9 @@ bool Transforms::align(CartesianPoint & _object, const CartesianPoint & _target,
 		// they are parallel
 		if (_object * newTarget < 0.0) {
 			// they are anti-parallel
-			lastRotMatrix[0][0] = -1;
-			lastRotMatrix[1][1] = -1;
-			lastRotMatrix[2][2] = -1;
+			lastRotation[0][0] = -1;
+			lastRotation[1][1] = -1;
+			lastRotation[2][2] = -1;
 		} else {
 			// they are parallel, nothing to do
 			_object += _rotCenter;
@@ -372,9 +374,9 @@ bool Transforms::align(CartesianPoint & _object, const CartesianPoint & _target,
 		 * Use the cross product to define the axis or rotation
 		 *********************************************/
 		double degrees = CartesianGeometry::angle(_object, newTarget);
-		lastRotMatrix = CartesianGeometry::getRotationMatrix(degrees, cx);
+		lastRotation = CartesianGeometry::getRotation(degrees, cx);
 	}
-	_object *= lastRotMatrix;
+	lastRotation.apply(_object);
 	_object += _rotCenter;
 	return true;
 
@@ -385,7 +387,7 @@ bool Transforms::orient(AtomPointerVector & _atoms, const CartesianPoint & _refe
 	CartesianPoint refCopy(_reference);
 	if (orient(refCopy, _target, _axis1, _axis2)) {
 		for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-			rotateAtom(*(*k), lastRotMatrix, _axis1);
+			rotateAtom(*(*k), lastRotation, _axis1);
 		}
 		return true;
 	}
@@ -412,17 +414,12 @@ bool Transforms::orient(CartesianPoint & _object, const CartesianPoint & _target
 	 ****************************************/
 
 	if (_axis2 == _axis1 || _axis2 == _target || _axis1 == _target) {
-		lastRotMatrix = Matrix(3, 3, 0.0);
-		lastRotMatrix[0][0] = 1;
-		lastRotMatrix[1][1] = 1;
-		lastRotMatrix[2][2] = 1;
+		lastRotation = Rotation3();
 		return false;
 	}
 	double degrees = CartesianGeometry::dihedral(_object, _axis1, _axis2, _target);
-	lastRotMatrix = CartesianGeometry::getRotationMatrix(degrees, _axis2 - _axis1);
-	_object -= _axis1;
-	_object *= lastRotMatrix;
-	_object += _axis1;
+	lastRotation = CartesianGeometry::getRotation(degrees, _axis2 - _axis1);
+	lastRotation.apply(_object, _axis1);
 
 	return true;
 
@@ -551,25 +548,25 @@ bool Transforms::rmsdAlignment(AtomPointerVector &_align, AtomPointerVector &_re
 	// Create a quaternion that minimizes the RMSD between two sets of points (COM1, COM2 center-of-mass get defined as well)
 	if (!q.makeQuaternion(_align,_ref)) return false;
 
-	q.convertToRotationMatrix(lastRotMatrix);
+	Matrix quaternionRotation(3, 3, 0.0);
+	q.convertToRotationMatrix(quaternionRotation);
+	lastRotation = Rotation3(quaternionRotation);
 
 	CartesianPoint GC1 = _ref.getGeometricCenter();
 	CartesianPoint GC2 = _align.getGeometricCenter();
 	CartesianPoint pt = _ref.getGeometricCenter() - _align.getGeometricCenter();
 	
 	
-	Matrix rotMatrix = lastRotMatrix.getTranspose();
+	Rotation3 rotMatrix = lastRotation.getTranspose();
 
 	for (AtomPointerVector::iterator k=_moveable.begin(); k!=_moveable.end(); k++) {
 		translateAtom(*(*k), pt); // GC2->origin
 		rotateAtom(*(*k), rotMatrix, GC1);
 	}
 	if (saveHistory_flag) {
-		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
-			k->second -= GC2;
-			k->second *= rotMatrix;
-			k->second += GC1;
-		}
+		history.translate(-GC2);
+		history.rotate(rotMatrix);
+		history.translate(GC1);
 	}
 
 	lastTranslation = GC1 - GC2;
@@ -578,7 +575,7 @@ bool Transforms::rmsdAlignment(AtomPointerVector &_align, AtomPointerVector &_re
 
 
 	// Output when Transforms output is turned on.
-	MSLOUT.stream() << "Rotation Matrix: "<<lastRotMatrix.toString()<<endl;
+	MSLOUT.stream() << "Rotation Matrix: "<<lastRotation.toString()<<endl;
 	MSLOUT.stream() << "Translation Vector: "<<lastTranslation.toString()<<endl;
 
 	return true;
@@ -595,7 +592,7 @@ bool Transforms::revertRmsdAlignment(AtomPointerVector &_align, AtomPointerVecto
 
 	for (AtomPointerVector::iterator k = _moveable.begin(); k != _moveable.end(); k++) {
 		translateAtom(*(*k), pt);
-		rotateAtom(*(*k), lastRotMatrix, oldGC2);
+		rotateAtom(*(*k), lastRotation, oldGC2);
 	}
 
 	return true;
@@ -614,48 +611,29 @@ Matrix Transforms::createBasisTransformation(vector<vector<double> > &_basis1, v
     
 	//  Transformation Matrix going from basis1 to basis2
 	// Dot products
-	lastRotMatrix[0][0] = i * ip;
-	lastRotMatrix[0][1] = i * jp;
-	lastRotMatrix[0][2] = i * kp;
+	lastRotation[0][0] = i * ip;
+	lastRotation[0][1] = i * jp;
+	lastRotation[0][2] = i * kp;
   
-	lastRotMatrix[1][0] = j * ip;
-	lastRotMatrix[1][1] = j * jp;
-	lastRotMatrix[1][2] = j * kp;
+	lastRotation[1][0] = j * ip;
+	lastRotation[1][1] = j * jp;
+	lastRotation[1][2] = j * kp;
   
-	lastRotMatrix[2][0] = k * ip;
-	lastRotMatrix[2][1] = k * jp;
-	lastRotMatrix[2][2] = k * kp;
+	lastRotation[2][0] = k * ip;
+	lastRotation[2][1] = k * jp;
+	lastRotation[2][2] = k * kp;
 
-	return lastRotMatrix;
+	return lastRotation.toMatrix();
 }
 
 
 void Transforms::applyHistory(Atom & _atom) {
-
-	CartesianPoint tX = frame["O"] + CartesianPoint(1.0, 0.0, 0.0);
-	align(tX, frame["X"], frame["O"]);
-	Matrix rot1 = lastRotMatrix;
-
-	CartesianPoint tY = frame["O"] + (CartesianPoint(0.0, 1.0, 0.0) * lastRotMatrix);
-	orient(tY, frame["Y"], frame["O"], frame["X"]);
-	Matrix rot2 = lastRotMatrix * rot1;
-
-	rotateAtom(_atom, rot2);
-	translateAtom(_atom, frame["O"]);
-
+	transformAtom(_atom, history);
 }
 
 void Transforms::applyHistory(AtomPointerVector & _atoms) {
-	CartesianPoint tX = frame["O"] + CartesianPoint(1.0, 0.0, 0.0);
-	align(tX, frame["X"], frame["O"]);
-	Matrix rot1 = lastRotMatrix;
-
-	CartesianPoint tY = frame["O"] + (CartesianPoint(0.0, 1.0, 0.0) * lastRotMatrix);
-	orient(tY, frame["Y"], frame["O"], frame["X"]);
-	Matrix rot2 = lastRotMatrix * rot1;
 	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-		rotateAtom(*(*k), rot2);
-		translateAtom(*(*k), frame["O"]);
+		transformAtom(*(*k), history);
 	}
 }
 
@@ -776,7 +754,7 @@ bool Transforms::setBondAngle(Atom & _atom1, Atom & _atom2, Atom & _atom3, doubl
 
 	if (!naturalMovementOnSetDOF_flag) {
 		// get the rotation matrix
-		Matrix m = CartesianGeometry::getRotationMatrix(rotation, rotAxis);
+		Rotation3 m = CartesianGeometry::getRotation(rotation, rotAxis);
 
 		// move the atoms
 		for (set<Atom*>::iterator k=moveList.begin(); k!=moveList.end(); k++) {
@@ -805,8 +783,8 @@ bool Transforms::setBondAngle(Atom & _atom1, Atom & _atom2, Atom & _atom3, doubl
 		f2 /= tot;
 
 		// get the rotation matrices
-		Matrix m1 = CartesianGeometry::getRotationMatrix(rotation * f2, rotAxis);
-		Matrix m2 = CartesianGeometry::getRotationMatrix(rotation * f1, rotAxis);
+		Rotation3 m1 = CartesianGeometry::getRotation(rotation * f2, rotAxis);
+		Rotation3 m2 = CartesianGeometry::getRotation(rotation * f1, rotAxis);
 
 		for (set<Atom*>::iterator k=moveList.begin(); k!=moveList.end(); k++) {
 			rotateAtom(**k, m1, _atom2.getCoor()); 
@@ -878,7 +856,7 @@ bool Transforms::setDihedral(Atom & _atom1, Atom & _atom2, Atom & _atom3, Atom &
 	// move the atoms
 	if (!naturalMovementOnSetDOF_flag) {
 		// get the rotation matrix
-		Matrix m = CartesianGeometry::getRotationMatrix(rotation, rotAxis);
+		Rotation3 m = CartesianGeometry::getRotation(rotation, rotAxis);
 
 		for (set<Atom*>::iterator k=moveList.begin(); k!=moveList.end(); k++) {
 			rotateAtom(**k, m, _atom2.getCoor()); 
@@ -906,8 +884,8 @@ bool Transforms::setDihedral(Atom & _atom1, Atom & _atom2, Atom & _atom3, Atom &
 		f2 /= tot;
 
 		// get the rotation matrices
-		Matrix m1 = CartesianGeometry::getRotationMatrix(rotation * f2, rotAxis);
-		Matrix m2 = CartesianGeometry::getRotationMatrix(rotation * f1, rotAxis);
+		Rotation3 m1 = CartesianGeometry::getRotation(rotation * f2, rotAxis);
+		Rotation3 m2 = CartesianGeometry::getRotation(rotation * f1, rotAxis);
 
 		for (set<Atom*>::iterator k=moveList.begin(); k!=moveList.end(); k++) {
 			rotateAtom(**k, m1, _atom2.getCoor()); 
@@ -36,6 +36,7 @@ You should have received a copy of the GNU Lesser General Public
 #include "Residue.h"
 #include "Quaternion.h"
 #include "SphericalPoint.h"
+#include "RigidTransform.h"
 #include <math.h>
 
 
@@ -61,6 +62,8 @@ class Transforms {
 		void Zrotate(Atom & _atom, double _degrees);
 		void rotate(Atom & _atom, double _degrees, const CartesianPoint & _axisFromRotCenter, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
 		void rotate(Atom & _atom, const Matrix & _rotMatrix, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
+		void rotate(Atom & _atom, const Rotation3 & _rot, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
+		void transform(Atom & _atom, const RigidTransform & _transform);
 
 		/*****************************************************
 		 *  Align rotates the atom so that it points in the
@@ -91,6 +94,8 @@ class Transforms {
 		void Zrotate(AtomPointerVector & _atoms, double _degrees);
 		void rotate(AtomPointerVector & _atoms, double _degrees, const CartesianPoint & _axisFromRotCenter, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
 		void rotate(AtomPointerVector & _atoms, const Matrix & _rotMatrix, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
+		void rotate(AtomPointerVector & _atoms, const Rotation3 & _rot, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
+		void transform(AtomPointerVector & _atoms, const RigidTransform & _transform);
 		
 		/*****************************************************
 		 *  For the atom std::vector, the align and orient operations 
@@ -100,6 +105,16 @@ class Transforms {
 		bool align(AtomPointerVector & _atoms, const CartesianPoint & _reference, const CartesianPoint & _target, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
 		bool orient(AtomPointerVector & _atoms, const CartesianPoint & _reference, const CartesianPoint & _target, const CartesianPoint & _axis1, const CartesianPoint & _axis2);
 
+		/***************************************************************************************
+		 *
+		 *  TRANSFORMATIONS APPLIED TO PACKED COORDINATES
+		 *  (x, y, z of _nPoints consecutive points, transformed in one pass)
+		 *
+		 ***************************************************************************************/
+		void rotate(double * _coor, unsigned int _nPoints, const Rotation3 & _rot, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
+		void transform(double * _coor, unsigned int _nPoints, const RigidTransform & _transform);
+		void transform(std::vector<double> & _coor, const RigidTransform & _transform);
+
 
 #ifdef __GSL__
 		/*******************************************************
@@ -164,7 +179,9 @@ class Transforms {
 		void applyHistory(AtomPointerVector & _atoms);
 
 		Matrix getLastRotationMatrix() const;
+		const Rotation3 & getLastRotation() const;
 		CartesianPoint getLastTranslation() const;
+		const RigidTransform & getTransformHistory() const; // what applyHistory applies
 
 		double getLastRMSD() const; // get RMSD after rmsdAlingment operations
 
@@ -183,18 +200,19 @@ class Transforms {
 	//	void findLinkedAtoms(Atom * _pAtom, const std::map<Atom*, bool> & _excluded, std::map<Atom*, bool> & _list);
 
 		void translateAtom(Atom & _atom, const CartesianPoint & _p);
-		void rotateAtom(Atom & _atom, const Matrix & _rotMatrix, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
+		void rotateAtom(Atom & _atom, const Rotation3 & _rot, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
+		void transformAtom(Atom & _atom, const RigidTransform & _transform);
 		bool alignAtom(Atom & _atom, const CartesianPoint & _target, const CartesianPoint & _rotCenter);
 		bool orientAtom(Atom & _atom, const CartesianPoint & _target, const CartesianPoint & _axis1, const CartesianPoint & _axis2);
 
 		Quaternion q;
 		
-		Matrix lastRotMatrix;
+		Rotation3 lastRotation;
 		CartesianPoint lastTranslation;
 		double lastRMSD;
 		bool saveHistory_flag;
 
-		std::map<std::string, CartesianPoint> frame;
+		RigidTransform history; // all the transformations since the last resetHistory
 
 		bool transformAllCoors_flag; // if false only the current coors are moved
 
@@ -204,8 +222,11 @@ class Transforms {
 // INLINE FUNCTIONS
 inline void Transforms::setStoreTransformHistory(bool _flag) {saveHistory_flag = _flag;}
 inline bool Transforms::getStoreTransformHistory() const {return saveHistory_flag;}
-inline void Transforms::resetHistory() {frame["O"] = CartesianPoint(0.0, 0.0, 0.0); frame["X"] = CartesianPoint(1.0, 0.0, 0.0); frame["Y"] = CartesianPoint(0.0, 1.0, 0.0);}
-inline Matrix Transforms::getLastRotationMatrix() const {return lastRotMatrix;}
+inline void Transforms::resetHistory() {history.reset();}
+inline Matrix Transforms::getLastRotationMatrix() const {return lastRotation.toMatrix();}
+inline const Rotation3 & Transforms::getLastRotation() const {return lastRotation;}
+inline const RigidTransform & Transforms::getTransformHistory() const {return history;}
+inline void Transforms::transform(std::vector<double> & _coor, const RigidTransform & _transform) {if (!_coor.empty()) {transform(&_coor[0], _coor.size() / 3, _transform);}}
 inline CartesianPoint Transforms::getLastTranslation() const {return lastTranslation;}
 inline double Transforms::getLastRMSD() const { return lastRMSD;}
 inline void Transforms::setTransformAllCoors(bool _flag) {transformAllCoors_flag = _flag;}
@@ -29,6 +29,7 @@ You should have received a copy of the GNU Lesser General Public
 
 #include "TwoBodyDistanceDependentPotentialTable.h"
 #include "MslExceptions.h"
+#include <algorithm>
 
 using namespace MSL;
 using namespace std;
@@ -43,7 +44,7 @@ void TwoBodyDistanceDependentPotentialTable::readPotentialTable(string _fileName
 	reader.open(_fileName);
 	reader.read(this);
 	reader.close();
-
+	compilePotentialTable();
 
 }
 
@@ -53,7 +54,7 @@ void TwoBodyDistanceDependentPotentialTable::readPotentialTable(string _fileName
 	reader.open(_fileName);
 	reader.read(this);
 	reader.close();
-
+	compilePotentialTable();
 
 	cout << "Potential: "<<potentialName<<endl;
 	cout << "Residue Skipping Number: "<<residueSkippingNumber<<endl;
@@ -78,6 +79,43 @@ void TwoBodyDistanceDependentPotentialTable::addPotential(string _name1, string
 	key << _name1 <<":"<<_name2<<":"<<_distBin;
 
 	PotentialTable::addPotential(key.str(),_value);
+
+	// intern the names for the compiled table
+	int class1 = classIds.insert(pair<string, int>(_name1, classIds.size())).first->second;
+	int class2 = classIds.insert(pair<string, int>(_name2, classIds.size())).first->second;
+	classPotentials.push_back(pair<pair<int, int>, pair<int, double> >(pair<int, int>(class1, class2), pair<int, double>(_distBin, _value)));
+	denseTableCurrent = false;
+}
+
+void TwoBodyDistanceDependentPotentialTable::compilePotentialTable() {
+	denseClasses = classIds.size();
+	denseBins = distBins.size();
+	denseTable.assign(denseClasses * denseClasses * denseBins, 0.0);
+	// in the order they were added, so that a repeated key keeps the last value, as in the std::map
+	for (unsigned int i=0; i<classPotentials.size(); i++) {
+		denseTable[(classPotentials[i].first.first * denseClasses + classPotentials[i].first.second) * denseBins + classPotentials[i].second.first] = classPotentials[i].second.second;
+	}
+	denseTableCurrent = true;
+}
+
+void TwoBodyDistanceDependentPotentialTable::updateBinLookup() {
+	binsContiguous = false;
+	binEnds.clear();
+	if (distBins.size() == 0 || distBins[0].endDistance <= distBins[0].startDistance) {
+		return;
+	}
+	for (uint i = 0; i < distBins.size();i++){
+		if (distBins[i].endDistance < distBins[i].startDistance || (i > 0 && distBins[i].startDistance != distBins[i-1].endDistance)) {
+			// gaps, overlaps or unsorted bins, getBin uses the linear search
+			binEnds.clear();
+			return;
+		}
+		binEnds.push_back(distBins[i].endDistance);
+	}
+	binLookupStart = distBins[0].startDistance;
+	binLookupEnd = distBins.back().endDistance;
+	binLookupInvWidth = 1.0 / (distBins[0].endDistance - distBins[0].startDistance);
+	binsContiguous = true;
 }
 
 double TwoBodyDistanceDependentPotentialTable::getPotential(string _name1, string _name2, int _distBin){
@@ -89,6 +127,10 @@ double TwoBodyDistanceDependentPotentialTable::getPotential(string _name1, strin
 	}
 
 	
+	if (denseTableCurrent) {
+		return getPotential(getClassId(_name1), getClassId(_name2), _distBin);
+	}
+
 	stringstream key;
 	key << _name1 <<":"<<_name2<<":"<<_distBin;
 
@@ -237,8 +279,56 @@ double TwoBodyDistanceDependentPotentialTable::calculateSurroundingEnergy(System
 	return energy;
 }
 
+/*
+  The properties of the atoms used by calculatePairwiseNonBondedEnergy, computed once per atom
+  instead of once per pair
+ */
+struct TBDAtomInfo {
+	bool hydrogen;
+	bool backbone;
+	int chain;
+	int residueNumber;
+	int classId;
+	std::string name; // RES_ATOM, used if the table is not compiled
+};
+
+static void fillAtomInfo(AtomPointerVector & _atoms, vector<TBDAtomInfo> & _info, vector<string> & _chains, const TwoBodyDistanceDependentPotentialTable & _table, bool _compiled) {
+	_info.resize(_atoms.size());
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		Atom & atom = *(_atoms[i]);
+		TBDAtomInfo & info = _info[i];
+		string name = atom.getName();
+		info.hydrogen = name.substr(0,1) == "H";
+		info.backbone = (name == "N") || (name == "C") || (name == "CA") || (name == "O");
+		info.residueNumber = atom.getResidueNumber();
+		string chain = atom.getChainId();
+		info.chain = find(_chains.begin(), _chains.end(), chain) - _chains.begin();
+		if (info.chain == _chains.size()) {
+			_chains.push_back(chain);
+		}
+		if (info.hydrogen) {
+			continue;
+		}
+		stringstream key;
+		key << atom.getResidueName() << "_" << name;
+		if (_compiled) {
+			info.classId = _table.getClassId(key.str());
+		} else {
+			info.name = key.str();
+		}
+	}
+}
+
 double TwoBodyDistanceDependentPotentialTable::calculatePairwiseNonBondedEnergy(System &_sys, AtomPointerVector &_a, AtomPointerVector &_b, bool _sameSet, bool _countLocalSCBB){
 
+	// the names are converted to the classes of the compiled table once per atom
+	bool compiled = denseTableCurrent;
+	vector<string> chains;
+	vector<TBDAtomInfo> infoA;
+	vector<TBDAtomInfo> infoB;
+	fillAtomInfo(_a, infoA, chains, *this, compiled);
+	fillAtomInfo(_b, infoB, chains, *this, compiled);
+
 	double energies = 0.;
 	for (int i = (_a.size() - 1); i >= 0; i--){
 		// Adjust starting point for inner loop depending if _a == _b or not.
@@ -246,30 +336,26 @@ double TwoBodyDistanceDependentPotentialTable::calculatePairwiseNonBondedEnergy(
 		if (_sameSet){
 			startJ = i+1;
 		}
-		if (_a(i).getName().substr(0,1) == "H") { continue; }
+		const TBDAtomInfo & a = infoA[i];
+		if (a.hydrogen) { continue; }
 		for (int j = (_b.size() - 1); j >= startJ; j--){
-			if (_b(j).getName().substr(0,1) == "H") { continue; }
-			else if ((_a(i).getChainId() == _b(j).getChainId()) && isBackbone(_a(i).getName()) && isBackbone(_b(j).getName()) && (abs(_a(i).getResidueNumber() - _b(j).getResidueNumber()) <= 7)) {}
-			else if ((!_countLocalSCBB) && (_a(i).getChainId() == _b(j).getChainId()) && (abs(_a(i).getResidueNumber() - _b(j).getResidueNumber()) <= 7)) {}
-			else if ((_a(i).getChainId() == _b(j).getChainId()) && (abs(_a(i).getResidueNumber() == _b(j).getResidueNumber()))) {}
-			//else if ((_a(i).getChainId() == _b(j).getChainId()) && (isBackbone(_a(i).getName()) || isBackbone(_b(j).getName())) && (abs(_a(i).getResidueNumber() - _b(j).getResidueNumber()) <= 7)) {}
-			//else if ((_a(i).getChainId() == _b(j).getChainId()) && (abs(_a(i).getResidueNumber() - _b(j).getResidueNumber()) <= 7)) {}
+			const TBDAtomInfo & b = infoB[j];
+			if (b.hydrogen) { continue; }
+			else if ((a.chain == b.chain) && a.backbone && b.backbone && (abs(a.residueNumber - b.residueNumber) <= 7)) {}
+			else if ((!_countLocalSCBB) && (a.chain == b.chain) && (abs(a.residueNumber - b.residueNumber) <= 7)) {}
+			else if ((a.chain == b.chain) && (a.residueNumber == b.residueNumber)) {}
 			else {
 				double kb = 0;
 				double dist = _a(i).distance(_b(j));
-				if (dist < getMinDistCutoff()) {
-					kb = getValueBelowCutoff();
+				if (dist < minDistCutoff) {
+					kb = valueBelowCutoff;
+				}
+				else if (dist > maxDistCutoff) { kb = valueAboveCutoff; }
+				else if (compiled) {
+					kb = getPotential(a.classId, b.classId, getBin(dist));
 				}
-				else if (dist > getMaxDistCutoff()) { kb = getValueAboveCutoff(); }
 				else {
-					stringstream name1;
-					name1 << _a(i).getResidueName() << "_" << _a(i).getName();
-					stringstream name2;
-					name2 << _b(j).getResidueName() << "_" << _b(j).getName();
-
-					double distBin = getBin(dist);
-
-					kb = getPotential(name1.str(),name2.str(),int(distBin));
+					kb = getPotential(a.name, b.name, getBin(dist));
 				}
 				energies += kb;
 			}
@@ -65,6 +65,20 @@ class TwoBodyDistanceDependentPotentialTable : public PotentialTable {
 		double getPotential(std::string _body1, std::string _body2, int _dist);
 		void addPotential(std::string _name1, std::string _name2, int _distBin, double _value);
 
+		/***************************************************************
+		 *  The names (RES_ATOM) are interned into integer classes and the
+		 *  potentials copied to a dense [class1][class2][bin] array, so
+		 *  that the energy functions do not build a string key for each
+		 *  atom pair.  readPotentialTable compiles the table; call this
+		 *  function after adding potentials or bins directly.  Until it
+		 *  is called the std::map of PotentialTable is used.
+		 *  The compiled table is read only, and the energy functions
+		 *  can be called from multiple threads
+		 ***************************************************************/
+		void compilePotentialTable();
+		int getClassId(const std::string & _name) const; // -1 if not in the table
+		double getPotential(int _class1, int _class2, int _distBin) const; // compiled table only
+
 		double getEnergyBetweenResidues();
 
 		double calculateSelfEnergy(System &_sys, int _position, int _rotamer);
@@ -76,6 +90,9 @@ class TwoBodyDistanceDependentPotentialTable : public PotentialTable {
 
 	private:
 
+		// the Quench fills its surround cache one pair of positions at a time
+		friend class Quench;
+
 		double calculatePairwiseNonBondedEnergy(System &_sys, AtomPointerVector &_a, AtomPointerVector &_b, bool _sameSet=false, bool _countLocalSCBB=false);
 
 		bool isBackbone(std::string atomname);
@@ -100,12 +117,37 @@ class TwoBodyDistanceDependentPotentialTable : public PotentialTable {
 
 		std::vector<distanceBin> distBins; // Read in from potential file
 
+		// getBin without the linear search, if the bins are sorted and contiguous: the bin is estimated from
+		// the width of the first bin and corrected to the first bin whose end is not below the distance
+		void updateBinLookup();
+		bool binsContiguous;
+		double binLookupStart;
+		double binLookupEnd;
+		double binLookupInvWidth;
+		std::vector<double> binEnds;
+
+		// compiled table
+		std::map<std::string, int> classIds;
+		std::vector<std::pair<std::pair<int, int>, std::pair<int, double> > > classPotentials; // in the order they were added
+		std::vector<double> denseTable;
+		int denseClasses;
+		int denseBins;
+		bool denseTableCurrent;
+
 		TBDReader reader;
 
 };
 
 // INLINES
-inline TwoBodyDistanceDependentPotentialTable::TwoBodyDistanceDependentPotentialTable() {}
+inline TwoBodyDistanceDependentPotentialTable::TwoBodyDistanceDependentPotentialTable() {
+	binsContiguous = false;
+	binLookupStart = 0.0;
+	binLookupEnd = 0.0;
+	binLookupInvWidth = 0.0;
+	denseClasses = 0;
+	denseBins = 0;
+	denseTableCurrent = false;
+}
 
 inline int TwoBodyDistanceDependentPotentialTable::getResidueSkippingNumber() { return residueSkippingNumber; }
 inline void TwoBodyDistanceDependentPotentialTable::setResidueSkippingNumber(int _resSkip) { residueSkippingNumber = _resSkip; }
@@ -126,10 +168,29 @@ inline void TwoBodyDistanceDependentPotentialTable::addBin(double _start, double
 	db.endDistance = _end;
 
 	distBins.push_back(db);
+	updateBinLookup();
+	denseTableCurrent = false;
 }
 
 inline int TwoBodyDistanceDependentPotentialTable::getBin(double _dist){
 
+	if (binsContiguous) {
+		// same result as the linear search: the first bin that contains the distance
+		if (!(_dist >= binLookupStart && _dist <= binLookupEnd)) {
+			return -1;
+		}
+		int last = binEnds.size() - 1;
+		int bin = (int)((_dist - binLookupStart) * binLookupInvWidth);
+		bin = bin < 0 ? 0 : (bin > last ? last : bin);
+		while (bin > 0 && _dist <= binEnds[bin-1]) {
+			bin--;
+		}
+		while (bin < last && _dist > binEnds[bin]) {
+			bin++;
+		}
+		return bin;
+	}
+
 	int bin = -1;
 	for (uint i = 0; i < distBins.size();i++){
 		if (_dist >= distBins[i].startDistance && _dist <= distBins[i].endDistance){
@@ -140,6 +201,21 @@ inline int TwoBodyDistanceDependentPotentialTable::getBin(double _dist){
 	return bin;
 }
 
+inline int TwoBodyDistanceDependentPotentialTable::getClassId(const std::string & _name) const {
+	std::map<std::string, int>::const_iterator found = classIds.find(_name);
+	if (found == classIds.end()) {
+		return -1;
+	}
+	return found->second;
+}
+inline double TwoBodyDistanceDependentPotentialTable::getPotential(int _class1, int _class2, int _distBin) const {
+	// unknown classes and distances out of the bins give 0, as a missing key in the std::map
+	if (_class1 < 0 || _class2 < 0 || _distBin < 0 || _distBin >= denseBins) {
+		return 0.0;
+	}
+	return denseTable[(_class1 * denseClasses + _class2) * denseBins + _distBin];
+}
+
 }
 
 #endif
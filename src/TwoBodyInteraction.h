@@ -56,7 +56,8 @@ class TwoBodyInteraction: public Interaction {
 
 		double getDistance() const;
 		
-		bool isSelected(std::string _selection1, std::string _selection2) const;
+		bool isSelected(unsigned int _selection1, unsigned int _selection2) const;
+		using Interaction::isSelected;
 		bool isActive() const;
 
 		virtual double getEnergy()=0;
@@ -75,7 +76,7 @@ class TwoBodyInteraction: public Interaction {
 inline void TwoBodyInteraction::setAtoms(std::vector<Atom*> _atoms) { if (_atoms.size() != 2) {std::cerr << "ERROR 38192: invalid number of atoms in inline void TwoBodyInteraction::setAtoms(std::vector<Atom*> _atoms)" << std::endl; exit(38192);} pAtoms = _atoms;}
 inline void TwoBodyInteraction::setAtoms(Atom & _a1, Atom & _a2) { pAtoms[0] = &_a1; pAtoms[1] = &_a2; }
 inline double TwoBodyInteraction::getDistance() const {return pAtoms[0]->distance(*pAtoms[1]);}
-inline bool TwoBodyInteraction::isSelected(std::string _selection1, std::string _selection2) const {
+inline bool TwoBodyInteraction::isSelected(unsigned int _selection1, unsigned int _selection2) const {
 	if ( (pAtoms[0]->getSelectionFlag(_selection1) && pAtoms[1]->getSelectionFlag(_selection2)) || (pAtoms[0]->getSelectionFlag(_selection2) && pAtoms[1]->getSelectionFlag(_selection1)) ) {
 		return true;
 	} else {
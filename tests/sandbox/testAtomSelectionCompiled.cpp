@@ -0,0 +1,256 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the compiled selections of AtomSelection (typed conditions
+ *  and truth table, spatial grid for WITHIN X OF) against the
+ *  evaluation of the selection string on each atom through the
+ *  LogicalCondition and a double loop for WITHIN.  The selections
+ *  are repeated after the atoms are moved (a new model of the
+ *  same System) with another AtomSelection, and with copies of
+ *  the AtomSelection.  The time is reported
+ ******************************************************************/
+
+#include <iostream>
+
+#include "System.h"
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "AtomSelection.h"
+#include "LogicalCondition.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+// the condition tokens answered by string comparison on the atom
+bool referenceCondition(const vector<string> & _tokens, Atom & _atom) {
+	if (_tokens[0] == "ALL" && _tokens.size() == 1) {
+		return true;
+	}
+	if (_tokens.size() == 2) {
+		vector<string> vals = MslTools::tokenize(_tokens[1], "+");
+		for (unsigned int i=0; i<vals.size(); i++) {
+			if (_tokens[0] == "NAME" && vals[i] == _atom.getName()) {
+				return true;
+			}
+			if (_tokens[0] == "RESN" && vals[i] == _atom.getResidueName()) {
+				return true;
+			}
+			if (_tokens[0] == "CHAIN" && vals[i] == _atom.getChainId()) {
+				return true;
+			}
+			if (_tokens[0] == "RESI") {
+				vector<string> range = MslTools::tokenize(vals[i], "-");
+				if (range.size() == 2) {
+					if (MslTools::toInt(range[0]) <= _atom.getResidueNumber() && MslTools::toInt(range[1]) >= _atom.getResidueNumber()) {
+						return true;
+					}
+				} else if (vals[i] == _atom.getPositionId(1)) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+	if (_tokens[0] == "HASCRD") {
+		return _atom.hasCoor();
+	}
+	// a stored selection
+	return _atom.getSelectionFlag(_tokens[0]);
+}
+
+AtomPointerVector referenceLogic(string _logic, AtomPointerVector & _atoms) {
+	AtomPointerVector out;
+	LogicalCondition cond;
+	cond.setLogic(_logic);
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		cond.restartQuery();
+		while (!cond.logicComplete()) {
+			vector<string> tokens = cond.getLogicalCondition();
+			cond.setLogicalConditionValue(referenceCondition(tokens, *_atoms[i]));
+		}
+		if (cond.getOverallBooleanState()) {
+			out.push_back(_atoms[i]);
+		}
+	}
+	return out;
+}
+
+AtomPointerVector referenceSelect(string _logic, AtomPointerVector & _atoms) {
+	_logic = MslTools::toUpper(_logic);
+	size_t wpos = _logic.find("WITHIN");
+	if (wpos == string::npos) {
+		return referenceLogic(_logic, _atoms);
+	}
+	size_t opos = _logic.find("OF");
+	double radius = MslTools::toDouble(MslTools::tokenizeAndTrim(_logic.substr(wpos, opos-wpos+2))[1]);
+	AtomPointerVector sele2 = referenceLogic(_logic.substr(opos+3), _atoms);
+	AtomPointerVector around;
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		bool in = false;
+		for (unsigned int j=0; j<sele2.size() && !in; j++) {
+			in = sele2[j] == _atoms[i] || _atoms[i]->distance(*sele2[j]) < radius;
+		}
+		if (in) {
+			around.push_back(_atoms[i]);
+		}
+	}
+	return referenceLogic(_logic.substr(0, wpos-1), around);
+}
+
+int main() {
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+	CSB.setBuildNonBondedInteractions(false);
+	string residues[10] = {"ALA", "ILE", "GLU", "LEU", "LYS", "PHE", "SER", "ARG", "TRP", "ASP"};
+	string seqString = "A:";
+	for (unsigned int i=0; i<30; i++) {
+		seqString += " " + residues[i % 10];
+	}
+	seqString += "\nB:";
+	for (unsigned int i=0; i<30; i++) {
+		seqString += " " + residues[(i * 3) % 10];
+	}
+	PolymerSequence seq(seqString);
+	CSB.buildSystem(seq);
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAtoms();
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	// place chain B next to chain A
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		if (atoms[i]->getChainId() == "B") {
+			atoms[i]->setCoor(atoms[i]->getCoor() + CartesianPoint(0.0, 6.0, 2.0));
+		}
+	}
+	cout << "System with " << atoms.size() << " atoms" << endl;
+
+	vector<string> selections;
+	selections.push_back("name CA");
+	selections.push_back("name CA+CB and resi 3-7");
+	selections.push_back("resn LEU+ILE or chain B");
+	selections.push_back("not (name N or name C) and resi 2+5+9");
+	selections.push_back("chain A and not resn ALA xor resi 10-20 or hascrd and name O");
+	selections.push_back("name CA and ((resi 3 and chain A) or (resi 4-6 and chain B)) and not resn ILE");
+	selections.push_back("name CA WITHIN 6 OF resi 5");
+	selections.push_back("(name CB or resn LEU) WITHIN 4.5 OF (chain B and name CA)");
+	selections.push_back("all WITHIN 3 OF name OD1+OD2");
+
+	AtomSelection sel(atoms);
+	bool result = true;
+	for (unsigned int model=0; model<2; model++) {
+		if (model == 1) {
+			// a new model: move chain B
+			for (unsigned int i=0; i<atoms.size(); i++) {
+				if (atoms[i]->getChainId() == "B") {
+					atoms[i]->setCoor(atoms[i]->getCoor() + CartesianPoint(1.5, -2.0, 0.5));
+				}
+			}
+		}
+		// the new model is selected with another AtomSelection (the compiled logic is shared)
+		AtomSelection modelSel(atoms);
+		AtomSelection & current = (model == 0) ? sel : modelSel;
+		for (unsigned int s=0; s<selections.size(); s++) {
+			AtomPointerVector selected = current.select("test, " + selections[s]);
+			AtomPointerVector reference = referenceSelect(selections[s], atoms);
+			bool same = selected.size() == reference.size();
+			for (unsigned int i=0; i<selected.size() && same; i++) {
+				same = selected[i] == reference[i];
+			}
+			cout << "Model " << model << " \"" << selections[s] << "\": " << selected.size() << " atoms (reference " << reference.size() << ")" << endl;
+			if (!same) {
+				cout << "   the selection differs from the reference" << endl;
+				result = false;
+			}
+		}
+	}
+
+	// copies of an AtomSelection, destroyed before the original is used again
+	for (unsigned int copy=0; copy<2; copy++) {
+		AtomSelection copied(sel);
+		AtomSelection assigned;
+		assigned = copied;
+		for (unsigned int s=0; s<selections.size(); s++) {
+			AtomPointerVector & selected = (copy == 0) ? copied.select("test, " + selections[s]) : assigned.select("test, " + selections[s]);
+			AtomPointerVector reference = referenceSelect(selections[s], atoms);
+			if (selected.size() != reference.size()) {
+				cout << "The copied AtomSelection differs from the reference for \"" << selections[s] << "\"" << endl;
+				result = false;
+			}
+		}
+	}
+
+	// stored selections
+	sel.select("sel1, name CA+CB");
+	AtomPointerVector selected = sel.select("sel2, sel1 and resi 1-4 and not name CB");
+	unsigned int expected = 0;
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		if (atoms[i]->getName() == "CA" && atoms[i]->getResidueNumber() <= 4) {
+			expected++;
+		}
+		if (atoms[i]->getSelectionFlag("sel2") != (atoms[i]->getName() == "CA" && atoms[i]->getResidueNumber() <= 4)) {
+			result = false;
+		}
+	}
+	cout << "Stored selection: " << selected.size() << " atoms (expected " << expected << ")" << endl;
+	if (selected.size() != expected) {
+		result = false;
+	}
+
+	// time
+	Timer timer;
+	unsigned int repeats = 20;
+	double start = timer.getWallTime();
+	for (unsigned int n=0; n<repeats; n++) {
+		for (unsigned int s=0; s<selections.size(); s++) {
+			referenceSelect(selections[s], atoms);
+		}
+	}
+	double referenceTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	for (unsigned int n=0; n<repeats; n++) {
+		for (unsigned int s=0; s<selections.size(); s++) {
+			sel.select("test, " + selections[s]);
+		}
+	}
+	double compiledTime = timer.getWallTime() - start;
+	cout << "Time for the selections: " << referenceTime / repeats << " s parsing each atom, " << compiledTime / repeats << " s compiled" << endl;
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
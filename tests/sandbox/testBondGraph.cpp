@@ -0,0 +1,246 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the bonded topology: the 1-2, 1-3 and 1-4 lists of the
+ *  atoms (Atom::isBoundTo, isOneThree, isOneFour and the middle
+ *  atoms) against the paths found walking the bonds, and the
+ *  BondGraph of the System against the atoms, after building a
+ *  system with alternative identities and after removing and
+ *  adding bonds.  The time to classify all pairs is reported
+ ******************************************************************/
+
+#include <iostream>
+
+#include "System.h"
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "BondGraph.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+// the 1-3 and 1-4 relationships from the paths of distinct atoms (for systems without alternative identities)
+bool checkPaths(AtomPointerVector & _atoms) {
+	bool result = true;
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		Atom * pA = _atoms[i];
+		map<Atom*, vector<Atom*> > oneThree;
+		map<Atom*, vector<vector<Atom*> > > oneFour;
+		vector<Atom*> bonds1 = pA->getBonds();
+		for (unsigned int k=0; k<bonds1.size(); k++) {
+			vector<Atom*> bonds2 = bonds1[k]->getBonds();
+			for (unsigned int l=0; l<bonds2.size(); l++) {
+				if (bonds2[l] == pA) {
+					continue;
+				}
+				oneThree[bonds2[l]].push_back(bonds1[k]);
+				vector<Atom*> bonds3 = bonds2[l]->getBonds();
+				for (unsigned int m=0; m<bonds3.size(); m++) {
+					if (bonds3[m] == pA || bonds3[m] == bonds1[k]) {
+						continue;
+					}
+					vector<Atom*> middle(1, bonds1[k]);
+					middle.push_back(bonds2[l]);
+					oneFour[bonds3[m]].push_back(middle);
+				}
+			}
+		}
+		for (unsigned int j=0; j<_atoms.size(); j++) {
+			Atom * pB = _atoms[j];
+			vector<Atom*> middle3 = pA->getOneThreeMiddleAtoms(pB);
+			vector<Atom*> expected3 = oneThree[pB];
+			sort(middle3.begin(), middle3.end());
+			sort(expected3.begin(), expected3.end());
+			if (pA->isOneThree(pB) != (expected3.size() > 0) || middle3 != expected3) {
+				cerr << "Wrong 1-3 " << pA->getAtomOfIdentityId() << " " << pB->getAtomOfIdentityId() << endl;
+				result = false;
+			}
+			vector<vector<Atom*> > middle4 = pA->getOneFourMiddleAtoms(pB);
+			vector<vector<Atom*> > found4;
+			for (unsigned int k=0; k<middle4.size(); k++) {
+				for (unsigned int l=1; l<middle4[k].size(); l++) {
+					vector<Atom*> middle(1, middle4[k][0]);
+					middle.push_back(middle4[k][l]);
+					found4.push_back(middle);
+				}
+			}
+			vector<vector<Atom*> > expected4 = oneFour[pB];
+			sort(found4.begin(), found4.end());
+			sort(expected4.begin(), expected4.end());
+			if (pA->isOneFour(pB) != (expected4.size() > 0) || found4 != expected4) {
+				cerr << "Wrong 1-4 " << pA->getAtomOfIdentityId() << " " << pB->getAtomOfIdentityId() << endl;
+				result = false;
+			}
+		}
+	}
+	return result;
+}
+
+// the BondGraph against the relationships stored in the atoms
+bool checkGraph(System & _sys) {
+	bool result = true;
+	AtomPointerVector & atoms = _sys.getAllAtomPointers();
+	BondGraph & graph = _sys.getBondGraph();
+	if (!graph.isCurrent(atoms) || graph.size() != atoms.size()) {
+		cerr << "The graph is not current" << endl;
+		return false;
+	}
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		vector<Atom*> bonds = atoms[i]->getBonds();
+		vector<unsigned int> expected;
+		for (unsigned int j=0; j<atoms.size(); j++) {
+			if (atoms[i]->isBoundTo(atoms[j])) {
+				expected.push_back(j);
+			}
+			unsigned char relationship = 0;
+			if (atoms[i]->isBoundTo(atoms[j])) {
+				relationship |= BondGraph::oneTwo;
+			}
+			if (atoms[i]->isOneThree(atoms[j])) {
+				relationship |= BondGraph::oneThree;
+			}
+			if (atoms[i]->isOneFour(atoms[j])) {
+				relationship |= BondGraph::oneFour;
+			}
+			if (graph.getRelationship(i, j) != relationship) {
+				cerr << "Wrong relationship " << atoms[i]->getAtomOfIdentityId() << " " << atoms[j]->getAtomOfIdentityId() << endl;
+				result = false;
+			}
+		}
+		vector<unsigned int> found;
+		for (unsigned int n=0; n<graph.getNumberOfBonds(i); n++) {
+			found.push_back(graph.getBond(i, n));
+		}
+		if (found != expected || bonds.size() != expected.size()) {
+			cerr << "Wrong bonds " << atoms[i]->getAtomOfIdentityId() << endl;
+			result = false;
+		}
+	}
+	return result;
+}
+
+int main() {
+
+	bool result = true;
+
+	// without alternative identities, compare with the paths
+	System sys1;
+	CharmmSystemBuilder CSB1(sys1, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+	CSB1.buildSystem(PolymerSequence("A: ALA LEU TYR PRO HSD TRP ARG\nB: GLY SER CYS THR"));
+	AtomPointerVector & atoms1 = sys1.getAllAtomPointers();
+	result = checkPaths(atoms1) && result;
+	result = checkGraph(sys1) && result;
+
+	// remove some bonds, check again
+	for (unsigned int i=0; i<atoms1.size(); i+=7) {
+		vector<Atom*> bonds = atoms1[i]->getBonds();
+		if (bonds.size() > 0) {
+			atoms1[i]->setUnboundFrom(bonds[0]);
+		}
+	}
+	atoms1[20]->setUnboundFromAll();
+	if (sys1.getBondGraph().isCurrent(atoms1) == false) {
+		cerr << "The graph was not rebuilt after the bonds changed" << endl;
+		result = false;
+	}
+	result = checkPaths(atoms1) && result;
+	result = checkGraph(sys1) && result;
+
+	// add bonds back (and some new ones)
+	for (unsigned int i=0; i+5<atoms1.size(); i+=11) {
+		atoms1[i]->setBoundTo(atoms1[i+5]);
+	}
+	atoms1[20]->setBoundTo(atoms1[21]);
+	result = checkPaths(atoms1) && result;
+	result = checkGraph(sys1) && result;
+
+	// with alternative identities, the graph against the atoms, and no relationship between identities of the same position
+	System sys2;
+	CharmmSystemBuilder CSB2(sys2, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+	CSB2.buildSystem(PolymerSequence("A: ALA [LEU ILE PRO] TYR HSD PRO ARG\nB: GLY [SER CYS THR] ALA"));
+	AtomPointerVector & atoms2 = sys2.getAllAtomPointers();
+	result = checkGraph(sys2) && result;
+	for (unsigned int i=0; i<atoms2.size(); i++) {
+		for (unsigned int j=0; j<atoms2.size(); j++) {
+			if (atoms2[i]->isInAlternativeIdentity(atoms2[j]) && sys2.getBondGraph().getRelationship(i, j) != 0) {
+				cerr << "Relationship between alternative identities " << atoms2[i]->getAtomOfIdentityId() << " " << atoms2[j]->getAtomOfIdentityId() << endl;
+				result = false;
+			}
+		}
+	}
+
+	// time to classify all pairs
+	Timer timer;
+	unsigned int repeats = 20;
+	unsigned int countAtoms = 0;
+	double start = timer.getWallTime();
+	for (unsigned int n=0; n<repeats; n++) {
+		for (unsigned int i=0; i<atoms2.size(); i++) {
+			for (unsigned int j=i+1; j<atoms2.size(); j++) {
+				if (atoms2[i]->isBoundTo(atoms2[j]) || atoms2[i]->isOneThree(atoms2[j])) {
+					countAtoms++;
+				} else if (atoms2[i]->isOneFour(atoms2[j])) {
+					countAtoms++;
+				}
+			}
+		}
+	}
+	double atomTime = timer.getWallTime() - start;
+	unsigned int countGraph = 0;
+	start = timer.getWallTime();
+	for (unsigned int n=0; n<repeats; n++) {
+		BondGraph & graph = sys2.getBondGraph();
+		for (unsigned int i=0; i<atoms2.size(); i++) {
+			for (unsigned int j=i+1; j<atoms2.size(); j++) {
+				if (graph.getRelationship(i, j) != 0) {
+					countGraph++;
+				}
+			}
+		}
+	}
+	double graphTime = timer.getWallTime() - start;
+	if (countAtoms != countGraph) {
+		cerr << "Different number of related pairs: " << countAtoms << " " << countGraph << endl;
+		result = false;
+	}
+	cout << "Time to classify all pairs: " << atomTime / repeats << " s with the atoms, " << graphTime / repeats << " s with the BondGraph" << endl;
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,189 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the CHARMM parameters looked up by atom type id against
+ *  the lookup by type name (both orders of the bonded terms,
+ *  wildcard dihedrals and impropers, unknown types), the dense
+ *  matrix of the VDW pairs against the combination rule, and the
+ *  NBFIX block (a copy of the parameter file with an NBFIX block
+ *  appended)
+ ******************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+
+#include "CharmmParameterReader.h"
+#include "Atom.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+bool sameValues(const vector<double> & _a, const vector<double> & _b) {
+	if (_a.size() != _b.size()) {
+		return false;
+	}
+	for (unsigned int i=0; i<_a.size(); i++) {
+		if (fabs(_a[i] - _b[i]) > 1.0e-10) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool check(bool _ok, string _what) {
+	if (!_ok) {
+		cerr << "Failed: " << _what << endl;
+	}
+	return _ok;
+}
+
+int main() {
+
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+	string nbfixFile = "/tmp/testCharmmParameterIds.par";
+
+	// a copy of the parameter file with an NBFIX block
+	ifstream in(parFile.c_str());
+	ofstream out(nbfixFile.c_str());
+	out << in.rdbuf() << endl;
+	out << "NBFIX" << endl;
+	out << "CT1  OC   -0.2000  3.4000" << endl;
+	out << "NH3  OC   -0.3000  3.2000  -0.1500  3.0000" << endl;
+	out << "END" << endl;
+	out.close();
+	in.close();
+
+	CharmmParameterReader par(parFile);
+	par.read();
+	par.close();
+
+	CharmmParameterReader parNBFix(nbfixFile);
+	parNBFix.read();
+	parNBFix.close();
+
+	bool result = true;
+
+	string types[] = {"CT1", "CT2", "CT3", "C", "O", "OC", "NH1", "NH3", "H", "HA", "HB", "CA", "CE1", "S", "DUM"};
+	unsigned int nTypes = 15;
+
+	vector<double> p1;
+	vector<double> p2;
+	vector<vector<double> > d1;
+	vector<vector<double> > d2;
+	unsigned int found = 0;
+	for (unsigned int i=0; i<nTypes; i++) {
+		unsigned int id1 = Atom::findTypeId(types[i]);
+		result = check(id1 != Atom::noTypeId && Atom::getTypeName(id1) == types[i], "type id of " + types[i]) && result;
+
+		bool f1 = par.vdwParam(p1, types[i]);
+		bool f2 = par.vdwParam(p2, id1);
+		result = check(f1 && f2 && sameValues(p1, p2), "vdw " + types[i]) && result;
+
+		for (unsigned int j=0; j<nTypes; j++) {
+			unsigned int id2 = Atom::findTypeId(types[j]);
+			f1 = par.bondParam(p1, types[i], types[j]);
+			f2 = par.bondParam(p2, id1, id2);
+			result = check(f1 == f2 && sameValues(p1, p2), "bond " + types[i] + " " + types[j]) && result;
+			f2 = par.bondParam(p2, id2, id1);
+			result = check(f1 == f2 && sameValues(p1, p2), "reverse bond " + types[i] + " " + types[j]) && result;
+			found += f1;
+
+			const double * pPair = par.vdwParamPair(id1, id2);
+			vector<double> vdw1;
+			vector<double> vdw2;
+			par.vdwParam(vdw1, id1);
+			par.vdwParam(vdw2, id2);
+			result = check(pPair != NULL && fabs(pPair[0] - sqrt(vdw1[0] * vdw2[0])) < 1.0e-10 && fabs(pPair[1] - (vdw1[1] + vdw2[1])) < 1.0e-10 && fabs(pPair[2] - sqrt(vdw1[2] * vdw2[2])) < 1.0e-10 && fabs(pPair[3] - (vdw1[3] + vdw2[3])) < 1.0e-10, "vdw pair " + types[i] + " " + types[j]) && result;
+			result = check(sameValues(par.vdwParamPair(types[i], types[j]), vector<double>(pPair, pPair + 4)), "vdw pair by name " + types[i] + " " + types[j]) && result;
+
+			for (unsigned int k=0; k<nTypes; k++) {
+				unsigned int id3 = Atom::findTypeId(types[k]);
+				f1 = par.angleParam(p1, types[i], types[j], types[k]);
+				f2 = par.angleParam(p2, id3, id2, id1);
+				result = check(f1 == f2 && sameValues(p1, p2), "angle " + types[i] + " " + types[j] + " " + types[k]) && result;
+				found += f1;
+				f1 = par.ureyBradleyParam(p1, types[i], types[j], types[k]);
+				f2 = par.ureyBradleyParam(p2, id1, id2, id3);
+				result = check(f1 == f2 && sameValues(p1, p2), "Urey-Bradley " + types[i] + " " + types[j] + " " + types[k]) && result;
+				for (unsigned int l=0; l<nTypes; l++) {
+					unsigned int id4 = Atom::findTypeId(types[l]);
+					f1 = par.dihedralParam(d1, types[i], types[j], types[k], types[l]);
+					f2 = par.dihedralParam(d2, id4, id3, id2, id1);
+					result = check(f1 == f2 && d1.size() == d2.size(), "dihedral " + types[i] + " " + types[j] + " " + types[k] + " " + types[l]) && result;
+					for (unsigned int m=0; m<d1.size() && m<d2.size(); m++) {
+						result = check(sameValues(d1[m], d2[m]), "dihedral values " + types[i] + " " + types[j] + " " + types[k] + " " + types[l]) && result;
+					}
+					found += f1;
+					f1 = par.improperParam(p1, types[i], types[j], types[k], types[l]);
+					f2 = par.improperParam(p2, id1, id2, id3, id4);
+					result = check(f1 == f2 && sameValues(p1, p2), "improper " + types[i] + " " + types[j] + " " + types[k] + " " + types[l]) && result;
+				}
+			}
+		}
+	}
+	cout << "Found " << found << " bonds, angles and dihedrals among " << nTypes << " types" << endl;
+
+	// the wildcards: X CE1 CE1 X and NH1 X X H in charmm22.par
+	result = check(par.dihedralParam(d1, "DUM", "CE1", "CE1", "DUM") && d1.size() == 1 && fabs(d1[0][0] - 5.2) < 1.0e-10 && fabs(d1[0][1] - 2.0) < 1.0e-10 && fabs(d1[0][2] - 180.0) < 1.0e-10, "wildcard dihedral") && result;
+	result = check(par.improperParam(p1, "NH1", "DUM", "DUM", "H") && fabs(p1[0] - 20.0) < 1.0e-10 && fabs(p1[1]) < 1.0e-10, "wildcard improper") && result;
+
+	// unknown types
+	result = check(!par.bondParam(p1, "NOTATYPE", "CT1") && sameValues(p1, vector<double>(2, 0.0)), "unknown bond") && result;
+	result = check(!par.vdwParam(p1, "NOTATYPE") && sameValues(p1, vector<double>(4, 0.0)), "unknown vdw") && result;
+	result = check(par.vdwParamPair(Atom::noTypeId, Atom::findTypeId("CT1")) == NULL, "unknown vdw pair") && result;
+
+	// NBFIX
+	unsigned int ct1 = Atom::findTypeId("CT1");
+	unsigned int oc = Atom::findTypeId("OC");
+	unsigned int nh3 = Atom::findTypeId("NH3");
+	double fix1[4] = {0.2, 3.4, 0.2, 3.4};
+	double fix2[4] = {0.3, 3.2, 0.15, 3.0};
+	result = check(sameValues(vector<double>(parNBFix.vdwParamPair(ct1, oc), parNBFix.vdwParamPair(ct1, oc) + 4), vector<double>(fix1, fix1 + 4)), "NBFIX CT1 OC") && result;
+	result = check(sameValues(vector<double>(parNBFix.vdwParamPair(oc, ct1), parNBFix.vdwParamPair(oc, ct1) + 4), vector<double>(fix1, fix1 + 4)), "NBFIX OC CT1") && result;
+	result = check(sameValues(vector<double>(parNBFix.vdwParamPair(nh3, oc), parNBFix.vdwParamPair(nh3, oc) + 4), vector<double>(fix2, fix2 + 4)), "NBFIX NH3 OC") && result;
+	result = check(sameValues(vector<double>(parNBFix.vdwParamPair(oc, oc), parNBFix.vdwParamPair(oc, oc) + 4), vector<double>(par.vdwParamPair(oc, oc), par.vdwParamPair(oc, oc) + 4)), "no NBFIX OC OC") && result;
+	result = check(sameValues(vector<double>(parNBFix.vdwParamPair(ct1, nh3), parNBFix.vdwParamPair(ct1, nh3) + 4), vector<double>(par.vdwParamPair(ct1, nh3), par.vdwParamPair(ct1, nh3) + 4)), "no NBFIX CT1 NH3") && result;
+
+	// the copy keeps the dense matrix
+	CharmmParameterReader parCopy(parNBFix);
+	result = check(sameValues(vector<double>(parCopy.vdwParamPair(ct1, oc), parCopy.vdwParamPair(ct1, oc) + 4), vector<double>(fix1, fix1 + 4)), "NBFIX in the copy") && result;
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
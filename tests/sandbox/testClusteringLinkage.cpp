@@ -0,0 +1,254 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the single, average and complete linkages of Clustering
+ *  on a CondensedDistanceMatrix (SLINK and nearest-neighbor chain)
+ *  against a plain agglomeration that recomputes the linkage of
+ *  all pairs of clusters from their members: the partitions at
+ *  every level and the merge distances must agree.  It also
+ *  clusters a memory mapped matrix in place, checks the matrix
+ *  filled with the RMSD of an ensemble by two threads against
+ *  pairwise qcpRMSD, and reports the time on a larger matrix
+ ******************************************************************/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+
+#include "Clustering.h"
+#include "CondensedDistanceMatrix.h"
+#include "OptimalRMSDCalculator.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+double uniform() {
+	return (double)rand() / RAND_MAX;
+}
+
+// distances between random points in 5 dimensions
+void makeMatrix(unsigned int _n, CondensedDistanceMatrix & _matrix) {
+	vector<double> points;
+	for (unsigned int i=0; i<5*_n; i++) {
+		points.push_back(10.0 * uniform());
+	}
+	_matrix.resize(_n);
+	for (unsigned int i=0; i<_n; i++) {
+		for (unsigned int j=i+1; j<_n; j++) {
+			double sum = 0.0;
+			for (unsigned int k=0; k<5; k++) {
+				sum += (points[5*i+k] - points[5*j+k]) * (points[5*i+k] - points[5*j+k]);
+			}
+			_matrix.setValue(i, j, sqrt(sum));
+		}
+	}
+}
+
+// linkage: 0 single, 1 average, 2 complete
+double linkage(const CondensedDistanceMatrix & _matrix, const vector<unsigned int> & _a, const vector<unsigned int> & _b, int _linkage) {
+	double result = _linkage == 2 ? 0.0 : 1.0e100;
+	double sum = 0.0;
+	for (unsigned int i=0; i<_a.size(); i++) {
+		for (unsigned int j=0; j<_b.size(); j++) {
+			double d = _matrix.getValue(_a[i], _b[j]);
+			sum += d;
+			result = _linkage == 2 ? max(result, d) : min(result, d);
+		}
+	}
+	return _linkage == 1 ? sum / (_a.size() * _b.size()) : result;
+}
+
+// cluster index of each element numbered by first element, as Clustering::getLinkageClusters
+vector<unsigned int> partition(const vector<vector<unsigned int> > & _clusters, unsigned int _n) {
+	vector<unsigned int> owner(_n);
+	for (unsigned int c=0; c<_clusters.size(); c++) {
+		for (unsigned int i=0; i<_clusters[c].size(); i++) {
+			owner[_clusters[c][i]] = c;
+		}
+	}
+	vector<int> number(_clusters.size(), -1);
+	vector<unsigned int> result(_n);
+	unsigned int next = 0;
+	for (unsigned int i=0; i<_n; i++) {
+		if (number[owner[i]] < 0) {
+			number[owner[i]] = next++;
+		}
+		result[i] = number[owner[i]];
+	}
+	return result;
+}
+
+bool checkLinkage(CondensedDistanceMatrix & _matrix, int _linkage) {
+	Clustering clust;
+	bool ok = _linkage == 0 ? clust.SingleLinkage(_matrix) : (_linkage == 1 ? clust.AverageLinkage(_matrix) : clust.CompleteLinkage(_matrix));
+	unsigned int n = _matrix.size();
+	const vector<Clustering::LinkageMerge> & merges = clust.getLinkageMerges();
+	if (!ok || merges.size() != n - 1) {
+		return false;
+	}
+
+	vector<vector<unsigned int> > clusters(n);
+	for (unsigned int i=0; i<n; i++) {
+		clusters[i].push_back(i);
+	}
+	double maxDiff = 0.0;
+	unsigned int mismatches = 0;
+	for (unsigned int k=0; k<n-1; k++) {
+		unsigned int bestA = 0;
+		unsigned int bestB = 1;
+		double best = 1.0e100;
+		for (unsigned int a=0; a<clusters.size(); a++) {
+			for (unsigned int b=a+1; b<clusters.size(); b++) {
+				double d = linkage(_matrix, clusters[a], clusters[b], _linkage);
+				if (d < best) {
+					best = d;
+					bestA = a;
+					bestB = b;
+				}
+			}
+		}
+		clusters[bestA].insert(clusters[bestA].end(), clusters[bestB].begin(), clusters[bestB].end());
+		clusters.erase(clusters.begin() + bestB);
+		maxDiff = max(maxDiff, fabs(best - merges[k].distance));
+		if (clust.getLinkageClustersByNumber(clusters.size()) != partition(clusters, n)) {
+			mismatches++;
+		}
+	}
+	unsigned int last = merges.back().cluster2;
+	cout << "   " << (_linkage == 0 ? "single" : (_linkage == 1 ? "average" : "complete")) << ": " << mismatches << " levels differ, largest distance difference " << maxDiff << endl;
+	return mismatches == 0 && maxDiff < 1.0e-4 && merges.back().size == n && last == 2 * n - 3;
+}
+
+int main() {
+
+	bool result = true;
+	Timer timer;
+	srand(314159);
+
+	// against the plain agglomeration
+	cout << "Linkages of 60 points" << endl;
+	CondensedDistanceMatrix matrix;
+	makeMatrix(60, matrix);
+	for (int l=0; l<3; l++) {
+		if (!checkLinkage(matrix, l)) {
+			result = false;
+		}
+	}
+	CondensedDistanceMatrix before(matrix);
+	Clustering clust;
+	clust.AverageLinkage(matrix);
+	for (unsigned int i=0; i<matrix.getNumberOfValues(); i++) {
+		if (matrix.getData()[i] != before.getData()[i]) {
+			cout << "The matrix was changed by AverageLinkage with _keepMatrix" << endl;
+			result = false;
+			break;
+		}
+	}
+	vector<unsigned int> byCutoff = clust.getLinkageClusters(clust.getLinkageMerges()[49].distance);
+	if (byCutoff != clust.getLinkageClustersByNumber(10)) {
+		cout << "The cut at a distance differs from the cut at the same number of clusters" << endl;
+		result = false;
+	}
+	clust.printLinkageClusters(clust.getLinkageMerges()[55].distance);
+
+	// a mapped matrix filled with the RMSD of an ensemble, clustered in place
+	const unsigned int nStructures = 300;
+	const unsigned int nAtoms = 60;
+	vector<float> coor;
+	for (unsigned int s=0; s<nStructures; s++) {
+		double twist = 1.6 + 0.4 * uniform();
+		for (unsigned int i=0; i<nAtoms; i++) {
+			coor.push_back(2.3 * cos(i * twist) + uniform());
+			coor.push_back(2.3 * sin(i * twist) + uniform());
+			coor.push_back(1.5 * i + uniform());
+		}
+	}
+	string filename = "/tmp/testClusteringLinkage.cdm";
+	CondensedDistanceMatrix mapped;
+	if (!mapped.createMapped(filename, nStructures) || !mapped.fillFromRMSD(coor, nAtoms, 2)) {
+		cout << "Cannot fill the mapped matrix" << endl;
+		result = false;
+	}
+	vector<double> coorDouble(coor.begin(), coor.end());
+	OptimalRMSDCalculator calc;
+	double maxDiff = 0.0;
+	for (unsigned int i=0; i<nStructures; i+=7) {
+		for (unsigned int j=i+1; j<nStructures; j+=5) {
+			double rmsd = calc.qcpRMSD(&coorDouble[3*nAtoms*i], &coorDouble[3*nAtoms*j], nAtoms);
+			maxDiff = max(maxDiff, fabs(rmsd - mapped.getValue(j, i)));
+		}
+	}
+	cout << "RMSD matrix of " << nStructures << " structures, largest difference from qcpRMSD " << maxDiff << endl;
+	if (maxDiff > 1.0e-4) {
+		result = false;
+	}
+	mapped.clear();
+	CondensedDistanceMatrix reopened;
+	if (!reopened.openMapped(filename, true) || reopened.size() != nStructures) {
+		cout << "Cannot reopen the mapped matrix" << endl;
+		result = false;
+	} else {
+		Clustering copyClust;
+		copyClust.CompleteLinkage(reopened);
+		Clustering inPlace;
+		inPlace.CompleteLinkage(reopened, false);
+		if (copyClust.getLinkageClustersByNumber(5) != inPlace.getLinkageClustersByNumber(5) || copyClust.getLinkageMerges().back().distance != inPlace.getLinkageMerges().back().distance) {
+			cout << "Clustering the mapped matrix in place gives a different tree" << endl;
+			result = false;
+		}
+	}
+	reopened.clear();
+	remove(filename.c_str());
+
+	// time
+	const unsigned int nLarge = 6000;
+	CondensedDistanceMatrix large;
+	makeMatrix(nLarge, large);
+	double start = timer.getWallTime();
+	clust.SingleLinkage(large);
+	double singleTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	clust.AverageLinkage(large);
+	double averageTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	clust.CompleteLinkage(large, false);
+	double completeTime = timer.getWallTime() - start;
+	cout << "Linkages of " << nLarge << " points: single " << singleTime << " s, average " << averageTime << " s, complete (in place) " << completeTime << " s" << endl;
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,325 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the dense phi/psi and chi tables: the PhiPsiStatistics
+ *  wrappers against lookups of the string keys, the integer bin
+ *  lookups against the counts, the bilinear interpolation, the
+ *  binary files of PhiPsiStatistics (also through PhiPsiReader)
+ *  and ChiStatistics, the invalid residue type indices, the
+ *  totals after computeTotalCounts, and the chi counts read
+ *  from text.  It reports the time of reading
+ *  the text and the binary phi/psi tables and of the lookups
+ ******************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cmath>
+
+#include "PhiPsiReader.h"
+#include "PhiPsiStatistics.h"
+#include "ChiStatistics.h"
+#include "SysEnv.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+double uniform() {
+	return (double)rand() / RAND_MAX;
+}
+
+int mapCounts(map<string,int> & _table, PhiPsiStatistics & _pps, string _resName, double _phi, double _psi) {
+	stringstream ss;
+	ss << _resName << ":" << _pps.getPhiPsiBin(_phi) << ":" << _pps.getPhiPsiBin(_psi);
+	map<string,int>::iterator it = _table.find(ss.str());
+	if (it == _table.end()) {
+		return MslTools::intMax;
+	}
+	return it->second;
+}
+
+int main() {
+
+	bool result = true;
+	Timer timer;
+	srand(271828);
+	SysEnv env;
+
+	string phiPsiCounts = env.getEnv("MSL_PHIPSI_TABLE");
+	double start = timer.getWallTime();
+	PhiPsiReader ppr(phiPsiCounts);
+	ppr.open();
+	ppr.read();
+	ppr.close();
+	PhiPsiStatistics pps = ppr.getPhiPsiStatistics();
+	pps.hasGrids();
+	double textTime = timer.getWallTime() - start;
+
+	if (!pps.hasGrids()) {
+		cout << "No dense tables for " << phiPsiCounts << endl;
+		cout << "LEAD" << endl;
+		return 0;
+	}
+	map<string,int> table = pps.getPhiPsiCounts();
+
+	vector<string> resNames;
+	resNames.push_back("ALA");
+	resNames.push_back("GLY");
+	resNames.push_back("PRO");
+	resNames.push_back("TRP");
+	resNames.push_back("ALL");
+
+	// the wrappers against the string keys, angles on and around the bin boundaries included
+	unsigned int mismatches = 0;
+	for (unsigned int k=0; k<20000; k++) {
+		string resName = resNames[k % resNames.size()];
+		double phi = 360.0 * uniform() - 180.0;
+		double psi = 360.0 * uniform() - 180.0;
+		if (k % 4 == 1) {
+			phi = 5.0 * floor(phi / 5.0);
+		} else if (k % 4 == 2) {
+			psi = 5.0 * floor(psi / 5.0) - 0.001;
+		}
+		int expected = mapCounts(table, pps, resName, phi, psi);
+		if (expected == MslTools::intMax) continue;
+		if (pps.getCounts(resName, phi, psi) != expected) {
+			mismatches++;
+		}
+		double prob = pps.getProbability(resName, phi, psi);
+		double expectedProb = (double)expected / table[resName];
+		if (fabs(prob - expectedProb) > 1.0e-12) {
+			mismatches++;
+		}
+		double freq = pps.getFreqInBin(resName, phi, psi);
+		double expectedFreq = (double)expected / mapCounts(table, pps, "ALL", phi, psi);
+		if (fabs(freq - expectedFreq) > 1.0e-12 && !(isnan(freq) && isnan(expectedFreq))) {
+			mismatches++;
+		}
+	}
+	if (pps.getCounts("XXX", 10.0, 10.0) != MslTools::intMax || pps.getProbability(resNames[0], 180.0, 10.0) != MslTools::doubleMax) {
+		cout << "Missing entries are not reported" << endl;
+		result = false;
+	}
+	cout << "Wrappers against the string keys: " << mismatches << " mismatches" << endl;
+	if (mismatches > 0) {
+		result = false;
+	}
+
+	// the integer bin lookups against the counts of the bin centers
+	mismatches = 0;
+	for (unsigned int r=0; r<resNames.size(); r++) {
+		int resType = pps.getResidueTypeIndex(resNames[r]);
+		const DihedralGrid & grid = pps.getGrid(resType);
+		for (unsigned int i=0; i<grid.getNumberOfBins(); i++) {
+			for (unsigned int j=0; j<grid.getNumberOfBins(); j++) {
+				double phi = grid.getBinCenter(i);
+				double psi = grid.getBinCenter(j);
+				stringstream key;
+				key << resNames[r] << ":" << phi << ":" << psi;
+				double expectedProb = (double)table[key.str()] / table[resNames[r]];
+				double prob = pps.getProbability(resType, phi + 2.4, psi - 2.4);
+				if (fabs(prob - expectedProb) > 1.0e-12 || fabs(pps.getProbability(resType, phi, psi, true) - expectedProb) > 1.0e-12) {
+					mismatches++;
+				}
+				if (expectedProb > 0.0 && fabs(pps.getLogProbability(resType, phi, psi) - log(expectedProb)) > 1.0e-9) {
+					mismatches++;
+				}
+			}
+		}
+	}
+	cout << "Integer bin lookups against the counts: " << mismatches << " mismatches" << endl;
+	if (mismatches > 0) {
+		result = false;
+	}
+
+	// bilinear interpolation: half way between two centers, between four, and across +/-180
+	int ala = pps.getResidueTypeIndex("ALA");
+	const DihedralGrid & alaGrid = pps.getGrid(ala);
+	double between = pps.getProbability(ala, -60.0, -42.5, true);
+	double expectedBetween = 0.5 * (pps.getProbability(ala, -62.5, -42.5) + pps.getProbability(ala, -57.5, -42.5));
+	double corner = pps.getProbability(ala, -60.0, -45.0, true);
+	double expectedCorner = 0.25 * (pps.getProbability(ala, -62.5, -47.5) + pps.getProbability(ala, -62.5, -42.5) + pps.getProbability(ala, -57.5, -47.5) + pps.getProbability(ala, -57.5, -42.5));
+	double across = pps.getProbability(ala, -122.5, 180.0, true);
+	double expectedAcross = 0.5 * (pps.getProbability(ala, -122.5, 177.5) + pps.getProbability(ala, -122.5, -177.5));
+	if (fabs(between - expectedBetween) > 1.0e-12 || fabs(corner - expectedCorner) > 1.0e-12 || fabs(across - expectedAcross) > 1.0e-12 || across == 0.0) {
+		cout << "Bilinear interpolation " << between << " " << expectedBetween << " " << corner << " " << expectedCorner << " " << across << " " << expectedAcross << endl;
+		result = false;
+	}
+	if (alaGrid.getNumberOfBins() != 72 || alaGrid.getBin(180.0) != 0 || alaGrid.getBin(-180.0) != 0 || alaGrid.getBin(-540.0 + 2.0) != 0) {
+		cout << "Periodic bins" << endl;
+		result = false;
+	}
+
+	// binary round trip
+	string binaryFile = "/tmp/phiPsiCounts.bin";
+	if (!pps.writeBinaryFile(binaryFile) || !PhiPsiStatistics::isBinaryFile(binaryFile) || PhiPsiStatistics::isBinaryFile(phiPsiCounts)) {
+		cout << "Cannot write " << binaryFile << endl;
+		result = false;
+	}
+	start = timer.getWallTime();
+	PhiPsiStatistics binaryPps;
+	binaryPps.readBinaryFile(binaryFile);
+	double binaryTime = timer.getWallTime() - start;
+	mismatches = 0;
+	for (unsigned int k=0; k<20000; k++) {
+		string resName = resNames[k % resNames.size()];
+		double phi = 360.0 * uniform() - 180.0;
+		double psi = 360.0 * uniform() - 180.0;
+		if (binaryPps.getCounts(resName, phi, psi) != pps.getCounts(resName, phi, psi) || binaryPps.getPropensity(resName, phi, psi) != pps.getPropensity(resName, phi, psi)) {
+			mismatches++;
+		}
+	}
+	if (binaryPps.getGridSize() != pps.getGridSize() || binaryPps.getPhiPsiCounts() != table) {
+		mismatches++;
+	}
+	// the binary file read through the PhiPsiReader
+	PhiPsiReader binaryReader(binaryFile);
+	binaryReader.open();
+	if (!binaryReader.read() || binaryReader.getPhiPsiStatistics().getPhiPsiCounts() != table) {
+		mismatches++;
+	}
+	binaryReader.close();
+	cout << "Binary table against the text table: " << mismatches << " mismatches" << endl;
+	if (mismatches > 0) {
+		result = false;
+	}
+
+	// the integer lookups with an index that is not a residue type
+	int nTypes = pps.getResidueTypeIndex("ALL") + 1000;
+	if (pps.getProbability(-1, 10.0, 10.0) != MslTools::doubleMax || pps.getLogProbability(nTypes, 10.0, 10.0) != MslTools::doubleMax) {
+		cout << "Invalid residue type indices are not reported" << endl;
+		result = false;
+	}
+
+	// the totals are those of the string keys: ALL counts given in the table are
+	// added to the bins by computeTotalCounts but do not enter the ALL total
+	PhiPsiStatistics smallPps;
+	smallPps.setGridSize(5.0);
+	for (int i=0; i<72; i++) {
+		for (int j=0; j<72; j++) {
+			smallPps.addStatisitics("ALA", MslTools::doubleToString(-177.5 + 5.0 * i), MslTools::doubleToString(-177.5 + 5.0 * j), 1 + (i + j) % 3);
+			smallPps.addStatisitics("ALL", MslTools::doubleToString(-177.5 + 5.0 * i), MslTools::doubleToString(-177.5 + 5.0 * j), 2);
+		}
+	}
+	smallPps.computeTotalCounts();
+	map<string,int> smallTable = smallPps.getPhiPsiCounts();
+	double probAll = smallPps.getProbabilityAll(-62.5, -42.5);
+	double expectedProbAll = (double)smallTable["ALL:-62.5:-42.5"] / smallTable["ALL"];
+	if (!smallPps.hasGrids() || smallTable["ALL"] != smallTable["ALA"] || fabs(probAll - expectedProbAll) > 1.0e-12) {
+		cout << "The ALL total " << smallTable["ALL"] << " differs from the counts of the residues " << smallTable["ALA"] << " (probability " << probAll << " != " << expectedProbAll << ")" << endl;
+		result = false;
+	}
+
+	// time
+	unsigned int nQueries = 1000000;
+	vector<double> angles(2 * nQueries);
+	for (unsigned int k=0; k<angles.size(); k++) {
+		angles[k] = 360.0 * uniform() - 180.0;
+	}
+	start = timer.getWallTime();
+	double sumMap = 0.0;
+	for (unsigned int k=0; k<nQueries; k++) {
+		sumMap += mapCounts(table, pps, "ALA", angles[2*k], angles[2*k+1]);
+	}
+	double mapTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	double sumWrapper = 0.0;
+	for (unsigned int k=0; k<nQueries; k++) {
+		sumWrapper += pps.getCounts("ALA", angles[2*k], angles[2*k+1]);
+	}
+	double wrapperTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	double sumDense = 0.0;
+	for (unsigned int k=0; k<nQueries; k++) {
+		sumDense += pps.getLogProbability(ala, angles[2*k], angles[2*k+1]);
+	}
+	double denseTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	for (unsigned int k=0; k<nQueries; k++) {
+		sumDense += pps.getLogProbability(ala, angles[2*k], angles[2*k+1], true);
+	}
+	double interpolatedTime = timer.getWallTime() - start;
+	cout << "Reading the tables: text " << textTime << " s, binary " << binaryTime << " s" << endl;
+	cout << nQueries << " lookups: string keys " << mapTime << " s, getCounts " << wrapperTime << " s, dense " << denseTime << " s, interpolated " << interpolatedTime << " s" << endl;
+	if (sumMap != sumWrapper || sumDense >= 0.0) {
+		cout << "The timed lookups differ" << endl;
+		result = false;
+	}
+
+	// chi counts from text, and their binary file
+	string chiFile = "/tmp/chiCounts.txt";
+	ofstream fout(chiFile.c_str());
+	fout << "# chi counts" << endl;
+	fout << "RESN VAL" << endl;
+	fout << "STAT 175 6" << endl;
+	fout << "STAT -65 2" << endl;
+	fout << "STAT 65 2" << endl;
+	fout << "RESN LEU" << endl;
+	fout << "STAT -65 175 30" << endl;
+	fout << "STAT -175 65 10" << endl;
+	fout << "STAT -85 65 0" << endl;
+	fout.close();
+
+	ChiStatistics chiStat;
+	if (!chiStat.readCounts(chiFile) || chiStat.getChiGridSize() != 10.0) {
+		cout << "Cannot read " << chiFile << endl;
+		result = false;
+	}
+	vector<double> valChi(1, 172.0);
+	vector<double> leuChis(2, 0.0);
+	leuChis[0] = -62.0;
+	leuChis[1] = 178.0;
+	double valBetween[1] = {-60.0};
+	if (chiStat.getCounts("VAL", valChi) != 6 || fabs(chiStat.getProbability("VAL", valChi) - 0.6) > 1.0e-12 ||
+			fabs(chiStat.getLogProbability("LEU", leuChis) - log(0.75)) > 1.0e-12 ||
+			fabs(chiStat.getProbability(chiStat.getResidueTypeIndex("VAL"), valBetween, true) - 0.1) > 1.0e-12 ||
+			fabs(chiStat.getLogProbability("LEU", vector<double>(2, 0.0)) - log(0.5 / 40.0)) > 1.0e-12 ||
+			chiStat.getCounts("ALA", valChi) != MslTools::intMax) {
+		cout << "Chi counts " << chiStat.getCounts("VAL", valChi) << " " << chiStat.getProbability("VAL", valChi) << " " << chiStat.getLogProbability("LEU", leuChis) << endl;
+		result = false;
+	}
+	string chiBinaryFile = "/tmp/chiCounts.bin";
+	ChiStatistics binaryChiStat;
+	if (!chiStat.writeBinaryFile(chiBinaryFile) || !binaryChiStat.readBinaryFile(chiBinaryFile) ||
+			binaryChiStat.getProbability("LEU", leuChis) != chiStat.getProbability("LEU", leuChis) ||
+			binaryChiStat.getChiGridSize() != chiStat.getChiGridSize()) {
+		cout << "Chi binary file" << endl;
+		result = false;
+	}
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
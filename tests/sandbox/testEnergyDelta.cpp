@@ -0,0 +1,186 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the incremental energy of the EnergySet (markMoved,
+ *  calcEnergyDelta, acceptEnergyDelta, rejectEnergyDelta) with a
+ *  series of random moves of single residues, some accepted and
+ *  some rejected.  After each move the total energy and the
+ *  number of interactions are compared with a full calcEnergy()
+ *  and the time per move of the two is reported.  After long runs
+ *  the totals, summed again periodically, must not drift.
+ ******************************************************************/
+
+#include <iostream>
+#include <iomanip>
+
+#include "System.h"
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "RandomNumberGenerator.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+int main() {
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+
+	string residues[10] = {"ALA", "ILE", "GLU", "LEU", "LYS", "PHE", "SER", "ARG", "TRP", "ASP"};
+	string seqString = "A:";
+	unsigned int nRes = 100;
+	for (unsigned int i=0; i<nRes; i++) {
+		seqString += " " + residues[i % 10];
+	}
+	PolymerSequence seq(seqString);
+	CSB.buildSystem(seq);
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAtoms();
+	CSB.updateNonBonded(9.0, 10.0, 11.0);
+	cout << "System with " << sys.atomSize() << " atoms" << endl;
+
+	EnergySet * pESet = sys.getEnergySet();
+	double E = pESet->initializeEnergyDelta();
+	double fullE = sys.calcEnergy();
+	bool result = true;
+	if (fabs(E - fullE) > 1.0e-7 * (1.0 + fabs(fullE))) {
+		cout << "Initial energy " << E << " differs from calcEnergy() " << fullE << endl;
+		result = false;
+	}
+
+	RandomNumberGenerator rng;
+	rng.setSeed(7);
+	Timer timer;
+	double deltaTime = 0.0;
+	double fullTime = 0.0;
+	unsigned int moves = 100;
+	unsigned int accepted = 0;
+	for (unsigned int m=0; m<moves; m++) {
+		// displace all the atoms of a random residue
+		Residue & res = sys.getResidue(rng.getRandomInt(sys.positionSize() - 1));
+		AtomPointerVector & atoms = res.getAtomPointers();
+		vector<CartesianPoint> saved;
+		for (unsigned int i=0; i<atoms.size(); i++) {
+			saved.push_back(atoms[i]->getCoor());
+			atoms[i]->setCoor(atoms[i]->getCoor() + CartesianPoint(rng.getRandomDouble(-0.3, 0.3), rng.getRandomDouble(-0.3, 0.3), rng.getRandomDouble(-0.3, 0.3)));
+		}
+
+		double start = timer.getWallTime();
+		pESet->markMoved(atoms);
+		double dE = pESet->calcEnergyDelta();
+		double newE = pESet->getTotalEnergy();
+		unsigned int newN = pESet->getTotalNumberOfInteractionsCalculated();
+		bool accept = rng.getRandomDouble() < 0.5;
+		if (accept) {
+			pESet->acceptEnergyDelta();
+			accepted++;
+		} else {
+			for (unsigned int i=0; i<atoms.size(); i++) {
+				atoms[i]->setCoor(saved[i]);
+			}
+			pESet->rejectEnergyDelta();
+		}
+		deltaTime += timer.getWallTime() - start;
+
+		// compare with a full calculation
+		start = timer.getWallTime();
+		fullE = sys.calcEnergy();
+		fullTime += timer.getWallTime() - start;
+		unsigned int fullN = pESet->getTotalNumberOfInteractionsCalculated();
+		if (accept) {
+			if (fabs(newE - fullE) > 1.0e-7 * (1.0 + fabs(fullE)) || newN != fullN || fabs(dE - (newE - E)) > 1.0e-7 * (1.0 + fabs(fullE))) {
+				cout << "Move " << m << " accepted: delta energy " << newE << " (" << newN << ") full " << fullE << " (" << fullN << ")" << endl;
+				result = false;
+			}
+			E = newE;
+		} else {
+			if (fabs(E - fullE) > 1.0e-7 * (1.0 + fabs(fullE)) || newN != fullN) {
+				cout << "Move " << m << " rejected: restored energy " << E << " full " << fullE << " (" << fullN << ")" << endl;
+				result = false;
+			}
+		}
+		// calcEnergy() overwrote the totals, check that the cached ones are unchanged by a move with no atoms
+		pESet->calcEnergyDelta();
+		pESet->acceptEnergyDelta();
+		if (pESet->getTotalEnergy() != E) {
+			cout << "Move " << m << ": cached energy changed by an empty move" << endl;
+			result = false;
+		}
+	}
+	cout << setprecision(10) << "Final energy " << E << ", " << accepted << " of " << moves << " moves accepted" << endl;
+	cout << "Time per move: delta " << deltaTime / moves << " s, full calcEnergy() " << fullTime / moves << " s" << endl;
+
+	// long runs: the totals are updated by the differences, with the resync they are summed again from the
+	// cached energies every 250 moves, after the last one they must be identical to a new initialization
+	unsigned int longMoves = 2000;
+	for (unsigned int r=0; r<2; r++) {
+		unsigned int interval = r == 0 ? 0 : 250;
+		pESet->setEnergyDeltaResyncInterval(interval);
+		pESet->initializeEnergyDelta();
+		for (unsigned int m=0; m<longMoves; m++) {
+			Residue & res = sys.getResidue(rng.getRandomInt(sys.positionSize() - 1));
+			AtomPointerVector & atoms = res.getAtomPointers();
+			vector<CartesianPoint> saved;
+			for (unsigned int i=0; i<atoms.size(); i++) {
+				saved.push_back(atoms[i]->getCoor());
+				atoms[i]->setCoor(atoms[i]->getCoor() + CartesianPoint(rng.getRandomDouble(-0.1, 0.1), rng.getRandomDouble(-0.1, 0.1), rng.getRandomDouble(-0.1, 0.1)));
+			}
+			pESet->markMoved(atoms);
+			pESet->calcEnergyDelta();
+			if (rng.getRandomDouble() < 0.5) {
+				pESet->acceptEnergyDelta();
+			} else {
+				for (unsigned int i=0; i<atoms.size(); i++) {
+					atoms[i]->setCoor(saved[i]);
+				}
+				pESet->rejectEnergyDelta();
+			}
+		}
+		double cached = pESet->getTotalEnergy();
+		double initialized = pESet->initializeEnergyDelta();
+		cout << "After " << longMoves << " moves, resync every " << interval << ": delta energy " << cached << ", summed again " << initialized << ", difference " << cached - initialized << endl;
+		if ((interval > 0 && cached != initialized) || fabs(cached - initialized) > 1.0e-7 * (1.0 + fabs(initialized))) {
+			cout << "The delta energy drifted from the sum of the interactions" << endl;
+			result = false;
+		}
+	}
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
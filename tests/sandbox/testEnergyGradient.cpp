@@ -0,0 +1,193 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the energy and gradient used by the minimizer
+ *  (EnergySet::calcEnergyAndEnergyGradient, which adds the
+ *  gradient of each interaction directly into a flat buffer)
+ *  against the per interaction getEnergy(std::vector<double>*)
+ *  with a temporary gradient vector, and against a numerical
+ *  derivative of calcEnergyWithoutSwitchingFunction() (without
+ *  the dihedrals, see below).  Some
+ *  atoms are fixed (minimization index -1).  The time of the
+ *  two forms is reported.
+ ******************************************************************/
+
+#include <iostream>
+#include <cmath>
+
+#include "System.h"
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+// the energy and gradient as computed before the flat buffer, with a new vector for each interaction
+double referenceEnergyAndGradient(EnergySet & _eSet, vector<double> & _gradients) {
+	double energy = 0.0;
+	map<string, vector<Interaction*> > * pTerms = _eSet.getEnergyTerms();
+	for (map<string, vector<Interaction*> >::iterator k=pTerms->begin(); k!=pTerms->end(); k++) {
+		if (!_eSet.isTermActive(k->first)) {
+			continue;
+		}
+		for (vector<Interaction*>::iterator l=k->second.begin(); l!=k->second.end(); l++) {
+			if (!(*l)->isActive()) {
+				continue;
+			}
+			vector<Atom*> & atoms = (*l)->getAtomPointers();
+			vector<double> gradient;
+			energy += (*l)->getEnergy(&gradient);
+			for (unsigned int a=0; a<atoms.size(); a++) {
+				int index = atoms[a]->getMinimizationIndex();
+				if (index == -1) {
+					continue;
+				}
+				for (unsigned int c=0; c<3; c++) {
+					_gradients[3*(index-1)+c] += gradient[3*a+c];
+				}
+			}
+		}
+	}
+	return energy;
+}
+
+int main() {
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+
+	string residues[10] = {"ALA", "ILE", "GLU", "LEU", "LYS", "PHE", "SER", "ARG", "TRP", "ASP"};
+	string seqString = "A:";
+	unsigned int nRes = 60;
+	for (unsigned int i=0; i<nRes; i++) {
+		seqString += " " + residues[i % 10];
+	}
+	PolymerSequence seq(seqString);
+	CSB.buildSystem(seq);
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAtoms();
+	CSB.updateNonBonded(9.0, 10.0, 11.0);
+
+	// as the minimizer: the index starts from 1, every tenth atom is fixed
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		atoms[i]->setMinimizationIndex(i % 10 == 9 ? -1 : (int)i + 1);
+	}
+	cout << "System with " << atoms.size() << " atoms" << endl;
+
+	EnergySet & eSet = *(sys.getEnergySet());
+	bool result = true;
+
+	vector<double> reference(atoms.size() * 3, 0.0);
+	vector<double> gradient(atoms.size() * 3, 0.0);
+	double referenceE = referenceEnergyAndGradient(eSet, reference);
+	double E = eSet.calcEnergyAndEnergyGradient(gradient);
+	double maxDiff = 0.0;
+	for (unsigned int i=0; i<gradient.size(); i++) {
+		maxDiff = max(maxDiff, fabs(gradient[i] - reference[i]));
+	}
+	cout << "Energy " << E << " (reference " << referenceE << "), largest gradient difference " << maxDiff << endl;
+	if (fabs(E - referenceE) > 1.0e-9 * (1.0 + fabs(referenceE)) || maxDiff > 1.0e-9) {
+		cout << "The energy or the gradient differ from the reference" << endl;
+		result = false;
+	}
+	double withoutSwitching = eSet.calcEnergyWithoutSwitchingFunction();
+	if (fabs(E - withoutSwitching) > 1.0e-9 * (1.0 + fabs(E))) {
+		cout << "The energy differs from calcEnergyWithoutSwitchingFunction " << withoutSwitching << endl;
+		result = false;
+	}
+
+	// numerical derivative of a few coordinates, the fixed atoms have zero gradient.  The
+	// dihedrals are excluded: the structure built from the internal coordinates has many
+	// dihedrals at exactly 0 or 180, where CartesianGeometry::dihedralDerivative is approximate
+	eSet.setTermActive("CHARMM_DIHE", false);
+	gradient.assign(gradient.size(), 0.0);
+	eSet.calcEnergyAndEnergyGradient(gradient);
+	double h = 1.0e-5;
+	double maxError = 0.0;
+	for (unsigned int i=0; i<atoms.size(); i+=37) {
+		int index = atoms[i]->getMinimizationIndex();
+		for (unsigned int c=0; c<3; c++) {
+			CartesianPoint saved = atoms[i]->getCoor();
+			CartesianPoint shift(c == 0 ? h : 0.0, c == 1 ? h : 0.0, c == 2 ? h : 0.0);
+			atoms[i]->setCoor(saved + shift);
+			double plus = eSet.calcEnergyWithoutSwitchingFunction();
+			atoms[i]->setCoor(saved - shift);
+			double minus = eSet.calcEnergyWithoutSwitchingFunction();
+			atoms[i]->setCoor(saved);
+			double numerical = (plus - minus) / (2.0 * h);
+			if (index == -1) {
+				continue;
+			}
+			double error = fabs(numerical - gradient[3*(index-1)+c]) / (1.0 + fabs(numerical));
+			maxError = max(maxError, error);
+		}
+		if (index == -1 && (gradient[3*i] != 0.0 || gradient[3*i+1] != 0.0 || gradient[3*i+2] != 0.0)) {
+			cout << "Non zero gradient for the fixed atom " << i << endl;
+			result = false;
+		}
+	}
+	cout << "Largest relative error against the numerical derivative " << maxError << endl;
+	if (maxError > 1.0e-4) {
+		cout << "The gradient differs from the numerical derivative" << endl;
+		result = false;
+	}
+
+	eSet.setTermActive("CHARMM_DIHE", true);
+
+	// time
+	Timer timer;
+	unsigned int calls = 20;
+	double start = timer.getWallTime();
+	for (unsigned int n=0; n<calls; n++) {
+		reference.assign(reference.size(), 0.0);
+		referenceEnergyAndGradient(eSet, reference);
+	}
+	double referenceTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	for (unsigned int n=0; n<calls; n++) {
+		gradient.assign(gradient.size(), 0.0);
+		eSet.calcEnergyAndEnergyGradient(&gradient[0]);
+	}
+	double flatTime = timer.getWallTime() - start;
+	cout << "Time per energy and gradient: " << referenceTime / calls << " s with a vector per interaction, " << flatTime / calls << " s flat" << endl;
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
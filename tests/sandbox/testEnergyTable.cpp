@@ -0,0 +1,385 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+
+/******************************************************************
+ *  Tests the flat EnergyTable: conversion from and to the legacy
+ *  nested tables (in double and float precision), and that Dead
+ *  End Elimination and the Self Consistent Mean Field give the
+ *  same results with the flat and the nested tables, also when
+ *  the table is sparse (the pairs of positions that do not
+ *  interact are not stored).  The text and binary files are
+ *  written and read back (the binary file also memory mapped)
+ *  and used by DEE.  The memory and the time of a DEE-like sweep over a large table are
+ *  reported for the nested and the flat forms.
+ ******************************************************************/
+
+#include <iostream>
+#include <cmath>
+
+#include "EnergyTable.h"
+#include "DeadEndElimination.h"
+#include "SelfConsistentMeanField.h"
+#include "RandomNumberGenerator.h"
+#include "Timer.h"
+#include "MslTools.h"
+
+using namespace std;
+
+using namespace MSL;
+
+void createTables(vector<unsigned int> _rotamers, vector<vector<double> > & _self, vector<vector<vector<vector<double> > > > & _pair, RandomNumberGenerator & _rng) {
+	_self.clear();
+	_pair.clear();
+	for (unsigned int i=0; i<_rotamers.size(); i++) {
+		_self.push_back(vector<double>(_rotamers[i], 0.0));
+		_pair.push_back(vector<vector<vector<double> > >(_rotamers[i]));
+		for (unsigned int ir=0; ir<_rotamers[i]; ir++) {
+			_self[i][ir] = _rng.getRandomDouble(-10.0, 10.0);
+			for (unsigned int j=0; j<i; j++) {
+				_pair[i][ir].push_back(vector<double>(_rotamers[j], 0.0));
+				for (unsigned int jr=0; jr<_rotamers[j]; jr++) {
+					_pair[i][ir][j][jr] = _rng.getRandomDouble(-2.0, 2.0);
+				}
+			}
+		}
+	}
+}
+
+// memory of the nested tables: the energies, the vector objects and their heap blocks (estimated as 16 bytes each)
+size_t getNestedMemory(const vector<vector<double> > & _self, const vector<vector<vector<vector<double> > > > & _pair) {
+	size_t out = sizeof(_self) + sizeof(_pair);
+	for (unsigned int i=0; i<_self.size(); i++) {
+		out += sizeof(vector<double>) + 16 + _self[i].size() * sizeof(double);
+	}
+	for (unsigned int i=0; i<_pair.size(); i++) {
+		out += sizeof(vector<vector<vector<double> > >) + 16;
+		for (unsigned int ir=0; ir<_pair[i].size(); ir++) {
+			out += sizeof(vector<vector<double> >) + 16;
+			for (unsigned int j=0; j<_pair[i][ir].size(); j++) {
+				out += sizeof(vector<double>) + 16 + _pair[i][ir][j].size() * sizeof(double);
+			}
+		}
+	}
+	return out;
+}
+
+// for each rotamer the sum over the other positions of the best pair energy, as in the DEE singles
+double sweepNested(const vector<vector<vector<vector<double> > > > & _pair) {
+	double out = 0.0;
+	for (unsigned int i=0; i<_pair.size(); i++) {
+		for (unsigned int ir=0; ir<_pair[i].size(); ir++) {
+			for (unsigned int j=0; j<_pair[i][ir].size(); j++) {
+				double min = _pair[i][ir][j][0];
+				for (unsigned int jr=1; jr<_pair[i][ir][j].size(); jr++) {
+					if (_pair[i][ir][j][jr] < min) {
+						min = _pair[i][ir][j][jr];
+					}
+				}
+				out += min;
+			}
+		}
+	}
+	return out;
+}
+
+double sweepTable(const EnergyTable & _table) {
+	double out = 0.0;
+	for (unsigned int i=0; i<_table.getNumberOfPositions(); i++) {
+		for (unsigned int ir=0; ir<_table.getNumberOfRotamers(i); ir++) {
+			for (unsigned int j=0; j<i; j++) {
+				double min = _table.getPairEnergy(i, ir, j, 0);
+				for (unsigned int jr=1; jr<_table.getNumberOfRotamers(j); jr++) {
+					double e = _table.getPairEnergy(i, ir, j, jr);
+					if (e < min) {
+						min = e;
+					}
+				}
+				out += min;
+			}
+		}
+	}
+	return out;
+}
+
+int main() {
+
+	bool result = true;
+	RandomNumberGenerator rng;
+	rng.setSeed(3);
+
+	/******************************************************************
+	 *  Conversion from and to the nested tables
+	 ******************************************************************/
+	vector<unsigned int> rotamers;
+	for (unsigned int i=0; i<9; i++) {
+		rotamers.push_back(1 + (i * 7) % 12);
+	}
+	vector<vector<double> > self;
+	vector<vector<vector<vector<double> > > > pair;
+	createTables(rotamers, self, pair, rng);
+
+	EnergyTable table(self, pair);
+	EnergyTable floatTable(self, pair, true);
+	double maxFloatError = 0.0;
+	for (unsigned int i=0; i<rotamers.size(); i++) {
+		for (unsigned int ir=0; ir<rotamers[i]; ir++) {
+			if (table.getSelfEnergy(i, ir) != self[i][ir] || floatTable.getSelfEnergy(i, ir) != self[i][ir]) {
+				cout << "Self energy " << i << "/" << ir << " differs from the nested table" << endl;
+				result = false;
+			}
+			for (unsigned int j=0; j<i; j++) {
+				for (unsigned int jr=0; jr<rotamers[j]; jr++) {
+					if (table.getPairEnergy(i, ir, j, jr) != pair[i][ir][j][jr] || table.getPairEnergy(j, jr, i, ir) != pair[i][ir][j][jr]) {
+						cout << "Pair energy " << i << "/" << ir << " - " << j << "/" << jr << " differs from the nested table" << endl;
+						result = false;
+					}
+					double error = fabs(floatTable.getPairEnergy(i, ir, j, jr) - pair[i][ir][j][jr]);
+					if (error > maxFloatError) {
+						maxFloatError = error;
+					}
+				}
+			}
+		}
+	}
+	cout << "Largest error of the float table: " << maxFloatError << endl;
+	if (maxFloatError > 1.0e-6) {
+		cout << "The error of the float table is too large" << endl;
+		result = false;
+	}
+
+	vector<vector<double> > self2;
+	vector<vector<vector<vector<double> > > > pair2;
+	table.getTables(self2, pair2);
+	if (self2 != self || pair2 != pair) {
+		cout << "The nested tables are not recovered by getTables" << endl;
+		result = false;
+	}
+	EnergyTable copyTable(table);
+	copyTable.getTables(self2, pair2);
+	if (self2 != self || pair2 != pair) {
+		cout << "The copied table differs from the original" << endl;
+		result = false;
+	}
+
+	/******************************************************************
+	 *  The optimizers give the same results with the flat table
+	 ******************************************************************/
+	DeadEndElimination DEE1(self, pair);
+	DeadEndElimination DEE2(table);
+	DEE1.setVerbose(false, 0);
+	DEE2.setVerbose(false, 0);
+	DEE1.runSimpleGoldsteinSingles();
+	DEE2.runSimpleGoldsteinSingles();
+	DEE1.runSimpleGoldsteinPairs();
+	DEE2.runSimpleGoldsteinPairs();
+	cout << "DEE combinations: " << DEE1.getTotalCombinations() << " (nested), " << DEE2.getTotalCombinations() << " (flat)" << endl;
+	if (DEE1.getMask() != DEE2.getMask()) {
+		cout << "DEE eliminated different rotamers with the flat table" << endl;
+		result = false;
+	}
+
+	SelfConsistentMeanField SCMF1(self, pair);
+	SelfConsistentMeanField SCMF2(table);
+	for (unsigned int i=0; i<50; i++) {
+		SCMF1.cycle();
+		SCMF2.cycle();
+	}
+	if (SCMF1.getP() != SCMF2.getP() || SCMF1.getAverageEnergy() != SCMF2.getAverageEnergy()) {
+		cout << "SCMF probabilities differ with the flat table" << endl;
+		result = false;
+	}
+
+	/******************************************************************
+	 *  Sparse table: the positions only interact with the positions
+	 *  that are close in sequence
+	 ******************************************************************/
+	for (unsigned int i=0; i<rotamers.size(); i++) {
+		for (unsigned int ir=0; ir<rotamers[i]; ir++) {
+			for (unsigned int j=0; j+3<i; j++) {
+				pair[i][ir][j] = vector<double>(rotamers[j], 0.0);
+			}
+		}
+	}
+	EnergyTable denseTable(self, pair);
+	EnergyTable sparseTable(self, pair, false, true);
+	cout << "Sparse table: " << sparseTable.getNumberOfStoredPairs() << " of " << rotamers.size() * (rotamers.size() - 1) / 2 << " pairs stored, memory " << sparseTable.getMemoryUsage() << " bytes (dense " << denseTable.getMemoryUsage() << ")" << endl;
+	if (sparseTable.getNumberOfStoredPairs() != 3 * rotamers.size() - 6 || sparseTable.getMemoryUsage() >= denseTable.getMemoryUsage()) {
+		cout << "Unexpected number of stored pairs in the sparse table" << endl;
+		result = false;
+	}
+	sparseTable.getTables(self2, pair2);
+	if (self2 != self || pair2 != pair) {
+		cout << "The nested tables are not recovered from the sparse table" << endl;
+		result = false;
+	}
+	for (unsigned int i=0; i<rotamers.size(); i++) {
+		const vector<unsigned int> & neighbors = sparseTable.getNeighbors(i);
+		for (unsigned int n=0; n<neighbors.size(); n++) {
+			unsigned int d = neighbors[n] > i ? neighbors[n] - i : i - neighbors[n];
+			if (d == 0 || d > 3 || !sparseTable.isPairStored(i, neighbors[n])) {
+				cout << "Position " << neighbors[n] << " should not be a neighbor of position " << i << endl;
+				result = false;
+			}
+		}
+	}
+
+	DeadEndElimination DEE3(denseTable);
+	DeadEndElimination DEE4(sparseTable);
+	DEE3.setVerbose(false, 0);
+	DEE4.setVerbose(false, 0);
+	DEE3.runSimpleGoldsteinSingles();
+	DEE4.runSimpleGoldsteinSingles();
+	DEE3.runSimpleGoldsteinPairs();
+	DEE4.runSimpleGoldsteinPairs();
+	cout << "DEE combinations: " << DEE3.getTotalCombinations() << " (dense), " << DEE4.getTotalCombinations() << " (sparse)" << endl;
+	if (DEE3.getMask() != DEE4.getMask()) {
+		cout << "DEE eliminated different rotamers with the sparse table" << endl;
+		result = false;
+	}
+
+	SelfConsistentMeanField SCMF3(denseTable);
+	SelfConsistentMeanField SCMF4(sparseTable);
+	for (unsigned int i=0; i<50; i++) {
+		SCMF3.cycle();
+		SCMF4.cycle();
+	}
+	if (SCMF3.getP() != SCMF4.getP() || SCMF3.getAverageEnergy() != SCMF4.getAverageEnergy()) {
+		cout << "SCMF probabilities differ with the sparse table" << endl;
+		result = false;
+	}
+
+	/******************************************************************
+	 *  Text and binary files
+	 ******************************************************************/
+	vector<vector<string> > labels(rotamers.size());
+	for (unsigned int i=0; i<rotamers.size(); i++) {
+		for (unsigned int ir=0; ir<rotamers[i]; ir++) {
+			labels[i].push_back("A," + MslTools::intToString(i + 1) + ":" + MslTools::intToString(ir));
+		}
+	}
+	sparseTable.setRotamerLabels(labels);
+	sparseTable.setFixedEnergy(-12.25);
+	if (!sparseTable.writeTextFile("/tmp/testEnergyTable.txt") || !sparseTable.writeBinaryFile("/tmp/testEnergyTable.bin")) {
+		cout << "Cannot write the energy table files" << endl;
+		result = false;
+	}
+	if (EnergyTable::isBinaryFile("/tmp/testEnergyTable.txt") || !EnergyTable::isBinaryFile("/tmp/testEnergyTable.bin")) {
+		cout << "The format of the energy table files is not detected" << endl;
+		result = false;
+	}
+	EnergyTable textTable;
+	EnergyTable mappedTable;
+	EnergyTable binaryTable;
+	textTable.readFile("/tmp/testEnergyTable.txt");
+	mappedTable.readFile("/tmp/testEnergyTable.bin");
+	binaryTable.readBinaryFile("/tmp/testEnergyTable.bin", false);
+	cout << "Files read: memory mapped " << mappedTable.getMemoryMapped() << ", " << mappedTable.getNumberOfStoredPairs() << " pairs stored" << endl;
+	EnergyTable * fileTables[3] = {&textTable, &mappedTable, &binaryTable};
+	for (unsigned int k=0; k<3; k++) {
+		fileTables[k]->getTables(self2, pair2);
+		if (self2 != self || pair2 != pair || fileTables[k]->getFixedEnergy() != -12.25 || fileTables[k]->getRotamerLabels() != labels || fileTables[k]->getNumberOfStoredPairs() != sparseTable.getNumberOfStoredPairs()) {
+			cout << "The energy table read from file " << k << " differs from the original" << endl;
+			result = false;
+		}
+	}
+	if (!mappedTable.getMemoryMapped() || binaryTable.getMemoryMapped()) {
+		cout << "The binary file should be memory mapped only on request" << endl;
+		result = false;
+	}
+	EnergyTable floatFileTable(self, pair, true, true);
+	floatFileTable.writeBinaryFile("/tmp/testEnergyTable.float.bin");
+	EnergyTable floatMapped;
+	floatMapped.readFile("/tmp/testEnergyTable.float.bin");
+	if (!floatMapped.getUseFloat() || sweepTable(floatMapped) != sweepTable(floatFileTable)) {
+		cout << "The float binary table differs from the original" << endl;
+		result = false;
+	}
+
+	DeadEndElimination DEE5(self, pair);
+	DeadEndElimination DEE6;
+	DEE5.setVerbose(false, 0);
+	DEE6.setVerbose(false, 0);
+	DEE6.readEnergyTable("/tmp/testEnergyTable.bin");
+	DEE5.runSimpleGoldsteinSingles();
+	DEE6.runSimpleGoldsteinSingles();
+	DEE5.runSimpleGoldsteinPairs();
+	DEE6.runSimpleGoldsteinPairs();
+	if (DEE5.getMask() != DEE6.getMask()) {
+		cout << "DEE eliminated different rotamers with the memory mapped table" << endl;
+		result = false;
+	}
+
+	/******************************************************************
+	 *  Memory and time of a large table
+	 ******************************************************************/
+	vector<unsigned int> largeRotamers(30, 100);
+	createTables(largeRotamers, self, pair, rng);
+	EnergyTable largeTable(self, pair);
+	EnergyTable largeFloatTable(self, pair, true);
+	cout << "Table of " << largeRotamers.size() << " positions with " << largeRotamers[0] << " rotamers" << endl;
+	cout << "Memory: " << getNestedMemory(self, pair) / 1048576.0 << " MB nested, " << largeTable.getMemoryUsage() / 1048576.0 << " MB flat, " << largeFloatTable.getMemoryUsage() / 1048576.0 << " MB flat (float)" << endl;
+
+	Timer timer;
+	unsigned int sweeps = 5;
+	double start = timer.getWallTime();
+	double nestedSum = 0.0;
+	for (unsigned int i=0; i<sweeps; i++) {
+		nestedSum += sweepNested(pair);
+	}
+	double nestedTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	double tableSum = 0.0;
+	for (unsigned int i=0; i<sweeps; i++) {
+		tableSum += sweepTable(largeTable);
+	}
+	double tableTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	double floatSum = 0.0;
+	for (unsigned int i=0; i<sweeps; i++) {
+		floatSum += sweepTable(largeFloatTable);
+	}
+	double floatTime = timer.getWallTime() - start;
+	cout << "Sweep time: " << nestedTime << " s nested, " << tableTime << " s flat, " << floatTime << " s flat (float)" << endl;
+	if (nestedSum != tableSum) {
+		cout << "The sweep of the flat table gives a different result" << endl;
+		result = false;
+	}
+	if (fabs(nestedSum - floatSum) > 1.0e-6 * fabs(nestedSum)) {
+		cout << "The sweep of the float table gives a different result" << endl;
+		result = false;
+	}
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,217 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the analytic gradients of the EEF1, IMM1, Scwrl4 hydrogen
+ *  bond and EZ potential interactions against central finite
+ *  differences of the energy without switching function, on
+ *  random geometries.  The energy returned with the gradient must
+ *  be the same as the one without, and the fused form used by the
+ *  minimizer (getEnergyAndAddGradient) must give the same gradient
+ ******************************************************************/
+
+#include <iostream>
+#include <cmath>
+
+#include "CharmmEEF1Interaction.h"
+#include "CharmmIMM1Interaction.h"
+#include "Scwrl4HBondInteraction.h"
+#include "EZpotentialInteraction.h"
+#include "CartesianGeometry.h"
+#include "RandomNumberGenerator.h"
+
+using namespace std;
+
+using namespace MSL;
+
+RandomNumberGenerator rng;
+
+CartesianPoint randomShift(double _size) {
+	return CartesianPoint(rng.getRandomDouble(-_size, _size), rng.getRandomDouble(-_size, _size), rng.getRandomDouble(-_size, _size));
+}
+
+// largest relative error of the gradient against the finite differences, -1 if the energy or the fused gradient differ
+double checkGradient(Interaction & _interaction, vector<Atom*> & _atoms) {
+	vector<double> gradient;
+	double energy = _interaction.getEnergy(&gradient);
+	double reference = _interaction.getEnergy((vector<double>*)NULL);
+	if (gradient.size() != 3 * _atoms.size() || fabs(energy - reference) > 1.0e-12 * (1.0 + fabs(reference))) {
+		cout << _interaction.getName() << ": the energy with the gradient " << energy << " differs from " << reference << endl;
+		return -1.0;
+	}
+
+	// the fused form, with the minimization index of the atoms
+	vector<double> fused(3 * _atoms.size(), 0.0);
+	vector<double> workspace;
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		_atoms[i]->setMinimizationIndex(i + 1);
+	}
+	double fusedEnergy = _interaction.getEnergyAndAddGradient(&fused[0], workspace);
+	for (unsigned int i=0; i<fused.size(); i++) {
+		if (fabs(fused[i] - gradient[i]) > 1.0e-12 * (1.0 + fabs(gradient[i])) || fabs(fusedEnergy - energy) > 1.0e-12 * (1.0 + fabs(energy))) {
+			cout << _interaction.getName() << ": the fused gradient differs" << endl;
+			return -1.0;
+		}
+	}
+
+	double h = 1.0e-6;
+	double maxError = 0.0;
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		for (unsigned int c=0; c<3; c++) {
+			CartesianPoint saved = _atoms[i]->getCoor();
+			CartesianPoint shift(c == 0 ? h : 0.0, c == 1 ? h : 0.0, c == 2 ? h : 0.0);
+			_atoms[i]->setCoor(saved + shift);
+			double plus = _interaction.getEnergy((vector<double>*)NULL);
+			_atoms[i]->setCoor(saved - shift);
+			double minus = _interaction.getEnergy((vector<double>*)NULL);
+			_atoms[i]->setCoor(saved);
+			if ((plus == 0.0) != (minus == 0.0) || (plus == 0.0) != (energy == 0.0)) {
+				// on the edge of the range of the function, where it is not differentiable
+				continue;
+			}
+			double numerical = (plus - minus) / (2.0 * h);
+			maxError = max(maxError, fabs(numerical - gradient[3*i+c]) / (1.0 + fabs(numerical)));
+		}
+	}
+	return maxError;
+}
+
+bool report(string _name, double _maxError, unsigned int _nonZero, unsigned int _samples) {
+	cout << _name << ": largest relative error " << _maxError << " over " << _samples << " geometries (" << _nonZero << " with non zero energy)" << endl;
+	if (_maxError < 0.0 || _maxError > 1.0e-5 || _nonZero < _samples / 4) {
+		cout << _name << ": the gradient differs from the finite differences" << endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+
+	rng.setSeed(747);
+	bool result = true;
+	unsigned int samples = 500;
+
+	Atom a1("A,1,ALA,CB", CartesianPoint(0.0, 0.0, 0.0));
+	Atom a2("A,2,LEU,CD1", CartesianPoint(0.0, 0.0, 0.0));
+	vector<Atom*> pair;
+	pair.push_back(&a1);
+	pair.push_back(&a2);
+
+	// EEF1
+	CharmmEEF1Interaction eef1(a1, a2, 14.7, -0.645, 3.5, 2.06, 21.4, 0.67, 3.5, 2.1);
+	double maxError = 0.0;
+	unsigned int nonZero = 0;
+	for (unsigned int n=0; n<samples; n++) {
+		a1.setCoor(randomShift(5.0));
+		a2.setCoor(randomShift(5.0));
+		double error = checkGradient(eef1, pair);
+		maxError = error < 0.0 || maxError < 0.0 ? -1.0 : max(maxError, error);
+		nonZero += eef1.getEnergy() != 0.0;
+	}
+	result = report("CHARMM_EEF1", maxError, nonZero, samples) && result;
+
+	// IMM1, water and chex parameters, the atoms anywhere across the membrane
+	vector<double> water;
+	water.push_back(14.7); water.push_back(-0.645); water.push_back(3.5); water.push_back(2.06);
+	water.push_back(21.4); water.push_back(0.67); water.push_back(3.5); water.push_back(2.1);
+	vector<double> chex;
+	chex.push_back(14.7); chex.push_back(0.02); chex.push_back(3.5); chex.push_back(2.06);
+	chex.push_back(21.4); chex.push_back(1.27); chex.push_back(3.5); chex.push_back(2.1);
+	CharmmIMM1Interaction imm1(a1, a2, water, chex, 13.5, 10.0);
+	maxError = 0.0;
+	nonZero = 0;
+	for (unsigned int n=0; n<samples; n++) {
+		a1.setCoor(randomShift(5.0) + CartesianPoint(0.0, 0.0, rng.getRandomDouble(-20.0, 20.0)));
+		a2.setCoor(a1.getCoor() + randomShift(4.0));
+		double error = checkGradient(imm1, pair);
+		maxError = error < 0.0 || maxError < 0.0 ? -1.0 : max(maxError, error);
+		nonZero += imm1.getEnergy() != 0.0;
+	}
+	result = report("CHARMM_IMM1", maxError, nonZero, samples) && result;
+
+	// Scwrl4 hydrogen bond, backbone parameters, around an ideal N-H...O=C
+	Atom h("A,1,ALA,HN", CartesianPoint(0.0, 0.0, 0.0));
+	Atom d("A,1,ALA,N", CartesianPoint(0.0, 0.0, 0.0));
+	Atom o("A,5,ALA,O", CartesianPoint(0.0, 0.0, 0.0));
+	Atom c("A,5,ALA,C", CartesianPoint(0.0, 0.0, 0.0));
+	Atom ca("A,5,ALA,CA", CartesianPoint(0.0, 0.0, 0.0));
+	h.setCharge(0.31);
+	o.setCharge(-0.51);
+	vector<Atom*> hbondAtoms;
+	hbondAtoms.push_back(&h);
+	hbondAtoms.push_back(&d);
+	hbondAtoms.push_back(&o);
+	hbondAtoms.push_back(&c);
+	hbondAtoms.push_back(&ca);
+	double deg = M_PI / 180.0;
+	Scwrl4HBondInteraction hbond(h, d, o, c, ca, 1.0, 120.0 * deg, 0.0, 180.0 * deg, 2.08, 0.67, 35.0, 37.0 * deg, 49.0 * deg);
+	maxError = 0.0;
+	nonZero = 0;
+	for (unsigned int n=0; n<samples; n++) {
+		o.setCoor(randomShift(0.2));
+		c.setCoor(CartesianPoint(-1.23, 0.0, 0.0) + randomShift(0.2));
+		ca.setCoor(CartesianPoint(-1.9, 1.2, 0.0) + randomShift(0.2));
+		CartesianPoint electron = (CartesianGeometry::buildRadians(o.getCoor(), c.getCoor(), ca.getCoor(), 1.0, 120.0 * deg, (n % 2) * 180.0 * deg) - o.getCoor()).getUnit();
+		h.setCoor(o.getCoor() + electron * 2.0 + randomShift(0.3));
+		d.setCoor(h.getCoor() + electron * 1.0 + randomShift(0.3));
+		double error = checkGradient(hbond, hbondAtoms);
+		maxError = error < 0.0 || maxError < 0.0 ? -1.0 : max(maxError, error);
+		nonZero += hbond.getEnergy() != 0.0;
+	}
+	result = report("SCWRL4_HBOND", maxError, nonZero, samples) && result;
+
+	// EZ potential, sigmoidal and gaussian
+	vector<Atom*> single(1, &a1);
+	vector<double> sigmoidal;
+	sigmoidal.push_back(1.27); sigmoidal.push_back(10.16); sigmoidal.push_back(4.0);
+	vector<double> gaussian;
+	gaussian.push_back(2.5); gaussian.push_back(13.5); gaussian.push_back(-0.6);
+	EZpotentialInteraction ez1(a1, sigmoidal, true);
+	EZpotentialInteraction ez2(a1, gaussian, false);
+	double maxError2 = 0.0;
+	maxError = 0.0;
+	nonZero = 0;
+	for (unsigned int n=0; n<samples; n++) {
+		a1.setCoor(randomShift(30.0));
+		double error = checkGradient(ez1, single);
+		maxError = error < 0.0 || maxError < 0.0 ? -1.0 : max(maxError, error);
+		error = checkGradient(ez2, single);
+		maxError2 = error < 0.0 || maxError2 < 0.0 ? -1.0 : max(maxError2, error);
+		nonZero += ez1.getEnergy() != 0.0;
+	}
+	result = report("EZ_POTENTIAL sigmoidal", maxError, nonZero, samples) && result;
+	result = report("EZ_POTENTIAL gaussian", maxError2, nonZero, samples) && result;
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,110 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests GSLMinimizer with and without the neighbor list.  The list
+ *  is off by default.  Without it the energy without the switching
+ *  function is minimized and the list is never built.  With it the
+ *  switched energy is minimized, the list is built at least once
+ *  and the last energy agrees with calcEnergy() on all interactions
+ ******************************************************************/
+
+#include <iostream>
+#include <cmath>
+
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "GSLMinimizer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+int main() {
+
+	bool result = true;
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+	PolymerSequence seq("A: ARG ASN LYS ILE ASP CYS GLU GLN LEU PHE SER THR");
+	CSB.buildSystem(seq);
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAllAtoms();
+	// all pairs within 30 A get an interaction, switched off between 5 and 7 A
+	CSB.updateNonBonded(5.0, 7.0, 30.0);
+
+	EnergySet * pESet = sys.getEnergySet();
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	atoms.saveCoor("start");
+
+	// without the neighbor list (the default)
+	GSLMinimizer minimizer(sys);
+	minimizer.setMinimizeAlgorithm(GSLMinimizer::STEEPEST_DESCENT);
+	minimizer.setMaxIterations(100);
+	if (minimizer.getUseNeighborList()) {
+		cout << "The neighbor list is used by default" << endl;
+		result = false;
+	}
+	unsigned int builds = pESet->getNumberOfNeighborListBuilds();
+	double before = pESet->calcEnergyWithoutSwitchingFunction();
+	minimizer.minimize();
+	double after = pESet->calcEnergyWithoutSwitchingFunction();
+	cout << "Without the neighbor list: energy without switching " << before << " => " << after << ", " << minimizer.getNumberOfNeighborListBuilds() << " list builds" << endl;
+	if (after >= before || minimizer.getNumberOfNeighborListBuilds() != 0 || pESet->getNumberOfNeighborListBuilds() != builds) {
+		cout << "The minimization without the neighbor list failed or built the list" << endl;
+		result = false;
+	}
+
+	// with the neighbor list, from the same start
+	atoms.applySavedCoor("start");
+	minimizer.setUseNeighborList(true);
+	before = pESet->calcEnergy();
+	minimizer.minimize();
+	after = pESet->calcEnergy();
+	double listEnergy = pESet->calcSwitchedEnergyAndEnergyGradient((double*)NULL);
+	cout << "With the neighbor list: switched energy " << before << " => " << after << " (" << listEnergy << " with the list), " << minimizer.getNumberOfNeighborListBuilds() << " list builds" << endl;
+	if (after >= before || minimizer.getNumberOfNeighborListBuilds() == 0) {
+		cout << "The minimization with the neighbor list failed or did not build the list" << endl;
+		result = false;
+	}
+	if (fabs(listEnergy - after) > 1.0e-8 * (1.0 + fabs(after))) {
+		cout << "The energy with the neighbor list differs from calcEnergy() after the minimization" << endl;
+		result = false;
+	}
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
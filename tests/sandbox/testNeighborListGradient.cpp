@@ -0,0 +1,176 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests EnergySet::calcSwitchedEnergyAndEnergyGradient, used by
+ *  the minimizer: the energy must be the same as calcEnergy() with
+ *  the non bonded cutoffs, and the gradient must agree with the
+ *  finite differences of calcEnergy(), including the pairs in the
+ *  switching region.  The Verlet list must not be rebuilt after
+ *  small moves, and must be rebuilt after a large one.  It reports
+ *  the time against the gradient without the switching function
+ ******************************************************************/
+
+#include <iostream>
+#include <cmath>
+
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "RandomNumberGenerator.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+int main() {
+
+	bool result = true;
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+	PolymerSequence seq("A: ARG ASN LYS ILE ASP CYS GLU GLN LEU PHE SER THR TRP ARG GLU ALA LEU MET TYR SER LEU ARG GLU PHE");
+	CSB.buildSystem(seq);
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAllAtoms();
+	// all pairs within 30 A get an interaction, switched off between 5 and 7 A
+	CSB.updateNonBonded(5.0, 7.0, 30.0);
+
+	EnergySet * pESet = sys.getEnergySet();
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		atoms[i]->setMinimizationIndex(i+1);
+	}
+
+	// the energy
+	vector<double> gradient(3 * atoms.size(), 0.0);
+	double reference = pESet->calcEnergy();
+	double energy = pESet->calcSwitchedEnergyAndEnergyGradient(&gradient[0]);
+	double energyOnly = pESet->calcSwitchedEnergyAndEnergyGradient((double*)NULL);
+	cout << "Energy " << reference << ", with the neighbor list " << energy << " (" << pESet->getTotalNumberOfInteractions("CHARMM_VDW") << " vdw interactions, " << pESet->getTotalNumberOfInteractionsCalculated() << " within the cutoffs)" << endl;
+	if (fabs(energy - reference) > 1.0e-8 * (1.0 + fabs(reference)) || fabs(energyOnly - reference) > 1.0e-8 * (1.0 + fabs(reference))) {
+		cout << "The energy with the neighbor list differs from calcEnergy()" << endl;
+		result = false;
+	}
+
+	// the gradient against the finite differences of the switched energy
+	// (the dihedrals of the ideal chain are planar, where their derivative is not defined, the term is left out)
+	pESet->setTermActive("CHARMM_DIHE", false);
+	gradient.assign(gradient.size(), 0.0);
+	pESet->calcSwitchedEnergyAndEnergyGradient(&gradient[0]);
+	vector<double> unswitched(3 * atoms.size(), 0.0);
+	pESet->calcEnergyAndEnergyGradient(&unswitched[0]);
+	double h = 1.0e-5;
+	double maxError = 0.0;
+	double maxUnswitchedError = 0.0;
+	for (unsigned int i=0; i<atoms.size(); i+=3) {
+		CartesianPoint coor = atoms[i]->getCoor();
+		for (unsigned int j=0; j<3; j++) {
+			CartesianPoint shift(0.0, 0.0, 0.0);
+			shift[j] = h;
+			atoms[i]->setCoor(coor + shift);
+			double plus = pESet->calcEnergy();
+			atoms[i]->setCoor(coor - shift);
+			double minus = pESet->calcEnergy();
+			atoms[i]->setCoor(coor);
+			double numerical = (plus - minus) / (2.0 * h);
+			double error = fabs(gradient[3*i+j] - numerical) / (1.0 + fabs(numerical));
+			if (error > maxError) {
+				maxError = error;
+			}
+			error = fabs(unswitched[3*i+j] - numerical) / (1.0 + fabs(numerical));
+			if (error > maxUnswitchedError) {
+				maxUnswitchedError = error;
+			}
+		}
+	}
+	cout << "Largest relative error of the gradient: switched " << maxError << ", without the switching function " << maxUnswitchedError << endl;
+	if (maxError > 1.0e-4) {
+		cout << "The switched gradient differs from the finite differences" << endl;
+		result = false;
+	}
+
+	pESet->setTermActive("CHARMM_DIHE", true);
+
+	// small moves do not rebuild the list (skin 2 A, no atom moves more than 1 A)
+	unsigned int builds = pESet->getNumberOfNeighborListBuilds();
+	RandomNumberGenerator rng;
+	rng.setSeed(11);
+	for (unsigned int n=0; n<5; n++) {
+		for (unsigned int i=0; i<atoms.size(); i++) {
+			atoms[i]->setCoor(atoms[i]->getCoor() + CartesianPoint(rng.getRandomDouble(-0.1, 0.1), rng.getRandomDouble(-0.1, 0.1), rng.getRandomDouble(-0.1, 0.1)));
+		}
+		reference = pESet->calcEnergy();
+		energy = pESet->calcSwitchedEnergyAndEnergyGradient(&gradient[0]);
+		if (fabs(energy - reference) > 1.0e-8 * (1.0 + fabs(reference))) {
+			cout << "The energy with the neighbor list differs from calcEnergy() after a move" << endl;
+			result = false;
+		}
+	}
+	cout << "Builds after 5 small moves: " << pESet->getNumberOfNeighborListBuilds() - builds << endl;
+	if (pESet->getNumberOfNeighborListBuilds() != builds) {
+		cout << "The neighbor list was rebuilt after small moves" << endl;
+		result = false;
+	}
+
+	// a large move does
+	atoms[0]->setCoor(atoms[0]->getCoor() + CartesianPoint(1.5, 0.0, 0.0));
+	reference = pESet->calcEnergy();
+	energy = pESet->calcSwitchedEnergyAndEnergyGradient(&gradient[0]);
+	cout << "Builds after a large move: " << pESet->getNumberOfNeighborListBuilds() - builds << endl;
+	if (pESet->getNumberOfNeighborListBuilds() != builds + 1 || fabs(energy - reference) > 1.0e-8 * (1.0 + fabs(reference))) {
+		cout << "The neighbor list was not rebuilt after a large move" << endl;
+		result = false;
+	}
+
+	// the time of an energy and gradient evaluation
+	unsigned int cycles = 50;
+	Timer timer;
+	double start = timer.getWallTime();
+	for (unsigned int n=0; n<cycles; n++) {
+		pESet->calcSwitchedEnergyAndEnergyGradient(&gradient[0]);
+	}
+	double switchedTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	for (unsigned int n=0; n<cycles; n++) {
+		pESet->calcEnergyAndEnergyGradient(&unswitched[0]);
+	}
+	double fullTime = timer.getWallTime() - start;
+	cout << cycles << " evaluations: neighbor list " << switchedTime << " s, all interactions without switching " << fullTime << " s" << endl;
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
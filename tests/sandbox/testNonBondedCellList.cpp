@@ -0,0 +1,188 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the cell-list neighbor search of
+ *  CharmmSystemBuilder::updateNonBonded with cutoffs: the
+ *  CHARMM_VDW and CHARMM_ELEC pairs (in order) are compared with
+ *  a reference all-pairs search based on the boxes that contain
+ *  all the alternative conformations of each atom.  The system has
+ *  alternative identities, alternative conformations and atoms
+ *  without coordinates.  The build is repeated with 3 threads.
+ ******************************************************************/
+
+#include <iostream>
+
+#include "System.h"
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+vector<pair<Atom*, Atom*> > getPairs(System & _sys, string _term);
+vector<pair<Atom*, Atom*> > getReferencePairs(AtomPointerVector & _atoms, double _cutnb);
+
+int main() {
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+	CSB.setBuildNonBondedInteractions(false);
+	CSB.setUseGroupCutoffs(false);
+
+	string residues[10] = {"ALA", "ILE", "GLU", "LEU", "LYS", "PHE", "SER", "ARG", "TRP", "ASP"};
+	string seqString = "A:";
+	unsigned int nRes = 60;
+	for (unsigned int i=0; i<nRes; i++) {
+		seqString += " " + residues[i % 10];
+	}
+	PolymerSequence seq(seqString);
+	CSB.buildSystem(seq);
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAtoms();
+
+	// alternative identities
+	for (unsigned int p=3; p<nRes; p+=7) {
+		vector<string> ids;
+		ids.push_back("LEU");
+		ids.push_back("PHE");
+		CSB.addIdentity("A," + MslTools::intToString(p), ids);
+	}
+	sys.buildAtoms();
+
+	// alternative conformations and atoms without coordinates
+	AtomPointerVector & atoms = sys.getAllAtomPointers();
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		if (atoms[i]->getResidueNumber() % 5 == 0 && atoms[i]->hasCoor()) {
+			CartesianPoint c = atoms[i]->getCoor();
+			for (unsigned int k=1; k<4; k++) {
+				atoms[i]->addAltConformation(c + CartesianPoint(0.9*k, -1.3*k, 0.4*k));
+			}
+		}
+		if (i % 97 == 0) {
+			atoms[i]->wipeCoordinates();
+		}
+	}
+	cout << "System with " << atoms.size() << " atoms" << endl;
+
+	bool result = true;
+	double cutnb = 8.0;
+	// all the atom types have VDW parameters, the VDW and ELEC terms have the same pairs
+	vector<pair<Atom*, Atom*> > reference = getReferencePairs(atoms, cutnb);
+
+	Timer timer;
+	for (unsigned int threads=1; threads<=3; threads+=2) {
+		CSB.setNumberOfThreads(threads);
+		double start = timer.getWallTime();
+		CSB.updateNonBonded(6.0, 7.0, cutnb);
+		double time = timer.getWallTime() - start;
+		vector<pair<Atom*, Atom*> > vdw = getPairs(sys, "CHARMM_VDW");
+		vector<pair<Atom*, Atom*> > elec = getPairs(sys, "CHARMM_ELEC");
+		cout << threads << " thread(s): " << vdw.size() << " VDW pairs, " << elec.size() << " ELEC pairs (reference " << reference.size() << "), built in " << time << " s";
+		if (vdw == reference && elec == reference) {
+			cout << " OK" << endl;
+		} else {
+			cout << " NOT OK" << endl;
+			result = false;
+		}
+	}
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
+
+vector<pair<Atom*, Atom*> > getPairs(System & _sys, string _term) {
+	vector<pair<Atom*, Atom*> > out;
+	map<string, vector<Interaction*> > * terms = _sys.getEnergySet()->getEnergyTerms();
+	if (terms->find(_term) == terms->end()) {
+		return out;
+	}
+	vector<Interaction*> & interactions = (*terms)[_term];
+	for (unsigned int i=0; i<interactions.size(); i++) {
+		out.push_back(pair<Atom*, Atom*>(interactions[i]->getAtom(0), interactions[i]->getAtom(1)));
+	}
+	return out;
+}
+
+vector<pair<Atom*, Atom*> > getReferencePairs(AtomPointerVector & _atoms, double _cutnb) {
+	// boxes around all the alternative conformations, padded by half cutoff
+	vector<vector<double> > boxes(_atoms.size(), vector<double>(6, 0.0));
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		unsigned int ac = _atoms[i]->getActiveConformation();
+		for (unsigned int c=0; c<_atoms[i]->getNumberOfAltConformations(); c++) {
+			_atoms[i]->setActiveConformation(c);
+			CartesianPoint & a = _atoms[i]->getCoor();
+			for (unsigned int d=0; d<3; d++) {
+				if (c == 0 || a[d] < boxes[i][2*d]) {
+					boxes[i][2*d] = a[d];
+				}
+				if (c == 0 || a[d] > boxes[i][2*d+1]) {
+					boxes[i][2*d+1] = a[d];
+				}
+			}
+		}
+		_atoms[i]->setActiveConformation(ac);
+		for (unsigned int d=0; d<3; d++) {
+			boxes[i][2*d] -= _cutnb/2;
+			boxes[i][2*d+1] += _cutnb/2;
+		}
+	}
+
+	vector<pair<Atom*, Atom*> > out;
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		if (!_atoms[i]->hasCoor()) {
+			continue;
+		}
+		for (unsigned int j=i+1; j<_atoms.size(); j++) {
+			if (!_atoms[j]->hasCoor() || _atoms[i]->isInAlternativeIdentity(_atoms[j])) {
+				continue;
+			}
+			bool overlap = true;
+			for (unsigned int d=0; d<3; d++) {
+				if (boxes[i][2*d+1] < boxes[j][2*d] || boxes[j][2*d+1] < boxes[i][2*d]) {
+					overlap = false;
+				}
+			}
+			if (!overlap || _atoms[i]->isBoundTo(_atoms[j]) || _atoms[i]->isOneThree(_atoms[j])) {
+				continue;
+			}
+			out.push_back(pair<Atom*, Atom*>(_atoms[i], _atoms[j]));
+		}
+	}
+	return out;
+}
@@ -0,0 +1,215 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+
+/******************************************************************
+ *  Tests the lazy hits and the cache of source structures of
+ *  PDBFragments.  The source PDBs are rewritten with the CB atoms
+ *  renamed, so the name of the CBs in a hit tells when its source
+ *  was read: after the search (lazy materialization), from the
+ *  cache (until the least recently used is dropped) or again for
+ *  every hit without a cache.  A hit whose source cannot be
+ *  opened is not counted
+ ******************************************************************/
+
+#include <iostream>
+
+#include "testData.h"
+#include "PDBFragments.h"
+
+using namespace std;
+
+using namespace MSL;
+
+string sourceDir = "/tmp/testPDBFragmentsCache";
+
+// the CA atoms of the test structures, with the file name as segID (as createFragmentDatabase)
+void writeFragmentDatabase(string _file, const vector<string> & _segIDs) {
+	AtomPointerVector db;
+	for (unsigned int i=0; i<_segIDs.size(); i++) {
+		System sys;
+		sys.readPdb("/tmp/" + _segIDs[i] + ".pdb");
+		for (unsigned int a=0; a<sys.atomSize(); a++) {
+			if (sys.getAtom(a).getName() == "CA") {
+				Atom * pAtom = new Atom(sys.getAtom(a));
+				pAtom->setSegID(_segIDs[i]);
+				db.push_back(pAtom);
+			}
+		}
+	}
+	db.setName("ca-only");
+	db.save_checkpoint(_file);
+	db.deletePointers();
+}
+
+// a copy of the test PDB in the source directory with the CB atoms renamed
+void writeSource(string _segID, string _cbName) {
+	ifstream in(("/tmp/" + _segID + ".pdb").c_str());
+	ofstream out((sourceDir + "/" + _segID + ".pdb").c_str());
+	string line;
+	while (getline(in, line)) {
+		if (line.substr(0, 4) == "ATOM" && line.size() > 16 && line.substr(12, 4) == " CB ") {
+			line.replace(12, 4, " " + _cbName + " ");
+		}
+		out << line << endl;
+	}
+}
+
+void writeSources(const vector<string> & _segIDs, string _cbName) {
+	for (unsigned int i=0; i<_segIDs.size(); i++) {
+		writeSource(_segIDs[i], _cbName);
+	}
+}
+
+// the name of the CB atoms of a hit
+string cbName(AtomContainer * _pAtoms) {
+	if (_pAtoms == NULL) {
+		return "NULL";
+	}
+	for (unsigned int i=0; i<_pAtoms->size(); i++) {
+		string name = (*_pAtoms)[i].getName();
+		if (name.size() == 2 && name[0] == 'C' && name != "CA") {
+			return name;
+		}
+	}
+	return "none";
+}
+
+// materializes the next hit of a source, whose CBs are expected to be named _expected
+bool checkNextHit(PDBFragments & _frags, map<string, unsigned int> & _next, string _segID, string _expected, string _step) {
+	unsigned int & n = _next[_segID];
+	while (n < _frags.getNumberOfHits() && _frags.getHitCAtrace(n)(0).getSegID() != _segID) {
+		n++;
+	}
+	if (n >= _frags.getNumberOfHits()) {
+		cout << _step << ": no hit left from " << _segID << endl;
+		return false;
+	}
+	string name = cbName(_frags.getHitAtoms(n));
+	n++;
+	cout << _step << ": hit from " << _segID << " has " << name << " (expected " << _expected << ")" << endl;
+	return name == _expected;
+}
+
+int main() {
+
+	bool result = true;
+
+	writePdbFile();
+	vector<string> segIDs;
+	segIDs.push_back("xtalLattice");
+	segIDs.push_back("symmetricTrimer");
+	segIDs.push_back("pdbDimer");
+	string dbFile = "/tmp/testPDBFragmentsCache.fragdb";
+	writeFragmentDatabase(dbFile, segIDs);
+	MslTools::mkNestedDir(sourceDir, 0755);
+	writeSources(segIDs, "CB");
+
+	System query;
+	query.readPdb("/tmp/xtalLattice.pdb");
+	string start = "A,10";
+	string end = "A,13";
+
+	PDBFragments frags(dbFile);
+	frags.loadFragmentDatabase();
+	frags.setIncludeFullFile(true);
+
+	// without pdbDir all the hits are counted
+	int allHits = frags.searchForMatchingFragmentsLinear(query, start, end, "", 3.0);
+	map<string, int> hitsBySource;
+	for (unsigned int n=0; n<frags.getNumberOfHits(); n++) {
+		hitsBySource[frags.getHitCAtrace(n)(0).getSegID()]++;
+	}
+	for (unsigned int i=0; i<segIDs.size(); i++) {
+		cout << hitsBySource[segIDs[i]] << " hits from " << segIDs[i] << endl;
+		if (hitsBySource[segIDs[i]] < 4) {
+			cout << "Not enough hits from " << segIDs[i] << " for the test" << endl;
+			result = false;
+		}
+	}
+
+	// the sources are only read when a hit is materialized, after the search
+	frags.setPdbDir(sourceDir);
+	frags.setSourceCacheSize(2);
+	int found = frags.searchForMatchingFragmentsLinear(query, start, end, "", 3.0);
+	if (found != allHits || frags.getNumberOfHits() != allHits) {
+		cout << found << " hits with all the sources in pdbDir instead of " << allHits << endl;
+		result = false;
+	}
+	writeSources(segIDs, "C1");
+	map<string, unsigned int> next;
+	result = checkNextHit(frags, next, "xtalLattice", "C1", "lazy read") && result;
+	result = checkNextHit(frags, next, "symmetricTrimer", "C1", "lazy read") && result;
+
+	// LRU: xtalLattice is used again, so the trimer is the one dropped when the dimer is read
+	writeSources(segIDs, "C2");
+	result = checkNextHit(frags, next, "xtalLattice", "C1", "cached") && result;
+	result = checkNextHit(frags, next, "pdbDimer", "C2", "read, drops the trimer") && result;
+
+	// the cache is kept by the next search
+	found = frags.searchForMatchingFragmentsLinear(query, start, end, "", 3.0);
+	next.clear();
+	result = checkNextHit(frags, next, "pdbDimer", "C2", "cached after a new search") && result;
+	result = checkNextHit(frags, next, "xtalLattice", "C1", "cached after a new search") && result;
+	result = checkNextHit(frags, next, "symmetricTrimer", "C2", "read again, drops the dimer") && result;
+	writeSources(segIDs, "C3");
+	result = checkNextHit(frags, next, "xtalLattice", "C1", "cached") && result;
+	result = checkNextHit(frags, next, "pdbDimer", "C3", "read again") && result;
+
+	// without a cache every hit reads its source, even the same one twice in a row
+	frags.setSourceCacheSize(0);
+	writeSources(segIDs, "C4");
+	result = checkNextHit(frags, next, "xtalLattice", "C4", "no cache") && result;
+	writeSource("xtalLattice", "C5");
+	result = checkNextHit(frags, next, "xtalLattice", "C5", "no cache") && result;
+
+	// the hits whose source cannot be opened are not counted
+	remove((sourceDir + "/pdbDimer.pdb").c_str());
+	frags.setPdbDir(sourceDir);
+	found = frags.searchForMatchingFragmentsLinear(query, start, end, "", 3.0);
+	int expected = allHits - hitsBySource["pdbDimer"];
+	cout << found << " hits without the dimer source (expected " << expected << ")" << endl;
+	if (found != expected || frags.getNumberOfHits() != expected) {
+		result = false;
+	}
+	for (unsigned int n=0; n<frags.getNumberOfHits(); n++) {
+		if (frags.getHitCAtrace(n)(0).getSegID() == "pdbDimer" || frags.getHitAtoms(n) == NULL) {
+			cout << "Hit " << n << " has no source" << endl;
+			result = false;
+			break;
+		}
+	}
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,193 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+
+/******************************************************************
+ *  Tests the indexed fragment search of PDBFragments against a
+ *  plain linear scan of the fragment database (superimpose every
+ *  window that does not change segID or chain).  Both must give the
+ *  same hits, in the same (database) order and with the same RMSD,
+ *  with one or more threads.  A search by spots runs first: it
+ *  must not move the database atoms read by the index
+ ******************************************************************/
+
+#include <iostream>
+#include <cmath>
+
+#include "testData.h"
+#include "PDBFragments.h"
+#include "Transforms.h"
+
+using namespace std;
+
+using namespace MSL;
+
+struct Hit {
+	string segID;
+	string chain;
+	int resnum;
+	double rmsd;
+};
+
+// the CA atoms of the test structures, with the file name as segID (as createFragmentDatabase)
+void writeFragmentDatabase(string _file) {
+	vector<string> pdbs;
+	pdbs.push_back("/tmp/xtalLattice.pdb");
+	pdbs.push_back("/tmp/symmetricTrimer.pdb");
+	pdbs.push_back("/tmp/pdbDimer.pdb");
+	AtomPointerVector db;
+	for (unsigned int i=0; i<pdbs.size(); i++) {
+		System sys;
+		sys.readPdb(pdbs[i]);
+		for (unsigned int a=0; a<sys.atomSize(); a++) {
+			if (sys.getAtom(a).getName() == "CA") {
+				Atom * pAtom = new Atom(sys.getAtom(a));
+				pAtom->setSegID(MslTools::getFileName(pdbs[i]));
+				db.push_back(pAtom);
+			}
+		}
+	}
+	db.setName("ca-only");
+	db.save_checkpoint(_file);
+	db.deletePointers();
+}
+
+// every window of the database superimposed onto the query
+vector<Hit> linearScan(AtomPointerVector & _db, AtomPointerVector & _query, double _rmsdTol) {
+	vector<Hit> hits;
+	unsigned int span = _query.size() - 1;
+	Transforms tm;
+	for (unsigned int i=0; i+span<_db.size(); i++) {
+		if (_db(i).getSegID() != _db(i+span).getSegID() || _db(i).getChainId() != _db(i+span).getChainId()) {
+			continue;
+		}
+		AtomPointerVector window;
+		for (unsigned int j=0; j<=span; j++) {
+			window.push_back(new Atom(_db(i+j)));
+		}
+		bool aligned = tm.rmsdAlignment(window, _query);
+		double rmsd = window.rmsd(_query);
+		window.deletePointers();
+		if (aligned && rmsd <= _rmsdTol) {
+			Hit hit;
+			hit.segID = _db(i).getSegID();
+			hit.chain = _db(i).getChainId();
+			hit.resnum = _db(i).getResidueNumber();
+			hit.rmsd = rmsd;
+			hits.push_back(hit);
+		}
+	}
+	return hits;
+}
+
+bool sameHits(PDBFragments & _frags, const vector<Hit> & _expected) {
+	if (_frags.getNumberOfHits() != _expected.size()) {
+		cout << "    " << _frags.getNumberOfHits() << " hits instead of " << _expected.size() << endl;
+		return false;
+	}
+	for (unsigned int n=0; n<_expected.size(); n++) {
+		Atom & first = _frags.getHitCAtrace(n)(0);
+		if (first.getSegID() != _expected[n].segID || first.getChainId() != _expected[n].chain || first.getResidueNumber() != _expected[n].resnum || fabs(_frags.getHitRMSD(n) - _expected[n].rmsd) > 1.0e-5) {
+			cout << "    hit " << n << " is " << first.getSegID() << " " << first.getChainId() << " " << first.getResidueNumber() << " (" << _frags.getHitRMSD(n) << "), expected " << _expected[n].segID << " " << _expected[n].chain << " " << _expected[n].resnum << " (" << _expected[n].rmsd << ")" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() {
+
+	bool result = true;
+
+	writePdbFile();
+	string dbFile = "/tmp/testPDBFragmentsIndex.fragdb";
+	writeFragmentDatabase(dbFile);
+
+	AtomPointerVector db;
+	db.load_checkpoint(dbFile);
+
+	PDBFragments frags(dbFile);
+	frags.loadFragmentDatabase();
+
+	System query;
+	query.readPdb("/tmp/xtalLattice.pdb");
+
+	// the spots search superimposes the stems of the candidates
+	vector<string> spots;
+	spots.push_back("A,10");
+	spots.push_back("A,14");
+	spots.push_back("A,18");
+	int spotHits = frags.searchForMatchingFragmentsSpots(query, spots, 6, 1.0);
+	cout << spotHits << " hits by spots" << endl;
+
+	// queries of several lengths, the tolerances go from a few hits to most of the windows
+	vector<string> start;
+	vector<string> end;
+	start.push_back("A,10"); end.push_back("A,13");
+	start.push_back("B,20"); end.push_back("B,26");
+	start.push_back("C,40"); end.push_back("C,51");
+	start.push_back("A,60"); end.push_back("A,79");
+	vector<double> tolerances;
+	tolerances.push_back(0.25);
+	tolerances.push_back(1.0);
+	tolerances.push_back(3.0);
+
+	unsigned int totalHits = 0;
+	for (unsigned int q=0; q<start.size(); q++) {
+		AtomPointerVector queryCA;
+		for (unsigned int i=query.getPositionIndex(start[q]); i<=query.getPositionIndex(end[q]); i++) {
+			queryCA.push_back(&query.getPosition(i).getAtom("CA"));
+		}
+		for (unsigned int t=0; t<tolerances.size(); t++) {
+			vector<Hit> expected = linearScan(db, queryCA, tolerances[t]);
+			totalHits += expected.size();
+			for (unsigned int threads=1; threads<=3; threads+=2) {
+				frags.setNumberOfThreads(threads);
+				int found = frags.searchForMatchingFragmentsLinear(query, start[q], end[q], "", tolerances[t]);
+				cout << start[q] << "-" << end[q] << " tolerance " << tolerances[t] << ", " << threads << " thread(s): " << found << " indexed hits, " << expected.size() << " linear hits" << endl;
+				if (found != (int)expected.size() || !sameHits(frags, expected)) {
+					cout << "The indexed search differs from the linear scan" << endl;
+					result = false;
+				}
+			}
+		}
+	}
+	if (totalHits == 0) {
+		cout << "No hits, the test is not meaningful" << endl;
+		result = false;
+	}
+	db.deletePointers();
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,302 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the PDBReader against a reference reader that follows
+ *  the original line by line algorithm (getline, PDBFormat string
+ *  parser, one Atom at a time): same atoms, fields, bounding box
+ *  and crystal records, from a file, from a string, from a gzipped
+ *  file (when compiled with MSL_ZLIB=T), and model by model with
+ *  the streaming callback.  The reading throughput of the two
+ *  readers on a large multi-model file is reported
+ ******************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <iomanip>
+
+#include "PDBReader.h"
+#include "CRDReader.h"
+#include "Timer.h"
+#include "testData.h"
+
+#ifdef __ZLIB__
+#include <zlib.h>
+#endif
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+// the original reading loop, on a file
+void referenceRead(string _file, AtomPointerVector & _atoms, map<string, double> & _bounds) {
+	ifstream in(_file.c_str());
+	string line;
+	while (getline(in, line)) {
+		if (line.size() < 6) {
+			continue;
+		}
+		string header = line.substr(0, 6);
+		if (header != "ATOM  " && header != "HETATM") {
+			continue;
+		}
+		PDBFormat::AtomData atom = PDBFormat::parseAtomLine(line);
+		Atom * pAtom = new Atom;
+		pAtom->setName(atom.D_ATOM_NAME);
+		pAtom->setResidueName(atom.D_RES_NAME);
+		pAtom->setResidueIcode(atom.D_I_CODE);
+		pAtom->setResidueNumber(atom.D_RES_SEQ);
+		pAtom->setChainId(!strcmp(atom.D_CHAIN_ID, "") ? atom.D_SEG_ID : atom.D_CHAIN_ID);
+		pAtom->setCoor(atom.D_X, atom.D_Y, atom.D_Z);
+		pAtom->setElement(atom.D_ELEMENT_SYMBOL);
+		pAtom->setTempFactor(atom.D_TEMP_FACT);
+		pAtom->setSegID(atom.D_SEG_ID);
+		_atoms.push_back(pAtom);
+		if (atom.D_X < _bounds["minX"]) _bounds["minX"] = atom.D_X;
+		if (atom.D_X > _bounds["maxX"]) _bounds["maxX"] = atom.D_X;
+		if (atom.D_Y < _bounds["minY"]) _bounds["minY"] = atom.D_Y;
+		if (atom.D_Y > _bounds["maxY"]) _bounds["maxY"] = atom.D_Y;
+		if (atom.D_Z < _bounds["minZ"]) _bounds["minZ"] = atom.D_Z;
+		if (atom.D_Z > _bounds["maxZ"]) _bounds["maxZ"] = atom.D_Z;
+	}
+}
+
+bool sameAtoms(AtomPointerVector & _atoms1, AtomPointerVector & _atoms2, unsigned int _offset=0) {
+	if (_atoms2.size() < _offset + _atoms1.size()) {
+		cerr << "Too few atoms: " << _atoms2.size() << " for " << _offset + _atoms1.size() << endl;
+		return false;
+	}
+	for (unsigned int i=0; i<_atoms1.size(); i++) {
+		Atom & a = *_atoms1[i];
+		Atom & b = *_atoms2[_offset + i];
+		if (a.getName() != b.getName() || a.getResidueName() != b.getResidueName() || a.getResidueNumber() != b.getResidueNumber() || a.getResidueIcode() != b.getResidueIcode() || a.getChainId() != b.getChainId() || a.getSegID() != b.getSegID() || a.getElement() != b.getElement() || a.getTempFactor() != b.getTempFactor() || a.getX() != b.getX() || a.getY() != b.getY() || a.getZ() != b.getZ()) {
+			cerr << "Different atoms " << i << ": " << a << " / " << b << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool sameBounds(map<string, double> & _bounds1, map<string, double> & _bounds2) {
+	string keys[6] = {"minX", "maxX", "minY", "maxY", "minZ", "maxZ"};
+	for (unsigned int i=0; i<6; i++) {
+		if (_bounds1[keys[i]] != _bounds2[keys[i]]) {
+			cerr << "Different bounding coordinate " << keys[i] << ": " << _bounds1[keys[i]] << " " << _bounds2[keys[i]] << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+void deleteAtoms(AtomPointerVector & _atoms) {
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		delete _atoms[i];
+	}
+	_atoms.clear();
+}
+
+// the streaming callback compares each model with the reference atoms of one model
+struct StreamCheck {
+	AtomPointerVector * pReference;
+	unsigned int models;
+	unsigned int atoms;
+	bool result;
+};
+
+bool checkModel(AtomPointerVector & _atoms, unsigned int _model, void * _data) {
+	StreamCheck * pCheck = (StreamCheck *)_data;
+	pCheck->models++;
+	pCheck->atoms += _atoms.size();
+	if (_model != pCheck->models || _atoms.size() != pCheck->pReference->size() || !sameAtoms(_atoms, *pCheck->pReference)) {
+		cerr << "Wrong model " << _model << endl;
+		pCheck->result = false;
+	}
+	return true;
+}
+
+bool stopAtThree(AtomPointerVector & _atoms, unsigned int _model, void * _data) {
+	(*(unsigned int *)_data)++;
+	return _model < 3;
+}
+
+int main() {
+
+	bool result = true;
+
+	string example = SYSENV.getEnv("MSL_DIR") + "/exampleFiles/example0002.pdb";
+
+	// the example file
+	AtomPointerVector refAtoms;
+	map<string, double> refBounds;
+	referenceRead(example, refAtoms, refBounds);
+	PDBReader pin(example);
+	pin.open();
+	pin.read();
+	pin.close();
+	if (pin.getAtomPointers().size() != refAtoms.size() || !sameAtoms(refAtoms, pin.getAtomPointers()) || !sameBounds(refBounds, pin.getBoundingCoordinates())) {
+		cerr << "The example file is read differently" << endl;
+		result = false;
+	}
+
+	// from a string, with crystal records
+	string file3DVH = "/tmp/testPDBReaderFast_3DVH.pdb";
+	ofstream out3DVH(file3DVH.c_str());
+	out3DVH << xtalLatticeTest3DVH;
+	out3DVH.close();
+	AtomPointerVector ref3DVH;
+	map<string, double> refBounds3DVH;
+	referenceRead(file3DVH, ref3DVH, refBounds3DVH);
+	PDBReader pin3DVH;
+	pin3DVH.read(xtalLatticeTest3DVH);
+	if (pin3DVH.getAtomPointers().size() != ref3DVH.size() || !sameAtoms(ref3DVH, pin3DVH.getAtomPointers()) || !sameBounds(refBounds3DVH, pin3DVH.getBoundingCoordinates())) {
+		cerr << "The crystal structure string is read differently" << endl;
+		result = false;
+	}
+	if (pin3DVH.getSymmetryRotations().size() != 4 || pin3DVH.getUnitCellParameters().size() != 6) {
+		cerr << "Wrong crystal records: " << pin3DVH.getSymmetryRotations().size() << " symmetry operations, " << pin3DVH.getUnitCellParameters().size() << " unit cell parameters" << endl;
+		result = false;
+	}
+	deleteAtoms(ref3DVH);
+	remove(file3DVH.c_str());
+
+	// a large multi-model file
+	unsigned int numberOfModels = 200;
+	string bigFile = "/tmp/testPDBReaderFast.pdb";
+	ifstream exampleIn(example.c_str());
+	vector<string> atomLines;
+	string line;
+	while (getline(exampleIn, line)) {
+		if (line.substr(0, 6) == "ATOM  " || line.substr(0, 6) == "HETATM") {
+			atomLines.push_back(line);
+		}
+	}
+	exampleIn.close();
+	ofstream bigOut(bigFile.c_str());
+	for (unsigned int m=1; m<=numberOfModels; m++) {
+		bigOut << "MODEL     " << setw(4) << m << endl;
+		for (unsigned int i=0; i<atomLines.size(); i++) {
+			bigOut << atomLines[i] << endl;
+		}
+		bigOut << "ENDMDL" << endl;
+	}
+	bigOut.close();
+
+	Timer timer;
+	double start = timer.getWallTime();
+	AtomPointerVector refBig;
+	map<string, double> refBoundsBig;
+	referenceRead(bigFile, refBig, refBoundsBig);
+	double referenceTime = timer.getWallTime() - start;
+
+	start = timer.getWallTime();
+	PDBReader pinBig(bigFile);
+	pinBig.open();
+	pinBig.read();
+	pinBig.close();
+	double readerTime = timer.getWallTime() - start;
+	if (pinBig.getAtomPointers().size() != refBig.size() || !sameAtoms(refBig, pinBig.getAtomPointers()) || !sameBounds(refBoundsBig, pinBig.getBoundingCoordinates()) || pinBig.getNumberOfModels() != numberOfModels) {
+		cerr << "The multi-model file is read differently" << endl;
+		result = false;
+	}
+	cout << "Time to read " << refBig.size() << " atoms: " << referenceTime << " s with the line by line reader, " << readerTime << " s with the PDBReader" << endl;
+
+	// model by model
+	StreamCheck check;
+	check.pReference = &refAtoms;
+	check.models = 0;
+	check.atoms = 0;
+	check.result = true;
+	PDBReader pinStream(bigFile);
+	pinStream.open();
+	pinStream.readModels(checkModel, &check);
+	pinStream.close();
+	if (!check.result || check.models != numberOfModels || check.atoms != refBig.size() || pinStream.getAtomPointers().size() != 0) {
+		cerr << "Wrong streaming: " << check.models << " models, " << check.atoms << " atoms" << endl;
+		result = false;
+	}
+	unsigned int calls = 0;
+	PDBReader pinStop(bigFile);
+	pinStop.open();
+	pinStop.readModels(stopAtThree, &calls);
+	pinStop.close();
+	if (calls != 3) {
+		cerr << "The streaming did not stop after 3 models: " << calls << endl;
+		result = false;
+	}
+
+#ifdef __ZLIB__
+	// gzipped
+	string gzName = bigFile + ".gz";
+	gzFile gz = gzopen(gzName.c_str(), "wb");
+	ifstream bigIn(bigFile.c_str());
+	while (getline(bigIn, line)) {
+		line += "\n";
+		gzwrite(gz, line.c_str(), line.size());
+	}
+	bigIn.close();
+	gzclose(gz);
+	start = timer.getWallTime();
+	PDBReader pinGz(gzName);
+	pinGz.open();
+	pinGz.read();
+	pinGz.close();
+	double gzTime = timer.getWallTime() - start;
+	if (pinGz.getAtomPointers().size() != refBig.size() || !sameAtoms(refBig, pinGz.getAtomPointers())) {
+		cerr << "The gzipped file is read differently" << endl;
+		result = false;
+	}
+	cout << "Time to read the gzipped file: " << gzTime << " s" << endl;
+	remove(gzName.c_str());
+#else
+	cout << "Compiled without zlib, gzipped files not tested" << endl;
+#endif
+
+	// CRD files go through the same buffer
+	CRDReader crdIn;
+	crdIn.read(testCrdFile);
+	if (crdIn.getAtomPointers().size() == 0) {
+		cerr << "The CRD string was not read" << endl;
+		result = false;
+	}
+
+	deleteAtoms(refAtoms);
+	deleteAtoms(refBig);
+	remove(bigFile.c_str());
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,149 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Compares the packed non bonded energies (CHARMM_VDW and
+ *  CHARMM_ELEC, see PackedNonBondedEnergy.h) with the regular
+ *  EnergySet calculation and times the two on a CHARMM system.
+ *
+ *  The system is a 200 residue protein built from the internal
+ *  coordinates, or a PDB in CHARMM format given as argument:
+ *     testPackedNonBonded [file.pdb]
+ ******************************************************************/
+
+#include <iostream>
+#include <iomanip>
+
+#include "System.h"
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+bool compareTerms(System & _sys, unsigned int _repeats);
+
+int main(int argc, char *argv[]) {
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+
+	if (argc > 1) {
+		if (!CSB.buildSystemFromPDB((string)argv[1])) {
+			cerr << "Cannot build the system from " << argv[1] << endl;
+			exit(1);
+		}
+	} else {
+		string residues[10] = {"ALA", "ILE", "GLU", "LEU", "LYS", "PHE", "SER", "ARG", "TRP", "ASP"};
+		string seqString = "A:";
+		for (unsigned int i=0; i<200; i++) {
+			seqString += " " + residues[i % 10];
+		}
+		PolymerSequence seq(seqString);
+		CSB.buildSystem(seq);
+		sys.seed("A 1 C", "A 1 CA", "A 1 N");
+		sys.buildAtoms();
+	}
+	cout << "System with " << sys.atomSize() << " atoms" << endl;
+
+	bool result = true;
+
+	cout << "=====================================================" << endl;
+	cout << "No cutoffs" << endl;
+	if (!compareTerms(sys, 20)) {
+		result = false;
+	}
+
+	cout << "=====================================================" << endl;
+	cout << "Cutoffs 9.0 10.0 11.0" << endl;
+	CSB.updateNonBonded(9.0, 10.0, 11.0);
+	if (!compareTerms(sys, 20)) {
+		result = false;
+	}
+
+	cout << "=====================================================" << endl;
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
+
+bool compareTerms(System & _sys, unsigned int _repeats) {
+
+	EnergySet * pESet = _sys.getEnergySet();
+	string terms[2] = {"CHARMM_VDW", "CHARMM_ELEC"};
+	Timer timer;
+
+	pESet->setUsePackedNonBonded(false);
+	double start = timer.getWallTime();
+	for (unsigned int i=0; i<_repeats; i++) {
+		_sys.calcEnergy();
+	}
+	double regularTime = (timer.getWallTime() - start) / _repeats;
+	double regularE[2];
+	unsigned int regularN[2];
+	for (unsigned int i=0; i<2; i++) {
+		regularE[i] = pESet->getTermEnergy(terms[i]);
+		regularN[i] = pESet->getTermNumberOfInteractionsCalculated(terms[i]);
+	}
+	double regularTotal = pESet->getTotalEnergy();
+
+	pESet->setUsePackedNonBonded(true);
+	start = timer.getWallTime();
+	for (unsigned int i=0; i<_repeats; i++) {
+		_sys.calcEnergy();
+	}
+	double packedTime = (timer.getWallTime() - start) / _repeats;
+	bool out = true;
+	for (unsigned int i=0; i<2; i++) {
+		double E = pESet->getTermEnergy(terms[i]);
+		unsigned int N = pESet->getTermNumberOfInteractionsCalculated(terms[i]);
+		cout << setw(12) << terms[i] << setprecision(15) << " regular " << regularE[i] << " (" << regularN[i] << ")   packed " << E << " (" << N << ")";
+		if (E == regularE[i] && N == regularN[i]) {
+			cout << " OK" << endl;
+		} else {
+			cout << " NOT OK" << endl;
+			out = false;
+		}
+	}
+	if (pESet->getTotalEnergy() != regularTotal) {
+		cout << "Total energy differs: regular " << regularTotal << " packed " << pESet->getTotalEnergy() << endl;
+		out = false;
+	}
+	cout << "Time per calcEnergy(): regular " << regularTime << " s, packed " << packedTime << " s" << endl;
+	pESet->setUsePackedNonBonded(false);
+	return out;
+}
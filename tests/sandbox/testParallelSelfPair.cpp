@@ -0,0 +1,205 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+
+/******************************************************************
+ *  Tests the multithreaded construction of the self and pair
+ *  energy tables of the SelfPairManager: the tables (energies,
+ *  energies by term and interaction counts) built with several
+ *  threads must be identical to the ones built serially, also
+ *  when the non saved pair energies are recalculated.  The
+ *  non bonded cutoffs are on, so that the threads compute the
+ *  group distances concurrently (built with -fsanitize=thread
+ *  this test also checks for data races).  The rotamers are
+ *  created by displacing the side chain atoms.
+ ******************************************************************/
+
+#include <iostream>
+#include <iomanip>
+
+#include "System.h"
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "SelfPairManager.h"
+#include "RandomNumberGenerator.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+bool compareTables(SelfPairManager & _spm1, SelfPairManager & _spm2) {
+	EnergyTable & table1 = _spm1.getEnergyTable();
+	EnergyTable & table2 = _spm2.getEnergyTable();
+	bool same = _spm1.getFixedEnergy() == _spm2.getFixedEnergy() && table1.getNumberOfRotamers() == table2.getNumberOfRotamers();
+	for (unsigned int i=0; i<table1.getNumberOfPositions() && same; i++) {
+		for (unsigned int ir=0; ir<table1.getNumberOfRotamers(i); ir++) {
+			same = same && table1.getSelfEnergy(i, ir) == table2.getSelfEnergy(i, ir);
+			for (unsigned int j=0; j<i; j++) {
+				for (unsigned int jr=0; jr<table1.getNumberOfRotamers(j); jr++) {
+					same = same && table1.getPairEnergy(i, ir, j, jr) == table2.getPairEnergy(i, ir, j, jr);
+				}
+			}
+		}
+	}
+	if (!same) {
+		cout << "The energy tables differ" << endl;
+		return false;
+	}
+
+	// compare the energies by term and the counts through the state energies
+	vector<unsigned int> rots = _spm1.getNumberOfRotamers();
+	for (unsigned int i=0; i<rots.size(); i++) {
+		for (unsigned int r=0; r<rots[i]; r++) {
+			vector<unsigned int> state(rots.size(), 0);
+			state[i] = r;
+			if (i > 0) {
+				state[i-1] = rots[i-1] - 1;
+			}
+			if (_spm1.getStateEnergy(state, "CHARMM_VDW") != _spm2.getStateEnergy(state, "CHARMM_VDW") || _spm1.getStateInteractionCount(state) != _spm2.getStateInteractionCount(state)) {
+				cout << "The energies by term or interaction counts differ" << endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main() {
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+
+	PolymerSequence seq("A: [ALA GLY] ARG [ASN LYS] [ILE ASP] CYS GLU [GLN LEU] PHE SER [THR VAL] TRP ARG [LYS GLU] ALA LEU [MET ILE] TYR SER");
+	CSB.buildSystem(seq);
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAllAtoms();
+	CSB.updateNonBonded(9.0, 10.0, 11.0);
+
+	// create the rotamers by displacing the side chain atoms of the variable positions
+	RandomNumberGenerator rng;
+	rng.setSeed(11);
+	unsigned int nRots = 4;
+	for (unsigned int i=0; i<sys.positionSize(); i++) {
+		Position & pos = sys.getPosition(i);
+		if (pos.identitySize() == 1 && i % 4 != 1) {
+			continue;
+		}
+		for (unsigned int j=0; j<pos.identitySize(); j++) {
+			AtomPointerVector & atoms = pos.getIdentity(j).getAtomPointers();
+			for (unsigned int r=1; r<nRots; r++) {
+				for (unsigned int k=0; k<atoms.size(); k++) {
+					string name = atoms[k]->getName();
+					if (name == "N" || name == "HN" || name == "CA" || name == "HA" || name == "C" || name == "O") {
+						continue;
+					}
+					atoms[k]->addAltConformation(atoms[k]->getCoor() + CartesianPoint(rng.getRandomDouble(-0.5, 0.5), rng.getRandomDouble(-0.5, 0.5), rng.getRandomDouble(-0.5, 0.5)));
+				}
+			}
+		}
+	}
+	cout << "System with " << sys.positionSize() << " positions and " << sys.allAtomSize() << " atoms" << endl;
+
+	Timer timer;
+	double start = timer.getWallTime();
+	SelfPairManager spm1(&sys);
+	spm1.saveInteractionCounts(true);
+	spm1.saveEnergiesByTerm(true);
+	spm1.calculateEnergies();
+	double serialTime = timer.getWallTime() - start;
+	cout << "Variable positions: " << spm1.getNumberOfVariablePositions() << endl;
+
+	bool result = true;
+
+	// the legacy nested tables are copies of the energy table
+	EnergyTable & table1 = spm1.getEnergyTable();
+	const vector<vector<double> > & legacySelf = spm1.getSelfEnergy();
+	const vector<vector<vector<vector<double> > > > & legacyPair = spm1.getPairEnergy();
+	for (unsigned int i=0; i<table1.getNumberOfPositions(); i++) {
+		for (unsigned int ir=0; ir<table1.getNumberOfRotamers(i); ir++) {
+			bool same = legacySelf[i][ir] == table1.getSelfEnergy(i, ir);
+			for (unsigned int j=0; j<i; j++) {
+				for (unsigned int jr=0; jr<table1.getNumberOfRotamers(j); jr++) {
+					same = same && legacyPair[i][ir][j][jr] == table1.getPairEnergy(i, ir, j, jr);
+				}
+			}
+			if (!same) {
+				cout << "The legacy tables differ from the energy table at position " << i << " rotamer " << ir << endl;
+				result = false;
+			}
+		}
+	}
+
+	unsigned int threads[4] = {2, 3, 4, 8};
+	for (unsigned int t=0; t<4; t++) {
+		start = timer.getWallTime();
+		SelfPairManager spm2(&sys);
+		spm2.saveInteractionCounts(true);
+		spm2.saveEnergiesByTerm(true);
+		spm2.setNumberOfThreads(threads[t]);
+		spm2.calculateEnergies();
+		cout << "Tables built in " << timer.getWallTime() - start << " s with " << threads[t] << " threads, " << serialTime << " s serially" << endl;
+		if (!compareTables(spm1, spm2)) {
+			cout << "Tables built with " << threads[t] << " threads differ from the serial ones" << endl;
+			result = false;
+		}
+
+		// recalculate the pair energies that are not flagged as saved
+		vector<vector<vector<vector<bool> > > > saved;
+		EnergyTable & table = spm1.getEnergyTable();
+		for (unsigned int i=0; i<table.getNumberOfPositions(); i++) {
+			saved.push_back(vector<vector<vector<bool> > >());
+			for (unsigned int j=0; j<table.getNumberOfRotamers(i); j++) {
+				saved.back().push_back(vector<vector<bool> >());
+				for (unsigned int k=0; k<i; k++) {
+					saved.back().back().push_back(vector<bool>(table.getNumberOfRotamers(k), false));
+					for (unsigned int l=0; l<table.getNumberOfRotamers(k); l++) {
+						saved.back().back().back()[l] = (i + j + k + l) % 2 == 0;
+					}
+				}
+			}
+		}
+		spm1.recalculateNonSavedEnergies(saved);
+		spm2.recalculateNonSavedEnergies(saved);
+		if (!compareTables(spm1, spm2)) {
+			cout << "Recalculated tables with " << threads[t] << " threads differ from the serial ones" << endl;
+			result = false;
+		}
+	}
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
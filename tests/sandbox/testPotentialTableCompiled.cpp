@@ -0,0 +1,269 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the compiled (integer keyed, dense) knowledge based
+ *  tables: the TwoBodyDistanceDependentPotentialTable energies must
+ *  be identical to the ones computed with string keys on the
+ *  std::map, the bins must be the same as the linear search
+ *  (including distances on the bin boundaries) and the
+ *  ResiduePairTable values must be the same as in its std::map.
+ *  It reports the time of the pair energies of a peptide with and
+ *  without the compiled table
+ ******************************************************************/
+
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+
+#include "TwoBodyDistanceDependentPotentialTable.h"
+#include "ResiduePairTable.h"
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "Transforms.h"
+#include "RandomNumberGenerator.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+bool isBackbone(string _name) {
+	return (_name == "N") || (_name == "C") || (_name == "CA") || (_name == "O");
+}
+
+int linearBin(const vector<pair<double, double> > & _bins, double _dist) {
+	for (unsigned int i=0; i<_bins.size(); i++) {
+		if (_dist >= _bins[i].first && _dist <= _bins[i].second) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// the energy as it was computed with the string keys, one per atom pair
+double referenceEnergy(TwoBodyDistanceDependentPotentialTable & _tbd, const vector<pair<double, double> > & _bins, AtomPointerVector &_a, AtomPointerVector &_b, bool _sameSet, bool _countLocalSCBB) {
+	double energies = 0.;
+	for (int i = (_a.size() - 1); i >= 0; i--){
+		int startJ = 0;
+		if (_sameSet){
+			startJ = i+1;
+		}
+		if (_a(i).getName().substr(0,1) == "H") { continue; }
+		for (int j = (_b.size() - 1); j >= startJ; j--){
+			if (_b(j).getName().substr(0,1) == "H") { continue; }
+			else if ((_a(i).getChainId() == _b(j).getChainId()) && isBackbone(_a(i).getName()) && isBackbone(_b(j).getName()) && (abs(_a(i).getResidueNumber() - _b(j).getResidueNumber()) <= 7)) {}
+			else if ((!_countLocalSCBB) && (_a(i).getChainId() == _b(j).getChainId()) && (abs(_a(i).getResidueNumber() - _b(j).getResidueNumber()) <= 7)) {}
+			else if ((_a(i).getChainId() == _b(j).getChainId()) && (_a(i).getResidueNumber() == _b(j).getResidueNumber())) {}
+			else {
+				double kb = 0;
+				double dist = _a(i).distance(_b(j));
+				if (dist < _tbd.getMinDistCutoff()) {
+					kb = _tbd.getValueBelowCutoff();
+				}
+				else if (dist > _tbd.getMaxDistCutoff()) { kb = _tbd.getValueAboveCutoff(); }
+				else {
+					stringstream key;
+					key << _a(i).getResidueName() << "_" << _a(i).getName() << ":" << _b(j).getResidueName() << "_" << _b(j).getName() << ":" << linearBin(_bins, dist);
+					kb = _tbd.PotentialTable::getPotential(key.str());
+				}
+				energies += kb;
+			}
+		}
+	}
+	return energies;
+}
+
+int main() {
+
+	bool result = true;
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+	PolymerSequence seq("A: ARG ASN LYS ILE ASP CYS GLU GLN LEU PHE SER THR TRP ARG GLU ALA LEU MET TYR SER LEU ARG GLU PHE VAL ILE LYS SER GLN ASP LEU ARG TYR MET GLU VAL ASN PHE TRP LYS");
+	CSB.buildSystem(seq);
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAllAtoms();
+	// a helix, so that the residues more than 7 apart are within the cutoff
+	Transforms tm;
+	for (unsigned int i=2; i<sys.positionSize(); i++) {
+		Residue & prev = sys.getResidue(i-2);
+		Residue & res = sys.getResidue(i-1);
+		Residue & next = sys.getResidue(i);
+		tm.setDihedral(prev("C"), res("N"), res("CA"), res("C"), -57.0);
+		tm.setDihedral(res("N"), res("CA"), res("C"), next("N"), -47.0);
+	}
+	AtomPointerVector & atoms = sys.getAtomPointers();
+
+	// the heavy atom classes of the system, one in ten is missing from the table
+	vector<string> classes;
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		if (atoms[i]->getName().substr(0,1) == "H") {
+			continue;
+		}
+		string name = atoms[i]->getResidueName() + "_" + atoms[i]->getName();
+		if (find(classes.begin(), classes.end(), name) == classes.end()) {
+			classes.push_back(name);
+		}
+	}
+
+	// uniform bins, and contiguous bins of different widths
+	vector<vector<pair<double, double> > > binSets(2);
+	for (unsigned int i=0; i<26; i++) {
+		binSets[0].push_back(pair<double, double>(2.0 + 0.5 * i, 2.5 + 0.5 * i));
+	}
+	double edges[] = {2.0, 3.0, 3.25, 4.0, 4.1, 6.0, 7.5, 9.0, 12.0, 15.0};
+	for (unsigned int i=0; i<9; i++) {
+		binSets[1].push_back(pair<double, double>(edges[i], edges[i+1]));
+	}
+
+	RandomNumberGenerator rng;
+	rng.setSeed(77);
+	for (unsigned int s=0; s<binSets.size(); s++) {
+		TwoBodyDistanceDependentPotentialTable tbd;
+		tbd.setMinDistCutoffAndValue(2.0, 100.0);
+		tbd.setMaxDistCutoffAndValue(15.0, 0.0);
+		for (unsigned int i=0; i<binSets[s].size(); i++) {
+			tbd.addBin(binSets[s][i].first, binSets[s][i].second);
+		}
+		for (unsigned int i=0; i<classes.size(); i++) {
+			for (unsigned int j=0; j<classes.size(); j++) {
+				if ((i * classes.size() + j) % 10 == 3) {
+					continue;
+				}
+				for (unsigned int b=0; b<binSets[s].size(); b++) {
+					tbd.addPotential(classes[i], classes[j], b, rng.getRandomDouble(-1.0, 1.0));
+				}
+			}
+		}
+
+		// the bins, on random distances and on the boundaries
+		unsigned int binErrors = 0;
+		for (unsigned int n=0; n<100000; n++) {
+			double dist = rng.getRandomDouble(0.0, 17.0);
+			if (n % 10 == 0) {
+				dist = binSets[s][rng.getRandomInt(binSets[s].size() - 1)].second;
+			}
+			if (tbd.getBin(dist) != linearBin(binSets[s], dist)) {
+				binErrors++;
+			}
+		}
+
+		// the energies between all the residues with the std::map, through the public pair energy
+		// (its last argument reaches calculatePairwiseNonBondedEnergy as _sameSet)
+		Timer timer;
+		double start = timer.getWallTime();
+		double mapEnergy = 0.0;
+		for (unsigned int i=0; i<sys.positionSize(); i++) {
+			for (unsigned int j=i+1; j<sys.positionSize(); j++) {
+				mapEnergy += tbd.calculatePairEnergy(sys, i, 0, j, 0, false);
+			}
+		}
+		double mapTime = timer.getWallTime() - start;
+
+		tbd.compilePotentialTable();
+		start = timer.getWallTime();
+		double compiledEnergy = 0.0;
+		for (unsigned int i=0; i<sys.positionSize(); i++) {
+			for (unsigned int j=i+1; j<sys.positionSize(); j++) {
+				compiledEnergy += tbd.calculatePairEnergy(sys, i, 0, j, 0, false);
+			}
+		}
+		double compiledTime = timer.getWallTime() - start;
+
+		// each residue pair, without and with the _sameSet flag
+		double reference = 0.0;
+		unsigned int pairErrors = 0;
+		unsigned int pairs = 0;
+		for (unsigned int i=0; i<sys.positionSize(); i++) {
+			for (unsigned int j=i+1; j<sys.positionSize(); j++) {
+				AtomPointerVector & atoms1 = sys.getPosition(i).getAtomPointers();
+				AtomPointerVector & atoms2 = sys.getPosition(j).getAtomPointers();
+				double pairReference = referenceEnergy(tbd, binSets[s], atoms1, atoms2, false, false);
+				reference += pairReference;
+				if (tbd.calculatePairEnergy(sys, i, 0, j, 0, false) != pairReference) {
+					pairErrors++;
+				}
+				if (tbd.calculatePairEnergy(sys, i, 0, j, 0, true) != referenceEnergy(tbd, binSets[s], atoms1, atoms2, true, false)) {
+					pairErrors++;
+				}
+				pairs++;
+			}
+		}
+
+		cout << "Bin set " << s << ": " << classes.size() << " classes, " << binSets[s].size() << " bins, energy " << reference << ", with the map " << mapEnergy << " (" << mapTime << " s), compiled " << compiledEnergy << " (" << compiledTime << " s)" << endl;
+		cout << "Bin set " << s << ": " << binErrors << " different bins, " << pairErrors << " of " << pairs << " residue pairs different" << endl;
+		if (mapEnergy != reference || compiledEnergy != reference || binErrors != 0 || pairErrors != 0) {
+			cout << "The compiled table differs from the std::map" << endl;
+			result = false;
+		}
+	}
+
+	// the residue pair table
+	string residues[] = {"ALA", "ARG", "ASN", "ASP", "CYS", "GLN", "GLU", "GLY", "HIS", "ILE", "LEU", "LYS", "MET", "PHE", "PRO", "SER", "THR", "TRP", "TYR", "VAL"};
+	ResiduePairTable rpt;
+	for (unsigned int i=0; i<20; i++) {
+		for (unsigned int j=0; j<20; j++) {
+			if ((i + j) % 7 != 0) {
+				rpt.addResiduePair(residues[i], residues[j], rng.getRandomDouble(-1.0, 1.0));
+			}
+		}
+	}
+	ResiduePairTable copied(rpt);
+	map<string, double> pairTable = rpt.getPairTable();
+	unsigned int residueErrors = 0;
+	for (unsigned int i=0; i<21; i++) {
+		for (unsigned int j=0; j<21; j++) {
+			string res1 = i < 20 ? residues[i] : "XXX";
+			string res2 = j < 20 ? residues[j] : "XXX";
+			double expected = MslTools::doubleMax;
+			if (pairTable.find(res1 + ":" + res2) != pairTable.end()) {
+				expected = pairTable[res1 + ":" + res2];
+			}
+			if (rpt.getValue(res1, res2) != expected || copied.getValue(res1, res2) != expected) {
+				residueErrors++;
+			}
+		}
+	}
+	cout << "Residue pair table: " << residueErrors << " different values" << endl;
+	if (residueErrors != 0) {
+		result = false;
+	}
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
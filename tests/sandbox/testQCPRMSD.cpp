@@ -0,0 +1,252 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the QCP RMSD of the OptimalRMSDCalculator (qcpRMSD,
+ *  oneVsMany and the tiled manyVsMany, with double and float
+ *  coordinates and more threads) against the Kabsch bestRMSD on
+ *  an ensemble of perturbed and randomly moved CA traces (the
+ *  Kabsch eigenvalues lose some precision on coordinates this far
+ *  from the origin, the tolerance is 1e-4).  The rotation of
+ *  qcpRMSD must superimpose the structures with the RMSD that
+ *  qcpRMSD returns.  It reports the time of the QCP and Kabsch
+ *  paths
+ ******************************************************************/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+#include "OptimalRMSDCalculator.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+double uniform() {
+	return (double)rand() / RAND_MAX;
+}
+
+// a helix-like CA trace, perturbed by up to _noise on each coordinate, rotated and translated at random
+void makeStructure(unsigned int _nAtoms, double _noise, vector<double> & _coor) {
+	double q[4];
+	double norm = 0.0;
+	for (unsigned int k=0; k<4; k++) {
+		q[k] = uniform() - 0.5;
+		norm += q[k] * q[k];
+	}
+	norm = sqrt(norm);
+	for (unsigned int k=0; k<4; k++) {
+		q[k] /= norm;
+	}
+	double R[3][3] = {
+		{q[0]*q[0]+q[1]*q[1]-q[2]*q[2]-q[3]*q[3], 2*(q[1]*q[2]-q[0]*q[3]), 2*(q[1]*q[3]+q[0]*q[2])},
+		{2*(q[1]*q[2]+q[0]*q[3]), q[0]*q[0]-q[1]*q[1]+q[2]*q[2]-q[3]*q[3], 2*(q[2]*q[3]-q[0]*q[1])},
+		{2*(q[1]*q[3]-q[0]*q[2]), 2*(q[2]*q[3]+q[0]*q[1]), q[0]*q[0]-q[1]*q[1]-q[2]*q[2]+q[3]*q[3]}};
+	double shift[3] = {20.0 * uniform(), 20.0 * uniform(), 20.0 * uniform()};
+	for (unsigned int i=0; i<_nAtoms; i++) {
+		double p[3];
+		p[0] = 2.3 * cos(i * 1.745) + _noise * (uniform() - 0.5);
+		p[1] = 2.3 * sin(i * 1.745) + _noise * (uniform() - 0.5);
+		p[2] = 1.5 * i + _noise * (uniform() - 0.5);
+		for (unsigned int k=0; k<3; k++) {
+			_coor.push_back(R[k][0] * p[0] + R[k][1] * p[1] + R[k][2] * p[2] + shift[k]);
+		}
+	}
+}
+
+void makeAtoms(const vector<double> & _coor, unsigned int _first, unsigned int _nAtoms, AtomPointerVector & _atoms) {
+	for (unsigned int i=0; i<_nAtoms; i++) {
+		const double * p = &_coor[3 * (_first + i)];
+		_atoms.push_back(new Atom("A,1,CA", p[0], p[1], p[2], "C"));
+	}
+}
+
+int main() {
+
+	bool result = true;
+	Timer timer;
+	srand(271828);
+
+	const unsigned int nAtoms = 120;
+	const unsigned int nStructures = 20000;
+	const unsigned int nAllPairs = 800;
+
+	vector<double> coor;
+	for (unsigned int s=0; s<nStructures; s++) {
+		makeStructure(nAtoms, 4.0, coor);
+	}
+	vector<float> coorFloat(coor.begin(), coor.end());
+	vector<AtomPointerVector> atoms(nStructures);
+	for (unsigned int s=0; s<nStructures; s++) {
+		makeAtoms(coor, s * nAtoms, nAtoms, atoms[s]);
+	}
+
+	OptimalRMSDCalculator calc;
+
+	// single pairs against Kabsch, with the rotation
+	double maxDiff = 0.0;
+	double maxRotationDiff = 0.0;
+	for (unsigned int s=1; s<200; s++) {
+		double kabsch = calc.bestRMSD(atoms[s], atoms[0]);
+		double qcp = calc.qcpRMSD(atoms[s], atoms[0], true);
+		maxDiff = max(maxDiff, fabs(qcp - kabsch));
+
+		vector<vector<double> > rot = calc.lastRotation();
+		vector<double> trans = calc.lastTranslation();
+		double sum = 0.0;
+		for (unsigned int i=0; i<nAtoms; i++) {
+			double moved[3];
+			for (unsigned int k=0; k<3; k++) {
+				moved[k] = trans[k] + rot[k][0] * atoms[s][i]->getX() + rot[k][1] * atoms[s][i]->getY() + rot[k][2] * atoms[s][i]->getZ();
+			}
+			double dx = moved[0] - atoms[0][i]->getX();
+			double dy = moved[1] - atoms[0][i]->getY();
+			double dz = moved[2] - atoms[0][i]->getZ();
+			sum += dx * dx + dy * dy + dz * dz;
+		}
+		maxRotationDiff = max(maxRotationDiff, fabs(sqrt(sum / nAtoms) - qcp));
+	}
+	cout << "qcpRMSD: largest difference from Kabsch " << maxDiff << ", from the RMSD after the rotation " << maxRotationDiff << endl;
+	if (maxDiff > 1.0e-4 || maxRotationDiff > 1.0e-8) {
+		result = false;
+	}
+	if (calc.qcpRMSD(atoms[5], atoms[5]) > 1.0e-5) {
+		cout << "The RMSD of a structure on itself is " << calc.qcpRMSD(atoms[5], atoms[5]) << endl;
+		result = false;
+	}
+	double noAtoms[3] = {0.0, 0.0, 0.0};
+	if (calc.qcpRMSD(noAtoms, noAtoms, 0, true) != 999999.0) {
+		cout << "The RMSD of structures without atoms is not 999999" << endl;
+		result = false;
+	}
+
+	// one vs many
+	double start = timer.getWallTime();
+	vector<double> kabsch(nStructures);
+	for (unsigned int s=0; s<nStructures; s++) {
+		kabsch[s] = calc.bestRMSD(atoms[s], atoms[0]);
+	}
+	double kabschTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	vector<double> ref(coor.begin(), coor.begin() + 3 * nAtoms);
+	vector<double> qcp;
+	calc.oneVsMany(ref, coor, nAtoms, qcp);
+	double qcpTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	vector<float> refFloat(coorFloat.begin(), coorFloat.begin() + 3 * nAtoms);
+	vector<double> qcpFloat;
+	calc.oneVsMany(refFloat, coorFloat, nAtoms, qcpFloat);
+	double qcpFloatTime = timer.getWallTime() - start;
+	calc.setNumberOfThreads(4);
+	vector<double> qcpThreads;
+	calc.oneVsMany(ref, coor, nAtoms, qcpThreads);
+	calc.setNumberOfThreads(1);
+
+	maxDiff = 0.0;
+	double maxFloatDiff = 0.0;
+	bool sameThreads = qcp.size() == nStructures && qcpThreads == qcp;
+	for (unsigned int s=0; s<nStructures && s<qcp.size() && s<qcpFloat.size(); s++) {
+		maxDiff = max(maxDiff, fabs(qcp[s] - kabsch[s]));
+		maxFloatDiff = max(maxFloatDiff, fabs(qcpFloat[s] - kabsch[s]));
+	}
+	cout << "One vs " << nStructures << ": Kabsch " << kabschTime << " s, QCP " << qcpTime << " s, QCP (float) " << qcpFloatTime << " s" << endl;
+	cout << "   largest difference from Kabsch " << maxDiff << " (float " << maxFloatDiff << ")" << endl;
+	if (qcp.size() != nStructures || qcpFloat.size() != nStructures || maxDiff > 1.0e-4 || maxFloatDiff > 1.0e-3) {
+		result = false;
+	}
+	if (!sameThreads) {
+		cout << "The RMSD computed by 4 threads differ" << endl;
+		result = false;
+	}
+
+	// many vs many
+	start = timer.getWallTime();
+	vector<double> kabschPairs;
+	for (unsigned int i=0; i<nAllPairs; i++) {
+		for (unsigned int j=i+1; j<nAllPairs; j++) {
+			kabschPairs.push_back(calc.bestRMSD(atoms[j], atoms[i]));
+		}
+	}
+	kabschTime = timer.getWallTime() - start;
+	vector<double> ensemble(coor.begin(), coor.begin() + 3 * nAtoms * nAllPairs);
+	vector<float> ensembleFloat(coorFloat.begin(), coorFloat.begin() + 3 * nAtoms * nAllPairs);
+	start = timer.getWallTime();
+	vector<float> pairs;
+	calc.manyVsMany(ensemble, nAtoms, pairs);
+	qcpTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	vector<float> pairsFloat;
+	calc.manyVsMany(ensembleFloat, nAtoms, pairsFloat);
+	qcpFloatTime = timer.getWallTime() - start;
+	calc.setNumberOfThreads(4);
+	start = timer.getWallTime();
+	vector<float> pairsThreads;
+	calc.manyVsMany(ensemble, nAtoms, pairsThreads);
+	double threadsTime = timer.getWallTime() - start;
+	calc.setNumberOfThreads(1);
+
+	maxDiff = 0.0;
+	maxFloatDiff = 0.0;
+	unsigned int misplaced = 0;
+	unsigned int k = 0;
+	for (unsigned int i=0; i<nAllPairs; i++) {
+		for (unsigned int j=i+1; j<nAllPairs; j++) {
+			if (OptimalRMSDCalculator::condensedIndex(i, j, nAllPairs) != k) {
+				misplaced++;
+			}
+			if (k < pairs.size() && k < pairsFloat.size()) {
+				maxDiff = max(maxDiff, fabs(pairs[k] - kabschPairs[k]));
+				maxFloatDiff = max(maxFloatDiff, fabs(pairsFloat[k] - kabschPairs[k]));
+			}
+			k++;
+		}
+	}
+	cout << "All pairs of " << nAllPairs << ": Kabsch " << kabschTime << " s, QCP " << qcpTime << " s, QCP (float) " << qcpFloatTime << " s, QCP (4 threads) " << threadsTime << " s" << endl;
+	cout << "   largest difference from Kabsch " << maxDiff << " (float " << maxFloatDiff << ")" << endl;
+	if (pairs.size() != kabschPairs.size() || pairsFloat.size() != kabschPairs.size() || misplaced > 0 || maxDiff > 1.0e-4 || maxFloatDiff > 1.0e-3) {
+		result = false;
+	}
+	if (pairsThreads != pairs) {
+		cout << "The pairs computed by 4 threads differ" << endl;
+		result = false;
+	}
+
+	for (unsigned int s=0; s<nStructures; s++) {
+		atoms[s].deletePointers();
+	}
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
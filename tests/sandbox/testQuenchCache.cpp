@@ -0,0 +1,175 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the sparse surround cache and the batched sweeps of
+ *  Quench: the quench of a peptide with 1 and 2 threads must give
+ *  the same energies along the sweeps and the same final
+ *  structure.  It reports the pair energies allocated and
+ *  calculated by the cache against the size of a dense table, and
+ *  the time of the quench.  The rotamers are created by displacing
+ *  the side chain atoms.
+ ******************************************************************/
+
+#include <iostream>
+#include <sstream>
+
+#include "Quench.h"
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "RandomNumberGenerator.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+void buildSystem(System & _sys) {
+	CharmmSystemBuilder CSB(_sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+
+	PolymerSequence seq("A: [ALA GLY] ARG [ASN LYS] [ILE ASP] CYS GLU [GLN LEU] PHE SER [THR VAL] TRP ARG [LYS GLU] ALA LEU [MET ILE] TYR SER LEU ARG GLU [PHE TRP] VAL ILE LYS [SER THR] GLN ASP LEU [ARG LYS] TYR MET GLU [VAL LEU] ASN PHE");
+	CSB.buildSystem(seq);
+	_sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	_sys.buildAllAtoms();
+
+	// the same rotamers at every call
+	RandomNumberGenerator rng;
+	rng.setSeed(23);
+	unsigned int nRots = 5;
+	for (unsigned int i=0; i<_sys.positionSize(); i++) {
+		Position & pos = _sys.getPosition(i);
+		if (pos.identitySize() == 1 && i % 3 == 1) {
+			continue;
+		}
+		for (unsigned int j=0; j<pos.identitySize(); j++) {
+			AtomPointerVector & atoms = pos.getIdentity(j).getAtomPointers();
+			for (unsigned int r=1; r<nRots; r++) {
+				for (unsigned int k=0; k<atoms.size(); k++) {
+					string name = atoms[k]->getName();
+					if (name == "N" || name == "HN" || name == "CA" || name == "HA" || name == "C" || name == "O") {
+						continue;
+					}
+					atoms[k]->addAltConformation(atoms[k]->getCoor() + CartesianPoint(rng.getRandomDouble(-1.0, 1.0), rng.getRandomDouble(-1.0, 1.0), rng.getRandomDouble(-1.0, 1.0)));
+				}
+			}
+		}
+	}
+}
+
+string runQuench(unsigned int _threads, vector<CartesianPoint> & _coordinates, double & _time, size_t & _cached, size_t & _calculated) {
+	System sys;
+	buildSystem(sys);
+
+	Quench quencher;
+	quencher.setRandomSeed(4242);
+	quencher.setNumberOfThreads(_threads);
+	quencher.setUpBuiltSystem(sys);
+
+	// the quench reports the energy of each position along the sweeps
+	stringstream out;
+	streambuf * pCout = cout.rdbuf(out.rdbuf());
+	Timer timer;
+	double start = timer.getWallTime();
+	quencher.runPreSetUpQuench(sys);
+	_time = timer.getWallTime() - start;
+	cout.rdbuf(pCout);
+
+	_coordinates.clear();
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		_coordinates.push_back(atoms[i]->getCoor());
+	}
+	_cached = quencher.getNumberOfCachedPairEnergies();
+	_calculated = quencher.getNumberOfCalculatedPairEnergies();
+	return out.str();
+}
+
+int main() {
+
+	bool result = true;
+
+	vector<CartesianPoint> serialCoordinates;
+	vector<CartesianPoint> threadedCoordinates;
+	double serialTime = 0.0;
+	double threadedTime = 0.0;
+	size_t cached = 0;
+	size_t calculated = 0;
+	string serial = runQuench(1, serialCoordinates, serialTime, cached, calculated);
+	string threaded = runQuench(2, threadedCoordinates, threadedTime, cached, calculated);
+
+	// the dense table had all the rotamers of all the variable positions against each other
+	System sys;
+	buildSystem(sys);
+	size_t rotamers = 0;
+	for (unsigned int i=0; i<sys.positionSize(); i++) {
+		if (sys.getPosition(i).getTotalNumberOfRotamers() > 1) {
+			rotamers += sys.getPosition(i).getTotalNumberOfRotamers();
+		}
+	}
+
+	size_t loops = 0;
+	size_t position = serial.find("New loop:");
+	while (position != string::npos) {
+		loops++;
+		position = serial.find("New loop:", position + 1);
+	}
+	cout << "Quench of " << sys.positionSize() << " positions (" << rotamers << " rotamers), " << loops << " sweeps: 1 thread " << serialTime << " s, 2 threads " << threadedTime << " s" << endl;
+	cout << "Pair energies: dense table " << rotamers * rotamers << ", allocated " << cached << ", calculated " << calculated << endl;
+
+	if (loops == 0 || serial != threaded) {
+		cout << "The sweeps with 1 and 2 threads differ" << endl;
+		result = false;
+	}
+	if (serialCoordinates.size() == 0 || serialCoordinates.size() != threadedCoordinates.size()) {
+		cout << "The final structures differ in size" << endl;
+		result = false;
+	} else {
+		for (unsigned int i=0; i<serialCoordinates.size(); i++) {
+			if (serialCoordinates[i] != threadedCoordinates[i]) {
+				cout << "The final structures differ" << endl;
+				result = false;
+				break;
+			}
+		}
+	}
+	if (cached == 0 || cached >= rotamers * rotamers || calculated > cached) {
+		cout << "Unexpected size of the surround cache" << endl;
+		result = false;
+	}
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,217 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the fixed-size Rotation3 and RigidTransform: the
+ *  rotations of CartesianGeometry against their Matrix versions,
+ *  Transforms::rotate with a Rotation3 against the Matrix overload
+ *  and against the packed coordinate pass, the composition and
+ *  inverse of rigid transforms, and the transformation history.
+ *  It reports the time of rotating points with a Matrix and with
+ *  a Rotation3
+ ******************************************************************/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+#include "Transforms.h"
+#include "CartesianGeometry.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+double uniform() {
+	return (double)rand() / RAND_MAX;
+}
+
+CartesianPoint randomPoint() {
+	return CartesianPoint(20.0 * uniform() - 10.0, 20.0 * uniform() - 10.0, 20.0 * uniform() - 10.0);
+}
+
+double maxDifference(AtomPointerVector & _a, AtomPointerVector & _b) {
+	double out = 0.0;
+	for (unsigned int i=0; i<_a.size(); i++) {
+		out = max(out, _a[i]->distance(*_b[i]));
+	}
+	return out;
+}
+
+int main() {
+
+	bool result = true;
+	Timer timer;
+	srand(161803);
+
+	// the rotations against the Matrix versions
+	double maxDiff = 0.0;
+	for (unsigned int k=0; k<100; k++) {
+		double degrees = 360.0 * uniform() - 180.0;
+		CartesianPoint axis = randomPoint();
+		Rotation3 rot = CartesianGeometry::getRotation(degrees, axis);
+		Matrix mat = CartesianGeometry::getRotationMatrix(degrees, axis);
+		Matrix x = CartesianGeometry::getXRotationMatrix(degrees);
+		Matrix y = CartesianGeometry::getYRotationMatrix(degrees);
+		Matrix z = CartesianGeometry::getZRotationMatrix(degrees);
+		for (unsigned int i=0; i<3; i++) {
+			for (unsigned int j=0; j<3; j++) {
+				maxDiff = max(maxDiff, fabs(rot[i][j] - mat[i][j]));
+				maxDiff = max(maxDiff, fabs(CartesianGeometry::getXRotation(degrees)[i][j] - x[i][j]));
+				maxDiff = max(maxDiff, fabs(CartesianGeometry::getYRotation(degrees)[i][j] - y[i][j]));
+				maxDiff = max(maxDiff, fabs(CartesianGeometry::getZRotation(degrees)[i][j] - z[i][j]));
+			}
+		}
+		if (Rotation3(rot.toMatrix()) != rot || fabs(rot.getDeterminant() - 1.0) > 1.0e-12) {
+			result = false;
+		}
+		CartesianPoint p = randomPoint();
+		maxDiff = max(maxDiff, (rot * p).distance(p * mat));
+		maxDiff = max(maxDiff, (rot.getTranspose() * (rot * p)).distance(p));
+	}
+	cout << "Rotations: largest difference from Matrix " << maxDiff << endl;
+	if (maxDiff > 1.0e-12) {
+		result = false;
+	}
+
+	// Transforms with Rotation3, Matrix and packed coordinates
+	const unsigned int nAtoms = 2000;
+	AtomPointerVector a;
+	AtomPointerVector b;
+	AtomPointerVector c;
+	for (unsigned int i=0; i<nAtoms; i++) {
+		CartesianPoint p = randomPoint();
+		a.push_back(new Atom("A,1,CA", p, "C"));
+		b.push_back(new Atom("A,1,CA", p, "C"));
+		c.push_back(new Atom("A,1,CA", p, "C"));
+	}
+	vector<double> packed;
+	for (unsigned int i=0; i<nAtoms; i++) {
+		packed.push_back(a[i]->getX());
+		packed.push_back(a[i]->getY());
+		packed.push_back(a[i]->getZ());
+	}
+	Transforms trA;
+	Transforms trB;
+	Transforms trPacked;
+	trA.setStoreTransformHistory(true);
+	RigidTransform total;
+	for (unsigned int k=0; k<20; k++) {
+		double degrees = 360.0 * uniform() - 180.0;
+		CartesianPoint axis = randomPoint();
+		CartesianPoint center = randomPoint();
+		CartesianPoint shift = randomPoint();
+		Rotation3 rot = CartesianGeometry::getRotation(degrees, axis);
+		trA.rotate(a, rot, center);
+		trB.rotate(b, CartesianGeometry::getRotationMatrix(degrees, axis), center);
+		trPacked.rotate(&packed[0], nAtoms, rot, center);
+		trA.translate(a, shift);
+		trB.translate(b, shift);
+		trPacked.transform(packed, RigidTransform(Rotation3(), shift));
+		total = RigidTransform(Rotation3(), shift) * RigidTransform::rotationAbout(rot, center) * total;
+	}
+	double packedDiff = 0.0;
+	double totalDiff = 0.0;
+	for (unsigned int i=0; i<nAtoms; i++) {
+		CartesianPoint p(packed[3*i], packed[3*i+1], packed[3*i+2]);
+		packedDiff = max(packedDiff, p.distance(a[i]->getCoor()));
+		totalDiff = max(totalDiff, (total * c[i]->getCoor()).distance(a[i]->getCoor()));
+	}
+	double matrixDiff = maxDifference(a, b);
+	trA.applyHistory(c);
+	double historyDiff = maxDifference(a, c);
+	trA.transform(c, total.getInverse());
+	trA.transform(c, total);
+	double inverseDiff = maxDifference(a, c);
+	cout << "Transforms: Matrix " << matrixDiff << ", packed " << packedDiff << ", composed " << totalDiff << ", history " << historyDiff << ", inverse " << inverseDiff << endl;
+	if (matrixDiff > 1.0e-9 || packedDiff > 1.0e-9 || totalDiff > 1.0e-9 || historyDiff > 1.0e-9 || inverseDiff > 1.0e-9) {
+		result = false;
+	}
+	if (trA.getLastRotation() != total.getRotation() || trA.getTransformHistory().getTranslation().distance(total.getTranslation()) > 1.0e-9) {
+		cout << "The last rotation or the history is not the one applied" << endl;
+		result = false;
+	}
+
+	// time
+	const unsigned int nRepeats = 500;
+	Matrix mat = CartesianGeometry::getRotationMatrix(0.1, CartesianPoint(1.0, 2.0, 3.0));
+	Rotation3 rot = CartesianGeometry::getRotation(0.1, CartesianPoint(1.0, 2.0, 3.0));
+	CartesianPoint center(1.0, 1.0, 1.0);
+	double start = timer.getWallTime();
+	for (unsigned int k=0; k<nRepeats; k++) {
+		for (unsigned int i=0; i<nAtoms; i++) {
+			CartesianPoint & p = b[i]->getCoor();
+			p -= center;
+			p *= mat;
+			p += center;
+		}
+	}
+	double matrixTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	for (unsigned int k=0; k<nRepeats; k++) {
+		for (unsigned int i=0; i<nAtoms; i++) {
+			rot.apply(a[i]->getCoor(), center);
+		}
+	}
+	double rotationTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	for (unsigned int k=0; k<nRepeats; k++) {
+		rot.apply(&packed[0], nAtoms, center);
+	}
+	double packedTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	const unsigned int nBuilds = 200000;
+	for (unsigned int k=0; k<nBuilds; k++) {
+		mat = CartesianGeometry::getRotationMatrix(0.1 * k, CartesianPoint(1.0, 2.0, 3.0));
+	}
+	double matrixBuildTime = timer.getWallTime() - start;
+	start = timer.getWallTime();
+	for (unsigned int k=0; k<nBuilds; k++) {
+		rot = CartesianGeometry::getRotation(0.1 * k, CartesianPoint(1.0, 2.0, 3.0));
+	}
+	double rotationBuildTime = timer.getWallTime() - start;
+	cout << "Rotating " << nAtoms << " atoms " << nRepeats << " times: Matrix " << matrixTime << " s, Rotation3 " << rotationTime << " s, packed " << packedTime << " s" << endl;
+	cout << "Building " << nBuilds << " rotations: Matrix " << matrixBuildTime << " s, Rotation3 " << rotationBuildTime << " s" << endl;
+	if (maxDifference(a, b) > 1.0e-6) {
+		cout << "The timed rotations differ" << endl;
+		result = false;
+	}
+
+	a.deletePointers();
+	b.deletePointers();
+	c.deletePointers();
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
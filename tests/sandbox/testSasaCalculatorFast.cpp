@@ -0,0 +1,184 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the SasaCalculator (unit sphere template, packed points,
+ *  sorted neighbor lists) against the per atom SurfaceSphere
+ *  calculation of SasaAtom, which must give the same values.
+ *  A small system uses the all-pairs neighbor search, a large
+ *  one the Atom3DGrid.  It also checks the calculation with more
+ *  threads and the incremental calcSasa(AtomPointerVector&) after
+ *  some atoms are moved and after some radii are changed, and
+ *  reports the time
+ ******************************************************************/
+
+#include <iostream>
+
+#include "System.h"
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "SasaCalculator.h"
+#include "Transforms.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+// the SASA as calculated by SasaAtom, one SurfaceSphere per atom
+vector<double> referenceSasa(AtomPointerVector & _atoms, double _probeRadius, unsigned int _points) {
+	vector<double> sasa(_atoms.size(), 0.0);
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		SasaAtom sasaAtom(_atoms[i], _probeRadius, _points);
+		double r1 = _atoms[i]->getRadius();
+		for (unsigned int j=0; j<_atoms.size() && r1 > 0.0; j++) {
+			double r2 = _atoms[j]->getRadius();
+			if (j == i || r2 <= 0.0) {
+				continue;
+			}
+			if (_atoms[i]->distance(*_atoms[j]) < r1 + r2 + 2 * _probeRadius) {
+				sasaAtom.removeOccluded(*_atoms[j], true);
+			}
+		}
+		sasa[i] = sasaAtom.calcSasa();
+	}
+	return sasa;
+}
+
+bool compare(string _label, AtomPointerVector & _atoms, const vector<double> & _reference) {
+	unsigned int different = 0;
+	double total = 0.0;
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		total += _atoms[i]->getSasa();
+		if (_atoms[i]->getSasa() != _reference[i]) {
+			if (different < 5) {
+				cout << "   atom " << i << " " << _atoms[i]->getSasa() << " != " << _reference[i] << endl;
+			}
+			different++;
+		}
+	}
+	cout << _label << ": total SASA " << total << ", " << different << " atoms differ from the reference" << endl;
+	return different == 0;
+}
+
+int main() {
+
+	bool result = true;
+	Timer timer;
+
+	unsigned int sizes[2] = {20, 150}; // below and above DEFAULT_MIN_ATOMSIZE_FOR_ATOMGRID atoms
+	for (unsigned int s=0; s<2; s++) {
+		System sys;
+		CharmmSystemBuilder CSB(sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+		CSB.setBuildNonBondedInteractions(false);
+
+		string residues[10] = {"ALA", "ILE", "GLU", "LEU", "LYS", "PHE", "SER", "ARG", "TRP", "ASP"};
+		string seqString = "A:";
+		for (unsigned int i=0; i<sizes[s]; i++) {
+			seqString += " " + residues[i % 10];
+		}
+		PolymerSequence seq(seqString);
+		CSB.buildSystem(seq);
+		sys.seed("A 1 C", "A 1 CA", "A 1 N");
+		sys.buildAtoms();
+		// a helix, so that the atoms have neighbors on other residues
+		Transforms tm;
+		for (unsigned int i=2; i<sizes[s]; i++) {
+			Residue & prev = sys.getResidue(i-2);
+			Residue & res = sys.getResidue(i-1);
+			Residue & next = sys.getResidue(i);
+			tm.setDihedral(prev("C"), res("N"), res("CA"), res("C"), -57.0 + 3.0 * (i % 4));
+			tm.setDihedral(res("N"), res("CA"), res("C"), next("N"), -47.0);
+		}
+		AtomPointerVector & atoms = sys.getAtomPointers();
+		cout << "System with " << atoms.size() << " atoms" << endl;
+
+		SasaCalculator sasaCalculator(atoms);
+		double start = timer.getWallTime();
+		sasaCalculator.calcSasa();
+		double fastTime = timer.getWallTime() - start;
+
+		start = timer.getWallTime();
+		vector<double> reference = referenceSasa(atoms, sasaCalculator.getProbeRadius(), DEFAULT_OCCLUSION_POINTS);
+		double referenceTime = timer.getWallTime() - start;
+		cout << "Time: " << referenceTime << " s with SasaAtom, " << fastTime << " s with SasaCalculator" << endl;
+		result = compare("SasaCalculator", atoms, reference) && result;
+
+		SasaCalculator threaded(atoms);
+		threaded.setNumberOfThreads(3);
+		threaded.calcSasa();
+		result = compare("SasaCalculator with 3 threads", atoms, reference) && result;
+
+		// move the atoms of two residues and update only what changed
+		AtomPointerVector moved;
+		for (unsigned int i=0; i<atoms.size(); i++) {
+			if (atoms[i]->getResidueNumber() == 3 || atoms[i]->getResidueNumber() == (int)sizes[s] / 2) {
+				atoms[i]->setCoor(atoms[i]->getCoor() + CartesianPoint(0.7, -1.1, 0.4));
+				moved.push_back(atoms[i]);
+			}
+		}
+		start = timer.getWallTime();
+		sasaCalculator.calcSasa(moved);
+		double incrementalTime = timer.getWallTime() - start;
+		reference = referenceSasa(atoms, sasaCalculator.getProbeRadius(), DEFAULT_OCCLUSION_POINTS);
+		cout << "Time of the update after moving " << moved.size() << " atoms: " << incrementalTime << " s" << endl;
+		result = compare("SasaCalculator incremental", atoms, reference) && result;
+		double total = 0.0;
+		for (unsigned int i=0; i<atoms.size(); i++) {
+			total += reference[i];
+		}
+		if (fabs(sasaCalculator.getTotalSasa() - total) > 1.0e-6) {
+			cout << "The total SASA " << sasaCalculator.getTotalSasa() << " differs from " << total << endl;
+			result = false;
+		}
+
+		// change the radius of the atoms of a residue after addAtoms, it is
+		// used both for the atoms themselves and when they are neighbors
+		AtomPointerVector resized;
+		for (unsigned int i=0; i<atoms.size(); i++) {
+			if (atoms[i]->getResidueNumber() == 5) {
+				atoms[i]->setRadius(atoms[i]->getRadius() * 1.4);
+				resized.push_back(atoms[i]);
+			}
+		}
+		sasaCalculator.calcSasa(resized);
+		reference = referenceSasa(atoms, sasaCalculator.getProbeRadius(), DEFAULT_OCCLUSION_POINTS);
+		result = compare("SasaCalculator incremental after changing " + MslTools::intToString(resized.size()) + " radii", atoms, reference) && result;
+	}
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,167 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the integer selection ids (see Selectable.h): creates
+ *  one selection per residue (more than the number of ids kept
+ *  in the bitset, so that both storages are exercised), checks
+ *  the atom flags against the selected atoms and the energies
+ *  of residue pairs against a reference computed on the atoms
+ *  of the two selections.  Also times EnergySet::calcEnergy
+ *  with two selections.
+ ******************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <set>
+
+#include "System.h"
+#include "CharmmSystemBuilder.h"
+#include "PolymerSequence.h"
+#include "AtomSelection.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+int main() {
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, SYSENV.getEnv("MSL_CHARMM_TOP"), SYSENV.getEnv("MSL_CHARMM_PAR"));
+
+	string residues[10] = {"ALA", "ILE", "GLU", "LEU", "LYS", "PHE", "SER", "ARG", "TRP", "ASP"};
+	string seqString = "A:";
+	unsigned int nRes = 100;
+	for (unsigned int i=0; i<nRes; i++) {
+		seqString += " " + residues[i % 10];
+	}
+	PolymerSequence seq(seqString);
+	CSB.buildSystem(seq);
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAtoms();
+	cout << "System with " << sys.atomSize() << " atoms" << endl;
+
+	bool result = true;
+
+	// one selection per residue, residue 1 to 100
+	AtomSelection sel(sys.getAtomPointers());
+	vector<set<Atom*> > members(nRes+1);
+	for (unsigned int i=1; i<=nRes; i++) {
+		string name = "res" + MslTools::intToString(i);
+		AtomPointerVector & selected = sel.select(name + ", resi " + MslTools::intToString(i));
+		members[i].insert(selected.begin(), selected.end());
+	}
+
+	// the flags by name and by id must agree with the selected atoms
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	for (unsigned int i=1; i<=nRes; i++) {
+		string name = "res" + MslTools::intToString(i);
+		unsigned int id = Atom::findSelectionId(name);
+		if (id == Atom::noSelectionId || Atom::getSelectionName(id) != "RES" + MslTools::intToString(i)) {
+			cout << "Selection " << name << " not registered" << endl;
+			result = false;
+			continue;
+		}
+		for (AtomPointerVector::iterator k=atoms.begin(); k!=atoms.end(); k++) {
+			bool expected = members[i].find(*k) != members[i].end();
+			if ((*k)->getSelectionFlag(id) != expected || (*k)->getSelectionFlag(name) != expected) {
+				cout << "Atom " << (*k)->getAtomId() << " has the wrong flag for " << name << " (id " << id << ")" << endl;
+				result = false;
+			}
+		}
+	}
+	if (Atom::findSelectionId("not a selection") != Atom::noSelectionId) {
+		cout << "Unregistered selection has an id" << endl;
+		result = false;
+	}
+
+	// clear a selection stored in the bitset and one stored in the hash
+	sel.clearStoredSelection("res2");
+	sel.clearStoredSelection("res99");
+	for (AtomPointerVector::iterator k=atoms.begin(); k!=atoms.end(); k++) {
+		if ((*k)->getSelectionFlag("res2") || (*k)->getSelectionFlag("res99")) {
+			cout << "Atom " << (*k)->getAtomId() << " still flagged after clearStoredSelection" << endl;
+			result = false;
+		}
+	}
+	sel.select("res2, resi 2");
+	sel.select("res99, resi 99");
+
+	// energies between residue pairs versus a reference on the CHARMM_VDW pairs
+	EnergySet * pESet = sys.getEnergySet();
+	map<string, vector<Interaction*> > * terms = pESet->getEnergyTerms();
+	vector<Interaction*> & vdw = (*terms)["CHARMM_VDW"];
+	unsigned int pairs[4][2] = {{1, 2}, {10, 11}, {70, 71}, {98, 99}};
+	for (unsigned int p=0; p<4; p++) {
+		unsigned int r1 = pairs[p][0];
+		unsigned int r2 = pairs[p][1];
+		string name1 = "res" + MslTools::intToString(r1);
+		string name2 = "res" + MslTools::intToString(r2);
+
+		double refE = 0.0;
+		unsigned int refN = 0;
+		for (vector<Interaction*>::iterator k=vdw.begin(); k!=vdw.end(); k++) {
+			Atom * a1 = (*k)->getAtom(0);
+			Atom * a2 = (*k)->getAtom(1);
+			if ((members[r1].count(a1) && members[r2].count(a2)) || (members[r2].count(a1) && members[r1].count(a2))) {
+				refE += (*k)->getEnergy();
+				refN++;
+			}
+		}
+		sys.calcEnergy(name1, name2);
+		double E = pESet->getTermEnergy("CHARMM_VDW");
+		unsigned int N = pESet->getTermNumberOfInteractionsCalculated("CHARMM_VDW");
+		cout << setw(6) << name1 << setw(6) << name2 << setprecision(15) << " reference " << refE << " (" << refN << ")   calcEnergy " << E << " (" << N << ")";
+		if (E == refE && N == refN) {
+			cout << " OK" << endl;
+		} else {
+			cout << " NOT OK" << endl;
+			result = false;
+		}
+	}
+
+	Timer timer;
+	unsigned int repeats = 20;
+	double start = timer.getWallTime();
+	for (unsigned int i=0; i<repeats; i++) {
+		sys.calcEnergy("res10", "res11");
+	}
+	cout << "Time per calcEnergy(\"res10\", \"res11\"): " << (timer.getWallTime() - start) / repeats << " s" << endl;
+
+	if (result) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}
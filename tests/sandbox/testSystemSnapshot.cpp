@@ -0,0 +1,404 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+/******************************************************************
+ *  Tests the System snapshot: a CHARMM System with alternative
+ *  identities, alternative and hidden conformations is written and
+ *  loaded in a new System, which must have the same atoms, all the
+ *  conformations, bonds, IC table and energies, also after changing
+ *  identity and rotamer.  Writing the loaded System again gives the
+ *  same snapshot, and each energy term is the same after the round
+ *  trip.  A snapshot with a changed source file, a corrupted and a
+ *  truncated snapshot must be rejected, and Systems with linked
+ *  positions, hidden identities or IMM1 interactions must not be
+ *  written.  The time to build the System and to load it are reported
+ ******************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cmath>
+#include <set>
+
+#include "System.h"
+#include "CharmmSystemBuilder.h"
+#include "SystemSnapshotWriter.h"
+#include "SystemSnapshotReader.h"
+#include "AtomSelection.h"
+#include "Transforms.h"
+#include "Timer.h"
+
+using namespace std;
+
+using namespace MSL;
+
+#include "SysEnv.h"
+static SysEnv SYSENV;
+
+// alternative conformations of the side chain, shifted from the current one
+void addConformations(Residue & _res, unsigned int _n) {
+	AtomPointerVector & atoms = _res.getAtomPointers();
+	for (unsigned int k=1; k<=_n; k++) {
+		vector<CartesianPoint> points;
+		for (unsigned int i=0; i<atoms.size(); i++) {
+			string name = atoms[i]->getName();
+			CartesianPoint p = atoms[i]->getCoor();
+			if (name != "N" && name != "HN" && name != "CA" && name != "C" && name != "O" && name != "HA") {
+				p += CartesianPoint(0.3 * k, -0.2 * k, 0.1 * k);
+			}
+			points.push_back(p);
+		}
+		_res.addAltConformation(points);
+	}
+}
+
+void buildSystem(System & _sys, string _topFile, string _parFile) {
+	PolymerSequence seq("\
+A: ALA ARG ASN [ILE ASP] CYS GLU GLN\n\
+B: GLY HSE ILE [LEU ALA] LYS MET\n\
+C: MET PHE PRO SER THR TRP TYR VAL");
+
+	CharmmSystemBuilder CSB(_sys, _topFile, _parFile);
+	CSB.setDielectricConstant(4.0);
+	CSB.setUseRdielectric(true);
+	CSB.buildSystem(seq);
+
+	_sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	_sys.seed("B 1 C", "B 1 CA", "B 1 N");
+	_sys.seed("C 1 C", "C 1 CA", "C 1 N");
+	_sys.buildAtoms();
+
+	AtomSelection as(_sys.getAllAtomPointers());
+	Transforms tr;
+	AtomPointerVector chainB = as.select("chain B");
+	tr.translate(chainB, CartesianPoint(13, 4, 9));
+	AtomPointerVector chainC = as.select("chain C");
+	tr.translate(chainC, CartesianPoint(-5, -10, -8));
+
+	vector<string> bbAtoms;
+	bbAtoms.push_back("N");
+	bbAtoms.push_back("HN");
+	bbAtoms.push_back("CA");
+	bbAtoms.push_back("C");
+	bbAtoms.push_back("O");
+	_sys.copyCoordinatesOfAtomsInPosition(bbAtoms);
+	_sys.buildAllAtoms();
+
+	addConformations(_sys.getPosition("A,4").getIdentity("ILE"), 2);
+	addConformations(_sys.getPosition("A,4").getIdentity("ASP"), 1);
+	addConformations(_sys.getPosition("C,2").getIdentity("PHE"), 3);
+
+	// a hidden rotamer and a non default identity
+	_sys.getPosition("C,2").getIdentity(0).hideRotamerAbsIndex(2);
+	_sys.getPosition("B,4").setActiveIdentity("ALA");
+}
+
+bool sameEnergy(double _e1, double _e2) {
+	return fabs(_e1 - _e2) <= 1.0e-9 * (1.0 + fabs(_e1));
+}
+
+bool compareSystems(System & _sys1, System & _sys2) {
+	bool ok = true;
+	AtomPointerVector & atoms1 = _sys1.getAllAtomPointers();
+	AtomPointerVector & atoms2 = _sys2.getAllAtomPointers();
+	if (atoms1.size() != atoms2.size() || _sys1.atomSize() != _sys2.atomSize() || _sys1.positionSize() != _sys2.positionSize()) {
+		cout << "LEAD: different number of atoms or positions, " << atoms1.size() << " vs " << atoms2.size() << endl;
+		return false;
+	}
+	vector<CartesianPoint> coor1, coor2, hidden1, hidden2;
+	vector<unsigned int> hiddenIndices1, hiddenIndices2;
+	unsigned int active1 = 0;
+	unsigned int active2 = 0;
+	unsigned int mismatches = 0;
+	for (unsigned int i=0; i<atoms1.size(); i++) {
+		Atom & a1 = *atoms1[i];
+		Atom & a2 = *atoms2[i];
+		a1.getConformationState(coor1, hidden1, hiddenIndices1, active1);
+		a2.getConformationState(coor2, hidden2, hiddenIndices2, active2);
+		bool same = a1.getAtomId() == a2.getAtomId() && a1.getType() == a2.getType() && a1.getCharge() == a2.getCharge() && a1.getGroupNumber() == a2.getGroupNumber() && a1.hasCoor() == a2.hasCoor() && a1.getActive() == a2.getActive();
+		same = same && active1 == active2 && hiddenIndices1 == hiddenIndices2 && coor1.size() == coor2.size() && hidden1.size() == hidden2.size();
+		for (unsigned int j=0; same && j<coor1.size(); j++) {
+			same = coor1[j] == coor2[j];
+		}
+		for (unsigned int j=0; same && j<hidden1.size(); j++) {
+			same = hidden1[j] == hidden2[j];
+		}
+		// the bonded atoms are not in a defined order, compare their ids
+		vector<Atom*> bonds1 = a1.getBonds();
+		vector<Atom*> bonds2 = a2.getBonds();
+		set<string> bondIds1;
+		set<string> bondIds2;
+		for (unsigned int j=0; j<bonds1.size(); j++) {
+			bondIds1.insert(bonds1[j]->getAtomOfIdentityId());
+		}
+		for (unsigned int j=0; j<bonds2.size(); j++) {
+			bondIds2.insert(bonds2[j]->getAtomOfIdentityId());
+		}
+		same = same && bonds1.size() == bonds2.size() && bondIds1 == bondIds2;
+		if (!same) {
+			if (mismatches < 5) {
+				cout << "LEAD: atom " << a1 << " is different from " << a2 << endl;
+			}
+			mismatches++;
+			ok = false;
+		}
+	}
+	for (unsigned int i=0; i<_sys1.positionSize(); i++) {
+		if (_sys1.getPosition(i).getActiveIdentity() != _sys2.getPosition(i).getActiveIdentity()) {
+			cout << "LEAD: position " << i << " has a different active identity" << endl;
+			ok = false;
+		}
+	}
+	IcTable & ic1 = _sys1.getIcTable();
+	IcTable & ic2 = _sys2.getIcTable();
+	if (ic1.size() != ic2.size()) {
+		cout << "LEAD: the IC tables have " << ic1.size() << " and " << ic2.size() << " entries" << endl;
+		ok = false;
+	} else {
+		for (unsigned int i=0; i<ic1.size(); i++) {
+			if (ic1[i]->toString() != ic2[i]->toString() || ic1[i]->getValues() != ic2[i]->getValues()) {
+				cout << "LEAD: IC entry " << i << " differs: " << *ic1[i] << " vs " << *ic2[i] << endl;
+				ok = false;
+				break;
+			}
+		}
+	}
+	double e1 = _sys1.calcEnergy();
+	double e2 = _sys2.calcEnergy();
+	if (!sameEnergy(e1, e2) || _sys1.getEnergySet()->getSummary() != _sys2.getEnergySet()->getSummary()) {
+		cout << "LEAD: energies differ, " << e1 << " vs " << e2 << endl;
+		cout << _sys1.getEnergySet()->getSummary() << _sys2.getEnergySet()->getSummary();
+		ok = false;
+	}
+	map<string, vector<Interaction*> > * terms1 = _sys1.getEnergySet()->getEnergyTerms();
+	map<string, vector<Interaction*> > * terms2 = _sys2.getEnergySet()->getEnergyTerms();
+	if (terms1->size() != terms2->size()) {
+		cout << "LEAD: " << terms1->size() << " and " << terms2->size() << " energy terms" << endl;
+		ok = false;
+	}
+	for (map<string, vector<Interaction*> >::iterator k=terms1->begin(); k!=terms1->end(); k++) {
+		double t1 = _sys1.getEnergySet()->getTermEnergy(k->first);
+		double t2 = _sys2.getEnergySet()->getTermEnergy(k->first);
+		if (terms2->find(k->first) == terms2->end() || (*terms2)[k->first].size() != k->second.size() || !sameEnergy(t1, t2)) {
+			cout << "LEAD: term " << k->first << " differs, " << t1 << " vs " << t2 << endl;
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+string readFile(string _file) {
+	ifstream in(_file.c_str(), ios::binary);
+	return string((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+// a System that the writer must refuse, the snapshot file must not be written
+bool refused(System & _sys, string _what) {
+	string file = "/tmp/testSystemSnapshot_refused.snap";
+	remove(file.c_str());
+	SystemSnapshotWriter writer(file);
+	writer.open();
+	bool written = writer.write(_sys);
+	writer.close();
+	if (written || readFile(file).size() != 0) {
+		cout << "LEAD: a System with " << _what << " was written" << endl;
+		return false;
+	}
+	cout << "System with " << _what << " refused" << endl;
+	return true;
+}
+
+// a copy of a file, optionally truncated or with a byte changed
+void copyFile(string _from, string _to, long _truncateAt=-1, long _flipAt=-1) {
+	ifstream in(_from.c_str(), ios::binary);
+	string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	if (_flipAt >= 0 && _flipAt < (long)data.size()) {
+		data[_flipAt] ^= 0x10;
+	}
+	if (_truncateAt >= 0 && _truncateAt < (long)data.size()) {
+		data.resize(_truncateAt);
+	}
+	ofstream out(_to.c_str(), ios::binary);
+	out << data;
+}
+
+int main() {
+	string topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+	string snapshot = "/tmp/testSystemSnapshot.snap";
+	bool ok = true;
+
+	Timer t;
+	double start = t.getWallTime();
+	System sys;
+	buildSystem(sys, topFile, parFile);
+	double buildTime = t.getWallTime() - start;
+	cout << "Built a System with " << sys.positionSize() << " positions and " << sys.allAtomSize() << " atoms, energy " << sys.calcEnergy() << endl;
+
+	SystemSnapshotWriter writer(snapshot);
+	writer.open();
+	writer.addSourceFile(topFile);
+	writer.addSourceFile(parFile);
+	if (!writer.write(sys)) {
+		cout << "LEAD: cannot write snapshot " << snapshot << endl;
+		ok = false;
+	}
+	writer.close();
+
+	/******************************************************
+	 *  Load the snapshot and compare
+	 ******************************************************/
+	start = t.getWallTime();
+	System loaded;
+	SystemSnapshotReader reader(snapshot);
+	reader.open();
+	reader.addSourceFile(topFile);
+	reader.addSourceFile(parFile);
+	if (!reader.read(loaded)) {
+		cout << "LEAD: cannot read snapshot " << snapshot << endl;
+		ok = false;
+	}
+	reader.close();
+	double loadTime = t.getWallTime() - start;
+	fprintf(stdout, "Build time %8.4f s, snapshot load time %8.4f s (%.1fx)\n", buildTime, loadTime, buildTime / loadTime);
+
+	if (compareSystems(sys, loaded)) {
+		cout << "Loaded System is identical to the built one" << endl;
+	} else {
+		ok = false;
+	}
+
+	// the loaded System written again gives the same snapshot
+	string rewritten = "/tmp/testSystemSnapshot_rewritten.snap";
+	SystemSnapshotWriter rewriter(rewritten);
+	rewriter.open();
+	rewriter.addSourceFile(topFile);
+	rewriter.addSourceFile(parFile);
+	bool rewrittenOk = rewriter.write(loaded);
+	rewriter.close();
+	if (rewrittenOk && readFile(rewritten) == readFile(snapshot)) {
+		cout << "The loaded System writes the same snapshot" << endl;
+	} else {
+		cout << "LEAD: the snapshot of the loaded System is different" << endl;
+		ok = false;
+	}
+
+	// change identities and rotamers in both, unhide the hidden rotamer
+	sys.getPosition("A,4").setActiveRotamer("ASP", 1);
+	loaded.getPosition("A,4").setActiveRotamer("ASP", 1);
+	sys.getPosition("B,4").setActiveIdentity("LEU");
+	loaded.getPosition("B,4").setActiveIdentity("LEU");
+	sys.getPosition("C,2").getIdentity(0).unhideRotamerAbsIndex(2);
+	loaded.getPosition("C,2").getIdentity(0).unhideRotamerAbsIndex(2);
+	sys.getPosition("C,2").setActiveRotamer(2);
+	loaded.getPosition("C,2").setActiveRotamer(2);
+	if (compareSystems(sys, loaded)) {
+		cout << "Same state and energy after changing identities and rotamers: " << loaded.calcEnergy() << endl;
+	} else {
+		ok = false;
+	}
+
+	/******************************************************
+	 *  Snapshots that must be rejected
+	 ******************************************************/
+	string changedTop = "/tmp/testSystemSnapshot.top";
+	copyFile(topFile, changedTop);
+	{
+		ofstream out(changedTop.c_str(), ios::app);
+		out << "! changed" << endl;
+	}
+	System stale;
+	SystemSnapshotReader staleReader(snapshot);
+	staleReader.open();
+	staleReader.addSourceFile(changedTop);
+	staleReader.addSourceFile(parFile);
+	if (staleReader.read(stale)) {
+		cout << "LEAD: a snapshot with a changed source file was accepted" << endl;
+		ok = false;
+	} else {
+		cout << "Snapshot with a changed source file rejected" << endl;
+	}
+	staleReader.close();
+
+	string corrupted = "/tmp/testSystemSnapshot_corrupted.snap";
+	copyFile(snapshot, corrupted, -1, 1000);
+	System corruptedSys;
+	SystemSnapshotReader corruptedReader(corrupted);
+	corruptedReader.open();
+	if (corruptedReader.read(corruptedSys) || corruptedSys.allAtomSize() != 0) {
+		cout << "LEAD: a corrupted snapshot was accepted" << endl;
+		ok = false;
+	} else {
+		cout << "Corrupted snapshot rejected" << endl;
+	}
+	corruptedReader.close();
+
+	string truncated = "/tmp/testSystemSnapshot_truncated.snap";
+	copyFile(snapshot, truncated, 5000);
+	System truncatedSys;
+	SystemSnapshotReader truncatedReader(truncated);
+	truncatedReader.open();
+	if (truncatedReader.read(truncatedSys) || truncatedSys.allAtomSize() != 0) {
+		cout << "LEAD: a truncated snapshot was accepted" << endl;
+		ok = false;
+	} else {
+		cout << "Truncated snapshot rejected" << endl;
+	}
+	truncatedReader.close();
+
+	/******************************************************
+	 *  Systems that cannot be stored
+	 ******************************************************/
+	System hidden;
+	buildSystem(hidden, topFile, parFile);
+	hidden.getPosition("A,4").hideIdentity("ASP");
+	ok = refused(hidden, "a hidden identity") && ok;
+
+	System linked;
+	buildSystem(linked, topFile, parFile);
+	vector<string> linkedPositions;
+	linkedPositions.push_back("C,1");
+	linkedPositions.push_back("C,3");
+	linked.setLinkedPositions(linkedPositions);
+	ok = refused(linked, "linked positions") && ok;
+
+	System imm1;
+	buildSystem(imm1, topFile, parFile);
+	vector<double> imm1W(8, 1.0);
+	vector<double> imm1C(8, 1.0);
+	imm1.getEnergySet()->addInteraction(new CharmmIMM1Interaction(imm1.getAtom("A,1,CA"), imm1.getAtom("C,8,CA"), imm1W, imm1C, 15.0, 10.0));
+	ok = refused(imm1, "an IMM1 interaction") && ok;
+
+	if (ok) {
+		cout << "GOLD" << endl;
+	} else {
+		cout << "LEAD" << endl;
+	}
+	return 0;
+}